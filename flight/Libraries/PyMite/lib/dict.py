@@ -15,6 +15,12 @@
 
 ## @package dict
 #  @brief Provides PyMite's dict module.
+#
+#  A dict keeps its items in the order their keys were first added:
+#  keys(), values(), iterating over a dict and dir() give the oldest key
+#  first.  Rebinding a key keeps its place, deleting and adding it again
+#  moves it to the end.  Until the dicts got a hash index, new keys were
+#  put at the front and these gave the newest key first.
 
 def clear(d):
     """__NATIVE__
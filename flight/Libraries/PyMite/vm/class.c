@@ -52,6 +52,7 @@ class_new(pPmObj_t pattrs, pPmObj_t pbases, pPmObj_t pname, pPmObj_t *r_pclass)
 
     /* Class has no access to its CO */
     ((pPmClass_t)pobj)->cl_attrs = (pPmDict_t)pattrs;
+    ((pPmDict_t)pattrs)->d_watched = C_TRUE;
     ((pPmClass_t)pobj)->cl_bases = (pPmTuple_t)pbases;
 
     *r_pclass = pobj;
@@ -69,6 +69,11 @@ co_loadFromImg(PmMemSpace_t memspace, uint8_t const **paddr, pPmObj_t *r_pco)
     pco->co_names = C_NULL;
     pco->co_consts = C_NULL;
 
+#ifdef HAVE_INLINE_CACHE
+    pco->co_heat = 0;
+    pco->co_cache = C_NULL;
+#endif /* HAVE_INLINE_CACHE */
+
 #ifdef HAVE_CLOSURES
     pco->co_nfreevars = mem_getByte(memspace, paddr);
     pco->co_cellvars = C_NULL;
@@ -63,6 +63,55 @@
 #define CO_GENERATOR 0x20
 #define CO_NOFREE 0x40
 
+#ifdef HAVE_INLINE_CACHE
+/** Calls plus loop iterations after which a code obj gets an inline cache */
+#define CO_CACHE_HEAT 8
+
+/** Most names (from the start of co_names) an inline cache covers */
+#define CO_CACHE_MAX_NAMES 64
+
+/**
+ * Inline cache entry
+ *
+ * Remembers where the last LOAD_NAME, LOAD_GLOBAL or LOAD_ATTR of one name
+ * in a code obj found its value.  The entry is valid while ce_dict, the
+ * dict the name was looked up in first, keeps the same version.
+ * If the value was in ce_dict itself, ce_version2 is zero and the entry
+ * points at the value's slot, so rebinding the name keeps the entry valid.
+ * If it came from the builtins or a class, the entry holds the value,
+ * valid while gVmGlobal.watchedVersion equals ce_version2.
+ */
+typedef struct PmCoCacheEntry_s
+{
+    /** dict the name was looked up in first */
+    pPmDict_t ce_dict;
+    /** version of ce_dict when the entry was filled */
+    uint32_t ce_version;
+    /** zero, or the watched version the value was found under */
+    uint32_t ce_version2;
+    union
+    {
+        /** slot of the value in ce_dict, if ce_version2 is zero */
+        pPmObj_t *pslot;
+        /** the value, otherwise */
+        pPmObj_t pval;
+    } ce_value;
+} PmCoCacheEntry_t,
+ *pPmCoCacheEntry_t;
+
+/** Inline cache, one entry per name of a code obj */
+typedef struct PmCoCache_s
+{
+    /** object descriptor */
+    PmObjDesc_t od;
+    /** number of entries */
+    uint16_t length;
+    /** the entries */
+    PmCoCacheEntry_t entry[1];
+} PmCoCache_t,
+ *pPmCoCache_t;
+#endif /* HAVE_INLINE_CACHE */
+
 /**
  * Code Object
  *
@@ -109,6 +158,13 @@ typedef struct PmCo_s
     uint8_t co_stacksize;
     /** Number of local variables */
     uint8_t co_nlocals;
+
+#ifdef HAVE_INLINE_CACHE
+    /** Calls plus loop iterations so far, saturates at CO_CACHE_HEAT */
+    uint8_t co_heat;
+    /** Inline cache for name lookups, allocated once the code is hot */
+    pPmCoCache_t co_cache;
+#endif /* HAVE_INLINE_CACHE */
 } PmCo_t,
  *pPmCo_t;
 
@@ -28,6 +28,150 @@
 #include "pm.h"
 
 
+/* Returns a new version number; zero is never handed out */
+static uint32_t
+dict_nextVersion(void)
+{
+    if (++gVmGlobal.dictVersion == 0)
+    {
+        gVmGlobal.dictVersion++;
+    }
+    return gVmGlobal.dictVersion;
+}
+
+
+/*
+ * Records a change to the dict.  Adding or removing keys gives the dict
+ * a new version; any change to a watched dict (see PmDict_t) gives
+ * gVmGlobal.watchedVersion a new version.
+ */
+static void
+dict_touch(pPmDict_t pdict, uint8_t keysChanged)
+{
+    if (keysChanged)
+    {
+        pdict->d_version = dict_nextVersion();
+    }
+    if (pdict->d_watched)
+    {
+        gVmGlobal.watchedVersion = dict_nextVersion();
+    }
+}
+
+
+/* Puts the item at indx in the first free slot of the probe sequence */
+static void
+dict_indexInsert(pPmDictIndex_t pindex, uint16_t hash, int16_t indx)
+{
+    uint16_t i;
+
+    for (i = hash & pindex->mask; pindex->slot[i] != 0;
+         i = (i + 1) & pindex->mask);
+    pindex->slot[i] = (hash & 0xFF00) | (uint16_t)(indx + 1);
+}
+
+
+/*
+ * Rebuilds the hash index to fit the current length of the dict.
+ * Small dicts, and dicts too big for one index chunk, are left without one.
+ * The index only speeds up lookups, so failing to allocate it is not an
+ * error; the dict falls back to scanning its keys.
+ */
+static void
+dict_indexRebuild(pPmDict_t pdict)
+{
+    pPmDictIndex_t pindex;
+    pSegment_t pseg;
+    uint16_t nslots;
+    int16_t i;
+    uint8_t *pchunk;
+
+    if (pdict->d_index != C_NULL)
+    {
+        heap_freeChunk((pPmObj_t)pdict->d_index);
+        pdict->d_index = C_NULL;
+    }
+
+    if ((pdict->length < DICT_INDEX_MIN_LENGTH)
+        || ((pdict->length * 4) > (DICT_INDEX_MAX_SLOTS * 3)))
+    {
+        return;
+    }
+
+    /* Leave the index at most half full so it can grow in place a while */
+    for (nslots = 16;
+         (nslots < (pdict->length * 2)) && (nslots < DICT_INDEX_MAX_SLOTS);
+         nslots <<= 1);
+
+    if (heap_getChunk(sizeof(PmDictIndex_t) + (nslots - 1) * sizeof(uint16_t),
+                      &pchunk) != PM_RET_OK)
+    {
+        return;
+    }
+    pindex = (pPmDictIndex_t)pchunk;
+    OBJ_SET_TYPE(pindex, OBJ_TYPE_RAW);
+    pindex->mask = nslots - 1;
+    sli_memset((unsigned char *)pindex->slot, 0, nslots * sizeof(uint16_t));
+
+    /* Walk the keys segment by segment */
+    pseg = pdict->d_keys->sl_rootseg;
+    for (i = 0; i < pdict->length; i++)
+    {
+        dict_indexInsert(pindex,
+                         obj_hash(pseg->s_val[i % SEGLIST_OBJS_PER_SEG]), i);
+        if ((i % SEGLIST_OBJS_PER_SEG) == (SEGLIST_OBJS_PER_SEG - 1))
+        {
+            pseg = pseg->next;
+        }
+    }
+    pdict->d_index = pindex;
+}
+
+
+/*
+ * Finds the position of the key in the dict.
+ * Returns PM_RET_OK with the position in r_indx, or PM_RET_NO.
+ * If the dict has an index, the key's hash is returned in r_hash.
+ */
+static PmReturn_t
+dict_find(pPmDict_t pdict, pPmObj_t pkey, uint16_t *r_hash, int16_t *r_indx)
+{
+    pPmDictIndex_t pindex = pdict->d_index;
+    pPmObj_t pobj;
+    uint16_t hash;
+    uint16_t i;
+    uint16_t s;
+
+    /* Small dicts are scanned */
+    if (pindex == C_NULL)
+    {
+        *r_indx = 0;
+        return seglist_findEqual(pdict->d_keys, pkey, r_indx);
+    }
+
+    hash = obj_hash(pkey);
+    *r_hash = hash;
+
+    /* The index is never full, so the probe ends at an empty slot */
+    for (i = hash & pindex->mask; (s = pindex->slot[i]) != 0;
+         i = (i + 1) & pindex->mask)
+    {
+        /* Only fetch the key if the tag matches */
+        if ((s & 0xFF00) != (hash & 0xFF00))
+        {
+            continue;
+        }
+        *r_indx = (int16_t)(s & 0xFF) - 1;
+        if ((seglist_getItem(pdict->d_keys, *r_indx, &pobj) == PM_RET_OK)
+            && (obj_compare(pkey, pobj) == C_SAME))
+        {
+            return PM_RET_OK;
+        }
+    }
+    return PM_RET_NO;
+}
+
+
 PmReturn_t
 dict_new(pPmObj_t *r_pdict)
 {
@@ -45,6 +189,9 @@ dict_new(pPmObj_t *r_pdict)
     pdict->length = 0;
     pdict->d_keys = C_NULL;
     pdict->d_vals = C_NULL;
+    pdict->d_index = C_NULL;
+    pdict->d_watched = C_FALSE;
+    dict_touch(pdict, C_TRUE);
 
     *r_pdict = (pPmObj_t)pchunk;
     return retval;
@@ -67,6 +214,15 @@ dict_clear(pPmObj_t pdict)
 
     /* clear length */
     ((pPmDict_t)pdict)->length = 0;
+    dict_touch((pPmDict_t)pdict, C_TRUE);
+
+    /* Free the hash index if needed */
+    if (((pPmDict_t)pdict)->d_index != C_NULL)
+    {
+        PM_RETURN_IF_ERROR(heap_freeChunk((pPmObj_t)
+                                          ((pPmDict_t)pdict)->d_index));
+        ((pPmDict_t)pdict)->d_index = C_NULL;
+    }
 
     /* Free the keys and values seglists if needed */
     if (((pPmDict_t)pdict)->d_keys != C_NULL)
@@ -89,13 +245,15 @@ dict_clear(pPmObj_t pdict)
 /*
  * Sets a value in the dict using the given key.
  *
- * Scans dict for the key.  If key val found, replace old
+ * Looks up the key.  If key val found, replace old
  * with new val.  If no key found, add key/val pair to dict.
  */
 PmReturn_t
 dict_setItem(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t pval)
 {
     PmReturn_t retval = PM_RET_OK;
+    pPmDictIndex_t pindex;
+    uint16_t hash = 0;
     int16_t indx;
 
     C_ASSERT(pdict != C_NULL);
@@ -141,22 +299,36 @@ dict_setItem(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t pval)
     else
     {
         /* Check for matching key */
-        indx = 0;
-        retval = seglist_findEqual(((pPmDict_t)pdict)->d_keys, pkey, &indx);
+        retval = dict_find((pPmDict_t)pdict, pkey, &hash, &indx);
 
         /* If found a matching key, replace val obj */
         if (retval == PM_RET_OK)
         {
             retval = seglist_setItem(((pPmDict_t)pdict)->d_vals, pval, indx);
+            dict_touch((pPmDict_t)pdict, C_FALSE);
             return retval;
         }
     }
 
-    /* Otherwise, insert the key,val pair */
-    retval = seglist_insertItem(((pPmDict_t)pdict)->d_keys, pkey, 0);
+    /* Otherwise, append the key,val pair */
+    retval = seglist_appendItem(((pPmDict_t)pdict)->d_keys, pkey);
+    PM_RETURN_IF_ERROR(retval);
+    retval = seglist_appendItem(((pPmDict_t)pdict)->d_vals, pval);
     PM_RETURN_IF_ERROR(retval);
-    retval = seglist_insertItem(((pPmDict_t)pdict)->d_vals, pval, 0);
     ((pPmDict_t)pdict)->length++;
+    dict_touch((pPmDict_t)pdict, C_TRUE);
+
+    /* Index the new item, growing the index once it is 3/4 full */
+    pindex = ((pPmDict_t)pdict)->d_index;
+    if ((pindex != C_NULL) && ((((pPmDict_t)pdict)->length * 4)
+                               <= ((pindex->mask + 1) * 3)))
+    {
+        dict_indexInsert(pindex, hash, ((pPmDict_t)pdict)->length - 1);
+    }
+    else if (((pPmDict_t)pdict)->length >= DICT_INDEX_MIN_LENGTH)
+    {
+        dict_indexRebuild((pPmDict_t)pdict);
+    }
 
     return retval;
 }
@@ -166,6 +338,7 @@ PmReturn_t
 dict_getItem(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t *r_pobj)
 {
     PmReturn_t retval = PM_RET_OK;
+    uint16_t hash;
     int16_t indx = 0;
 
 /*    C_ASSERT(pdict != C_NULL);*/
@@ -195,7 +368,7 @@ dict_getItem(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t *r_pobj)
     }
 
     /* check for matching key */
-    retval = seglist_findEqual(((pPmDict_t)pdict)->d_keys, pkey, &indx);
+    retval = dict_find((pPmDict_t)pdict, pkey, &hash, &indx);
     /* if key not found, raise KeyError */
     if (retval == PM_RET_NO)
     {
@@ -210,17 +383,53 @@ dict_getItem(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t *r_pobj)
 }
 
 
+PmReturn_t
+dict_getSlot(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t **r_pslot)
+{
+    PmReturn_t retval;
+    pSegment_t pseg;
+    uint16_t hash;
+    int16_t indx;
+    int16_t i;
+
+    C_ASSERT(OBJ_GET_TYPE(pdict) == OBJ_TYPE_DIC);
+
+    if (((pPmDict_t)pdict)->length <= 0)
+    {
+        PM_RAISE(retval, PM_RET_EX_KEY);
+        return retval;
+    }
+
+    retval = dict_find((pPmDict_t)pdict, pkey, &hash, &indx);
+    if (retval == PM_RET_NO)
+    {
+        PM_RAISE(retval, PM_RET_EX_KEY);
+        return retval;
+    }
+
+    /* Walk out to the value's segment */
+    pseg = ((pPmDict_t)pdict)->d_vals->sl_rootseg;
+    for (i = indx / SEGLIST_OBJS_PER_SEG; i > 0; i--)
+    {
+        pseg = pseg->next;
+    }
+    *r_pslot = &pseg->s_val[indx % SEGLIST_OBJS_PER_SEG];
+    return PM_RET_OK;
+}
+
+
 #ifdef HAVE_DEL
 PmReturn_t
 dict_delItem(pPmObj_t pdict, pPmObj_t pkey)
 {
     PmReturn_t retval = PM_RET_OK;
+    uint16_t hash;
     int16_t indx = 0;
 
     C_ASSERT(pdict != C_NULL);
 
     /* Check for matching key */
-    retval = seglist_findEqual(((pPmDict_t)pdict)->d_keys, pkey, &indx);
+    retval = dict_find((pPmDict_t)pdict, pkey, &hash, &indx);
 
     /* Raise KeyError if key is not found */
     if (retval == PM_RET_NO)
@@ -238,6 +447,13 @@ dict_delItem(pPmObj_t pdict, pPmObj_t pkey)
 
     /* Reduce the item count */
     ((pPmDict_t)pdict)->length--;
+    dict_touch((pPmDict_t)pdict, C_TRUE);
+
+    /* The later items moved down one position, so reindex them */
+    if (((pPmDict_t)pdict)->d_index != C_NULL)
+    {
+        dict_indexRebuild((pPmDict_t)pdict);
+    }
 
     return retval;
 }
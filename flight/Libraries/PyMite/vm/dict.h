@@ -25,12 +25,47 @@
  */
 
 
+/** Dicts with at least this many items get a hash index */
+#define DICT_INDEX_MIN_LENGTH 8
+
+/** Largest number of slots in a hash index (one byte holds the item index) */
+#define DICT_INDEX_MAX_SLOTS 256
+
+/**
+ * Dict hash index
+ *
+ * Open-addressing table over the items of the key/value seglists.
+ * Each slot holds the item's position plus one in its low byte (zero marks
+ * an empty slot) and the high byte of the key's hash as a tag, so most
+ * mismatches are rejected without fetching the key.
+ */
+typedef struct PmDictIndex_s
+{
+    /** object descriptor */
+    PmObjDesc_t od;
+    /** number of slots minus one (slots are a power of two) */
+    uint16_t mask;
+    /** the slots */
+    uint16_t slot[1];
+} PmDictIndex_t,
+ *pPmDictIndex_t;
+
 /**
  * Dict
  *
  * Contains ptr to two seglists,
  * one for keys, the other for values;
  * and a length, the number of key/value pairs.
+ * Items are kept in insertion order, new keys are appended to the seglists
+ * (they used to be inserted at the front), so walking the seglists gives
+ * the oldest key first.  Dicts with DICT_INDEX_MIN_LENGTH or more items
+ * also carry a hash index over the seglists.
+ *
+ * Adding or removing keys gives the dict a new version from a VM-wide
+ * counter.  While a dict keeps its version, each of its values stays in
+ * the same seglist slot, so a lookup can be reused by reading that slot.
+ * Changes of any kind to a watched dict (class attrs and the builtins,
+ * which seldom change) also set gVmGlobal.watchedVersion.
  */
 typedef struct PmDict_s
 {
@@ -42,6 +77,12 @@ typedef struct PmDict_s
     pSeglist_t d_keys;
     /** ptr to seglist containing values */
     pSeglist_t d_vals;
+    /** ptr to the hash index, C_NULL for small dicts */
+    pPmDictIndex_t d_index;
+    /** version of the key set, changes when keys are added or removed */
+    uint32_t d_version;
+    /** nonzero if changes to this dict update gVmGlobal.watchedVersion */
+    uint8_t d_watched;
 } PmDict_t,
  *pPmDict_t;
 
@@ -66,6 +107,19 @@ PmReturn_t dict_clear(pPmObj_t pdict);
  */
 PmReturn_t dict_getItem(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t *r_pobj);
 
+/**
+ * Gets the address of the seglist slot holding the value for the given key.
+ * The slot keeps holding that key's value while the dict's version stays
+ * the same.
+ * Throws KeyError if pkey does not exist in pdict.
+ *
+ * @param   pdict ptr to dict to search
+ * @param   pkey ptr to key obj
+ * @param   r_pslot Return; addr of the value slot
+ * @return  Return status
+ */
+PmReturn_t dict_getSlot(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t **r_pslot);
+
 #ifdef HAVE_DEL
 /**
  * Removes a key and value from the dict.
@@ -92,8 +146,8 @@ PmReturn_t dict_new(pPmObj_t *r_pdict);
  * Sets a value in the dict using the given key.
  *
  * If the dict already contains a matching key, the value is
- * replaced; otherwise the new key,val pair is inserted
- * at the front of the dict (for fast lookup).
+ * replaced; otherwise the new key,val pair is appended
+ * to the end of the dict.
  * In the later case, the length of the dict is incremented.
  *
  * @param   pdict ptr to dict in which (key,val) will go
@@ -47,6 +47,14 @@ frame_new(pPmObj_t pfunc, pPmObj_t *r_pobj)
         return retval;
     }
 
+#ifdef HAVE_INLINE_CACHE
+    /* Each call warms up the code obj's inline cache */
+    if (pco->co_heat < CO_CACHE_HEAT)
+    {
+        pco->co_heat++;
+    }
+#endif /* HAVE_INLINE_CACHE */
+
 #ifdef HAVE_GENERATORS
     /* #207: Initializing a Generator using CALL_FUNC needs extra stack slot */
     fsize = sizeof(PmFrame_t) + (pco->co_stacksize + pco->co_nlocals + 2) * sizeof(pPmObj_t);
@@ -65,6 +65,9 @@ global_init(void)
     /* Set the PyMite release num (for debug and post mortem) */
     gVmGlobal.errVmRelease = PM_RELEASE;
 
+    /* Zero marks direct entries in the inline caches, so start at one */
+    gVmGlobal.watchedVersion = 1;
+
     /* Init zero */
     retval = heap_getChunk(sizeof(PmInt_t), &pchunk);
     PM_RETURN_IF_ERROR(retval);
@@ -231,6 +234,7 @@ global_loadBuiltins(void)
 
     /* Builtins points to the builtins module's attrs dict */
     gVmGlobal.builtins = ((pPmFunc_t)pbimod)->f_attrs;
+    gVmGlobal.builtins->d_watched = C_TRUE;
 
     /* Set None manually */
     retval = string_new(&nonestr, &pkey);
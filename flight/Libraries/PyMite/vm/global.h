@@ -153,6 +153,12 @@ typedef struct PmVmGlobal_s
 
     /** Flag to trigger rescheduling */
     uint8_t reschedule;
+
+    /** Last version given to a dict (see PmDict_t) */
+    uint32_t dictVersion;
+
+    /** Changes whenever a watched dict (class attrs, builtins) changes */
+    uint32_t watchedVersion;
 } PmVmGlobal_t,
  *pPmVmGlobal_t;
 
@@ -625,6 +625,7 @@ heap_gcMarkObj(pPmObj_t pobj)
         case OBJ_TYPE_NOB:
         case OBJ_TYPE_BOOL:
         case OBJ_TYPE_CIO:
+        case OBJ_TYPE_RAW:
             OBJ_SET_GCVAL(pobj, pmHeap.gcval);
             break;
 
@@ -661,6 +662,10 @@ heap_gcMarkObj(pPmObj_t pobj)
 
             /* Mark the vals seglist */
             retval = heap_gcMarkObj((pPmObj_t)((pPmDict_t)pobj)->d_vals);
+            PM_RETURN_IF_ERROR(retval);
+
+            /* Mark the hash index */
+            retval = heap_gcMarkObj((pPmObj_t)((pPmDict_t)pobj)->d_index);
             break;
 
         case OBJ_TYPE_COB:
@@ -687,7 +692,13 @@ heap_gcMarkObj(pPmObj_t pobj)
             /* #256: Add support for closures */
             /* Mark the cellvars tuple */
             retval = heap_gcMarkObj((pPmObj_t)((pPmCo_t)pobj)->co_cellvars);
+            PM_RETURN_IF_ERROR(retval);
 #endif /* HAVE_CLOSURES */
+
+#ifdef HAVE_INLINE_CACHE
+            /* Mark the inline cache (its entries are weak) */
+            retval = heap_gcMarkObj((pPmObj_t)((pPmCo_t)pobj)->co_cache);
+#endif /* HAVE_INLINE_CACHE */
             break;
 
         case OBJ_TYPE_MOD:
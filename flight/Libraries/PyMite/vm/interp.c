@@ -28,6 +28,131 @@
 #include "pm.h"
 
 
+#ifdef HAVE_INLINE_CACHE
+/*
+ * Returns the inline cache entry for the name at indx in the code obj's
+ * names, or C_NULL if the name is not cached.  The cache is allocated
+ * the first time it is needed once the code obj is hot.
+ */
+static pPmCoCacheEntry_t
+interp_getCacheEntry(pPmCo_t pco, int16_t indx)
+{
+    uint16_t n;
+    uint8_t *pchunk;
+
+    if (pco->co_cache == C_NULL)
+    {
+        /* Code that only runs once is not worth the memory */
+        if (pco->co_heat < CO_CACHE_HEAT)
+        {
+            return C_NULL;
+        }
+
+        n = pco->co_names->length;
+        if (n > CO_CACHE_MAX_NAMES)
+        {
+            n = CO_CACHE_MAX_NAMES;
+        }
+        if (heap_getChunk(sizeof(PmCoCache_t)
+                          + (n - 1) * sizeof(PmCoCacheEntry_t),
+                          &pchunk) != PM_RET_OK)
+        {
+            /* Try again once the code has run a while longer */
+            pco->co_heat = 0;
+            return C_NULL;
+        }
+
+        OBJ_SET_TYPE(pchunk, OBJ_TYPE_RAW);
+        pco->co_cache = (pPmCoCache_t)pchunk;
+        pco->co_cache->length = n;
+
+        /* No dict is at address zero, so cleared entries never hit */
+        sli_memset((unsigned char *)pco->co_cache->entry, 0,
+                   n * sizeof(PmCoCacheEntry_t));
+    }
+
+    if (indx >= pco->co_cache->length)
+    {
+        return C_NULL;
+    }
+    return &pco->co_cache->entry[indx];
+}
+
+
+/* Returns the cached result of a lookup in pdict, or C_NULL on a miss */
+static pPmObj_t
+interp_lookupCacheEntry(pPmCoCacheEntry_t pce, pPmDict_t pdict)
+{
+    if ((pce == C_NULL) || (pce->ce_dict != pdict)
+        || (pce->ce_version != pdict->d_version))
+    {
+        return C_NULL;
+    }
+    if (pce->ce_version2 == 0)
+    {
+        return *pce->ce_value.pslot;
+    }
+    if (pce->ce_version2 == gVmGlobal.watchedVersion)
+    {
+        return pce->ce_value.pval;
+    }
+    return C_NULL;
+}
+
+
+/*
+ * Gets the value of pkey in pdict like dict_getItem(), through the cache
+ * entry if there is one.  On a miss, the entry is refilled with the slot
+ * of the value found.
+ */
+static PmReturn_t
+interp_getItemCached(pPmCoCacheEntry_t pce, pPmDict_t pdict, pPmObj_t pkey,
+                     pPmObj_t *r_pobj)
+{
+    PmReturn_t retval;
+    pPmObj_t *pslot;
+
+    if (pce == C_NULL)
+    {
+        return dict_getItem((pPmObj_t)pdict, pkey, r_pobj);
+    }
+
+    *r_pobj = interp_lookupCacheEntry(pce, pdict);
+    if (*r_pobj != C_NULL)
+    {
+        return PM_RET_OK;
+    }
+
+    retval = dict_getSlot((pPmObj_t)pdict, pkey, &pslot);
+    PM_RETURN_IF_ERROR(retval);
+
+    pce->ce_dict = pdict;
+    pce->ce_version = pdict->d_version;
+    pce->ce_version2 = 0;
+    pce->ce_value.pslot = pslot;
+    *r_pobj = *pslot;
+    return retval;
+}
+
+
+/*
+ * Fills the cache entry, if any, with a value that was not in pdict but
+ * in the builtins or a class, so it must be watched for changes
+ */
+static void
+interp_fillCacheEntry(pPmCoCacheEntry_t pce, pPmDict_t pdict, pPmObj_t pval)
+{
+    if (pce != C_NULL)
+    {
+        pce->ce_dict = pdict;
+        pce->ce_version = pdict->d_version;
+        pce->ce_version2 = gVmGlobal.watchedVersion;
+        pce->ce_value.pval = pval;
+    }
+}
+#endif /* HAVE_INLINE_CACHE */
+
+
 PmReturn_t
 interpret(const uint8_t returnOnNoThreads)
 {
@@ -39,6 +164,9 @@ interpret(const uint8_t returnOnNoThreads)
     int8_t t8 = 0;
     uint8_t bc;
     uint8_t objid, objid2;
+#ifdef HAVE_INLINE_CACHE
+    pPmCoCacheEntry_t pce;
+#endif /* HAVE_INLINE_CACHE */
 
     /* Activate a thread the first time */
     retval = interp_reschedule();
@@ -1247,8 +1375,21 @@ interpret(const uint8_t returnOnNoThreads)
                 /* Get name from names tuple */
                 pobj1 = PM_FP->fo_func->f_co->co_names->val[t16];
 
+#ifdef HAVE_INLINE_CACHE
+                /* At module level the attrs are the globals; cache those */
+                pce = C_NULL;
+                if (PM_FP->fo_attrs == PM_FP->fo_globals)
+                {
+                    pce = interp_getCacheEntry(PM_FP->fo_func->f_co, t16);
+                }
+
+                /* Get value from frame's attrs dict */
+                retval = interp_getItemCached(pce, PM_FP->fo_attrs, pobj1,
+                                              &pobj2);
+#else
                 /* Get value from frame's attrs dict */
                 retval = dict_getItem((pPmObj_t)PM_FP->fo_attrs, pobj1, &pobj2);
+#endif /* HAVE_INLINE_CACHE */
                 if (retval == PM_RET_EX_KEY)
                 {
                     /* Get val from globals */
@@ -1266,6 +1407,13 @@ interpret(const uint8_t returnOnNoThreads)
                             PM_RAISE(retval, PM_RET_EX_NAME);
                             break;
                         }
+#ifdef HAVE_INLINE_CACHE
+                        if (retval == PM_RET_OK)
+                        {
+                            interp_fillCacheEntry(pce, PM_FP->fo_globals,
+                                                  pobj2);
+                        }
+#endif /* HAVE_INLINE_CACHE */
                     }
                 }
                 PM_BREAK_IF_ERROR(retval);
@@ -1357,8 +1505,15 @@ interpret(const uint8_t returnOnNoThreads)
                 /* Get name */
                 pobj2 = PM_FP->fo_func->f_co->co_names->val[t16];
 
+#ifdef HAVE_INLINE_CACHE
+                /* Get attr with given name */
+                pce = interp_getCacheEntry(PM_FP->fo_func->f_co, t16);
+                retval = interp_getItemCached(pce, (pPmDict_t)pobj1, pobj2,
+                                              &pobj3);
+#else
                 /* Get attr with given name */
                 retval = dict_getItem(pobj1, pobj2, &pobj3);
+#endif /* HAVE_INLINE_CACHE */
 
 #ifdef HAVE_CLASSES
                 /*
@@ -1370,6 +1525,12 @@ interpret(const uint8_t returnOnNoThreads)
                         || (OBJ_GET_TYPE(TOS) == OBJ_TYPE_CLI)))
                 {
                     retval = class_getAttr(TOS, pobj2, &pobj3);
+#ifdef HAVE_INLINE_CACHE
+                    if (retval == PM_RET_OK)
+                    {
+                        interp_fillCacheEntry(pce, (pPmDict_t)pobj1, pobj3);
+                    }
+#endif /* HAVE_INLINE_CACHE */
                 }
 #endif /* HAVE_CLASSES */
 
@@ -1593,6 +1754,14 @@ interpret(const uint8_t returnOnNoThreads)
                 /* Get target offset (bytes) */
                 t16 = GET_ARG();
 
+#ifdef HAVE_INLINE_CACHE
+                /* These jump back to the top of a loop; warm up the cache */
+                if (PM_FP->fo_func->f_co->co_heat < CO_CACHE_HEAT)
+                {
+                    PM_FP->fo_func->f_co->co_heat++;
+                }
+#endif /* HAVE_INLINE_CACHE */
+
                 /* Jump to base_ip + arg */
                 PM_IP = PM_FP->fo_func->f_co->co_codeaddr + t16;
                 continue;
@@ -1603,8 +1772,14 @@ interpret(const uint8_t returnOnNoThreads)
                 pobj1 = PM_FP->fo_func->f_co->co_names->val[t16];
 
                 /* Try globals first */
+#ifdef HAVE_INLINE_CACHE
+                pce = interp_getCacheEntry(PM_FP->fo_func->f_co, t16);
+                retval = interp_getItemCached(pce, PM_FP->fo_globals, pobj1,
+                                              &pobj2);
+#else
                 retval = dict_getItem((pPmObj_t)PM_FP->fo_globals,
                                       pobj1, &pobj2);
+#endif /* HAVE_INLINE_CACHE */
 
                 /* If that didn't work, try builtins */
                 if (retval == PM_RET_EX_KEY)
@@ -1617,6 +1792,12 @@ interpret(const uint8_t returnOnNoThreads)
                         PM_RAISE(retval, PM_RET_EX_NAME);
                         break;
                     }
+#ifdef HAVE_INLINE_CACHE
+                    if (retval == PM_RET_OK)
+                    {
+                        interp_fillCacheEntry(pce, PM_FP->fo_globals, pobj2);
+                    }
+#endif /* HAVE_INLINE_CACHE */
                 }
                 PM_BREAK_IF_ERROR(retval);
                 PM_PUSH(pobj2);
@@ -340,6 +340,80 @@ obj_compare(pPmObj_t pobj1, pPmObj_t pobj2)
 }
 
 
+/* Folds a 32-bit value into 16 bits, mixing the high bits into the low ones */
+static uint16_t
+obj_hashFold(uint32_t h)
+{
+    h *= (uint32_t)0x9E3779B1;
+    return (uint16_t)(h >> 16);
+}
+
+
+uint16_t
+obj_hash(pPmObj_t pobj)
+{
+    uint32_t h;
+    uint16_t i;
+
+    C_ASSERT(pobj != C_NULL);
+
+    switch (OBJ_GET_TYPE(pobj))
+    {
+        case OBJ_TYPE_NON:
+            return 0;
+
+        case OBJ_TYPE_INT:
+            return obj_hashFold((uint32_t)((pPmInt_t)pobj)->val);
+
+#ifdef HAVE_FLOAT
+        case OBJ_TYPE_FLT:
+        {
+            union
+            {
+                float f;
+                uint32_t u;
+            } v;
+
+            /* 0.0 and -0.0 compare equal */
+            v.f = ((pPmFloat_t)pobj)->val;
+            return (v.f == 0.0) ? 0 : obj_hashFold(v.u);
+        }
+#endif /* HAVE_FLOAT */
+
+        case OBJ_TYPE_STR:
+            /* FNV-1a over the characters */
+            h = (uint32_t)2166136261u;
+            for (i = 0; i < ((pPmString_t)pobj)->length; i++)
+            {
+                h = (h ^ ((pPmString_t)pobj)->val[i]) * (uint32_t)16777619;
+            }
+            return (uint16_t)(h ^ (h >> 16));
+
+        case OBJ_TYPE_TUP:
+            h = ((pPmTuple_t)pobj)->length;
+            for (i = 0; i < ((pPmTuple_t)pobj)->length; i++)
+            {
+                h = h * 31 + obj_hash(((pPmTuple_t)pobj)->val[i]);
+            }
+            return obj_hashFold(h);
+
+        /* Containers compared by content that have no hash of their own */
+        case OBJ_TYPE_LST:
+        case OBJ_TYPE_DIC:
+#ifdef HAVE_BYTEARRAY
+        case OBJ_TYPE_BYA:
+        /* An instance may be compared by the bytearray it contains */
+        case OBJ_TYPE_CLI:
+#endif /* HAVE_BYTEARRAY */
+            return 0;
+
+        default:
+            /* All other types compare by identity */
+            return obj_hashFold((uint32_t)(uintptr_t)pobj >> 2);
+    }
+}
+
+
 #ifdef HAVE_PRINT
 PmReturn_t
 obj_print(pPmObj_t pobj, uint8_t is_expr_repr, uint8_t is_nested)
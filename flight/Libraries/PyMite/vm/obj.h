@@ -221,6 +221,9 @@ typedef enum PmType_e
 
     /** Native frame (there is only one) */
     OBJ_TYPE_NFM = 0x1E,
+
+    /** Raw data chunk (dict hash index, inline cache); holds no references */
+    OBJ_TYPE_RAW = 0x1F,
 } PmType_t, *pPmType_t;
 
 
@@ -342,6 +345,15 @@ PmReturn_t obj_isIn(pPmObj_t pobj, pPmObj_t pitem);
  */
 int8_t obj_compare(pPmObj_t pobj1, pPmObj_t pobj2);
 
+/**
+ * Computes a 16-bit hash of a hashable object.
+ * Objects that compare C_SAME using obj_compare() have the same hash.
+ *
+ * @param   pobj Ptr to object to hash.
+ * @return  The hash value.
+ */
+uint16_t obj_hash(pPmObj_t pobj);
+
 /**
  * Print an object, thereby using objects helpers.
  *
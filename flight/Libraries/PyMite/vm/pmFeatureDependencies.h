@@ -150,6 +150,15 @@
  * When defined, the code to support debug information in exception reports
  * is included in the build.
  * Issue #103 Add debug info to exception reports
+ *
+ *
+ * HAVE_INLINE_CACHE
+ * -----------------
+ *
+ * When defined, code objects that run repeatedly (in a loop or over several
+ * calls) get a cache of the results of their LOAD_NAME, LOAD_GLOBAL and
+ * LOAD_ATTR lookups, revalidated using the dict versions.  Costs one heap
+ * chunk per hot code object.
  */
 
 /* Check for dependencies */
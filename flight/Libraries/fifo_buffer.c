@@ -32,6 +32,20 @@
 // *****************************************************************************
 // circular buffer functions
 
+// The counts are worked out from one read of each index per call, not
+// stored, so the reader and the writer never write the same field
+static inline uint16_t fifoBuf_used(uint16_t rd, uint16_t wr, uint16_t buf_size)
+{
+    if (wr < rd)
+        return (buf_size - rd) + wr;
+    return wr - rd;
+}
+
+static inline uint16_t fifoBuf_free(uint16_t rd, uint16_t wr, uint16_t buf_size)
+{
+    return (buf_size - fifoBuf_used(rd, wr, buf_size)) - 1;
+}
+
 uint16_t fifoBuf_getSize(t_fifo_buffer *buf)
 {       // return the usable size of the buffer
 
@@ -46,25 +60,13 @@ uint16_t fifoBuf_getSize(t_fifo_buffer *buf)
 uint16_t fifoBuf_getUsed(t_fifo_buffer *buf)
 {       // return the number of bytes available in the rx buffer
 
-    uint16_t rd = buf->rd;
-    uint16_t wr = buf->wr;
-    uint16_t buf_size = buf->buf_size;
-
-    uint16_t num_bytes = wr - rd;
-    if (wr < rd)
-        num_bytes = (buf_size - rd) + wr;
-
-    return num_bytes;
+    return fifoBuf_used(buf->rd, buf->wr, buf->buf_size);
 }
 
 uint16_t fifoBuf_getFree(t_fifo_buffer *buf)
 {       // return the free space size in the buffer
 
-    uint16_t buf_size = buf->buf_size;
-
-    uint16_t num_bytes = fifoBuf_getUsed(buf);
-
-    return ((buf_size - num_bytes) - 1);
+    return fifoBuf_free(buf->rd, buf->wr, buf->buf_size);
 }
 
 void fifoBuf_clearData(t_fifo_buffer *buf)
@@ -79,7 +81,7 @@ void fifoBuf_removeData(t_fifo_buffer *buf, uint16_t len)
     uint16_t buf_size = buf->buf_size;
 
     // get number of bytes available
-    uint16_t num_bytes = fifoBuf_getUsed(buf);
+    uint16_t num_bytes = fifoBuf_used(rd, buf->wr, buf_size);
 
     if (num_bytes > len)
         num_bytes = len;
@@ -100,7 +102,7 @@ int16_t fifoBuf_getBytePeek(t_fifo_buffer *buf)
     uint16_t rd = buf->rd;
 
     // get number of bytes available
-    uint16_t num_bytes = fifoBuf_getUsed(buf);
+    uint16_t num_bytes = fifoBuf_used(rd, buf->wr, buf->buf_size);
 
     if (num_bytes < 1)
         return -1;                      // no byte retuened
@@ -116,7 +118,7 @@ int16_t fifoBuf_getByte(t_fifo_buffer *buf)
     uint8_t *buff = buf->buf_ptr;
 
     // get number of bytes available
-    uint16_t num_bytes = fifoBuf_getUsed(buf);
+    uint16_t num_bytes = fifoBuf_used(rd, buf->wr, buf_size);
 
     if (num_bytes < 1)
         return -1;                      // no byte returned
@@ -138,7 +140,7 @@ uint16_t fifoBuf_getDataPeek(t_fifo_buffer *buf, void *data, uint16_t len)
     uint8_t *buff = buf->buf_ptr;
 
     // get number of bytes available
-    uint16_t num_bytes = fifoBuf_getUsed(buf);
+    uint16_t num_bytes = fifoBuf_used(rd, buf->wr, buf_size);
 
     if (num_bytes > len)
         num_bytes = len;
@@ -173,7 +175,7 @@ uint16_t fifoBuf_getData(t_fifo_buffer *buf, void *data, uint16_t len)
     uint8_t *buff = buf->buf_ptr;
 
     // get number of bytes available
-    uint16_t num_bytes = fifoBuf_getUsed(buf);
+    uint16_t num_bytes = fifoBuf_used(rd, buf->wr, buf_size);
 
     if (num_bytes > len)
         num_bytes = len;
@@ -209,7 +211,7 @@ uint16_t fifoBuf_putByte(t_fifo_buffer *buf, const uint8_t b)
     uint16_t buf_size = buf->buf_size;
     uint8_t *buff = buf->buf_ptr;
 
-    uint16_t num_bytes = fifoBuf_getFree(buf);
+    uint16_t num_bytes = fifoBuf_free(buf->rd, wr, buf_size);
     if (num_bytes < 1)
         return 0;
 
@@ -229,7 +231,7 @@ uint16_t fifoBuf_putData(t_fifo_buffer *buf, const void *data, uint16_t len)
     uint16_t buf_size = buf->buf_size;
     uint8_t *buff = buf->buf_ptr;
 
-    uint16_t num_bytes = fifoBuf_getFree(buf);
+    uint16_t num_bytes = fifoBuf_free(buf->rd, wr, buf_size);
     if (num_bytes > len)
         num_bytes = len;
 
@@ -257,6 +259,78 @@ uint16_t fifoBuf_putData(t_fifo_buffer *buf, const void *data, uint16_t len)
     return i;                   // return number of bytes copied
 }
 
+uint16_t fifoBuf_reserve(t_fifo_buffer *buf, t_fifo_span *span)
+{       // get the free space of the buffer to write into, see fifoBuf_commit
+
+    uint16_t rd = buf->rd;
+    uint16_t wr = buf->wr;
+    uint16_t buf_size = buf->buf_size;
+    uint8_t *buff = buf->buf_ptr;
+
+    span->ptr[0] = buff + wr;
+    span->ptr[1] = buff;
+    span->len[1] = 0;
+
+    if (buf_size == 0)
+        span->len[0] = 0;
+    else if (rd > wr)
+        span->len[0] = rd - wr - 1;     // up to the byte before the reader
+    else if (rd == 0)
+        span->len[0] = buf_size - wr - 1;   // the last byte stays free
+    else
+    {
+        span->len[0] = buf_size - wr;   // to the end, then wrap
+        span->len[1] = rd - 1;
+    }
+
+    return span->len[0] + span->len[1];     // same as fifoBuf_getFree
+}
+
+uint16_t fifoBuf_commit(t_fifo_buffer *buf, uint16_t len)
+{       // add len bytes written into the space from fifoBuf_reserve, returns the number of bytes added
+
+    uint16_t wr = buf->wr;
+    uint16_t buf_size = buf->buf_size;
+
+    uint16_t num_bytes = fifoBuf_free(buf->rd, wr, buf_size);
+    if (num_bytes > len)
+        num_bytes = len;
+
+    if (num_bytes < 1)
+        return 0;
+
+    wr += num_bytes;
+    if (wr >= buf_size)
+        wr -= buf_size;
+
+    buf->wr = wr;                       // publish the data in one store
+
+    return num_bytes;
+}
+
+uint16_t fifoBuf_peek(t_fifo_buffer *buf, t_fifo_span *span)
+{       // get the data in the buffer without copying, see fifoBuf_removeData
+
+    uint16_t rd = buf->rd;
+    uint16_t wr = buf->wr;
+    uint16_t buf_size = buf->buf_size;
+    uint8_t *buff = buf->buf_ptr;
+
+    span->ptr[0] = buff + rd;
+    span->ptr[1] = buff;
+    span->len[1] = 0;
+
+    if (wr >= rd)
+        span->len[0] = wr - rd;
+    else
+    {
+        span->len[0] = buf_size - rd;   // to the end, then wrap
+        span->len[1] = wr;
+    }
+
+    return span->len[0] + span->len[1];     // same as fifoBuf_getUsed
+}
+
 void fifoBuf_init(t_fifo_buffer *buf, const void *buffer, const uint16_t buffer_size)
 {
     buf->buf_ptr = (uint8_t *)buffer;
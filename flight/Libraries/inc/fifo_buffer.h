@@ -40,6 +40,14 @@ typedef struct
     uint16_t buf_size;
 } t_fifo_buffer;
 
+// Up to two contiguous regions of a buffer, the second one only when the
+// region wraps around the end, and then starting at its beginning
+typedef struct
+{
+    uint8_t *ptr[2];
+    uint16_t len[2];
+} t_fifo_span;
+
 // *********************
 
 uint16_t fifoBuf_getSize(t_fifo_buffer *buf);
@@ -60,6 +68,12 @@ uint16_t fifoBuf_putByte(t_fifo_buffer *buf, const uint8_t b);
 
 uint16_t fifoBuf_putData(t_fifo_buffer *buf, const void *data, uint16_t len);
 
+// Zero copy access: write into the free space then commit it, or read the
+// data in place then release it with fifoBuf_removeData
+uint16_t fifoBuf_reserve(t_fifo_buffer *buf, t_fifo_span *span);
+uint16_t fifoBuf_commit(t_fifo_buffer *buf, uint16_t len);
+uint16_t fifoBuf_peek(t_fifo_buffer *buf, t_fifo_span *span);
+
 void fifoBuf_init(t_fifo_buffer *buf, const void *buffer, const uint16_t buffer_size);
 
 #endif /* _FIFO_BUFFER_H_ */
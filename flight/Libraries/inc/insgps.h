@@ -60,9 +60,12 @@ void INSGPSInit();
 //! Compute an update of the state estimate
 void INSStatePrediction(const float gyro_data[3], const float accel_data[3], float dT);
 
-//! Compute an update of the state covariance
+//! Compute an update of the state covariance, dT can span several state predictions
 void INSCovariancePrediction(float dT);
 
+//! Shift a delayed position and velocity measurement to the current time
+void INSCompensateDelay(float delay, float Pos[3], float Vel[3]);
+
 //! Correct the state and covariance estimate based on the sensors that were updated
 void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[3], float BaroAlt, uint16_t SensorsUsed);
 
@@ -34,6 +34,8 @@ int32_t TaskMonitorAdd(TaskInfoRunningElem task, xTaskHandle handle);
 int32_t TaskMonitorRemove(TaskInfoRunningElem task);
 bool TaskMonitorQueryRunning(TaskInfoRunningElem task);
 void TaskMonitorUpdateAll(void);
+void TaskMonitorLoopBegin(TaskInfoRunningElem task);
+void TaskMonitorLoopEnd(TaskInfoRunningElem task);
 
 #endif // TASKMONITOR_H
 
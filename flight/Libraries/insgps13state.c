@@ -38,6 +38,9 @@
 #define NUMV 10			// number of measurements, v is the measurement noise vector
 #define NUMU 6			// number of deterministic inputs, U is the input vector
 
+#define HISTORY_LEN 64			// number of position and velocity snapshots
+#define HISTORY_PERIOD_US 5000	// minimum time between two snapshots (us)
+
 #if defined(GENERAL_COV)
 // This might trick people so I have a note here.  There is a slower but bigger version of the 
 // code here but won't fit when debugging disabled (requires -Os)
@@ -63,6 +66,22 @@ static float Be[3];	                    // local magnetic unit vector in NED fra
 static float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
 static float Q[NUMW], R[NUMV];   // input noise and measurement noise variances
 static float K[NUMX][NUMV];	     // feedback gain matrix
+static float U[NUMU];	             // inputs of the last state prediction
+static float state_dT;	             // time step of the last state prediction
+
+// Recent positions and velocities, for measurements that arrive late
+static struct {
+	uint32_t time_us;
+	float pos[3];
+	float vel[3];
+} history[HISTORY_LEN];
+static uint8_t history_head;
+static uint8_t history_count;
+static uint32_t ins_time_us;
+static float history_pending_us;
+
+static void ResetHistory();
+static void RecordHistory(float dT);
 
 //  *************  Exposed Functions ****************
 //  *************************************************
@@ -120,6 +139,12 @@ void INSGPSInit()		//pretty much just a place holder for now
 	R[5] = 100.0f;          // High freq GPS vertical velocity noise variance (m/s)^2
 	R[6] = R[7] = R[8] = 0.005f;    // magnetometer unit vector noise variance
 	R[9] = .25f;                    // High freq altimeter noise variance (m^2)
+
+	for (int i = 0; i < NUMU; i++)
+		U[i] = 0.0f;
+	state_dT = 0.0f;
+
+	ResetHistory();
 }
 
 /**
@@ -197,6 +222,8 @@ void INSSetState(const float pos[3], const float vel[3], const float q[4], const
 	X[10] = gyro_bias[0];
 	X[11] = gyro_bias[1];
 	X[12] = gyro_bias[2];
+
+	ResetHistory();
 }
 
 void INSPosVelReset(const float pos[3], const float vel[3]) 
@@ -217,6 +244,8 @@ void INSPosVelReset(const float pos[3], const float vel[3])
 	X[3] = vel[0];
 	X[4] = vel[1];
 	X[5] = vel[2];	
+
+	ResetHistory();
 }
 
 void INSSetPosVelVar(float PosVar, float VelVar, float VertPosVar)
@@ -270,9 +299,13 @@ void INSSetMagNorth(const float B[3])
 	Be[2] = B[2] / mag;
 }
 
+/**
+ * Propagate the state with the gyro and accel inputs. The covariance is
+ * propagated separately by INSCovariancePrediction, which can run at a
+ * lower rate.
+ */
 void INSStatePrediction(const float gyro_data[3], const float accel_data[3], float dT)
 {
-	float U[6];
 	float qmag;
 
 	// rate gyro inputs in units of rad/s
@@ -286,19 +319,88 @@ void INSStatePrediction(const float gyro_data[3], const float accel_data[3], flo
 	U[5] = accel_data[2];
 
 	// EKF prediction step
-	LinearizeFG(X, U, F, G);
 	RungeKutta(X, U, dT);
 	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
 	X[6] /= qmag;
 	X[7] /= qmag;
 	X[8] /= qmag;
 	X[9] /= qmag;
-	//CovariancePrediction(F,G,Q,dT,P);
+
+	state_dT = dT;
+	RecordHistory(dT);
 }
 
+/**
+ * Propagate the covariance over dT, linearized about the current state
+ * and the last inputs. When dT spans several state predictions the
+ * process noise is scaled so it matches what the individual steps would
+ * have added.
+ */
 void INSCovariancePrediction(float dT)
 {
-	CovariancePrediction(F, G, Q, dT, P);
+	float Qs[NUMW];
+	float scale = 1.0f;
+
+	if (state_dT > 0.0f && dT > state_dT)
+		scale = state_dT / dT;
+	for (int i = 0; i < NUMW; i++)
+		Qs[i] = Q[i] * scale;
+
+	LinearizeFG(X, U, F, G);
+	CovariancePrediction(F, G, Qs, dT, P);
+}
+
+/**
+ * Shift a measurement taken delay seconds ago to the current time, by
+ * adding how far the state moved since then. Either pointer can be NULL.
+ * @param[in] delay Age of the measurement (s)
+ * @param[in,out] Pos Position measurement in NED (m)
+ * @param[in,out] Vel Velocity measurement in NED (m/s)
+ */
+void INSCompensateDelay(float delay, float Pos[3], float Vel[3])
+{
+	uint32_t delay_us = (uint32_t) (delay * 1e6f);
+	float pos_then[3], vel_then[3];
+	uint8_t newer, older;
+
+	if (history_count == 0 || delay_us == 0)
+		return;
+
+	// Walk back from the newest snapshot to the two around the
+	// measurement time
+	newer = (history_head + HISTORY_LEN - 1) % HISTORY_LEN;
+	older = newer;
+	for (uint8_t n = 1; n < history_count; n++) {
+		older = (newer + HISTORY_LEN - 1) % HISTORY_LEN;
+		if (ins_time_us - history[older].time_us >= delay_us)
+			break;
+		newer = older;
+	}
+
+	uint32_t age_newer = ins_time_us - history[newer].time_us;
+	uint32_t age_older = ins_time_us - history[older].time_us;
+	float t = 0.0f;
+	if (age_older > age_newer && delay_us > age_newer) {
+		t = (float) (delay_us - age_newer) / (float) (age_older - age_newer);
+		if (t > 1.0f)
+			t = 1.0f;
+	}
+
+	for (int i = 0; i < 3; i++) {
+		pos_then[i] = history[newer].pos[i] + t * (history[older].pos[i] - history[newer].pos[i]);
+		vel_then[i] = history[newer].vel[i] + t * (history[older].vel[i] - history[newer].vel[i]);
+	}
+
+	if (Pos) {
+		Pos[0] += X[0] - pos_then[0];
+		Pos[1] += X[1] - pos_then[1];
+		Pos[2] += X[2] - pos_then[2];
+	}
+	if (Vel) {
+		Vel[0] += X[3] - vel_then[0];
+		Vel[1] += X[4] - vel_then[1];
+		Vel[2] += X[5] - vel_then[2];
+	}
 }
 
 void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[3],
@@ -339,6 +441,35 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 	X[9] /= qmag;
 }
 
+static void ResetHistory()
+{
+	history_head = 0;
+	history_count = 0;
+	history_pending_us = HISTORY_PERIOD_US;
+}
+
+static void RecordHistory(float dT)
+{
+	ins_time_us += (uint32_t) (dT * 1e6f);
+	history_pending_us += dT * 1e6f;
+	if (history_pending_us < HISTORY_PERIOD_US)
+		return;
+
+	// Keep the average spacing, unless the prediction steps are longer
+	history_pending_us -= HISTORY_PERIOD_US;
+	if (history_pending_us >= HISTORY_PERIOD_US)
+		history_pending_us = 0;
+
+	history[history_head].time_us = ins_time_us;
+	for (int i = 0; i < 3; i++) {
+		history[history_head].pos[i] = X[i];
+		history[history_head].vel[i] = X[3 + i];
+	}
+	history_head = (history_head + 1) % HISTORY_LEN;
+	if (history_count < HISTORY_LEN)
+		history_count++;
+}
+
 //  *************  CovariancePrediction *************
 //  Does the prediction step of the Kalman filter for the covariance matrix
 //  Output, Pnew, overwrites P, the input covariance
@@ -33,6 +33,7 @@
  */
 
 #include <math.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "coordinate_conversions.h"
 #include "physical_constants.h"
@@ -365,6 +366,58 @@ void rot_mult(float R[3][3], const float vec[3], float vec_out[3], bool transpos
 
 }
 
+/**
+ * @brief Fold a three axis sensor calibration into one affine transform
+ * @param[out] A the 3x4 transform, out = A[:][0..2] * raw + A[:][3]
+ * @param[in] R rotation applied after scale and bias, or NULL for none
+ * @param[in] transpose If false use R, else if true use R'
+ * @param[in] scale per axis scale of the raw sample
+ * @param[in] bias per axis bias removed after scaling
+ * @param[in] offset added after the rotation
+ *
+ * Applying A gives the same result as
+ * rot_mult(R, raw .* scale - bias, out, transpose) + offset
+ */
+void affine_from_calibration(float A[3][4], float R[3][3], bool transpose,
+		const float scale[3], const float bias[3], const float offset[3])
+{
+	for (int i = 0; i < 3; i++) {
+		A[i][3] = offset[i];
+		for (int j = 0; j < 3; j++) {
+			float r;
+			if (R == NULL)
+				r = (i == j) ? 1.0f : 0.0f;
+			else
+				r = transpose ? R[j][i] : R[i][j];
+
+			A[i][j] = r * scale[j];
+			A[i][3] -= r * bias[j];
+		}
+	}
+}
+
+/**
+ * @brief Apply an affine transform to a block of three axis samples
+ * @param[in] A the 3x4 transform from @ref affine_from_calibration
+ * @param[in] in n samples stored as consecutive x, y, z
+ * @param[out] out n transformed samples, may be the same as in
+ * @param[in] n number of samples
+ */
+void affine_apply(const float A[3][4], const float *in, float *out, uint32_t n)
+{
+	// Keep the coefficients in registers for the whole block
+	const float a00 = A[0][0], a01 = A[0][1], a02 = A[0][2], a03 = A[0][3];
+	const float a10 = A[1][0], a11 = A[1][1], a12 = A[1][2], a13 = A[1][3];
+	const float a20 = A[2][0], a21 = A[2][1], a22 = A[2][2], a23 = A[2][3];
+
+	for (uint32_t i = 0; i < n; i++, in += 3, out += 3) {
+		const float x = in[0], y = in[1], z = in[2];
+		out[0] = a00 * x + a01 * y + a02 * z + a03;
+		out[1] = a10 * x + a11 * y + a12 * z + a13;
+		out[2] = a20 * x + a21 * y + a22 * z + a23;
+	}
+}
+
 /**
  * @}
  * @}
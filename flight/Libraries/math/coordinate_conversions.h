@@ -36,6 +36,7 @@
 #define COORDINATECONVERSIONS_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
 void RneFromLLA(float LLA[3], float Rne[3][3]);
 
@@ -74,6 +75,10 @@ void quat_copy(const float q[4], float qnew[4]);
 void quat_mult(const float q1[4], const float q2[4], float qout[4]);
 void rot_mult(float R[3][3], const float vec[3], float vec_out[3], bool transpose);
 
+void affine_from_calibration(float A[3][4], float R[3][3], bool transpose,
+		const float scale[3], const float bias[3], const float offset[3]);
+void affine_apply(const float A[3][4], const float *in, float *out, uint32_t n);
+
 #endif /* COORDINATECONVERSIONS_H_ */
 
 /**
@@ -27,15 +27,44 @@
 
 #include "openpilot.h"
 //#include "taskmonitor.h"
+#if defined(DIAG_TASKS)
+#include "taskbudgetsettings.h"
+#include "taskbudgetstats.h"
+#endif
 
 // Private constants
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+/* The run time counter counts CPU cycles on every target */
+#define RUN_TIME_PER_US (PIOS_SYSCLK / 1000000)
+#endif
 
 // Private types
 
+/**
+ * Execution time of the loop of one task since the last update, only
+ * written by the task itself. With run time stats this is the CPU time of
+ * the task, otherwise the wall time.
+ */
+struct TaskBudget {
+	uint32_t loopStart;
+	uint32_t loopTimeMax;
+	uint32_t loopTimeSum;
+	uint16_t loops;
+	uint16_t overruns;
+	uint16_t throttled;
+};
+
 // Private variables
 static xSemaphoreHandle lock;
 static xTaskHandle handles[TASKINFO_RUNNING_NUMELEM];
 static uint32_t lastMonitorTime;
+#if defined(DIAG_TASKS)
+static struct TaskBudget budgets[TASKINFO_RUNNING_NUMELEM];
+static TaskBudgetSettingsData budgetSettings;
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+static uint32_t lastRunTime[TASKINFO_RUNNING_NUMELEM];
+#endif
+#endif
 
 // Private functions
 
@@ -49,6 +78,14 @@ int32_t TaskMonitorInitialize(void)
 	lastMonitorTime = 0;
 #if defined(DIAG_TASKS)
 	lastMonitorTime = portGET_RUN_TIME_COUNTER_VALUE();
+
+	memset(budgets, 0, sizeof(budgets));
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+	memset(lastRunTime, 0, sizeof(lastRunTime));
+#endif
+	TaskBudgetSettingsInitialize();
+	TaskBudgetStatsInitialize();
+	TaskBudgetSettingsGet(&budgetSettings);
 #endif
 	return 0;
 }
@@ -62,6 +99,9 @@ int32_t TaskMonitorAdd(TaskInfoRunningElem task, xTaskHandle handle)
 	{
 	    xSemaphoreTakeRecursive(lock, portMAX_DELAY);
 		handles[task] = handle;
+#if defined(DIAG_TASKS) && ( configGENERATE_RUN_TIME_STATS == 1 )
+		lastRunTime[task] = 0;
+#endif
 		xSemaphoreGiveRecursive(lock);
 		return 0;
 	}
@@ -137,8 +177,10 @@ void TaskMonitorUpdateAll(void)
 			data.StackRemaining[n] = uxTaskGetStackHighWaterMark(handles[n]) * 4;
 #endif
 #if ( configGENERATE_RUN_TIME_STATS == 1 )
-			/* Generate run time stats */
-			data.RunningTime[n] = uxTaskGetRunTime(handles[n]) / deltaTime;
+			/* Generate run time stats, the counter is left running for the loop budgets */
+			uint32_t runTime = uxTaskGetRunTimeCounter(handles[n]);
+			data.RunningTime[n] = (runTime - lastRunTime[n]) / deltaTime;
+			lastRunTime[n] = runTime;
 #endif
 			
 		}
@@ -153,11 +195,93 @@ void TaskMonitorUpdateAll(void)
 	// Update object
 	TaskInfoSet(&data);
 
+	// Publish the loop execution times and pick up new budgets
+	static TaskBudgetStatsData budgetStats;
+	for (n = 0; n < TASKINFO_RUNNING_NUMELEM; ++n)
+	{
+		struct TaskBudget *budget = &budgets[n];
+
+		portENTER_CRITICAL();
+		budgetStats.LoopTimeMax[n] = budget->loopTimeMax;
+		budgetStats.LoopTimeAvg[n] = budget->loops ? budget->loopTimeSum / budget->loops : 0;
+		budgetStats.Overruns[n] = budget->overruns;
+		budgetStats.Throttled[n] = budget->throttled;
+		budget->loopTimeMax = 0;
+		budget->loopTimeSum = 0;
+		budget->loops = 0;
+		budget->overruns = 0;
+		budget->throttled = 0;
+		portEXIT_CRITICAL();
+	}
+	TaskBudgetStatsSet(&budgetStats);
+	TaskBudgetSettingsGet(&budgetSettings);
+
 	// Done
 	xSemaphoreGiveRecursive(lock);
 #endif
 }
 
+/**
+ * Mark the start of one iteration of a module loop
+ */
+void TaskMonitorLoopBegin(TaskInfoRunningElem task)
+{
+#if defined(DIAG_TASKS)
+	if (task < TASKINFO_RUNNING_NUMELEM) {
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+		budgets[task].loopStart = uxTaskGetRunTimeCounter(NULL);
+#else
+		budgets[task].loopStart = PIOS_DELAY_GetRaw();
+#endif
+	}
+#endif
+}
+
+/**
+ * Mark the end of one iteration of a module loop. The CPU time the task
+ * used since TaskMonitorLoopBegin is checked against its budget, time it
+ * was preempted does not count. Without run time stats the wall time is
+ * used instead. If the budget is exceeded and throttling is enabled for the
+ * task it sleeps for the time it overran so that lower priority tasks get
+ * the CPU back. Stabilization is never throttled.
+ */
+void TaskMonitorLoopEnd(TaskInfoRunningElem task)
+{
+#if defined(DIAG_TASKS)
+	if (task >= TASKINFO_RUNNING_NUMELEM)
+		return;
+
+	struct TaskBudget *budget = &budgets[task];
+#if ( configGENERATE_RUN_TIME_STATS == 1 )
+	uint32_t loopTime = (uxTaskGetRunTimeCounter(NULL) - budget->loopStart) / RUN_TIME_PER_US;
+#else
+	uint32_t loopTime = PIOS_DELAY_DiffuS(budget->loopStart);
+#endif
+	uint32_t budgetUs = budgetSettings.Budget[task];
+	portTickType throttleTicks = 0;
+
+	portENTER_CRITICAL();
+	if (loopTime > budget->loopTimeMax)
+		budget->loopTimeMax = loopTime;
+	budget->loopTimeSum += loopTime;
+	++budget->loops;
+	if (budgetUs > 0 && loopTime > budgetUs) {
+		++budget->overruns;
+		if (budgetSettings.Throttle[task] == TASKBUDGETSETTINGS_THROTTLE_TRUE &&
+				task != TASKINFO_RUNNING_STABILIZATION) {
+			++budget->throttled;
+			throttleTicks = MS2TICKS((loopTime - budgetUs) / 1000);
+			if (throttleTicks == 0)
+				throttleTicks = 1;
+		}
+	}
+	portEXIT_CRITICAL();
+
+	if (throttleTicks > 0)
+		vTaskDelay(throttleTicks);
+#endif
+}
+
 /**
  * @}
  */
\ No newline at end of file
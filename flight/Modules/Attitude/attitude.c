@@ -75,6 +75,14 @@
 #define TASK_PRIORITY (tskIDLE_PRIORITY+3)
 #define FAILSAFE_TIMEOUT_MS 10
 
+// Bits of the sensor notifier
+#define GYROS_UPDATED      0x01
+#define ACCELS_UPDATED     0x02
+#define MAG_UPDATED        0x04
+#define BARO_UPDATED       0x08
+#define GPS_UPDATED        0x10
+#define GPSVEL_UPDATED     0x20
+
 // Private types
 
 // Track the initialization state of the complementary filter
@@ -115,12 +123,7 @@ struct complementary_filter_state {
 // Private variables
 static xTaskHandle attitudeTaskHandle;
 
-static xQueueHandle gyroQueue;
-static xQueueHandle accelQueue;
-static xQueueHandle magQueue;
-static xQueueHandle baroQueue;
-static xQueueHandle gpsQueue;
-static xQueueHandle gpsVelQueue;
+static UAVObjNotifier sensorNotifier;
 
 static AttitudeSettingsData attitudeSettings;
 static HomeLocationData homeLocation;
@@ -170,10 +173,10 @@ static void set_state_estimation_error(SystemAlarmsStateEstimationOptions error_
 
 /**
  * API for sensor fusion algorithms:
- * Configure(xQueueHandle gyro, xQueueHandle accel, xQueueHandle mag, xQueueHandle baro)
- *   Stores all the queues the algorithm will pull data from
+ * Configure(UAVObjNotifier sensors)
+ *   Stores the notifier the algorithm will wait on for sensor updates
  * FinalizeSensors() -- before saving the sensors modifies them based on internal state (gyro bias)
- * Update() -- queries queues and updates the attitude estiamte
+ * Update() -- queries the notifier and updates the attitude estiamte
  */
 
 
@@ -211,13 +214,10 @@ int32_t AttitudeInitialize(void)
  */
 int32_t AttitudeStart(void)
 {
-	// Create the queues for the sensors
-	gyroQueue = xQueueCreate(1, sizeof(UAVObjEvent));
-	accelQueue = xQueueCreate(1, sizeof(UAVObjEvent));
-	magQueue = xQueueCreate(2, sizeof(UAVObjEvent));
-	baroQueue = xQueueCreate(1, sizeof(UAVObjEvent));
-	gpsQueue = xQueueCreate(1, sizeof(UAVObjEvent));
-	gpsVelQueue = xQueueCreate(1, sizeof(UAVObjEvent));
+	// Create the notifier for the sensors
+	sensorNotifier = UAVObjNotifierCreate();
+	if (sensorNotifier == NULL)
+		return -1;
 
 	// Initialize quaternion
 	AttitudeActualData attitude;
@@ -236,16 +236,16 @@ int32_t AttitudeStart(void)
 	gyrosBias.z = 0;
 	GyrosBiasSet(&gyrosBias);
 
-	GyrosConnectQueue(gyroQueue);
-	AccelsConnectQueue(accelQueue);
+	GyrosConnectNotifier(sensorNotifier, GYROS_UPDATED);
+	AccelsConnectNotifier(sensorNotifier, ACCELS_UPDATED);
 	if (MagnetometerHandle())
-		MagnetometerConnectQueue(magQueue);
+		MagnetometerConnectNotifier(sensorNotifier, MAG_UPDATED);
 	if (BaroAltitudeHandle())
-		BaroAltitudeConnectQueue(baroQueue);
+		BaroAltitudeConnectNotifier(sensorNotifier, BARO_UPDATED);
 	if (GPSPositionHandle())
-		GPSPositionConnectQueue(gpsQueue);
+		GPSPositionConnectNotifier(sensorNotifier, GPS_UPDATED);
 	if (GPSVelocityHandle())
-		GPSVelocityConnectQueue(gpsVelQueue);
+		GPSVelocityConnectNotifier(sensorNotifier, GPSVEL_UPDATED);
 
 	// Start main task
 	xTaskCreate(AttitudeTask, (signed char *)"Attitude", STACK_SIZE_BYTES/4, NULL, TASK_PRIORITY, &attitudeTaskHandle);
@@ -355,7 +355,6 @@ static float cf_q[4];
  */
 static int32_t updateAttitudeComplementary(bool first_run, bool secondary)
 {
-	UAVObjEvent ev;
 	GyrosData gyrosData;
 	AccelsData accelsData;
 	static int32_t timeval;
@@ -365,8 +364,8 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary)
 	// If this is the primary estimation filter, wait until the accel and
 	// gyro objects are updated. If it timeouts then go to failsafe.
 	if (!secondary) {
-		bool gyroTimeout  = (xQueueReceive(gyroQueue, &ev, MS2TICKS(FAILSAFE_TIMEOUT_MS)) != pdTRUE);
-		bool accelTimeout = (xQueueReceive(accelQueue, &ev, MS2TICKS(1)) != pdTRUE );
+		bool gyroTimeout  = (UAVObjNotifierWait(sensorNotifier, GYROS_UPDATED, MS2TICKS(FAILSAFE_TIMEOUT_MS)) == 0);
+		bool accelTimeout = (UAVObjNotifierWait(sensorNotifier, ACCELS_UPDATED, MS2TICKS(1)) == 0);
 
 		// When one of these is updated so should the other.
 		if (gyroTimeout || accelTimeout) {
@@ -395,7 +394,7 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary)
 
 		// Wait for a mag reading if a magnetometer was registered
 		if (PIOS_SENSORS_GetQueue(PIOS_SENSOR_MAG) != NULL) {
-			if ( !secondary && xQueueReceive(magQueue, &ev, MS2TICKS(20)) != pdTRUE ) {
+			if ( !secondary && UAVObjNotifierWait(sensorNotifier, MAG_UPDATED, MS2TICKS(20)) == 0 ) {
 				return -1;
 			}
 			MagnetometerGet(&magData);
@@ -432,7 +431,7 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary)
 		(ms_since_reset > 1000)) {
 
 		// For first 7 seconds use accels to get gyro bias
-		attitudeSettings.AccelKp = 0.1f + 0.1f * (xTaskGetTickCount() < 4000);
+		attitudeSettings.AccelKp = 0.1f + 0.1f * (ms_since_reset < 4000);
 		attitudeSettings.AccelKi = 0.1f;
 		attitudeSettings.YawBiasRate = 0.1f;
 		attitudeSettings.MagKp = 0.1f;
@@ -530,7 +529,7 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary)
 	}
 
 	float mag_err[3];
-	if ( secondary || xQueueReceive(magQueue, &ev, 0) == pdTRUE )
+	if ( secondary || UAVObjNotifierWait(sensorNotifier, MAG_UPDATED, 0) != 0 )
 	{
 		MagnetometerData mag;
 		MagnetometerGet(&mag);
@@ -556,15 +555,16 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary)
 			}
 
 			float mag_len = sqrtf(mag.x * mag.x + mag.y * mag.y + mag.z * mag.z);
-			mag.x /= mag_len;
-			mag.y /= mag_len;
-			mag.z /= mag_len;
 
 			// Only compute if neither vector is null
-			if (bmag < 1 || mag_len < 1)
+			if (bmag < 1 || mag_len < 1) {
 				mag_err[0] = mag_err[1] = mag_err[2] = 0;
-			else
+			} else {
+				mag.x /= mag_len;
+				mag.y /= mag_len;
+				mag.z /= mag_len;
 				CrossProduct((const float *) &mag.x, (const float *) brot, mag_err);
+			}
 
 			if (mag_err[2] != mag_err[2])
 				mag_err[2] = 0;
@@ -634,11 +634,9 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary)
 //! Set the navigation information to the raw estimates
 static int32_t setNavigationRaw()
 {
-	UAVObjEvent ev;
-
-	// Flush these queues for avoid errors
-	xQueueReceive(baroQueue, &ev, 0);
-	if ( xQueueReceive(gpsQueue, &ev, 0) == pdTRUE && homeLocation.Set == HOMELOCATION_SET_TRUE ) {
+	// Flush these updates for avoid errors
+	uint32_t updated = UAVObjNotifierWait(sensorNotifier, BARO_UPDATED | GPS_UPDATED | GPSVEL_UPDATED, 0);
+	if ( (updated & GPS_UPDATED) && homeLocation.Set == HOMELOCATION_SET_TRUE ) {
 		float NED[3];
 		// Transform the GPS position into NED coordinates
 		GPSPositionData gpsPosition;
@@ -660,7 +658,7 @@ static int32_t setNavigationRaw()
 		PositionActualSet(&positionActual);
 	}
 
-	if ( xQueueReceive(gpsVelQueue, &ev, 0) == pdTRUE ) {
+	if ( updated & GPSVEL_UPDATED ) {
 		// Transform the GPS position into NED coordinates
 		GPSVelocityData gpsVelocity;
 		GPSVelocityGet(&gpsVelocity);
@@ -763,7 +761,6 @@ static bool home_location_updated;
  */
 static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 {
-	UAVObjEvent ev;
 	GyrosData gyrosData;
 	AccelsData accelsData;
 	MagnetometerData magData;
@@ -784,6 +781,10 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	static uint32_t ins_last_time = 0;
 	static bool inited;
 
+	// Time the covariance has not been propagated over yet
+	static float cov_dT;
+	static uint8_t cov_steps;
+
 	float NED[3] = {0.0f, 0.0f, 0.0f};
 	float vel[3] = {0.0f, 0.0f, 0.0f};
 
@@ -805,18 +806,22 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		home_location_updated = false;
 
 		ins_last_time = PIOS_DELAY_GetRaw();
+		cov_dT = 0;
+		cov_steps = 0;
 
 		return 0;
 	}
 
-	mag_updated |= (xQueueReceive(magQueue, &ev, MS2TICKS(0)) == pdTRUE);
-	baro_updated |= xQueueReceive(baroQueue, &ev, MS2TICKS(0)) == pdTRUE;
-	gps_updated |= (xQueueReceive(gpsQueue, &ev, MS2TICKS(0)) == pdTRUE) && outdoor_mode;
-	gps_vel_updated |= (xQueueReceive(gpsVelQueue, &ev, MS2TICKS(0)) == pdTRUE) && outdoor_mode;
+	uint32_t updated = UAVObjNotifierWait(sensorNotifier,
+		MAG_UPDATED | BARO_UPDATED | GPS_UPDATED | GPSVEL_UPDATED, 0);
+	mag_updated |= (updated & MAG_UPDATED) != 0;
+	baro_updated |= (updated & BARO_UPDATED) != 0;
+	gps_updated |= (updated & GPS_UPDATED) && outdoor_mode;
+	gps_vel_updated |= (updated & GPSVEL_UPDATED) && outdoor_mode;
 
 	// Wait until the gyro and accel object is updated, if a timeout then go to failsafe
-	if ( (xQueueReceive(gyroQueue, &ev, MS2TICKS(FAILSAFE_TIMEOUT_MS)) != pdTRUE) ||
-		 (xQueueReceive(accelQueue, &ev, MS2TICKS(1)) != pdTRUE) )
+	if ( (UAVObjNotifierWait(sensorNotifier, GYROS_UPDATED, MS2TICKS(FAILSAFE_TIMEOUT_MS)) == 0) ||
+		 (UAVObjNotifierWait(sensorNotifier, ACCELS_UPDATED, MS2TICKS(1)) == 0) )
 	{
 		return -1;
 	}
@@ -931,6 +936,8 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		inited = true;
 
 		ins_last_time = PIOS_DELAY_GetRaw();	
+		cov_dT = 0;
+		cov_steps = 0;
 
 		return 0;
 	}
@@ -970,11 +977,10 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		INSSetGyroBias(zeros);
 	}
 
-	// Advance the state estimate
+	// Advance the state estimate at the gyro rate
 	INSStatePrediction(gyros, &accelsData.x, dT);
-
-	// Advance the covariance estimate
-	INSCovariancePrediction(dT);
+	cov_dT += dT;
+	cov_steps++;
 
 	if(mag_updated) {
 		sensors |= MAG_SENSORS;
@@ -1003,6 +1009,10 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		nedPos.Down = NED[2];
 		NEDPositionSet(&nedPos);
 
+		// Move the fix to the current time
+		if (insSettings.GPSDelay > 0)
+			INSCompensateDelay(insSettings.GPSDelay / 1000.0f, NED, NULL);
+
 		gps_updated = false;
 	}
 
@@ -1014,6 +1024,9 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		vel[1] = gpsVelData.East;
 		vel[2] = gpsVelData.Down;
 
+		if (insSettings.GPSDelay > 0)
+			INSCompensateDelay(insSettings.GPSDelay / 1000.0f, NULL, vel);
+
 		gps_vel_updated = false;
 	}
 
@@ -1028,6 +1041,14 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		sensors |= VERT_VEL_SENSORS | VERT_POS_SENSORS;
 	}
 
+	// Advance the covariance estimate at the decimated rate, and always
+	// before a correction so the measurements are fused as they arrive
+	if (sensors || cov_steps >= insSettings.CovarianceDecimation) {
+		INSCovariancePrediction(cov_dT);
+		cov_dT = 0;
+		cov_steps = 0;
+	}
+
 	/*
 	 * TODO: Need to add a general sanity check for all the inputs to make sure their kosher
 	 * although probably should occur within INS itself
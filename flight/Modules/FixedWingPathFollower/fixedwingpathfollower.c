@@ -194,6 +194,7 @@ static void pathfollowerTask(void *parameters)
 
 		// Continue collecting data if not enough time
 		vTaskDelayUntil(&lastUpdateTime, fixedwingpathfollowerSettings.UpdatePeriod / portTICK_RATE_MS);
+		TaskMonitorLoopBegin(TASKINFO_RUNNING_PATHFOLLOWER);
 
 		
 		FlightStatusGet(&flightStatus);
@@ -253,6 +254,8 @@ static void pathfollowerTask(void *parameters)
 				break;
 		}
 		PathStatusSet(&pathStatus);
+
+		TaskMonitorLoopEnd(TASKINFO_RUNNING_PATHFOLLOWER);
 	}
 }
 
@@ -66,6 +66,7 @@ static void setHomeLocation(GPSPositionData * gpsData);
 
 #define GPS_TIMEOUT_MS                  500
 #define GPS_COM_TIMEOUT_MS              100
+#define GPS_READ_BUFFER                 16
 
 
 #ifdef PIOS_GPS_SETS_HOMELOCATION
@@ -217,33 +218,41 @@ static void gpsTask(void *parameters)
 	// Loop forever
 	while (1)
 	{
-		uint8_t c;
+		uint8_t c[GPS_READ_BUFFER];
+		uint16_t received;
 
-		// This blocks the task until there is something on the buffer
-		while (PIOS_COM_ReceiveBuffer(gpsPort, &c, 1, xDelay) > 0)
+		// This blocks the task until there is something on the buffer.
+		// One batch of received bytes is one loop for the task monitor.
+		while ((received = PIOS_COM_ReceiveBuffer(gpsPort, c, sizeof(c), xDelay)) > 0)
 		{
-			int res;
-			switch (gpsProtocol) {
+			TaskMonitorLoopBegin(TASKINFO_RUNNING_GPS);
+
+			for (uint16_t i = 0; i < received; i++) {
+				int res;
+				switch (gpsProtocol) {
 #if defined(PIOS_INCLUDE_GPS_NMEA_PARSER)
-				case MODULESETTINGS_GPSDATAPROTOCOL_NMEA:
-					res = parse_nmea_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
-					break;
+					case MODULESETTINGS_GPSDATAPROTOCOL_NMEA:
+						res = parse_nmea_stream (c[i],gps_rx_buffer, &gpsposition, &gpsRxStats);
+						break;
 #endif
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER)
-				case MODULESETTINGS_GPSDATAPROTOCOL_UBX:
-					res = parse_ubx_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
-					break;
+					case MODULESETTINGS_GPSDATAPROTOCOL_UBX:
+						res = parse_ubx_stream (c[i],gps_rx_buffer, &gpsposition, &gpsRxStats);
+						break;
 #endif
-				default:
-					res = NO_PARSER; // this should not happen
-					break;
+					default:
+						res = NO_PARSER; // this should not happen
+						break;
+				}
+
+				if (res == PARSER_COMPLETE) {
+					timeNowMs = TICKS2MS(xTaskGetTickCount());
+					timeOfLastUpdateMs = timeNowMs;
+					timeOfLastCommandMs = timeNowMs;
+				}
 			}
 
-			if (res == PARSER_COMPLETE) {
-				timeNowMs = TICKS2MS(xTaskGetTickCount());
-				timeOfLastUpdateMs = timeNowMs;
-				timeOfLastCommandMs = timeNowMs;
-			}
+			TaskMonitorLoopEnd(TASKINFO_RUNNING_GPS);
 		}
 
 		// Check for GPS timeout
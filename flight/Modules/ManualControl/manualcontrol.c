@@ -43,11 +43,16 @@
 #include "tablet_control.h"
 #include "transmitter_control.h"
 
+#include "actuatordesired.h"
 #include "flightstatus.h"
 #include "manualcontrolcommand.h"
 #include "manualcontrolsettings.h"
 #include "systemalarms.h"
 
+#if defined(RECEIVERLATENCY_DIAGNOSTICS)
+#include "receiverlatency.h"
+#endif
+
 // Private constants
 #if defined(PIOS_MANUAL_STACK_SIZE)
 #define STACK_SIZE_BYTES PIOS_MANUAL_STACK_SIZE
@@ -57,15 +62,22 @@
 
 #define TASK_PRIORITY (tskIDLE_PRIORITY+4)
 #define UPDATE_PERIOD_MS 20
+#define LATENCY_PUBLISH_PERIOD_MS 1000
 
 // Private variables
 static xTaskHandle taskHandle;
-static portTickType lastSysTime;
+#if defined(RECEIVERLATENCY_DIAGNOSTICS)
+static volatile bool latency_pending;
+static volatile uint32_t latency_frame_time;
+#endif
 
 // Private functions
 static void manualControlTask(void *parameters);
 static bool ok_to_arm(void);
 static FlightStatusControlSourceOptions control_source_select();
+#if defined(RECEIVERLATENCY_DIAGNOSTICS)
+static void actuator_desired_updated(UAVObjEvent * ev);
+#endif
 
 // Private functions for control events
 static int32_t control_event_arm();
@@ -94,6 +106,13 @@ int32_t ManualControlInitialize()
 	transmitter_control_initialize();
 	tablet_control_initialize();
 
+#if defined(RECEIVERLATENCY_DIAGNOSTICS)
+	// Costs an event callback on every control loop update
+	ReceiverLatencyInitialize();
+	UAVObjConnectCallbackPriority(ActuatorDesiredHandle(), actuator_desired_updated,
+			EV_MASK_ALL_UPDATES, EV_PRIORITY_HIGH);
+#endif
+
 
 	return 0;
 }
@@ -111,12 +130,14 @@ static void manualControlTask(void *parameters)
 	flightStatus.Armed = FLIGHTSTATUS_ARMED_DISARMED;
 	FlightStatusSet(&flightStatus);
 
-	// Main task loop
-	lastSysTime = xTaskGetTickCount();
-
 	// Select failsafe before run
 	failsafe_control_select(true);
 
+#if defined(RECEIVERLATENCY_DIAGNOSTICS)
+	bool new_frame = false;
+	uint32_t frame_time = 0;
+#endif
+
 	while (1) {
 
 		// Process periodic data for each of the controllers, including reading
@@ -125,6 +146,14 @@ static void manualControlTask(void *parameters)
 		transmitter_control_update();
 		tablet_control_update();
 
+#if defined(RECEIVERLATENCY_DIAGNOSTICS)
+		// Time the frame until the control loop acts on it
+		if (new_frame) {
+			latency_frame_time = frame_time;
+			latency_pending = true;
+		}
+#endif
+
 		// Initialize to invalid value to ensure first update sets FlightStatus
 		static FlightStatusControlSourceOptions last_control_selection = -1;
 		enum control_events control_events = CONTROL_EVENTS_NONE;
@@ -182,8 +211,14 @@ static void manualControlTask(void *parameters)
 			break;
 		}
 
-		// Wait until next update
-		vTaskDelayUntil(&lastSysTime, MS2TICKS(UPDATE_PERIOD_MS));
+		// Run again as soon as a receiver delivers a frame. Without one
+		// the inputs are still polled, which detects receiver timeouts
+		// and serves the receivers that do not signal frames (PWM)
+#if defined(RECEIVERLATENCY_DIAGNOSTICS)
+		new_frame = PIOS_RCVR_WaitForFrame(UPDATE_PERIOD_MS, &frame_time);
+#else
+		PIOS_RCVR_WaitForFrame(UPDATE_PERIOD_MS, NULL);
+#endif
 		PIOS_WDG_UpdateFlag(PIOS_WDG_MANUAL);
 	}
 }
@@ -226,6 +261,41 @@ static int32_t control_event_disarm()
 	return 0;
 }
 
+#if defined(RECEIVERLATENCY_DIAGNOSTICS)
+/**
+ * Complete the latency measurement of the last receiver frame on the
+ * first ActuatorDesired update after ManualControl has processed it.
+ * Runs from the high priority event lane so it adds little delay itself.
+ */
+static void actuator_desired_updated(UAVObjEvent * ev)
+{
+	static ReceiverLatencyData latency;
+	static portTickType last_publish;
+
+	if (!latency_pending)
+		return;
+	latency_pending = false;
+
+	uint32_t dT_us = PIOS_DELAY_DiffuS(latency_frame_time);
+
+	uint8_t bucket = 0;
+	while (bucket < RECEIVERLATENCY_HISTOGRAM_NUMELEM - 1 && dT_us >= (1000u << bucket))
+		bucket++;
+
+	latency.Histogram[bucket]++;
+	latency.Last = dT_us;
+	if (dT_us > latency.Max)
+		latency.Max = dT_us;
+	latency.Frames++;
+
+	portTickType now = xTaskGetTickCount();
+	if (now - last_publish >= MS2TICKS(LATENCY_PUBLISH_PERIOD_MS)) {
+		last_publish = now;
+		ReceiverLatencySet(&latency);
+	}
+}
+#endif /* RECEIVERLATENCY_DIAGNOSTICS */
+
 /**
  * @brief control_source_select Determine which sub-module to use
  * for the main control source of the flight controller.
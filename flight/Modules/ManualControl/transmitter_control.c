@@ -60,6 +60,8 @@
 //safe band to allow a bit of calibration error or trim offset (in microseconds)
 #define CONNECTION_OFFSET_THROTTLE 100
 #define CONNECTION_OFFSET          250
+//time the input has to stay valid or invalid before the connection status follows
+#define CONNECTION_HYSTERESIS_MS   200
 
 // Private types
 enum arm_state {
@@ -78,20 +80,31 @@ struct rcvr_activity_fsm {
 	uint8_t sample_count;
 };
 
+//! Per channel scaling derived from the calibration in ManualControlSettings
+struct channel_scaling {
+	int16_t neutral;
+	int8_t direction;	//!< sign of (max - min), selects which side of neutral uses scale_max
+	float scale_max;	//!< 1 / (max - neutral) or 0 if max == neutral
+	float scale_min;	//!< 1 / (neutral - min) or 0 if min == neutral
+};
+
 
 // Private variables
 static enum arm_state             arm_state;
 static FlightStatusData           flightStatus;
 static ManualControlCommandData   cmd;
 static ManualControlSettingsData  settings;
-static uint8_t                    disconnected_count = 0;
-static uint8_t                    connected_count = 0;
+static bool                       last_valid_input;
+static portTickType               valid_input_change_time;
 static struct rcvr_activity_fsm   activity_fsm;
 static portTickType               lastActivityTime;
 static portTickType               lastSysTime;
 static float                      flight_mode_value;
 static enum control_events        pending_control_event;
 static bool                       settings_updated;
+static struct channel_scaling     scaling[MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM];
+static float                      scaledChannel[MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM];
+static uint16_t                   scaledRaw[MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM];
 
 // Private functions
 static void update_actuator_desired(ManualControlCommandData * cmd);
@@ -101,7 +114,8 @@ static void update_path_desired(ManualControlCommandData * cmd, bool flightModeC
 static void set_flight_mode();
 static void process_transmitter_events(ManualControlCommandData * cmd, ManualControlSettingsData * settings, float * scaled);
 static void set_manual_control_error(SystemAlarmsManualControlOptions errorCode);
-static float scaleChannel(int16_t value, int16_t max, int16_t min, int16_t neutral);
+static void updateChannelScaling(ManualControlSettingsData * settings);
+static float scaleChannel(int16_t value, const struct channel_scaling * scale);
 static uint32_t timeDifferenceMs(portTickType start_time, portTickType end_time);
 static bool validInputRange(int16_t min, int16_t max, uint16_t value, uint16_t offset);
 static void applyDeadband(float *value, float deadband);
@@ -146,6 +160,7 @@ int32_t transmitter_control_initialize()
 
 	// Main task loop
 	lastSysTime = xTaskGetTickCount();
+	valid_input_change_time = lastSysTime;
 	return 0;
 }
 
@@ -161,11 +176,10 @@ int32_t transmitter_control_update()
 {
 	lastSysTime = xTaskGetTickCount();
 
-	float scaledChannel[MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM];
-
 	if (settings_updated) {
 		settings_updated = false;
 		ManualControlSettingsGet(&settings);
+		updateChannelScaling(&settings);
 	}
 
 	/* Update channel activity monitor */
@@ -241,8 +255,11 @@ int32_t transmitter_control_update()
 		// until we decide to go to failsafe
 		if(cmd.Channel[n] == (uint16_t) PIOS_RCVR_TIMEOUT)
 			valid_input_detected = false;
-		else
-			scaledChannel[n] = scaleChannel(cmd.Channel[n], settings.ChannelMax[n],	settings.ChannelMin[n], settings.ChannelNeutral[n]);
+		else if (cmd.Channel[n] != scaledRaw[n]) {
+			// Only rescale when the receiver delivered a different value
+			scaledChannel[n] = scaleChannel(cmd.Channel[n], &scaling[n]);
+			scaledRaw[n] = cmd.Channel[n];
+		}
 	}
 
 	// Check settings, if error raise alarm
@@ -292,16 +309,14 @@ int32_t transmitter_control_update()
 	     validInputRange(settings.ChannelMin[MANUALCONTROLSETTINGS_CHANNELGROUPS_PITCH], settings.ChannelMax[MANUALCONTROLSETTINGS_CHANNELGROUPS_PITCH], cmd.Channel[MANUALCONTROLSETTINGS_CHANNELGROUPS_PITCH], CONNECTION_OFFSET) &&
 	     flightmode_valid_input;
 
-	// Implement hysteresis loop on connection status
-	if (valid_input_detected && (++connected_count > 10)) {
-		cmd.Connected = MANUALCONTROLCOMMAND_CONNECTED_TRUE;
-		connected_count = 0;
-		disconnected_count = 0;
-	} else if (!valid_input_detected && (++disconnected_count > 10)) {
-		cmd.Connected = MANUALCONTROLCOMMAND_CONNECTED_FALSE;
-		connected_count = 0;
-		disconnected_count = 0;
+	// Implement hysteresis loop on connection status, in time so that it does
+	// not depend on how often the receiver sends frames
+	if (valid_input_detected != last_valid_input) {
+		last_valid_input = valid_input_detected;
+		valid_input_change_time = lastSysTime;
 	}
+	if (timeDifferenceMs(valid_input_change_time, lastSysTime) > CONNECTION_HYSTERESIS_MS)
+		cmd.Connected = valid_input_detected ? MANUALCONTROLCOMMAND_CONNECTED_TRUE : MANUALCONTROLCOMMAND_CONNECTED_FALSE;
 
 	if (cmd.Connected == MANUALCONTROLCOMMAND_CONNECTED_FALSE) {
 		// These values are not used but just put ManualControlCommand in a sane state.  When
@@ -968,28 +983,40 @@ static void altitude_hold_desired(ManualControlCommandData * cmd, bool flightMod
 
 #endif /* REVOLUTION */
 
+/**
+ * Precompute the channel scaling from the calibrated min, max and neutral
+ * values so that scaling a sample needs no division.
+ */
+static void updateChannelScaling(ManualControlSettingsData * settings)
+{
+	for (uint8_t n = 0; n < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM; n++) {
+		int16_t max = settings->ChannelMax[n];
+		int16_t min = settings->ChannelMin[n];
+		int16_t neutral = settings->ChannelNeutral[n];
+
+		scaling[n].neutral = neutral;
+		scaling[n].direction = (max > min) ? 1 : (min > max) ? -1 : 0;
+		scaling[n].scale_max = (max != neutral) ? 1.0f / (float)(max - neutral) : 0;
+		scaling[n].scale_min = (min != neutral) ? 1.0f / (float)(neutral - min) : 0;
+
+		// Force the next sample to be scaled again, timeouts are never scaled
+		scaledRaw[n] = (uint16_t) PIOS_RCVR_TIMEOUT;
+	}
+}
+
 /**
  * Convert channel from servo pulse duration (microseconds) to scaled -1/+1 range.
  */
-static float scaleChannel(int16_t value, int16_t max, int16_t min, int16_t neutral)
+static float scaleChannel(int16_t value, const struct channel_scaling * scale)
 {
+	int16_t diff = value - scale->neutral;
 	float valueScaled;
 
 	// Scale
-	if ((max > min && value >= neutral) || (min > max && value <= neutral))
-	{
-		if (max != neutral)
-			valueScaled = (float)(value - neutral) / (float)(max - neutral);
-		else
-			valueScaled = 0;
-	}
+	if ((scale->direction > 0 && diff >= 0) || (scale->direction < 0 && diff <= 0))
+		valueScaled = (float)diff * scale->scale_max;
 	else
-	{
-		if (min != neutral)
-			valueScaled = (float)(value - neutral) / (float)(neutral - min);
-		else
-			valueScaled = 0;
-	}
+		valueScaled = (float)diff * scale->scale_min;
 
 	// Bound
 	if (valueScaled >  1.0f) valueScaled =  1.0f;
@@ -1034,7 +1061,7 @@ static void applyDeadband(float *value, float deadband)
 			*value += deadband;
 }
 
-//! Update the manual control settings
+//! Flag the manual control settings for the control task to fetch and precompute the scaling
 static void manual_control_settings_updated(UAVObjEvent * ev)
 {
 	settings_updated = true;
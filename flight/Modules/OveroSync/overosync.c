@@ -34,15 +34,44 @@
 #include "overosyncstats.h"
 #include "systemstats.h"
 
+#include "accels.h"
+#include "baroaltitude.h"
+#include "gpsposition.h"
+#include "gpsvelocity.h"
+#include "gyros.h"
+#include "magnetometer.h"
+
 // Private constants
-#define MAX_QUEUE_SIZE   200
+#define SENSOR_QUEUE_SIZE    64
+#define STATE_QUEUE_SIZE     96
+#define SETTINGS_QUEUE_SIZE  16
 #define STACK_SIZE_BYTES 512
 #define TASK_PRIORITY (tskIDLE_PRIORITY + 0)
 
+//! Longest wait for new data, the credit is checked at least this often
+#define SERVICE_PERIOD_MS    2
+//! All settings are sent once per period, one object at a time
+#define SETTINGS_REFRESH_MS  30000
+//! Wait after boot before enabling the SPI to let the Overo start up
+#define STARTUP_DELAY_MS     5000
+
 // Private types
 
+//! Priority classes, a class is only sent when all higher ones are empty
+enum overosync_class {
+	OVEROSYNC_SENSORS = 0,
+	OVEROSYNC_STATE,
+	OVEROSYNC_SETTINGS,
+	OVEROSYNC_NUM_CLASSES
+};
+
 // Private variables
-static xQueueHandle queue;
+static const uint16_t queue_sizes[OVEROSYNC_NUM_CLASSES] = {
+	[OVEROSYNC_SENSORS] = SENSOR_QUEUE_SIZE,
+	[OVEROSYNC_STATE] = STATE_QUEUE_SIZE,
+	[OVEROSYNC_SETTINGS] = SETTINGS_QUEUE_SIZE,
+};
+static xQueueHandle queues[OVEROSYNC_NUM_CLASSES];
 static UAVTalkConnection uavTalkCon;
 static xTaskHandle overoSyncTaskHandle;
 static bool module_enabled;
@@ -50,8 +79,15 @@ static bool module_enabled;
 // Private functions
 static void    overoSyncTask(void *parameters);
 static int32_t pack_data(uint8_t * data, int32_t length);
+static uint8_t *reserve_data(uint16_t length);
+static int32_t commit_data(uint8_t * data, uint16_t length);
 static void    register_object(UAVObjHandle obj);
-static void    send_settings(UAVObjHandle obj);
+static void    count_settings(UAVObjHandle obj);
+static void    find_settings(UAVObjHandle obj);
+static void    refresh_settings(portTickType now);
+static bool    service_class(enum overosync_class class);
+static void    flush_batch(void);
+static void    update_stats(portTickType now);
 
 // External variables
 extern uint32_t pios_com_overo_id;
@@ -62,7 +98,35 @@ struct overosync {
 	uint32_t sent_objects;
 	uint32_t failed_objects;
 	uint32_t received_objects;
-	bool     sending_settings;
+
+	// Flow control: every SPI transaction clocks out the whole COM fifo,
+	// so each new packet grants a full packet of credit, as far as the
+	// fifo has room for it
+	int32_t  last_packets;
+	uint16_t credit;
+
+	// Packets are built in place in the COM fifo and committed at once,
+	// or collected here when the free space in the fifo wraps
+	uint8_t  batch[PIOS_OVERO_PACKET_SIZE];
+	uint8_t  *batch_ptr;
+	uint16_t batch_len;
+	uint16_t batch_objects;
+	bool     deferred;
+
+	// Settings refresh cursor
+	uint16_t num_settings;
+	uint16_t settings_index;
+	uint16_t settings_search;
+	UAVObjHandle settings_found;
+	portTickType next_settings_time;
+	bool     settings_burst;
+
+	// Statistics for the current period
+	uint32_t class_sent[OVEROSYNC_NUM_CLASSES];
+	uint32_t class_full[OVEROSYNC_NUM_CLASSES];
+	uint16_t class_latency[OVEROSYNC_NUM_CLASSES];
+	portTickType pending_since[OVEROSYNC_NUM_CLASSES];
+	bool     pending[OVEROSYNC_NUM_CLASSES];
 };
 
 struct overosync *overosync;
@@ -90,12 +154,14 @@ int32_t OveroSyncInitialize(void)
 		return -1;
 
 	// Create object queues
-	queue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
+	for (uint8_t i = 0; i < OVEROSYNC_NUM_CLASSES; i++)
+		queues[i] = xQueueCreate(queue_sizes[i], sizeof(UAVObjEvent));
 	
 	OveroSyncStatsInitialize();
 
 	// Initialise UAVTalk
 	uavTalkCon = UAVTalkInitialize(&pack_data);
+	UAVTalkSetOutputBuffer(uavTalkCon, &reserve_data, &commit_data);
 
 	return 0;
 }
@@ -116,10 +182,11 @@ int32_t OveroSyncStart(void)
 	if(overosync == NULL)
 		return -1;
 
-	overosync->sent_bytes = 0;
+	memset(overosync, 0, sizeof(*overosync));
 
 	// Process all registered objects and connect queue for updates
 	UAVObjIterate(&register_object);
+	UAVObjIterate(&count_settings);
 	
 	// Start telemetry tasks
 	xTaskCreate(overoSyncTask, (signed char *)"OveroSync", STACK_SIZE_BYTES/4, NULL, TASK_PRIORITY, &overoSyncTaskHandle);
@@ -132,108 +199,255 @@ int32_t OveroSyncStart(void)
 MODULE_INITCALL(OveroSyncInitialize, OveroSyncStart)
 ;
 /**
- * Register a new object, adds object to local list and connects the queue depending on the object's
- * telemetry settings.
+ * Register a new object, connects it to the queue of its priority class.
+ * Settings are only sent when they change and by the background refresh.
  * \param[in] obj Object to connect
  */
 static void register_object(UAVObjHandle obj)
 {
 	int32_t eventMask;
 	eventMask = EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ | EV_UNPACKED;
-	UAVObjConnectQueue(obj, queue, eventMask);
+
+	enum overosync_class class = OVEROSYNC_STATE;
+	if (UAVObjIsSettings(obj) || UAVObjIsMetaobject(obj))
+		class = OVEROSYNC_SETTINGS;
+	else if (obj == GyrosHandle() || obj == AccelsHandle() ||
+	         obj == MagnetometerHandle() || obj == BaroAltitudeHandle() ||
+	         obj == GPSPositionHandle() || obj == GPSVelocityHandle())
+		class = OVEROSYNC_SENSORS;
+
+	UAVObjConnectQueue(obj, queues[class], eventMask);
+}
+
+static void count_settings(UAVObjHandle obj)
+{
+	if (UAVObjIsSettings(obj))
+		overosync->num_settings++;
+}
+
+static void find_settings(UAVObjHandle obj)
+{
+	if (UAVObjIsSettings(obj)) {
+		if (overosync->settings_search == overosync->settings_index)
+			overosync->settings_found = obj;
+		overosync->settings_search++;
+	}
 }
 
 /**
- * Register a new object, adds object to local list and connects the queue depending on the object's
- * telemetry settings.
- * \param[in] obj Object to connect
+ * Queue the next settings object of the refresh cycle when it is due. A
+ * burst (after connecting) sends them as fast as the spare credit allows,
+ * otherwise they are spread evenly over SETTINGS_REFRESH_MS.
  */
-static void send_settings(UAVObjHandle obj)
+static void refresh_settings(portTickType now)
 {
-	if (UAVObjIsSettings(obj)) {
-		UAVTalkSendObjectTimestamped(uavTalkCon, obj, 0, false, 0);
+	if (overosync->num_settings == 0)
+		return;
+	if (!overosync->settings_burst &&
+	    (int32_t) (now - overosync->next_settings_time) < 0)
+		return;
+	if (uxQueueMessagesWaiting(queues[OVEROSYNC_SETTINGS]) > 0)
+		return;
+
+	overosync->settings_search = 0;
+	overosync->settings_found = NULL;
+	UAVObjIterate(&find_settings);
+
+	if (overosync->settings_found) {
+		UAVObjEvent ev = {
+			.obj = overosync->settings_found,
+			.instId = UAVOBJ_ALL_INSTANCES,
+			.event = EV_UPDATED_MANUAL,
+		};
+		xQueueSend(queues[OVEROSYNC_SETTINGS], &ev, 0);
+	}
+
+	if (++overosync->settings_index >= overosync->num_settings) {
+		overosync->settings_index = 0;
+		overosync->settings_burst = false;
 	}
+	overosync->next_settings_time = now + MS2TICKS(SETTINGS_REFRESH_MS) / overosync->num_settings;
+}
+
+/**
+ * Send the queued events of a class as long as the credit lasts. Events
+ * that do not fit stay queued until the Overo reads the next packet.
+ * \return false when out of credit
+ */
+static bool service_class(enum overosync_class class)
+{
+	UAVObjEvent ev;
+	portTickType now = xTaskGetTickCount();
+
+	// Updates were lost since the last round
+	if (uxQueueMessagesWaiting(queues[class]) >= queue_sizes[class])
+		overosync->class_full[class]++;
+
+	while (xQueuePeek(queues[class], &ev, 0) == pdTRUE) {
+		if (!overosync->pending[class]) {
+			overosync->pending[class] = true;
+			overosync->pending_since[class] = now;
+		}
+
+		overosync->deferred = false;
+		UAVTalkSendObjectTimestamped(uavTalkCon, ev.obj, ev.instId, false, 0);
+		if (overosync->deferred)
+			return false;
+
+		xQueueReceive(queues[class], &ev, 0);
+		overosync->class_sent[class]++;
+	}
+
+	if (overosync->pending[class]) {
+		uint16_t latency = (now - overosync->pending_since[class]) * portTICK_RATE_MS;
+		if (latency > overosync->class_latency[class])
+			overosync->class_latency[class] = latency;
+		overosync->pending[class] = false;
+	}
+
+	return true;
+}
+
+/**
+ * Write the collected packets to the COM fifo
+ */
+static void flush_batch(void)
+{
+	if (overosync->batch_len == 0)
+		return;
+
+	int32_t rc;
+	if (overosync->batch_ptr == overosync->batch)
+		rc = PIOS_COM_SendBufferNonBlocking(pios_com_overo_id, overosync->batch, overosync->batch_len);
+	else
+		rc = PIOS_COM_SendCommit(pios_com_overo_id, overosync->batch_len);
+
+	if (rc < 0) {
+		overosync->failed_objects += overosync->batch_objects;
+	} else {
+		overosync->sent_bytes += overosync->batch_len;
+		overosync->sent_objects += overosync->batch_objects;
+	}
+
+	if (overosync->credit > overosync->batch_len)
+		overosync->credit -= overosync->batch_len;
+	else
+		overosync->credit = 0;
+
+	overosync->batch_ptr = NULL;
+	overosync->batch_len = 0;
+	overosync->batch_objects = 0;
 }
 
 /**
  * Telemetry transmit task, regular priority
  *
- * Logic: We need to double buffer the DMA transfers.  Pack the buffer until either
- * 1) it is full (and then we should record the number of missed events then)
- * 2) the current transaction is done (we should immediately schedule since we are slave)
- * when done packing the buffer we should call PIOS_SPI_TransferBlock, change the active buffer
- * and then take the semaphrore
+ * Logic: The Overo is the SPI master and reads one packet of
+ * PIOS_OVERO_PACKET_SIZE bytes at a time, which drains the COM fifo. Each
+ * new packet therefore refills the credit. Events are sent by priority
+ * class (sensors, then state, then settings) and packed into one batch
+ * per packet. Anything that does not fit waits in its queue, the
+ * queues only overflow when the Overo stops reading.
  */
 static void overoSyncTask(void *parameters)
 {
 	UAVObjEvent ev;
 
-	// Kick off SPI transfers (once one is completed another will automatically transmit)
-	overosync->sent_objects = 0;
-	overosync->failed_objects = 0;
-	overosync->received_objects = 0;
-	
 	portTickType lastUpdateTime = xTaskGetTickCount();
-	portTickType updateTime;
-
 	bool initialized = false;
-	uint8_t last_connected = OVEROSYNCSTATS_CONNECTED_FALSE;
 
 	// Loop forever
 	while (1) {
-		// Wait for queue message
-		if (xQueueReceive(queue, &ev, portMAX_DELAY) == pdTRUE) {
+		// Wait for sensor data or the next credit check
+		xQueuePeek(queues[OVEROSYNC_SENSORS], &ev, MS2TICKS(SERVICE_PERIOD_MS));
 
-			// For the first seconds do not send updates to allow the
-			// overo to boot.  Then enable it and act normally.
-			if (!initialized && xTaskGetTickCount() < 5000) {
+		portTickType now = xTaskGetTickCount();
+
+		// For the first seconds do not send updates to allow the
+		// overo to boot.  Then enable it and act normally.
+		if (!initialized) {
+			if (now < MS2TICKS(STARTUP_DELAY_MS)) {
+				for (uint8_t i = 0; i < OVEROSYNC_NUM_CLASSES; i++)
+					while (xQueueReceive(queues[i], &ev, 0) == pdTRUE);
 				continue;
-			} else if (!initialized) {
-				initialized = true;
-				PIOS_OVERO_Enable(pios_overo_id);
 			}
+			initialized = true;
+			overosync->last_packets = PIOS_OVERO_GetPacketCount(pios_overo_id);
+			overosync->credit = PIOS_OVERO_PACKET_SIZE;
+			PIOS_OVERO_Enable(pios_overo_id);
+		}
 
-			// Process event.  This calls transmitData
-			UAVTalkSendObjectTimestamped(uavTalkCon, ev.obj, ev.instId, false, 0);
-			
-			updateTime = xTaskGetTickCount();
-			if(((portTickType) (updateTime - lastUpdateTime)) > 1000) {
-				// Update stats.  This will trigger a local send event too
-				OveroSyncStatsData syncStats;
-				syncStats.Send = overosync->sent_bytes;
-				syncStats.Connected = syncStats.Send > 500 ? OVEROSYNCSTATS_CONNECTED_TRUE : OVEROSYNCSTATS_CONNECTED_FALSE;
-				syncStats.DroppedUpdates = overosync->failed_objects;
-				syncStats.Packets = PIOS_OVERO_GetPacketCount(pios_overo_id);
-				OveroSyncStatsSet(&syncStats);
-				overosync->failed_objects = 0;
-				overosync->sent_bytes = 0;
-				lastUpdateTime = updateTime;
-
-				// When first connected, send all the settings.  Right now this
-				// will fail since all the settings will overfill the buffer and
-				if (last_connected == OVEROSYNCSTATS_CONNECTED_FALSE &&
-					syncStats.Connected == OVEROSYNCSTATS_CONNECTED_TRUE) {
-					UAVObjIterate(&send_settings);
-				}
-
-				// Because the previous code only happens on connection and the
-				// remote logging program doesn't send the settings to the log
-				// when arming starts we send all settings every thirty seconds
-				static uint32_t second_count = 0;
-				if (second_count ++ > 30) {
-					UAVObjIterate(&send_settings);
-					second_count = 0;
-				}
-				last_connected = syncStats.Connected;
-			}
+		int32_t packets = PIOS_OVERO_GetPacketCount(pios_overo_id);
+		if (packets != overosync->last_packets) {
+			overosync->last_packets = packets;
+			overosync->credit = PIOS_OVERO_PACKET_SIZE;
+		}
+
+		// The fifo holds one byte less than a packet and may not be
+		// drained yet. A batch that does not fit would be lost, the
+		// events are already off their queues by then.
+		uint16_t room = PIOS_COM_GetTxFree(pios_com_overo_id);
+		if (overosync->credit > room)
+			overosync->credit = room;
+
+		refresh_settings(now);
 
-			// TODO: Check the receive buffer
+		bool credit_left = true;
+		for (uint8_t i = 0; i < OVEROSYNC_NUM_CLASSES && credit_left; i++)
+			credit_left = service_class(i);
+		flush_batch();
+
+		// Nothing more fits until the Overo reads the next packet
+		if (!credit_left)
+			vTaskDelay(1);
+
+		if ((portTickType) (now - lastUpdateTime) > MS2TICKS(1000)) {
+			update_stats(now);
+			lastUpdateTime = now;
 		}
+
+		// TODO: Check the receive buffer
 	}
 }
 
 /**
- * Transmit data buffer to the modem or USB port.
+ * Publish the statistics of the last period and restart them
+ */
+static void update_stats(portTickType now)
+{
+	OveroSyncStatsData syncStats;
+	OveroSyncStatsGet(&syncStats);
+
+	uint8_t last_connected = syncStats.Connected;
+
+	syncStats.Send = overosync->sent_bytes;
+	syncStats.Connected = syncStats.Send > 500 ? OVEROSYNCSTATS_CONNECTED_TRUE : OVEROSYNCSTATS_CONNECTED_FALSE;
+	syncStats.DroppedUpdates = overosync->failed_objects;
+	syncStats.Packets = PIOS_OVERO_GetPacketCount(pios_overo_id);
+	for (uint8_t i = 0; i < OVEROSYNC_NUM_CLASSES; i++) {
+		syncStats.SentUpdates[i] = overosync->class_sent[i];
+		syncStats.QueueFull[i] = overosync->class_full[i];
+		syncStats.MaxLatency[i] = overosync->class_latency[i];
+		overosync->class_sent[i] = 0;
+		overosync->class_full[i] = 0;
+		overosync->class_latency[i] = 0;
+	}
+	OveroSyncStatsSet(&syncStats);
+
+	overosync->failed_objects = 0;
+	overosync->sent_bytes = 0;
+
+	// When first connected send all the settings as fast as the spare
+	// credit allows, the refresh then keeps the log complete
+	if (last_connected == OVEROSYNCSTATS_CONNECTED_FALSE &&
+		syncStats.Connected == OVEROSYNCSTATS_CONNECTED_TRUE) {
+		overosync->settings_index = 0;
+		overosync->settings_burst = true;
+	}
+}
+
+/**
+ * Collect a packet into the batch for the current SPI packet.
  * \param[in] data Data buffer to send
  * \param[in] length Length of buffer
  * \return -1 on failure
@@ -241,18 +455,72 @@ static void overoSyncTask(void *parameters)
  */
 static int32_t pack_data(uint8_t * data, int32_t length)
 {
-	if( PIOS_COM_SendBufferNonBlocking(pios_com_overo_id, data, length) < 0)
+	if (length > PIOS_OVERO_PACKET_SIZE)
 		goto fail;
 
-	overosync->sent_bytes += length;
+	// Out of credit, keep the event queued
+	if (overosync->batch_len + length > overosync->credit) {
+		overosync->deferred = true;
+		return -1;
+	}
 
-	return length;
+	uint8_t *dest = reserve_data(length);
+	if (dest == NULL)
+		return -1;
+
+	memcpy(dest, data, length);
+
+	return commit_data(dest, length);
 
 fail:
 	overosync->failed_objects++;
 	return -1;
 }
 
+/**
+ * Get room for the next packet of the batch. The batch is kept in the COM
+ * fifo while the free space there is contiguous, nothing else writes to
+ * the overo port so it stays put until flush_batch() commits it.
+ * \param[in] length Length of the packet
+ * \return NULL when out of credit, the event then stays queued
+ */
+static uint8_t *reserve_data(uint16_t length)
+{
+	if (overosync->batch_len + length > overosync->credit) {
+		overosync->deferred = true;
+		return NULL;
+	}
+
+	if (overosync->batch_ptr != overosync->batch) {
+		uint8_t *ptr = PIOS_COM_SendReserve(pios_com_overo_id, overosync->batch_len + length);
+		if (ptr != NULL) {
+			overosync->batch_ptr = ptr;
+			return ptr + overosync->batch_len;
+		}
+
+		// Continue the batch in the local buffer
+		if (overosync->batch_ptr != NULL)
+			memcpy(overosync->batch, overosync->batch_ptr, overosync->batch_len);
+		overosync->batch_ptr = overosync->batch;
+	}
+
+	return &overosync->batch[overosync->batch_len];
+}
+
+/**
+ * Add a packet built by reserve_data to the batch
+ * \param[in] data The reserved room
+ * \param[in] length Length of the packet
+ * \return number of bytes added
+ */
+static int32_t commit_data(uint8_t * data, uint16_t length)
+{
+	overosync->batch_len += length;
+	overosync->batch_objects++;
+
+	return length;
+}
+
 /**
   * @}
   * @}
@@ -53,6 +53,7 @@ FILE * fid;
 static void overoSyncTask(void *parameters);
 static int32_t packData(uint8_t * data, int32_t length);
 static void registerObject(UAVObjHandle obj);
+static void logObject(UAVObjHandle obj);
 
 struct dma_transaction {
 	uint8_t tx_buffer[OVEROSYNC_PACKET_SIZE] __attribute__ ((aligned(4)));
@@ -140,13 +141,23 @@ MODULE_INITCALL(OveroSyncInitialize, OveroSyncStart)
 static void registerObject(UAVObjHandle obj)
 {
 	int32_t eventMask;
-	eventMask = EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
-	if (UAVObjIsMetaobject(obj)) {
-		eventMask |= EV_UNPACKED;	// we also need to act on remote updates (unpack events)
-	}
+	// Remote updates are logged too, a replay needs the settings and
+	// commands the GCS sent during the flight
+	eventMask = EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ | EV_UNPACKED;
 	UAVObjConnectQueue(obj, queue, eventMask);
 }
 
+/**
+ * Write all instances of an object to the log, so that a replay starts
+ * from the state the objects had when the log was opened
+ * \param[in] obj Object to log
+ */
+static void logObject(UAVObjHandle obj)
+{
+	for (uint16_t instId = 0; instId < UAVObjGetNumInstances(obj); instId++)
+		UAVTalkSendObject(uavTalkCon, obj, instId, false, 0);
+}
+
 /**
  * Telemetry transmit task, regular priority
  *
@@ -170,6 +181,7 @@ static void overoSyncTask(void *parameters)
 	portTickType updateTime;
 	
 	fid = fopen("sim_log.opl", "w");
+	UAVObjIterate(&logObject);
 
 	// Loop forever
 	while (1) {
@@ -214,9 +226,11 @@ static int32_t packData(uint8_t * data, int32_t length)
 	// Get the lock for manipulating the buffer
 	xSemaphoreTake(overosync->buffer_lock, portMAX_DELAY);
 
-	portTickType tickTime = xTaskGetTickCount();
-	uint64_t packetSize = data[2] + (data[3] << 8);
-	fwrite((void *) &tickTime, 1, sizeof(tickTime), fid);
+	// Same record layout as the GCS logfile (.tll): a 32 bit timestamp in
+	// ms, a 64 bit length and then the complete packet including the CRC
+	uint32_t timestamp = TICKS2MS(xTaskGetTickCount());
+	uint64_t packetSize = length;
+	fwrite((void *) &timestamp, 1, sizeof(timestamp), fid);
 	fwrite((void *) &packetSize, sizeof(packetSize), 1, fid);
 	fwrite((void *) data, 1, length, fid);
 	overosync->sent_bytes += length;
@@ -202,6 +202,7 @@ static void PathFollowerTask(void *parameters)
 		FixedWingPathFollowerSettingsCCGet(&fixedwingpathfollowerSettings);
 
 		vTaskDelayUntil(&lastUpdateTime, MS2TICKS(fixedwingpathfollowerSettings.UpdatePeriod));
+		TaskMonitorLoopBegin(TASKINFO_RUNNING_PATHFOLLOWER);
 
 		if (flightStatusUpdate)
 			FlightStatusFlightModeGet(&flightMode);
@@ -233,6 +234,8 @@ static void PathFollowerTask(void *parameters)
 			AlarmsSet(SYSTEMALARMS_ALARM_PATHFOLLOWER, SYSTEMALARMS_ALARM_CRITICAL);
 			break;
 		}
+
+		TaskMonitorLoopEnd(TASKINFO_RUNNING_PATHFOLLOWER);
 	}
 }
 
@@ -0,0 +1,727 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup Sensors Sensor acquisition module
+ * @{
+ *
+ * @file       sensors.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @brief      Replay the sensors of a recorded log through the flight code
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ ******************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * Reads a log in the GCS logfile format (.tll, also written by the simulated
+ * OveroSync module) and replaces the sensor module of the posix build:
+ *
+ *  - sensor objects, pilot commands and all settings found in the log are
+ *    unpacked into the local objects, so the real Attitude, Stabilization,
+ *    Actuator and path follower modules run on the recorded flight;
+ *  - the delay timer follows the log timestamps, so every loop sees the
+ *    recorded time steps however fast the host runs;
+ *  - each logged output object is compared against the value computed
+ *    locally at that point of the log, and a summary of the differences is
+ *    printed when the log ends.
+ *
+ * The log is taken from REPLAY_LOG (default sim_log.opl). By default the
+ * log is replayed as fast as possible: each gyro and accel sample pair is
+ * injected once the records logged with it are, then the replay waits for
+ * Stabilization to answer with a new ActuatorDesired and for Attitude to
+ * answer with a new AttitudeActual before it compares the outputs of that
+ * step. Until both have answered in the log the modules are still starting,
+ * so that part is replayed at the original timestamps. The records of the
+ * first timestamp are the state of the objects when the log was opened,
+ * they are loaded instead of compared. Setting
+ * REPLAY_REALTIME=1 replays at the original timestamps instead. When
+ * REPLAY_CHECK=1 is set the process exits with an error if more than
+ * REPLAY_MAX_OVER_PERCENT of the samples of any compared field differ by
+ * more than its tolerance. A pilot command or setting logged in the same ms
+ * as a sensor sample can be replayed on the other side of it, which moves
+ * a step of an output by one sample, so single samples may be over.
+ */
+
+#include "pios.h"
+#include "openpilot.h"
+#include "uavtalk_priv.h"
+
+#include "accels.h"
+#include "accessorydesired.h"
+#include "actuatorcommand.h"
+#include "actuatordesired.h"
+#include "airspeedactual.h"
+#include "attitudeactual.h"
+#include "baroairspeed.h"
+#include "baroaltitude.h"
+#include "flightstatus.h"
+#include "gpsposition.h"
+#include "gpsvelocity.h"
+#include "gyros.h"
+#include "gyrosbias.h"
+#include "magbias.h"
+#include "magnetometer.h"
+#include "manualcontrolcommand.h"
+#include "manualcontrolsettings.h"
+#include "pathdesired.h"
+#include "positionactual.h"
+#include "ratedesired.h"
+#include "stabilizationdesired.h"
+#include "velocityactual.h"
+#include "velocitydesired.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Private constants
+#define STACK_SIZE_BYTES 1540
+// Below Attitude and Stabilization, so they run as soon as a sample is injected
+#define TASK_PRIORITY (tskIDLE_PRIORITY+2)
+
+#define REPLAY_DEFAULT_LOG "sim_log.opl"
+#define REPLAY_MAX_RECORD_SIZE (1024 * 1024)
+#define REPLAY_READ_CHUNK 256
+#define REPLAY_MAX_VALUES 10
+//! How long to wait for the control loop to answer a sensor sample
+#define REPLAY_STEP_TIMEOUT_MS 5
+//! How long to wait for a module to start answering sensor samples
+#define REPLAY_START_TIMEOUT_MS 500
+//! Share of the samples of a field that may exceed its tolerance
+#define REPLAY_MAX_OVER_PERCENT 5
+
+#define ACTUATORDESIRED_UPDATED 0x01
+#define ATTITUDEACTUAL_UPDATED  0x02
+#define ALL_STEPS               (ACTUATORDESIRED_UPDATED | ATTITUDEACTUAL_UPDATED)
+#define REPLAY_MAX_SAMPLES      2	//!< one per object returned by stepBits
+#define REPLAY_MAX_ANSWERS      8
+
+// Private types
+enum replay_value_type {REPLAY_FLOAT, REPLAY_INT16};
+
+//! An output object that is compared against the log
+struct replay_output {
+	const char *name;
+	UAVObjHandle (*handle)(void);
+	enum replay_value_type type;
+	uint8_t num_values;	//!< leading fields of the object that are compared
+	float tolerance;	//!< max error of every field, in the unit of the object
+	uint32_t step;		//!< notifier bit when this object answers a sensor sample
+	uint32_t samples;
+	uint32_t over[REPLAY_MAX_VALUES];	//!< samples above the tolerance
+	float max_error[REPLAY_MAX_VALUES];
+	double sum_sq_error[REPLAY_MAX_VALUES];
+};
+
+//! Incremental UAVTalk frame parser, records may split or merge packets
+struct replay_parser {
+	uint8_t buffer[UAVTALK_MAX_PACKET_LENGTH];
+	uint16_t length;
+	uint16_t packet_size;
+};
+
+//! A record held back until its batch of sensor samples is complete
+struct replay_record {
+	UAVObjHandle obj;
+	uint16_t instId;
+	uint8_t data[UAVOBJECTS_LARGEST];
+};
+
+//! The gyro and accel samples the sensors publish together, and the outputs
+//! logged in between
+struct replay_batch {
+	struct replay_record samples[REPLAY_MAX_SAMPLES];
+	struct replay_record answers[REPLAY_MAX_ANSWERS];
+	uint8_t num_samples;
+	uint8_t num_answers;
+	uint32_t steps;
+};
+
+struct replay_stats {
+	uint32_t records;
+	uint32_t packets;
+	uint32_t bad_packets;
+	uint32_t unknown_objects;
+	uint32_t injected;
+	uint32_t compared;
+	uint32_t step_timeouts;
+};
+
+// Private variables
+static xTaskHandle sensorsTaskHandle;
+static UAVObjNotifier notifier;
+static struct replay_parser parser;
+static struct replay_stats stats;
+static uint8_t local_data[UAVOBJECTS_LARGEST];
+static bool realtime;
+static bool snapshot;
+static uint32_t pending_step;
+static uint32_t started_steps;
+static struct replay_batch batch;
+
+/*
+ * The log has ms timestamps while the recorded loops measured their time
+ * steps in us, so the replayed attitude drifts by a few degrees over a
+ * flight, and the outputs that depend on it by as much as the gains make
+ * of that. Estimates that are copied from the sensors must match exactly.
+ * Of the attitude only the quaternion is compared, the Euler angles taken
+ * from it swap roll for yaw close to a pitch of 90 degrees.
+ */
+static struct replay_output outputs[] = {
+	{ .name = "AttitudeActual", .handle = AttitudeActualHandle, .type = REPLAY_FLOAT, .num_values = 4, .tolerance = 0.1f, .step = ATTITUDEACTUAL_UPDATED },
+	{ .name = "RateDesired", .handle = RateDesiredHandle, .type = REPLAY_FLOAT, .num_values = 3, .tolerance = 30 },
+	{ .name = "ActuatorDesired", .handle = ActuatorDesiredHandle, .type = REPLAY_FLOAT, .num_values = 4, .tolerance = 0.06f, .step = ACTUATORDESIRED_UPDATED },
+	{ .name = "ActuatorCommand", .handle = ActuatorCommandHandle, .type = REPLAY_INT16, .num_values = ACTUATORCOMMAND_CHANNEL_NUMELEM, .tolerance = 40 },
+	{ .name = "PositionActual", .handle = PositionActualHandle, .type = REPLAY_FLOAT, .num_values = 3, .tolerance = 0 },
+	{ .name = "VelocityActual", .handle = VelocityActualHandle, .type = REPLAY_FLOAT, .num_values = 3, .tolerance = 0 },
+	{ .name = "VelocityDesired", .handle = VelocityDesiredHandle, .type = REPLAY_FLOAT, .num_values = 3, .tolerance = 0.1f },
+};
+
+//! Data objects taken from the log, settings are always taken from the log
+static UAVObjHandle (* const inputs[])(void) = {
+	AccelsHandle,
+	AccessoryDesiredHandle,
+	AirspeedActualHandle,
+	BaroAirspeedHandle,
+	BaroAltitudeHandle,
+	FlightStatusHandle,
+	GPSPositionHandle,
+	GPSVelocityHandle,
+	GyrosHandle,
+	MagnetometerHandle,
+	ManualControlCommandHandle,
+	PathDesiredHandle,
+	StabilizationDesiredHandle,
+};
+
+// Private functions
+static void SensorsTask(void *parameters);
+static int32_t skipHeader(FILE *log);
+static void processRecord(FILE *log, uint64_t size);
+static void parseByte(uint8_t b);
+static void processPacket(const uint8_t *packet, uint16_t packet_size);
+static bool isInput(UAVObjHandle obj);
+static struct replay_output *findOutput(UAVObjHandle obj);
+static void compareOutput(struct replay_output *output, uint16_t instId, const uint8_t *logged);
+static uint32_t stepBits(UAVObjHandle obj);
+static void holdRecord(struct replay_record *record, UAVObjHandle obj, uint16_t instId, const uint8_t *data);
+static void injectBatch();
+static void checkOutput(struct replay_output *output, uint16_t instId, const uint8_t *logged);
+static void finishStep();
+static int printReport(bool check);
+
+/**
+ * Initialise the module.  Called before the start function
+ * \returns 0 on success or -1 if initialisation failed
+ */
+int32_t SensorsInitialize(void)
+{
+	AccelsInitialize();
+	AirspeedActualInitialize();
+	BaroAltitudeInitialize();
+	BaroAirspeedInitialize();
+	GyrosInitialize();
+	GyrosBiasInitialize();
+	GPSPositionInitialize();
+	GPSVelocityInitialize();
+	MagnetometerInitialize();
+	MagBiasInitialize();
+
+	// ManualControl is not linked in, the pilot commands come from the log
+	AccessoryDesiredInitialize();
+	ManualControlCommandInitialize();
+	ManualControlSettingsInitialize();
+	FlightStatusInitialize();
+	StabilizationDesiredInitialize();
+	AccessoryDesiredCreateInstance();
+	AccessoryDesiredCreateInstance();
+
+	notifier = UAVObjNotifierCreate();
+	if (notifier == NULL)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Start the task.  Expects all objects to be initialized by this point.
+ * \returns 0 on success or -1 if initialisation failed
+ */
+int32_t SensorsStart(void)
+{
+	// Owned by Stabilization and Attitude, only known to be initialized at this point
+	if (ActuatorDesiredConnectNotifier(notifier, ACTUATORDESIRED_UPDATED) != 0 ||
+	    AttitudeActualConnectNotifier(notifier, ATTITUDEACTUAL_UPDATED) != 0)
+		return -1;
+
+	// Start main task
+	xTaskCreate(SensorsTask, (signed char *)"Sensors", STACK_SIZE_BYTES/4, NULL, TASK_PRIORITY, &sensorsTaskHandle);
+	TaskMonitorAdd(TASKINFO_RUNNING_SENSORS, sensorsTaskHandle);
+	PIOS_WDG_RegisterFlag(PIOS_WDG_SENSORS);
+
+	return 0;
+}
+
+MODULE_INITCALL(SensorsInitialize, SensorsStart)
+
+/**
+ * Replay task. Feeds the log record by record and exits the process with
+ * the result of the comparison when the log ends.
+ */
+static void SensorsTask(void *parameters)
+{
+	const char *log_name = getenv("REPLAY_LOG");
+	if (log_name == NULL)
+		log_name = REPLAY_DEFAULT_LOG;
+
+	const char *env = getenv("REPLAY_REALTIME");
+	realtime = (env != NULL && atoi(env) != 0);
+
+	env = getenv("REPLAY_CHECK");
+	bool check = (env != NULL && atoi(env) != 0);
+
+	FILE *log = fopen(log_name, "rb");
+	if (log == NULL || skipHeader(log) != 0) {
+		fprintf(stderr, "Replay: unable to read log %s\n", log_name);
+		exit(1);
+	}
+
+	printf("Replay: %s %s\n", log_name, realtime ? "at the original timestamps" : "as fast as possible");
+
+	AlarmsClear(SYSTEMALARMS_ALARM_SENSORS);
+
+	bool first = true;
+	uint32_t first_timestamp = 0;
+	uint32_t time_us = 0;
+	portTickType start_time = xTaskGetTickCount();
+
+	while (1) {
+		PIOS_WDG_UpdateFlag(PIOS_WDG_SENSORS);
+
+		uint32_t timestamp;
+		uint64_t size;
+		if (fread(&timestamp, sizeof(timestamp), 1, log) != 1 ||
+		    fread(&size, sizeof(size), 1, log) != 1)
+			break;
+
+		if (size < 1 || size > REPLAY_MAX_RECORD_SIZE) {
+			fprintf(stderr, "Replay: corrupted record of %llu bytes at %u ms\n",
+				(unsigned long long) size, timestamp);
+			break;
+		}
+
+		if (first) {
+			first_timestamp = timestamp;
+			first = false;
+		}
+		// The outputs loaded from the snapshot are no answers of the loops
+		if (snapshot && timestamp != first_timestamp)
+			UAVObjNotifierWait(notifier, ALL_STEPS, 0);
+		snapshot = (timestamp == first_timestamp);
+
+		// Until every loop has answered in the log the modules are still
+		// starting, that has to take as long as it did when recording
+		if (realtime || started_steps != ALL_STEPS) {
+			portTickType due = start_time + MS2TICKS(timestamp - first_timestamp);
+			portTickType now = xTaskGetTickCount();
+			if ((int32_t) (due - now) > 0)
+				vTaskDelay(due - now);
+		}
+
+		// The log only has ms resolution, keep the clock moving so that
+		// two samples of the same ms do not give a zero time step
+		if ((int32_t) (timestamp * 1000 - time_us) > 0)
+			time_us = timestamp * 1000;
+		else
+			time_us++;
+		PIOS_DELAY_SetuS(time_us);
+		processRecord(log, size);
+		stats.records++;
+	}
+
+	fclose(log);
+
+	injectBatch();
+	finishStep();
+
+	exit(printReport(check));
+}
+
+/**
+ * Skip the text header written by the GCS, if there is one
+ * \returns 0 on success or -1 if the header is not terminated
+ */
+static int32_t skipHeader(FILE *log)
+{
+	static const char magic[] = "Tau Labs git hash:";
+	char line[128];
+
+	if (fgets(line, sizeof(line), log) == NULL)
+		return -1;
+
+	if (strncmp(line, magic, strlen(magic)) != 0) {
+		// Raw records, as written by the simulated OveroSync
+		rewind(log);
+		return 0;
+	}
+
+	for (int i = 0; i < 10; i++) {
+		if (fgets(line, sizeof(line), log) == NULL)
+			return -1;
+		if (strcmp(line, "##\n") == 0)
+			return 0;
+	}
+
+	return -1;
+}
+
+/**
+ * Feed the bytes of one log record to the UAVTalk parser
+ */
+static void processRecord(FILE *log, uint64_t size)
+{
+	uint8_t chunk[REPLAY_READ_CHUNK];
+
+	while (size > 0) {
+		size_t len = (size > sizeof(chunk)) ? sizeof(chunk) : size;
+		if (fread(chunk, 1, len, log) != len)
+			return;
+		size -= len;
+
+		for (size_t i = 0; i < len; i++)
+			parseByte(chunk[i]);
+	}
+}
+
+/**
+ * Collect the bytes of a UAVTalk packet and hand it on once it is complete
+ * and its CRC matches. On any error the parser resynchronizes on the next
+ * sync byte.
+ */
+static void parseByte(uint8_t b)
+{
+	if (parser.length == 0 && b != UAVTALK_SYNC_VAL)
+		return;
+
+	parser.buffer[parser.length++] = b;
+
+	if (parser.length == 2 && (b & UAVTALK_TYPE_MASK) != UAVTALK_TYPE_VER) {
+		stats.bad_packets++;
+		parser.length = 0;
+		return;
+	}
+
+	if (parser.length == 4) {
+		parser.packet_size = parser.buffer[2] | (parser.buffer[3] << 8);
+		if (parser.packet_size < UAVTALK_MIN_HEADER_LENGTH ||
+		    parser.packet_size + UAVTALK_CHECKSUM_LENGTH > sizeof(parser.buffer)) {
+			stats.bad_packets++;
+			parser.length = 0;
+		}
+		return;
+	}
+
+	if (parser.length < 4 || parser.length < parser.packet_size + UAVTALK_CHECKSUM_LENGTH)
+		return;
+
+	if (PIOS_CRC_updateCRC(0, parser.buffer, parser.packet_size) == parser.buffer[parser.packet_size])
+		processPacket(parser.buffer, parser.packet_size);
+	else
+		stats.bad_packets++;
+
+	parser.length = 0;
+}
+
+/**
+ * Inject, compare or ignore one object update from the log
+ */
+static void processPacket(const uint8_t *packet, uint16_t packet_size)
+{
+	stats.packets++;
+
+	uint8_t type = packet[1];
+	if ((type & ~UAVTALK_TIMESTAMPED) != UAVTALK_TYPE_OBJ &&
+	    (type & ~UAVTALK_TIMESTAMPED) != UAVTALK_TYPE_OBJ_ACK)
+		return;
+
+	uint32_t objId = packet[4] | (packet[5] << 8) | (packet[6] << 16) | ((uint32_t) packet[7] << 24);
+	UAVObjHandle obj = UAVObjGetByID(objId);
+	if (obj == NULL) {
+		stats.unknown_objects++;
+		return;
+	}
+
+	if (UAVObjIsMetaobject(obj))
+		return;
+
+	uint16_t offset = UAVTALK_MIN_HEADER_LENGTH;
+	uint16_t instId = 0;
+	if (!UAVObjIsSingleInstance(obj)) {
+		instId = packet[offset] | (packet[offset + 1] << 8);
+		offset += 2;
+	}
+	if (type & UAVTALK_TIMESTAMPED)
+		offset += 2;
+
+	// Logs made with different object definitions do not fit
+	if (offset + UAVObjGetNumBytes(obj) != packet_size) {
+		stats.bad_packets++;
+		return;
+	}
+
+	struct replay_output *output = findOutput(obj);
+	if (output != NULL && !snapshot) {
+		// Stabilization answers the gyros before the accels are logged,
+		// keep its answer until the batch is complete
+		if (batch.num_samples > 0 && (started_steps & ~batch.steps) &&
+		    batch.num_answers < REPLAY_MAX_ANSWERS) {
+			holdRecord(&batch.answers[batch.num_answers++], obj, instId, &packet[offset]);
+			return;
+		}
+		injectBatch();
+		finishStep();
+		checkOutput(output, instId, &packet[offset]);
+		return;
+	}
+
+	if (output == NULL && !UAVObjIsSettings(obj) && !isInput(obj))
+		return;
+
+	// A sensor sample of the snapshot would run the loops on a partly
+	// loaded state, the next sample replaces it anyway
+	uint32_t step = stepBits(obj);
+	if (snapshot && step)
+		return;
+
+	// The consumers can run as soon as a sample is unpacked, so hold it back
+	// until the gyros and accels are both there, like the sensors publish
+	// them, and the GPS and other updates logged with them are injected
+	if (step & started_steps) {
+		if (batch.steps & step)
+			injectBatch();
+		holdRecord(&batch.samples[batch.num_samples++], obj, instId, &packet[offset]);
+		batch.steps |= step;
+		return;
+	}
+
+	if (UAVObjUnpack(obj, instId, &packet[offset]) == 0)
+		stats.injected++;
+}
+
+/**
+ * Keep a copy of a record until its batch is injected
+ */
+static void holdRecord(struct replay_record *record, UAVObjHandle obj, uint16_t instId, const uint8_t *data)
+{
+	record->obj = obj;
+	record->instId = instId;
+	memcpy(record->data, data, UAVObjGetNumBytes(obj));
+}
+
+/**
+ * Inject the held back sensor samples as one step, wait for the answers
+ * and compare the outputs logged with them
+ */
+static void injectBatch()
+{
+	if (batch.num_samples == 0)
+		return;
+
+	// Drop older answers before any sample is unpacked
+	finishStep();
+	UAVObjNotifierWait(notifier, ALL_STEPS, 0);
+
+	// Attitude only waits briefly for the accels once it has the gyros,
+	// so the gyros go last
+	for (uint8_t pass = 0; pass < 2; pass++) {
+		for (uint8_t i = 0; i < batch.num_samples; i++) {
+			struct replay_record *sample = &batch.samples[i];
+			if ((sample->obj == GyrosHandle()) != (pass == 1))
+				continue;
+
+			if (UAVObjUnpack(sample->obj, sample->instId, sample->data) != 0)
+				continue;
+
+			stats.injected++;
+			pending_step |= stepBits(sample->obj);
+		}
+	}
+	finishStep();
+
+	for (uint8_t i = 0; i < batch.num_answers; i++) {
+		struct replay_record *answer = &batch.answers[i];
+		checkOutput(findOutput(answer->obj), answer->instId, answer->data);
+	}
+
+	batch.num_samples = 0;
+	batch.num_answers = 0;
+	batch.steps = 0;
+}
+
+/**
+ * Compare an output once the loop that computes it runs
+ */
+static void checkOutput(struct replay_output *output, uint16_t instId, const uint8_t *logged)
+{
+	// The first answer of a loop tells that its module has started,
+	// give the local module time to get there as well
+	if (!realtime && (output->step & ~started_steps)) {
+		if (UAVObjNotifierWait(notifier, output->step, MS2TICKS(REPLAY_START_TIMEOUT_MS)) == 0)
+			stats.step_timeouts++;
+		started_steps |= output->step;
+	}
+
+	// Until every loop runs the outputs are start up values of the modules
+	if (started_steps != ALL_STEPS)
+		return;
+
+	compareOutput(output, instId, logged);
+}
+
+/**
+ * The output that answers a sensor sample when stepping through the log
+ * \returns the notifier bit to wait for, 0 for objects that do not drive a loop
+ */
+static uint32_t stepBits(UAVObjHandle obj)
+{
+	if (obj == GyrosHandle())
+		return ACTUATORDESIRED_UPDATED;
+	if (obj == AccelsHandle())
+		return ATTITUDEACTUAL_UPDATED;
+
+	return 0;
+}
+
+/**
+ * Wait until the consumers of the last sensor samples have answered
+ */
+static void finishStep()
+{
+	while (pending_step) {
+		uint32_t bits = UAVObjNotifierWait(notifier, pending_step, MS2TICKS(REPLAY_STEP_TIMEOUT_MS));
+		if (bits == 0) {
+			stats.step_timeouts++;
+			pending_step = 0;
+		}
+		pending_step &= ~bits;
+	}
+}
+
+static bool isInput(UAVObjHandle obj)
+{
+	for (uint32_t i = 0; i < NELEMENTS(inputs); i++)
+		if (inputs[i]() == obj)
+			return true;
+
+	return false;
+}
+
+static struct replay_output *findOutput(UAVObjHandle obj)
+{
+	for (uint32_t i = 0; i < NELEMENTS(outputs); i++)
+		if (outputs[i].handle() == obj)
+			return &outputs[i];
+
+	return NULL;
+}
+
+/**
+ * Extract the compared fields of a packed object
+ */
+static void getValues(const struct replay_output *output, const uint8_t *data, float *values)
+{
+	for (uint32_t i = 0; i < output->num_values; i++) {
+		if (output->type == REPLAY_FLOAT) {
+			memcpy(&values[i], &data[i * sizeof(float)], sizeof(float));
+		} else {
+			int16_t value;
+			memcpy(&value, &data[i * sizeof(int16_t)], sizeof(int16_t));
+			values[i] = value;
+		}
+	}
+}
+
+/**
+ * Compare a logged output against the locally computed one
+ */
+static void compareOutput(struct replay_output *output, uint16_t instId, const uint8_t *logged)
+{
+	if (UAVObjGetInstanceData(output->handle(), instId, local_data) != 0)
+		return;
+
+	float logged_values[REPLAY_MAX_VALUES];
+	float local_values[REPLAY_MAX_VALUES];
+	getValues(output, logged, logged_values);
+	getValues(output, local_data, local_values);
+
+	for (uint32_t i = 0; i < output->num_values; i++) {
+		float error = fabsf(local_values[i] - logged_values[i]);
+		if (!(error <= output->tolerance))
+			output->over[i]++;
+
+		if (!(error <= output->max_error[i]))
+			output->max_error[i] = error;
+		output->sum_sq_error[i] += error * error;
+	}
+
+	output->samples++;
+	stats.compared++;
+}
+
+/**
+ * Print the differences between the log and the replay
+ * \param[in] check whether differences above the tolerances are an error
+ * \returns the exit status, 0 when the errors of all fields are within their tolerance
+ */
+static int printReport(bool check)
+{
+	int result = 0;
+
+	printf("Replay: %u records, %u packets (%u bad, %u unknown objects), %u injected, %u compared, %u step timeouts\n",
+		stats.records, stats.packets, stats.bad_packets, stats.unknown_objects,
+		stats.injected, stats.compared, stats.step_timeouts);
+	printf("%-16s %8s %6s %12s %12s %12s %8s\n", "Object", "Samples", "Field", "Max error", "RMS error", "Tolerance", "Over");
+
+	for (uint32_t i = 0; i < NELEMENTS(outputs); i++) {
+		struct replay_output *output = &outputs[i];
+		if (output->samples == 0)
+			continue;
+
+		for (uint32_t j = 0; j < output->num_values; j++) {
+			float rms = sqrtf(output->sum_sq_error[j] / output->samples);
+			bool exceeded = output->over[j] * 100 > output->samples * REPLAY_MAX_OVER_PERCENT;
+			printf("%-16s %8u %6u %12g %12g %12g %8u%s\n", output->name, output->samples, j,
+				output->max_error[j], rms, output->tolerance, output->over[j], exceeded ? " !" : "");
+
+			if (check && exceeded)
+				result = 1;
+		}
+	}
+
+	if (result != 0)
+		printf("Replay: more than %u%% of the samples above the tolerance, marked with !\n", REPLAY_MAX_OVER_PERCENT);
+
+	return result;
+}
+
+/**
+  * @}
+  * @}
+  */
@@ -52,6 +52,7 @@
 #define TASK_PRIORITY (tskIDLE_PRIORITY+3)
 #define SENSOR_PERIOD 6		// this allows sensor data to arrive as slow as 166Hz
 #define REQUIRED_GOOD_CYCLES 50
+#define TEMP_COMP_THRESHOLD 0.1f	// deg C the average must move to recompute the gyro temp bias
 
 // Private types
 enum mag_calibration_algo {
@@ -71,7 +72,8 @@ static void update_baro(struct pios_sensor_baro_data *baro);
 static void mag_calibration_prelemari(MagnetometerData *mag);
 static void mag_calibration_fix_length(MagnetometerData *mag);
 
-static void updateTemperatureComp(float temperature, float *temp_bias);
+static bool updateTemperatureComp(float temperature, float *temp_bias);
+static void update_calibration(void);
 
 // Private variables
 static xTaskHandle sensorsTaskHandle;
@@ -93,6 +95,13 @@ static float gyro_temp_bias[3] = {0,0,0};
 static float z_accel_offset = 0;
 static float Rsb[3][3] = {{0}}; //! Rotation matrix that transforms from the body frame to the sensor board frame
 static int8_t rotate = 0;
+static float gyro_temp_comp_t = NAN; //! Average temperature gyro_temp_bias was computed for
+
+//! Scale, bias, temperature compensation and rotation of each sensor, see @ref update_calibration
+static float accel_affine[3][4];
+static float gyro_affine[3][4];
+static float mag_affine[3][4];
+static volatile bool calibration_dirty = true;
 
 //! Select the algorithm to try and null out the magnetometer bias error
 static enum mag_calibration_algo mag_calibration_algo = MAG_CALIBRATION_PRELEMARI;
@@ -181,6 +190,11 @@ static void SensorsTask(void *parameters)
 
 		uint32_t timeval = PIOS_DELAY_GetRaw();
 
+		if (calibration_dirty) {
+			calibration_dirty = false;
+			update_calibration();
+		}
+
 		//Block on gyro data but nothing else
 		xQueueHandle queue;
 		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_GYRO);
@@ -231,27 +245,12 @@ static void SensorsTask(void *parameters)
  */
 static void update_accels(struct pios_sensor_accel_data *accels)
 {
-	// Average and scale the accels before rotation
-	float accels_out[3] = {
-	    accels->x * accel_scale[0] - accel_bias[0],
-	    accels->y * accel_scale[1] - accel_bias[1],
-	    accels->z * accel_scale[2] - accel_bias[2]
-	};
-
-	if (rotate) {
-		float accel_rotated[3];
-		rot_mult(Rsb, accels_out, accel_rotated, true);
-		accelsData.x = accel_rotated[0];
-		accelsData.y = accel_rotated[1];
-		accelsData.z = accel_rotated[2];
-	} else {
-		accelsData.x = accels_out[0];
-		accelsData.y = accels_out[1];
-		accelsData.z = accels_out[2];
-	}
-
-	accelsData.z += z_accel_offset;
+	float accels_out[3];
+	affine_apply(accel_affine, &accels->x, accels_out, 1);
 
+	accelsData.x = accels_out[0];
+	accelsData.y = accels_out[1];
+	accelsData.z = accels_out[2];
 	accelsData.temperature = accels->temperature;
 	AccelsSet(&accelsData);
 }
@@ -262,37 +261,19 @@ static void update_accels(struct pios_sensor_accel_data *accels)
  */
 static void update_gyros(struct pios_sensor_gyro_data *gyros)
 {
-	// Scale the gyros
-	float gyros_out[3] = {
-	    gyros->x * gyro_scale[0],
-	    gyros->y * gyro_scale[1],
-	    gyros->z * gyro_scale[2]
-	};
+	// Update the bias due to the temperature, which is folded into the
+	// calibration ahead of the rotation
+	if (updateTemperatureComp(gyros->temperature, gyro_temp_bias))
+		update_calibration();
+
+	float gyros_out[3];
+	affine_apply(gyro_affine, &gyros->x, gyros_out, 1);
 
 	GyrosData gyrosData;
 	gyrosData.temperature = gyros->temperature;
-
-	// Update the bias due to the temperature
-	updateTemperatureComp(gyrosData.temperature, gyro_temp_bias);
-
-	// Apply temperature bias correction before the rotation
-	if (bias_correct_gyro) {
-		gyros_out[0] -= gyro_temp_bias[0];
-		gyros_out[1] -= gyro_temp_bias[1];
-		gyros_out[2] -= gyro_temp_bias[2];
-	}
-
-	if (rotate) {
-		float gyros[3];
-		rot_mult(Rsb, gyros_out, gyros, true);
-		gyrosData.x = gyros[0];
-		gyrosData.y = gyros[1];
-		gyrosData.z = gyros[2];
-	} else {
-		gyrosData.x = gyros_out[0];
-		gyrosData.y = gyros_out[1];
-		gyrosData.z = gyros_out[2];
-	}
+	gyrosData.x = gyros_out[0];
+	gyrosData.y = gyros_out[1];
+	gyrosData.z = gyros_out[2];
 
 	if (bias_correct_gyro) {
 		// Apply bias correction to the gyros from the state estimator
@@ -312,24 +293,13 @@ static void update_gyros(struct pios_sensor_gyro_data *gyros)
  */
 static void update_mags(struct pios_sensor_mag_data *mag)
 {
-	float mags[3] = {
-	    mag->x * mag_scale[0] - mag_bias[0],
-	    mag->y * mag_scale[1] - mag_bias[1],
-	    mag->z * mag_scale[2] - mag_bias[2]
-	};
+	float mags[3];
+	affine_apply(mag_affine, &mag->x, mags, 1);
 
 	MagnetometerData magData;
-	if (rotate) {
-		float mag_out[3];
-		rot_mult(Rsb, mags, mag_out, true);
-		magData.x = mag_out[0];
-		magData.y = mag_out[1];
-		magData.z = mag_out[2];
-	} else {
-		magData.x = mags[0];
-		magData.y = mags[1];
-		magData.z = mags[2];
-	}
+	magData.x = mags[0];
+	magData.y = mags[1];
+	magData.z = mags[2];
 
 	// Correct for mag bias and update if the rate is non zero
 	if (insSettings.MagBiasNullingRate > 0) {
@@ -367,9 +337,11 @@ static void update_baro(struct pios_sensor_baro_data *baro)
 
 /**
  * Compute the bias expected from temperature variation for each gyro
- * channel
+ * channel. The temperature is averaged over 500 samples and the bias only
+ * recomputed when the average has moved by more than TEMP_COMP_THRESHOLD.
+ * @returns true if temp_bias changed
  */
-static void updateTemperatureComp(float temperature, float *temp_bias)
+static bool updateTemperatureComp(float temperature, float *temp_bias)
 {
 	static int temp_counter = -1;
 	static float temp_accum = 0;
@@ -389,14 +361,35 @@ static void updateTemperatureComp(float temperature, float *temp_bias)
 		temp_accum = 0;
 		temp_counter = 0;
 
-		// Compute a third order polynomial for each chanel after each 500 samples
-		temp_bias[0] = gyro_coeff_x[0] + gyro_coeff_x[1] * t + 
-		               gyro_coeff_x[2] * powf(t,2) + gyro_coeff_x[3] * powf(t,3);
-		temp_bias[1] = gyro_coeff_y[0] + gyro_coeff_y[1] * t + 
-		               gyro_coeff_y[2] * powf(t,2) + gyro_coeff_y[3] * powf(t,3);
-		temp_bias[2] = gyro_coeff_z[0] + gyro_coeff_z[1] * t + 
-		               gyro_coeff_z[2] * powf(t,2) + gyro_coeff_z[3] * powf(t,3);
+		// gyro_temp_comp_t is NAN after a settings change, so this fails
+		if (fabsf(t - gyro_temp_comp_t) < TEMP_COMP_THRESHOLD)
+			return false;
+		gyro_temp_comp_t = t;
+
+		// Evaluate a third order polynomial for each channel
+		temp_bias[0] = gyro_coeff_x[0] + t * (gyro_coeff_x[1] + t * (gyro_coeff_x[2] + t * gyro_coeff_x[3]));
+		temp_bias[1] = gyro_coeff_y[0] + t * (gyro_coeff_y[1] + t * (gyro_coeff_y[2] + t * gyro_coeff_y[3]));
+		temp_bias[2] = gyro_coeff_z[0] + t * (gyro_coeff_z[1] + t * (gyro_coeff_z[2] + t * gyro_coeff_z[3]));
+		return true;
 	}
+
+	return false;
+}
+
+/**
+ * Fold the scale, bias, temperature compensation and board rotation of
+ * each sensor into the affine transform applied to its samples
+ */
+static void update_calibration(void)
+{
+	const float zero[3] = {0, 0, 0};
+	const float accel_offset[3] = {0, 0, z_accel_offset};
+	float (*R)[3] = rotate ? Rsb : NULL;
+
+	affine_from_calibration(accel_affine, R, true, accel_scale, accel_bias, accel_offset);
+	affine_from_calibration(gyro_affine, R, true, gyro_scale,
+	                        bias_correct_gyro ? gyro_temp_bias : zero, zero);
+	affine_from_calibration(mag_affine, R, true, mag_scale, mag_bias, zero);
 }
 
 /**
@@ -571,6 +564,9 @@ static void settingsUpdatedCb(UAVObjEvent * objEv)
 		rotate = 1;
 	}
 
+	// Rebuilt by the sensors task before its next sample
+	gyro_temp_comp_t = NAN;
+	calibration_dirty = true;
 }
 /**
   * @}
@@ -56,9 +56,20 @@
 
 // Private constants
 #define STACK_SIZE_BYTES 1540
+#if defined(PIOS_SIM_LOCKSTEP)
+// Below Attitude and Stabilization, so they run as soon as a step is published
+#define TASK_PRIORITY (tskIDLE_PRIORITY+2)
+#else
 #define TASK_PRIORITY (tskIDLE_PRIORITY+3)
+#endif
 #define SENSOR_PERIOD 2
 
+#if defined(PIOS_SIM_LOCKSTEP)
+//! How long to wait for the control loop to answer a step
+#define LOCKSTEP_STEP_TIMEOUT_MS 5
+#define ACTUATORDESIRED_UPDATED 0x01
+#endif
+
 // Private types
 
 // Private variables
@@ -71,6 +82,11 @@ static void simulateModelAgnostic();
 static void simulateModelQuadcopter();
 static void simulateModelAirplane();
 static void simulateModelCar();
+#if defined(PIOS_SIM_LOCKSTEP)
+static void simulateLockstep();
+
+static UAVObjNotifier lockstepNotifier;
+#endif
 
 static void magOffsetEstimation(MagnetometerData *mag);
 
@@ -78,7 +94,7 @@ static float accel_bias[3];
 
 static float rand_gauss();
 
-enum sensor_sim_type {CONSTANT, MODEL_AGNOSTIC, MODEL_QUADCOPTER, MODEL_AIRPLANE, MODEL_CAR} sensor_sim_type;
+enum sensor_sim_type {CONSTANT, MODEL_AGNOSTIC, MODEL_QUADCOPTER, MODEL_AIRPLANE, MODEL_CAR, LOCKSTEP} sensor_sim_type;
 
 /**
  * Initialise the module.  Called before the start function
@@ -102,6 +118,15 @@ int32_t SensorsInitialize(void)
 	MagnetometerInitialize();
 	MagBiasInitialize();
 
+#if defined(PIOS_SIM_LOCKSTEP)
+	if (PIOS_SIM_Init() != 0)
+		return -1;
+
+	lockstepNotifier = UAVObjNotifierCreate();
+	if (lockstepNotifier == NULL)
+		return -1;
+#endif
+
 	return 0;
 }
 
@@ -111,6 +136,12 @@ int32_t SensorsInitialize(void)
  */
 int32_t SensorsStart(void)
 {
+#if defined(PIOS_SIM_LOCKSTEP)
+	// Owned by Stabilization, only known to be initialized at this point
+	if (ActuatorDesiredConnectNotifier(lockstepNotifier, ACTUATORDESIRED_UPDATED) != 0)
+		return -1;
+#endif
+
 	// Start main task
 	xTaskCreate(SensorsTask, (signed char *)"Sensors", STACK_SIZE_BYTES/4, NULL, TASK_PRIORITY, &sensorsTaskHandle);
 	TaskMonitorAdd(TASKINFO_RUNNING_SENSORS, sensorsTaskHandle);
@@ -168,6 +199,11 @@ static void SensorsTask(void *parameters)
 			default:
 				sensor_sim_type = MODEL_AGNOSTIC;
 		}
+
+#if defined(PIOS_SIM_LOCKSTEP)
+		// The GCS runs the airframe model
+		sensor_sim_type = LOCKSTEP;
+#endif
 		
 		static int i;
 		i++;
@@ -193,9 +229,17 @@ static void SensorsTask(void *parameters)
 				break;
 			case MODEL_CAR:
 				simulateModelCar();
+				break;
+			case LOCKSTEP:
+#if defined(PIOS_SIM_LOCKSTEP)
+				simulateLockstep();
+#endif
+				break;
 		}
 
-		vTaskDelay(MS2TICKS(2));
+		// In lockstep the GCS paces the steps
+		if (sensor_sim_type != LOCKSTEP)
+			vTaskDelay(MS2TICKS(2));
 
 	}
 }
@@ -1079,6 +1123,110 @@ static void simulateModelCar()
 	AttitudeSimulatedSet(&attitudeSimulated);
 }
 
+#if defined(PIOS_SIM_LOCKSTEP)
+/**
+ * Take the sensors from the GCS HITL bridge through the PIOS_SIM hooks
+ *
+ * Each step blocks until the GCS sends the sensor frame of the step, then
+ * publishes it with the gyros last since they trigger Attitude and
+ * Stabilization. Once Stabilization answered with the ActuatorDesired it
+ * computed from these sensors, those actuators answer the same frame. In
+ * manual mode ManualControl owns ActuatorDesired and the step is answered
+ * right away.
+ */
+static void simulateLockstep()
+{
+	if (PIOS_SIM_Step(SENSOR_PERIOD / 1000.0f) != 0)
+		return;
+
+	// Drop answers to earlier steps
+	UAVObjNotifierWait(lockstepNotifier, ACTUATORDESIRED_UPDATED, 0);
+
+	float accels[3], gyros[3], mag[3], baro[1], q[4], vel[3], pos[3];
+	PIOS_SIM_GetAccels(accels);
+	PIOS_SIM_GetGyros(gyros);
+	PIOS_SIM_GetMag(mag);
+	PIOS_SIM_GetBaro(baro);
+	PIOS_SIM_GetAttitude(q);
+	PIOS_SIM_GetVelocity(vel);
+	PIOS_SIM_GetPosition(pos);
+
+	AccelsData accelsData; // Skip get as we set all the fields
+	accelsData.x = accels[0] + accel_bias[0];
+	accelsData.y = accels[1] + accel_bias[1];
+	accelsData.z = accels[2] + accel_bias[2];
+	accelsData.temperature = 30;
+	AccelsSet(&accelsData);
+
+	BaroAltitudeData baroAltitude;
+	BaroAltitudeGet(&baroAltitude);
+	baroAltitude.Altitude = baro[0];
+	BaroAltitudeSet(&baroAltitude);
+
+	// Most simulators do not provide a magnetometer, rotate the home
+	// location field into the body frame instead
+	MagnetometerData magData;
+	if (mag[0] == 0 && mag[1] == 0 && mag[2] == 0) {
+		HomeLocationData homeLocation;
+		HomeLocationGet(&homeLocation);
+
+		float Rbe[3][3];
+		Quaternion2R(q, Rbe);
+		magData.x = homeLocation.Be[0] * Rbe[0][0] + homeLocation.Be[1] * Rbe[0][1] + homeLocation.Be[2] * Rbe[0][2];
+		magData.y = homeLocation.Be[0] * Rbe[1][0] + homeLocation.Be[1] * Rbe[1][1] + homeLocation.Be[2] * Rbe[1][2];
+		magData.z = homeLocation.Be[0] * Rbe[2][0] + homeLocation.Be[1] * Rbe[2][1] + homeLocation.Be[2] * Rbe[2][2];
+	} else {
+		magData.x = mag[0];
+		magData.y = mag[1];
+		magData.z = mag[2];
+	}
+	magOffsetEstimation(&magData);
+	MagnetometerSet(&magData);
+
+	AttitudeSimulatedData attitudeSimulated;
+	AttitudeSimulatedGet(&attitudeSimulated);
+	attitudeSimulated.q1 = q[0];
+	attitudeSimulated.q2 = q[1];
+	attitudeSimulated.q3 = q[2];
+	attitudeSimulated.q4 = q[3];
+	Quaternion2RPY(q,&attitudeSimulated.Roll);
+	attitudeSimulated.Position[0] = pos[0];
+	attitudeSimulated.Position[1] = pos[1];
+	attitudeSimulated.Position[2] = pos[2];
+	attitudeSimulated.Velocity[0] = vel[0];
+	attitudeSimulated.Velocity[1] = vel[1];
+	attitudeSimulated.Velocity[2] = vel[2];
+	AttitudeSimulatedSet(&attitudeSimulated);
+
+	GyrosData gyrosData; // Skip get as we set all the fields
+	gyrosData.x = gyros[0];
+	gyrosData.y = gyros[1];
+	gyrosData.z = gyros[2];
+
+	// Apply bias correction to the gyros
+	GyrosBiasData gyrosBias;
+	GyrosBiasGet(&gyrosBias);
+	gyrosData.x += gyrosBias.x;
+	gyrosData.y += gyrosBias.y;
+	gyrosData.z += gyrosBias.z;
+	gyrosData.temperature = 30;
+
+	GyrosSet(&gyrosData);
+
+	FlightStatusData flightStatus;
+	FlightStatusGet(&flightStatus);
+	if (flightStatus.FlightMode != FLIGHTSTATUS_FLIGHTMODE_MANUAL &&
+	    UAVObjNotifierWait(lockstepNotifier, ACTUATORDESIRED_UPDATED, MS2TICKS(LOCKSTEP_STEP_TIMEOUT_MS)) == 0)
+		fprintf(stderr, "HITL lockstep: no ActuatorDesired for this step, answering with the previous one\n");
+
+	ActuatorDesiredData actuatorDesired;
+	ActuatorDesiredGet(&actuatorDesired);
+	float actuator[4] = {actuatorDesired.Roll, actuatorDesired.Pitch,
+	                     actuatorDesired.Yaw, actuatorDesired.Throttle};
+	PIOS_SIM_SetActuator(actuator, NELEMENTS(actuator));
+	PIOS_SIM_Commit();
+}
+#endif /* PIOS_SIM_LOCKSTEP */
 
 static float rand_gauss (void) {
 	float v1,v2,s;
@@ -119,7 +119,10 @@ static void VisualizationTask(void *parameters)
 		uav_data.camera_roll = camera.Roll * 30;
 		uav_data.camera_pitch = camera.Pitch * 45;
 		sendto(s, (struct sockaddr *) &uav_data, sizeof(uav_data), 0, (struct sockaddr *) &server, sizeof(server));
+#if !defined(portPOSIX_FIBERS)
+		// With fibers this would stall every task
 		usleep(100000);
+#endif
 		vTaskDelay(100);
 
 	}
@@ -62,7 +62,7 @@
 #include "virtualflybar.h"
 
 // Private constants
-#define MAX_QUEUE_SIZE 1
+#define GYROS_UPDATED 0x01
 
 #if defined(PIOS_STABILIZATION_STACK_SIZE)
 #define STACK_SIZE_BYTES PIOS_STABILIZATION_STACK_SIZE
@@ -97,7 +97,7 @@ enum {
 static xTaskHandle taskHandle;
 static StabilizationSettingsData settings;
 static TrimAnglesData trimAngles;
-static xQueueHandle queue;
+static UAVObjNotifier notifier;
 float gyro_alpha = 0;
 float axis_lock_accum[3] = {0,0,0};
 uint8_t max_axis_lock = 0;
@@ -119,12 +119,11 @@ static void SettingsUpdatedCb(UAVObjEvent * ev);
 int32_t StabilizationStart()
 {
 	// Initialize variables
-	// Create object queue
-	queue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
+	// Create object notifier
+	notifier = UAVObjNotifierCreate();
 
 	// Listen for updates.
-	//	AttitudeActualConnectQueue(queue);
-	GyrosConnectQueue(queue);
+	GyrosConnectNotifier(notifier, GYROS_UPDATED);
 	
 	// Connect settings callback
 	StabilizationSettingsConnectCallback(SettingsUpdatedCb);
@@ -164,8 +163,6 @@ MODULE_INITCALL(StabilizationInitialize, StabilizationStart);
  */
 static void stabilizationTask(void* parameters)
 {
-	UAVObjEvent ev;
-	
 	uint32_t timeval = PIOS_DELAY_GetRaw();
 	
 	ActuatorDesiredData actuatorDesired;
@@ -190,12 +187,13 @@ static void stabilizationTask(void* parameters)
 		
 		PIOS_WDG_UpdateFlag(PIOS_WDG_STABILIZATION);
 		
-		// Wait until the AttitudeRaw object is updated, if a timeout then go to failsafe
-		if ( xQueueReceive(queue, &ev, MS2TICKS(FAILSAFE_TIMEOUT_MS)) != pdTRUE )
+		// Wait until the Gyros object is updated, if a timeout then go to failsafe
+		if (UAVObjNotifierWait(notifier, GYROS_UPDATED, MS2TICKS(FAILSAFE_TIMEOUT_MS)) == 0)
 		{
 			AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION,SYSTEMALARMS_ALARM_WARNING);
 			continue;
 		}
+		TaskMonitorLoopBegin(TASKINFO_RUNNING_STABILIZATION);
 		
 		dT = PIOS_DELAY_DiffuS(timeval) * 1.0e-6f;
 		timeval = PIOS_DELAY_GetRaw();
@@ -601,6 +599,8 @@ static void stabilizationTask(void* parameters)
 			AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION,SYSTEMALARMS_ALARM_ERROR);
 		else
 			AlarmsClear(SYSTEMALARMS_ALARM_STABILIZATION);
+
+		TaskMonitorLoopEnd(TASKINFO_RUNNING_STABILIZATION);
 	}
 }
 
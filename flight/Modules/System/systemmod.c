@@ -33,6 +33,7 @@
 #include "systemmod.h"
 #include "sanitycheck.h"
 #include "objectpersistence.h"
+#include "eventdispatcherstats.h"
 #include "flightstatus.h"
 #include "manualcontrolsettings.h"
 #include "stabilizationsettings.h"
@@ -41,6 +42,9 @@
 #include "taskinfo.h"
 #include "watchdogstatus.h"
 #include "taskmonitor.h"
+#if defined(I2C_STATS_DIAGNOSTICS)
+#include "i2cstats.h"
+#endif
 
 //#define DEBUG_THIS_FILE
 
@@ -86,10 +90,14 @@ static void configurationUpdatedCb(UAVObjEvent * ev);
 
 static void updateStats();
 static void updateSystemAlarms();
+static void updateEventStats(const EventStats *evStats);
 static void systemTask(void *parameters);
 #if defined(WDG_STATS_DIAGNOSTICS)
 static void updateWDGstats();
 #endif
+#if defined(I2C_STATS_DIAGNOSTICS)
+static void updateI2Cstats();
+#endif
 /**
  * Create the module task.
  * \returns 0 on success or -1 if initialization failed
@@ -118,12 +126,16 @@ int32_t SystemModInitialize(void)
 	SystemStatsInitialize();
 	FlightStatusInitialize();
 	ObjectPersistenceInitialize();
+	EventDispatcherStatsInitialize();
 #if defined(DIAG_TASKS)
 	TaskInfoInitialize();
 #endif
 #if defined(WDG_STATS_DIAGNOSTICS)
 	WatchdogStatusInitialize();
 #endif
+#if defined(I2C_STATS_DIAGNOSTICS)
+	I2CStatsInitialize();
+#endif
 
 	objectPersistenceQueue = xQueueCreate(1, sizeof(UAVObjEvent));
 	if (objectPersistenceQueue == NULL)
@@ -188,6 +200,9 @@ static void systemTask(void *parameters)
 #if defined(WDG_STATS_DIAGNOSTICS)
 		updateWDGstats();
 #endif
+#if defined(I2C_STATS_DIAGNOSTICS)
+		updateI2Cstats();
+#endif
 
 #if defined(DIAG_TASKS)
 		// Update the task status object
@@ -340,6 +355,33 @@ static void updateWDGstats()
 }
 #endif
 
+/**
+ * Called periodically to update the statistics of the I2C buses
+ */
+#if defined(I2C_STATS_DIAGNOSTICS)
+static void updateI2Cstats()
+{
+	I2CStatsData i2cStats;
+	memset(&i2cStats, 0, sizeof(i2cStats));
+
+	for (uint8_t bus = 0; bus < I2CSTATS_REQUESTS_NUMELEM; bus++) {
+		struct pios_i2c_stats stats;
+		if (PIOS_I2C_GetStats(PIOS_I2C_GetAdapter(bus), &stats) != 0)
+			continue;
+
+		i2cStats.Requests[bus] = stats.requests;
+		i2cStats.BytesPerSecond[bus] = stats.bytes_per_second;
+		i2cStats.Nacks[bus] = stats.nacks;
+		i2cStats.BusErrors[bus] = stats.bus_errors;
+		i2cStats.FsmFaults[bus] = stats.fsm_faults;
+		i2cStats.Timeouts[bus] = stats.timeouts;
+		i2cStats.MaxQueueDepth[bus] = stats.max_queue_depth;
+	}
+
+	I2CStatsSet(&i2cStats);
+}
+#endif
+
 
 /**
  * Called periodically to update the system stats
@@ -483,6 +525,7 @@ static void updateSystemAlarms()
 	EventGetStats(&evStats);
 	UAVObjClearStats();
 	EventClearStats();
+	updateEventStats(&evStats);
 	if (objStats.eventCallbackErrors > 0 || objStats.eventQueueErrors > 0  || evStats.eventErrors > 0) {
 		AlarmsSet(SYSTEMALARMS_ALARM_EVENTSYSTEM, SYSTEMALARMS_ALARM_WARNING);
 	} else {
@@ -500,6 +543,27 @@ static void updateSystemAlarms()
 		
 }
 
+/**
+ * Publish the event dispatcher statistics of the last update period
+ */
+static void updateEventStats(const EventStats *evStats)
+{
+	EventDispatcherStatsData eventStats;
+
+	for (uint8_t i = 0; i < EV_PRIORITY_NUM; i++) {
+		eventStats.Callbacks[i] = evStats->callbackCount[i];
+		eventStats.CallbackTime[i] = evStats->callbackTimeUs[i];
+		eventStats.CallbackTimeMax[i] = evStats->callbackMaxUs[i];
+		eventStats.Aged[i] = evStats->agedCount[i];
+	}
+	eventStats.Coalesced = evStats->coalescedEvents;
+	eventStats.Errors = evStats->eventErrors;
+	eventStats.SlowestCallbackID = evStats->slowestCallbackID;
+	eventStats.SlowestCallback = (uint32_t)(uintptr_t)evStats->slowestCallback;
+
+	EventDispatcherStatsSet(&eventStats);
+}
+
 /**
  * Called by the RTOS when the CPU is idle, used to measure the CPU idle time.
  */
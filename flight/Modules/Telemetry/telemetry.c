@@ -64,11 +64,14 @@ static uint32_t txErrors;
 static uint32_t txRetries;
 static uint32_t timeOfLastObjectUpdate;
 static UAVTalkConnection uavTalkCon;
+static uintptr_t reservedPort;
 
 // Private functions
 static void telemetryTxTask(void *parameters);
 static void telemetryRxTask(void *parameters);
 static int32_t transmitData(uint8_t * data, int32_t length);
+static uint8_t *reserveData(uint16_t length);
+static int32_t commitData(uint8_t * data, uint16_t length);
 static void registerObject(UAVObjHandle obj);
 static void updateObject(UAVObjHandle obj, int32_t eventType);
 static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs);
@@ -130,6 +133,7 @@ int32_t TelemetryInitialize(void)
     
 	// Initialise UAVTalk
 	uavTalkCon = UAVTalkInitialize(&transmitData);
+	UAVTalkSetOutputBuffer(uavTalkCon, &reserveData, &commitData);
     
 	// Create periodic event that will be used to update the telemetry stats
 	txErrors = 0;
@@ -403,6 +407,33 @@ static int32_t transmitData(uint8_t * data, int32_t length)
 	return -1;
 }
 
+/**
+ * Get room in the transmit buffer of the modem or USB port to build a
+ * packet in. UAVTalk holds its lock until the packet is committed.
+ * \param[in] length Length of the packet
+ * \return NULL if there is no room, the packet then goes to transmitData
+ */
+static uint8_t *reserveData(uint16_t length)
+{
+	reservedPort = getComPort();
+
+	if (reservedPort)
+		return PIOS_COM_SendReserve(reservedPort, length);
+
+	return NULL;
+}
+
+/**
+ * Transmit a packet built by reserveData
+ * \param[in] data The reserved room
+ * \param[in] length Length of the packet
+ * \return number of bytes transmitted
+ */
+static int32_t commitData(uint8_t * data, uint16_t length)
+{
+	return PIOS_COM_SendCommit(reservedPort, length);
+}
+
 /**
  * Set update period of object (it must be already setup for periodic updates)
  * \param[in] obj The object to update
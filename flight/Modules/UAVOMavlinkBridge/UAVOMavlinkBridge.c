@@ -49,6 +49,7 @@
 
 static void uavoMavlinkBridgeTask(void *parameters);
 static bool stream_trigger(enum MAV_DATA_STREAM stream_num);
+static void send_message(void);
 
 // ****************
 // Private constants
@@ -207,7 +208,6 @@ static void uavoMavlinkBridgeTask(void *parameters) {
 		homeLocation.SeaLevelPressure = STANDARD_AIR_SEA_LEVEL_PRESSURE/1000;
 	}
 
-	uint16_t msg_length;
 	portTickType lastSysTime;
 	// Main task loop
 	lastSysTime = xTaskGetTickCount();
@@ -262,8 +262,7 @@ static void uavoMavlinkBridgeTask(void *parameters) {
 					0,
 					// errors_count4 Autopilot-specific errors
 					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+			send_message();
 		}
 
 		if (stream_trigger(MAV_DATA_STREAM_RC_CHANNELS)) {
@@ -295,8 +294,7 @@ static void uavoMavlinkBridgeTask(void *parameters) {
 					manualState.Channel[7],
 					// rssi Receive signal strength indicator, 0: 0%, 255: 100%
 					manualState.Rssi);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+			send_message();
 		}
 
 		if (stream_trigger(MAV_DATA_STREAM_POSITION)) {
@@ -347,8 +345,7 @@ static void uavoMavlinkBridgeTask(void *parameters) {
 					gpsPosData.Heading * 100,
 					// satellites_visible Number of satellites visible. If unknown, set to 255
 					gpsPosData.Satellites);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+			send_message();
 
 			mavlink_msg_gps_global_origin_pack(0, 200, &mavMsg,
 					// latitude Latitude (WGS84), expressed as * 1E7
@@ -357,8 +354,7 @@ static void uavoMavlinkBridgeTask(void *parameters) {
 					homeLocation.Longitude,
 					// altitude Altitude(WGS84), expressed as * 1000
 					homeLocation.Altitude * 1000);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+			send_message();
 
 			//TODO add waypoint nav stuff
 			//wp_target_bearing
@@ -390,8 +386,7 @@ static void uavoMavlinkBridgeTask(void *parameters) {
 					0,
 					// yawspeed Yaw angular speed (rad/s)
 					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+			send_message();
 		}
 
 		if (stream_trigger(MAV_DATA_STREAM_EXTRA2)) {
@@ -428,8 +423,7 @@ static void uavoMavlinkBridgeTask(void *parameters) {
 					altitude,
 					// climb Current climb rate in meters/second
 					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+			send_message();
 
 			uint8_t armed_mode = 0;
 			if (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED)
@@ -446,12 +440,28 @@ static void uavoMavlinkBridgeTask(void *parameters) {
 					0,
 					// system_status System status flag, see MAV_STATE ENUM
 					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+			send_message();
 		}
 	}
 }
 
+/**
+ * Send mavMsg, packed straight into the transmit buffer of the port when
+ * there is room for it there.
+ */
+static void send_message(void) {
+	uint16_t msg_length = MAVLINK_NUM_NON_PAYLOAD_BYTES + (uint16_t)mavMsg.len;
+	uint8_t *dest = PIOS_COM_SendReserve(mavlink_port, msg_length);
+
+	if (dest != NULL) {
+		mavlink_msg_to_send_buffer(dest, &mavMsg);
+		PIOS_COM_SendCommit(mavlink_port, msg_length);
+	} else {
+		msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
+		PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+	}
+}
+
 static bool stream_trigger(enum MAV_DATA_STREAM stream_num) {
 	uint8_t rate = (uint8_t) mav_rates[stream_num];
 
@@ -49,7 +49,7 @@
 
 // Private constants
 
-#define MAX_QUEUE_SIZE 2
+#define ACCELS_UPDATED 0x01
 #define STACK_SIZE_BYTES (200 + 484 + (13*fft_window_size)*0) // The fft memory requirement grows linearly 
 																				  // with window size. The constant is multiplied
 																				  // by 0 in order to reflect the fact that the
@@ -65,7 +65,7 @@
 
 // Private variables
 static xTaskHandle taskHandle;
-static xQueueHandle queue;
+static UAVObjNotifier notifier;
 static bool module_enabled = false;
 
 static struct VibrationAnalysis_data {
@@ -224,8 +224,8 @@ static int32_t VibrationAnalysisInitialize(void)
 	VibrationAnalysisSettingsInitialize();
 	VibrationAnalysisOutputInitialize();
 		
-	// Create object queue
-	queue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
+	// Create object notifier
+	notifier = UAVObjNotifierCreate();
 		
 	return 0;
 	
@@ -242,10 +242,9 @@ static void VibrationAnalysisTask(void *parameters)
 	uint8_t runAnalysisFlag = VIBRATIONANALYSISSETTINGS_TESTINGSTATUS_OFF; // By default, turn analysis off
 	uint16_t sampleRate_ms = 100; // Default sample rate of 100ms
 	uint8_t sample_count;
-	UAVObjEvent ev;
 	
 	// Listen for updates.
-	AccelsConnectQueue(queue);
+	AccelsConnectNotifier(notifier, ACCELS_UPDATED);
 	
 	// Declare FFT structure and status variable
 	arm_cfft_radix4_instance_q15 cfft_instance;
@@ -293,7 +292,7 @@ static void VibrationAnalysisTask(void *parameters)
 		}
 		
 		// Wait until the Accels object is updated, and never time out
-		if ( xQueueReceive(queue, &ev, portMAX_DELAY) == pdTRUE )
+		if ( UAVObjNotifierWait(notifier, ACCELS_UPDATED, portMAX_DELAY) != 0 )
 		{
 			/**
 			 * Accumulate accelerometer data. This would be a great place to add a 
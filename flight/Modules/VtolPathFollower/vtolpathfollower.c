@@ -184,6 +184,7 @@ static void vtolPathFollowerTask(void *parameters)
 
 		// Continue collecting data if not enough time
 		vTaskDelayUntil(&lastUpdateTime, MS2TICKS(guidanceSettings.UpdatePeriod));
+		TaskMonitorLoopBegin(TASKINFO_RUNNING_PATHFOLLOWER);
 
 		// Convert the accels into the NED frame
 		updateNedAccel();
@@ -240,6 +241,7 @@ static void vtolPathFollowerTask(void *parameters)
 
 		AlarmsClear(SYSTEMALARMS_ALARM_PATHFOLLOWER);
 
+		TaskMonitorLoopEnd(TASKINFO_RUNNING_PATHFOLLOWER);
 	}
 }
 
@@ -106,6 +106,7 @@ static void gcsreceiver_updated(UAVObjEvent * ev)
 	if (ev->obj == GCSReceiverHandle()) {
 		GCSReceiverGet(&gcsreceiverdata);
 		gcsrcvr_dev->Fresh = true;
+		PIOS_RCVR_Active();
 	}
 }
 
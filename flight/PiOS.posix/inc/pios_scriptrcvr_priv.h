@@ -0,0 +1,46 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SCRIPTRCVR Scripted receiver for the simulator
+ * @{
+ *
+ * @file       pios_scriptrcvr_priv.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @brief      Scripted receiver private definitions.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_SCRIPTRCVR_PRIV_H
+#define PIOS_SCRIPTRCVR_PRIV_H
+
+#include <pios.h>
+
+#define PIOS_SCRIPTRCVR_NUM_INPUTS 12
+
+extern const struct pios_rcvr_driver pios_scriptrcvr_rcvr_driver;
+
+extern int32_t PIOS_SCRIPTRCVR_Init(uintptr_t *scriptrcvr_id, const char *script);
+
+#endif /* PIOS_SCRIPTRCVR_PRIV_H */
+
+/**
+  * @}
+  * @}
+  */
@@ -4,10 +4,14 @@
 
 int PIOS_SIM_Init();
 int PIOS_SIM_Step(float dT);
+int PIOS_SIM_Commit();
 void PIOS_SIM_SetActuator(float * actuator_int, int nchannels);
 void PIOS_SIM_GetAccels(float *);
 void PIOS_SIM_GetGyros(float *);
+void PIOS_SIM_GetMag(float *);
+void PIOS_SIM_GetBaro(float *);
 void PIOS_SIM_GetAttitude(float *);
+void PIOS_SIM_GetVelocity(float *);
 void PIOS_SIM_GetPosition(float *);
 
 #endif /* PIOS_SIM_H */
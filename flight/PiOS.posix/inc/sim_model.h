@@ -4,3 +4,4 @@
 extern int sim_model_init();
 extern int sim_model_terminate();
 extern int sim_model_step(float dT, struct pios_sim_state * state);
+extern int sim_model_commit(struct pios_sim_state * state);
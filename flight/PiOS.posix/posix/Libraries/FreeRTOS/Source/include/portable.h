@@ -304,8 +304,8 @@ portmacro.h has not yet been included - as every portmacro.h provides a
 portENTER_CRITICAL() definition.  Check the demo application for your demo
 to find the path to the correct portmacro.h file. */
 #ifndef portENTER_CRITICAL
-	#include "../../Source/portable/GCC/Posix/portmacro.h"	
-	//#include "portmacro.h"	
+	/* The port directory selected by library.mk is on the include path */
+	#include "portmacro.h"
 #endif
 	
 #if portBYTE_ALIGNMENT == 8
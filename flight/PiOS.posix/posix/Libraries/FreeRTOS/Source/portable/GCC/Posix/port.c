@@ -110,6 +110,8 @@ This approach is tested and works both on Linux and BSD style Unix (MAC OS X)
 /*-----------------------------------------------------------*/
 
 #define MAX_NUMBER_OF_TASKS 		( _POSIX_THREAD_THREADS_MAX )
+/* How long the ended scheduler waits for the task threads to exit */
+#define portEXIT_TIMEOUT_MS			1000
 /*-----------------------------------------------------------*/
 
 #define PORT_PRINT(...) fprintf(stderr,__VA_ARGS__)
@@ -171,6 +173,7 @@ static xThreadState* prvGetThreadHandle( xTaskHandle hTask );
 static xThreadState* prvGetThreadHandleByThread( pthread_t hThread );
 static portLONG prvGetFreeThreadState( void );
 static void prvDeleteThread( void *xThreadId );
+static portBASE_TYPE prvWaitForThreadsToExit( void );
 static void prvPortYield();
 /*-----------------------------------------------------------*/
 
@@ -335,11 +338,22 @@ portBASE_TYPE xPortStartScheduler( void )
 	}
 
 	PORT_PRINT( "Cleaning Up, Exiting.\n" );
+
+	/* The cancelled threads still run prvDeleteThread() on their way out,
+	which clears their entry. Wait for them before the entries are freed,
+	a thread that does not get there in time keeps them allocated. */
+	if ( !prvWaitForThreadsToExit() )
+		return 0;
+
 	/* Cleanup the mutexes */
 	pthread_mutex_destroy( &xRunningThreadMutex );
 	pthread_mutex_destroy( &xYieldingThreadMutex );
 	pthread_mutex_destroy( &xGuardMutex );
-	vPortFree( (void *)pxThreads );
+
+	/* This thread is not a task, vPortFree() would enter a critical
+	section. The posix heap is malloc() underneath. */
+	free( (void *)pxThreads );
+	pxThreads = NULL;
 
 	/* Should not get here! */
 	return 0;
@@ -352,6 +366,11 @@ portBASE_TYPE xPortStartScheduler( void )
 void vPortEndScheduler( void )
 {
 portBASE_TYPE xNumberOfThreads;
+
+	/* Stop the tick handler first, it must not look for the threads that
+	are being killed. */
+	xSchedulerEnd = pdTRUE;
+
 	for ( xNumberOfThreads = 0; xNumberOfThreads < MAX_NUMBER_OF_TASKS; xNumberOfThreads++ )
 	{
 		if ( ( pthread_t )NULL != pxThreads[ xNumberOfThreads ].hThread )
@@ -539,6 +558,12 @@ portBASE_TYPE xPortSetInterruptMask( void )
 {
 	portBASE_TYPE xReturn;
 
+	/**
+	 * the tick hook runs on the supervisor thread, which already holds
+	 * the guard while every task is suspended
+	 */
+	if ( xSchedulerStarted && !prvGetThreadHandleByThread(pthread_self()) ) return pdFALSE;
+
 	PORT_ENTER();
 
 	xReturn = xInterruptsEnabled;
@@ -558,6 +583,8 @@ portBASE_TYPE xPortSetInterruptMask( void )
  */
 void vPortClearInterruptMask( portBASE_TYPE xMask )
 {
+	if ( xSchedulerStarted && !prvGetThreadHandleByThread(pthread_self()) ) return;
+
 	PORT_ENTER();
 
 	/**
@@ -593,6 +620,12 @@ void vPortSystemTickHandler()
 	 */
 	PORT_LOCK( xGuardMutex );
 
+	/* the scheduler is being ended, the threads are going away */
+	if ( pdTRUE == xSchedulerEnd ) {
+		PORT_UNLOCK( xGuardMutex );
+		return;
+	}
+
 	/* thread MUST be running */
 	if ( prvGetThreadHandle(xTaskGetCurrentTaskHandle())->threadStatus!=THREAD_RUNNING ) {
 		xPendYield = pdTRUE;
@@ -1035,6 +1068,33 @@ portLONG lIndex;
 }
 /*-----------------------------------------------------------*/
 
+/**
+ * wait until every task thread has left the list
+ * @returns pdTRUE if they all did before the timeout
+ */
+static portBASE_TYPE prvWaitForThreadsToExit( void )
+{
+portLONG lIndex;
+portLONG lWaited;
+struct timespec wait = { 0, 1000000 };
+
+	for ( lWaited = 0; lWaited < portEXIT_TIMEOUT_MS; lWaited++ )
+	{
+		for ( lIndex = 0; lIndex < MAX_NUMBER_OF_TASKS; lIndex++ )
+		{
+			if ( ( pthread_t )NULL != pxThreads[ lIndex ].hThread )
+				break;
+		}
+		if ( MAX_NUMBER_OF_TASKS == lIndex )
+			return pdTRUE;
+
+		nanosleep( &wait, NULL );
+	}
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
 /**
  * add a thread to the list
  */
@@ -143,6 +143,14 @@ extern void vPortAddTaskHandle( void *pxTaskHandle );
 /* Posix Signal definitions that can be changed or read as appropriate. */
 #define SIG_SUSPEND					SIGUSR1
 
+/* call nanosleep for smalles sleep time possible
+(depending on kernel settings - around 100 microseconds)
+decreases idle thread CPU load from 100 to practically 0 */
+#define portIDLE_SLEEP()			do { struct timespec x = { 1, 0 }; nanosleep( &x, NULL ); } while( 0 )
+
+/* Every task is a thread of its own and may block in a system call. */
+#define portWAIT_FOR_READABLE( iFd )
+
 /* Make use of times(man 2) to gather run-time statistics on the tasks. */
 extern void vPortFindTicksPerSecond( void );
 #undef portCONFIGURE_TIMER_FOR_RUN_TIME_STATS
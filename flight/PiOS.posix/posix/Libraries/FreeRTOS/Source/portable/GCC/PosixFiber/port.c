@@ -0,0 +1,618 @@
+/*
+	Copyright (C) 2013 Tau Labs, http://taulabs.org
+	based on the Posix port from Corvus Corax and William Davy
+
+	This file is part of the FreeRTOS.org distribution.
+
+	FreeRTOS.org is free software; you can redistribute it and/or modify it
+	under the terms of the GNU General Public License (version 2) as published
+	by the Free Software Foundation and modified by the FreeRTOS exception.
+
+	FreeRTOS.org is distributed in the hope that it will be useful,	but WITHOUT
+	ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+	FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+	more details.
+
+	You should have received a copy of the GNU General Public License along
+	with FreeRTOS.org; if not, write to the Free Software Foundation, Inc., 59
+	Temple Place, Suite 330, Boston, MA  02111-1307  USA.
+
+	A special exception to the GPL is included to allow you to distribute a
+	combined work that includes FreeRTOS.org without being obliged to provide
+	the source code for any proprietary components.  See the licensing section
+	of http://www.FreeRTOS.org for full details.
+
+	1 tab == 4 spaces!
+*/
+
+/*-----------------------------------------------------------
+ * Implementation of functions defined in portable.h for the single threaded
+ * Posix port.
+ *----------------------------------------------------------*/
+
+
+/** Description of scheduler:
+
+All FreeRTOS tasks run as fibers on the thread that starts the scheduler.
+Each task gets a ucontext with a stack of its own, and a context switch is
+a single swapcontext() - no signals, no condition variables and no mutexes
+are involved.
+
+Only one task ever runs, so the kernel data needs no locking. Critical
+sections just count their nesting per task, and "interrupts" are enabled
+when the running task is not inside one.
+
+Ticks are delivered cooperatively: the monotonic clock is checked whenever
+a task leaves a critical section or yields, and every tick that has elapsed
+is processed there. With preemption enabled this is also where a task that
+became ready through the tick takes over. A task that computes for a long
+time without calling into the kernel is therefore never preempted.
+
+When no task is ready the idle task sleeps until the next tick is due.
+Tasks must not block in system calls, as that would stop every task.
+portWAIT_FOR_READABLE() suspends the calling task until a file descriptor
+becomes readable, the descriptors are polled at each tick and while idle.
+
+Stacks are mapped with a guard page at the bottom, an overflow faults
+instead of corrupting the neighbouring stack. The stack allocated by the
+kernel for the task is unused, except for its top word which holds the
+fiber of the task so the lookup from a task handle is a single load.
+
+*/
+
+#include <ucontext.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <time.h>
+#include <sys/times.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Scheduler includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+/*-----------------------------------------------------------*/
+
+#define PORT_PRINT(...) fprintf(stderr,__VA_ARGS__)
+#define PORT_ASSERT(assertion)    if ( !(assertion) ) { PORT_PRINT("Assertion failed in %s:%i  " #assertion "\n",__FILE__,__LINE__); abort(); }
+
+/* Stack of every fiber. Pages are only committed when they are touched. */
+#ifndef portFIBER_STACK_SIZE
+#define portFIBER_STACK_SIZE			( 256 * 1024 )
+#endif
+
+/* Number of file descriptors tasks can wait on at the same time. */
+#define portMAX_FD_WAITS				16
+
+/* After a longer stall (debugger, suspended process) the missed ticks are
+dropped rather than replayed. */
+#define portMAX_TICK_CATCH_UP			100
+
+#define portNSEC_PER_SEC				1000000000L
+#define portTICK_RATE_NANOSECONDS		( portNSEC_PER_SEC / configTICK_RATE_HZ )
+/*-----------------------------------------------------------*/
+
+typedef struct FIBER
+{
+	ucontext_t xContext;
+	void *pvStack;
+	pdTASK_CODE pxCode;
+	void *pvParams;
+	unsigned portBASE_TYPE uxCriticalNesting;
+} xFiber;
+/*-----------------------------------------------------------*/
+
+/* Context of xPortStartScheduler(), resumed by vPortEndScheduler(). */
+static ucontext_t xSchedulerContext;
+
+static xFiber *pxCurrentFiber = NULL;
+
+/* A task that deleted itself, its stack is freed by the next fiber to run. */
+static xFiber *pxZombieFiber = NULL;
+
+/* Critical section depth before the scheduler got started */
+static unsigned portBASE_TYPE uxCriticalNestingBeforeStart = 0;
+
+static portBASE_TYPE xSchedulerStarted = pdFALSE;
+static portBASE_TYPE xInterruptsEnabled = pdFALSE;
+static portBASE_TYPE xInKernelHook = pdFALSE;
+static volatile portBASE_TYPE xPendYield = pdFALSE;
+static struct timespec xNextTick;
+
+static struct pollfd pxWaitFds[ portMAX_FD_WAITS ];
+static xTaskHandle pxWaitTasks[ portMAX_FD_WAITS ];
+static int iNumWaits = 0;
+/*-----------------------------------------------------------*/
+
+static void prvFiberEntry( void );
+static void prvFreeFiber( xFiber *pxFiber );
+static void prvReapZombie( void );
+static void prvSwitchContext( void );
+static void prvPreemptionPoint( void );
+static portBASE_TYPE prvProcessTicks( void );
+static portBASE_TYPE prvPollWaits( int iTimeoutMS );
+/*-----------------------------------------------------------*/
+
+/**
+ * The fiber of a task is stored at the top of the stack the kernel
+ * allocated for it, pxTopOfStack is the first member of the TCB.
+ */
+static inline xFiber *prvGetFiber( void *pxTCB )
+{
+	return ( xFiber * ) **( portSTACK_TYPE ** ) pxTCB;
+}
+
+static inline unsigned portBASE_TYPE *prvCriticalNesting( void )
+{
+	return pxCurrentFiber ? &pxCurrentFiber->uxCriticalNesting : &uxCriticalNestingBeforeStart;
+}
+
+static inline void prvAddTickPeriod( struct timespec *pxTime )
+{
+	pxTime->tv_nsec += portTICK_RATE_NANOSECONDS;
+	if ( pxTime->tv_nsec >= portNSEC_PER_SEC )
+	{
+		pxTime->tv_nsec -= portNSEC_PER_SEC;
+		pxTime->tv_sec++;
+	}
+}
+
+static inline long prvNanosecondsUntil( const struct timespec *pxNow, const struct timespec *pxTime )
+{
+	return ( pxTime->tv_sec - pxNow->tv_sec ) * portNSEC_PER_SEC + ( pxTime->tv_nsec - pxNow->tv_nsec );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Creates a new fiber, it starts running when the task is first switched in.
+ */
+portSTACK_TYPE *pxPortInitialiseStack( portSTACK_TYPE *pxTopOfStack, pdTASK_CODE pxCode, void *pvParameters )
+{
+	xFiber *pxFiber = pvPortMalloc( sizeof( xFiber ) );
+	PORT_ASSERT( pxFiber );
+
+	pxFiber->pvStack = mmap( NULL, portFIBER_STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	PORT_ASSERT( pxFiber->pvStack != MAP_FAILED );
+	/* Guard page */
+	PORT_ASSERT( 0 == mprotect( pxFiber->pvStack, getpagesize(), PROT_NONE ) );
+
+	pxFiber->pxCode = pxCode;
+	pxFiber->pvParams = pvParameters;
+	pxFiber->uxCriticalNesting = 0;
+
+	PORT_ASSERT( 0 == getcontext( &pxFiber->xContext ) );
+	pxFiber->xContext.uc_stack.ss_sp = pxFiber->pvStack;
+	pxFiber->xContext.uc_stack.ss_size = portFIBER_STACK_SIZE;
+	pxFiber->xContext.uc_link = NULL;
+	makecontext( &pxFiber->xContext, prvFiberEntry, 0 );
+
+	*pxTopOfStack = ( portSTACK_TYPE ) pxFiber;
+	return pxTopOfStack;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Switches to the first task. Returns when vPortEndScheduler() is called.
+ */
+portBASE_TYPE xPortStartScheduler( void )
+{
+	clock_gettime( CLOCK_MONOTONIC, &xNextTick );
+	prvAddTickPeriod( &xNextTick );
+
+	xSchedulerStarted = pdTRUE;
+	pxCurrentFiber = prvGetFiber( xTaskGetCurrentTaskHandle() );
+
+	PORT_ASSERT( 0 == swapcontext( &xSchedulerContext, &pxCurrentFiber->xContext ) );
+
+	PORT_PRINT( "Cleaning Up, Exiting.\n" );
+	pxCurrentFiber = NULL;
+	xSchedulerStarted = pdFALSE;
+
+	return 0;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Leaves the running task and returns from xPortStartScheduler()
+ */
+void vPortEndScheduler( void )
+{
+	if ( xSchedulerStarted != pdTRUE || pxCurrentFiber == NULL )
+		return;
+
+	PORT_ASSERT( 0 == swapcontext( &pxCurrentFiber->xContext, &xSchedulerContext ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Only threads outside of the scheduler (or signal handlers) can get here,
+ * the switch happens at the next preemption point.
+ */
+void vPortYieldFromISR( void )
+{
+	xPendYield = pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * enter a critical section (public)
+ */
+void vPortEnterCritical( void )
+{
+	xInterruptsEnabled = pdFALSE;
+	( *prvCriticalNesting() )++;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * leave a critical section (public)
+ */
+void vPortExitCritical( void )
+{
+	unsigned portBASE_TYPE *puxNesting = prvCriticalNesting();
+
+	/* Check for unmatched exits. */
+	PORT_ASSERT( *puxNesting > 0 );
+	if ( *puxNesting > 0 )
+	{
+		( *puxNesting )--;
+	}
+
+	/* If we have reached 0 then re-enable the interrupts. */
+	if ( *puxNesting == 0 )
+	{
+		xInterruptsEnabled = pdTRUE;
+		prvPreemptionPoint();
+	}
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * public yield function
+ */
+void vPortYield( void )
+{
+	if ( xInKernelHook == pdTRUE )
+	{
+		xPendYield = pdTRUE;
+		return;
+	}
+
+	xInKernelHook = pdTRUE;
+	xPendYield = pdFALSE;
+	if ( xInterruptsEnabled == pdTRUE )
+	{
+		prvProcessTicks();
+	}
+	xInKernelHook = pdFALSE;
+
+	prvSwitchContext();
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * public function to disable interrupts
+ */
+void vPortDisableInterrupts( void )
+{
+	xInterruptsEnabled = pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * public function to enable interrupts
+ */
+void vPortEnableInterrupts( void )
+{
+	/**
+	 * It is bad practice to enable interrupts explicitly while in a critical section
+	 * most likely this is a bug - better prevent the userspace from being stupid
+	 */
+	PORT_ASSERT( *prvCriticalNesting() == 0 );
+
+	xInterruptsEnabled = pdTRUE;
+	prvPreemptionPoint();
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * set and clear interrupt masks are used by FreeRTOS to enter and leave critical sections
+ * with unknown nexting level - but we DO know the nesting level
+ */
+portBASE_TYPE xPortSetInterruptMask( void )
+{
+	portBASE_TYPE xReturn = xInterruptsEnabled;
+
+	xInterruptsEnabled = pdFALSE;
+	( *prvCriticalNesting() )++;
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * sets the "interrupt mask back to a stored setting
+ */
+void vPortClearInterruptMask( portBASE_TYPE xMask )
+{
+	unsigned portBASE_TYPE *puxNesting = prvCriticalNesting();
+
+	PORT_ASSERT( xMask == pdTRUE || xMask == pdFALSE );
+
+	if ( *puxNesting > 0 )
+	{
+		( *puxNesting )--;
+	}
+
+	xInterruptsEnabled = xMask;
+	if ( xInterruptsEnabled == pdTRUE )
+	{
+		prvPreemptionPoint();
+	}
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * The task is done with the kernel data, deliver the ticks that elapsed
+ * and switch if a higher priority task became ready.
+ */
+static void prvPreemptionPoint( void )
+{
+	portBASE_TYPE xSwitchRequired;
+
+	if ( xSchedulerStarted != pdTRUE || xInKernelHook == pdTRUE )
+		return;
+
+	xInKernelHook = pdTRUE;
+	xSwitchRequired = prvProcessTicks();
+	if ( xPendYield == pdTRUE )
+	{
+		xPendYield = pdFALSE;
+		xSwitchRequired = pdTRUE;
+	}
+	xInKernelHook = pdFALSE;
+
+	if ( xSwitchRequired == pdTRUE )
+	{
+		prvSwitchContext();
+	}
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Run the tick handler for every tick period that has elapsed.
+ * @returns pdTRUE if a context switch is required
+ */
+static portBASE_TYPE prvProcessTicks( void )
+{
+	struct timespec xNow;
+	portBASE_TYPE xTicks = 0;
+	portBASE_TYPE xSwitchRequired = pdFALSE;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	while ( prvNanosecondsUntil( &xNow, &xNextTick ) <= 0 )
+	{
+		if ( ++xTicks > portMAX_TICK_CATCH_UP )
+		{
+			/* Drop the rest */
+			xNextTick = xNow;
+			prvAddTickPeriod( &xNextTick );
+			break;
+		}
+
+		vTaskIncrementTick();
+		prvAddTickPeriod( &xNextTick );
+	}
+
+	if ( xTicks > 0 )
+	{
+#if ( configUSE_PREEMPTION == 1 )
+		xSwitchRequired = pdTRUE;
+#endif
+		if ( iNumWaits > 0 && prvPollWaits( 0 ) )
+		{
+			xSwitchRequired = pdTRUE;
+		}
+	}
+
+	return xSwitchRequired;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Let the kernel select the task to run and switch to its fiber
+ */
+static void prvSwitchContext( void )
+{
+	xFiber *pxFrom = pxCurrentFiber;
+	xFiber *pxTo;
+
+	vTaskSwitchContext();
+	pxTo = prvGetFiber( xTaskGetCurrentTaskHandle() );
+
+	if ( pxTo == pxFrom )
+	{
+		xInterruptsEnabled = ( pxFrom->uxCriticalNesting == 0 );
+		return;
+	}
+
+	pxCurrentFiber = pxTo;
+	PORT_ASSERT( 0 == swapcontext( &pxFrom->xContext, &pxTo->xContext ) );
+
+	/* Switched back in */
+	prvReapZombie();
+	xInterruptsEnabled = ( pxCurrentFiber->uxCriticalNesting == 0 );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * First code run by every fiber
+ */
+static void prvFiberEntry( void )
+{
+	xFiber *pxSelf = pxCurrentFiber;
+
+	prvReapZombie();
+	xInterruptsEnabled = pdTRUE;
+
+	pxSelf->pxCode( pxSelf->pvParams );
+
+	/* Tasks must not return */
+	PORT_PRINT( "Task returned, deleting it.\n" );
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFreeFiber( xFiber *pxFiber )
+{
+	munmap( pxFiber->pvStack, portFIBER_STACK_SIZE );
+	vPortFree( pxFiber );
+}
+
+static void prvReapZombie( void )
+{
+	xFiber *pxZombie = pxZombieFiber;
+
+	/* Taken first, vPortFree() can switch to a fiber that reaps too */
+	if ( pxZombie != NULL && pxZombie != pxCurrentFiber )
+	{
+		pxZombieFiber = NULL;
+		prvFreeFiber( pxZombie );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Called by the kernel when a task is deleted
+ */
+void vPortForciblyEndThread( void *pxTaskToDelete )
+{
+	xFiber *pxFiber = prvGetFiber( pxTaskToDelete );
+
+	if ( pxFiber == pxCurrentFiber )
+	{
+		/* Still running on that stack, the kernel switches away next */
+		PORT_ASSERT( pxZombieFiber == NULL );
+		pxZombieFiber = pxFiber;
+	}
+	else
+	{
+		prvFreeFiber( pxFiber );
+	}
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Poll the descriptors tasks are waiting on and resume the tasks whose
+ * descriptor became readable.
+ * @returns pdTRUE if a task was resumed
+ */
+static portBASE_TYPE prvPollWaits( int iTimeoutMS )
+{
+	portBASE_TYPE xResumed = pdFALSE;
+	int iIndex;
+
+	if ( poll( pxWaitFds, iNumWaits, iTimeoutMS ) <= 0 )
+		return pdFALSE;
+
+	for ( iIndex = iNumWaits - 1; iIndex >= 0; iIndex-- )
+	{
+		if ( pxWaitFds[ iIndex ].revents != 0 )
+		{
+			vTaskResume( pxWaitTasks[ iIndex ] );
+			xResumed = pdTRUE;
+
+			iNumWaits--;
+			pxWaitFds[ iIndex ] = pxWaitFds[ iNumWaits ];
+			pxWaitTasks[ iIndex ] = pxWaitTasks[ iNumWaits ];
+		}
+	}
+
+	return xResumed;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Suspend the calling task until the descriptor is readable
+ */
+void vPortWaitForReadable( int iFd )
+{
+	struct pollfd xFd = { .fd = iFd, .events = POLLIN };
+
+	if ( poll( &xFd, 1, 0 ) > 0 )
+		return;
+
+	PORT_ASSERT( iNumWaits < portMAX_FD_WAITS );
+	pxWaitFds[ iNumWaits ].fd = iFd;
+	pxWaitFds[ iNumWaits ].events = POLLIN;
+	pxWaitFds[ iNumWaits ].revents = 0;
+	pxWaitTasks[ iNumWaits ] = xTaskGetCurrentTaskHandle();
+	iNumWaits++;
+
+	vTaskSuspend( NULL );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * Called by the idle task, sleep until the next tick or until a waited on
+ * descriptor is readable.
+ */
+void vPortIdleSleep( void )
+{
+	struct timespec xNow;
+	long lWaitNS;
+
+	clock_gettime( CLOCK_MONOTONIC, &xNow );
+	lWaitNS = prvNanosecondsUntil( &xNow, &xNextTick );
+
+	if ( lWaitNS > 0 )
+	{
+		if ( iNumWaits > 0 )
+		{
+			xInKernelHook = pdTRUE;
+			prvPollWaits( ( lWaitNS + 999999 ) / 1000000 );
+			xInKernelHook = pdFALSE;
+		}
+		else
+		{
+			struct timespec xWait = { .tv_sec = 0, .tv_nsec = lWaitNS };
+			nanosleep( &xWait, NULL );
+		}
+	}
+
+	prvPreemptionPoint();
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * find out system speed
+ */
+void vPortFindTicksPerSecond( void )
+{
+	/* Needs to be reasonably high for accuracy. */
+	unsigned long ulTicksPerSecond = sysconf(_SC_CLK_TCK);
+	PORT_PRINT( "Timer Resolution for Run TimeStats is %ld ticks per second.\n", ulTicksPerSecond );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * timer stuff
+ */
+unsigned long ulPortGetTimerValue( void )
+{
+struct tms xTimes;
+	unsigned long ulTotalTime = times( &xTimes );
+	/* Return the application code times.
+	 * The timer only increases when the application code is actually running
+	 * which means that the total execution times should add up to 100%.
+	 */
+	return ( unsigned long ) xTimes.tms_utime;
+
+	/* Should check ulTotalTime for being clock_t max minus 1. */
+	(void)ulTotalTime;
+}
+/*-----------------------------------------------------------*/
@@ -66,11 +66,16 @@ ARCHFLAGS			+= -DARCH_POSIX
 # If the application has included the generic FreeRTOS support, then add in
 # the device-specific pieces of the code.
 #
+# Posix runs every task as a thread of its own, PosixFiber runs all of them
+# as fibers on a single thread.
+#
+FREERTOS_POSIX_PORT	?=	Posix
+
 ifneq ($(FREERTOS_DIR),)
 FREERTOS_PORTDIR	:=	$(PIOS_DEVLIB)/Libraries/FreeRTOS/Source
-SRC					+=	$(wildcard $(FREERTOS_PORTDIR)/portable/GCC/Posix/*.c)
+SRC					+=	$(wildcard $(FREERTOS_PORTDIR)/portable/GCC/$(FREERTOS_POSIX_PORT)/*.c)
 SRC					+=	$(wildcard $(FREERTOS_PORTDIR)/portable/MemMang/*.c)
 
-EXTRAINCDIRS		+=	$(FREERTOS_PORTDIR)/portable/GCC/Posix
+EXTRAINCDIRS		+=	$(FREERTOS_PORTDIR)/portable/GCC/$(FREERTOS_POSIX_PORT)
 endif
 
@@ -45,6 +45,12 @@
 */
 #include <time.h>
 
+#if defined(PIOS_SIM_REPLAY) || defined(PIOS_SIM_LOCKSTEP)
+//! When replaying a log or stepping with the GCS the clock follows the
+//! timestamps of the log or of the steps
+static volatile uint32_t sim_time_us;
+#endif
+
 int32_t PIOS_DELAY_Init(void)
 {
 	// stub
@@ -109,6 +115,9 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
  */
 uint32_t PIOS_DELAY_GetuS()
 {
+#if defined(PIOS_SIM_REPLAY) || defined(PIOS_SIM_LOCKSTEP)
+	return sim_time_us;
+#else
 	static struct timespec current;
 
 #ifdef __MACH__ // OS X does not have clock_gettime, use clock_get_time
@@ -123,7 +132,24 @@ uint32_t PIOS_DELAY_GetuS()
 	clock_gettime(CLOCK_REALTIME, &current);
 #endif	
 	return ((current.tv_sec * 1000000) + (current.tv_nsec / 1000));
+#endif /* PIOS_SIM_REPLAY || PIOS_SIM_LOCKSTEP */
+}
+
+#if defined(PIOS_SIM_REPLAY) || defined(PIOS_SIM_LOCKSTEP)
+/**
+ * @brief Set the time returned by the delay timer
+ * @param[in] uS The time in microseconds
+ *
+ * Used by the log replay and the HITL lockstep so that every loop computes
+ * its time step from the recorded timestamps or the simulator steps instead
+ * of the wall clock, which makes runs repeatable no matter how fast the host
+ * replays the log or the simulator steps.
+ */
+void PIOS_DELAY_SetuS(uint32_t uS)
+{
+	sim_time_us = uS;
 }
+#endif /* PIOS_SIM_REPLAY || PIOS_SIM_LOCKSTEP */
 
 /**
  * @brief Calculate time in microseconds since a previous time
@@ -0,0 +1,258 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SCRIPTRCVR Scripted receiver for the simulator
+ * @brief Plays back receiver frames from a text file
+ * @{
+ *
+ * @file       pios_scriptrcvr.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @brief      Scripted receiver for the posix simulator
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * The script is a text file with one step per line:
+ *
+ *   # comment
+ *   frame <period_ms>
+ *   <time_ms> <ch1> <ch2> ... <chN>
+ *
+ * From <time_ms> after start on, every frame carries the channel values of
+ * the line, channels that are not given keep their previous value. Frames
+ * are sent every <period_ms> (default 20) and signalled to PIOS_RCVR like
+ * the frames of a real serial receiver. After the last line the receiver
+ * goes silent, so the end of a script exercises the failsafe.
+ */
+
+/* Project Includes */
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_SCRIPTRCVR)
+
+#include <stdio.h>
+#include "pios_scriptrcvr_priv.h"
+
+#define SCRIPTRCVR_MAX_STEPS      256
+#define SCRIPTRCVR_FRAME_MS        20
+#define SCRIPTRCVR_TIMEOUT_MS     100
+
+/* Provide a RCVR driver */
+static int32_t PIOS_SCRIPTRCVR_Get(uintptr_t rcvr_id, uint8_t channel);
+
+const struct pios_rcvr_driver pios_scriptrcvr_rcvr_driver = {
+	.read = PIOS_SCRIPTRCVR_Get,
+};
+
+/* Local Variables */
+enum pios_scriptrcvr_dev_magic {
+	PIOS_SCRIPTRCVR_DEV_MAGIC = 0x5c417c0d,
+};
+
+struct pios_scriptrcvr_step {
+	uint32_t time_ms;
+	uint8_t num_channels;
+	uint16_t channels[PIOS_SCRIPTRCVR_NUM_INPUTS];
+};
+
+struct pios_scriptrcvr_dev {
+	enum pios_scriptrcvr_dev_magic magic;
+
+	xTaskHandle task;
+	uint32_t frame_ms;
+	uint16_t num_steps;
+	struct pios_scriptrcvr_step *steps;
+
+	volatile uint16_t channels[PIOS_SCRIPTRCVR_NUM_INPUTS];
+	volatile uint32_t last_frame_ms;
+	volatile bool running;
+};
+
+static bool PIOS_SCRIPTRCVR_Validate(struct pios_scriptrcvr_dev *scriptrcvr_dev)
+{
+	return (scriptrcvr_dev->magic == PIOS_SCRIPTRCVR_DEV_MAGIC);
+}
+
+/**
+ * Parse the script into steps
+ * \return the number of steps, -1 on error
+ */
+static int32_t PIOS_SCRIPTRCVR_Load(struct pios_scriptrcvr_dev *scriptrcvr_dev, const char *script)
+{
+	FILE *f = fopen(script, "r");
+	if (!f) {
+		fprintf(stderr, "scriptrcvr: cannot open %s\n", script);
+		return -1;
+	}
+
+	char line[256];
+	uint32_t line_no = 0;
+	while (fgets(line, sizeof(line), f)) {
+		line_no++;
+
+		char *p = line;
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0')
+			continue;
+
+		unsigned int value;
+		if (sscanf(p, "frame %u", &value) == 1) {
+			scriptrcvr_dev->frame_ms = value ? value : SCRIPTRCVR_FRAME_MS;
+			continue;
+		}
+
+		if (scriptrcvr_dev->num_steps >= SCRIPTRCVR_MAX_STEPS) {
+			fprintf(stderr, "scriptrcvr: %s:%u: too many steps\n", script, line_no);
+			break;
+		}
+
+		struct pios_scriptrcvr_step *step = &scriptrcvr_dev->steps[scriptrcvr_dev->num_steps];
+		int consumed;
+		if (sscanf(p, "%u%n", &value, &consumed) != 1) {
+			fprintf(stderr, "scriptrcvr: %s:%u: parse error\n", script, line_no);
+			fclose(f);
+			return -1;
+		}
+		step->time_ms = value;
+		step->num_channels = 0;
+		p += consumed;
+		while (step->num_channels < PIOS_SCRIPTRCVR_NUM_INPUTS &&
+		       sscanf(p, "%u%n", &value, &consumed) == 1) {
+			step->channels[step->num_channels++] = value;
+			p += consumed;
+		}
+
+		scriptrcvr_dev->num_steps++;
+	}
+
+	fclose(f);
+	return scriptrcvr_dev->num_steps;
+}
+
+static void PIOS_SCRIPTRCVR_Task(void *parameters)
+{
+	struct pios_scriptrcvr_dev *scriptrcvr_dev = (struct pios_scriptrcvr_dev *)parameters;
+
+	portTickType start_time = xTaskGetTickCount();
+	portTickType last_time = start_time;
+	uint16_t next_step = 0;
+
+	while (1) {
+		uint32_t now_ms = TICKS2MS(xTaskGetTickCount() - start_time);
+
+		/* Apply all the steps that are due */
+		while (next_step < scriptrcvr_dev->num_steps &&
+		       scriptrcvr_dev->steps[next_step].time_ms <= now_ms) {
+			const struct pios_scriptrcvr_step *step = &scriptrcvr_dev->steps[next_step++];
+			for (uint8_t i = 0; i < step->num_channels; i++)
+				scriptrcvr_dev->channels[i] = step->channels[i];
+			scriptrcvr_dev->running = true;
+		}
+
+		/* The last step ends the script */
+		if (next_step == scriptrcvr_dev->num_steps && scriptrcvr_dev->running &&
+		    now_ms >= scriptrcvr_dev->steps[next_step - 1].time_ms + scriptrcvr_dev->frame_ms) {
+			scriptrcvr_dev->running = false;
+			fprintf(stderr, "scriptrcvr: script finished at %u ms\n", now_ms);
+			break;
+		}
+
+		if (scriptrcvr_dev->running) {
+			scriptrcvr_dev->last_frame_ms = TICKS2MS(xTaskGetTickCount());
+			PIOS_RCVR_Active();
+		}
+
+		vTaskDelayUntil(&last_time, MS2TICKS(scriptrcvr_dev->frame_ms));
+	}
+
+	vTaskDelete(NULL);
+}
+
+/**
+ * Load a receiver script and start playing it back
+ * \param[out] scriptrcvr_id the receiver handle
+ * \param[in] script the path of the script file
+ * \return 0 on success, -1 if the script could not be loaded
+ */
+int32_t PIOS_SCRIPTRCVR_Init(uintptr_t *scriptrcvr_id, const char *script)
+{
+	PIOS_DEBUG_Assert(scriptrcvr_id);
+
+	struct pios_scriptrcvr_dev *scriptrcvr_dev;
+
+	scriptrcvr_dev = (struct pios_scriptrcvr_dev *)pvPortMalloc(sizeof(*scriptrcvr_dev));
+	if (!scriptrcvr_dev)
+		return -1;
+	memset(scriptrcvr_dev, 0, sizeof(*scriptrcvr_dev));
+
+	scriptrcvr_dev->magic = PIOS_SCRIPTRCVR_DEV_MAGIC;
+	scriptrcvr_dev->frame_ms = SCRIPTRCVR_FRAME_MS;
+	scriptrcvr_dev->steps = (struct pios_scriptrcvr_step *)pvPortMalloc(SCRIPTRCVR_MAX_STEPS * sizeof(struct pios_scriptrcvr_step));
+	if (!scriptrcvr_dev->steps)
+		goto out_fail;
+
+	if (PIOS_SCRIPTRCVR_Load(scriptrcvr_dev, script) <= 0)
+		goto out_fail;
+
+	for (uint8_t i = 0; i < PIOS_SCRIPTRCVR_NUM_INPUTS; i++)
+		scriptrcvr_dev->channels[i] = PIOS_RCVR_TIMEOUT;
+
+	xTaskCreate(PIOS_SCRIPTRCVR_Task, (signed char *)"ScriptRcvr", 1024, (void *)scriptrcvr_dev, 3, &scriptrcvr_dev->task);
+
+	fprintf(stderr, "scriptrcvr: playing %u steps from %s, %u ms frames\n",
+		scriptrcvr_dev->num_steps, script, scriptrcvr_dev->frame_ms);
+
+	*scriptrcvr_id = (uintptr_t)scriptrcvr_dev;
+	return 0;
+
+out_fail:
+	if (scriptrcvr_dev->steps)
+		vPortFree(scriptrcvr_dev->steps);
+	vPortFree(scriptrcvr_dev);
+	return -1;
+}
+
+static int32_t PIOS_SCRIPTRCVR_Get(uintptr_t rcvr_id, uint8_t channel)
+{
+	struct pios_scriptrcvr_dev *scriptrcvr_dev = (struct pios_scriptrcvr_dev *)rcvr_id;
+
+	if (!PIOS_SCRIPTRCVR_Validate(scriptrcvr_dev))
+		return PIOS_RCVR_NODRIVER;
+
+	if (channel >= PIOS_SCRIPTRCVR_NUM_INPUTS) {
+		/* channel is out of range */
+		return PIOS_RCVR_INVALID;
+	}
+
+	/* Like a real receiver, time out when the frames stop */
+	uint32_t now_ms = TICKS2MS(xTaskGetTickCount());
+	if (!scriptrcvr_dev->running && now_ms - scriptrcvr_dev->last_frame_ms > SCRIPTRCVR_TIMEOUT_MS)
+		return PIOS_RCVR_TIMEOUT;
+
+	return scriptrcvr_dev->channels[channel];
+}
+
+#endif	/* PIOS_INCLUDE_SCRIPTRCVR */
+
+/**
+  * @}
+  * @}
+  */
@@ -37,6 +37,19 @@ int PIOS_SIM_Step(float dT)
 	return 0;
 }
 
+/**
+ * Hand the actuators set since the last step back to the model, for models
+ * that wait for the outputs of the control loop before the next step
+ * @returns 0 for success, -1 for failure to send them to the external library
+ */
+int PIOS_SIM_Commit()
+{
+	if (sim_model_commit(&pios_sim_state) != 0)
+		return -1;
+
+	return 0;
+}
+
 /**
  * Set the actuator inputs to the model
  * @param[in] actuator pointer to an array of actuators to set
@@ -68,6 +81,26 @@ void PIOS_SIM_GetGyros(float * gyros)
 		gyros[i] = pios_sim_state.gyros[i];
 }
 
+/**
+ * Get the magnetometer data from the simulation model
+ * @param[out] mag pointer to store the magnetometer data in
+ */
+void PIOS_SIM_GetMag(float * mag)
+{
+	for (int i = 0; i < NELEMENTS(pios_sim_state.mag); i++)
+		mag[i] = pios_sim_state.mag[i];
+}
+
+/**
+ * Get the barometric altitude from the simulation model
+ * @param[out] baro pointer to store the altitude in
+ */
+void PIOS_SIM_GetBaro(float * baro)
+{
+	for (int i = 0; i < NELEMENTS(pios_sim_state.baro); i++)
+		baro[i] = pios_sim_state.baro[i];
+}
+
 /**
  * Get the current attitude from the simulation model
  * @param[out] quat pointer to store the quaternion attitude in
@@ -115,3 +148,9 @@ int sim_model_step(float dT, struct pios_sim_state *pios_sim_state)
 {
 	return 0;
 }
+
+int sim_model_commit(struct pios_sim_state *pios_sim_state) __attribute__((weak));
+int sim_model_commit(struct pios_sim_state *pios_sim_state)
+{
+	return 0;
+}
@@ -0,0 +1,167 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_sim_lockstep.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @brief      Simulation model backed by the GCS HITL bridge in lockstep mode
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   PIOS_SIM Simulation model
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * Provides sim_model_init(), sim_model_step() and sim_model_commit() in place
+ * of the weak versions in pios_sim.c. Each PIOS_SIM_Step() blocks until the
+ * GCS sends the sensor frame of the next step and advances the delay timer by
+ * the step time, then PIOS_SIM_Commit() answers that same frame with the
+ * actuators the control loop computed from it. The GCS only sends the next
+ * frame once it has the answer, so the flight side runs exactly one control
+ * loop per simulator step however fast either side is.
+ */
+
+#include "pios.h"
+
+#if defined(PIOS_SIM_LOCKSTEP)
+
+#include "pios_sim_priv.h"
+#include "sim_model.h"
+#include "hitl_lockstep.h"
+
+#include <math.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#ifndef PIOS_SIM_LOCKSTEP_PORT
+#define PIOS_SIM_LOCKSTEP_PORT HITL_LOCKSTEP_DEFAULT_PORT
+#endif
+
+static int lockstep_socket = -1;
+static struct sockaddr_in lockstep_peer;
+//! Step of the frame being answered, zero before the first one
+static uint32_t lockstep_step;
+//! The last answer, sent again if the GCS repeats its frame
+static struct hitl_lockstep_actuators lockstep_reply;
+static uint32_t lockstep_time_us;
+
+/**
+ * Open the lockstep socket
+ * @returns 0 for success, -1 if the socket could not be bound
+ */
+int sim_model_init(void)
+{
+	struct sockaddr_in local;
+
+	lockstep_socket = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (lockstep_socket < 0)
+		return -1;
+
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(PIOS_SIM_LOCKSTEP_PORT);
+	if (bind(lockstep_socket, (struct sockaddr *) &local, sizeof(local)) != 0)
+		return -1;
+
+	printf("HITL lockstep listening on port %d\n", PIOS_SIM_LOCKSTEP_PORT);
+
+	return 0;
+}
+
+/**
+ * Wait for the sensor frame of the next step from the GCS
+ *
+ * The threaded posix port cannot wait for a socket without stalling the
+ * scheduler, the socket is polled once per tick there instead.
+ * @returns 0 once a new frame was applied
+ */
+int sim_model_step(float dT, struct pios_sim_state *state)
+{
+	struct hitl_lockstep_sensors frame;
+	struct sockaddr_in peer;
+
+	while (1) {
+		portWAIT_FOR_READABLE(lockstep_socket);
+		socklen_t peer_len = sizeof(peer);
+		ssize_t received = recvfrom(lockstep_socket, &frame, sizeof(frame), MSG_DONTWAIT,
+				(struct sockaddr *) &peer, &peer_len);
+
+		if (received < 0) {
+			vTaskDelay(1);
+			continue;
+		}
+
+		if (received != sizeof(frame) || frame.magic != HITL_LOCKSTEP_SENSORS_MAGIC)
+			continue;
+
+		// The GCS repeats a frame when the answer got lost, do not step twice
+		if (lockstep_step != 0 && frame.step == lockstep_step) {
+			sendto(lockstep_socket, &lockstep_reply, sizeof(lockstep_reply), 0,
+					(struct sockaddr *) &peer, sizeof(peer));
+			continue;
+		}
+
+		break;
+	}
+
+	lockstep_peer = peer;
+	lockstep_step = frame.step;
+
+	memcpy(state->accels, frame.accels, sizeof(state->accels));
+	memcpy(state->gyros, frame.gyros, sizeof(state->gyros));
+	memcpy(state->mag, frame.mag, sizeof(state->mag));
+	memcpy(state->baro, frame.baro, sizeof(state->baro));
+	memcpy(state->q, frame.q, sizeof(state->q));
+	memcpy(state->velocity, frame.velocity, sizeof(state->velocity));
+	memcpy(state->position, frame.position, sizeof(state->position));
+
+	// The loops compute their time step from the simulator steps
+	lockstep_time_us += lrintf(frame.dT * 1e6f);
+	PIOS_DELAY_SetuS(lockstep_time_us);
+
+	return 0;
+}
+
+/**
+ * Answer the frame of the current step with the actuators
+ * @returns 0 for success, -1 if there is no step to answer or the answer
+ * could not be sent
+ */
+int sim_model_commit(struct pios_sim_state *state)
+{
+	if (lockstep_step == 0)
+		return -1;
+
+	lockstep_reply.magic = HITL_LOCKSTEP_ACTUATORS_MAGIC;
+	lockstep_reply.step = lockstep_step;
+	for (int i = 0; i < HITL_LOCKSTEP_NUM_ACTUATORS; i++)
+		lockstep_reply.actuator[i] = i < NELEMENTS(state->actuator) ? state->actuator[i] : 0;
+
+	if (sendto(lockstep_socket, &lockstep_reply, sizeof(lockstep_reply), 0,
+			(struct sockaddr *) &lockstep_peer, sizeof(lockstep_peer)) != sizeof(lockstep_reply))
+		return -1;
+
+	return 0;
+}
+
+#endif /* PIOS_SIM_LOCKSTEP */
+
+/**
+ * @}
+ */
@@ -95,6 +95,7 @@ void PIOS_UDP_RxThread(void * udp_dev_n)
 		 * receive 
 		 */
 		int received;
+		portWAIT_FOR_READABLE(udp_dev->socket);
 		udp_dev->clientLength=sizeof(udp_dev->client);
 		if ((received = recvfrom(udp_dev->socket,
 				&udp_dev->rx_buffer,
@@ -1162,6 +1162,19 @@ unsigned portBASE_TYPE uxTaskGetStackHighWaterMark( xTaskHandle xTask ) PRIVILEG
  */
 unsigned portBASE_TYPE uxTaskGetRunTime( xTaskHandle xTask );
 
+/**
+ * task.h
+ * <PRE>unsigned portBASE_TYPE uxTaskGetRunTimeCounter( xTaskHandle xTask );</PRE>
+ *
+ * Returns the run time of selected task without resetting it, including the
+ * current time slice if it is the running task
+ *
+ * @param xTask Handle of the task. Set xTask to NULL for the calling task.
+ *
+ * @return The run time of selected task
+ */
+unsigned portBASE_TYPE uxTaskGetRunTimeCounter( xTaskHandle xTask );
+
 /* When using trace macros it is sometimes necessary to include tasks.h before
 FreeRTOS.h.  When this is done pdTASK_HOOK_CODE will not yet have been defined,
 so the following two prototypes will cause a compilation error.  This can be
@@ -2570,6 +2570,30 @@ tskTCB *pxNewTCB;
 		return runTime;
 	}
 
+	unsigned portBASE_TYPE uxTaskGetRunTimeCounter( xTaskHandle xTask )
+	{
+		unsigned long runTime;
+
+		tskTCB *pxTCB;
+		portENTER_CRITICAL();
+		{
+			pxTCB = prvGetTCBFromHandle( xTask );
+			runTime = pxTCB->ulRunTimeCounter;
+
+			#if ( configGENERATE_RUN_TIME_STATS == 1 )
+			{
+				/* The running task is only credited when it is switched out */
+				if( pxTCB == pxCurrentTCB )
+				{
+					runTime += portGET_RUN_TIME_COUNTER_VALUE() - ulTaskSwitchedInTime;
+				}
+			}
+			#endif
+		}
+		portEXIT_CRITICAL();
+		return runTime;
+	}
+
 #endif
 /*-----------------------------------------------------------*/
 
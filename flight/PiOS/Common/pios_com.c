@@ -80,6 +80,7 @@ static struct pios_com_dev * PIOS_COM_alloc(void)
 }
 
 static uint16_t PIOS_COM_TxOutCallback(uintptr_t context, uint8_t * buf, uint16_t buf_len, uint16_t * headroom, bool * need_yield);
+static uint16_t PIOS_COM_TxSpanCallback(uintptr_t context, uint8_t ** buf, uint16_t sent, bool * need_yield);
 static uint16_t PIOS_COM_RxInCallback(uintptr_t context, uint8_t * buf, uint16_t buf_len, uint16_t * headroom, bool * need_yield);
 static void PIOS_COM_UnblockRx(struct pios_com_dev * com_dev, bool * need_yield);
 static void PIOS_COM_UnblockTx(struct pios_com_dev * com_dev, bool * need_yield);
@@ -132,6 +133,10 @@ int32_t PIOS_COM_Init(uintptr_t * com_id, const struct pios_com_driver * driver,
 		vSemaphoreCreateBinary(com_dev->tx_sem);
 #endif	/* PIOS_INCLUDE_FREERTOS */
 		(com_dev->driver->bind_tx_cb)(lower_id, PIOS_COM_TxOutCallback, (uintptr_t)com_dev);
+		if (com_dev->driver->bind_tx_span_cb) {
+			/* The driver can also send straight out of the fifo */
+			(com_dev->driver->bind_tx_span_cb)(lower_id, PIOS_COM_TxSpanCallback, (uintptr_t)com_dev);
+		}
 	}
 
 	*com_id = (uintptr_t)com_dev;
@@ -219,6 +224,31 @@ static uint16_t PIOS_COM_TxOutCallback(uintptr_t context, uint8_t * buf, uint16_
 	return (bytes_from_fifo);
 }
 
+static uint16_t PIOS_COM_TxSpanCallback(uintptr_t context, uint8_t ** buf, uint16_t sent, bool * need_yield)
+{
+	struct pios_com_dev * com_dev = (struct pios_com_dev *)context;
+
+	bool valid = PIOS_COM_validate(com_dev);
+	PIOS_Assert(valid);
+	PIOS_Assert(buf);
+	PIOS_Assert(com_dev->has_tx);
+
+	if (sent > 0) {
+		/* The driver is done with these bytes, make room for more */
+		fifoBuf_removeData(&com_dev->tx, sent);
+		PIOS_COM_UnblockTx(com_dev, need_yield);
+	} else {
+		*need_yield = false;
+	}
+
+	/* Only the part up to the end of the buffer, the rest comes next call */
+	t_fifo_span span;
+	fifoBuf_peek(&com_dev->tx, &span);
+
+	*buf = span.ptr[0];
+	return span.len[0];
+}
+
 /**
 * Change the port speed without re-initializing
 * \param[in] port COM port
@@ -356,6 +386,101 @@ int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t le
 	return len;
 }
 
+/**
+* Get room to build a message directly in the transmit buffer, saving the
+* copy into it. Nothing is sent until PIOS_COM_SendCommit, and the caller
+* must be the only one sending on the port in between.
+*
+* The room has to be contiguous. When the free space wraps around the end
+* of the buffer this returns NULL even if PIOS_COM_GetTxFree() says the
+* message would fit, so a NULL is not a full buffer: the caller must build
+* the message elsewhere and send it with PIOS_COM_SendBuffer or
+* PIOS_COM_SendBufferNonBlocking, which copy across the wrap.
+* \param[in] port COM port
+* \param[in] len message length
+* \return pointer to len contiguous free bytes
+* \return NULL if the port is not available or there is not that much
+*         contiguous room right now, send through the copying calls
+*/
+uint8_t *PIOS_COM_SendReserve(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev * com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		return NULL;
+	}
+
+	PIOS_Assert(com_dev->has_tx);
+
+	/* Let PIOS_COM_SendBuffer deal with a device that went away */
+	if (com_dev->driver->available && !com_dev->driver->available(com_dev->lower_id)) {
+		return NULL;
+	}
+
+	t_fifo_span span;
+	fifoBuf_reserve(&com_dev->tx, &span);
+
+	/* Messages are built contiguously, so the wrapped part is not used */
+	if (len == 0 || span.len[0] < len) {
+		return NULL;
+	}
+
+	return span.ptr[0];
+}
+
+/**
+* Get the free space in the transmit buffer
+* \param[in] port COM port
+* \return number of bytes that can be sent without blocking,
+*         0 if the port is not available
+*/
+uint16_t PIOS_COM_GetTxFree(uintptr_t com_id)
+{
+	struct pios_com_dev * com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev) || !com_dev->has_tx) {
+		return 0;
+	}
+
+	return fifoBuf_getFree(&com_dev->tx);
+}
+
+/**
+* Send a message built with PIOS_COM_SendReserve
+* \param[in] port COM port
+* \param[in] len message length, at most what was reserved
+* \return -1 if port not available
+* \return -2 if the buffer did not have room for the whole message
+* \return number of bytes transmitted on success
+*/
+int32_t PIOS_COM_SendCommit(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev * com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		return -1;
+	}
+
+	PIOS_Assert(com_dev->has_tx);
+
+	uint16_t committed = fifoBuf_commit(&com_dev->tx, len);
+
+	/* More data has been put in the tx buffer, make sure the tx is started */
+	if (committed > 0 && com_dev->driver->tx_start) {
+		com_dev->driver->tx_start(com_dev->lower_id,
+					  fifoBuf_getUsed(&com_dev->tx));
+	}
+
+	/* Only part of the message went out, count it as lost */
+	if (committed < len) {
+		return -2;
+	}
+
+	return committed;
+}
+
 /**
 * Sends a single character over given port
 * \param[in] port COM port
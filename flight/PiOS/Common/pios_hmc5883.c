@@ -35,12 +35,11 @@
 
 #if defined(PIOS_INCLUDE_HMC5883)
 
-#include "pios_semaphore.h"
+#include "pios_sensor_bus.h"
 
 /* Private constants */
-#define HMC5883_TASK_PRIORITY        (tskIDLE_PRIORITY + configMAX_PRIORITIES - 1)  // max priority
-#define HMC5883_TASK_STACK	         (512 / 4)
 #define PIOS_HMC5883_MAX_DOWNSAMPLE  1
+#define PIOS_HMC5883_READ_TIMEOUT_US 20000
 
 /* Global Variables */
 
@@ -53,17 +52,35 @@ struct hmc5883_dev {
 	uint32_t i2c_id;
 	const struct pios_hmc5883_cfg *cfg;
 	xQueueHandle queue;
-	xTaskHandle task;
-	struct pios_semaphore *data_ready_sema;
+	struct pios_sensor_bus_job job;
+	uint32_t sample_period_us;
 	enum pios_hmc5883_dev_magic magic;
 	enum pios_hmc5883_orientation orientation;
+
+#if defined(PIOS_I2C_HAS_QUEUE)
+	/* Sample read, submitted to the I2C adapter queue */
+	uint8_t addr_read;
+	uint8_t buffer_read[6];
+	uint8_t buffer_write[2];
+	struct pios_i2c_txn read_txns[3];
+	struct pios_i2c_request read_request;
+	volatile int32_t read_result;
+	volatile bool read_done;
+	bool read_pending;
+	uint32_t read_time_us;
+#endif
 };
 
 /* Local Variables */
 static int32_t PIOS_HMC5883_Config(const struct pios_hmc5883_cfg * cfg);
 static int32_t PIOS_HMC5883_Read(uint8_t address, uint8_t * buffer, uint8_t len);
 static int32_t PIOS_HMC5883_Write(uint8_t address, uint8_t buffer);
-static void PIOS_HMC5883_Task(void *parameters);
+static uint32_t PIOS_HMC5883_NextSample(void);
+static uint32_t PIOS_HMC5883_Job(void *ctx);
+static void PIOS_HMC5883_ConvertMag(const uint8_t buffer_read[6], struct pios_sensor_mag_data *mag_data);
+#if defined(PIOS_I2C_HAS_QUEUE)
+static void PIOS_HMC5883_InitRead(void);
+#endif
 
 static struct hmc5883_dev *dev;
 
@@ -117,12 +134,29 @@ int32_t PIOS_HMC5883_Init(uint32_t i2c_id, const struct pios_hmc5883_cfg *cfg)
 	dev->i2c_id = i2c_id;
 	dev->orientation = cfg->Default_Orientation;
 
-	/* check if we are using an irq line */
-	if (cfg->exti_cfg != NULL) {
-		PIOS_EXTI_Init(cfg->exti_cfg);
-
-		dev->data_ready_sema = PIOS_Semaphore_Create();
-		PIOS_Assert(dev->data_ready_sema != NULL);
+	switch (cfg->M_ODR) {
+	case PIOS_HMC5883_ODR_0_75:
+		dev->sample_period_us = 1000000 / 0.75f;
+		break;
+	case PIOS_HMC5883_ODR_1_5:
+		dev->sample_period_us = 1000000 / 1.5f;
+		break;
+	case PIOS_HMC5883_ODR_3:
+		dev->sample_period_us = 1000000 / 3.0f;
+		break;
+	case PIOS_HMC5883_ODR_7_5:
+		dev->sample_period_us = 1000000 / 7.5f;
+		break;
+	case PIOS_HMC5883_ODR_15:
+		dev->sample_period_us = 1000000 / 15.0f;
+		break;
+	case PIOS_HMC5883_ODR_30:
+		dev->sample_period_us = 1000000 / 30.0f;
+		break;
+	case PIOS_HMC5883_ODR_75:
+	default:
+		dev->sample_period_us = 1000000 / 75.0f;
+		break;
 	}
 
 	if (PIOS_HMC5883_Config(cfg) != 0)
@@ -130,15 +164,36 @@ int32_t PIOS_HMC5883_Init(uint32_t i2c_id, const struct pios_hmc5883_cfg *cfg)
 
 	PIOS_SENSORS_Register(PIOS_SENSOR_MAG, dev->queue);
 
-	int result = xTaskCreate(PIOS_HMC5883_Task, (const signed char *)"pios_hmc5883",
-						 HMC5883_TASK_STACK, NULL, HMC5883_TASK_PRIORITY,
-						 &dev->task);
+#if defined(PIOS_I2C_HAS_QUEUE)
+	PIOS_HMC5883_InitRead();
+#endif
 
-	PIOS_Assert(result == pdPASS);
+	/* Samples are read by the sensor bus task of the I2C adapter, in
+	 * between the transfers of the other sensors on it */
+	dev->job.name = "hmc5883";
+	dev->job.run = PIOS_HMC5883_Job;
+	dev->job.ctx = dev;
+	if (PIOS_SENSOR_BUS_AddJob(PIOS_SENSOR_BUS_Get(i2c_id), &dev->job, PIOS_HMC5883_NextSample()) != 0)
+		return -3;
+
+	/* check if we are using an irq line */
+	if (cfg->exti_cfg != NULL)
+		PIOS_EXTI_Init(cfg->exti_cfg);
 
 	return 0;
 }
 
+/**
+ * @brief Time until the next sample can be read
+ */
+static uint32_t PIOS_HMC5883_NextSample(void)
+{
+	if (dev->cfg->Mode == PIOS_HMC5883_MODE_CONTINUOUS && dev->cfg->exti_cfg != NULL)
+		return PIOS_SENSOR_BUS_IDLE;
+
+	return dev->sample_period_us;
+}
+
 /**
  * @brief Updates the HMC5883 chip orientation.
  * @returns 0 for success or -1 for failure
@@ -257,6 +312,7 @@ static uint16_t PIOS_HMC5883_Config_GetSensitivity()
 	return 0;
 }
 
+#if !defined(PIOS_I2C_HAS_QUEUE)
 /**
  * @brief Read current X, Z, Y values (in that order)
  * \param[out] int16_t array of size 3 to store X, Z, and Y magnetometer readings
@@ -308,6 +364,17 @@ static int32_t PIOS_HMC5883_ReadMag(struct pios_sensor_mag_data *mag_data)
 	if (PIOS_I2C_Transfer(dev->i2c_id, txn_list, NELEMENTS(txn_list)) != 0)
 		return -1;
 
+	PIOS_HMC5883_ConvertMag(buffer_read, mag_data);
+
+	return 0;
+}
+#endif
+
+/**
+ * @brief Scale and rotate the X, Z, Y values (in that order) as read
+ */
+static void PIOS_HMC5883_ConvertMag(const uint8_t buffer_read[6], struct pios_sensor_mag_data *mag_data)
+{
 	int16_t mag_x, mag_y, mag_z;
 	uint16_t sensitivity = PIOS_HMC5883_Config_GetSensitivity();
 	mag_x = ((int16_t) ((uint16_t)buffer_read[0] << 8) + buffer_read[1]) * 1000 / sensitivity;
@@ -357,8 +424,6 @@ static int32_t PIOS_HMC5883_ReadMag(struct pios_sensor_mag_data *mag_data)
 			mag_data->z = mag_z;
 			break;
 	}
-	
-	return 0;
 }
 
 
@@ -469,65 +534,116 @@ bool PIOS_HMC5883_IRQHandler(void)
 	if (PIOS_HMC5883_Validate(dev) != 0)
 		return false;
 
-	bool woken = false;
-	PIOS_Semaphore_Give_FromISR(dev->data_ready_sema, &woken);
-
-	return woken;
+	return PIOS_SENSOR_BUS_TriggerFromISR(&dev->job);
 }
 
 /**
- * The HMC5883 task
+ * Read a sample, run by the sensor bus task. In continuous mode the data
+ * ready interrupt triggers the next read, otherwise reading has started
+ * the next single conversion and the job comes back one sample later.
+ * Continuous mode without an interrupt line is polled the same way.
+ *
+ * Where the I2C adapter queues requests the read is submitted, and the job
+ * runs again to collect it when it completes.
  */
-static void PIOS_HMC5883_Task(void *parameters)
+static uint32_t PIOS_HMC5883_Job(void *ctx)
 {
-	while (PIOS_HMC5883_Validate(dev) != 0) {
-		vTaskDelay(MS2TICKS(100));
-	}
+	struct pios_sensor_mag_data mag_data;
 
-	portTickType sample_delay;
+#if defined(PIOS_I2C_HAS_QUEUE)
+	if (!dev->read_pending) {
+		dev->read_done = false;
+		dev->read_pending = true;
+		dev->read_time_us = PIOS_DELAY_GetuS();
 
-	switch (dev->cfg->M_ODR) {
-	case PIOS_HMC5883_ODR_0_75:
-		sample_delay = MS2TICKS(1000 / 0.75f) + 0.99999f;
-		break;
-	case PIOS_HMC5883_ODR_1_5:
-		sample_delay = MS2TICKS(1000 / 1.5f) + 0.99999f;
-		break;
-	case PIOS_HMC5883_ODR_3:
-		sample_delay = MS2TICKS(1000 / 3.0f) + 0.99999f;
-		break;
-	case PIOS_HMC5883_ODR_7_5:
-		sample_delay = MS2TICKS(1000 / 7.5f) + 0.99999f;
-		break;
-	case PIOS_HMC5883_ODR_15:
-		sample_delay = MS2TICKS(1000 / 15.0f) + 0.99999f;
-		break;
-	case PIOS_HMC5883_ODR_30:
-		sample_delay = MS2TICKS(1000 / 30.0f) + 0.99999f;
-		break;
-	case PIOS_HMC5883_ODR_75:
-	default:
-		sample_delay = MS2TICKS(1000 / 75.0f) + 0.99999f;
-		break;
+		if (PIOS_I2C_Submit(dev->i2c_id, &dev->read_request) != 0) {
+			dev->read_pending = false;
+			return PIOS_HMC5883_NextSample();
+		}
+
+		return PIOS_HMC5883_READ_TIMEOUT_US;
 	}
 
-	portTickType now = xTaskGetTickCount();
+	if (!dev->read_done) {
+		/* Early on the data ready line, otherwise overdue */
+		uint32_t elapsed_us = PIOS_DELAY_GetuSSince(dev->read_time_us);
+		if (elapsed_us < PIOS_HMC5883_READ_TIMEOUT_US)
+			return PIOS_HMC5883_READ_TIMEOUT_US - elapsed_us;
 
-	while (1) {
-		if (dev->cfg->Mode == PIOS_HMC5883_MODE_CONTINUOUS) {
-			if (PIOS_Semaphore_Take(dev->data_ready_sema, PIOS_SEMAPHORE_TIMEOUT_MAX) != true) {
-				vTaskDelay(MS2TICKS(100));
-				continue;
-			}
-		} else {
-			vTaskDelayUntil(&now, sample_delay);
-		}
+		PIOS_I2C_Abort(dev->i2c_id, &dev->read_request);
+	}
 
-		struct pios_sensor_mag_data mag_data;
-		if (PIOS_HMC5883_ReadMag(&mag_data) == 0)
-			xQueueSend(dev->queue, (void *) &mag_data, 0);
+	dev->read_pending = false;
+
+	if (dev->read_result == 0) {
+		PIOS_HMC5883_ConvertMag(dev->buffer_read, &mag_data);
+		xQueueSend(dev->queue, (void *) &mag_data, 0);
 	}
+#else
+	if (PIOS_HMC5883_ReadMag(&mag_data) == 0)
+		xQueueSend(dev->queue, (void *) &mag_data, 0);
+#endif
+
+	return PIOS_HMC5883_NextSample();
+}
+
+#if defined(PIOS_I2C_HAS_QUEUE)
+/**
+ * @brief Completion of a sample read, from the I2C interrupt
+ */
+static void PIOS_HMC5883_ReadDone(struct pios_i2c_request *request, int32_t result, bool *woken)
+{
+	struct hmc5883_dev *hmc5883_dev = (struct hmc5883_dev *)request->ctx;
+
+	hmc5883_dev->read_result = result;
+	hmc5883_dev->read_done = true;
+
+	if (PIOS_SENSOR_BUS_TriggerFromISR(&hmc5883_dev->job))
+		*woken = true;
+}
+
+/**
+ * @brief Set up the sample read: the data registers, then the mode register
+ * to trigger the next single measurement
+ */
+static void PIOS_HMC5883_InitRead(void)
+{
+	dev->addr_read = PIOS_HMC5883_DATAOUT_XMSB_REG;
+	dev->buffer_write[0] = PIOS_HMC5883_MODE_REG;
+	dev->buffer_write[1] = dev->cfg->Mode;
+
+	dev->read_txns[0] = (struct pios_i2c_txn) {
+		.info = __func__,
+		.addr = PIOS_HMC5883_I2C_ADDR,
+		.rw = PIOS_I2C_TXN_WRITE,
+		.len = sizeof(dev->addr_read),
+		.buf = &dev->addr_read,
+	};
+	dev->read_txns[1] = (struct pios_i2c_txn) {
+		.info = __func__,
+		.addr = PIOS_HMC5883_I2C_ADDR,
+		.rw = PIOS_I2C_TXN_READ,
+		.len = sizeof(dev->buffer_read),
+		.buf = dev->buffer_read,
+	};
+	dev->read_txns[2] = (struct pios_i2c_txn) {
+		.info = __func__,
+		.addr = PIOS_HMC5883_I2C_ADDR,
+		.rw = PIOS_I2C_TXN_WRITE,
+		.len = sizeof(dev->buffer_write),
+		.buf = dev->buffer_write,
+	};
+
+	dev->read_request = (struct pios_i2c_request) {
+		.txn_list = dev->read_txns,
+		.num_txns = NELEMENTS(dev->read_txns),
+		.callback = PIOS_HMC5883_ReadDone,
+		.ctx = dev,
+	};
+
+	dev->read_pending = false;
 }
+#endif
 
 #endif /* PIOS_INCLUDE_HMC5883 */
 
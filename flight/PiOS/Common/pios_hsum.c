@@ -267,10 +267,14 @@ stream_error:
 	return -1;
 }
 
-/* Update decoder state processing input byte from the HoTT stream */
-static void PIOS_HSUM_UpdateState(struct pios_hsum_dev *hsum_dev, uint8_t byte)
+/**
+ * Update decoder state processing input byte from the HoTT stream
+ * \output true if a complete frame was accepted
+ */
+static bool PIOS_HSUM_UpdateState(struct pios_hsum_dev *hsum_dev, uint8_t byte)
 {
 	struct pios_hsum_state *state = &(hsum_dev->state);
+	bool frame_accepted = false;
 	if (state->frame_found) {
 		/* receiving the data frame */
 		if (state->byte_count < HSUM_MAX_FRAME_LENGTH) {
@@ -282,14 +286,18 @@ static void PIOS_HSUM_UpdateState(struct pios_hsum_dev *hsum_dev, uint8_t byte)
 			}
 			if (state->byte_count == state->frame_length) {
 				/* full frame received - process and wait for new one */
-				if (!PIOS_HSUM_UnrollChannels(hsum_dev))
+				if (!PIOS_HSUM_UnrollChannels(hsum_dev)) {
 					/* data looking good */
 					state->failsafe_timer = 0;
+					frame_accepted = true;
+				}
 				/* prepare for the next frame */
 				state->frame_found = 0;
 			}
 		}
 	}
+
+	return frame_accepted;
 }
 
 /* Initialise HoTT receiver interface */
@@ -337,8 +345,9 @@ static uint16_t PIOS_HSUM_RxInCallback(uintptr_t context,
 	PIOS_Assert(valid);
 
 	/* process byte(s) and clear receive timer */
+	bool frame_accepted = false;
 	for (uint8_t i = 0; i < buf_len; i++) {
-		PIOS_HSUM_UpdateState(hsum_dev, buf[i]);
+		frame_accepted |= PIOS_HSUM_UpdateState(hsum_dev, buf[i]);
 		hsum_dev->state.receive_timer = 0;
 	}
 
@@ -346,8 +355,8 @@ static uint16_t PIOS_HSUM_RxInCallback(uintptr_t context,
 	if (headroom)
 		*headroom = HSUM_MAX_FRAME_LENGTH;
 
-	/* We never need a yield */
-	*need_yield = false;
+	/* Wake up the receiver consumer if a frame was decoded */
+	*need_yield = frame_accepted ? PIOS_RCVR_ActiveFromISR() : false;
 
 	/* Always indicate that all bytes were consumed */
 	return buf_len;
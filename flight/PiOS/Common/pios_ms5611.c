@@ -35,11 +35,11 @@
 #if defined(PIOS_INCLUDE_MS5611)
 
 #include "pios_ms5611_priv.h"
+#include "pios_sensor_bus.h"
 
 /* Private constants */
-#define PIOS_MS5611_OVERSAMPLING oversampling
-#define MS5611_TASK_PRIORITY	(tskIDLE_PRIORITY + configMAX_PRIORITIES - 1)	// max priority
-#define MS5611_TASK_STACK		(512 / 4)
+#define MS5611_RETRY_US         1000
+#define MS5611_BATCH_TIMEOUT_US 20000
 
 /* MS5611 Addresses */
 #define MS5611_I2C_ADDR	        0x77
@@ -55,7 +55,7 @@
 /* Private methods */
 static int32_t PIOS_MS5611_Read(uint8_t address, uint8_t * buffer, uint8_t len);
 static int32_t PIOS_MS5611_WriteCommand(uint8_t command);
-static void PIOS_MS5611_Task(void *parameters);
+static uint32_t PIOS_MS5611_Job(void *ctx);
 
 /* Private types */
 
@@ -73,15 +73,37 @@ enum conversion_type {
 struct ms5611_dev {
 	const struct pios_ms5611_cfg * cfg;
 	uint32_t i2c_id;
-	xTaskHandle task;
+	struct pios_sensor_bus_job job;
 	xQueueHandle queue;
 
 	int64_t pressure_unscaled;
 	int64_t temperature_unscaled;
 	uint16_t calibration[6];
 	enum conversion_type current_conversion_type;
+	bool conversion_pending;
+	uint32_t conversion_us;
+	uint32_t pressure_until_temperature;
+	volatile enum pios_ms5611_osr oversampling;
 	enum pios_ms5611_dev_magic magic;
 
+#if defined(PIOS_I2C_HAS_QUEUE)
+	/* Read back of a conversion and start of the next, run as one batch */
+	uint8_t adc_command;
+	uint8_t adc_data[3];
+	uint8_t start_command;
+	struct pios_i2c_txn read_txns[2];
+	struct pios_i2c_txn start_txn;
+	struct pios_i2c_request read_request;
+	struct pios_i2c_request start_request;
+	volatile int32_t read_result;
+	volatile int32_t start_result;
+	volatile bool batch_done;
+	bool batch_pending;
+	bool batch_reads;
+	enum conversion_type batch_conversion_type;
+	uint32_t batch_conversion_us;
+#endif
+
 #if defined(PIOS_INCLUDE_FREERTOS)
 	xSemaphoreHandle busy;
 #else
@@ -91,6 +113,16 @@ struct ms5611_dev {
 
 static struct ms5611_dev *dev;
 
+static void PIOS_MS5611_ConvertADC(const uint8_t data[3]);
+static void PIOS_MS5611_SendSample(void);
+static enum conversion_type PIOS_MS5611_NextConversion(void);
+static void PIOS_MS5611_ConversionStarted(enum conversion_type type);
+#if defined(PIOS_I2C_HAS_QUEUE)
+static void PIOS_MS5611_InitBatch(void);
+static uint32_t PIOS_MS5611_SubmitBatch(void);
+static uint32_t PIOS_MS5611_CollectBatch(void);
+#endif
+
 /**
  * @brief Allocate a new device
  */
@@ -102,14 +134,14 @@ static struct ms5611_dev * PIOS_MS5611_alloc(void)
 	if (!ms5611_dev)
 		return (NULL);
 
+	memset(ms5611_dev, 0, sizeof(*ms5611_dev));
+
 	ms5611_dev->queue = xQueueCreate(1, sizeof(struct pios_sensor_baro_data));
 	if (ms5611_dev->queue == NULL) {
 		vPortFree(ms5611_dev);
 		return NULL;
 	}
 
-	memset(ms5611_dev, 0, sizeof(ms5611_dev));
-
 	ms5611_dev->magic = PIOS_MS5611_DEV_MAGIC;
 
 #if defined(PIOS_INCLUDE_FREERTOS)
@@ -138,7 +170,8 @@ static int32_t PIOS_MS5611_Validate(struct ms5611_dev *dev)
 }
 
 /**
- * Initialise the MS5611 sensor
+ * Initialise the MS5611 sensor. Conversions are scheduled on the sensor bus
+ * task of the I2C adapter, which is shared with the other sensors on it.
  */
 int32_t PIOS_MS5611_Init(const struct pios_ms5611_cfg *cfg, int32_t i2c_device)
 {
@@ -148,6 +181,7 @@ int32_t PIOS_MS5611_Init(const struct pios_ms5611_cfg *cfg, int32_t i2c_device)
 
 	dev->i2c_id = i2c_device;
 	dev->cfg = cfg;
+	dev->oversampling = cfg->oversampling;
 
 	if (PIOS_MS5611_WriteCommand(MS5611_RESET) != 0)
 		return -2;
@@ -164,14 +198,41 @@ int32_t PIOS_MS5611_Init(const struct pios_ms5611_cfg *cfg, int32_t i2c_device)
 
 	PIOS_SENSORS_Register(PIOS_SENSOR_BARO, dev->queue);
 
-	portBASE_TYPE result = xTaskCreate(PIOS_MS5611_Task, (const signed char *)"pios_ms5611",
-					MS5611_TASK_STACK, NULL, MS5611_TASK_PRIORITY,
-					&dev->task);
-	PIOS_Assert(result == pdPASS);
+#if defined(PIOS_I2C_HAS_QUEUE)
+	PIOS_MS5611_InitBatch();
+#endif
+
+	dev->job.name = "ms5611";
+	dev->job.run = PIOS_MS5611_Job;
+	dev->job.ctx = dev;
+	if (PIOS_SENSOR_BUS_AddJob(PIOS_SENSOR_BUS_Get(i2c_device), &dev->job, 0) != 0)
+		return -3;
 
 	return 0;
 }
 
+/**
+ * Change the oversampling rate, from the next conversion on
+ * \return 0 for success, -1 for failure
+ */
+int32_t PIOS_MS5611_SetOversampling(enum pios_ms5611_osr oversampling)
+{
+	if (PIOS_MS5611_Validate(dev) != 0)
+		return -1;
+
+	switch (oversampling) {
+	case MS5611_OSR_256:
+	case MS5611_OSR_512:
+	case MS5611_OSR_1024:
+	case MS5611_OSR_2048:
+	case MS5611_OSR_4096:
+		dev->oversampling = oversampling;
+		return 0;
+	}
+
+	return -1;
+}
+
 /**
  * Claim the MS5611 device semaphore.
  * \return 0 if no error
@@ -221,59 +282,58 @@ static int32_t PIOS_MS5611_ReleaseDevice(void)
 }
 
 /**
-* Start the ADC conversion
+ * @brief Return the maximum conversion time in us for an osr, from the datasheet
+ */
+static uint32_t PIOS_MS5611_GetDelayUs(enum pios_ms5611_osr oversampling)
+{
+	switch(oversampling) {
+	case MS5611_OSR_256:
+		return 600;
+	case MS5611_OSR_512:
+		return 1170;
+	case MS5611_OSR_1024:
+		return 2280;
+	case MS5611_OSR_2048:
+		return 4540;
+	case MS5611_OSR_4096:
+		return 9040;
+	}
+	return 9040;
+}
+
+/**
+* Start the ADC conversion without waiting for it. The conversion time for
+* the oversampling rate it was started with is kept in dev->conversion_us.
 * \param[in] PRESSURE_CONV or TEMPERATURE_CONV to select which measurement to make
-* \return 0 for success, -1 for failure (conversion completed and not read)
+* \return 0 for success, -1 for failure
 */
 static int32_t PIOS_MS5611_StartADC(enum conversion_type type)
 {
 	if (PIOS_MS5611_Validate(dev) != 0)
 		return -1;
 
+	enum pios_ms5611_osr oversampling = dev->oversampling;
+
 	/* Start the conversion */
 	switch (type) {
 	case TEMPERATURE_CONV:
-		while (PIOS_MS5611_WriteCommand(MS5611_TEMP_ADDR + dev->cfg->oversampling) != 0)
-			continue;
+		if (PIOS_MS5611_WriteCommand(MS5611_TEMP_ADDR + oversampling) != 0)
+			return -1;
 		break;
 	case PRESSURE_CONV:
-		while (PIOS_MS5611_WriteCommand(MS5611_PRES_ADDR + dev->cfg->oversampling) != 0)
-			continue;
+		if (PIOS_MS5611_WriteCommand(MS5611_PRES_ADDR + oversampling) != 0)
+			return -1;
 		break;
 	default:
 		return -1;
 	}
 
 	dev->current_conversion_type = type;
+	dev->conversion_us = PIOS_MS5611_GetDelayUs(oversampling);
 
 	return 0;
 }
 
-/**
- * @brief Return the delay for the current osr
- */
-static int32_t PIOS_MS5611_GetDelay()
-{
-	if (PIOS_MS5611_Validate(dev) != 0)
-		return 100;
-
-	switch(dev->cfg->oversampling) {
-	case MS5611_OSR_256:
-		return 2;
-	case MS5611_OSR_512:
-		return 2;
-	case MS5611_OSR_1024:
-		return 3;
-	case MS5611_OSR_2048:
-		return 5;
-	case MS5611_OSR_4096:
-		return 10;
-	default:
-		break;
-	}
-	return 10;
-}
-
 /**
 * Read the ADC conversion value (once ADC conversion has completed)
 * \return 0 if successfully read the ADC, -1 if failed
@@ -285,15 +345,27 @@ static int32_t PIOS_MS5611_ReadADC(void)
 
 	uint8_t data[3];
 
+	/* Read the conversion */
+	if (PIOS_MS5611_Read(MS5611_ADC_READ, data, 3) != 0)
+		return -1;
+
+	PIOS_MS5611_ConvertADC(data);
+
+	return 0;
+}
+
+/**
+* Compensate the 24bit result of the current conversion
+* \param[in] data the result as read from the ADC
+*/
+static void PIOS_MS5611_ConvertADC(const uint8_t data[3])
+{
 	static int64_t delta_temp;
 	static int64_t temperature;
 
-	/* Read and store the 16bit result */
+	/* Store the result */
 	if (dev->current_conversion_type == TEMPERATURE_CONV) {
 		uint32_t raw_temperature;
-		/* Read the temperature conversion */
-		if (PIOS_MS5611_Read(MS5611_ADC_READ, data, 3) != 0)
-			return -1;
 
 		raw_temperature = (data[0] << 16) | (data[1] << 8) | data[2];
 
@@ -310,10 +382,6 @@ static int32_t PIOS_MS5611_ReadADC(void)
 		int64_t sens;
 		uint32_t raw_pressure;
 
-		/* Read the pressure conversion */
-		if (PIOS_MS5611_Read(MS5611_ADC_READ, data, 3) != 0)
-			return -1;
-
 		raw_pressure = (data[0] << 16) | (data[1] << 8) | (data[2] << 0);
 
 		offset = ((int64_t)dev->calibration[1] << 16) + (((int64_t)dev->calibration[3] * delta_temp) >> 7);
@@ -333,7 +401,6 @@ static int32_t PIOS_MS5611_ReadADC(void)
 
 		dev->pressure_unscaled = ((((int64_t)raw_pressure * sens) >> 21) - offset) >> 15;
 	}
-	return 0;
 }
 
 /**
@@ -406,15 +473,28 @@ int32_t PIOS_MS5611_Test()
 		return -1;
 
 	PIOS_MS5611_ClaimDevice();
+
+#if defined(PIOS_I2C_HAS_QUEUE)
+	/* Take back a batch in flight */
+	if (dev->batch_pending)
+		PIOS_MS5611_CollectBatch();
+#endif
+
+	/* Let a conversion started by the bus job finish, its result is
+	 * discarded and the job starts over with a temperature reading */
+	if (dev->conversion_pending)
+		PIOS_DELAY_WaituS(dev->conversion_us);
+	dev->conversion_pending = false;
+	dev->pressure_until_temperature = 0;
+
 	PIOS_MS5611_StartADC(TEMPERATURE_CONV);
-	PIOS_DELAY_WaitmS(PIOS_MS5611_GetDelay() / portTICK_RATE_MS);
+	PIOS_DELAY_WaituS(dev->conversion_us);
 	PIOS_MS5611_ReadADC();
-	PIOS_MS5611_ReleaseDevice();
 
-	PIOS_MS5611_ClaimDevice();
 	PIOS_MS5611_StartADC(PRESSURE_CONV);
-	PIOS_DELAY_WaitmS(PIOS_MS5611_GetDelay() / portTICK_RATE_MS);
+	PIOS_DELAY_WaituS(dev->conversion_us);
 	PIOS_MS5611_ReadADC();
+
 	PIOS_MS5611_ReleaseDevice();
 
 	// check range for sanity according to datasheet
@@ -427,46 +507,245 @@ int32_t PIOS_MS5611_Test()
 	return 0;
 }
 
-static void PIOS_MS5611_Task(void *parameters)
+/**
+ * Compute the altitude from the pressure and temperature and send it out
+ */
+static void PIOS_MS5611_SendSample(void)
+{
+	struct pios_sensor_baro_data data;
+	data.temperature = ((float) dev->temperature_unscaled) / 100.0f;
+	data.pressure = ((float) dev->pressure_unscaled) / 1000.0f;
+	data.altitude = 44330.0f * (1.0f - powf(data.pressure / MS5611_P0, (1.0f / 5.255f)));
+
+	xQueueSend(dev->queue, (void*)&data, 0);
+}
+
+/**
+ * Temperature is converted once every temperature_interleaving pressure
+ * conversions
+ */
+static enum conversion_type PIOS_MS5611_NextConversion(void)
 {
-	// init this to 1 in order to force a temperature read on the first run
-	uint32_t temp_press_interleave_count = 1;
+	return (dev->pressure_until_temperature == 0) ? TEMPERATURE_CONV : PRESSURE_CONV;
+}
 
-	while (1) {
+/**
+ * Account for a conversion that has been started
+ */
+static void PIOS_MS5611_ConversionStarted(enum conversion_type type)
+{
+	dev->conversion_pending = true;
+	if (type == TEMPERATURE_CONV) {
+		dev->pressure_until_temperature = dev->cfg->temperature_interleaving;
+		if (dev->pressure_until_temperature == 0)
+			dev->pressure_until_temperature = 1;
+	} else {
+		dev->pressure_until_temperature--;
+	}
+}
 
-		--temp_press_interleave_count;
+/**
+ * The conversion state machine, run by the sensor bus task. Reads back the
+ * conversion started on the previous run, starts the next one and leaves
+ * the bus to the other sensors until it completes.
+ *
+ * Where the I2C adapter queues requests the read back and the start are
+ * submitted as one batch, and the job runs again when the batch completes.
+ * The bus task is free meanwhile instead of waiting on two transfers.
+ */
+static uint32_t PIOS_MS5611_Job(void *ctx)
+{
+	if (PIOS_MS5611_ClaimDevice() != 0)
+		return MS5611_RETRY_US;
 
-		if (temp_press_interleave_count == 0)
-		{
-			// Update the temperature data
-			PIOS_MS5611_ClaimDevice();
-			PIOS_MS5611_StartADC(TEMPERATURE_CONV);
-			vTaskDelay(MS2TICKS(PIOS_MS5611_GetDelay()));
-			PIOS_MS5611_ReadADC();
-			PIOS_MS5611_ReleaseDevice();
-
-			temp_press_interleave_count = dev->cfg->temperature_interleaving;
-			if (temp_press_interleave_count == 0)
-				temp_press_interleave_count = 1;
+#if defined(PIOS_I2C_HAS_QUEUE)
+	uint32_t delay_us;
+	if (dev->batch_pending)
+		delay_us = PIOS_MS5611_CollectBatch();
+	else
+		delay_us = PIOS_MS5611_SubmitBatch();
+
+	PIOS_MS5611_ReleaseDevice();
+
+	return delay_us;
+#else
+	if (dev->conversion_pending) {
+		dev->conversion_pending = false;
+
+		if (PIOS_MS5611_ReadADC() != 0) {
+			// the pressure compensation needs a valid temperature
+			if (dev->current_conversion_type == TEMPERATURE_CONV)
+				dev->pressure_until_temperature = 0;
+		} else if (dev->current_conversion_type == PRESSURE_CONV) {
+			PIOS_MS5611_SendSample();
 		}
+	}
 
-		// Update the pressure data
-		PIOS_MS5611_ClaimDevice();
-		PIOS_MS5611_StartADC(PRESSURE_CONV);
-		vTaskDelay(MS2TICKS(PIOS_MS5611_GetDelay()));
-		PIOS_MS5611_ReadADC();
+	enum conversion_type next = PIOS_MS5611_NextConversion();
+
+	if (PIOS_MS5611_StartADC(next) != 0) {
 		PIOS_MS5611_ReleaseDevice();
+		return MS5611_RETRY_US;
+	}
+
+	PIOS_MS5611_ConversionStarted(next);
+
+	PIOS_MS5611_ReleaseDevice();
+
+	return dev->conversion_us;
+#endif
+}
+
+#if defined(PIOS_I2C_HAS_QUEUE)
+/**
+ * Completion of the ADC read back, from the I2C interrupt
+ */
+static void PIOS_MS5611_ReadDone(struct pios_i2c_request *request, int32_t result, bool *woken)
+{
+	struct ms5611_dev *ms5611_dev = (struct ms5611_dev *)request->ctx;
+
+	ms5611_dev->read_result = result;
+}
+
+/**
+ * Completion of the conversion start, the last request of a batch. Runs the
+ * job again to collect the batch.
+ */
+static void PIOS_MS5611_StartDone(struct pios_i2c_request *request, int32_t result, bool *woken)
+{
+	struct ms5611_dev *ms5611_dev = (struct ms5611_dev *)request->ctx;
+
+	ms5611_dev->start_result = result;
+	ms5611_dev->batch_done = true;
+
+	if (PIOS_SENSOR_BUS_TriggerFromISR(&ms5611_dev->job))
+		*woken = true;
+}
 
-		// Compute the altitude from the pressure and temperature and send it out
-		struct pios_sensor_baro_data data;
-		data.temperature = ((float) dev->temperature_unscaled) / 100.0f;
-		data.pressure = ((float) dev->pressure_unscaled) / 1000.0f;
-		data.altitude = 44330.0f * (1.0f - powf(data.pressure / MS5611_P0, (1.0f / 5.255f)));
+/**
+ * Set up the requests of a batch, only the commands change between runs
+ */
+static void PIOS_MS5611_InitBatch(void)
+{
+	dev->adc_command = MS5611_ADC_READ;
+
+	dev->read_txns[0] = (struct pios_i2c_txn) {
+		.info = __func__,
+		.addr = MS5611_I2C_ADDR,
+		.rw = PIOS_I2C_TXN_WRITE,
+		.len = 1,
+		.buf = &dev->adc_command,
+	};
+	dev->read_txns[1] = (struct pios_i2c_txn) {
+		.info = __func__,
+		.addr = MS5611_I2C_ADDR,
+		.rw = PIOS_I2C_TXN_READ,
+		.len = sizeof(dev->adc_data),
+		.buf = dev->adc_data,
+	};
+	dev->start_txn = (struct pios_i2c_txn) {
+		.info = __func__,
+		.addr = MS5611_I2C_ADDR,
+		.rw = PIOS_I2C_TXN_WRITE,
+		.len = 1,
+		.buf = &dev->start_command,
+	};
+
+	dev->read_request = (struct pios_i2c_request) {
+		.txn_list = dev->read_txns,
+		.num_txns = NELEMENTS(dev->read_txns),
+		.callback = PIOS_MS5611_ReadDone,
+		.ctx = dev,
+	};
+	dev->start_request = (struct pios_i2c_request) {
+		.txn_list = &dev->start_txn,
+		.num_txns = 1,
+		.callback = PIOS_MS5611_StartDone,
+		.ctx = dev,
+	};
+}
+
+/**
+ * Queue the read back of the conversion in flight, if there is one, and
+ * the start of the next conversion
+ * \return the time until the job must run even if the batch has not completed
+ */
+static uint32_t PIOS_MS5611_SubmitBatch(void)
+{
+	enum conversion_type next = PIOS_MS5611_NextConversion();
+	enum pios_ms5611_osr oversampling = dev->oversampling;
+
+	dev->start_command = ((next == TEMPERATURE_CONV) ? MS5611_TEMP_ADDR : MS5611_PRES_ADDR) + oversampling;
+	dev->batch_conversion_type = next;
+	dev->batch_conversion_us = PIOS_MS5611_GetDelayUs(oversampling);
+
+	dev->read_result = -1;
+	dev->start_result = -1;
+	dev->batch_done = false;
+	dev->batch_pending = true;
+
+	struct pios_i2c_request *batch = &dev->start_request;
+	dev->start_request.next = NULL;
+	dev->batch_reads = dev->conversion_pending;
+	if (dev->batch_reads) {
+		dev->read_request.next = &dev->start_request;
+		batch = &dev->read_request;
+	}
 
-		xQueueSend(dev->queue, (void*)&data, 0);
+	if (PIOS_I2C_Submit(dev->i2c_id, batch) != 0) {
+		dev->batch_pending = false;
+		return MS5611_RETRY_US;
 	}
+
+	return MS5611_BATCH_TIMEOUT_US;
 }
 
+/**
+ * Process a batch that has completed, or take back what has not completed
+ * of one that is overdue. A read back that failed is retried with the next
+ * batch unless a new conversion has started.
+ * \return the time until the job must run again
+ */
+static uint32_t PIOS_MS5611_CollectBatch(void)
+{
+	/* The start first, so that aborting the read does not start it */
+	if (!dev->batch_done) {
+		PIOS_I2C_Abort(dev->i2c_id, &dev->start_request);
+		PIOS_I2C_Abort(dev->i2c_id, &dev->read_request);
+	}
+
+	dev->batch_pending = false;
+
+	bool temperature_lost = false;
+
+	if (dev->batch_reads) {
+		if (dev->read_result == 0) {
+			dev->conversion_pending = false;
+			PIOS_MS5611_ConvertADC(dev->adc_data);
+
+			if (dev->current_conversion_type == PRESSURE_CONV)
+				PIOS_MS5611_SendSample();
+		} else {
+			// the pressure compensation needs a valid temperature
+			temperature_lost = (dev->current_conversion_type == TEMPERATURE_CONV);
+		}
+	}
+
+	uint32_t delay_us = MS5611_RETRY_US;
+
+	if (dev->start_result == 0) {
+		dev->current_conversion_type = dev->batch_conversion_type;
+		dev->conversion_us = dev->batch_conversion_us;
+		PIOS_MS5611_ConversionStarted(dev->batch_conversion_type);
+		delay_us = dev->conversion_us;
+	}
+
+	if (temperature_lost)
+		dev->pressure_until_temperature = 0;
+
+	return delay_us;
+}
+#endif
 
 #endif
 
@@ -15,6 +15,12 @@ struct pios_rcvr_dev {
   const struct pios_rcvr_driver * driver;
 };
 
+/* Frame notification shared by all receiver drivers */
+#if defined(PIOS_INCLUDE_FREERTOS)
+static xSemaphoreHandle pios_rcvr_frame_sem;
+#endif
+static volatile uint32_t pios_rcvr_frame_time;
+
 static bool PIOS_RCVR_validate(struct pios_rcvr_dev * rcvr_dev)
 {
   return (rcvr_dev->magic == PIOS_RCVR_DEV_MAGIC);
@@ -108,6 +114,72 @@ int32_t PIOS_RCVR_Read(uintptr_t rcvr_id, uint8_t channel)
   return rcvr_dev->driver->read(rcvr_dev->lower_id, channel);
 }
 
+/**
+ * @brief Signal that a receiver driver has decoded a new frame. Called
+ * from interrupt context by the serial and PPM receiver drivers.
+ * @returns true if a higher priority task was woken
+ */
+bool PIOS_RCVR_ActiveFromISR(void)
+{
+	pios_rcvr_frame_time = PIOS_DELAY_GetRaw();
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+	if (pios_rcvr_frame_sem) {
+		signed portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+		xSemaphoreGiveFromISR(pios_rcvr_frame_sem, &xHigherPriorityTaskWoken);
+		return xHigherPriorityTaskWoken == pdTRUE;
+	}
+#endif
+
+	return false;
+}
+
+/**
+ * @brief Signal a new frame from task context, used by the receivers
+ * which are fed through UAVObjects
+ */
+void PIOS_RCVR_Active(void)
+{
+	pios_rcvr_frame_time = PIOS_DELAY_GetRaw();
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+	if (pios_rcvr_frame_sem)
+		xSemaphoreGive(pios_rcvr_frame_sem);
+#endif
+}
+
+/**
+ * @brief Wait until any receiver driver decodes a new frame. Frames that
+ * arrive while the caller is busy are coalesced into one wakeup.
+ * Drivers without a frame structure (PWM) never signal, so the caller
+ * has to poll them when this times out. Only one task may wait.
+ * @param[in] timeout_ms how long to wait
+ * @param[out] frame_time PIOS_DELAY raw time the latest frame arrived at
+ * @returns true if a frame arrived, false on timeout
+ */
+bool PIOS_RCVR_WaitForFrame(uint32_t timeout_ms, uint32_t *frame_time)
+{
+#if defined(PIOS_INCLUDE_FREERTOS)
+	if (!pios_rcvr_frame_sem) {
+		vSemaphoreCreateBinary(pios_rcvr_frame_sem);
+		PIOS_Assert(pios_rcvr_frame_sem);
+		/* Created in the given state, frames before now do not count */
+		xSemaphoreTake(pios_rcvr_frame_sem, 0);
+	}
+
+	if (xSemaphoreTake(pios_rcvr_frame_sem, MS2TICKS(timeout_ms)) != pdTRUE)
+		return false;
+
+	if (frame_time)
+		*frame_time = pios_rcvr_frame_time;
+
+	return true;
+#else
+	PIOS_DELAY_WaitmS(timeout_ms);
+	return false;
+#endif
+}
+
 #endif
 
 /**
@@ -56,11 +56,14 @@ enum pios_sbus_dev_magic {
 
 struct pios_sbus_state {
 	uint16_t channel_data[PIOS_SBUS_NUM_INPUTS];
-	uint8_t received_data[SBUS_FRAME_LENGTH - 2];
+	/* one spare byte, the word loads of the last channels read past the flags */
+	uint8_t received_data[SBUS_FRAME_LENGTH - 1];
 	uint8_t receive_timer;
 	uint8_t failsafe_timer;
 	uint8_t frame_found;
 	uint8_t byte_count;
+	/* frames decoded, only used by the receive callback to signal them */
+	uint8_t frame_count;
 };
 
 struct pios_sbus_dev {
@@ -101,6 +104,7 @@ static void PIOS_SBus_ResetState(struct pios_sbus_state *state)
 	state->receive_timer = 0;
 	state->failsafe_timer = 0;
 	state->frame_found = 0;
+	state->frame_count = 0;
 	PIOS_SBus_ResetChannels(state);
 }
 
@@ -170,41 +174,101 @@ static int32_t PIOS_SBus_Get(uintptr_t rcvr_id, uint8_t channel)
 	return sbus_dev->state.channel_data[channel];
 }
 
+/* Unaligned little endian load, a single LDR on Cortex-M3/M4 */
+static inline uint32_t PIOS_SBus_LoadWord(const uint8_t *p)
+{
+	uint32_t w;
+	memcpy(&w, p, sizeof(w));
+	return w;
+}
+
 /**
- * Compute channel_data[] from received_data[].
- * For efficiency it unrolls first 8 channels without loops and does the
- * same for other 8 channels. Also 2 discrete channels will be set.
+ * Compute the channels from the 22 data bytes and the flags of a frame.
+ * Every 11 bit channel starts at most 7 bits into a byte, so it is taken
+ * from one 32 bit load at that byte. The loads of the last channels read
+ * one byte past the flags, which must be accessible.
  */
-static void PIOS_SBus_UnrollChannels(struct pios_sbus_state *state)
+static void PIOS_SBus_UnrollChannels(uint16_t *d, const uint8_t *s)
 {
-	uint8_t *s = state->received_data;
-	uint16_t *d = state->channel_data;
-
-#define F(v,s) (((v) >> (s)) & 0x7ff)
-
-	/* unroll channels 1-8 */
-	*d++ = F(s[0] | s[1] << 8, 0);
-	*d++ = F(s[1] | s[2] << 8, 3);
-	*d++ = F(s[2] | s[3] << 8 | s[4] << 16, 6);
-	*d++ = F(s[4] | s[5] << 8, 1);
-	*d++ = F(s[5] | s[6] << 8, 4);
-	*d++ = F(s[6] | s[7] << 8 | s[8] << 16, 7);
-	*d++ = F(s[8] | s[9] << 8, 2);
-	*d++ = F(s[9] | s[10] << 8, 5);
-
-	/* unroll channels 9-16 */
-	*d++ = F(s[11] | s[12] << 8, 0);
-	*d++ = F(s[12] | s[13] << 8, 3);
-	*d++ = F(s[13] | s[14] << 8 | s[15] << 16, 6);
-	*d++ = F(s[15] | s[16] << 8, 1);
-	*d++ = F(s[16] | s[17] << 8, 4);
-	*d++ = F(s[17] | s[18] << 8 | s[19] << 16, 7);
-	*d++ = F(s[19] | s[20] << 8, 2);
-	*d++ = F(s[20] | s[21] << 8, 5);
+#define F(n) ((PIOS_SBus_LoadWord(&s[(n) * 11 / 8]) >> ((n) * 11 % 8)) & 0x7ff)
+
+	/* unroll channels 1-16 */
+	d[0] = F(0);
+	d[1] = F(1);
+	d[2] = F(2);
+	d[3] = F(3);
+	d[4] = F(4);
+	d[5] = F(5);
+	d[6] = F(6);
+	d[7] = F(7);
+	d[8] = F(8);
+	d[9] = F(9);
+	d[10] = F(10);
+	d[11] = F(11);
+	d[12] = F(12);
+	d[13] = F(13);
+	d[14] = F(14);
+	d[15] = F(15);
+
+#undef F
 
 	/* unroll discrete channels 17 and 18 */
-	*d++ = (s[22] & SBUS_FLAG_DC1) ? SBUS_VALUE_MAX : SBUS_VALUE_MIN;
-	*d++ = (s[22] & SBUS_FLAG_DC2) ? SBUS_VALUE_MAX : SBUS_VALUE_MIN;
+	d[16] = (s[22] & SBUS_FLAG_DC1) ? SBUS_VALUE_MAX : SBUS_VALUE_MIN;
+	d[17] = (s[22] & SBUS_FLAG_DC2) ? SBUS_VALUE_MAX : SBUS_VALUE_MIN;
+}
+
+/* Apply a complete frame, s points to the byte after the SOF byte */
+static void PIOS_SBus_ProcessFrame(struct pios_sbus_state *state, const uint8_t *s)
+{
+	uint8_t flags = s[SBUS_FRAME_LENGTH - 3];
+	if (flags & SBUS_FLAG_FL) {
+		/* frame lost, do not update */
+		return;
+	} else if (flags & SBUS_FLAG_FS) {
+		/* failsafe flag active */
+		PIOS_SBus_ResetChannels(state);
+	} else {
+		/* data looking good */
+		PIOS_SBus_UnrollChannels(state->channel_data, s);
+		state->failsafe_timer = 0;
+	}
+
+	state->frame_count++;
+}
+
+/**
+ * Decode whole frames straight from the receive buffer. Applies when the
+ * decoder waits for a new frame and the buffer starts with the SOF byte
+ * and holds the matching EOF byte, as with drivers that deliver more than
+ * one byte per callback. Frames that follow back to back in the
+ * same buffer are decoded too, they are aligned by the first one.
+ * \return the number of bytes consumed, 0 to use the byte-wise path
+ */
+static uint16_t PIOS_SBus_DecodeBlock(struct pios_sbus_state *state, const uint8_t *buf, uint16_t buf_len)
+{
+	if (!state->frame_found || state->byte_count != 0)
+		return 0;
+
+	if (buf[0] != SBUS_SOF_BYTE)
+		return 0;
+
+	uint16_t used = 0;
+	while (buf_len - used >= SBUS_FRAME_LENGTH && buf[used] == SBUS_SOF_BYTE) {
+		if (buf[used + SBUS_FRAME_LENGTH - 1] != SBUS_EOF_BYTE) {
+			/* discard the whole frame, as the byte-wise path would */
+			if (used == 0)
+				used = SBUS_FRAME_LENGTH;
+			break;
+		}
+
+		PIOS_SBus_ProcessFrame(state, &buf[used + 1]);
+		used += SBUS_FRAME_LENGTH;
+	}
+
+	/* wait for the next pause between frames */
+	state->frame_found = 0;
+
+	return used;
 }
 
 /* Update decoder state processing input byte from the S.Bus stream */
@@ -233,17 +297,7 @@ static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
 	} else {
 		if (b == SBUS_EOF_BYTE) {
 			/* full frame received */
-			uint8_t flags = state->received_data[SBUS_FRAME_LENGTH - 3];
-			if (flags & SBUS_FLAG_FL) {
-				/* frame lost, do not update */
-			} else if (flags & SBUS_FLAG_FS) {
-				/* failsafe flag active */
-				PIOS_SBus_ResetChannels(state);
-			} else {
-				/* data looking good */
-				PIOS_SBus_UnrollChannels(state);
-				state->failsafe_timer = 0;
-			}
+			PIOS_SBus_ProcessFrame(state, state->received_data);
 		} else {
 			/* discard whole frame */
 		}
@@ -266,19 +320,26 @@ static uint16_t PIOS_SBus_RxInCallback(uintptr_t context,
 	PIOS_Assert(valid);
 
 	struct pios_sbus_state *state = &(sbus_dev->state);
+	uint8_t frame_count = state->frame_count;
 
-	/* process byte(s) and clear receive timer */
-	for (uint8_t i = 0; i < buf_len; i++) {
+	/* whole frames can only start right after a pause, i.e. at the start of the buffer */
+	uint16_t i = 0;
+	if (buf_len >= SBUS_FRAME_LENGTH)
+		i = PIOS_SBus_DecodeBlock(state, buf, buf_len);
+
+	/* process remaining byte(s) and clear receive timer */
+	for (; i < buf_len; i++)
 		PIOS_SBus_UpdateState(state, buf[i]);
+
+	if (buf_len > 0)
 		state->receive_timer = 0;
-	}
 
 	/* Always signal that we can accept another byte */
 	if (headroom)
 		*headroom = SBUS_FRAME_LENGTH;
 
-	/* We never need a yield */
-	*need_yield = false;
+	/* Wake up the receiver consumer if a frame was decoded */
+	*need_yield = (frame_count != state->frame_count) ? PIOS_RCVR_ActiveFromISR() : false;
 
 	/* Always indicate that all bytes were consumed */
 	return buf_len;
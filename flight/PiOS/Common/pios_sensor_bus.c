@@ -0,0 +1,225 @@
+/**
+ ******************************************************************************
+ * @file       pios_sensor_bus.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SENSOR_BUS Sensor bus scheduler
+ * @{
+ * @brief Deadline scheduler shared by the sensors on one bus
+ *
+ * Sensors such as the MS5611 spend most of their time converting, with
+ * the bus idle, and used to sleep a dedicated task through that window.
+ * Instead each driver registers a job with the scheduler of its bus and
+ * returns how long until it needs the bus again. A single task per bus
+ * runs whichever job is due, earliest deadline first, so one sensor's
+ * conversion window is used to service the others.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+#include "pios_sensor_bus.h"
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+#include "pios_semaphore.h"
+#endif
+
+/* Private constants */
+#define SENSOR_BUS_TASK_PRIORITY	(tskIDLE_PRIORITY + configMAX_PRIORITIES - 1)	// max priority
+#define SENSOR_BUS_TASK_STACK		(512 / 4)
+
+struct pios_sensor_bus {
+	uint32_t bus_id;
+	struct pios_sensor_bus_job *jobs;
+	struct pios_sensor_bus *next;
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+	struct pios_semaphore *wake;
+	xTaskHandle task;
+#endif
+};
+
+static struct pios_sensor_bus *sensor_buses;
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+static void PIOS_SENSOR_BUS_Task(void *parameters);
+#endif
+
+/**
+ * @brief Get the scheduler for a bus, creating it the first time
+ * @param[in] bus_id the id of the bus driver (e.g. the i2c adapter id)
+ * @returns the scheduler or NULL if out of memory
+ */
+struct pios_sensor_bus *PIOS_SENSOR_BUS_Get(uint32_t bus_id)
+{
+	struct pios_sensor_bus *bus;
+
+	for (bus = sensor_buses; bus != NULL; bus = bus->next) {
+		if (bus->bus_id == bus_id)
+			return bus;
+	}
+
+	bus = (struct pios_sensor_bus *)PIOS_malloc(sizeof(*bus));
+	if (bus == NULL)
+		return NULL;
+
+	memset(bus, 0, sizeof(*bus));
+	bus->bus_id = bus_id;
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+	bus->wake = PIOS_Semaphore_Create();
+	if (bus->wake == NULL) {
+		PIOS_free(bus);
+		return NULL;
+	}
+#endif
+
+	bus->next = sensor_buses;
+	sensor_buses = bus;
+
+	return bus;
+}
+
+/**
+ * @brief Add a job to a bus. The bus task is started with the first job.
+ * @param[in] bus the scheduler from @ref PIOS_SENSOR_BUS_Get
+ * @param[in] job the job, which must stay allocated
+ * @param[in] delay_us time until the first run, or PIOS_SENSOR_BUS_IDLE
+ * @returns 0 on success, -1 on error
+ */
+int32_t PIOS_SENSOR_BUS_AddJob(struct pios_sensor_bus *bus, struct pios_sensor_bus_job *job, uint32_t delay_us)
+{
+	if (bus == NULL || job == NULL || job->run == NULL)
+		return -1;
+
+	job->bus = bus;
+	job->idle = (delay_us == PIOS_SENSOR_BUS_IDLE);
+	job->triggered = false;
+	job->deadline_us = PIOS_DELAY_GetuS() + delay_us;
+	job->next = bus->jobs;
+
+	/* Publishing the head is a single store, so a running bus task sees
+	 * either the old list or the complete new one */
+	bus->jobs = job;
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+	if (bus->task == NULL) {
+		portBASE_TYPE result = xTaskCreate(PIOS_SENSOR_BUS_Task, (const signed char *)"pios_sensorbus",
+						SENSOR_BUS_TASK_STACK, bus, SENSOR_BUS_TASK_PRIORITY,
+						&bus->task);
+		PIOS_Assert(result == pdPASS);
+	} else {
+		PIOS_Semaphore_Give(bus->wake);
+	}
+#endif
+
+	return 0;
+}
+
+/**
+ * @brief Make a job due now. Safe to call from an interrupt.
+ * @returns true if a higher priority task was woken
+ */
+bool PIOS_SENSOR_BUS_TriggerFromISR(struct pios_sensor_bus_job *job)
+{
+	if (job == NULL || job->bus == NULL)
+		return false;
+
+	job->triggered = true;
+
+	bool woken = false;
+#if defined(PIOS_INCLUDE_FREERTOS)
+	PIOS_Semaphore_Give_FromISR(job->bus->wake, &woken);
+#endif
+
+	return woken;
+}
+
+/**
+ * @brief Run every job that is due, earliest deadline first, until none is.
+ * A job's deadline is reset from the time it returns, so jobs that finish
+ * late push only themselves back.
+ * @returns the time in microseconds until the next deadline, or
+ * PIOS_SENSOR_BUS_IDLE if every job is waiting for a trigger
+ */
+uint32_t PIOS_SENSOR_BUS_Run(struct pios_sensor_bus *bus)
+{
+	PIOS_Assert(bus != NULL);
+
+	while (true) {
+		uint32_t now = PIOS_DELAY_GetuS();
+		uint32_t wait_us = PIOS_SENSOR_BUS_IDLE;
+		struct pios_sensor_bus_job *due = NULL;
+		int32_t due_remaining = 0;
+
+		for (struct pios_sensor_bus_job *job = bus->jobs; job != NULL; job = job->next) {
+			int32_t remaining;
+
+			if (job->triggered)
+				remaining = 0;
+			else if (job->idle)
+				continue;
+			else
+				remaining = (int32_t)(job->deadline_us - now);
+
+			if (remaining > 0) {
+				if ((uint32_t)remaining < wait_us)
+					wait_us = remaining;
+			} else if (due == NULL || remaining < due_remaining) {
+				due = job;
+				due_remaining = remaining;
+			}
+		}
+
+		if (due == NULL)
+			return wait_us;
+
+		due->triggered = false;
+		uint32_t delay_us = due->run(due->ctx);
+
+		due->idle = (delay_us == PIOS_SENSOR_BUS_IDLE);
+		if (!due->idle)
+			due->deadline_us = PIOS_DELAY_GetuS() + delay_us;
+	}
+}
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+/**
+ * The bus task, sleeps until the next deadline or trigger
+ */
+static void PIOS_SENSOR_BUS_Task(void *parameters)
+{
+	struct pios_sensor_bus *bus = (struct pios_sensor_bus *)parameters;
+
+	while (1) {
+		uint32_t wait_us = PIOS_SENSOR_BUS_Run(bus);
+
+		/* A tick timeout can expire up to one tick short, so round up.
+		 * Anything woken early is held back by the next Run(). */
+		uint32_t timeout_ms = PIOS_SEMAPHORE_TIMEOUT_MAX;
+		if (wait_us != PIOS_SENSOR_BUS_IDLE)
+			timeout_ms = wait_us / 1000 + 1;
+
+		PIOS_Semaphore_Take(bus->wake, timeout_ms);
+	}
+}
+#endif
+
+/**
+ * @}
+ * @}
+ */
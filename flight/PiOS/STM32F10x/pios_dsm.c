@@ -235,10 +235,14 @@ stream_error:
 	return -1;
 }
 
-/* Update decoder state processing input byte from the DSMx stream */
-static void PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
+/**
+ * Update decoder state processing input byte from the DSMx stream
+ * \output true if a complete frame was accepted
+ */
+static bool PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
 {
 	struct pios_dsm_state *state = &(dsm_dev->state);
+	bool frame_accepted = false;
 	if (state->frame_found) {
 		/* receiving the data frame */
 		if (state->byte_count < DSM_FRAME_LENGTH) {
@@ -246,15 +250,19 @@ static void PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
 			state->received_data[state->byte_count++] = byte;
 			if (state->byte_count == DSM_FRAME_LENGTH) {
 				/* full frame received - process and wait for new one */
-				if (!PIOS_DSM_UnrollChannels(dsm_dev))
+				if (!PIOS_DSM_UnrollChannels(dsm_dev)) {
 					/* data looking good */
 					state->failsafe_timer = 0;
+					frame_accepted = true;
+				}
 
 				/* prepare for the next frame */
 				state->frame_found = 0;
 			}
 		}
 	}
+
+	return frame_accepted;
 }
 
 /* Initialise DSM receiver interface */
@@ -310,8 +318,9 @@ static uint16_t PIOS_DSM_RxInCallback(uintptr_t context,
 	PIOS_Assert(valid);
 
 	/* process byte(s) and clear receive timer */
+	bool frame_accepted = false;
 	for (uint8_t i = 0; i < buf_len; i++) {
-		PIOS_DSM_UpdateState(dsm_dev, buf[i]);
+		frame_accepted |= PIOS_DSM_UpdateState(dsm_dev, buf[i]);
 		dsm_dev->state.receive_timer = 0;
 	}
 
@@ -319,8 +328,8 @@ static uint16_t PIOS_DSM_RxInCallback(uintptr_t context,
 	if (headroom)
 		*headroom = DSM_FRAME_LENGTH;
 
-	/* We never need a yield */
-	*need_yield = false;
+	/* Wake up the receiver consumer if a frame was decoded */
+	*need_yield = frame_accepted ? PIOS_RCVR_ActiveFromISR() : false;
 
 	/* Always indicate that all bytes were consumed */
 	return buf_len;
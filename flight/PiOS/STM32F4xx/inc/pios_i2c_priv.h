@@ -43,6 +43,9 @@ struct pios_i2c_adapter_cfg {
 	struct stm32_gpio sda;
 	struct stm32_irq event;
 	struct stm32_irq error;
+
+	/* Reads of two bytes or more by DMA (rx stream and its irq), NULL for interrupts only */
+	const struct stm32_dma *dma;
 };
 
 enum pios_i2c_adapter_magic {
@@ -65,6 +68,8 @@ enum i2c_adapter_state {
 	I2C_STATE_R_MORE_TXN_PRE_MIDDLE,
 	I2C_STATE_R_MORE_TXN_PRE_LAST,
 	I2C_STATE_R_MORE_TXN_POST_LAST,
+	I2C_STATE_R_MORE_TXN_DMA,
+	I2C_STATE_R_MORE_TXN_DMA_DONE,
 
 	I2C_STATE_R_LAST_TXN_ADDR,
 	I2C_STATE_R_LAST_TXN_PRE_ONE,
@@ -72,6 +77,8 @@ enum i2c_adapter_state {
 	I2C_STATE_R_LAST_TXN_PRE_MIDDLE,
 	I2C_STATE_R_LAST_TXN_PRE_LAST,
 	I2C_STATE_R_LAST_TXN_POST_LAST,
+	I2C_STATE_R_LAST_TXN_DMA,
+	I2C_STATE_R_LAST_TXN_DMA_DONE,
 
 	I2C_STATE_W_MORE_TXN_ADDR,
 	I2C_STATE_W_MORE_TXN_PRE_MIDDLE,
@@ -99,10 +106,12 @@ enum i2c_adapter_event {
 	I2C_EVENT_ADDR_SENT_LEN_EQ_1,
 	I2C_EVENT_ADDR_SENT_LEN_EQ_2,
 	I2C_EVENT_ADDR_SENT_LEN_GT_2,
+	I2C_EVENT_ADDR_SENT_DMA,
 	I2C_EVENT_TRANSFER_DONE_LEN_EQ_0,
 	I2C_EVENT_TRANSFER_DONE_LEN_EQ_1,
 	I2C_EVENT_TRANSFER_DONE_LEN_EQ_2,
 	I2C_EVENT_TRANSFER_DONE_LEN_GT_2,
+	I2C_EVENT_DMA_DONE,
 	I2C_EVENT_NACK,
 	I2C_EVENT_STOPPED,
 	I2C_EVENT_AUTO,
@@ -144,6 +153,22 @@ struct pios_i2c_adapter {
 	uint8_t *active_byte;
 	uint8_t *last_byte;
 
+	/* The active read txn is being received by the DMA */
+	bool dma_rx;
+
+	/* Request on the bus and those waiting for it */
+	struct pios_i2c_request *active_request;
+	struct pios_i2c_request *queue_head;
+	struct pios_i2c_request *queue_tail;
+
+	/* Used by the blocking PIOS_I2C_Transfer */
+	struct pios_i2c_request transfer_request;
+	volatile int32_t transfer_result;
+
+	struct pios_i2c_stats stats;
+	uint32_t stats_bytes;
+	uint32_t stats_time_us;
+
 #if defined(PIOS_I2C_DIAGNOSTICS)
 	volatile struct pios_i2c_fault_history i2c_adapter_fault_history;
 
@@ -169,4 +194,33 @@ struct pios_i2c_adapter {
 
 int32_t PIOS_I2C_Init(uint32_t * i2c_id, const struct pios_i2c_adapter_cfg * cfg);
 
+/* Transfer state machine (pios_i2c_fsm.c), called with the I2C irqs masked */
+void i2c_adapter_fsm_init(struct pios_i2c_adapter *i2c_adapter);
+void i2c_adapter_inject_event(struct pios_i2c_adapter *i2c_adapter, enum i2c_adapter_event event, bool *woken);
+void i2c_adapter_started(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+void i2c_adapter_address_sent(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+void i2c_adapter_byte_done(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+void i2c_adapter_dma_done(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+void i2c_adapter_submit(struct pios_i2c_adapter *i2c_adapter, struct pios_i2c_request *request, bool *woken);
+bool i2c_adapter_abort(struct pios_i2c_adapter *i2c_adapter, struct pios_i2c_request *request, bool *woken);
+#if defined(PIOS_I2C_DIAGNOSTICS)
+void i2c_adapter_log_fault(struct pios_i2c_adapter *i2c_adapter, enum pios_i2c_error_type type);
+#endif
+
+/* Peripheral access used by the state machine (pios_i2c.c) */
+#define I2C_HAL_IRQ_EVT 0x01
+#define I2C_HAL_IRQ_BUF 0x02
+#define I2C_HAL_IRQ_ERR 0x04
+
+void i2c_hal_irq_config(struct pios_i2c_adapter *i2c_adapter, uint8_t irqs, bool enable);
+void i2c_hal_start(struct pios_i2c_adapter *i2c_adapter, bool enable);
+void i2c_hal_stop(struct pios_i2c_adapter *i2c_adapter);
+void i2c_hal_ack(struct pios_i2c_adapter *i2c_adapter, bool enable);
+void i2c_hal_send_address(struct pios_i2c_adapter *i2c_adapter, uint16_t addr, bool read);
+void i2c_hal_send_byte(struct pios_i2c_adapter *i2c_adapter, uint8_t byte);
+uint8_t i2c_hal_receive_byte(struct pios_i2c_adapter *i2c_adapter);
+bool i2c_hal_dma_rx_start(struct pios_i2c_adapter *i2c_adapter, uint8_t *buf, uint16_t len);
+void i2c_hal_dma_stop(struct pios_i2c_adapter *i2c_adapter);
+void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter);
+
 #endif /* PIOS_I2C_PRIV_H */
@@ -36,567 +36,90 @@
 
 #include <pios_i2c_priv.h>
 
-static void i2c_adapter_inject_event(struct pios_i2c_adapter *i2c_adapter, enum i2c_adapter_event event, bool *woken);
-static void i2c_adapter_fsm_init(struct pios_i2c_adapter *i2c_adapter);
-static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter);
-#if defined(PIOS_I2C_DIAGNOSTICS)
-static void i2c_adapter_log_fault(struct pios_i2c_adapter *i2c_adapter, enum pios_i2c_error_type type);
-#endif
-
-static void go_fsm_fault(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_bus_error(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_nack(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_stopped(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_starting(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-
-static void go_r_more_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_r_more_txn_pre_one(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_r_more_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_r_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_r_more_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_r_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-
-static void go_r_last_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_r_last_txn_pre_one(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_r_last_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_r_last_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_r_last_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_r_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-
-static void go_w_more_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_w_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_w_more_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_w_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-
-static void go_w_last_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_w_last_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_w_last_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-static void go_w_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-
-struct i2c_adapter_transition {
-	void (*entry_fn)(struct pios_i2c_adapter *i2c_adapter, bool *woken);
-	enum i2c_adapter_state next_state[I2C_EVENT_NUM_EVENTS];
-};
-
-static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM_STATES] = {
-	[I2C_STATE_FSM_FAULT] = {
-		.entry_fn = go_fsm_fault,
-		.next_state = {
-			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
-		},
-	},
-	[I2C_STATE_BUS_ERROR] = {
-		.entry_fn = go_bus_error,
-		.next_state = {
-			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
-		},
-	},
-	[I2C_STATE_NACK] = {
-		.entry_fn = go_nack,
-		.next_state = {
-			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
-		},
-	},
-	[I2C_STATE_STOPPED] = {
-		.entry_fn = go_stopped,
-		.next_state = {
-			[I2C_EVENT_START] = I2C_STATE_STARTING,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_STARTING] = {
-		.entry_fn = go_starting,
-		.next_state = {
-			[I2C_EVENT_R_MORE_TXN_STARTED] = I2C_STATE_R_MORE_TXN_ADDR,
-			[I2C_EVENT_W_MORE_TXN_STARTED] = I2C_STATE_W_MORE_TXN_ADDR,
-			[I2C_EVENT_R_LAST_TXN_STARTED] = I2C_STATE_R_LAST_TXN_ADDR,
-			[I2C_EVENT_W_LAST_TXN_STARTED] = I2C_STATE_W_LAST_TXN_ADDR,
-			[I2C_EVENT_NACK] = I2C_STATE_NACK,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-
-	/*
-	 * Read with restart
-	 */
-	[I2C_STATE_R_MORE_TXN_ADDR] = {
-		.entry_fn = go_r_more_txn_addr,
-		.next_state = {
-			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_R_MORE_TXN_PRE_ONE,
-			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_R_MORE_TXN_PRE_FIRST,
-			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_R_MORE_TXN_PRE_FIRST,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_R_MORE_TXN_PRE_ONE] = {
-		.entry_fn = go_r_more_txn_pre_one,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_R_MORE_TXN_POST_LAST,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_R_MORE_TXN_PRE_FIRST] = {
-		.entry_fn = go_r_more_txn_pre_first,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_R_MORE_TXN_PRE_LAST,
-			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_R_MORE_TXN_PRE_MIDDLE,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_R_MORE_TXN_PRE_MIDDLE] = {
-		.entry_fn = go_r_more_txn_pre_middle,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_R_MORE_TXN_PRE_LAST,
-			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_R_MORE_TXN_PRE_MIDDLE,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_R_MORE_TXN_PRE_LAST] = {
-		.entry_fn = go_r_more_txn_pre_last,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_R_MORE_TXN_POST_LAST,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_R_MORE_TXN_POST_LAST] = {
-		.entry_fn = go_r_more_txn_post_last,
-		.next_state = {
-			[I2C_EVENT_R_MORE_TXN_STARTED] = I2C_STATE_R_MORE_TXN_ADDR,
-			[I2C_EVENT_W_MORE_TXN_STARTED] = I2C_STATE_W_MORE_TXN_ADDR,
-			[I2C_EVENT_R_LAST_TXN_STARTED] = I2C_STATE_R_LAST_TXN_ADDR,
-			[I2C_EVENT_W_LAST_TXN_STARTED] = I2C_STATE_W_LAST_TXN_ADDR,
-			[I2C_EVENT_NACK] = I2C_STATE_NACK,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-
-	/*
-	 * Read with stop
-	 */
-	[I2C_STATE_R_LAST_TXN_ADDR] = {
-		.entry_fn = go_r_last_txn_addr,
-		.next_state = {
-			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_R_LAST_TXN_PRE_ONE,
-			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_R_LAST_TXN_PRE_FIRST,
-			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_R_LAST_TXN_PRE_FIRST,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_R_LAST_TXN_PRE_ONE] = {
-		.entry_fn = go_r_last_txn_pre_one,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_R_LAST_TXN_POST_LAST,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_R_LAST_TXN_PRE_FIRST] = {
-		.entry_fn = go_r_last_txn_pre_first,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_R_LAST_TXN_PRE_LAST,
-			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_R_LAST_TXN_PRE_MIDDLE,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_R_LAST_TXN_PRE_MIDDLE] = {
-		.entry_fn = go_r_last_txn_pre_middle,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_R_LAST_TXN_PRE_LAST,
-			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_R_LAST_TXN_PRE_MIDDLE,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_R_LAST_TXN_PRE_LAST] = {
-		.entry_fn = go_r_last_txn_pre_last,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_R_LAST_TXN_POST_LAST,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_R_LAST_TXN_POST_LAST] = {
-		.entry_fn = go_r_last_txn_post_last,
-		.next_state = {
-			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
-		},
-	},
-
-	/*
-	 * Write with restart
-	 */
-	[I2C_STATE_W_MORE_TXN_ADDR] = {
-		.entry_fn = go_w_more_txn_addr,
-		.next_state = {
-			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_W_MORE_TXN_PRE_LAST,
-			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_W_MORE_TXN_PRE_MIDDLE,
-			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_W_MORE_TXN_PRE_MIDDLE,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_W_MORE_TXN_PRE_MIDDLE] = {
-		.entry_fn = go_w_more_txn_pre_middle,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_W_MORE_TXN_PRE_LAST,
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_W_MORE_TXN_PRE_MIDDLE,
-			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_W_MORE_TXN_PRE_MIDDLE,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_W_MORE_TXN_PRE_LAST] = {
-		.entry_fn = go_w_more_txn_pre_last,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_0] = I2C_STATE_W_MORE_TXN_POST_LAST,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_W_MORE_TXN_POST_LAST] = {
-		.entry_fn = go_w_more_txn_post_last,
-		.next_state = {
-			[I2C_EVENT_R_MORE_TXN_STARTED] = I2C_STATE_R_MORE_TXN_ADDR,
-			[I2C_EVENT_W_MORE_TXN_STARTED] = I2C_STATE_W_MORE_TXN_ADDR,
-			[I2C_EVENT_R_LAST_TXN_STARTED] = I2C_STATE_R_LAST_TXN_ADDR,
-			[I2C_EVENT_W_LAST_TXN_STARTED] = I2C_STATE_W_LAST_TXN_ADDR,
-			[I2C_EVENT_NACK] = I2C_STATE_NACK,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-
-	/*
-	 * Write with stop
-	 */
-	[I2C_STATE_W_LAST_TXN_ADDR] = {
-		.entry_fn = go_w_last_txn_addr,
-		.next_state = {
-			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_W_LAST_TXN_PRE_LAST,
-			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_W_LAST_TXN_PRE_MIDDLE,
-			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_W_LAST_TXN_PRE_MIDDLE,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_W_LAST_TXN_PRE_MIDDLE] = {
-		.entry_fn = go_w_last_txn_pre_middle,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_W_LAST_TXN_PRE_LAST,
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_W_LAST_TXN_PRE_MIDDLE,
-			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_W_LAST_TXN_PRE_MIDDLE,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_W_LAST_TXN_PRE_LAST] = {
-		.entry_fn = go_w_last_txn_pre_last,
-		.next_state = {
-			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_0] = I2C_STATE_W_LAST_TXN_POST_LAST,
-			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
-		},
-	},
-	[I2C_STATE_W_LAST_TXN_POST_LAST] = {
-		.entry_fn = go_w_last_txn_post_last,
-		.next_state = {
-			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
-		},
-	},
-};
-
-static void go_fsm_fault(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	i2c_adapter->bus_error = true;
-	i2c_adapter_reset_bus(i2c_adapter);
-}
-
-static void go_nack(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	i2c_adapter->nack = true;
-
-	// setup handling of this byte
-	I2C_AcknowledgeConfig(i2c_adapter->cfg->regs, DISABLE);
-	I2C_GenerateSTART(i2c_adapter->cfg->regs, DISABLE);
-	I2C_GenerateSTOP(i2c_adapter->cfg->regs, ENABLE);
-}
-
-static void go_bus_error(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	i2c_adapter->bus_error = true;
-	i2c_adapter_reset_bus(i2c_adapter);
-}
-
-static void go_stopped(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// disable all irqs
-	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_EVT | I2C_IT_BUF | I2C_IT_ERR, DISABLE);
-
-	/* wake up blocked PIOS_I2C_Transfer() */
-	PIOS_Semaphore_Give_FromISR(i2c_adapter->sem_ready, woken);
-}
-
-static void go_starting(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// set up current txn byte pointers
-	i2c_adapter->active_byte = &(i2c_adapter->active_txn->buf[0]);
-	i2c_adapter->last_byte = &(i2c_adapter->active_txn->buf[i2c_adapter->active_txn->len - 1]);
-
-	// enabled interrupts
-	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_EVT | I2C_IT_ERR, ENABLE);
-
-	// generate a start condition
-	I2C_GenerateSTART(i2c_adapter->cfg->regs, ENABLE);
-}
-
-/*
- * Read with restart
- */
-static void go_r_more_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// enable buffer RxNE
-	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_BUF, ENABLE);
-
-	I2C_Send7bitAddress(i2c_adapter->cfg->regs, (i2c_adapter->active_txn->addr) << 1, I2C_Direction_Receiver);
-}
-
-static void go_r_more_txn_pre_one(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// send a nack on the last byte
-	I2C_AcknowledgeConfig(i2c_adapter->cfg->regs, DISABLE);
-}
-
-static void go_r_more_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// ack all following bytes
-	I2C_AcknowledgeConfig(i2c_adapter->cfg->regs, ENABLE);
-}
-
-static void go_r_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// read received byte from buffer
-	*i2c_adapter->active_byte = I2C_ReceiveData(i2c_adapter->cfg->regs);
-
-	/* Move to the next byte */
-	i2c_adapter->active_byte++;
-}
-
-static void go_r_more_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// read received byte from buffer
-	*i2c_adapter->active_byte = I2C_ReceiveData(i2c_adapter->cfg->regs);
-
-	// send a nack on the last byte
-	I2C_AcknowledgeConfig(i2c_adapter->cfg->regs, DISABLE);
-
-	/* Move to the next byte */
-	i2c_adapter->active_byte++;
-}
-
-static void go_r_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// the last byte of this txn has been received, so disable the buffer RxNE
-	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_BUF, DISABLE);
-
-	// read received byte from buffer
-	*i2c_adapter->active_byte = I2C_ReceiveData(i2c_adapter->cfg->regs);
-
-	/* Move to the next byte */
-	i2c_adapter->active_byte++;
-
-	/* Move to the next transaction */
-	i2c_adapter->active_txn++;
-
-	// set up current txn byte pointers
-	i2c_adapter->active_byte = &(i2c_adapter->active_txn->buf[0]);
-	i2c_adapter->last_byte = &(i2c_adapter->active_txn->buf[i2c_adapter->active_txn->len - 1]);
-
-	// generate repeated START condition
-	I2C_GenerateSTART(i2c_adapter->cfg->regs, ENABLE);
-}
-
 /*
- * Read with stop
+ * Peripheral access for the transfer state machine in pios_i2c_fsm.c
  */
-static void go_r_last_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// enable buffer RxNE
-	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_BUF, ENABLE);
-
-	I2C_Send7bitAddress(i2c_adapter->cfg->regs, (i2c_adapter->active_txn->addr) << 1, I2C_Direction_Receiver);
-}
-
-static void go_r_last_txn_pre_one(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+void i2c_hal_irq_config(struct pios_i2c_adapter *i2c_adapter, uint8_t irqs, bool enable)
 {
-	// send a nack on the last byte
-	I2C_AcknowledgeConfig(i2c_adapter->cfg->regs, DISABLE);
-}
-
-static void go_r_last_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// ack all following bytes
-	I2C_AcknowledgeConfig(i2c_adapter->cfg->regs, ENABLE);
-}
+	uint16_t it = 0;
 
-static void go_r_last_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// read received byte from buffer
-	*i2c_adapter->active_byte = I2C_ReceiveData(i2c_adapter->cfg->regs);
+	if (irqs & I2C_HAL_IRQ_EVT)
+		it |= I2C_IT_EVT;
+	if (irqs & I2C_HAL_IRQ_BUF)
+		it |= I2C_IT_BUF;
+	if (irqs & I2C_HAL_IRQ_ERR)
+		it |= I2C_IT_ERR;
 
-	/* Move to the next byte */
-	i2c_adapter->active_byte++;
+	I2C_ITConfig(i2c_adapter->cfg->regs, it, enable ? ENABLE : DISABLE);
 }
 
-static void go_r_last_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+void i2c_hal_start(struct pios_i2c_adapter *i2c_adapter, bool enable)
 {
-	// read received byte from buffer
-	*i2c_adapter->active_byte = I2C_ReceiveData(i2c_adapter->cfg->regs);
-
-	// send a nack on the last byte
-	I2C_AcknowledgeConfig(i2c_adapter->cfg->regs, DISABLE);
-
-	/* Move to the next byte */
-	i2c_adapter->active_byte++;
+	I2C_GenerateSTART(i2c_adapter->cfg->regs, enable ? ENABLE : DISABLE);
 }
 
-static void go_r_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+void i2c_hal_stop(struct pios_i2c_adapter *i2c_adapter)
 {
-	// the last byte of this txn has been received, so disable the buffer RxNE
-	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_BUF, DISABLE);
-
-	// read received byte from buffer
-	*i2c_adapter->active_byte = I2C_ReceiveData(i2c_adapter->cfg->regs);
-
-	// generate a stop condition
 	I2C_GenerateSTOP(i2c_adapter->cfg->regs, ENABLE);
-
-	/* Move to the next byte */
-	i2c_adapter->active_byte++;
-
-	/* Move to the next transaction */
-	i2c_adapter->active_txn++;
 }
 
-
-/*
- * Write with restart
- */
-static void go_w_more_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+void i2c_hal_ack(struct pios_i2c_adapter *i2c_adapter, bool enable)
 {
-	I2C_Send7bitAddress(i2c_adapter->cfg->regs, (i2c_adapter->active_txn->addr) << 1, I2C_Direction_Transmitter);
+	I2C_AcknowledgeConfig(i2c_adapter->cfg->regs, enable ? ENABLE : DISABLE);
 }
 
-static void go_w_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+void i2c_hal_send_address(struct pios_i2c_adapter *i2c_adapter, uint16_t addr, bool read)
 {
-	// write byte to buffer
-	I2C_SendData(i2c_adapter->cfg->regs, *i2c_adapter->active_byte);
-
-	/* Move to the next byte */
-	i2c_adapter->active_byte++;
+	I2C_Send7bitAddress(i2c_adapter->cfg->regs, addr << 1, read ? I2C_Direction_Receiver : I2C_Direction_Transmitter);
 }
 
-static void go_w_more_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+void i2c_hal_send_byte(struct pios_i2c_adapter *i2c_adapter, uint8_t byte)
 {
-	// write byte to buffer
-	I2C_SendData(i2c_adapter->cfg->regs, *i2c_adapter->active_byte);
-
-	/* Move to the next byte */
-	i2c_adapter->active_byte++;
-}
-
-static void go_w_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	/* Move to the next transaction */
-	i2c_adapter->active_txn++;
-
-	// set up current txn byte pointers
-	i2c_adapter->active_byte = &(i2c_adapter->active_txn->buf[0]);
-	i2c_adapter->last_byte = &(i2c_adapter->active_txn->buf[i2c_adapter->active_txn->len - 1]);
-
-	// the last byte of this txn has been transmitted, so disable the buffer TxE
-	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_BUF, DISABLE);
-
-	// also clear the TxE flag to prevent another irq from being thrown by executing a dummy read
-	(void)I2C_ReceiveData(i2c_adapter->cfg->regs);
-
-	// generate restart
-	I2C_GenerateSTART(i2c_adapter->cfg->regs, ENABLE);
+	I2C_SendData(i2c_adapter->cfg->regs, byte);
 }
 
-/*
- * Write with stop
- */
-static void go_w_last_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+uint8_t i2c_hal_receive_byte(struct pios_i2c_adapter *i2c_adapter)
 {
-	I2C_Send7bitAddress(i2c_adapter->cfg->regs, (i2c_adapter->active_txn->addr) << 1, I2C_Direction_Transmitter);
-}
-
-static void go_w_last_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// write byte to buffer
-	I2C_SendData(i2c_adapter->cfg->regs, *i2c_adapter->active_byte);
-
-	/* Move to the next byte */
-	i2c_adapter->active_byte++;
+	return I2C_ReceiveData(i2c_adapter->cfg->regs);
 }
 
-static void go_w_last_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+bool i2c_hal_dma_rx_start(struct pios_i2c_adapter *i2c_adapter, uint8_t *buf, uint16_t len)
 {
-	// write byte to buffer
-	I2C_SendData(i2c_adapter->cfg->regs, *i2c_adapter->active_byte);
+	const struct stm32_dma *dma = i2c_adapter->cfg->dma;
 
-	/* Move to the next byte */
-	i2c_adapter->active_byte++;
-}
+	if (dma == NULL)
+		return false;
 
-static void go_w_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
-{
-	// the last byte of this txn has been transmitted, so disable the buffer TxE
-	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_BUF, DISABLE);
+	DMA_ClearFlag(dma->rx.channel, dma->irq.flags);
+	DMA_MemoryTargetConfig(dma->rx.channel, (uint32_t)buf, DMA_Memory_0);
+	DMA_SetCurrDataCounter(dma->rx.channel, len);
+	DMA_Cmd(dma->rx.channel, ENABLE);
 
-	// setup handling of this byte
-	I2C_GenerateSTOP(i2c_adapter->cfg->regs, ENABLE);
+	/* NACK the final byte without an EV7 for it */
+	I2C_DMALastTransferCmd(i2c_adapter->cfg->regs, ENABLE);
+	I2C_DMACmd(i2c_adapter->cfg->regs, ENABLE);
 
-	/* Move to the next transaction */
-	i2c_adapter->active_txn++;
+	return true;
 }
 
-static void i2c_adapter_inject_event(struct pios_i2c_adapter *i2c_adapter, enum i2c_adapter_event event, bool *woken)
+void i2c_hal_dma_stop(struct pios_i2c_adapter *i2c_adapter)
 {
-#if defined(PIOS_I2C_DIAGNOSTICS)
-	i2c_adapter->i2c_state_event_history[i2c_adapter->i2c_state_event_history_pointer] = event;
-	i2c_adapter->i2c_state_event_history_pointer = (i2c_adapter->i2c_state_event_history_pointer + 1) % I2C_LOG_DEPTH;
+	const struct stm32_dma *dma = i2c_adapter->cfg->dma;
 
-	i2c_adapter->i2c_state_history[i2c_adapter->i2c_state_history_pointer] = i2c_adapter->state;
-	i2c_adapter->i2c_state_history_pointer = (i2c_adapter->i2c_state_history_pointer + 1) % I2C_LOG_DEPTH;
+	if (dma == NULL)
+		return;
 
-	if (i2c_adapter_transitions[i2c_adapter->state].next_state[event] == I2C_STATE_FSM_FAULT)
-		i2c_adapter_log_fault(i2c_adapter, PIOS_I2C_ERROR_FSM);
-#endif
-	/*
-	 * Move to the next state
-	 */
-	i2c_adapter->state = i2c_adapter_transitions[i2c_adapter->state].next_state[event];
-
-	/* Call the entry function (if any) for the next state. */
-	if (i2c_adapter_transitions[i2c_adapter->state].entry_fn) {
-		i2c_adapter_transitions[i2c_adapter->state].entry_fn(i2c_adapter, woken);
-	}
+	I2C_DMACmd(i2c_adapter->cfg->regs, DISABLE);
+	I2C_DMALastTransferCmd(i2c_adapter->cfg->regs, DISABLE);
 
-	/* Process any AUTO transitions in the FSM */
-	while (i2c_adapter_transitions[i2c_adapter->state].next_state[I2C_EVENT_AUTO]) {
-
-#if defined(PIOS_I2C_DIAGNOSTICS)
-		i2c_adapter->i2c_state_history[i2c_adapter->i2c_state_history_pointer] = i2c_adapter->state;
-		i2c_adapter->i2c_state_history_pointer = (i2c_adapter->i2c_state_history_pointer + 1) % I2C_LOG_DEPTH;
-#endif
-
-		i2c_adapter->state = i2c_adapter_transitions[i2c_adapter->state].next_state[I2C_EVENT_AUTO];
-
-		/* Call the entry function (if any) for the next state. */
-		if (i2c_adapter_transitions[i2c_adapter->state].entry_fn) {
-			i2c_adapter_transitions[i2c_adapter->state].entry_fn(i2c_adapter, woken);
-		}
-	}
+	/* Stopping a stream early flags it complete, don't take that for a read */
+	DMA_Cmd(dma->rx.channel, DISABLE);
+	while (DMA_GetCmdStatus(dma->rx.channel) == ENABLE);
+	DMA_ClearFlag(dma->rx.channel, dma->irq.flags);
+	NVIC_ClearPendingIRQ(dma->irq.init.NVIC_IRQChannel);
 }
 
-static void i2c_adapter_fsm_init(struct pios_i2c_adapter *i2c_adapter)
-{
-	i2c_adapter_reset_bus(i2c_adapter);
-	i2c_adapter->state = I2C_STATE_STOPPED;
-}
-
-static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter)
+void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter)
 {
 	uint8_t retry_count = 0;
 	uint8_t retry_count_clk = 0;
@@ -691,38 +214,8 @@ static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter)
 	}
 }
 
-/**
- * Logs the last N state transitions and N IRQ events due to
- * an error condition
- * \param[in] i2c the adapter number to log an event for
- */
-#if defined(PIOS_I2C_DIAGNOSTICS)
-static void i2c_adapter_log_fault(struct pios_i2c_adapter *i2c_adapter, enum pios_i2c_error_type type)
-{
-	i2c_adapter->i2c_adapter_fault_history.type = type;
-	for (uint8_t i = 0; i < I2C_LOG_DEPTH; i++) {
-		i2c_adapter->i2c_adapter_fault_history.evirq[i] =
-				i2c_adapter->i2c_evirq_history[(I2C_LOG_DEPTH + i2c_adapter->i2c_evirq_history_pointer - 1 - i) % I2C_LOG_DEPTH];
-		i2c_adapter->i2c_adapter_fault_history.erirq[i] =
-				i2c_adapter->i2c_erirq_history[(I2C_LOG_DEPTH + i2c_adapter->i2c_erirq_history_pointer - 1 - i) % I2C_LOG_DEPTH];
-		i2c_adapter->i2c_adapter_fault_history.event[i] =
-				i2c_adapter->i2c_state_event_history[(I2C_LOG_DEPTH + i2c_adapter->i2c_state_event_history_pointer - 1 - i) % I2C_LOG_DEPTH];
-		i2c_adapter->i2c_adapter_fault_history.state[i] =
-				i2c_adapter->i2c_state_history[(I2C_LOG_DEPTH + i2c_adapter->i2c_state_history_pointer - 1 - i) % I2C_LOG_DEPTH];
-	}
-	switch (type) {
-	case PIOS_I2C_ERROR_EVENT:
-		i2c_adapter->i2c_bad_event_counter++;
-		break;
-	case PIOS_I2C_ERROR_FSM:
-		i2c_adapter->i2c_fsm_fault_count++;
-		break;
-	case PIOS_I2C_ERROR_INTERRUPT:
-		i2c_adapter->i2c_error_interrupt_counter++;
-		break;
-	}
-}
-#endif
+/* Initialised adapters by peripheral, for the diagnostics */
+static struct pios_i2c_adapter *pios_i2c_adapters[3];
 
 static bool PIOS_I2C_validate(struct pios_i2c_adapter *i2c_adapter)
 {
@@ -774,6 +267,23 @@ int32_t PIOS_I2C_Init(uint32_t *i2c_id, const struct pios_i2c_adapter_cfg *cfg)
 
 	*i2c_id = (uint32_t)i2c_adapter;
 
+	if (cfg->regs == I2C1)
+		pios_i2c_adapters[0] = i2c_adapter;
+	else if (cfg->regs == I2C2)
+		pios_i2c_adapters[1] = i2c_adapter;
+	else if (cfg->regs == I2C3)
+		pios_i2c_adapters[2] = i2c_adapter;
+
+	/* Configure the stream for reads, the buffer is set per txn */
+	if (cfg->dma) {
+		DMA_DeInit(cfg->dma->rx.channel);
+		DMA_Init(cfg->dma->rx.channel, (DMA_InitTypeDef *) & (cfg->dma->rx.init));
+		DMA_ITConfig(cfg->dma->rx.channel, DMA_IT_TC | DMA_IT_TE, ENABLE);
+
+		/* Same priority as the event irq, so the state machine is never reentered */
+		NVIC_Init((NVIC_InitTypeDef *) & (cfg->dma->irq.init));
+	}
+
 	/* Configure and enable I2C interrupts */
 	NVIC_Init((NVIC_InitTypeDef *) & (i2c_adapter->cfg->event.init));
 	NVIC_Init((NVIC_InitTypeDef *) & (i2c_adapter->cfg->error.init));
@@ -814,6 +324,40 @@ int32_t PIOS_I2C_CheckClear(uint32_t i2c_id)
 	return 0;
 }
 
+/**
+ * Check a chain of requests can be run by the state machine
+ */
+static bool PIOS_I2C_validate_requests(const struct pios_i2c_request *request)
+{
+	if (request == NULL)
+		return false;
+
+	for (; request != NULL; request = request->next) {
+		if (request->txn_list == NULL || request->num_txns == 0)
+			return false;
+
+		for (uint32_t i = 0; i < request->num_txns; i++) {
+			if (request->txn_list[i].buf == NULL || request->txn_list[i].len == 0)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Completion of the request behind PIOS_I2C_Transfer
+ */
+static void PIOS_I2C_transfer_done(struct pios_i2c_request *request, int32_t result, bool *woken)
+{
+	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)request->ctx;
+
+	i2c_adapter->transfer_result = result;
+
+	/* wake up blocked PIOS_I2C_Transfer() */
+	PIOS_Semaphore_Give_FromISR(i2c_adapter->sem_ready, woken);
+}
+
 int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns)
 {
 	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
@@ -822,47 +366,145 @@ int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[],
 	if (!valid)
 		return -1;
 
-	bool semaphore_success = true;
-
 	if (PIOS_Semaphore_Take(i2c_adapter->sem_busy, i2c_adapter->cfg->transfer_timeout_ms) == false)
 		return -2;
 
-	i2c_adapter->active_txn = &txn_list[0];
-	i2c_adapter->last_txn = &txn_list[num_txns - 1];
+	struct pios_i2c_request *request = &i2c_adapter->transfer_request;
+	*request = (struct pios_i2c_request) {
+		.txn_list = txn_list,
+		.num_txns = num_txns,
+		.callback = PIOS_I2C_transfer_done,
+		.ctx = i2c_adapter,
+	};
 
 	/* Make sure the done/ready semaphore is consumed before we start */
-	semaphore_success = semaphore_success &&
-		(PIOS_Semaphore_Take(i2c_adapter->sem_ready, i2c_adapter->cfg->transfer_timeout_ms) == true);
-
-	i2c_adapter->bus_error = false;
-	i2c_adapter->nack = false;
+	PIOS_Semaphore_Take(i2c_adapter->sem_ready, 0);
 
-	bool dummy = false;
-	i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_START, &dummy);
+	if (PIOS_I2C_Submit(i2c_id, request) != 0) {
+		PIOS_Semaphore_Give(i2c_adapter->sem_busy);
+		return -1;
+	}
 
-	/* Wait for the transfer to complete */
-	semaphore_success = semaphore_success &&
-		(PIOS_Semaphore_Take(i2c_adapter->sem_ready, i2c_adapter->cfg->transfer_timeout_ms) == true);
-	PIOS_Semaphore_Give(i2c_adapter->sem_ready);
+	/* Wait for the transfer, which may first wait for queued requests */
+	if (PIOS_Semaphore_Take(i2c_adapter->sem_ready, i2c_adapter->cfg->transfer_timeout_ms) == false) {
+		bool dummy = false;
 
-	// handle fsm timeout
-	if (i2c_adapter->state != I2C_STATE_STOPPED) {
 		PIOS_IRQ_Disable();
-		i2c_adapter_fsm_init(i2c_adapter);
+		bool aborted = i2c_adapter_abort(i2c_adapter, request, &dummy);
 		PIOS_IRQ_Enable();
-	}
 
-	PIOS_Semaphore_Give(i2c_adapter->sem_busy);
+		/* Either the abort or a completion that just beat it gave this */
+		PIOS_Semaphore_Take(i2c_adapter->sem_ready, 0);
 
 #if defined(PIOS_I2C_DIAGNOSTICS)
-	if (!semaphore_success)
-		i2c_adapter->i2c_timeout_counter++;
+		if (aborted)
+			i2c_adapter->i2c_timeout_counter++;
+#else
+		(void)aborted;
 #endif
+	}
+
+	int32_t result = i2c_adapter->transfer_result;
 
-	return !semaphore_success ? -2 :
-		i2c_adapter->bus_error ? -1 :
-		i2c_adapter->nack ? -3 :
-		0;
+	PIOS_Semaphore_Give(i2c_adapter->sem_busy);
+
+	return result;
+}
+
+/**
+ * @brief Queue requests to run back to back on the bus without blocking.
+ * Each completes through its callback from the I2C interrupt.
+ * @param[in] request the first request, further ones chained through next
+ * @returns 0 on success, -1 if the adapter or a request is invalid
+ */
+int32_t PIOS_I2C_Submit(uint32_t i2c_id, struct pios_i2c_request *request)
+{
+	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
+
+	bool valid = PIOS_I2C_validate(i2c_adapter);
+	if (!valid)
+		return -1;
+
+	if (!PIOS_I2C_validate_requests(request))
+		return -1;
+
+	bool woken = false;
+
+	PIOS_IRQ_Disable();
+	i2c_adapter_submit(i2c_adapter, request, &woken);
+	PIOS_IRQ_Enable();
+
+	return 0;
+}
+
+/**
+ * @brief Take back a submitted request that has not completed, e.g. when
+ * it is overdue. It completes through its callback with -2.
+ * @returns 0 if the request was aborted, -1 if the adapter is invalid or
+ * the request had already completed
+ */
+int32_t PIOS_I2C_Abort(uint32_t i2c_id, struct pios_i2c_request *request)
+{
+	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
+
+	bool valid = PIOS_I2C_validate(i2c_adapter);
+	if (!valid)
+		return -1;
+
+	bool woken = false;
+
+	PIOS_IRQ_Disable();
+	bool aborted = i2c_adapter_abort(i2c_adapter, request, &woken);
+	PIOS_IRQ_Enable();
+
+	return aborted ? 0 : -1;
+}
+
+/**
+ * @brief Get the statistics of a bus
+ * @param[out] stats counters since init, with the throughput averaged
+ * since the previous call
+ * @returns 0 on success, -1 if the adapter is invalid
+ */
+int32_t PIOS_I2C_GetStats(uint32_t i2c_id, struct pios_i2c_stats *stats)
+{
+	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
+
+	if (i2c_adapter == NULL || stats == NULL)
+		return -1;
+
+	bool valid = PIOS_I2C_validate(i2c_adapter);
+	if (!valid)
+		return -1;
+
+	PIOS_IRQ_Disable();
+	*stats = i2c_adapter->stats;
+	PIOS_IRQ_Enable();
+
+	uint32_t now = PIOS_DELAY_GetuS();
+	uint32_t dT = now - i2c_adapter->stats_time_us;
+
+	stats->bytes_per_second = 0;
+	if (dT > 0)
+		stats->bytes_per_second = (uint64_t)(stats->bytes - i2c_adapter->stats_bytes) * 1000000 / dT;
+
+	i2c_adapter->stats_bytes = stats->bytes;
+	i2c_adapter->stats_time_us = now;
+
+	return 0;
+}
+
+/**
+ * @brief Get the adapter of a peripheral
+ * @param[in] bus 0 for I2C1, 1 for I2C2 and 2 for I2C3
+ * @returns the adapter id or 0 if that peripheral is not initialised
+ */
+uint32_t PIOS_I2C_GetAdapter(uint8_t bus)
+{
+	if (bus >= NELEMENTS(pios_i2c_adapters))
+		return 0;
+
+	return (uint32_t)pios_i2c_adapters[bus];
 }
 
 void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
@@ -884,60 +526,15 @@ void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
 
 	switch (event) {
 	case I2C_EVENT_MASTER_MODE_SELECT:	/* EV5 */
-		switch (i2c_adapter->active_txn->rw) {
-		case PIOS_I2C_TXN_READ:
-			if (i2c_adapter->active_txn == i2c_adapter->last_txn) {
-				/* Final transaction */
-				i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_R_LAST_TXN_STARTED, &woken);
-			} else {
-				/* More transactions follow */
-				i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_R_MORE_TXN_STARTED, &woken);
-			}
-			break;
-		case PIOS_I2C_TXN_WRITE:
-			if (i2c_adapter->active_txn == i2c_adapter->last_txn) {
-				/* Final transaction */
-				i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_W_LAST_TXN_STARTED, &woken);
-			} else {
-				/* More transactions follow */
-				i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_W_MORE_TXN_STARTED, &woken);
-			}
-			break;
-		}
+		i2c_adapter_started(i2c_adapter, &woken);
 		break;
 	case I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED:	/* EV6 */
 	case I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED:	/* EV6 */
-		switch (i2c_adapter->last_byte - i2c_adapter->active_byte + 1) {
-		case 0:
-			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_LEN_EQ_0, &woken);
-			break;
-		case 1:
-			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_LEN_EQ_1, &woken);
-			break;
-		case 2:
-			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_LEN_EQ_2, &woken);
-			break;
-		default:
-			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_LEN_GT_2, &woken);
-			break;
-		}
+		i2c_adapter_address_sent(i2c_adapter, &woken);
 		break;
 	case I2C_EVENT_MASTER_BYTE_RECEIVED:	/* EV7 */
 	case I2C_EVENT_MASTER_BYTE_TRANSMITTED:	/* EV8_2 */
-		switch (i2c_adapter->last_byte - i2c_adapter->active_byte + 1) {
-		case 0:
-			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_TRANSFER_DONE_LEN_EQ_0, &woken);
-			break;
-		case 1:
-			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_TRANSFER_DONE_LEN_EQ_1, &woken);
-			break;
-		case 2:
-			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_TRANSFER_DONE_LEN_EQ_2, &woken);
-			break;
-		default:
-			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_TRANSFER_DONE_LEN_GT_2, &woken);
-			break;
-		}
+		i2c_adapter_byte_done(i2c_adapter, &woken);
 		break;
 	case I2C_EVENT_MASTER_BYTE_TRANSMITTING:	/* EV8 */
 		// This event is being ignored. It may be used to speed up transfer by reloading data buffer earlier.
@@ -956,6 +553,45 @@ void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
 #endif
 }
 
+/**
+ * @brief Handle the end of a read by DMA, from the rx stream interrupt
+ */
+void PIOS_I2C_DMA_IRQ_Handler(uint32_t i2c_id)
+{
+	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
+
+	bool valid = PIOS_I2C_validate(i2c_adapter);
+	PIOS_Assert(valid)
+
+	const struct stm32_dma *dma = i2c_adapter->cfg->dma;
+
+	bool woken = false;
+
+	DMA_ClearFlag(dma->rx.channel, dma->irq.flags);
+
+	/* Left over from a stream the state machine has already stopped */
+	if (!i2c_adapter->dma_rx)
+		return;
+
+	/* The stream disables itself when the count runs out or on a transfer error */
+	if (DMA_GetCmdStatus(dma->rx.channel) == ENABLE)
+		return;
+
+	if (DMA_GetCurrDataCounter(dma->rx.channel) == 0) {
+		i2c_adapter_dma_done(i2c_adapter, &woken);
+	} else {
+#if defined(PIOS_I2C_DIAGNOSTICS)
+		i2c_adapter_log_fault(i2c_adapter, PIOS_I2C_ERROR_INTERRUPT);
+#endif
+
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_BUS_ERROR, &woken);
+	}
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+	portEND_SWITCHING_ISR(woken == true ? pdTRUE : pdFALSE);
+#endif
+}
+
 void PIOS_I2C_ER_IRQ_Handler(uint32_t i2c_id)
 {
 	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
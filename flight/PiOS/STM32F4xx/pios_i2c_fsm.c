@@ -0,0 +1,966 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup   PIOS_I2C I2C Functions
+ * @brief STM32F4xx I2C transfer state machine and request queue
+ * @{
+ *
+ * @file       pios_i2c_fsm.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @brief      I2C transfer state machine
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ * The state machine only touches the peripheral through the i2c_hal_*
+ * functions in pios_i2c.c, and is fed the decoded interrupt events, so it
+ * can be built and exercised on the host. Requests are queued and each is
+ * started from the interrupt that completes the previous one, so sensors
+ * sharing a bus run back to back without waking a task in between.
+ * Reads of two bytes or more go by DMA when the adapter has a stream, so
+ * they cost two interrupts instead of one per byte; writes (register
+ * addresses and commands) stay interrupt driven.
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/* Project Includes */
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_I2C)
+
+#include <pios_i2c_priv.h>
+
+static void i2c_adapter_start_next(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void i2c_adapter_complete(struct pios_i2c_adapter *i2c_adapter, struct pios_i2c_request *request, int32_t result, bool *woken);
+
+static void go_fsm_fault(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_bus_error(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_nack(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_stopped(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_starting(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+
+static void go_r_more_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_more_txn_pre_one(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_more_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_more_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_more_txn_dma_done(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+
+static void go_r_last_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_last_txn_pre_one(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_last_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_last_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_last_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_last_txn_dma_done(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+
+static void go_w_more_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_w_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_w_more_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_w_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+
+static void go_w_last_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_w_last_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_w_last_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_w_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+
+struct i2c_adapter_transition {
+	void (*entry_fn)(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+	enum i2c_adapter_state next_state[I2C_EVENT_NUM_EVENTS];
+};
+
+static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM_STATES] = {
+	[I2C_STATE_FSM_FAULT] = {
+		.entry_fn = go_fsm_fault,
+		.next_state = {
+			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
+		},
+	},
+	[I2C_STATE_BUS_ERROR] = {
+		.entry_fn = go_bus_error,
+		.next_state = {
+			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
+		},
+	},
+	[I2C_STATE_NACK] = {
+		.entry_fn = go_nack,
+		.next_state = {
+			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
+		},
+	},
+	[I2C_STATE_STOPPED] = {
+		.entry_fn = go_stopped,
+		.next_state = {
+			[I2C_EVENT_START] = I2C_STATE_STARTING,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_STARTING] = {
+		.entry_fn = go_starting,
+		.next_state = {
+			[I2C_EVENT_R_MORE_TXN_STARTED] = I2C_STATE_R_MORE_TXN_ADDR,
+			[I2C_EVENT_W_MORE_TXN_STARTED] = I2C_STATE_W_MORE_TXN_ADDR,
+			[I2C_EVENT_R_LAST_TXN_STARTED] = I2C_STATE_R_LAST_TXN_ADDR,
+			[I2C_EVENT_W_LAST_TXN_STARTED] = I2C_STATE_W_LAST_TXN_ADDR,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+
+	/*
+	 * Read with restart
+	 */
+	[I2C_STATE_R_MORE_TXN_ADDR] = {
+		.entry_fn = go_r_more_txn_addr,
+		.next_state = {
+			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_R_MORE_TXN_PRE_ONE,
+			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_R_MORE_TXN_PRE_FIRST,
+			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_R_MORE_TXN_PRE_FIRST,
+			[I2C_EVENT_ADDR_SENT_DMA] = I2C_STATE_R_MORE_TXN_DMA,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_MORE_TXN_PRE_ONE] = {
+		.entry_fn = go_r_more_txn_pre_one,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_R_MORE_TXN_POST_LAST,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_MORE_TXN_PRE_FIRST] = {
+		.entry_fn = go_r_more_txn_pre_first,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_R_MORE_TXN_PRE_LAST,
+			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_R_MORE_TXN_PRE_MIDDLE,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_MORE_TXN_PRE_MIDDLE] = {
+		.entry_fn = go_r_more_txn_pre_middle,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_R_MORE_TXN_PRE_LAST,
+			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_R_MORE_TXN_PRE_MIDDLE,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_MORE_TXN_PRE_LAST] = {
+		.entry_fn = go_r_more_txn_pre_last,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_R_MORE_TXN_POST_LAST,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_MORE_TXN_POST_LAST] = {
+		.entry_fn = go_r_more_txn_post_last,
+		.next_state = {
+			[I2C_EVENT_R_MORE_TXN_STARTED] = I2C_STATE_R_MORE_TXN_ADDR,
+			[I2C_EVENT_W_MORE_TXN_STARTED] = I2C_STATE_W_MORE_TXN_ADDR,
+			[I2C_EVENT_R_LAST_TXN_STARTED] = I2C_STATE_R_LAST_TXN_ADDR,
+			[I2C_EVENT_W_LAST_TXN_STARTED] = I2C_STATE_W_LAST_TXN_ADDR,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_MORE_TXN_DMA] = {
+		.entry_fn = NULL,
+		.next_state = {
+			[I2C_EVENT_DMA_DONE] = I2C_STATE_R_MORE_TXN_DMA_DONE,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_MORE_TXN_DMA_DONE] = {
+		.entry_fn = go_r_more_txn_dma_done,
+		.next_state = {
+			[I2C_EVENT_R_MORE_TXN_STARTED] = I2C_STATE_R_MORE_TXN_ADDR,
+			[I2C_EVENT_W_MORE_TXN_STARTED] = I2C_STATE_W_MORE_TXN_ADDR,
+			[I2C_EVENT_R_LAST_TXN_STARTED] = I2C_STATE_R_LAST_TXN_ADDR,
+			[I2C_EVENT_W_LAST_TXN_STARTED] = I2C_STATE_W_LAST_TXN_ADDR,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+
+	/*
+	 * Read with stop
+	 */
+	[I2C_STATE_R_LAST_TXN_ADDR] = {
+		.entry_fn = go_r_last_txn_addr,
+		.next_state = {
+			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_R_LAST_TXN_PRE_ONE,
+			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_R_LAST_TXN_PRE_FIRST,
+			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_R_LAST_TXN_PRE_FIRST,
+			[I2C_EVENT_ADDR_SENT_DMA] = I2C_STATE_R_LAST_TXN_DMA,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_LAST_TXN_PRE_ONE] = {
+		.entry_fn = go_r_last_txn_pre_one,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_R_LAST_TXN_POST_LAST,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_LAST_TXN_PRE_FIRST] = {
+		.entry_fn = go_r_last_txn_pre_first,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_R_LAST_TXN_PRE_LAST,
+			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_R_LAST_TXN_PRE_MIDDLE,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_LAST_TXN_PRE_MIDDLE] = {
+		.entry_fn = go_r_last_txn_pre_middle,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_R_LAST_TXN_PRE_LAST,
+			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_R_LAST_TXN_PRE_MIDDLE,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_LAST_TXN_PRE_LAST] = {
+		.entry_fn = go_r_last_txn_pre_last,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_R_LAST_TXN_POST_LAST,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_LAST_TXN_POST_LAST] = {
+		.entry_fn = go_r_last_txn_post_last,
+		.next_state = {
+			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
+		},
+	},
+	[I2C_STATE_R_LAST_TXN_DMA] = {
+		.entry_fn = NULL,
+		.next_state = {
+			[I2C_EVENT_DMA_DONE] = I2C_STATE_R_LAST_TXN_DMA_DONE,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_LAST_TXN_DMA_DONE] = {
+		.entry_fn = go_r_last_txn_dma_done,
+		.next_state = {
+			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
+		},
+	},
+
+	/*
+	 * Write with restart
+	 */
+	[I2C_STATE_W_MORE_TXN_ADDR] = {
+		.entry_fn = go_w_more_txn_addr,
+		.next_state = {
+			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_W_MORE_TXN_PRE_LAST,
+			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_W_MORE_TXN_PRE_MIDDLE,
+			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_W_MORE_TXN_PRE_MIDDLE,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_W_MORE_TXN_PRE_MIDDLE] = {
+		.entry_fn = go_w_more_txn_pre_middle,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_W_MORE_TXN_PRE_LAST,
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_W_MORE_TXN_PRE_MIDDLE,
+			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_W_MORE_TXN_PRE_MIDDLE,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_W_MORE_TXN_PRE_LAST] = {
+		.entry_fn = go_w_more_txn_pre_last,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_0] = I2C_STATE_W_MORE_TXN_POST_LAST,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_W_MORE_TXN_POST_LAST] = {
+		.entry_fn = go_w_more_txn_post_last,
+		.next_state = {
+			[I2C_EVENT_R_MORE_TXN_STARTED] = I2C_STATE_R_MORE_TXN_ADDR,
+			[I2C_EVENT_W_MORE_TXN_STARTED] = I2C_STATE_W_MORE_TXN_ADDR,
+			[I2C_EVENT_R_LAST_TXN_STARTED] = I2C_STATE_R_LAST_TXN_ADDR,
+			[I2C_EVENT_W_LAST_TXN_STARTED] = I2C_STATE_W_LAST_TXN_ADDR,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+
+	/*
+	 * Write with stop
+	 */
+	[I2C_STATE_W_LAST_TXN_ADDR] = {
+		.entry_fn = go_w_last_txn_addr,
+		.next_state = {
+			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_W_LAST_TXN_PRE_LAST,
+			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_W_LAST_TXN_PRE_MIDDLE,
+			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_W_LAST_TXN_PRE_MIDDLE,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_W_LAST_TXN_PRE_MIDDLE] = {
+		.entry_fn = go_w_last_txn_pre_middle,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_1] = I2C_STATE_W_LAST_TXN_PRE_LAST,
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_2] = I2C_STATE_W_LAST_TXN_PRE_MIDDLE,
+			[I2C_EVENT_TRANSFER_DONE_LEN_GT_2] = I2C_STATE_W_LAST_TXN_PRE_MIDDLE,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_W_LAST_TXN_PRE_LAST] = {
+		.entry_fn = go_w_last_txn_pre_last,
+		.next_state = {
+			[I2C_EVENT_TRANSFER_DONE_LEN_EQ_0] = I2C_STATE_W_LAST_TXN_POST_LAST,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_W_LAST_TXN_POST_LAST] = {
+		.entry_fn = go_w_last_txn_post_last,
+		.next_state = {
+			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
+		},
+	},
+};
+
+/**
+ * Take the data register back from the DMA, if it has it
+ */
+static void i2c_adapter_dma_release(struct pios_i2c_adapter *i2c_adapter)
+{
+	if (!i2c_adapter->dma_rx)
+		return;
+
+	i2c_hal_dma_stop(i2c_adapter);
+	i2c_adapter->dma_rx = false;
+}
+
+/**
+ * Hand a read of two bytes or more to the DMA, which NACKs the last byte
+ * itself. The BUF irq stays off as the DMA requests need it clear.
+ */
+static bool i2c_adapter_dma_claim(struct pios_i2c_adapter *i2c_adapter)
+{
+	uint16_t len = i2c_adapter->last_byte - i2c_adapter->active_byte + 1;
+
+	if (len < 2 || !i2c_hal_dma_rx_start(i2c_adapter, i2c_adapter->active_byte, len))
+		return false;
+
+	i2c_adapter->dma_rx = true;
+
+	// ack all bytes but the last
+	i2c_hal_ack(i2c_adapter, true);
+
+	return true;
+}
+
+static void go_fsm_fault(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	i2c_adapter->stats.fsm_faults++;
+	i2c_adapter->bus_error = true;
+	i2c_adapter_dma_release(i2c_adapter);
+	i2c_adapter_reset_bus(i2c_adapter);
+}
+
+static void go_nack(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	i2c_adapter->nack = true;
+	i2c_adapter_dma_release(i2c_adapter);
+
+	// setup handling of this byte
+	i2c_hal_ack(i2c_adapter, false);
+	i2c_hal_start(i2c_adapter, false);
+	i2c_hal_stop(i2c_adapter);
+}
+
+static void go_bus_error(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	i2c_adapter->bus_error = true;
+	i2c_adapter_dma_release(i2c_adapter);
+	i2c_adapter_reset_bus(i2c_adapter);
+}
+
+static void go_stopped(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// disable all irqs
+	i2c_hal_irq_config(i2c_adapter, I2C_HAL_IRQ_EVT | I2C_HAL_IRQ_BUF | I2C_HAL_IRQ_ERR, false);
+
+	struct pios_i2c_request *request = i2c_adapter->active_request;
+	if (request == NULL)
+		return;
+
+	int32_t result = i2c_adapter->bus_error ? -1 :
+		i2c_adapter->nack ? -3 :
+		0;
+
+	if (i2c_adapter->bus_error) {
+		i2c_adapter->stats.bus_errors++;
+	} else if (i2c_adapter->nack) {
+		i2c_adapter->stats.nacks++;
+	} else {
+		for (uint32_t i = 0; i < request->num_txns; i++)
+			i2c_adapter->stats.bytes += request->txn_list[i].len;
+	}
+
+	/* The callback may submit the next request, so this goes last */
+	i2c_adapter_complete(i2c_adapter, request, result, woken);
+}
+
+static void go_starting(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// set up current txn byte pointers
+	i2c_adapter->active_byte = &(i2c_adapter->active_txn->buf[0]);
+	i2c_adapter->last_byte = &(i2c_adapter->active_txn->buf[i2c_adapter->active_txn->len - 1]);
+
+	// enabled interrupts
+	i2c_hal_irq_config(i2c_adapter, I2C_HAL_IRQ_EVT | I2C_HAL_IRQ_ERR, true);
+
+	// generate a start condition
+	i2c_hal_start(i2c_adapter, true);
+}
+
+/*
+ * Read with restart
+ */
+static void go_r_more_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// enable buffer RxNE, unless the DMA takes the bytes
+	if (!i2c_adapter_dma_claim(i2c_adapter))
+		i2c_hal_irq_config(i2c_adapter, I2C_HAL_IRQ_BUF, true);
+
+	i2c_hal_send_address(i2c_adapter, i2c_adapter->active_txn->addr, true);
+}
+
+static void go_r_more_txn_pre_one(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// send a nack on the last byte
+	i2c_hal_ack(i2c_adapter, false);
+}
+
+static void go_r_more_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// ack all following bytes
+	i2c_hal_ack(i2c_adapter, true);
+}
+
+static void go_r_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// read received byte from buffer
+	*i2c_adapter->active_byte = i2c_hal_receive_byte(i2c_adapter);
+
+	/* Move to the next byte */
+	i2c_adapter->active_byte++;
+}
+
+static void go_r_more_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// read received byte from buffer
+	*i2c_adapter->active_byte = i2c_hal_receive_byte(i2c_adapter);
+
+	// send a nack on the last byte
+	i2c_hal_ack(i2c_adapter, false);
+
+	/* Move to the next byte */
+	i2c_adapter->active_byte++;
+}
+
+static void go_r_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// the last byte of this txn has been received, so disable the buffer RxNE
+	i2c_hal_irq_config(i2c_adapter, I2C_HAL_IRQ_BUF, false);
+
+	// read received byte from buffer
+	*i2c_adapter->active_byte = i2c_hal_receive_byte(i2c_adapter);
+
+	/* Move to the next byte */
+	i2c_adapter->active_byte++;
+
+	/* Move to the next transaction */
+	i2c_adapter->active_txn++;
+
+	// set up current txn byte pointers
+	i2c_adapter->active_byte = &(i2c_adapter->active_txn->buf[0]);
+	i2c_adapter->last_byte = &(i2c_adapter->active_txn->buf[i2c_adapter->active_txn->len - 1]);
+
+	// generate repeated START condition
+	i2c_hal_start(i2c_adapter, true);
+}
+
+static void go_r_more_txn_dma_done(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// the DMA has received every byte of this txn and NACKed the last
+	i2c_adapter_dma_release(i2c_adapter);
+
+	/* Move to the next transaction */
+	i2c_adapter->active_txn++;
+
+	// set up current txn byte pointers
+	i2c_adapter->active_byte = &(i2c_adapter->active_txn->buf[0]);
+	i2c_adapter->last_byte = &(i2c_adapter->active_txn->buf[i2c_adapter->active_txn->len - 1]);
+
+	// generate repeated START condition
+	i2c_hal_start(i2c_adapter, true);
+}
+
+/*
+ * Read with stop
+ */
+static void go_r_last_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// enable buffer RxNE, unless the DMA takes the bytes
+	if (!i2c_adapter_dma_claim(i2c_adapter))
+		i2c_hal_irq_config(i2c_adapter, I2C_HAL_IRQ_BUF, true);
+
+	i2c_hal_send_address(i2c_adapter, i2c_adapter->active_txn->addr, true);
+}
+
+static void go_r_last_txn_pre_one(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// send a nack on the last byte
+	i2c_hal_ack(i2c_adapter, false);
+}
+
+static void go_r_last_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// ack all following bytes
+	i2c_hal_ack(i2c_adapter, true);
+}
+
+static void go_r_last_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// read received byte from buffer
+	*i2c_adapter->active_byte = i2c_hal_receive_byte(i2c_adapter);
+
+	/* Move to the next byte */
+	i2c_adapter->active_byte++;
+}
+
+static void go_r_last_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// read received byte from buffer
+	*i2c_adapter->active_byte = i2c_hal_receive_byte(i2c_adapter);
+
+	// send a nack on the last byte
+	i2c_hal_ack(i2c_adapter, false);
+
+	/* Move to the next byte */
+	i2c_adapter->active_byte++;
+}
+
+static void go_r_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// the last byte of this txn has been received, so disable the buffer RxNE
+	i2c_hal_irq_config(i2c_adapter, I2C_HAL_IRQ_BUF, false);
+
+	// read received byte from buffer
+	*i2c_adapter->active_byte = i2c_hal_receive_byte(i2c_adapter);
+
+	// generate a stop condition
+	i2c_hal_stop(i2c_adapter);
+
+	/* Move to the next byte */
+	i2c_adapter->active_byte++;
+
+	/* Move to the next transaction */
+	i2c_adapter->active_txn++;
+}
+
+static void go_r_last_txn_dma_done(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// the DMA has received every byte of this txn and NACKed the last
+	i2c_adapter_dma_release(i2c_adapter);
+
+	// generate a stop condition
+	i2c_hal_stop(i2c_adapter);
+
+	/* Move to the next transaction */
+	i2c_adapter->active_txn++;
+}
+
+
+/*
+ * Write with restart
+ */
+static void go_w_more_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	i2c_hal_send_address(i2c_adapter, i2c_adapter->active_txn->addr, false);
+}
+
+static void go_w_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// write byte to buffer
+	i2c_hal_send_byte(i2c_adapter, *i2c_adapter->active_byte);
+
+	/* Move to the next byte */
+	i2c_adapter->active_byte++;
+}
+
+static void go_w_more_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// write byte to buffer
+	i2c_hal_send_byte(i2c_adapter, *i2c_adapter->active_byte);
+
+	/* Move to the next byte */
+	i2c_adapter->active_byte++;
+}
+
+static void go_w_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	/* Move to the next transaction */
+	i2c_adapter->active_txn++;
+
+	// set up current txn byte pointers
+	i2c_adapter->active_byte = &(i2c_adapter->active_txn->buf[0]);
+	i2c_adapter->last_byte = &(i2c_adapter->active_txn->buf[i2c_adapter->active_txn->len - 1]);
+
+	// the last byte of this txn has been transmitted, so disable the buffer TxE
+	i2c_hal_irq_config(i2c_adapter, I2C_HAL_IRQ_BUF, false);
+
+	// also clear the TxE flag to prevent another irq from being thrown by executing a dummy read
+	(void)i2c_hal_receive_byte(i2c_adapter);
+
+	// generate restart
+	i2c_hal_start(i2c_adapter, true);
+}
+
+/*
+ * Write with stop
+ */
+static void go_w_last_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	i2c_hal_send_address(i2c_adapter, i2c_adapter->active_txn->addr, false);
+}
+
+static void go_w_last_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// write byte to buffer
+	i2c_hal_send_byte(i2c_adapter, *i2c_adapter->active_byte);
+
+	/* Move to the next byte */
+	i2c_adapter->active_byte++;
+}
+
+static void go_w_last_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// write byte to buffer
+	i2c_hal_send_byte(i2c_adapter, *i2c_adapter->active_byte);
+
+	/* Move to the next byte */
+	i2c_adapter->active_byte++;
+}
+
+static void go_w_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// the last byte of this txn has been transmitted, so disable the buffer TxE
+	i2c_hal_irq_config(i2c_adapter, I2C_HAL_IRQ_BUF, false);
+
+	// setup handling of this byte
+	i2c_hal_stop(i2c_adapter);
+
+	/* Move to the next transaction */
+	i2c_adapter->active_txn++;
+}
+
+void i2c_adapter_inject_event(struct pios_i2c_adapter *i2c_adapter, enum i2c_adapter_event event, bool *woken)
+{
+#if defined(PIOS_I2C_DIAGNOSTICS)
+	i2c_adapter->i2c_state_event_history[i2c_adapter->i2c_state_event_history_pointer] = event;
+	i2c_adapter->i2c_state_event_history_pointer = (i2c_adapter->i2c_state_event_history_pointer + 1) % I2C_LOG_DEPTH;
+
+	i2c_adapter->i2c_state_history[i2c_adapter->i2c_state_history_pointer] = i2c_adapter->state;
+	i2c_adapter->i2c_state_history_pointer = (i2c_adapter->i2c_state_history_pointer + 1) % I2C_LOG_DEPTH;
+
+	if (i2c_adapter_transitions[i2c_adapter->state].next_state[event] == I2C_STATE_FSM_FAULT)
+		i2c_adapter_log_fault(i2c_adapter, PIOS_I2C_ERROR_FSM);
+#endif
+	/*
+	 * Move to the next state
+	 */
+	i2c_adapter->state = i2c_adapter_transitions[i2c_adapter->state].next_state[event];
+
+	/* Call the entry function (if any) for the next state. */
+	if (i2c_adapter_transitions[i2c_adapter->state].entry_fn) {
+		i2c_adapter_transitions[i2c_adapter->state].entry_fn(i2c_adapter, woken);
+	}
+
+	/* Process any AUTO transitions in the FSM */
+	while (i2c_adapter_transitions[i2c_adapter->state].next_state[I2C_EVENT_AUTO]) {
+
+#if defined(PIOS_I2C_DIAGNOSTICS)
+		i2c_adapter->i2c_state_history[i2c_adapter->i2c_state_history_pointer] = i2c_adapter->state;
+		i2c_adapter->i2c_state_history_pointer = (i2c_adapter->i2c_state_history_pointer + 1) % I2C_LOG_DEPTH;
+#endif
+
+		i2c_adapter->state = i2c_adapter_transitions[i2c_adapter->state].next_state[I2C_EVENT_AUTO];
+
+		/* Call the entry function (if any) for the next state. */
+		if (i2c_adapter_transitions[i2c_adapter->state].entry_fn) {
+			i2c_adapter_transitions[i2c_adapter->state].entry_fn(i2c_adapter, woken);
+		}
+	}
+
+	i2c_adapter_start_next(i2c_adapter, woken);
+}
+
+void i2c_adapter_fsm_init(struct pios_i2c_adapter *i2c_adapter)
+{
+	i2c_adapter_dma_release(i2c_adapter);
+	i2c_adapter_reset_bus(i2c_adapter);
+	i2c_adapter->state = I2C_STATE_STOPPED;
+}
+
+/**
+ * Decode a start condition having been sent (EV5)
+ */
+void i2c_adapter_started(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	if (i2c_adapter->active_request == NULL) {
+		/* Nothing to send, the bus was not started by us */
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_BUS_ERROR, woken);
+		return;
+	}
+
+	switch (i2c_adapter->active_txn->rw) {
+	case PIOS_I2C_TXN_READ:
+		if (i2c_adapter->active_txn == i2c_adapter->last_txn) {
+			/* Final transaction */
+			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_R_LAST_TXN_STARTED, woken);
+		} else {
+			/* More transactions follow */
+			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_R_MORE_TXN_STARTED, woken);
+		}
+		break;
+	case PIOS_I2C_TXN_WRITE:
+		if (i2c_adapter->active_txn == i2c_adapter->last_txn) {
+			/* Final transaction */
+			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_W_LAST_TXN_STARTED, woken);
+		} else {
+			/* More transactions follow */
+			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_W_MORE_TXN_STARTED, woken);
+		}
+		break;
+	}
+}
+
+/**
+ * Decode the slave address having been acknowledged (EV6)
+ */
+void i2c_adapter_address_sent(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	if (i2c_adapter->dma_rx) {
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_DMA, woken);
+		return;
+	}
+
+	switch (i2c_adapter->last_byte - i2c_adapter->active_byte + 1) {
+	case 0:
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_LEN_EQ_0, woken);
+		break;
+	case 1:
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_LEN_EQ_1, woken);
+		break;
+	case 2:
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_LEN_EQ_2, woken);
+		break;
+	default:
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_LEN_GT_2, woken);
+		break;
+	}
+}
+
+/**
+ * Decode a byte having been received (EV7) or transmitted (EV8_2)
+ */
+void i2c_adapter_byte_done(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	/* The data register belongs to the DMA, which reports the end itself */
+	if (i2c_adapter->dma_rx)
+		return;
+
+	switch (i2c_adapter->last_byte - i2c_adapter->active_byte + 1) {
+	case 0:
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_TRANSFER_DONE_LEN_EQ_0, woken);
+		break;
+	case 1:
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_TRANSFER_DONE_LEN_EQ_1, woken);
+		break;
+	case 2:
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_TRANSFER_DONE_LEN_EQ_2, woken);
+		break;
+	default:
+		i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_TRANSFER_DONE_LEN_GT_2, woken);
+		break;
+	}
+}
+
+/**
+ * Decode the DMA having received the whole read txn
+ */
+void i2c_adapter_dma_done(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_DMA_DONE, woken);
+}
+
+/**
+ * Queue a chain of validated requests and start the bus if it is idle
+ * \param[in] request the first request, linked to the rest through next
+ */
+void i2c_adapter_submit(struct pios_i2c_adapter *i2c_adapter, struct pios_i2c_request *request, bool *woken)
+{
+	while (request != NULL) {
+		struct pios_i2c_request *next = request->next;
+
+		request->next = NULL;
+		if (i2c_adapter->queue_tail)
+			i2c_adapter->queue_tail->next = request;
+		else
+			i2c_adapter->queue_head = request;
+		i2c_adapter->queue_tail = request;
+
+		i2c_adapter->stats.queue_depth++;
+		if (i2c_adapter->stats.queue_depth > i2c_adapter->stats.max_queue_depth)
+			i2c_adapter->stats.max_queue_depth = i2c_adapter->stats.queue_depth;
+
+		request = next;
+	}
+
+	i2c_adapter_start_next(i2c_adapter, woken);
+}
+
+/**
+ * Complete a request with -2 (e.g. on a timeout). An active request is
+ * stopped by resetting the bus, and the queue moves on to the next one.
+ * \return false if the request had already completed
+ */
+bool i2c_adapter_abort(struct pios_i2c_adapter *i2c_adapter, struct pios_i2c_request *request, bool *woken)
+{
+	if (request == i2c_adapter->active_request) {
+		i2c_adapter->stats.timeouts++;
+		i2c_adapter_fsm_init(i2c_adapter);
+		i2c_adapter_complete(i2c_adapter, request, -2, woken);
+		i2c_adapter_start_next(i2c_adapter, woken);
+		return true;
+	}
+
+	struct pios_i2c_request *prev = NULL;
+	for (struct pios_i2c_request *queued = i2c_adapter->queue_head; queued != NULL; queued = queued->next) {
+		if (queued != request) {
+			prev = queued;
+			continue;
+		}
+
+		if (prev)
+			prev->next = request->next;
+		else
+			i2c_adapter->queue_head = request->next;
+		if (i2c_adapter->queue_tail == request)
+			i2c_adapter->queue_tail = prev;
+
+		i2c_adapter->stats.timeouts++;
+		i2c_adapter_complete(i2c_adapter, request, -2, woken);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Start the request at the head of the queue once the bus has stopped
+ */
+static void i2c_adapter_start_next(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	if (i2c_adapter->state != I2C_STATE_STOPPED ||
+			i2c_adapter->active_request != NULL ||
+			i2c_adapter->queue_head == NULL)
+		return;
+
+	struct pios_i2c_request *request = i2c_adapter->queue_head;
+	i2c_adapter->queue_head = request->next;
+	if (i2c_adapter->queue_head == NULL)
+		i2c_adapter->queue_tail = NULL;
+	request->next = NULL;
+
+	i2c_adapter->active_request = request;
+	i2c_adapter->active_txn = &request->txn_list[0];
+	i2c_adapter->last_txn = &request->txn_list[request->num_txns - 1];
+
+	i2c_adapter->bus_error = false;
+	i2c_adapter->nack = false;
+
+	i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_START, woken);
+}
+
+/**
+ * Hand a request that left the queue back to its owner
+ */
+static void i2c_adapter_complete(struct pios_i2c_adapter *i2c_adapter, struct pios_i2c_request *request, int32_t result, bool *woken)
+{
+	if (request == i2c_adapter->active_request)
+		i2c_adapter->active_request = NULL;
+
+	i2c_adapter->stats.requests++;
+	i2c_adapter->stats.queue_depth--;
+
+	if (request->callback)
+		request->callback(request, result, woken);
+}
+
+/**
+ * Logs the last N state transitions and N IRQ events due to
+ * an error condition
+ * \param[in] i2c the adapter number to log an event for
+ */
+#if defined(PIOS_I2C_DIAGNOSTICS)
+void i2c_adapter_log_fault(struct pios_i2c_adapter *i2c_adapter, enum pios_i2c_error_type type)
+{
+	i2c_adapter->i2c_adapter_fault_history.type = type;
+	for (uint8_t i = 0; i < I2C_LOG_DEPTH; i++) {
+		i2c_adapter->i2c_adapter_fault_history.evirq[i] =
+				i2c_adapter->i2c_evirq_history[(I2C_LOG_DEPTH + i2c_adapter->i2c_evirq_history_pointer - 1 - i) % I2C_LOG_DEPTH];
+		i2c_adapter->i2c_adapter_fault_history.erirq[i] =
+				i2c_adapter->i2c_erirq_history[(I2C_LOG_DEPTH + i2c_adapter->i2c_erirq_history_pointer - 1 - i) % I2C_LOG_DEPTH];
+		i2c_adapter->i2c_adapter_fault_history.event[i] =
+				i2c_adapter->i2c_state_event_history[(I2C_LOG_DEPTH + i2c_adapter->i2c_state_event_history_pointer - 1 - i) % I2C_LOG_DEPTH];
+		i2c_adapter->i2c_adapter_fault_history.state[i] =
+				i2c_adapter->i2c_state_history[(I2C_LOG_DEPTH + i2c_adapter->i2c_state_history_pointer - 1 - i) % I2C_LOG_DEPTH];
+	}
+	switch (type) {
+	case PIOS_I2C_ERROR_EVENT:
+		i2c_adapter->i2c_bad_event_counter++;
+		break;
+	case PIOS_I2C_ERROR_FSM:
+		i2c_adapter->i2c_fsm_fault_count++;
+		break;
+	case PIOS_I2C_ERROR_INTERRUPT:
+		i2c_adapter->i2c_error_interrupt_counter++;
+		break;
+	}
+}
+#endif
+
+#endif
+
+/**
+  * @}
+  * @}
+  */
@@ -43,7 +43,7 @@
 
 #include <pios_overo_priv.h>
 
-#define PACKET_SIZE 1024
+#define PACKET_SIZE PIOS_OVERO_PACKET_SIZE
 
 /* Provide a COM driver */
 static void PIOS_OVERO_RegisterRxCallback(uintptr_t overo_id, pios_com_callback rx_in_cb, uintptr_t context);
@@ -44,6 +44,7 @@
 static void PIOS_USART_ChangeBaud(uintptr_t usart_id, uint32_t baud);
 static void PIOS_USART_RegisterRxCallback(uintptr_t usart_id, pios_com_callback rx_in_cb, uintptr_t context);
 static void PIOS_USART_RegisterTxCallback(uintptr_t usart_id, pios_com_callback tx_out_cb, uintptr_t context);
+static void PIOS_USART_RegisterTxSpanCallback(uintptr_t usart_id, pios_com_tx_span_callback tx_span_cb, uintptr_t context);
 static void PIOS_USART_TxStart(uintptr_t usart_id, uint16_t tx_bytes_avail);
 static void PIOS_USART_RxStart(uintptr_t usart_id, uint16_t rx_bytes_avail);
 
@@ -53,6 +54,7 @@ const struct pios_com_driver pios_usart_com_driver = {
 	.rx_start   = PIOS_USART_RxStart,
 	.bind_tx_cb = PIOS_USART_RegisterTxCallback,
 	.bind_rx_cb = PIOS_USART_RegisterRxCallback,
+	.bind_tx_span_cb = PIOS_USART_RegisterTxSpanCallback,
 };
 
 enum pios_usart_dev_magic {
@@ -67,6 +69,9 @@ struct pios_usart_dev {
 	uintptr_t rx_in_context;
 	pios_com_callback tx_out_cb;
 	uintptr_t tx_out_context;
+	pios_com_tx_span_callback tx_span_cb;
+	uintptr_t tx_span_context;
+	uint16_t tx_dma_len;
 };
 
 static bool PIOS_USART_validate(struct pios_usart_dev * usart_dev)
@@ -74,6 +79,12 @@ static bool PIOS_USART_validate(struct pios_usart_dev * usart_dev)
 	return (usart_dev->magic == PIOS_USART_DEV_MAGIC);
 }
 
+/* Only PIOS_COM binds the span callback, other users still go per byte */
+static bool PIOS_USART_TxByDMA(struct pios_usart_dev * usart_dev)
+{
+	return (usart_dev->cfg->dma && usart_dev->tx_span_cb);
+}
+
 static struct pios_usart_dev * PIOS_USART_alloc(void)
 {
 	struct pios_usart_dev * usart_dev;
@@ -174,6 +185,13 @@ int32_t PIOS_USART_Init(uintptr_t * usart_id, const struct pios_usart_cfg * cfg)
 	/* Configure the USART */
 	USART_Init(usart_dev->cfg->regs, (USART_InitTypeDef *)&usart_dev->cfg->init);
 
+	/* Configure the tx DMA stream, it is started for each span of the fifo */
+	if (usart_dev->cfg->dma) {
+		DMA_DeInit(usart_dev->cfg->dma->tx.channel);
+		DMA_Init(usart_dev->cfg->dma->tx.channel, (DMA_InitTypeDef *)&usart_dev->cfg->dma->tx.init);
+		USART_DMACmd(usart_dev->cfg->regs, USART_DMAReq_Tx, ENABLE);
+	}
+
 	*usart_id = (uintptr_t)usart_dev;
 
 	/* Configure USART Interrupts */
@@ -228,7 +246,16 @@ static void PIOS_USART_TxStart(uintptr_t usart_id, uint16_t tx_bytes_avail)
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
 	
-	USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, ENABLE);
+	if (PIOS_USART_TxByDMA(usart_dev)) {
+		/*
+		 * TC is set while the DMA is idle, so this raises the interrupt
+		 * straight away and the handler starts the next span. Nothing
+		 * else touches the stream, the handler owns it.
+		 */
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_TC, ENABLE);
+	} else {
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, ENABLE);
+	}
 }
 
 /**
@@ -285,6 +312,59 @@ static void PIOS_USART_RegisterTxCallback(uintptr_t usart_id, pios_com_callback
 	usart_dev->tx_out_cb = tx_out_cb;
 }
 
+static void PIOS_USART_RegisterTxSpanCallback(uintptr_t usart_id, pios_com_tx_span_callback tx_span_cb, uintptr_t context)
+{
+	struct pios_usart_dev * usart_dev = (struct pios_usart_dev *)usart_id;
+
+	bool valid = PIOS_USART_validate(usart_dev);
+	PIOS_Assert(valid);
+
+	/* 
+	 * Order is important in these assignments since ISR uses _cb
+	 * field to determine if it's ok to dereference _cb and _context
+	 */
+	usart_dev->tx_span_context = context;
+	usart_dev->tx_span_cb = tx_span_cb;
+
+	/* From now on TC drives the transmitter, TXE would fire for nothing */
+	if (usart_dev->cfg->dma) {
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, DISABLE);
+	}
+}
+
+/* Called on TC with the tx DMA in use, returns true if a task was woken */
+static bool PIOS_USART_DMA_TxDone(struct pios_usart_dev * usart_dev)
+{
+	DMA_Stream_TypeDef * stream = usart_dev->cfg->dma->tx.channel;
+	bool need_yield = false;
+
+	/* TC can come between two bytes if the DMA was held off, wait for the end */
+	if (DMA_GetCmdStatus(stream) == ENABLE) {
+		USART_ClearITPendingBit(usart_dev->cfg->regs, USART_IT_TC);
+		return false;
+	}
+
+	/* Give back the span just sent and take the next one */
+	uint8_t * buf;
+	uint16_t len = (usart_dev->tx_span_cb)(usart_dev->tx_span_context, &buf, usart_dev->tx_dma_len, &need_yield);
+	usart_dev->tx_dma_len = len;
+
+	if (len == 0) {
+		/* Nothing left to send, leave TC set for the next PIOS_USART_TxStart */
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_TC, DISABLE);
+		return need_yield;
+	}
+
+	/* The stream flags of the last transfer must be clear before enabling it */
+	DMA_ClearFlag(stream, usart_dev->cfg->dma->irq.flags);
+	DMA_MemoryTargetConfig(stream, (uint32_t)buf, DMA_Memory_0);
+	DMA_SetCurrDataCounter(stream, len);
+	USART_ClearITPendingBit(usart_dev->cfg->regs, USART_IT_TC);
+	DMA_Cmd(stream, ENABLE);
+
+	return need_yield;
+}
+
 static void PIOS_USART_generic_irq_handler(uintptr_t usart_id)
 {
 	struct pios_usart_dev * usart_dev = (struct pios_usart_dev *)usart_id;
@@ -305,9 +385,14 @@ static void PIOS_USART_generic_irq_handler(uintptr_t usart_id)
 		}
 	}
 	
-	/* Check if TXE flag is set */
+	/* With DMA the fifo is sent a span at a time, TC marks the end of one */
 	bool tx_need_yield = false;
-	if (sr & USART_SR_TXE) {
+	if (PIOS_USART_TxByDMA(usart_dev)) {
+		if ((sr & USART_SR_TC) && (usart_dev->cfg->regs->CR1 & USART_CR1_TCIE)) {
+			tx_need_yield = PIOS_USART_DMA_TxDone(usart_dev);
+		}
+	} else if (sr & USART_SR_TXE) {
+		/* TXE flag is set */
 		if (usart_dev->tx_out_cb) {
 			uint8_t b;
 			uint16_t bytes_to_send;
@@ -42,6 +42,7 @@
 
 /* Implement COM layer driver API */
 static void PIOS_USB_CDC_RegisterTxCallback(uintptr_t usbcdc_id, pios_com_callback tx_out_cb, uintptr_t context);
+static void PIOS_USB_CDC_RegisterTxSpanCallback(uintptr_t usbcdc_id, pios_com_tx_span_callback tx_span_cb, uintptr_t context);
 static void PIOS_USB_CDC_RegisterRxCallback(uintptr_t usbcdc_id, pios_com_callback rx_in_cb, uintptr_t context);
 static void PIOS_USB_CDC_TxStart(uintptr_t usbcdc_id, uint16_t tx_bytes_avail);
 static void PIOS_USB_CDC_RxStart(uintptr_t usbcdc_id, uint16_t rx_bytes_avail);
@@ -53,6 +54,7 @@ const struct pios_com_driver pios_usb_cdc_com_driver = {
 	.bind_tx_cb  = PIOS_USB_CDC_RegisterTxCallback,
 	.bind_rx_cb  = PIOS_USB_CDC_RegisterRxCallback,
 	.available   = PIOS_USB_CDC_Available,
+	.bind_tx_span_cb = PIOS_USB_CDC_RegisterTxSpanCallback,
 };
 
 enum pios_usb_cdc_dev_magic {
@@ -69,6 +71,8 @@ struct pios_usb_cdc_dev {
 	uintptr_t rx_in_context;
 	pios_com_callback tx_out_cb;
 	uintptr_t tx_out_context;
+	pios_com_tx_span_callback tx_span_cb;
+	uintptr_t tx_span_context;
 
 	bool usb_ctrl_if_enabled;
 	bool usb_data_if_enabled;
@@ -84,6 +88,9 @@ struct pios_usb_cdc_dev {
 	uint8_t tx_packet_buffer[PIOS_USB_BOARD_CDC_DATA_LENGTH - 1] __attribute__ ((aligned(4)));
 	volatile bool tx_active;
 
+	/* Bytes of the COM fifo the IN endpoint is sending in place */
+	uint16_t tx_span_len;
+
 	uint8_t ctrl_tx_packet_buffer[PIOS_USB_BOARD_CDC_MGMT_LENGTH] __attribute__ ((aligned(4)));
 
 	uint32_t rx_dropped;
@@ -160,6 +167,7 @@ int32_t PIOS_USB_CDC_Init(uintptr_t * usbcdc_id, const struct pios_usb_cdc_cfg *
 	/* Rx and Tx are not active yet */
 	usb_cdc_dev->rx_active = false;
 	usb_cdc_dev->tx_active = false;
+	usb_cdc_dev->tx_span_len = 0;
 
 	/* Clear stats */
 	usb_cdc_dev->rx_dropped = 0;
@@ -187,18 +195,40 @@ out_fail:
 static bool PIOS_USB_CDC_SendData(struct pios_usb_cdc_dev * usb_cdc_dev)
 {
 	uint16_t bytes_to_tx;
+	const uint8_t * tx_buf;
 
-	if (!usb_cdc_dev->tx_out_cb) {
+	bool need_yield = false;
+	if (usb_cdc_dev->tx_span_cb) {
+		/*
+		 * Send straight out of the COM fifo. The core copies the packet
+		 * into the endpoint fifo from the tx fifo empty interrupt, so the
+		 * region is only given back once the IN transfer has completed.
+		 */
+		uint8_t * span;
+		bytes_to_tx = (usb_cdc_dev->tx_span_cb)(usb_cdc_dev->tx_span_context,
+							&span,
+							usb_cdc_dev->tx_span_len,
+							&need_yield);
+		if (bytes_to_tx > sizeof(usb_cdc_dev->tx_packet_buffer)) {
+			bytes_to_tx = sizeof(usb_cdc_dev->tx_packet_buffer);
+		}
+		usb_cdc_dev->tx_span_len = bytes_to_tx;
+		tx_buf = span;
+	} else if (usb_cdc_dev->tx_out_cb) {
+		bytes_to_tx = (usb_cdc_dev->tx_out_cb)(usb_cdc_dev->tx_out_context,
+						       usb_cdc_dev->tx_packet_buffer,
+						       sizeof(usb_cdc_dev->tx_packet_buffer),
+						       NULL,
+						       &need_yield);
+		tx_buf = usb_cdc_dev->tx_packet_buffer;
+	} else {
 		return false;
 	}
 
-	bool need_yield = false;
-	bytes_to_tx = (usb_cdc_dev->tx_out_cb)(usb_cdc_dev->tx_out_context,
-					       usb_cdc_dev->tx_packet_buffer,
-					       sizeof(usb_cdc_dev->tx_packet_buffer),
-					       NULL,
-					       &need_yield);
 	if (bytes_to_tx == 0) {
+#if defined(PIOS_INCLUDE_FREERTOS)
+		portEND_SWITCHING_ISR(need_yield);
+#endif	/* PIOS_INCLUDE_FREERTOS */
 		return false;
 	}
 
@@ -209,7 +239,7 @@ static bool PIOS_USB_CDC_SendData(struct pios_usb_cdc_dev * usb_cdc_dev)
 	usb_cdc_dev->tx_active = true;
 
 	PIOS_USBHOOK_EndpointTx(usb_cdc_dev->cfg->data_tx_ep,
-				usb_cdc_dev->tx_packet_buffer,
+				tx_buf,
 				bytes_to_tx);
 
 #if defined(PIOS_INCLUDE_FREERTOS)
@@ -295,6 +325,21 @@ static void PIOS_USB_CDC_RegisterTxCallback(uintptr_t usbcdc_id, pios_com_callba
 	usb_cdc_dev->tx_out_cb = tx_out_cb;
 }
 
+static void PIOS_USB_CDC_RegisterTxSpanCallback(uintptr_t usbcdc_id, pios_com_tx_span_callback tx_span_cb, uintptr_t context)
+{
+	struct pios_usb_cdc_dev * usb_cdc_dev = (struct pios_usb_cdc_dev *)usbcdc_id;
+
+	bool valid = PIOS_USB_CDC_validate(usb_cdc_dev);
+	PIOS_Assert(valid);
+
+	/* 
+	 * Order is important in these assignments since ISR uses _cb
+	 * field to determine if it's ok to dereference _cb and _context
+	 */
+	usb_cdc_dev->tx_span_context = context;
+	usb_cdc_dev->tx_span_cb = tx_span_cb;
+}
+
 static bool PIOS_USB_CDC_CTRL_EP_IN_Callback(uintptr_t usb_cdc_id, uint8_t epnum, uint16_t len);
 
 static void PIOS_USB_CDC_CTRL_IF_Init(uintptr_t usb_cdc_id)
@@ -543,6 +588,9 @@ static void PIOS_USB_CDC_DATA_IF_DeInit(uintptr_t usb_cdc_id)
 	usb_cdc_dev->tx_active = false;
 	usb_cdc_dev->usb_data_if_enabled = false;
 
+	/* The transfer in flight is gone, its bytes stay in the COM fifo */
+	usb_cdc_dev->tx_span_len = 0;
+
 	/* DeRegister endpoint specific callbacks with the USBHOOK layer */
 	PIOS_USBHOOK_DeRegisterEpInCallback(usb_cdc_dev->cfg->data_tx_ep);
 	PIOS_USBHOOK_DeRegisterEpOutCallback(usb_cdc_dev->cfg->data_rx_ep);
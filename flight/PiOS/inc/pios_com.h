@@ -36,6 +36,14 @@
 
 typedef uint16_t (*pios_com_callback)(uintptr_t context, uint8_t * buf, uint16_t buf_len, uint16_t * headroom, bool * task_woken);
 
+/*
+ * Zero copy transmit for drivers that send straight out of the tx fifo:
+ * releases the sent bytes of the region handed out by the previous call,
+ * then points buf at the next contiguous region and returns its length.
+ * The driver must not read a region after passing its length back.
+ */
+typedef uint16_t (*pios_com_tx_span_callback)(uintptr_t context, uint8_t ** buf, uint16_t sent, bool * task_woken);
+
 struct pios_com_driver {
 	void (*init)(uintptr_t id);
 	void (*set_baud)(uintptr_t id, uint32_t baud);
@@ -44,6 +52,7 @@ struct pios_com_driver {
 	void (*bind_rx_cb)(uintptr_t id, pios_com_callback rx_in_cb, uintptr_t context);
 	void (*bind_tx_cb)(uintptr_t id, pios_com_callback tx_out_cb, uintptr_t context);
 	bool (*available)(uintptr_t id);
+	void (*bind_tx_span_cb)(uintptr_t id, pios_com_tx_span_callback tx_span_cb, uintptr_t context);
 };
 
 /* Public Functions */
@@ -52,6 +61,9 @@ extern int32_t PIOS_COM_SendCharNonBlocking(uintptr_t com_id, char c);
 extern int32_t PIOS_COM_SendChar(uintptr_t com_id, char c);
 extern int32_t PIOS_COM_SendBufferNonBlocking(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
 extern int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
+extern uint8_t *PIOS_COM_SendReserve(uintptr_t com_id, uint16_t len);
+extern int32_t PIOS_COM_SendCommit(uintptr_t com_id, uint16_t len);
+extern uint16_t PIOS_COM_GetTxFree(uintptr_t com_id);
 extern int32_t PIOS_COM_SendStringNonBlocking(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendString(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendFormattedStringNonBlocking(uintptr_t com_id, const char *format, ...);
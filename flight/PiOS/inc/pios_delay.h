@@ -39,6 +39,9 @@ extern uint32_t PIOS_DELAY_GetuS();
 extern uint32_t PIOS_DELAY_GetuSSince(uint32_t t);
 extern uint32_t PIOS_DELAY_GetRaw();
 extern uint32_t PIOS_DELAY_DiffuS(uint32_t raw);
+#if defined(PIOS_SIM_REPLAY) || defined(PIOS_SIM_LOCKSTEP)
+extern void PIOS_DELAY_SetuS(uint32_t uS);
+#endif
 
 #endif /* PIOS_DELAY_H */
 
@@ -46,12 +46,57 @@ struct pios_i2c_txn {
 	uint8_t *buf;
 };
 
+/* Only the F4 adapter queues requests, see PIOS_I2C_Submit */
+#if defined(STM32F4XX)
+#define PIOS_I2C_HAS_QUEUE
+#endif
+
+struct pios_i2c_request;
+
+/**
+ * Completion of a queued request, called from the I2C interrupt with
+ * 0 on success, -1 on a bus error, -2 if aborted and -3 on a NACK.
+ * The callback may submit further requests.
+ */
+typedef void (*pios_i2c_callback)(struct pios_i2c_request *request, int32_t result, bool *woken);
+
+/**
+ * A list of transactions run back to back on the bus. Requests can be
+ * chained through next and submitted as one batch; the request, its
+ * transactions and their buffers belong to the driver until completion.
+ * The bytes are moved by the I2C interrupts, not by DMA.
+ */
+struct pios_i2c_request {
+	const struct pios_i2c_txn *txn_list;
+	uint32_t num_txns;
+	pios_i2c_callback callback;
+	void *ctx;
+	struct pios_i2c_request *next;
+};
+
+struct pios_i2c_stats {
+	uint32_t requests;		/* completed, whatever the result */
+	uint32_t bytes;			/* transferred by successful requests */
+	uint32_t bytes_per_second;	/* since the previous PIOS_I2C_GetStats */
+	uint32_t nacks;
+	uint32_t bus_errors;
+	uint32_t fsm_faults;		/* unexpected events, also counted in bus_errors */
+	uint32_t timeouts;
+	uint16_t queue_depth;		/* queued requests, including the active one */
+	uint16_t max_queue_depth;
+};
+
 /* Public Functions */
 extern int32_t PIOS_I2C_CheckClear(uint32_t i2c_id);
 extern int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns);
 extern int32_t PIOS_I2C_Transfer_Callback(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns, void *callback);
+extern int32_t PIOS_I2C_Submit(uint32_t i2c_id, struct pios_i2c_request *request);
+extern int32_t PIOS_I2C_Abort(uint32_t i2c_id, struct pios_i2c_request *request);
+extern int32_t PIOS_I2C_GetStats(uint32_t i2c_id, struct pios_i2c_stats *stats);
+extern uint32_t PIOS_I2C_GetAdapter(uint8_t bus);
 extern void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id);
 extern void PIOS_I2C_ER_IRQ_Handler(uint32_t i2c_id);
+extern void PIOS_I2C_DMA_IRQ_Handler(uint32_t i2c_id);
 
 #endif /* PIOS_I2C_H */
 
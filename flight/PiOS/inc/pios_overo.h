@@ -30,6 +30,9 @@
 #ifndef PIOS_OVERO_H
 #define PIOS_OVERO_H
 
+/* Bytes clocked out to the Overo with each SPI transaction */
+#define PIOS_OVERO_PACKET_SIZE 1024
+
 extern void PIOS_OVERO_DMA_irq_handler(uintptr_t overo_id);
 extern int32_t PIOS_OVERO_GetPacketCount(uintptr_t overo_id);
 extern int32_t PIOS_OVERO_GetWrittenBytes(uintptr_t overo_id);
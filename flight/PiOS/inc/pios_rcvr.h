@@ -38,6 +38,11 @@ struct pios_rcvr_driver {
 
 /* Public Functions */
 extern int32_t PIOS_RCVR_Read(uintptr_t rcvr_id, uint8_t channel);
+extern bool PIOS_RCVR_WaitForFrame(uint32_t timeout_ms, uint32_t *frame_time);
+
+/* Frame notification for the receiver drivers */
+extern bool PIOS_RCVR_ActiveFromISR(void);
+extern void PIOS_RCVR_Active(void);
 
 /*! Define error codes for PIOS_RCVR_Get */
 enum PIOS_RCVR_errors {
@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ * @file       pios_sensor_bus.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SENSOR_BUS Sensor bus scheduler
+ * @{
+ * @brief Deadline scheduler shared by the sensors on one bus
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_SENSOR_BUS_H
+#define PIOS_SENSOR_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct pios_sensor_bus;
+
+//! Returned by a job that only runs again when triggered
+#define PIOS_SENSOR_BUS_IDLE 0xffffffff
+
+/**
+ * One step of a sensor driver. Called from the bus task with the bus to
+ * itself; returns the time in microseconds until the job must run again,
+ * measured from when it returns, or PIOS_SENSOR_BUS_IDLE.
+ */
+typedef uint32_t (*pios_sensor_bus_job_fn)(void *ctx);
+
+//! A driver's slot in the bus schedule, owned by the driver
+struct pios_sensor_bus_job {
+	const char *name;
+	pios_sensor_bus_job_fn run;
+	void *ctx;
+
+	/* Managed by the scheduler */
+	uint32_t deadline_us;
+	bool idle;
+	volatile bool triggered;
+	struct pios_sensor_bus_job *next;
+	struct pios_sensor_bus *bus;
+};
+
+//! Get the scheduler for a bus, creating it the first time
+struct pios_sensor_bus *PIOS_SENSOR_BUS_Get(uint32_t bus_id);
+
+//! Add a job to a bus, first run after delay_us
+int32_t PIOS_SENSOR_BUS_AddJob(struct pios_sensor_bus *bus, struct pios_sensor_bus_job *job, uint32_t delay_us);
+
+//! Make a job due now, from an interrupt (e.g. a data ready line)
+bool PIOS_SENSOR_BUS_TriggerFromISR(struct pios_sensor_bus_job *job);
+
+//! Run every job that is due, earliest deadline first
+uint32_t PIOS_SENSOR_BUS_Run(struct pios_sensor_bus *bus);
+
+#endif /* PIOS_SENSOR_BUS_H */
+
+/**
+  * @}
+  * @}
+  */
@@ -48,6 +48,7 @@ struct pios_usart_cfg {
 	bool rx_invert;
 	bool tx_invert;
 	bool rxtx_swap;
+	const struct stm32_dma *dma;	/* F4: tx by DMA from the COM fifo, NULL for per byte */
 };
 
 extern int32_t PIOS_USART_Init(uintptr_t * usart_id, const struct pios_usart_cfg * cfg);
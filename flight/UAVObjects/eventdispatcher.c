@@ -47,6 +47,17 @@
 #define TASK_PRIORITY (tskIDLE_PRIORITY + 3)
 #define MAX_UPDATE_PERIOD_MS 1000
 
+// Size of the pending callback ring of each lane. Together they hold 1.8 times
+// the entries of the old single queue: at the default size 36 entries of 16
+// bytes (576 bytes) instead of 20 entries of 20 bytes (400 bytes)
+#define HIGH_QUEUE_SIZE (MAX_QUEUE_SIZE / 4 + 1)
+#define NORMAL_QUEUE_SIZE MAX_QUEUE_SIZE
+#define LOW_QUEUE_SIZE (MAX_QUEUE_SIZE / 2)
+
+// Callbacks a pending lane lets higher lanes run ahead of it before its
+// oldest callback goes first, so a busy high lane cannot starve the others
+#define MAX_PASSED_OVER 8
+
 // Private types
 
 
@@ -70,9 +81,36 @@ struct PeriodicObjectListStruct {
 };
 typedef struct PeriodicObjectListStruct PeriodicObjectList;
 
+/**
+ * Pending callback
+ */
+typedef struct {
+	UAVObjEvent ev; /** The actual event */
+	UAVObjEventCallback cb; /** The callback function */
+} EventPending;
+
+/**
+ * Ring of pending callbacks of one priority
+ */
+struct EventLane {
+	EventPending *ring;
+	uint8_t size;
+	uint8_t head;
+	uint8_t count;
+	uint8_t passedOver; /** Callbacks of higher lanes run while this one was pending */
+};
+
 // Private variables
 static PeriodicObjectList* objList;
-static xQueueHandle queue;
+static EventPending highRing[HIGH_QUEUE_SIZE];
+static EventPending normalRing[NORMAL_QUEUE_SIZE];
+static EventPending lowRing[LOW_QUEUE_SIZE];
+static struct EventLane lanes[EV_PRIORITY_NUM] = {
+	[EV_PRIORITY_HIGH]   = { .ring = highRing,   .size = HIGH_QUEUE_SIZE },
+	[EV_PRIORITY_NORMAL] = { .ring = normalRing, .size = NORMAL_QUEUE_SIZE },
+	[EV_PRIORITY_LOW]    = { .ring = lowRing,    .size = LOW_QUEUE_SIZE },
+};
+static xSemaphoreHandle wakeup;
 static xTaskHandle eventTaskHandle;
 static xSemaphoreHandle mutex;
 static EventStats stats;
@@ -80,6 +118,8 @@ static EventStats stats;
 // Private functions
 static int32_t processPeriodicUpdates();
 static void eventTask();
+static bool eventPop(EventPending *pending, uint8_t *priority);
+static void invokeCallback(UAVObjEvent *ev, UAVObjEventCallback cb, uint8_t priority);
 static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, xQueueHandle queue, uint16_t periodMs);
 static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, xQueueHandle queue, uint16_t periodMs);
 static uint16_t randomizePeriod(uint16_t periodMs);
@@ -100,8 +140,12 @@ int32_t EventDispatcherInitialize()
 	if (mutex == NULL)
 		return -1;
 
-	// Create event queue
-	queue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(EventCallbackInfo));
+	// Create the semaphore the event task sleeps on, binary semaphores
+	// are created given
+	vSemaphoreCreateBinary(wakeup);
+	if (wakeup == NULL)
+		return -1;
+	xSemaphoreTake(wakeup, 0);
 
 	// Create task
 	xTaskCreate( eventTask, (signed char*)"Event", STACK_SIZE, NULL, TASK_PRIORITY, &eventTaskHandle );
@@ -134,19 +178,43 @@ void EventClearStats()
 /**
  * Dispatch an event by invoking the supplied callback. The function
  * returns imidiatelly, the callback is invoked from the event task.
+ * If the same event is already pending for the callback it is only
+ * invoked once, callbacks read the current object data anyway.
  * \param[in] ev The event to be dispatched
  * \param[in] cb The callback function
- * \return Success (0), failure (-1)
+ * \param[in] priority The lane the callback is queued in
+ * \return pdTRUE on success, pdFALSE if the lane is full
  */
-int32_t EventCallbackDispatch(UAVObjEvent* ev, UAVObjEventCallback cb)
+int32_t EventCallbackDispatch(UAVObjEvent* ev, UAVObjEventCallback cb, UAVObjEventPriority priority)
 {
-	EventCallbackInfo evInfo;
-	// Initialize event callback information
-	memcpy(&evInfo.ev, ev, sizeof(UAVObjEvent));
-	evInfo.cb = cb;
-	evInfo.queue = 0;
-	// Push to queue
-	return xQueueSend(queue, &evInfo, 0); // will not block if queue is full
+	struct EventLane *lane = &lanes[priority];
+	int32_t res = pdFALSE;
+
+	portENTER_CRITICAL();
+	for (uint8_t i = 0; i < lane->count; i++) {
+		EventPending *pending = &lane->ring[(lane->head + i) % lane->size];
+		if (pending->cb == cb &&
+			pending->ev.obj == ev->obj &&
+			pending->ev.instId == ev->instId &&
+			pending->ev.event == ev->event) {
+			++stats.coalescedEvents;
+			res = pdTRUE;
+			break;
+		}
+	}
+	if (res != pdTRUE && lane->count < lane->size) {
+		EventPending *pending = &lane->ring[(lane->head + lane->count) % lane->size];
+		pending->ev = *ev;
+		pending->cb = cb;
+		++lane->count;
+		res = pdTRUE;
+	}
+	portEXIT_CRITICAL();
+
+	if (res == pdTRUE)
+		xSemaphoreGive(wakeup);
+
+	return res;
 }
 
 /**
@@ -283,7 +351,8 @@ static void eventTask()
 {
 	int32_t timeToNextUpdateMs;
 	int32_t delayMs;
-	EventCallbackInfo evInfo;
+	EventPending pending;
+	uint8_t priority;
 
 	/* Must do this in task context to ensure that TaskMonitor has already finished its init */
 	TaskMonitorAdd(TASKINFO_RUNNING_EVENTDISPATCHER, eventTaskHandle);
@@ -301,14 +370,11 @@ static void eventTask()
 			delayMs = 0;
 		}
 
-		// Wait for queue message
-		if ( xQueueReceive(queue, &evInfo, delayMs/portTICK_RATE_MS) == pdTRUE )
+		// Run the highest priority pending callback, wait for one if none
+		if ( eventPop(&pending, &priority) ||
+			(xSemaphoreTake(wakeup, delayMs/portTICK_RATE_MS) == pdTRUE && eventPop(&pending, &priority)) )
 		{
-			// Invoke callback, if one
-			if ( evInfo.cb != 0)
-			{
-				evInfo.cb(&evInfo.ev); // the function is expected to copy the event information
-			}
+			invokeCallback(&pending.ev, pending.cb, priority);
 		}
 
 		// Process periodic updates
@@ -319,6 +385,78 @@ static void eventTask()
 	}
 }
 
+/**
+ * Take the oldest pending callback of the highest priority lane, or of a
+ * lower lane that was passed over MAX_PASSED_OVER times
+ * \param[out] pending The callback and its event
+ * \param[out] priority The lane it was taken from
+ * \return true if a callback was pending
+ */
+static bool eventPop(EventPending *pending, uint8_t *priority)
+{
+	int8_t taken = -1;
+
+	portENTER_CRITICAL();
+	for (uint8_t i = 0; i < EV_PRIORITY_NUM; i++) {
+		if (lanes[i].count == 0)
+			continue;
+
+		if (taken < 0) {
+			taken = i;
+		} else if (lanes[i].passedOver >= MAX_PASSED_OVER) {
+			taken = i;
+			++stats.agedCount[i];
+			break;
+		}
+	}
+
+	if (taken >= 0) {
+		struct EventLane *lane = &lanes[taken];
+		*pending = lane->ring[lane->head];
+		*priority = taken;
+		lane->head = (lane->head + 1) % lane->size;
+		--lane->count;
+		lane->passedOver = 0;
+
+		for (uint8_t i = taken + 1; i < EV_PRIORITY_NUM; i++) {
+			if (lanes[i].count > 0 && lanes[i].passedOver < MAX_PASSED_OVER)
+				++lanes[i].passedOver;
+		}
+	}
+	portEXIT_CRITICAL();
+
+	return taken >= 0;
+}
+
+/**
+ * Invoke a callback and account its execution time
+ */
+static void invokeCallback(UAVObjEvent *ev, UAVObjEventCallback cb, uint8_t priority)
+{
+	uint32_t start = PIOS_DELAY_GetRaw();
+	cb(ev); // the function is expected to copy the event information
+	uint32_t us = PIOS_DELAY_DiffuS(start);
+
+	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+	++stats.callbackCount[priority];
+	stats.callbackTimeUs[priority] += us;
+	if (us > stats.callbackMaxUs[priority]) {
+		stats.callbackMaxUs[priority] = us;
+
+		// Remember the callback if it is the slowest of all lanes
+		bool slowest = true;
+		for (uint8_t i = 0; i < EV_PRIORITY_NUM; i++) {
+			if (stats.callbackMaxUs[i] > us)
+				slowest = false;
+		}
+		if (slowest) {
+			stats.slowestCallback = cb;
+			stats.slowestCallbackID = ev->obj ? UAVObjGetID(ev->obj) : 0;
+		}
+	}
+	xSemaphoreGiveRecursive(mutex);
+}
+
 /**
  * Handle periodic updates for all objects.
  * \return The system time until the next update (in ms) or -1 if failed
@@ -351,7 +489,7 @@ static int32_t processPeriodicUpdates()
     			// Invoke callback, if one
     			if ( objEntry->evInfo.cb != 0)
     			{
-    				objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
+    				invokeCallback(&objEntry->evInfo.ev, objEntry->evInfo.cb, EV_PRIORITY_NORMAL);
     			}
     			// Push event to queue, if one
     			if ( objEntry->evInfo.queue != 0)
@@ -39,13 +39,20 @@
 typedef struct {
 	uint32_t lastErrorID;
 	uint32_t eventErrors;
+	uint32_t coalescedEvents; /** Dispatches merged into an identical pending one */
+	uint32_t callbackCount[EV_PRIORITY_NUM]; /** Callbacks invoked per lane */
+	uint32_t callbackTimeUs[EV_PRIORITY_NUM]; /** Total callback execution time per lane */
+	uint32_t callbackMaxUs[EV_PRIORITY_NUM]; /** Longest callback execution time per lane */
+	uint32_t agedCount[EV_PRIORITY_NUM]; /** Callbacks run ahead of a higher lane after waiting too long */
+	uint32_t slowestCallbackID; /** Object of the longest callback */
+	UAVObjEventCallback slowestCallback; /** The longest callback */
 } EventStats;
 
 // Public functions
 int32_t EventDispatcherInitialize();
 void EventGetStats(EventStats* statsOut);
 void EventClearStats();
-int32_t EventCallbackDispatch(UAVObjEvent* ev, UAVObjEventCallback cb);
+int32_t EventCallbackDispatch(UAVObjEvent* ev, UAVObjEventCallback cb, UAVObjEventPriority priority);
 int32_t EventPeriodicCallbackCreate(UAVObjEvent* ev, UAVObjEventCallback cb, uint16_t periodMs);
 int32_t EventPeriodicCallbackUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, uint16_t periodMs);
 int32_t EventPeriodicQueueCreate(UAVObjEvent* ev, xQueueHandle queue, uint16_t periodMs);
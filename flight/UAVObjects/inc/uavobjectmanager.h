@@ -123,11 +123,57 @@ typedef struct {
  */
 typedef void (*UAVObjEventCallback)(UAVObjEvent* ev);
 
+/**
+ * Priority of the event dispatcher lane a callback is invoked from. Pending
+ * callbacks of a higher priority lane run first, except that a lane passed
+ * over 8 times in a row gets its turn. A running callback is never
+ * preempted, so callbacks that write flash belong in the low lane.
+ */
+typedef enum {
+	EV_PRIORITY_HIGH = 0, /** Time critical reactions, e.g. flight mode changes */
+	EV_PRIORITY_NORMAL = 1, /** Default for data objects */
+	EV_PRIORITY_LOW = 2, /** Default for settings and metaobjects */
+} UAVObjEventPriority;
+
+#define EV_PRIORITY_NUM 3
+
+/**
+ * Notifier, a set of pending bits a task can block on. Each connected object
+ * sets its own bits on update and the task reads the latest data with Get,
+ * so nothing is copied per event and the notifier can never overflow.
+ * Only one task may wait on a notifier.
+ */
+typedef struct UAVObjNotifierStruct *UAVObjNotifier;
+
 /**
  * Callback used to initialize the object fields to their default values.
  */
 typedef void (*UAVObjInitializeCallback)(UAVObjHandle obj_handle, uint16_t instId);
 
+/**
+ * Constant description of an object, generated for every object by the
+ * UAVObjectGenerator and kept in flash.
+ */
+typedef struct {
+	uint32_t id; /** Unique object ID */
+	uint16_t num_bytes; /** Number of bytes of object data (for one instance) */
+	bool is_single_instance;
+	bool is_settings;
+	bool is_latest_value; /** Lock-free triple buffered data, see UAVObjRegister */
+	UAVObjMetadata metadata; /** Default metadata */
+	UAVObjInitializeCallback init_cb; /** Default field and metadata initialization function */
+	UAVObjHandle *handle; /** Where the object handle is stored once registered */
+} UAVObjDescriptor;
+
+/**
+ * Entry of the object registry generated in uavobjectsregistry.h. The
+ * descriptor is NULL for objects that are not linked into the firmware.
+ */
+typedef struct {
+	uint32_t id;
+	const UAVObjDescriptor *descriptor;
+} UAVObjRegistryEntry;
+
 /**
  * Event manager statistics
  */
@@ -141,8 +187,7 @@ typedef struct {
 int32_t UAVObjInitialize();
 void UAVObjGetStats(UAVObjStats* statsOut);
 void UAVObjClearStats();
-UAVObjHandle UAVObjRegister(uint32_t id,
-		int32_t isSingleInstance, int32_t isSettings, uint32_t numBytes, UAVObjInitializeCallback initCb);
+UAVObjHandle UAVObjRegister(const UAVObjDescriptor *descriptor);
 UAVObjHandle UAVObjGetByID(uint32_t id);
 uint32_t UAVObjGetID(UAVObjHandle obj);
 uint32_t UAVObjGetNumBytes(UAVObjHandle obj);
@@ -194,7 +239,12 @@ int8_t UAVObjReadOnly(UAVObjHandle obj);
 int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, xQueueHandle queue, uint8_t eventMask);
 int32_t UAVObjDisconnectQueue(UAVObjHandle obj_handle, xQueueHandle queue);
 int32_t UAVObjConnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb, uint8_t eventMask);
+int32_t UAVObjConnectCallbackPriority(UAVObjHandle obj_handle, UAVObjEventCallback cb, uint8_t eventMask, UAVObjEventPriority priority);
 int32_t UAVObjDisconnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb);
+UAVObjNotifier UAVObjNotifierCreate();
+int32_t UAVObjConnectNotifier(UAVObjHandle obj_handle, UAVObjNotifier notifier, uint32_t bits, uint8_t eventMask);
+int32_t UAVObjDisconnectNotifier(UAVObjHandle obj_handle, UAVObjNotifier notifier);
+uint32_t UAVObjNotifierWait(UAVObjNotifier notifier, uint32_t bitsToWaitFor, portTickType timeout);
 void UAVObjRequestUpdate(UAVObjHandle obj);
 void UAVObjRequestInstanceUpdate(UAVObjHandle obj_handle, uint16_t instId);
 void UAVObjUpdated(UAVObjHandle obj);
@@ -0,0 +1,50 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsCore Tau Labs Core components
+ * @{
+ * @addtogroup UAVObjects UAVObject set for this firmware
+ * @{
+ *
+ * @file       uavobjectsregistry.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @brief      Constant registry of all objects, sorted by object ID. This
+ *             file is automatically updated by the parser and is only
+ *             meant to be included by uavobjectmanager.c.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef UAVOBJECTSREGISTRY_H
+#define UAVOBJECTSREGISTRY_H
+
+/*
+ * Each target only links the objects it uses. The descriptors are weak
+ * references so the ones that are not linked in resolve to NULL.
+ */
+$(REGISTRYEXTERNS)
+#define UAVOBJECTS_REGISTRY_SIZE $(REGISTRYSIZE)
+
+static const UAVObjRegistryEntry uavo_registry[UAVOBJECTS_REGISTRY_SIZE] = {
+$(REGISTRYENTRIES)};
+
+#endif /* UAVOBJECTSREGISTRY_H */
+
+/**
+ * @}
+ * @}
+ */
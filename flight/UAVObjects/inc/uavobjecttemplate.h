@@ -42,9 +42,11 @@
 #define $(NAMEUC)_OBJID $(OBJIDHEX)
 #define $(NAMEUC)_ISSINGLEINST $(ISSINGLEINST)
 #define $(NAMEUC)_ISSETTINGS $(ISSETTINGS)
+#define $(NAMEUC)_ISLATESTVALUE $(ISLATESTVALUE)
 #define $(NAMEUC)_NUMBYTES $(NUMBYTES)
 
 // Generic interface functions
+extern const UAVObjDescriptor $(NAME)Descriptor;
 int32_t $(NAME)Initialize();
 UAVObjHandle $(NAME)Handle();
 void $(NAME)SetDefaults(UAVObjHandle obj, uint16_t instId);
@@ -72,6 +74,8 @@ static inline int32_t $(NAME)ConnectQueue(xQueueHandle queue) { return UAVObjCon
 
 static inline int32_t $(NAME)ConnectCallback(UAVObjEventCallback cb) { return UAVObjConnectCallback($(NAME)Handle(), cb, EV_MASK_ALL_UPDATES); }
 
+static inline int32_t $(NAME)ConnectNotifier(UAVObjNotifier notifier, uint32_t bits) { return UAVObjConnectNotifier($(NAME)Handle(), notifier, bits, EV_MASK_ALL_UPDATES); }
+
 static inline uint16_t $(NAME)CreateInstance() { return UAVObjCreateInstance($(NAME)Handle(), &$(NAME)SetDefaults); }
 
 static inline void $(NAME)RequestUpdate() { UAVObjRequestUpdate($(NAME)Handle()); }
@@ -32,6 +32,7 @@
 #include "openpilot.h"
 #include "pios_struct_helper.h"
 #include "pios_heap.h"		/* PIOS_malloc_no_dma */
+#include "uavobjectsregistry.h"	/* uavo_registry */
 
 extern uintptr_t pios_uavo_settings_fs_id;
 
@@ -52,10 +53,23 @@ typedef void* InstanceHandle;
 struct ObjectEventEntry {
 	xQueueHandle              queue;
 	UAVObjEventCallback       cb;
+	UAVObjNotifier            notifier;
+	uint32_t                  notifyBits;
 	uint8_t                   eventMask;
+	uint8_t                   priority;
 	struct ObjectEventEntry * next;
 };
 
+/**
+ * Notifier, the waiting task sleeps on the semaphore which is given after
+ * the pending bits have been set. The semaphore only counts to one, repeated
+ * updates before the task runs collapse into the same bits.
+ */
+struct UAVObjNotifierStruct {
+	volatile uint32_t pending;
+	xSemaphoreHandle  sem;
+};
+
 /*
   MetaInstance   == [UAVOBase [UAVObjMetadata]]
   SingleInstance == [UAVOBase [UAVOData [InstanceData]]]
@@ -80,6 +94,7 @@ struct UAVOBase {
 		bool isMeta        : 1;
 		bool isSingle      : 1;
 		bool isSettings    : 1;
+		bool isLatest      : 1;
 	} flags;
 
 } __attribute__((packed));
@@ -93,14 +108,13 @@ struct UAVOMeta {
 /* Shared data structure for all data-carrying UAVObjects (UAVOSingle and UAVOMulti) */
 struct UAVOData {
 	struct UAVOBase   base;
-	uint32_t          id;
+	/* ID, size and default values live in flash */
+	const UAVObjDescriptor * descriptor;
 	/*
 	 * Embed the Meta object as another complete UAVO
 	 * inside the payload for this UAVO.
 	 */
 	struct UAVOMeta   metaObj;
-	struct UAVOData * next;
-	uint16_t          instance_size;
 } __attribute__((packed));
 
 /* Augmented type for Single Instance Data UAVO */
@@ -144,23 +158,68 @@ struct UAVOMulti {
 #define LinkedMetaDataPtr(obj) ((UAVObjMetadata*)&((obj)->metaObj.instance0))
 #define MetaObjectId(id) ((id)+1)
 
+/** object ID and instance size are taken from the constant descriptor **/
+#define ObjId(obj) ((obj)->descriptor->id)
+#define ObjInstanceSize(obj) ((obj)->descriptor->num_bytes)
+
+/**
+ * Iterate over all registered objects in object ID order. Objects that
+ * are not linked in or not registered yet are skipped.
+ */
+#define UAVO_FOREACH(obj) \
+	for (uint16_t uavo_idx = 0; uavo_idx < UAVOBJECTS_REGISTRY_SIZE; ++uavo_idx) \
+		if (((obj) = registeredObject(uavo_idx)) != NULL)
+
 /** all information about instances are dependant on object type **/
 #define ObjSingleInstanceDataOffset(obj) ((void*)(&(( (struct UAVOSingle*)obj )->instance0)))
 #define InstanceDataOffset(inst) ((void*)&(( (struct UAVOMultiInst*)inst )->instance))
 #define InstanceData(instance) (void*)instance
 
+/*
+  LatestValue    == [UAVOBase [UAVOData [Buffer0 [Buffer1 [Buffer2 [UAVOLatestCtl]]]]]]
+
+  A latest value object is a single instance object whose data lives in
+  three buffers. A writer claims a buffer that is neither published nor
+  claimed by another writer, fills it and then publishes it, so readers
+  never wait for a write in progress. A reader that was overtaken by two
+  writes sees the sequence number of its buffer change and copies again.
+
+  The published buffer and the claims share one word, so that a writer
+  can never claim the buffer another writer just published. With three
+  buffers two writers can be in progress at once, a third one fails.
+ */
+struct UAVOLatestCtl {
+	volatile uint32_t seq[3]; /* odd while the buffer is being written */
+	volatile uint32_t state;  /* published buffer, claim bits above it */
+};
+
+#define LATEST_PUBLISHED(state) ((state) & 0xff)
+#define LATEST_CLAIMED(n) (0x100 << (n))
+#define LATEST_NONE 3
+
+#define LatestBuffer(obj, n) ((uint8_t *)ObjSingleInstanceDataOffset(obj) + (n) * ObjInstanceSize(obj))
+#define LatestAllocSize(num_bytes) (3 * (num_bytes) + 3 + sizeof(struct UAVOLatestCtl))
+
 // Private functions
 static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 			UAVObjEventType event);
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId);
 static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId);
 static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue,
-			UAVObjEventCallback cb, uint8_t eventMask);
+			UAVObjEventCallback cb, UAVObjNotifier notifier,
+			uint32_t notifyBits, uint8_t eventMask,
+			UAVObjEventPriority priority);
 static int32_t disconnectObj(UAVObjHandle obj_handle, xQueueHandle queue,
-			UAVObjEventCallback cb);
+			UAVObjEventCallback cb, UAVObjNotifier notifier);
+static void latestRead(struct UAVOData * obj, void * dataOut,
+			uint32_t offset, uint32_t size);
+static int32_t latestWrite(struct UAVOData * obj, const void * dataIn,
+			uint32_t offset, uint32_t size);
+static uint8_t latestClaim(struct UAVOData * obj);
+static void latestRelease(struct UAVOData * obj, uint8_t buf, bool publish);
+static void latestNotify(struct UAVOData * obj, UAVObjEventType event);
 
 // Private variables
-static struct UAVOData * uavo_list;
 static xSemaphoreHandle mutex;
 static const UAVObjMetadata defMetadata = {
 	.flags = (ACCESS_READWRITE << UAVOBJ_ACCESS_SHIFT |
@@ -176,6 +235,44 @@ static const UAVObjMetadata defMetadata = {
 
 static UAVObjStats stats;
 
+/**
+ * Binary search the constant object registry
+ * \param[in] id The object ID
+ * \return The object descriptor or NULL if the object is not linked in
+ */
+static const UAVObjDescriptor * findDescriptor(uint32_t id)
+{
+	int32_t lo = 0;
+	int32_t hi = UAVOBJECTS_REGISTRY_SIZE - 1;
+
+	while (lo <= hi) {
+		int32_t mid = (lo + hi) / 2;
+
+		if (uavo_registry[mid].id < id)
+			lo = mid + 1;
+		else if (uavo_registry[mid].id > id)
+			hi = mid - 1;
+		else
+			return uavo_registry[mid].descriptor;
+	}
+
+	return NULL;
+}
+
+/**
+ * Get the registered object at a given position of the registry
+ * \return The object or NULL if it is not linked in or not registered
+ */
+static inline struct UAVOData * registeredObject(uint16_t idx)
+{
+	const UAVObjDescriptor * descriptor = uavo_registry[idx].descriptor;
+
+	if (descriptor == NULL)
+		return NULL;
+
+	return (struct UAVOData *) *descriptor->handle;
+}
+
 /**
  * Initialize the object manager
  * \return 0 Success
@@ -184,7 +281,6 @@ static UAVObjStats stats;
 int32_t UAVObjInitialize()
 {
 	// Initialize variables
-	uavo_list = NULL;
 	memset(&stats, 0, sizeof(UAVObjStats));
 
 	// Create mutex
@@ -294,53 +390,55 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
 
 /**
  * Register and new object in the object manager.
- * \param[in] id Unique object ID
- * \param[in] isSingleInstance Is this a single instance or multi-instance object
- * \param[in] isSettings Is this a settings object
- * \param[in] numBytes Number of bytes of object data (for one instance)
- * \param[in] initCb Default field and metadata initialization function
+ * \param[in] descriptor Constant description of the object, generated
+ * in flash. The object is published through descriptor->handle.
  * \return Object handle, or NULL if failure.
  * \return
+ *
+ * Objects marked latestvalue in their definition get/set their data
+ * without taking the object manager lock, and only go through the
+ * event machinery when a queue or callback is connected. Up to two
+ * writers, e.g. the sensor task and a telemetry unpack, can write at the
+ * same time, a write that finds no free buffer fails.
  */
-UAVObjHandle UAVObjRegister(uint32_t id, 
-			int32_t isSingleInstance, int32_t isSettings,
-			uint32_t num_bytes,
-			UAVObjInitializeCallback initCb)
+UAVObjHandle UAVObjRegister(const UAVObjDescriptor * descriptor)
 {
 	struct UAVOData * uavo_data = NULL;
 
+	PIOS_Assert(descriptor);
+
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
 	/* Don't allow duplicate registrations */
-	if (UAVObjGetByID(id))
+	if (*descriptor->handle)
 		goto unlock_exit;
 
 	/* Map the various flags to one of the UAVO types we understand */
-	if (isSingleInstance) {
-		uavo_data = UAVObjAllocSingle (num_bytes);
+	if (descriptor->is_latest_value) {
+		uavo_data = UAVObjAllocSingle (LatestAllocSize(descriptor->num_bytes));
+		if (uavo_data)
+			uavo_data->base.flags.isLatest = true;
+	} else if (descriptor->is_single_instance) {
+		uavo_data = UAVObjAllocSingle (descriptor->num_bytes);
 	} else {
-		uavo_data = UAVObjAllocMulti (num_bytes);
+		uavo_data = UAVObjAllocMulti (descriptor->num_bytes);
 	}
 
 	if (!uavo_data)
 		goto unlock_exit;
 
 	/* Fill in the details about this UAVO */
-	uavo_data->id            = id;
-	uavo_data->instance_size = num_bytes;
-	if (isSettings) {
+	uavo_data->descriptor = descriptor;
+	if (descriptor->is_settings) {
 		uavo_data->base.flags.isSettings = true;
 	}
 
 	/* Initialize the embedded meta UAVO */
 	UAVObjInitMetaData (&uavo_data->metaObj);
 
-	/* Add the newly created object to the global list of objects */
-	LL_APPEND(uavo_list, uavo_data);
-
 	/* Initialize object fields and metadata to default values */
-	if (initCb)
-		initCb((UAVObjHandle) uavo_data, 0);
+	if (descriptor->init_cb)
+		descriptor->init_cb((UAVObjHandle) uavo_data, 0);
 
 	/* Always try to load the meta object from flash */
 	UAVObjLoad((UAVObjHandle) &(uavo_data->metaObj), 0);
@@ -349,6 +447,10 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	if (uavo_data->base.flags.isSettings)
 		UAVObjLoad((UAVObjHandle) uavo_data, 0);
 
+	/* Publish the object only now that it holds its initial values,
+	 * UAVObjGetByID reads the handle without the lock */
+	*descriptor->handle = (UAVObjHandle) uavo_data;
+
 	// fire events for outer object and its embedded meta object
 	UAVObjInstanceUpdated((UAVObjHandle) uavo_data, 0);
 	UAVObjInstanceUpdated((UAVObjHandle) &(uavo_data->metaObj), 0);
@@ -365,27 +467,18 @@ unlock_exit:
  */
 UAVObjHandle UAVObjGetByID(uint32_t id)
 {
-	UAVObjHandle * found_obj = (UAVObjHandle *) NULL;
+	// The registry is constant and a handle is only written once, when
+	// the object is registered, so no lock is needed
+	const UAVObjDescriptor * descriptor = findDescriptor(id);
+	if (descriptor && *descriptor->handle)
+		return *descriptor->handle;
 
-	// Get lock
-	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+	// Meta objects use the ID following the one of their data object
+	descriptor = findDescriptor(id - 1);
+	if (descriptor && *descriptor->handle)
+		return (UAVObjHandle) &((struct UAVOData *) *descriptor->handle)->metaObj;
 
-	// Look for object
-	struct UAVOData * tmp_obj;
-	LL_FOREACH(uavo_list, tmp_obj) {
-		if (tmp_obj->id == id) {
-			found_obj = (UAVObjHandle *)tmp_obj;
-			goto unlock_exit;
-		}
-		if (MetaObjectId(tmp_obj->id) == id) {
-			found_obj = (UAVObjHandle *)&(tmp_obj->metaObj);
-			goto unlock_exit;
-		}
-	}
-
-unlock_exit:
-	xSemaphoreGiveRecursive(mutex);
-	return found_obj;
+	return NULL;
 }
 
 /**
@@ -404,12 +497,12 @@ uint32_t UAVObjGetID(UAVObjHandle obj_handle)
 		/* We have a meta object, find our containing UAVO */
 		struct UAVOData * uavo_data = container_of ((struct UAVOMeta *)uavo_base, struct UAVOData, metaObj);
 
-		return MetaObjectId (uavo_data->id);
+		return MetaObjectId (ObjId(uavo_data));
 	} else {
 		/* We have a data object, augment our pointer */
 		struct UAVOData * uavo_data = (struct UAVOData *) uavo_base;
 
-		return (uavo_data->id);
+		return (ObjId(uavo_data));
 	}
 }
 
@@ -433,7 +526,7 @@ uint32_t UAVObjGetNumBytes(UAVObjHandle obj)
 		/* We have a data object, augment our pointer */
 		struct UAVOData * uavo = (struct UAVOData *) uavo_base;
 
-		instance_size = uavo->instance_size;
+		instance_size = ObjInstanceSize(uavo);
 	}
 
 	return (instance_size);
@@ -591,6 +684,14 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 			goto unlock_exit;
 		}
 		memcpy(MetaDataPtr((struct UAVOMeta *)obj_handle), dataIn, MetaNumBytes);
+	} else if (((struct UAVOBase *)obj_handle)->flags.isLatest) {
+		if (instId != 0) {
+			goto unlock_exit;
+		}
+		if (latestWrite((struct UAVOData *) obj_handle, dataIn, 0,
+				ObjInstanceSize((struct UAVOData *) obj_handle)) != 0) {
+			goto unlock_exit;
+		}
 	} else {
 		struct UAVOData *obj;
 		InstanceHandle instEntry;
@@ -609,7 +710,7 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 			}
 		}
 		// Set the data
-		memcpy(InstanceData(instEntry), dataIn, obj->instance_size);
+		memcpy(InstanceData(instEntry), dataIn, ObjInstanceSize(obj));
 	}
 
 	// Fire event
@@ -642,6 +743,12 @@ int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t * dataOut)
 			goto unlock_exit;
 		}
 		memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
+	} else if (((struct UAVOBase *)obj_handle)->flags.isLatest) {
+		if (instId != 0) {
+			goto unlock_exit;
+		}
+		latestRead((struct UAVOData *) obj_handle, dataOut, 0,
+			ObjInstanceSize((struct UAVOData *) obj_handle));
 	} else {
 		struct UAVOData *obj;
 		InstanceHandle instEntry;
@@ -655,7 +762,7 @@ int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t * dataOut)
 			goto unlock_exit;
 		}
 		// Pack data
-		memcpy(dataOut, InstanceData(instEntry), obj->instance_size);
+		memcpy(dataOut, InstanceData(instEntry), ObjInstanceSize(obj));
 	}
 
 	rc = 0;
@@ -713,6 +820,40 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
 					UAVObjGetNumBytes(obj_handle));
 #endif  /* PIOS_INCLUDE_FASTHEAP */
 
+		if (rc != 0)
+			return -1;
+	} else if (((struct UAVOBase *)obj_handle)->flags.isLatest) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if (instId != 0)
+			return -1;
+
+		// Save a copy, the published buffer can be replaced meanwhile
+		int32_t rc;
+#if defined(PIOS_INCLUDE_FASTHEAP)
+		latestRead(obj, uavobj_save_trampoline, 0, ObjInstanceSize(obj));
+
+		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
+					UAVObjGetID(obj_handle),
+					instId,
+					uavobj_save_trampoline,
+					UAVObjGetNumBytes(obj_handle));
+#else /* PIOS_INCLUDE_FASTHEAP */
+		uint8_t buf = latestClaim(obj);
+		if (buf == LATEST_NONE)
+			return -1;
+
+		latestRead(obj, LatestBuffer(obj, buf), 0, ObjInstanceSize(obj));
+
+		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
+					UAVObjGetID(obj_handle),
+					instId,
+					LatestBuffer(obj, buf),
+					UAVObjGetNumBytes(obj_handle));
+
+		latestRelease(obj, buf, false);
+#endif  /* PIOS_INCLUDE_FASTHEAP */
+
 		if (rc != 0)
 			return -1;
 	} else {
@@ -800,6 +941,43 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 		memcpy(MetaDataPtr((struct UAVOMeta *)obj_handle), uavobj_load_trampoline, UAVObjGetNumBytes(obj_handle));
 #endif  /* PIOS_INCLUDE_FASTHEAP */
 
+	} else if (((struct UAVOBase *)obj_handle)->flags.isLatest) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if (instId != 0)
+			return -1;
+
+		// Load into a claimed buffer and publish it once complete
+		int32_t rc;
+#if defined(PIOS_INCLUDE_FASTHEAP)
+		rc = PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id,
+					UAVObjGetID(obj_handle),
+					instId,
+					uavobj_load_trampoline,
+					UAVObjGetNumBytes(obj_handle));
+
+		if (rc != 0)
+			return -1;
+
+		if (latestWrite(obj, uavobj_load_trampoline, 0, ObjInstanceSize(obj)) != 0)
+			return -1;
+#else  /* PIOS_INCLUDE_FASTHEAP */
+		uint8_t buf = latestClaim(obj);
+		if (buf == LATEST_NONE)
+			return -1;
+
+		rc = PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id,
+					UAVObjGetID(obj_handle),
+					instId,
+					LatestBuffer(obj, buf),
+					UAVObjGetNumBytes(obj_handle));
+
+		latestRelease(obj, buf, rc == 0);
+
+		if (rc != 0)
+			return -1;
+#endif  /* PIOS_INCLUDE_FASTHEAP */
+
 	} else {
 
 		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
@@ -863,7 +1041,7 @@ int32_t UAVObjSaveSettings()
 	int32_t rc = -1;
 
 	// Save all settings objects
-	LL_FOREACH(uavo_list, obj) {
+	UAVO_FOREACH(obj) {
 		// Check if this is a settings object
 		if (UAVObjIsSettings(obj)) {
 			// Save object
@@ -895,7 +1073,7 @@ int32_t UAVObjLoadSettings()
 	int32_t rc = -1;
 
 	// Load all settings objects
-	LL_FOREACH(uavo_list, obj) {
+	UAVO_FOREACH(obj) {
 		// Check if this is a settings object
 		if (UAVObjIsSettings(obj)) {
 			// Load object
@@ -927,7 +1105,7 @@ int32_t UAVObjDeleteSettings()
 	int32_t rc = -1;
 
 	// Save all settings objects
-	LL_FOREACH(uavo_list, obj) {
+	UAVO_FOREACH(obj) {
 		// Check if this is a settings object
 		if (UAVObjIsSettings(obj)) {
 			// Save object
@@ -959,7 +1137,7 @@ int32_t UAVObjSaveMetaobjects()
 	int32_t rc = -1;
 
 	// Save all settings objects
-	LL_FOREACH(uavo_list, obj) {
+	UAVO_FOREACH(obj) {
 		// Save object
 		if (UAVObjSave( (UAVObjHandle) MetaObjectPtr(obj), 0) ==
 			-1) {
@@ -988,7 +1166,7 @@ int32_t UAVObjLoadMetaobjects()
 	int32_t rc = -1;
 
 	// Load all settings objects
-	LL_FOREACH(uavo_list, obj) {
+	UAVO_FOREACH(obj) {
 		// Load object
 		if (UAVObjLoad((UAVObjHandle) MetaObjectPtr(obj), 0) ==
 			-1) {
@@ -1017,7 +1195,7 @@ int32_t UAVObjDeleteMetaobjects()
 	int32_t rc = -1;
 
 	// Load all settings objects
-	LL_FOREACH(uavo_list, obj) {
+	UAVO_FOREACH(obj) {
 		// Load object
 		if (UAVObjDeleteById(UAVObjGetID(MetaObjectPtr(obj)), 0)
 			== -1) {
@@ -1088,6 +1266,18 @@ int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 {
 	PIOS_Assert(obj_handle);
 
+	if (((struct UAVOBase *)obj_handle)->flags.isLatest) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if (instId != 0 || UAVObjReadOnly(obj_handle))
+			return -1;
+
+		if (latestWrite(obj, dataIn, 0, ObjInstanceSize(obj)) != 0)
+			return -1;
+		latestNotify(obj, EV_UPDATED);
+		return 0;
+	}
+
 	// Lock
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -1115,7 +1305,7 @@ int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 			goto unlock_exit;
 		}
 		// Set data
-		memcpy(InstanceData(instEntry), dataIn, obj->instance_size);
+		memcpy(InstanceData(instEntry), dataIn, ObjInstanceSize(obj));
 	}
 
 	// Fire event
@@ -1138,6 +1328,19 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
 {
 	PIOS_Assert(obj_handle);
 
+	if (((struct UAVOBase *)obj_handle)->flags.isLatest) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if (instId != 0 || UAVObjReadOnly(obj_handle) ||
+				(size + offset) > ObjInstanceSize(obj))
+			return -1;
+
+		if (latestWrite(obj, dataIn, offset, size) != 0)
+			return -1;
+		latestNotify(obj, EV_UPDATED);
+		return 0;
+	}
+
 	// Lock
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -1175,7 +1378,7 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
 		}
 
 		// Check for overrun
-		if ((size + offset) > obj->instance_size) {
+		if ((size + offset) > ObjInstanceSize(obj)) {
 			goto unlock_exit;
 		}
 
@@ -1205,6 +1408,16 @@ int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 {
 	PIOS_Assert(obj_handle);
 
+	if (((struct UAVOBase *)obj_handle)->flags.isLatest) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if (instId != 0)
+			return -1;
+
+		latestRead(obj, dataOut, 0, ObjInstanceSize(obj));
+		return 0;
+	}
+
 	// Lock
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -1230,7 +1443,7 @@ int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 			goto unlock_exit;
 		}
 		// Set data
-		memcpy(dataOut, InstanceData(instEntry), obj->instance_size);
+		memcpy(dataOut, InstanceData(instEntry), ObjInstanceSize(obj));
 	}
 
 	rc = 0;
@@ -1251,6 +1464,16 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 {
 	PIOS_Assert(obj_handle);
 
+	if (((struct UAVOBase *)obj_handle)->flags.isLatest) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handle;
+
+		if (instId != 0 || (size + offset) > ObjInstanceSize(obj))
+			return -1;
+
+		latestRead(obj, dataOut, offset, size);
+		return 0;
+	}
+
 	// Lock
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -1283,7 +1506,7 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 		}
 
 		// Check for overrun
-		if ((size + offset) > obj->instance_size) {
+		if ((size + offset) > ObjInstanceSize(obj)) {
 			goto unlock_exit;
 		}
 		
@@ -1507,7 +1730,7 @@ int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, xQueueHandle queue,
 	PIOS_Assert(queue);
 	int32_t res;
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-	res = connectObj(obj_handle, queue, 0, eventMask);
+	res = connectObj(obj_handle, queue, 0, 0, 0, eventMask, EV_PRIORITY_NORMAL);
 	xSemaphoreGiveRecursive(mutex);
 	return res;
 }
@@ -1524,14 +1747,15 @@ int32_t UAVObjDisconnectQueue(UAVObjHandle obj_handle, xQueueHandle queue)
 	PIOS_Assert(queue);
 	int32_t res;
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-	res = disconnectObj(obj_handle, queue, 0);
+	res = disconnectObj(obj_handle, queue, 0, 0);
 	xSemaphoreGiveRecursive(mutex);
 	return res;
 }
 
 /**
  * Connect an event callback to the object, if the callback is already connected then the event mask is only updated.
- * The supplied callback will be invoked on all events matching the event mask.
+ * The supplied callback will be invoked on all events matching the event mask. Callbacks of settings and metaobjects
+ * are dispatched with EV_PRIORITY_LOW, all others with EV_PRIORITY_NORMAL.
  * \param[in] obj The object handle
  * \param[in] cb The event callback
  * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
@@ -1541,9 +1765,30 @@ int32_t UAVObjConnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb,
 			uint8_t eventMask)
 {
 	PIOS_Assert(obj_handle);
+	UAVObjEventPriority priority = EV_PRIORITY_NORMAL;
+	if (UAVObjIsSettings(obj_handle) || UAVObjIsMetaobject(obj_handle)) {
+		priority = EV_PRIORITY_LOW;
+	}
+	return UAVObjConnectCallbackPriority(obj_handle, cb, eventMask, priority);
+}
+
+/**
+ * Connect an event callback to the object with an explicit dispatcher priority, if the callback is already connected
+ * then the event mask and priority are only updated.
+ * \param[in] obj The object handle
+ * \param[in] cb The event callback
+ * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \param[in] priority The event dispatcher lane the callback is invoked from
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectCallbackPriority(UAVObjHandle obj_handle, UAVObjEventCallback cb,
+			uint8_t eventMask, UAVObjEventPriority priority)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(priority < EV_PRIORITY_NUM);
 	int32_t res;
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-	res = connectObj(obj_handle, 0, cb, eventMask);
+	res = connectObj(obj_handle, 0, cb, 0, 0, eventMask, priority);
 	xSemaphoreGiveRecursive(mutex);
 	return res;
 }
@@ -1559,11 +1804,112 @@ int32_t UAVObjDisconnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb
 	PIOS_Assert(obj_handle);
 	int32_t res;
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-	res = disconnectObj(obj_handle, 0, cb);
+	res = disconnectObj(obj_handle, 0, cb, 0);
 	xSemaphoreGiveRecursive(mutex);
 	return res;
 }
 
+/**
+ * Create a notifier, see UAVObjConnectNotifier
+ * \return The notifier or NULL if out of memory
+ */
+UAVObjNotifier UAVObjNotifierCreate()
+{
+	UAVObjNotifier notifier = (UAVObjNotifier) PIOS_malloc_no_dma(sizeof(struct UAVObjNotifierStruct));
+	if (notifier == NULL) {
+		return NULL;
+	}
+
+	notifier->pending = 0;
+	vSemaphoreCreateBinary(notifier->sem);
+	if (notifier->sem == NULL) {
+		vPortFree(notifier);
+		return NULL;
+	}
+	// Binary semaphores are created given
+	xSemaphoreTake(notifier->sem, 0);
+
+	return notifier;
+}
+
+/**
+ * Connect a notifier to the object, if the notifier is already connected then the bits and event mask are only updated.
+ * All events matching the event mask set the bits in the notifier and wake the task waiting on it. Unlike a queue no
+ * event is stored, the task reads the current object data after the wakeup.
+ * \param[in] obj The object handle
+ * \param[in] notifier The notifier
+ * \param[in] bits The bits set for this object
+ * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectNotifier(UAVObjHandle obj_handle, UAVObjNotifier notifier,
+			uint32_t bits, uint8_t eventMask)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(notifier);
+	PIOS_Assert(bits);
+	int32_t res;
+	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+	res = connectObj(obj_handle, 0, 0, notifier, bits, eventMask, EV_PRIORITY_NORMAL);
+	xSemaphoreGiveRecursive(mutex);
+	return res;
+}
+
+/**
+ * Disconnect a notifier from the object.
+ * \param[in] obj The object handle
+ * \param[in] notifier The notifier
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjDisconnectNotifier(UAVObjHandle obj_handle, UAVObjNotifier notifier)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(notifier);
+	int32_t res;
+	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+	res = disconnectObj(obj_handle, 0, 0, notifier);
+	xSemaphoreGiveRecursive(mutex);
+	return res;
+}
+
+/**
+ * Wait until any of the requested bits is pending. The returned bits are
+ * cleared, other pending bits are left for a later call.
+ * \param[in] notifier The notifier
+ * \param[in] bitsToWaitFor The bits of interest
+ * \param[in] timeout Maximum time to wait in ticks, portMAX_DELAY waits forever
+ * \return The pending bits out of bitsToWaitFor, 0 on timeout
+ */
+uint32_t UAVObjNotifierWait(UAVObjNotifier notifier, uint32_t bitsToWaitFor,
+			portTickType timeout)
+{
+	PIOS_Assert(notifier);
+	portTickType start = xTaskGetTickCount();
+	uint32_t bits;
+
+	while (true) {
+		bits = __sync_fetch_and_and(&notifier->pending, ~bitsToWaitFor) & bitsToWaitFor;
+
+		if (bits) {
+			return bits;
+		}
+
+		// The semaphore can also have been given for bits that are not
+		// of interest now, wait again for the remaining time
+		portTickType wait = portMAX_DELAY;
+		if (timeout != portMAX_DELAY) {
+			portTickType elapsed = xTaskGetTickCount() - start;
+			if (elapsed >= timeout) {
+				return 0;
+			}
+			wait = timeout - elapsed;
+		}
+		if (xSemaphoreTake(notifier->sem, wait) != pdTRUE) {
+			timeout = 0;
+		}
+	}
+}
+
 /**
  * Request an update of the object's data from the GCS. The call will not wait for the response, a EV_UPDATED event
  * will be generated as soon as the object is updated.
@@ -1622,9 +1968,9 @@ void UAVObjIterate(void (*iterator) (UAVObjHandle obj))
 	// Get lock
 	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
-	// Iterate through the list and invoke iterator for each object
+	// Iterate through the registry and invoke iterator for each object
 	struct UAVOData *obj;
-	LL_FOREACH(uavo_list, obj) {
+	UAVO_FOREACH(obj) {
 		(*iterator) ((UAVObjHandle) obj);
 		(*iterator) ((UAVObjHandle) &obj->metaObj);
 	}
@@ -1660,10 +2006,17 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 				}
 			}
 
+			// Wake the task waiting on the notifier, will not block and
+			// can not overflow
+			if (event->notifier) {
+				__sync_fetch_and_or(&event->notifier->pending, event->notifyBits);
+				xSemaphoreGive(event->notifier->sem);
+			}
+
 			// Invoke callback (from event task) if a valid one is registered
 			if (event->cb) {
 				// invoke callback from the event task, will not block
-				if (EventCallbackDispatch(&msg, event->cb) != pdTRUE) {
+				if (EventCallbackDispatch(&msg, event->cb, event->priority) != pdTRUE) {
 					++stats.eventCallbackErrors;
 					stats.lastCallbackErrorID = UAVObjGetID(obj);
 				}
@@ -1674,6 +2027,118 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 	return 0;
 }
 
+/**
+ * Get the control block of a latest value object, it follows the buffers
+ */
+static inline struct UAVOLatestCtl * latestCtl(struct UAVOData * obj)
+{
+	uintptr_t end = (uintptr_t) LatestBuffer(obj, 3);
+	return (struct UAVOLatestCtl *) ((end + 3) & ~(uintptr_t) 3);
+}
+
+/**
+ * Copy from the published buffer of a latest value object. Never waits
+ * for the writer, it retries only if the writer overtook it.
+ */
+static void latestRead(struct UAVOData * obj, void * dataOut,
+			uint32_t offset, uint32_t size)
+{
+	struct UAVOLatestCtl * ctl = latestCtl(obj);
+	uint8_t buf;
+	uint32_t seq;
+
+	do {
+		buf = LATEST_PUBLISHED(ctl->state);
+		seq = ctl->seq[buf];
+		__sync_synchronize();
+		memcpy(dataOut, LatestBuffer(obj, buf) + offset, size);
+		__sync_synchronize();
+	} while ((seq & 1) || ctl->seq[buf] != seq);
+}
+
+/**
+ * Claim a buffer of a latest value object for writing, one that is
+ * neither published nor claimed. Returns LATEST_NONE if there is none.
+ */
+static uint8_t latestClaim(struct UAVOData * obj)
+{
+	struct UAVOLatestCtl * ctl = latestCtl(obj);
+	uint32_t state;
+	uint8_t buf;
+
+	do {
+		state = ctl->state;
+		buf = (LATEST_PUBLISHED(state) + 1) % 3;
+		if (state & LATEST_CLAIMED(buf)) {
+			buf = (buf + 1) % 3;
+			if (state & LATEST_CLAIMED(buf))
+				return LATEST_NONE;
+		}
+	} while (!__sync_bool_compare_and_swap(&ctl->state, state,
+			state | LATEST_CLAIMED(buf)));
+
+	ctl->seq[buf]++;
+	__sync_synchronize();
+
+	return buf;
+}
+
+/**
+ * Give back a claimed buffer of a latest value object, publishing it if
+ * it holds a complete new value
+ */
+static void latestRelease(struct UAVOData * obj, uint8_t buf, bool publish)
+{
+	struct UAVOLatestCtl * ctl = latestCtl(obj);
+	uint32_t state;
+	uint32_t released;
+
+	__sync_synchronize();
+	ctl->seq[buf]++;
+
+	do {
+		state = ctl->state;
+		released = state & ~LATEST_CLAIMED(buf);
+		if (publish)
+			released = (released & ~0xff) | buf;
+	} while (!__sync_bool_compare_and_swap(&ctl->state, state, released));
+}
+
+/**
+ * Write to a free buffer of a latest value object and publish it.
+ * Returns -1 if all the buffers are taken by other writers.
+ */
+static int32_t latestWrite(struct UAVOData * obj, const void * dataIn,
+			uint32_t offset, uint32_t size)
+{
+	uint8_t buf = latestClaim(obj);
+
+	if (buf == LATEST_NONE)
+		return -1;
+
+	// A partial write starts from the current value
+	if (size < ObjInstanceSize(obj))
+		latestRead(obj, LatestBuffer(obj, buf), 0, ObjInstanceSize(obj));
+	memcpy(LatestBuffer(obj, buf) + offset, dataIn, size);
+
+	latestRelease(obj, buf, true);
+	return 0;
+}
+
+/**
+ * Send an event for a latest value object, only taking the lock when
+ * a queue or callback is connected to it
+ */
+static void latestNotify(struct UAVOData * obj, UAVObjEventType event)
+{
+	if (obj->base.next_event == NULL)
+		return;
+
+	xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+	sendEvent(&obj->base, 0, event);
+	xSemaphoreGiveRecursive(mutex);
+}
+
 /**
  * Create a new object instance, return the instance info or NULL if failure.
  */
@@ -1705,10 +2170,10 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 	}
 
 	/* Create the actual instance */
-	instEntry = (struct UAVOMultiInst *) PIOS_malloc_no_dma(sizeof(struct UAVOMultiInst)+obj->instance_size);
+	instEntry = (struct UAVOMultiInst *) PIOS_malloc_no_dma(sizeof(struct UAVOMultiInst)+ObjInstanceSize(obj));
 	if (!instEntry)
 		return NULL;
-	memset(InstanceDataOffset(instEntry), 0, obj->instance_size);
+	memset(InstanceDataOffset(instEntry), 0, ObjInstanceSize(obj));
 	LL_APPEND(( (struct UAVOMulti*)obj )->instance0.next, instEntry);
 
 	( (struct UAVOMulti*)obj )->num_instances++;
@@ -1741,6 +2206,11 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
 		if (instId != 0)
 			return NULL;
 
+		/* Latest value objects are only accessed through latestRead
+		 * and latestWrite, their buffers change under the caller */
+		if (obj->base.flags.isLatest)
+			return NULL;
+
 		/* Augment our pointer to reflect the proper type */
 		struct UAVOSingle * uavo_single = (struct UAVOSingle *) obj;
 		return (&(uavo_single->instance0));
@@ -1770,11 +2240,16 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
  * \param[in] obj The object handle
  * \param[in] queue The event queue
  * \param[in] cb The event callback
+ * \param[in] notifier The notifier
+ * \param[in] notifyBits The bits set in the notifier
  * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \param[in] priority The event dispatcher lane of the callback
  * \return 0 if success or -1 if failure
  */
 static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue,
-			UAVObjEventCallback cb, uint8_t eventMask)
+			UAVObjEventCallback cb, UAVObjNotifier notifier,
+			uint32_t notifyBits, uint8_t eventMask,
+			UAVObjEventPriority priority)
 {
 	struct ObjectEventEntry *event;
 	struct UAVOBase *obj;
@@ -1782,9 +2257,12 @@ static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue,
 	// Check that the queue is not already connected, if it is simply update event mask
 	obj = (struct UAVOBase *) obj_handle;
 	LL_FOREACH(obj->next_event, event) {
-		if (event->queue == queue && event->cb == cb) {
+		if (event->queue == queue && event->cb == cb
+				&& event->notifier == notifier) {
 			// Already connected, update event mask and return
+			event->notifyBits = notifyBits;
 			event->eventMask = eventMask;
+			event->priority = priority;
 			return 0;
 		}
 	}
@@ -1796,7 +2274,10 @@ static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue,
 	}
 	event->queue = queue;
 	event->cb = cb;
+	event->notifier = notifier;
+	event->notifyBits = notifyBits;
 	event->eventMask = eventMask;
+	event->priority = priority;
 	LL_APPEND(obj->next_event, event);
 
 	// Done
@@ -1808,10 +2289,11 @@ static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue,
  * \param[in] obj The object handle
  * \param[in] queue The event queue
  * \param[in] cb The event callback
+ * \param[in] notifier The notifier
  * \return 0 if success or -1 if failure
  */
 static int32_t disconnectObj(UAVObjHandle obj_handle, xQueueHandle queue,
-			UAVObjEventCallback cb)
+			UAVObjEventCallback cb, UAVObjNotifier notifier)
 {
 	struct ObjectEventEntry *event;
 	struct UAVOBase *obj;
@@ -1820,7 +2302,8 @@ static int32_t disconnectObj(UAVObjHandle obj_handle, xQueueHandle queue,
 	obj = (struct UAVOBase *) obj_handle;
 	LL_FOREACH(obj->next_event, event) {
 		if ((event->queue == queue
-				&& event->cb == cb)) {
+				&& event->cb == cb
+				&& event->notifier == notifier)) {
 			LL_DELETE(obj->next_event, event);
 			vPortFree(event);
 			return 0;
@@ -1848,7 +2331,8 @@ int32_t getEventMask(UAVObjHandle obj_handle, xQueueHandle queue)
 	// Iterate over the event listeners, looking for the event matching the queue
 	obj = (struct UAVOBase *) obj_handle;
 	LL_FOREACH(obj->next_event, event) {
-		if (event->queue == queue && event->cb == 0) {
+		if (event->queue == queue && event->cb == 0
+				&& event->notifier == 0) {
 			// Already connected, update event mask and return
 			eventMask = event->eventMask;
 			break;
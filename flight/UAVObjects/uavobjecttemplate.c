@@ -40,6 +40,32 @@
 // Private variables
 static UAVObjHandle handle = NULL;
 
+/**
+ * Constant description of the object, kept in flash and
+ * referenced from the object registry.
+ */
+const UAVObjDescriptor $(NAME)Descriptor = {
+	.id = $(NAMEUC)_OBJID,
+	.num_bytes = $(NAMEUC)_NUMBYTES,
+	.is_single_instance = $(NAMEUC)_ISSINGLEINST,
+	.is_settings = $(NAMEUC)_ISSETTINGS,
+	.is_latest_value = $(NAMEUC)_ISLATESTVALUE,
+	.metadata = {
+		.flags =
+			$(FLIGHTACCESS) << UAVOBJ_ACCESS_SHIFT |
+			$(GCSACCESS) << UAVOBJ_GCS_ACCESS_SHIFT |
+			$(FLIGHTTELEM_ACKED) << UAVOBJ_TELEMETRY_ACKED_SHIFT |
+			$(GCSTELEM_ACKED) << UAVOBJ_GCS_TELEMETRY_ACKED_SHIFT |
+			$(FLIGHTTELEM_UPDATEMODE) << UAVOBJ_TELEMETRY_UPDATE_MODE_SHIFT |
+			$(GCSTELEM_UPDATEMODE) << UAVOBJ_GCS_TELEMETRY_UPDATE_MODE_SHIFT,
+		.telemetryUpdatePeriod = $(FLIGHTTELEM_UPDATEPERIOD),
+		.gcsTelemetryUpdatePeriod = $(GCSTELEM_UPDATEPERIOD),
+		.loggingUpdatePeriod = $(LOGGING_UPDATEPERIOD),
+	},
+	.init_cb = &$(NAME)SetDefaults,
+	.handle = &handle,
+};
+
 /**
  * Initialize object.
  * \return 0 Success
@@ -48,12 +74,11 @@ static UAVObjHandle handle = NULL;
 int32_t $(NAME)Initialize(void)
 {
 	// Don't set the handle to null if already registered
-	if(UAVObjGetByID($(NAMEUC)_OBJID) != NULL)
+	if (handle != NULL)
 		return -2;
 	
 	// Register object with the object manager
-	handle = UAVObjRegister($(NAMEUC)_OBJID,
-			$(NAMEUC)_ISSINGLEINST, $(NAMEUC)_ISSETTINGS, $(NAMEUC)_NUMBYTES, &$(NAME)SetDefaults);
+	handle = UAVObjRegister(&$(NAME)Descriptor);
 
 	// Done
 	if (handle != 0)
@@ -74,7 +99,6 @@ int32_t $(NAME)Initialize(void)
 void $(NAME)SetDefaults(UAVObjHandle obj, uint16_t instId)
 {
 	$(NAME)Data data;
-	UAVObjMetadata metadata;
 
 	// Initialize object fields to their default values
 	UAVObjGetInstanceData(obj, instId, &data);
@@ -83,17 +107,7 @@ $(INITFIELDS)
 	UAVObjSetInstanceData(obj, instId, &data);
 
 	// Initialize object metadata to their default values
-	metadata.flags =
-		$(FLIGHTACCESS) << UAVOBJ_ACCESS_SHIFT |
-		$(GCSACCESS) << UAVOBJ_GCS_ACCESS_SHIFT |
-		$(FLIGHTTELEM_ACKED) << UAVOBJ_TELEMETRY_ACKED_SHIFT |
-		$(GCSTELEM_ACKED) << UAVOBJ_GCS_TELEMETRY_ACKED_SHIFT |
-		$(FLIGHTTELEM_UPDATEMODE) << UAVOBJ_TELEMETRY_UPDATE_MODE_SHIFT |
-		$(GCSTELEM_UPDATEMODE) << UAVOBJ_GCS_TELEMETRY_UPDATE_MODE_SHIFT;
-	metadata.telemetryUpdatePeriod = $(FLIGHTTELEM_UPDATEPERIOD);
-	metadata.gcsTelemetryUpdatePeriod = $(GCSTELEM_UPDATEPERIOD);
-	metadata.loggingUpdatePeriod = $(LOGGING_UPDATEPERIOD);
-	UAVObjSetMetadata(obj, &metadata);
+	UAVObjSetMetadata(obj, &$(NAME)Descriptor.metadata);
 }
 
 /**
@@ -33,6 +33,8 @@
 
 // Public types
 typedef int32_t (*UAVTalkOutputStream)(uint8_t* data, int32_t length);
+typedef uint8_t* (*UAVTalkOutputReserve)(uint16_t length);
+typedef int32_t (*UAVTalkOutputCommit)(uint8_t* data, uint16_t length);
 
 //! Tracking statistics for a UAVTalk connection
 typedef struct {
@@ -54,6 +56,7 @@ typedef enum {UAVTALK_STATE_ERROR=0, UAVTALK_STATE_SYNC, UAVTALK_STATE_TYPE, UAV
 UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream);
 int32_t UAVTalkSetOutputStream(UAVTalkConnection connection, UAVTalkOutputStream outputStream);
 UAVTalkOutputStream UAVTalkGetOutputStream(UAVTalkConnection connection);
+int32_t UAVTalkSetOutputBuffer(UAVTalkConnection connection, UAVTalkOutputReserve reserve, UAVTalkOutputCommit commit);
 int32_t UAVTalkSendObject(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
 int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
 int32_t UAVTalkSendObjectRequest(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs);
@@ -82,6 +82,8 @@ typedef struct {
 typedef struct {
     uint8_t canari;
     UAVTalkOutputStream outStream;
+    UAVTalkOutputReserve outReserve;
+    UAVTalkOutputCommit outCommit;
     xSemaphoreHandle lock;
     xSemaphoreHandle transLock;
     xSemaphoreHandle respSema;
@@ -60,6 +60,8 @@ UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream)
 	connection->iproc.rxPacketLength = 0;
 	connection->iproc.state = UAVTALK_STATE_SYNC;
 	connection->outStream = outputStream;
+	connection->outReserve = NULL;
+	connection->outCommit = NULL;
 	connection->lock = xSemaphoreCreateRecursiveMutex();
 	connection->transLock = xSemaphoreCreateRecursiveMutex();
 	// allocate buffers
@@ -99,6 +101,33 @@ int32_t UAVTalkSetOutputStream(UAVTalkConnection connectionHandle, UAVTalkOutput
 
 }
 
+/**
+ * Let objects be serialized straight into the output, e.g. the transmit
+ * buffer of a COM port, instead of being copied there from the transmit
+ * buffer. The output stream is still used when reserve returns NULL.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] reserve Returns room for a packet of the given length, or NULL
+ * \param[in] commit Sends a packet built in the reserved room
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSetOutputBuffer(UAVTalkConnection connectionHandle, UAVTalkOutputReserve reserve, UAVTalkOutputCommit commit)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	// Lock
+	xSemaphoreTakeRecursive(connection->lock, portMAX_DELAY);
+
+	connection->outReserve = reserve;
+	connection->outCommit = commit;
+
+	// Release lock
+	xSemaphoreGiveRecursive(connection->lock);
+
+	return 0;
+}
+
 /**
  * Get current output stream
  * \param[in] connection UAVTalkConnection to be used
@@ -386,6 +415,7 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 			{
 				iproc->length = 0;
 				iproc->instanceLength = 0;
+				iproc->timestampLength = 0;
 			}
 			else
 			{
@@ -885,37 +915,22 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 	int32_t length;
 	int32_t dataOffset;
 	uint32_t objId;
+	uint8_t *txBuffer;
 
 	if (!connection->outStream) return -1;
 
-	// Setup type and object id fields
-	objId = UAVObjGetID(obj);
-	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
-	connection->txBuffer[1] = type;
-	// data length inserted here below
-	connection->txBuffer[4] = (uint8_t)(objId & 0xFF);
-	connection->txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
-	connection->txBuffer[6] = (uint8_t)((objId >> 16) & 0xFF);
-	connection->txBuffer[7] = (uint8_t)((objId >> 24) & 0xFF);
-	
-	// Setup instance ID if one is required
+	// Determine the header length
 	if (UAVObjIsSingleInstance(obj))
 	{
 		dataOffset = 8;
 	}
 	else
 	{
-		connection->txBuffer[8] = (uint8_t)(instId & 0xFF);
-		connection->txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
 		dataOffset = 10;
 	}
 
-	// Add timestamp when the transaction type is appropriate
 	if (type & UAVTALK_TIMESTAMPED)
 	{
-		portTickType time = xTaskGetTickCount();
-		connection->txBuffer[dataOffset] = (uint8_t)(time & 0xFF);
-		connection->txBuffer[dataOffset + 1] = (uint8_t)((time >> 8) & 0xFF);
 		dataOffset += 2;
 	}
 	
@@ -934,25 +949,75 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 	{
 		return -1;
 	}
+
+	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
+
+	// Build the packet straight in the output when it has room for it,
+	// otherwise in the transmit buffer
+	txBuffer = NULL;
+	if (connection->outReserve && connection->outCommit)
+	{
+		txBuffer = (*connection->outReserve)(tx_msg_len);
+	}
+	bool reserved = (txBuffer != NULL);
+	if (!reserved)
+	{
+		txBuffer = connection->txBuffer;
+	}
+
+	// Setup type and object id fields
+	objId = UAVObjGetID(obj);
+	txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
+	txBuffer[1] = type;
+	// data length inserted here below
+	txBuffer[4] = (uint8_t)(objId & 0xFF);
+	txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
+	txBuffer[6] = (uint8_t)((objId >> 16) & 0xFF);
+	txBuffer[7] = (uint8_t)((objId >> 24) & 0xFF);
+	
+	// Setup instance ID if one is required
+	int32_t offset = 8;
+	if (!UAVObjIsSingleInstance(obj))
+	{
+		txBuffer[8] = (uint8_t)(instId & 0xFF);
+		txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
+		offset = 10;
+	}
+
+	// Add timestamp when the transaction type is appropriate
+	if (type & UAVTALK_TIMESTAMPED)
+	{
+		portTickType time = xTaskGetTickCount();
+		txBuffer[offset] = (uint8_t)(time & 0xFF);
+		txBuffer[offset + 1] = (uint8_t)((time >> 8) & 0xFF);
+	}
 	
 	// Copy data (if any)
 	if (length > 0)
 	{
-		if ( UAVObjPack(obj, instId, &connection->txBuffer[dataOffset]) < 0 )
+		// Reserved space that is never committed is simply reused
+		if ( UAVObjPack(obj, instId, &txBuffer[dataOffset]) < 0 )
 		{
 			return -1;
 		}
 	}
 	
 	// Store the packet length
-	connection->txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
-	connection->txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
+	txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
+	txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
 	
 	// Calculate checksum
-	connection->txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, connection->txBuffer, dataOffset+length);
+	txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, txBuffer, dataOffset+length);
 
-	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
-	int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+	int32_t rc;
+	if (reserved)
+	{
+		rc = (*connection->outCommit)(txBuffer, tx_msg_len);
+	}
+	else
+	{
+		rc = (*connection->outStream)(txBuffer, tx_msg_len);
+	}
 
 	if (rc == tx_msg_len) {
 		// Update stats
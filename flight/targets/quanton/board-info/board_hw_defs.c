@@ -494,6 +494,39 @@ void PIOS_I2C_internal_ev_irq_handler(void);
 void PIOS_I2C_internal_er_irq_handler(void);
 void I2C3_EV_IRQHandler() __attribute__ ((alias ("PIOS_I2C_internal_ev_irq_handler")));
 void I2C3_ER_IRQHandler() __attribute__ ((alias ("PIOS_I2C_internal_er_irq_handler")));
+void PIOS_I2C_internal_dma_irq_handler(void);
+void DMA1_Stream2_IRQHandler(void) __attribute__ ((alias ("PIOS_I2C_internal_dma_irq_handler")));
+
+/* Sensor reads by DMA, I2C3_RX is on DMA1 stream 2 channel 3 */
+static const struct stm32_dma pios_i2c_internal_dma = {
+	.irq = {
+		.flags = (DMA_FLAG_TCIF2 | DMA_FLAG_TEIF2 | DMA_FLAG_HTIF2 | DMA_FLAG_DMEIF2 | DMA_FLAG_FEIF2),
+		.init = {
+			.NVIC_IRQChannel = DMA1_Stream2_IRQn,
+			.NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_HIGHEST,
+			.NVIC_IRQChannelSubPriority = 0,
+			.NVIC_IRQChannelCmd = ENABLE,
+		},
+	},
+	.rx = {
+		.channel = DMA1_Stream2,
+		.init = {
+			.DMA_Channel            = DMA_Channel_3,
+			.DMA_PeripheralBaseAddr = (uint32_t) & (I2C3->DR),
+			.DMA_DIR                = DMA_DIR_PeripheralToMemory,
+			.DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+			.DMA_MemoryInc          = DMA_MemoryInc_Enable,
+			.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+			.DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+			.DMA_Mode               = DMA_Mode_Normal,
+			.DMA_Priority           = DMA_Priority_Medium,
+			.DMA_FIFOMode           = DMA_FIFOMode_Disable,
+			.DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+			.DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+			.DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+		},
+	},
+};
 
 static const struct pios_i2c_adapter_cfg pios_i2c_internal_adapter_cfg = {
   .regs = I2C3,
@@ -547,6 +580,7 @@ static const struct pios_i2c_adapter_cfg pios_i2c_internal_adapter_cfg = {
 			.NVIC_IRQChannelCmd = ENABLE,
     },
   },
+  .dma = &pios_i2c_internal_dma,
 };
 
 uint32_t pios_i2c_internal_adapter_id;
@@ -562,6 +596,12 @@ void PIOS_I2C_internal_er_irq_handler(void)
   PIOS_I2C_ER_IRQ_Handler(pios_i2c_internal_adapter_id);
 }
 
+void PIOS_I2C_internal_dma_irq_handler(void)
+{
+  /* Call into the generic code to handle the IRQ for this specific device */
+  PIOS_I2C_DMA_IRQ_Handler(pios_i2c_internal_adapter_id);
+}
+
 
 
 #endif /* PIOS_INCLUDE_I2C */
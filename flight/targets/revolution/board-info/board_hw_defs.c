@@ -726,6 +726,32 @@ void PIOS_OVERO_irq_handler(void)
 /*
  * Telemetry on main USART
  */
+static const struct stm32_dma pios_usart_telem_dma = {
+	.irq = {
+		/* Not an interrupt, the flags cleared before each transfer */
+		.flags = (DMA_FLAG_TCIF6 | DMA_FLAG_HTIF6 | DMA_FLAG_TEIF6 |
+			  DMA_FLAG_DMEIF6 | DMA_FLAG_FEIF6),
+	},
+	.tx = {
+		.channel = DMA1_Stream6,
+		.init = {
+			.DMA_Channel            = DMA_Channel_4,
+			.DMA_PeripheralBaseAddr = (uint32_t) & (USART2->DR),
+			.DMA_DIR                = DMA_DIR_MemoryToPeripheral,
+			.DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+			.DMA_MemoryInc          = DMA_MemoryInc_Enable,
+			.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+			.DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+			.DMA_Mode               = DMA_Mode_Normal,
+			.DMA_Priority           = DMA_Priority_Low,
+			.DMA_FIFOMode           = DMA_FIFOMode_Disable,
+			.DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+			.DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+			.DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+		},
+	},
+};
+
 static const struct pios_usart_cfg pios_usart_telem_cfg = {
 	.regs = USART2,
 	.remap = GPIO_AF_USART2,
@@ -766,6 +792,7 @@ static const struct pios_usart_cfg pios_usart_telem_cfg = {
 			.GPIO_PuPd  = GPIO_PuPd_UP
 		},
 	},
+	.dma = &pios_usart_telem_dma,
 };
 
 #endif /* PIOS_COM_TELEM */
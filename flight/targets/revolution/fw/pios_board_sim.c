@@ -46,6 +46,7 @@
 
 #include "pios_rcvr_priv.h"
 #include "pios_gcsrcvr_priv.h"
+#include "pios_scriptrcvr_priv.h"
 
 void Stack_Change() {
 }
@@ -215,6 +216,21 @@ void PIOS_Board_Init(void) {
 	pios_rcvr_group_map[MANUALCONTROLSETTINGS_CHANNELGROUPS_GCS] = pios_gcsrcvr_rcvr_id;
 #endif	/* PIOS_INCLUDE_GCSRCVR */
 
+#if defined(PIOS_INCLUDE_SCRIPTRCVR)
+	/* A scripted receiver stands in for the PPM input when RCVR_SCRIPT names a script */
+	const char *rcvr_script = getenv("RCVR_SCRIPT");
+	if (rcvr_script) {
+		uintptr_t pios_scriptrcvr_id;
+		if (PIOS_SCRIPTRCVR_Init(&pios_scriptrcvr_id, rcvr_script) == 0) {
+			uintptr_t pios_scriptrcvr_rcvr_id;
+			if (PIOS_RCVR_Init(&pios_scriptrcvr_rcvr_id, &pios_scriptrcvr_rcvr_driver, pios_scriptrcvr_id)) {
+				PIOS_Assert(0);
+			}
+			pios_rcvr_group_map[MANUALCONTROLSETTINGS_CHANNELGROUPS_PPM] = pios_scriptrcvr_rcvr_id;
+		}
+	}
+#endif	/* PIOS_INCLUDE_SCRIPTRCVR */
+
 	// Register fake address.  Later if we really fake entire sensors then
 	// it will make sense to have real queues registered.  For now if these
 	// queues are used a crash is appropriate.
@@ -47,6 +47,7 @@
 #define PIOS_INCLUDE_SERVO
 #define PIOS_INCLUDE_RCVR
 #define PIOS_INCLUDE_GCSRCVR
+#define PIOS_INCLUDE_SCRIPTRCVR
 #define PIOS_INCLUDE_IAP
 #define PIOS_INCLUDE_BL_HELPER
 #define PIOS_INCLUDE_FLASH
@@ -81,6 +82,12 @@
 #define CPULOAD_LIMIT_WARNING		80
 #define CPULOAD_LIMIT_CRITICAL		95
 
+/*
+ * The posix idle task sleeps until it is scheduled again, so the idle hook
+ * runs about once per tick in which nothing else ran, not in a busy loop
+ */
+#define IDLE_COUNTS_PER_SEC_AT_NO_LOAD	1000
+
 #define REVOLUTION
 
 // Enable POI tracking mode for camera stabilization
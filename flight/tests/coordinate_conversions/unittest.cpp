@@ -85,3 +85,75 @@ TEST_F(RneFromLLATest, Equator) {
   ASSERT_NEAR(0, Rne[2][1], eps);
   ASSERT_NEAR(0, Rne[2][2], eps);
 };
+
+// Test fixture for affine_from_calibration() and affine_apply()
+class AffineTest : public CoordConversion {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(AffineTest, Identity) {
+  const float one[3] = { 1, 1, 1 };
+  const float zero[3] = { 0, 0, 0 };
+  float A[3][4];
+
+  affine_from_calibration(A, NULL, true, one, zero, zero);
+
+  float in[6] = { 1, -2, 3, 1000, 0.001f, -7 };
+  float out[6];
+  affine_apply(A, in, out, 2);
+
+  for (int i = 0; i < 6; i++)
+    ASSERT_EQ(in[i], out[i]);
+};
+
+TEST_F(AffineTest, MatchesRotatedCalibration) {
+  // Calibration as the sensors module applies it: scale, remove bias,
+  // rotate into the body frame and add an offset
+  const float rpy[3] = { 10.5f, -35, 170 };
+  const float scale[3] = { 0.0012f, -0.0011f, 0.00125f };
+  const float bias[3] = { 0.3f, -0.15f, 0.02f };
+  const float offset[3] = { 0, 0, -0.25f };
+  float q[4];
+  float Rsb[3][3];
+
+  RPY2Quaternion(rpy, q);
+  Quaternion2R(q, Rsb);
+
+  float A[3][4];
+  affine_from_calibration(A, Rsb, true, scale, bias, offset);
+
+  // Deterministic stand-in for a recorded block of raw samples
+  const uint32_t N = 1000;
+  float raw[N * 3];
+  uint32_t seed = 12345;
+  for (uint32_t i = 0; i < N * 3; i++) {
+    seed = seed * 1103515245 + 12345;
+    raw[i] = (float)((int32_t)(seed >> 8) % 32768);
+  }
+
+  float out[N * 3];
+  affine_apply(A, raw, out, N);
+
+  for (uint32_t i = 0; i < N; i++) {
+    const float calibrated[3] = {
+      raw[i * 3 + 0] * scale[0] - bias[0],
+      raw[i * 3 + 1] * scale[1] - bias[1],
+      raw[i * 3 + 2] * scale[2] - bias[2]
+    };
+    float expected[3];
+    rot_mult(Rsb, calibrated, expected, true);
+
+    for (int j = 0; j < 3; j++)
+      ASSERT_NEAR(expected[j] + offset[j], out[i * 3 + j], 4e-4f); // ~1e-5 of full scale
+  }
+
+  // In place gives the same result
+  affine_apply(A, raw, raw, N);
+  for (uint32_t i = 0; i < N * 3; i++)
+    ASSERT_EQ(out[i], raw[i]);
+};
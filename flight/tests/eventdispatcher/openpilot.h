@@ -0,0 +1,19 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include "pios.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "utlist.h"
+#include "uavobjectmanager.h"
+#include "eventdispatcher.h"
+
+/* From taskinfo.h and taskmonitor.h */
+#define TASKINFO_RUNNING_EVENTDISPATCHER 0
+extern int32_t TaskMonitorAdd(uint32_t task, xTaskHandle handle);
+
+#endif /* OPENPILOT_H */
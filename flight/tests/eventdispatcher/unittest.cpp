@@ -0,0 +1,203 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+#include <vector>
+
+extern "C" {
+
+#include "openpilot.h"
+
+}
+
+/* LOW_QUEUE_SIZE of eventdispatcher.c at the default MAX_QUEUE_SIZE */
+#define LOW_LANE_SIZE 10
+/* MAX_PASSED_OVER of eventdispatcher.c */
+#define MAX_PASSED_OVER 8
+#define BUSY_CALLBACKS 30
+/* Long enough for the event task to drain every lane */
+#define DRAIN_TICKS 10
+
+/* Fakes for the services the dispatcher takes from the rest of the firmware */
+static uint64_t now_ns(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+extern "C" uint32_t PIOS_DELAY_GetRaw(void)
+{
+  return (uint32_t)(now_ns() / 1000);
+}
+
+extern "C" uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
+{
+  return PIOS_DELAY_GetRaw() - raw;
+}
+
+extern "C" int32_t TaskMonitorAdd(uint32_t /* task */, xTaskHandle /* handle */)
+{
+  return 0;
+}
+
+extern "C" uint32_t UAVObjGetID(UAVObjHandle obj)
+{
+  return (uint32_t)(uintptr_t)obj;
+}
+
+extern "C" void vApplicationTickHook(void)
+{
+}
+
+/* Stand-ins for objects, only their addresses are used */
+static uint8_t objects[2];
+
+static std::vector<uint16_t> invoked;
+static uint32_t busy_count;
+static uint32_t busy_count_at_low;
+static volatile bool done;
+
+static void record_cb(UAVObjEvent *ev)
+{
+  invoked.push_back(ev->instId);
+}
+
+static void low_cb(UAVObjEvent * /* ev */)
+{
+  busy_count_at_low = busy_count;
+}
+
+/* Keeps the high lane busy by dispatching itself again */
+static void busy_cb(UAVObjEvent *ev)
+{
+  if (++busy_count < BUSY_CALLBACKS)
+    EventCallbackDispatch(ev, busy_cb, EV_PRIORITY_HIGH);
+}
+
+static int32_t dispatch(UAVObjEventCallback cb, uint8_t obj, uint16_t instId, UAVObjEventPriority priority)
+{
+  UAVObjEvent ev;
+  ev.obj = &objects[obj];
+  ev.instId = instId;
+  ev.event = EV_UPDATED;
+  return EventCallbackDispatch(&ev, cb, priority);
+}
+
+/* Runs above the event task, so everything it dispatches stays pending
+ * until it blocks */
+static void control_task(void *parameters __attribute__((unused)))
+{
+  EventStats stats;
+
+  /* Higher lanes first, each lane in order */
+  EventClearStats();
+  invoked.clear();
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, 1, EV_PRIORITY_LOW));
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, 2, EV_PRIORITY_NORMAL));
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, 3, EV_PRIORITY_HIGH));
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, 4, EV_PRIORITY_NORMAL));
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, 5, EV_PRIORITY_LOW));
+  vTaskDelay(DRAIN_TICKS);
+
+  const uint16_t order[] = { 3, 2, 4, 1, 5 };
+  EXPECT_EQ(std::vector<uint16_t>(order, order + 5), invoked);
+  EventGetStats(&stats);
+  EXPECT_EQ(1, (int)stats.callbackCount[EV_PRIORITY_HIGH]);
+  EXPECT_EQ(2, (int)stats.callbackCount[EV_PRIORITY_NORMAL]);
+  EXPECT_EQ(2, (int)stats.callbackCount[EV_PRIORITY_LOW]);
+
+  /* A dispatch identical to a pending one is merged into it, a different
+   * instance, object or lane is not */
+  EventClearStats();
+  invoked.clear();
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, 1, EV_PRIORITY_NORMAL));
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, 1, EV_PRIORITY_NORMAL));
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, 1, EV_PRIORITY_NORMAL));
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, 2, EV_PRIORITY_NORMAL));
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 1, 1, EV_PRIORITY_NORMAL));
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, 1, EV_PRIORITY_LOW));
+  vTaskDelay(DRAIN_TICKS);
+
+  EXPECT_EQ(4, (int)invoked.size());
+  EventGetStats(&stats);
+  EXPECT_EQ(2, (int)stats.coalescedEvents);
+  EXPECT_EQ(3, (int)stats.callbackCount[EV_PRIORITY_NORMAL]);
+  EXPECT_EQ(1, (int)stats.callbackCount[EV_PRIORITY_LOW]);
+
+  /* A full lane refuses new callbacks but still merges duplicates */
+  EventClearStats();
+  invoked.clear();
+  for (uint16_t i = 0; i < LOW_LANE_SIZE; i++)
+    EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, i, EV_PRIORITY_LOW));
+  EXPECT_EQ(pdFALSE, dispatch(record_cb, 0, LOW_LANE_SIZE, EV_PRIORITY_LOW));
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, 0, EV_PRIORITY_LOW));
+  EXPECT_EQ(pdTRUE, dispatch(record_cb, 0, LOW_LANE_SIZE, EV_PRIORITY_NORMAL));
+  vTaskDelay(DRAIN_TICKS);
+
+  EXPECT_EQ(LOW_LANE_SIZE + 1, (int)invoked.size());
+  EventGetStats(&stats);
+  EXPECT_EQ(LOW_LANE_SIZE, (int)stats.callbackCount[EV_PRIORITY_LOW]);
+  EXPECT_EQ(1, (int)stats.coalescedEvents);
+
+  /* A busy high lane lets a pending low callback through after
+   * MAX_PASSED_OVER of its own */
+  EventClearStats();
+  EXPECT_EQ(pdTRUE, dispatch(low_cb, 0, 0, EV_PRIORITY_LOW));
+  EXPECT_EQ(pdTRUE, dispatch(busy_cb, 1, 0, EV_PRIORITY_HIGH));
+  vTaskDelay(DRAIN_TICKS);
+
+  EXPECT_EQ(BUSY_CALLBACKS, (int)busy_count);
+  EXPECT_EQ(MAX_PASSED_OVER, (int)busy_count_at_low);
+  EventGetStats(&stats);
+  EXPECT_EQ(BUSY_CALLBACKS, (int)stats.callbackCount[EV_PRIORITY_HIGH]);
+  EXPECT_EQ(1, (int)stats.callbackCount[EV_PRIORITY_LOW]);
+  EXPECT_EQ(1, (int)stats.agedCount[EV_PRIORITY_LOW]);
+  EXPECT_EQ(0, (int)stats.agedCount[EV_PRIORITY_NORMAL]);
+
+  done = true;
+  vTaskEndScheduler();
+}
+
+TEST(EventDispatcher, Lanes) {
+  ASSERT_EQ(0, EventDispatcherInitialize());
+  ASSERT_EQ(pdPASS, xTaskCreate(control_task, (const signed char *)"Control", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY + 4, NULL));
+
+  vTaskStartScheduler();
+
+  EXPECT_TRUE(done);
+}
@@ -0,0 +1,326 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+#include <deque>
+
+extern "C" {
+
+#include "fifo_buffer.h"
+
+}
+
+/* Check the spans of a buffer against its state, as a caller relies on them */
+static void check_spans(t_fifo_buffer *buf)
+{
+  t_fifo_span span;
+  uint8_t *start = buf->buf_ptr;
+  uint8_t *end = buf->buf_ptr + buf->buf_size;
+
+  uint16_t free_bytes = fifoBuf_reserve(buf, &span);
+  EXPECT_EQ(fifoBuf_getFree(buf), free_bytes);
+  EXPECT_EQ(free_bytes, span.len[0] + span.len[1]);
+  EXPECT_EQ(start, span.ptr[1]);
+  EXPECT_LE(span.ptr[0] + span.len[0], end);
+  EXPECT_LE(span.ptr[1] + span.len[1], span.ptr[0]);
+  /* The slot before the reader is never handed out */
+  uint8_t *sentinel = start + (buf->rd + buf->buf_size - 1) % (buf->buf_size ? buf->buf_size : 1);
+  for (int i = 0; i < 2; i++) {
+    if (span.len[i] > 0) {
+      EXPECT_FALSE(sentinel >= span.ptr[i] && sentinel < span.ptr[i] + span.len[i]);
+    }
+  }
+
+  uint16_t used_bytes = fifoBuf_peek(buf, &span);
+  EXPECT_EQ(fifoBuf_getUsed(buf), used_bytes);
+  EXPECT_EQ(used_bytes, span.len[0] + span.len[1]);
+  EXPECT_EQ(start, span.ptr[1]);
+  EXPECT_EQ(start + buf->rd, span.ptr[0]);
+  EXPECT_LE(span.ptr[0] + span.len[0], end);
+  EXPECT_LE(span.ptr[1] + span.len[1], span.ptr[0]);
+}
+
+/* Write through the free spans, as PIOS_COM_SendReserve callers do */
+static uint16_t span_put(t_fifo_buffer *buf, const uint8_t *data, uint16_t len)
+{
+  t_fifo_span span;
+  fifoBuf_reserve(buf, &span);
+
+  uint16_t n = 0;
+  for (int i = 0; i < 2 && n < len; i++) {
+    uint16_t chunk = len - n < span.len[i] ? len - n : span.len[i];
+    memcpy(span.ptr[i], data + n, chunk);
+    n += chunk;
+  }
+  return fifoBuf_commit(buf, n);
+}
+
+/* Read through the used spans, as a DMA driver would */
+static uint16_t span_get(t_fifo_buffer *buf, uint8_t *data, uint16_t len)
+{
+  t_fifo_span span;
+  fifoBuf_peek(buf, &span);
+
+  uint16_t n = 0;
+  for (int i = 0; i < 2 && n < len; i++) {
+    uint16_t chunk = len - n < span.len[i] ? len - n : span.len[i];
+    memcpy(data + n, span.ptr[i], chunk);
+    n += chunk;
+  }
+  fifoBuf_removeData(buf, n);
+
+  return n;
+}
+
+class FifoBuffer : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1);
+    memset(storage, 0, sizeof(storage));
+  }
+
+  uint8_t storage[2][300];
+};
+
+TEST_F(FifoBuffer, TinyBuffers) {
+  t_fifo_buffer buf;
+  t_fifo_span span;
+
+  /* A buffer of n bytes holds n - 1 */
+  fifoBuf_init(&buf, storage[0], 0);
+  EXPECT_EQ(0, fifoBuf_reserve(&buf, &span));
+  EXPECT_EQ(0, fifoBuf_peek(&buf, &span));
+
+  fifoBuf_init(&buf, storage[0], 1);
+  EXPECT_EQ(0, fifoBuf_reserve(&buf, &span));
+  EXPECT_EQ(0, fifoBuf_commit(&buf, 1));
+  EXPECT_EQ(0, fifoBuf_getUsed(&buf));
+
+  fifoBuf_init(&buf, storage[0], 2);
+  for (int i = 0; i < 5; i++) {
+    ASSERT_EQ(1, fifoBuf_reserve(&buf, &span));
+    span.ptr[span.len[0] ? 0 : 1][0] = 0x40 + i;
+    ASSERT_EQ(1, fifoBuf_commit(&buf, 2));
+    ASSERT_EQ(1, fifoBuf_getUsed(&buf));
+    ASSERT_EQ(1, fifoBuf_peek(&buf, &span));
+    EXPECT_EQ(0x40 + i, span.ptr[span.len[0] ? 0 : 1][0]);
+    fifoBuf_removeData(&buf, 1);
+    check_spans(&buf);
+  }
+}
+
+TEST_F(FifoBuffer, SpansWrapAroundTheEnd) {
+  t_fifo_buffer buf;
+  t_fifo_span span;
+  uint8_t data[16];
+
+  fifoBuf_init(&buf, storage[0], 16);
+  for (int i = 0; i < 16; i++)
+    data[i] = i;
+
+  /* Move both pointers to 12 */
+  EXPECT_EQ(12, fifoBuf_putData(&buf, data, 12));
+  EXPECT_EQ(12, fifoBuf_getData(&buf, data, 12));
+
+  /* Free space: 4 bytes to the end, then 11 from the start */
+  EXPECT_EQ(15, fifoBuf_reserve(&buf, &span));
+  EXPECT_EQ(4, span.len[0]);
+  EXPECT_EQ(11, span.len[1]);
+
+  for (int i = 0; i < 16; i++)
+    data[i] = 0x80 + i;
+  EXPECT_EQ(10, span_put(&buf, data, 10));
+
+  EXPECT_EQ(10, fifoBuf_peek(&buf, &span));
+  EXPECT_EQ(4, span.len[0]);
+  EXPECT_EQ(6, span.len[1]);
+  EXPECT_EQ(0x80, span.ptr[0][0]);
+  EXPECT_EQ(0x84, span.ptr[1][0]);
+
+  uint8_t out[16];
+  EXPECT_EQ(10, fifoBuf_getData(&buf, out, sizeof(out)));
+  EXPECT_EQ(0, memcmp(data, out, 10));
+  check_spans(&buf);
+}
+
+TEST_F(FifoBuffer, CommitIsClampedToTheFreeSpace) {
+  t_fifo_buffer buf;
+  fifoBuf_init(&buf, storage[0], 32);
+
+  EXPECT_EQ(31, fifoBuf_commit(&buf, 100));
+  EXPECT_EQ(31, fifoBuf_getUsed(&buf));
+  EXPECT_EQ(0, fifoBuf_getFree(&buf));
+  EXPECT_EQ(0, fifoBuf_commit(&buf, 1));
+  check_spans(&buf);
+}
+
+/* Random operations on two buffers, one used through the copying calls and
+ * one through the spans, must give the same buffer as a reference queue */
+TEST_F(FifoBuffer, SpansMatchCopyingCalls) {
+  const uint16_t sizes[] = { 2, 3, 7, 64, 255, 300 };
+
+  for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    t_fifo_buffer copy, zero;
+    std::deque<uint8_t> ref;
+    uint8_t data[300], out[300];
+    uint8_t next = 0;
+
+    fifoBuf_init(&copy, storage[0], sizes[s]);
+    fifoBuf_init(&zero, storage[1], sizes[s]);
+
+    for (int op = 0; op < 20000; op++) {
+      uint16_t len = rand() % (sizes[s] + 1);
+
+      if (rand() % 2) {
+        for (int i = 0; i < len; i++)
+          data[i] = next++;
+
+        uint16_t copied = fifoBuf_putData(&copy, data, len);
+        ASSERT_EQ(copied, span_put(&zero, data, len));
+
+        /* putData only takes all or nothing */
+        for (int i = 0; i < copied; i++)
+          ref.push_back(data[i]);
+        next -= len - copied;
+      } else {
+        uint16_t copied = fifoBuf_getData(&copy, out, len);
+        ASSERT_EQ(copied, span_get(&zero, data, len));
+        ASSERT_EQ(0, memcmp(out, data, copied));
+
+        for (int i = 0; i < copied; i++) {
+          ASSERT_EQ(ref.front(), out[i]);
+          ref.pop_front();
+        }
+      }
+
+      ASSERT_EQ(ref.size(), fifoBuf_getUsed(&zero));
+      ASSERT_EQ(fifoBuf_getUsed(&copy), fifoBuf_getUsed(&zero));
+      ASSERT_EQ(fifoBuf_getFree(&copy), fifoBuf_getFree(&zero));
+      check_spans(&zero);
+      if (HasFailure())
+        return;
+    }
+  }
+}
+
+static double elapsed_ns(const struct timespec &start, const struct timespec &end)
+{
+  return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+/* Stands in for serializing a message, e.g. UAVTalk packing an object */
+static void __attribute__((noinline)) build_message(uint8_t *dest, uint16_t len, uint32_t n)
+{
+  for (uint16_t i = 0; i < len; i++)
+    dest[i] = n + i;
+}
+
+/* Stands in for the driver handing the bytes to the hardware */
+static uint32_t __attribute__((noinline)) transmit(const uint8_t *src, uint16_t len)
+{
+  uint32_t sum = 0;
+  for (uint16_t i = 0; i < len; i++)
+    sum += src[i];
+  return sum;
+}
+
+#define BENCH_BUF_LEN		256
+#define BENCH_MSG_LEN		45	/* a UAVTalk attitude packet */
+#define BENCH_DRIVER_LEN	64	/* one USB HID report */
+
+TEST_F(FifoBuffer, Benchmark) {
+  const uint32_t num_messages = 2000000;
+  struct timespec start, end;
+  t_fifo_buffer buf;
+  t_fifo_span span;
+  uint8_t scratch[BENCH_MSG_LEN];
+  uint8_t driver[BENCH_DRIVER_LEN];
+
+  /* Copying: build in a scratch buffer, copy into the fifo, copy out again */
+  uint64_t copy_bytes = 0;
+  uint32_t copy_sum = 0;
+  fifoBuf_init(&buf, storage[0], BENCH_BUF_LEN);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t n = 0; n < num_messages; n++) {
+    build_message(scratch, BENCH_MSG_LEN, n);
+    copy_bytes += fifoBuf_putData(&buf, scratch, BENCH_MSG_LEN);
+    while (fifoBuf_getUsed(&buf) >= BENCH_DRIVER_LEN) {
+      uint16_t len = fifoBuf_getData(&buf, driver, BENCH_DRIVER_LEN);
+      copy_bytes += len;
+      copy_sum += transmit(driver, len);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double copy_ns = elapsed_ns(start, end);
+  copy_sum += transmit(driver, fifoBuf_getData(&buf, driver, BENCH_DRIVER_LEN));
+
+  /* Zero copy: build in place, transmit from the fifo, copy only on wrap */
+  uint64_t zero_bytes = 0;
+  uint32_t zero_sum = 0;
+  fifoBuf_init(&buf, storage[1], BENCH_BUF_LEN);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t n = 0; n < num_messages; n++) {
+    fifoBuf_reserve(&buf, &span);
+    if (span.len[0] >= BENCH_MSG_LEN) {
+      build_message(span.ptr[0], BENCH_MSG_LEN, n);
+      fifoBuf_commit(&buf, BENCH_MSG_LEN);
+    } else {
+      build_message(scratch, BENCH_MSG_LEN, n);
+      zero_bytes += fifoBuf_putData(&buf, scratch, BENCH_MSG_LEN);
+    }
+    while (fifoBuf_getUsed(&buf) >= BENCH_DRIVER_LEN) {
+      fifoBuf_peek(&buf, &span);
+      uint16_t len = span.len[0] < BENCH_DRIVER_LEN ? span.len[0] : BENCH_DRIVER_LEN;
+      zero_sum += transmit(span.ptr[0], len);
+      fifoBuf_removeData(&buf, len);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double zero_ns = elapsed_ns(start, end);
+  zero_sum += transmit(driver, fifoBuf_getData(&buf, driver, BENCH_DRIVER_LEN));
+
+  /* Both deliver the same bytes */
+  EXPECT_EQ(copy_sum, zero_sum);
+
+  double total_mb = (double)num_messages * BENCH_MSG_LEN / 1e6;
+  printf("fifo_buffer %d byte messages: copying %.0f MB/s, %.2f copies per byte, zero copy %.0f MB/s, %.2f copies per byte\n",
+         BENCH_MSG_LEN,
+         total_mb / (copy_ns / 1e9), copy_bytes / (total_mb * 1e6),
+         total_mb / (zero_ns / 1e9), zero_bytes / (total_mb * 1e6));
+}
@@ -0,0 +1,15 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include "pios.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "utlist.h"
+#include "uavobjectmanager.h"
+#include "eventdispatcher.h"
+
+#endif /* OPENPILOT_H */
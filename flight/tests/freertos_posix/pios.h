@@ -0,0 +1,19 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* C Lib Includes */
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+/* Provided by the unit test */
+#include "pios_flashfs.h"
+
+#endif /* PIOS_H */
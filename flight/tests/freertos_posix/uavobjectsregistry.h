@@ -0,0 +1,31 @@
+#ifndef UAVOBJECTSREGISTRY_H
+#define UAVOBJECTSREGISTRY_H
+
+/*
+ * Stands in for the registry the UAVObject generator writes. The objects
+ * of the test are single instance and hold one timestamp, except for the
+ * latest value object. Their descriptors are defined by the unit test.
+ */
+#define SAMPLEQUEUE_OBJID	0x00000010
+#define SAMPLENOTIFY_OBJID	0x00000020
+#define CHECKA_OBJID		0x00000030
+#define CHECKB_OBJID		0x00000040
+#define LATEST_OBJID		0x00000050
+
+extern const UAVObjDescriptor SampleQueueDescriptor;
+extern const UAVObjDescriptor SampleNotifyDescriptor;
+extern const UAVObjDescriptor CheckADescriptor;
+extern const UAVObjDescriptor CheckBDescriptor;
+extern const UAVObjDescriptor LatestDescriptor;
+
+#define UAVOBJECTS_REGISTRY_SIZE 5
+
+static const UAVObjRegistryEntry uavo_registry[UAVOBJECTS_REGISTRY_SIZE] = {
+	{ .id = SAMPLEQUEUE_OBJID, .descriptor = &SampleQueueDescriptor },
+	{ .id = SAMPLENOTIFY_OBJID, .descriptor = &SampleNotifyDescriptor },
+	{ .id = CHECKA_OBJID, .descriptor = &CheckADescriptor },
+	{ .id = CHECKB_OBJID, .descriptor = &CheckBDescriptor },
+	{ .id = LATEST_OBJID, .descriptor = &LatestDescriptor },
+};
+
+#endif /* UAVOBJECTSREGISTRY_H */
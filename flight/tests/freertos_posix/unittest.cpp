@@ -0,0 +1,695 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+#include <unistd.h>		/* pipe, read, write */
+#include <errno.h>		/* errno */
+#include <string.h>		/* memcpy, memset */
+#include <pthread.h>		/* pthread_create, pthread_join, pthread_kill */
+#include <signal.h>		/* sigaction */
+
+
+extern "C" {
+
+#include "openpilot.h"
+#include "uavobjectsregistry.h"
+
+}
+
+#define NUM_ROUND_TRIPS 20000
+#define DELAY_TICKS 50
+#define NUM_ISR_SAMPLES 200
+#define NOTIFY_TIMEOUT_TICKS 5
+#define NUM_BENCH_UPDATES 4000
+#define BENCH_BURST 4
+#define TIMEOUT_MS 30000
+#define LATEST_WORDS 1024
+#define LATEST_TICKS 200
+
+#define CONTROL_PRIORITY 4
+#define SENSOR_PRIORITY 6
+
+#define SAMPLE_BIT 0x1
+#define CHECK_A_BIT 0x1
+#define CHECK_B_BIT 0x2
+
+static uint64_t now_ns(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static uint64_t cpu_ns(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* Fakes for the services the object manager takes from the rest of the firmware */
+extern "C" {
+
+uintptr_t pios_uavo_settings_fs_id;
+
+/* Only the latest value object is saved and loaded */
+static uint32_t flash_latest[LATEST_WORDS];
+
+int32_t PIOS_FLASHFS_ObjSave(uintptr_t /* fs_id */, uint32_t obj_id, uint16_t /* obj_inst_id */, uint8_t * obj_data, uint16_t obj_size)
+{
+  if (obj_id != LATEST_OBJID || obj_size != sizeof(flash_latest))
+    return -1;
+  memcpy(flash_latest, obj_data, obj_size);
+  return 0;
+}
+
+int32_t PIOS_FLASHFS_ObjLoad(uintptr_t /* fs_id */, uint32_t obj_id, uint16_t /* obj_inst_id */, uint8_t * obj_data, uint16_t obj_size)
+{
+  if (obj_id != LATEST_OBJID || obj_size != sizeof(flash_latest))
+    return -1;
+  memcpy(obj_data, flash_latest, obj_size);
+  return 0;
+}
+
+int32_t PIOS_FLASHFS_ObjDelete(uintptr_t /* fs_id */, uint32_t /* obj_id */, uint16_t /* obj_inst_id */)
+{
+  return -1;
+}
+
+void * PIOS_malloc_no_dma(size_t size)
+{
+  return malloc(size);
+}
+
+/* No callback is connected to the objects of this test */
+int32_t EventCallbackDispatch(UAVObjEvent * /* ev */, UAVObjEventCallback /* cb */, UAVObjEventPriority /* priority */)
+{
+  ADD_FAILURE();
+  return pdFALSE;
+}
+
+#define TEST_OBJECT(name, objid)					\
+  static UAVObjHandle name##Handle;					\
+  const UAVObjDescriptor name##Descriptor = {				\
+    objid, sizeof(uint64_t), true, false, false,			\
+    { ACCESS_READWRITE << UAVOBJ_ACCESS_SHIFT, 0, 0, 0 },		\
+    NULL, &name##Handle,						\
+  };
+
+TEST_OBJECT(SampleQueue, SAMPLEQUEUE_OBJID)
+TEST_OBJECT(SampleNotify, SAMPLENOTIFY_OBJID)
+TEST_OBJECT(CheckA, CHECKA_OBJID)
+TEST_OBJECT(CheckB, CHECKB_OBJID)
+
+static UAVObjHandle LatestHandle;
+const UAVObjDescriptor LatestDescriptor = {
+  LATEST_OBJID, LATEST_WORDS * sizeof(uint32_t), true, false, true,
+  { ACCESS_READWRITE << UAVOBJ_ACCESS_SHIFT, 0, 0, 0 },
+  NULL, &LatestHandle,
+};
+
+}
+
+static xQueueHandle ping_queue;
+static xQueueHandle pong_queue;
+static volatile uint32_t round_trips;
+static volatile bool ping_done;
+static uint64_t ping_ns;
+
+static volatile bool delay_done;
+static uint64_t delay_ns;
+static portTickType delay_ticks;
+
+static int pipe_fds[2];
+static volatile bool fd_done;
+static uint64_t fd_written_ns;
+static uint64_t fd_woken_ns;
+static portTickType fd_written_ticks;
+static portTickType fd_woken_ticks;
+static char fd_byte;
+
+/* The tick hook stands in for a sensor interrupt, the sensor task
+ * publishes each sample in an object that a consumer waits on either
+ * through an object queue or a UAVObjNotifier */
+static volatile bool isr_armed;
+static volatile uint64_t isr_ns;
+static xSemaphoreHandle isr_sem;
+static xQueueHandle sample_queue;
+static UAVObjNotifier sample_notifier;
+static volatile bool isr_done;
+static uint32_t isr_samples;
+
+static volatile bool benchmarking;
+static volatile uint32_t queue_wakeups;
+static volatile uint32_t notify_wakeups;
+
+struct latency {
+  uint32_t count;
+  uint64_t sum_ns;
+  uint64_t max_ns;
+};
+static struct latency isr_latency;
+static struct latency queue_latency;
+static struct latency notify_latency;
+
+static void latency_add(struct latency *latency, uint64_t ns)
+{
+  latency->count++;
+  latency->sum_ns += ns;
+  if (ns > latency->max_ns)
+    latency->max_ns = ns;
+}
+
+/* Outcome of the notifier checks, taken in the control task */
+static UAVObjNotifier check_notifier;
+static volatile bool check_done;
+static portTickType timeout_ticks;
+static portTickType other_bit_ticks;
+static uint32_t other_bit_woken;
+static uint32_t other_bit_left;
+static uint32_t pending_woken;
+static uint32_t pending_left;
+static uint32_t both_woken;
+static uint32_t disconnected_woken;
+
+static volatile bool latest_stop;
+static uint32_t latest_writes;
+static uint32_t latest_write_errors;
+static uint32_t latest_readbacks_torn;
+static volatile uint32_t latest_isr_writes;
+static volatile uint32_t latest_isr_errors;
+static uint32_t latest_reads;
+static uint32_t latest_torn;
+static uint32_t latest_unpacks;
+static uint32_t latest_unpack_errors;
+static bool latest_unpacked;
+static bool latest_saved;
+static bool latest_loaded;
+static volatile bool latest_done;
+
+struct bench {
+  const char *name;
+  uint32_t burst;
+  uint64_t cpu_ns;
+  uint32_t wakeups;
+  uint32_t errors;
+};
+static struct bench benches[] = {
+  { "object queue", 1, 0, 0, 0 },
+  { "notifier", 1, 0, 0, 0 },
+  { "object queue", BENCH_BURST, 0, 0, 0 },
+  { "notifier", BENCH_BURST, 0, 0, 0 },
+};
+#define NUM_BENCHES (sizeof(benches) / sizeof(benches[0]))
+static volatile bool bench_done;
+
+/* Both queue tasks block in turn, every round trip is two context switches */
+static void ping_task(void *parameters __attribute__((unused)))
+{
+  uint64_t start = now_ns();
+
+  for (uint32_t i = 0; i < NUM_ROUND_TRIPS; i++) {
+    uint32_t token = i;
+    xQueueSend(ping_queue, &token, portMAX_DELAY);
+    xQueueReceive(pong_queue, &token, portMAX_DELAY);
+    if (token == i)
+      round_trips++;
+  }
+
+  ping_ns = now_ns() - start;
+  ping_done = true;
+  vTaskDelete(NULL);
+}
+
+static void pong_task(void *parameters __attribute__((unused)))
+{
+  uint32_t token;
+
+  while (1) {
+    xQueueReceive(ping_queue, &token, portMAX_DELAY);
+    xQueueSend(pong_queue, &token, portMAX_DELAY);
+  }
+}
+
+/* Runs above the queue tasks, has to preempt them when the delay expires */
+static void delay_task(void *parameters __attribute__((unused)))
+{
+  portTickType start_ticks = xTaskGetTickCount();
+  uint64_t start = now_ns();
+
+  vTaskDelay(DELAY_TICKS);
+
+  delay_ns = now_ns() - start;
+  delay_ticks = xTaskGetTickCount() - start_ticks;
+  delay_done = true;
+  vTaskDelete(NULL);
+}
+
+static void fd_task(void *parameters __attribute__((unused)))
+{
+  portWAIT_FOR_READABLE(pipe_fds[0]);
+
+  /* The threaded port suspends tasks with a signal, which interrupts
+   * a blocking read */
+  ssize_t len;
+  do {
+    len = read(pipe_fds[0], &fd_byte, 1);
+  } while (len < 0 && errno == EINTR);
+  fd_woken_ns = now_ns();
+  fd_woken_ticks = xTaskGetTickCount();
+  EXPECT_EQ(1, len);
+
+  fd_done = true;
+  vTaskDelete(NULL);
+}
+
+extern "C" void vApplicationTickHook(void)
+{
+  if (!isr_armed)
+    return;
+
+  isr_ns = now_ns();
+  portBASE_TYPE woken = pdFALSE;
+  xSemaphoreGiveFromISR(isr_sem, &woken);
+  portEND_SWITCHING_ISR(woken);
+}
+
+static void sensor_task(void *parameters __attribute__((unused)))
+{
+  for (isr_samples = 0; isr_samples < 2 * NUM_ISR_SAMPLES; isr_samples++) {
+    xSemaphoreTake(isr_sem, portMAX_DELAY);
+    uint64_t sample_ns = isr_ns;
+    latency_add(&isr_latency, now_ns() - sample_ns);
+
+    if (isr_samples % 2)
+      UAVObjSetData(SampleQueueHandle, &sample_ns);
+    else
+      UAVObjSetData(SampleNotifyHandle, &sample_ns);
+  }
+
+  isr_armed = false;
+  isr_done = true;
+  vTaskDelete(NULL);
+}
+
+static void queue_consumer_task(void *parameters __attribute__((unused)))
+{
+  UAVObjEvent ev;
+  uint64_t sample_ns;
+
+  while (1) {
+    xQueueReceive(sample_queue, &ev, portMAX_DELAY);
+    UAVObjGetData(ev.obj, &sample_ns);
+    queue_wakeups++;
+    if (!benchmarking)
+      latency_add(&queue_latency, now_ns() - sample_ns);
+  }
+}
+
+static void notify_consumer_task(void *parameters __attribute__((unused)))
+{
+  uint64_t sample_ns;
+
+  while (1) {
+    UAVObjNotifierWait(sample_notifier, SAMPLE_BIT, portMAX_DELAY);
+    UAVObjGetData(SampleNotifyHandle, &sample_ns);
+    notify_wakeups++;
+    if (!benchmarking)
+      latency_add(&notify_latency, now_ns() - sample_ns);
+  }
+}
+
+/* Two objects on one notifier, as a module that waits on several inputs */
+static void check_notifier_bits(void)
+{
+  uint64_t value = 0;
+  portTickType start;
+
+  /* Nothing pending, the wait runs into its timeout */
+  start = xTaskGetTickCount();
+  UAVObjNotifierWait(check_notifier, CHECK_A_BIT, NOTIFY_TIMEOUT_TICKS);
+  timeout_ticks = xTaskGetTickCount() - start;
+
+  /* An update of the other object gives the semaphore but is not what
+   * the task waits for, the wait goes on for the rest of the timeout
+   * and the bit is kept for a later wait */
+  UAVObjSetData(CheckBHandle, &value);
+  start = xTaskGetTickCount();
+  other_bit_woken = UAVObjNotifierWait(check_notifier, CHECK_A_BIT, NOTIFY_TIMEOUT_TICKS);
+  other_bit_ticks = xTaskGetTickCount() - start;
+  other_bit_left = UAVObjNotifierWait(check_notifier, CHECK_B_BIT, 0);
+
+  /* Updates made while the task was not waiting are not missed, and
+   * collapse into one wakeup */
+  for (int i = 0; i < 3; i++)
+    UAVObjSetData(CheckAHandle, &value);
+  pending_woken = UAVObjNotifierWait(check_notifier, CHECK_A_BIT | CHECK_B_BIT, 0);
+  pending_left = UAVObjNotifierWait(check_notifier, CHECK_A_BIT | CHECK_B_BIT, 0);
+
+  UAVObjSetData(CheckAHandle, &value);
+  UAVObjSetData(CheckBHandle, &value);
+  both_woken = UAVObjNotifierWait(check_notifier, CHECK_A_BIT | CHECK_B_BIT, 0);
+
+  UAVObjDisconnectNotifier(CheckBHandle, check_notifier);
+  UAVObjSetData(CheckBHandle, &value);
+  disconnected_woken = UAVObjNotifierWait(check_notifier, CHECK_A_BIT | CHECK_B_BIT, 0);
+
+  check_done = true;
+}
+
+/* Every write fills the whole latest value object with one value */
+static void latest_fill(uint32_t data[LATEST_WORDS], uint32_t value)
+{
+  for (int i = 0; i < LATEST_WORDS; i++)
+    data[i] = value;
+}
+
+static bool latest_consistent(const uint32_t data[LATEST_WORDS])
+{
+  for (int i = 1; i < LATEST_WORDS; i++)
+    if (data[i] != data[0])
+      return false;
+  return true;
+}
+
+/* The fiber port only switches tasks in kernel calls, never in the
+ * middle of a write, so the writers here are host threads and a signal.
+ * Writes of latest value objects do not call into the kernel. */
+static void latest_isr(int signum __attribute__((unused)))
+{
+  uint32_t data[LATEST_WORDS];
+
+  latest_fill(data, 0xee000000 | (latest_isr_writes & 0xffffff));
+  if (UAVObjSetData(LatestHandle, data) != 0)
+    latest_isr_errors = latest_isr_errors + 1;
+  latest_isr_writes = latest_isr_writes + 1;
+}
+
+/* The signal interrupts the writer wherever the host preempted it, which
+ * is often in the middle of a write, and writes the object itself as an
+ * ISR or a higher priority task would. A write that was overtaken like
+ * this is still whole when it is published: the writer reads back either
+ * its own value or a later one, never a mix. */
+static void *latest_writer_thread(void *parameters __attribute__((unused)))
+{
+  uint32_t data[LATEST_WORDS];
+
+  while (!latest_stop) {
+    latest_fill(data, 0x11000000 | (latest_writes & 0xffffff));
+    if (UAVObjSetData(LatestHandle, data) != 0)
+      latest_write_errors++;
+    latest_writes++;
+
+    UAVObjGetData(LatestHandle, data);
+    if (!latest_consistent(data))
+      latest_readbacks_torn++;
+  }
+
+  return NULL;
+}
+
+static void *latest_interrupter_thread(void *parameters)
+{
+  pthread_t writer = *(pthread_t *)parameters;
+
+  while (!latest_stop) {
+    pthread_kill(writer, SIGUSR2);
+    sched_yield();
+  }
+
+  return NULL;
+}
+
+/* The control task also reads the object every tick and unpacks into it
+ * as telemetry would. That makes up to three writers at once, the one
+ * that finds no free buffer fails. */
+static void check_latest_writers(void)
+{
+  struct sigaction action;
+  pthread_t writer;
+  pthread_t interrupter;
+  uint32_t data[LATEST_WORDS];
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = latest_isr;
+  action.sa_flags = SA_RESTART;
+  sigaction(SIGUSR2, &action, NULL);
+
+  EXPECT_EQ(0, pthread_create(&writer, NULL, latest_writer_thread, NULL));
+  EXPECT_EQ(0, pthread_create(&interrupter, NULL, latest_interrupter_thread, &writer));
+
+  for (uint32_t i = 0; i < LATEST_TICKS; i++) {
+    vTaskDelay(1);
+
+    UAVObjGetData(LatestHandle, data);
+    latest_reads++;
+    if (!latest_consistent(data))
+      latest_torn++;
+
+    latest_fill(data, 0xff000000 | i);
+    latest_unpacks++;
+    if (UAVObjUnpack(LatestHandle, 0, (const uint8_t *)data) != 0)
+      latest_unpack_errors++;
+  }
+
+  latest_stop = true;
+  pthread_join(interrupter, NULL);
+  pthread_join(writer, NULL);
+
+  /* Alone, an unpack always finds a buffer */
+  latest_fill(data, 0xfeedf00d);
+  latest_unpacked = UAVObjUnpack(LatestHandle, 0, (const uint8_t *)data) == 0;
+  memset(data, 0, sizeof(data));
+  latest_unpacked = latest_unpacked && UAVObjGetData(LatestHandle, data) == 0 &&
+    latest_consistent(data) && data[0] == 0xfeedf00d;
+
+  /* Save and load go through the buffers the same way */
+  latest_fill(data, 0x5a5a5a5a);
+  UAVObjSetData(LatestHandle, data);
+  memset(flash_latest, 0, sizeof(flash_latest));
+  latest_saved = UAVObjSave(LatestHandle, 0) == 0 && latest_consistent(flash_latest) &&
+    flash_latest[0] == 0x5a5a5a5a;
+
+  latest_fill(flash_latest, 0xa5a5a5a5);
+  memset(data, 0, sizeof(data));
+  latest_loaded = UAVObjLoad(LatestHandle, 0) == 0 &&
+    UAVObjGetData(LatestHandle, data) == 0 && latest_consistent(data) && data[0] == 0xa5a5a5a5;
+
+  latest_done = true;
+}
+
+/* CPU time per update handed to a consumer task. The consumer runs
+ * above the control task, for a burst the control task is raised above
+ * it while it publishes so the consumer wakes once per burst */
+static void run_bench(struct bench *bench, UAVObjHandle obj, volatile uint32_t *wakeups)
+{
+  uint64_t value = 0;
+  UAVObjStats stats;
+
+  UAVObjClearStats();
+  uint32_t start_wakeups = *wakeups;
+  uint64_t start = cpu_ns();
+
+  for (uint32_t i = 0; i < NUM_BENCH_UPDATES; i += bench->burst) {
+    if (bench->burst > 1)
+      vTaskPrioritySet(NULL, SENSOR_PRIORITY);
+    for (uint32_t j = 0; j < bench->burst; j++)
+      UAVObjSetData(obj, &value);
+    if (bench->burst > 1)
+      vTaskPrioritySet(NULL, CONTROL_PRIORITY);
+  }
+
+  bench->cpu_ns = cpu_ns() - start;
+  bench->wakeups = *wakeups - start_wakeups;
+  UAVObjGetStats(&stats);
+  bench->errors = stats.eventQueueErrors;
+}
+
+static void control_task(void *parameters __attribute__((unused)))
+{
+  UAVObjInitialize();
+  UAVObjRegister(&SampleQueueDescriptor);
+  UAVObjRegister(&SampleNotifyDescriptor);
+  UAVObjRegister(&CheckADescriptor);
+  UAVObjRegister(&CheckBDescriptor);
+  UAVObjRegister(&LatestDescriptor);
+  UAVObjConnectQueue(SampleQueueHandle, sample_queue, EV_MASK_ALL_UPDATES);
+  UAVObjConnectNotifier(SampleNotifyHandle, sample_notifier, SAMPLE_BIT, EV_MASK_ALL_UPDATES);
+  UAVObjConnectNotifier(CheckAHandle, check_notifier, CHECK_A_BIT, EV_MASK_ALL_UPDATES);
+  UAVObjConnectNotifier(CheckBHandle, check_notifier, CHECK_B_BIT, EV_MASK_ALL_UPDATES);
+
+  check_notifier_bits();
+
+  isr_armed = true;
+
+  fd_written_ticks = xTaskGetTickCount();
+  fd_written_ns = now_ns();
+  EXPECT_EQ(1, write(pipe_fds[1], "x", 1));
+
+  for (int waited = 0; waited < TIMEOUT_MS; waited += 10) {
+    if (ping_done && delay_done && fd_done && isr_done)
+      break;
+    vTaskDelay(10);
+  }
+
+  if (isr_done) {
+    benchmarking = true;
+    for (uint32_t i = 0; i < NUM_BENCHES; i++) {
+      if (i % 2)
+        run_bench(&benches[i], SampleNotifyHandle, &notify_wakeups);
+      else
+        run_bench(&benches[i], SampleQueueHandle, &queue_wakeups);
+    }
+    bench_done = true;
+  }
+
+  check_latest_writers();
+
+  vTaskEndScheduler();
+}
+
+TEST(FreeRTOSPosix, Scheduler) {
+  ASSERT_EQ(0, pipe(pipe_fds));
+
+  ping_queue = xQueueCreate(1, sizeof(uint32_t));
+  pong_queue = xQueueCreate(1, sizeof(uint32_t));
+  ASSERT_TRUE(ping_queue != NULL);
+  ASSERT_TRUE(pong_queue != NULL);
+
+  vSemaphoreCreateBinary(isr_sem);
+  sample_queue = xQueueCreate(1, sizeof(UAVObjEvent));
+  sample_notifier = UAVObjNotifierCreate();
+  check_notifier = UAVObjNotifierCreate();
+  ASSERT_TRUE(isr_sem != NULL);
+  ASSERT_TRUE(sample_queue != NULL);
+  ASSERT_TRUE(sample_notifier != NULL);
+  ASSERT_TRUE(check_notifier != NULL);
+  xSemaphoreTake(isr_sem, 0);
+
+  ASSERT_EQ(pdPASS, xTaskCreate(ping_task, (const signed char *)"Ping", configMINIMAL_STACK_SIZE, NULL, 2, NULL));
+  ASSERT_EQ(pdPASS, xTaskCreate(pong_task, (const signed char *)"Pong", configMINIMAL_STACK_SIZE, NULL, 2, NULL));
+  ASSERT_EQ(pdPASS, xTaskCreate(delay_task, (const signed char *)"Delay", configMINIMAL_STACK_SIZE, NULL, 3, NULL));
+  ASSERT_EQ(pdPASS, xTaskCreate(fd_task, (const signed char *)"Fd", configMINIMAL_STACK_SIZE, NULL, 3, NULL));
+  ASSERT_EQ(pdPASS, xTaskCreate(control_task, (const signed char *)"Control", configMINIMAL_STACK_SIZE, NULL, CONTROL_PRIORITY, NULL));
+  ASSERT_EQ(pdPASS, xTaskCreate(queue_consumer_task, (const signed char *)"QueueRx", configMINIMAL_STACK_SIZE, NULL, 5, NULL));
+  ASSERT_EQ(pdPASS, xTaskCreate(notify_consumer_task, (const signed char *)"NotifyRx", configMINIMAL_STACK_SIZE, NULL, 5, NULL));
+  ASSERT_EQ(pdPASS, xTaskCreate(sensor_task, (const signed char *)"Sensor", configMINIMAL_STACK_SIZE, NULL, SENSOR_PRIORITY, NULL));
+
+  vTaskStartScheduler();
+
+  EXPECT_TRUE(ping_done);
+  EXPECT_EQ(NUM_ROUND_TRIPS, (int)round_trips);
+
+  /* Only the order of events and tick counts are asserted, wall clock
+   * times depend on the load of the machine and are printed below */
+  EXPECT_TRUE(delay_done);
+  EXPECT_GE((int)delay_ticks, DELAY_TICKS);
+
+  EXPECT_TRUE(fd_done);
+  EXPECT_EQ('x', fd_byte);
+  EXPECT_GE(fd_woken_ns, fd_written_ns);
+  EXPECT_GE(fd_woken_ticks, fd_written_ticks);
+
+  EXPECT_TRUE(check_done);
+  EXPECT_GE(timeout_ticks, (portTickType)NOTIFY_TIMEOUT_TICKS);
+  EXPECT_EQ(0u, other_bit_woken);
+  EXPECT_GE(other_bit_ticks, (portTickType)NOTIFY_TIMEOUT_TICKS);
+  EXPECT_EQ((uint32_t)CHECK_B_BIT, other_bit_left);
+  EXPECT_EQ((uint32_t)CHECK_A_BIT, pending_woken);
+  EXPECT_EQ(0u, pending_left);
+  EXPECT_EQ((uint32_t)(CHECK_A_BIT | CHECK_B_BIT), both_woken);
+  EXPECT_EQ(0u, disconnected_woken);
+
+  EXPECT_TRUE(isr_done);
+  EXPECT_EQ(NUM_ISR_SAMPLES, (int)queue_latency.count);
+  EXPECT_EQ(NUM_ISR_SAMPLES, (int)notify_latency.count);
+
+  /* A queue of one event drops all but the first update of a burst, the
+   * notifier collapses them into one wakeup */
+  EXPECT_TRUE(bench_done);
+  for (uint32_t i = 0; i < NUM_BENCHES; i++) {
+    const struct bench *bench = &benches[i];
+    bool queue = (i % 2) == 0;
+    EXPECT_EQ(NUM_BENCH_UPDATES / bench->burst, bench->wakeups) << bench->name << ", burst " << bench->burst;
+    EXPECT_EQ(queue ? NUM_BENCH_UPDATES - NUM_BENCH_UPDATES / bench->burst : 0, bench->errors) << bench->name << ", burst " << bench->burst;
+  }
+
+  /* However the writers interleave, a reader never sees a mix of two
+   * writes */
+  EXPECT_TRUE(latest_done);
+  EXPECT_EQ((uint32_t)LATEST_TICKS, latest_reads);
+  EXPECT_EQ(0u, latest_torn);
+  EXPECT_GT(latest_writes, 0u);
+  EXPECT_GT(latest_isr_writes, 0u);
+  EXPECT_EQ(0u, latest_readbacks_torn);
+  EXPECT_TRUE(latest_unpacked);
+  EXPECT_TRUE(latest_saved);
+  EXPECT_TRUE(latest_loaded);
+
+  if (ping_done && ping_ns > 0) {
+    printf("%u round trips in %.1f ms, %.0f context switches/s\n",
+      NUM_ROUND_TRIPS, ping_ns / 1e6, 2.0 * NUM_ROUND_TRIPS * 1e9 / ping_ns);
+  }
+  if (delay_done) {
+    printf("%u tick delay under load took %.1f ms, %u ticks\n", DELAY_TICKS, delay_ns / 1e6,
+      (unsigned)delay_ticks);
+  }
+  if (fd_done) {
+    printf("fd wake-up latency %.1f us, %u ticks\n", (fd_woken_ns - fd_written_ns) / 1e3,
+      (unsigned)(fd_woken_ticks - fd_written_ticks));
+  }
+  const struct latency *latencies[] = { &isr_latency, &queue_latency, &notify_latency };
+  const char *names[] = { "isr to task", "isr to task to object queue", "isr to task to notifier" };
+  for (int i = 0; i < 3; i++) {
+    if (latencies[i]->count) {
+      printf("%s latency %.1f us mean, %.1f us max\n", names[i],
+        latencies[i]->sum_ns / 1e3 / latencies[i]->count, latencies[i]->max_ns / 1e3);
+    }
+  }
+  if (bench_done) {
+    for (uint32_t i = 0; i < NUM_BENCHES; i++) {
+      const struct bench *bench = &benches[i];
+      printf("%s, %u update%s per wakeup: %.2f us CPU per update, %u wakeups, %u dropped\n",
+        bench->name, bench->burst, bench->burst > 1 ? "s" : "",
+        bench->cpu_ns / 1e3 / NUM_BENCH_UPDATES, bench->wakeups, bench->errors);
+    }
+  }
+  if (latest_done) {
+    printf("latest value: %u task and %u isr writes, %u and %u found no free buffer, %u of %u unpacks did\n",
+      latest_writes, latest_isr_writes, latest_write_errors, latest_isr_errors,
+      latest_unpack_errors, latest_unpacks);
+  }
+}
@@ -0,0 +1,22 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+/* C Lib Includes */
+#include <stdlib.h>
+#include <string.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+#include <pios_i2c.h>
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#endif /* PIOS_H */
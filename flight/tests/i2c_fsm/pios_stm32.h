@@ -0,0 +1,23 @@
+#ifndef PIOS_STM32_H
+#define PIOS_STM32_H
+
+/* Only the state machine is built, so the peripheral types are opaque */
+typedef struct { uint32_t unused; } I2C_TypeDef;
+typedef struct { uint32_t unused; } I2C_InitTypeDef;
+typedef struct { uint32_t unused; } GPIO_TypeDef;
+typedef struct { uint32_t unused; } GPIO_InitTypeDef;
+typedef struct { uint32_t unused; } NVIC_InitTypeDef;
+
+struct stm32_gpio {
+	GPIO_TypeDef *gpio;
+	GPIO_InitTypeDef init;
+	uint8_t pin_source;
+};
+
+struct stm32_irq {
+	void (*handler) (uint32_t);
+	uint32_t flags;
+	NVIC_InitTypeDef init;
+};
+
+#endif /* PIOS_STM32_H */
@@ -0,0 +1,813 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <vector>
+
+extern "C" {
+
+#include "pios.h"
+#include "pios_i2c_priv.h"
+
+}
+
+#define EEPROM_ADDR		0x50
+#define IMU_ADDR		0x68
+#define ABSENT_ADDR		0x20
+
+#define MAX_TXNS		3
+#define MAX_LEN			6
+#define GUARD_LEN		4
+#define GUARD_BYTE		0xA5
+
+enum hw_event {
+  HW_NONE,
+  HW_STARTED,		/* EV5 */
+  HW_ADDRESS_SENT,	/* EV6 */
+  HW_BYTE_DONE,		/* EV7 / EV8_2 */
+  HW_DMA_DONE,		/* rx stream TC */
+  HW_NACK,		/* AF */
+  HW_BUS_ERROR,		/* BERR, ARLO, ... */
+};
+
+/* A register file behind an address, the first byte written selects the register */
+struct fake_slave {
+  bool present;
+  uint8_t reg;
+  uint8_t mem[256];
+};
+
+/* The peripheral as seen by the state machine through the HAL */
+static struct {
+  struct pios_i2c_adapter *adapter;
+
+  uint8_t irqs;
+  bool ack;
+  bool reading;
+  bool writing;
+  bool reg_selected;
+  struct fake_slave *slave;
+  enum hw_event pending;
+
+  /* The adapter has an rx stream, and what it was last given */
+  bool dma;
+  bool dma_armed;
+  uint8_t *dma_buf;
+  uint16_t dma_len;
+  uint32_t dma_reads;
+
+  uint32_t starts;
+  uint32_t stops;
+  uint32_t resets;
+  uint32_t out_of_bounds;
+} hw;
+
+static struct fake_slave slaves[128];
+
+static bool active_byte_in_bounds()
+{
+  const struct pios_i2c_txn *txn = hw.adapter->active_txn;
+  return hw.adapter->active_request != NULL &&
+    txn >= hw.adapter->active_request->txn_list &&
+    txn < hw.adapter->active_request->txn_list + hw.adapter->active_request->num_txns &&
+    hw.adapter->active_byte >= txn->buf &&
+    hw.adapter->active_byte < txn->buf + txn->len;
+}
+
+static bool in_read_state()
+{
+  return hw.adapter->state >= I2C_STATE_R_MORE_TXN_ADDR &&
+    hw.adapter->state <= I2C_STATE_R_LAST_TXN_DMA_DONE;
+}
+
+/* The DMA writes exactly the active read txn */
+static bool dma_in_bounds()
+{
+  const struct pios_i2c_txn *txn = hw.adapter->active_txn;
+  return active_byte_in_bounds() &&
+    txn->rw == PIOS_I2C_TXN_READ &&
+    hw.dma_buf >= txn->buf &&
+    hw.dma_buf + hw.dma_len <= txn->buf + txn->len;
+}
+
+extern "C" void i2c_hal_irq_config(struct pios_i2c_adapter * /* i2c_adapter */, uint8_t irqs, bool enable)
+{
+  if (enable)
+    hw.irqs |= irqs;
+  else
+    hw.irqs &= ~irqs;
+}
+
+extern "C" void i2c_hal_start(struct pios_i2c_adapter * /* i2c_adapter */, bool enable)
+{
+  if (enable) {
+    hw.starts++;
+    hw.reading = false;
+    hw.writing = false;
+    hw.pending = HW_STARTED;
+  } else if (hw.pending == HW_STARTED) {
+    hw.pending = HW_NONE;
+  }
+}
+
+extern "C" void i2c_hal_stop(struct pios_i2c_adapter * /* i2c_adapter */)
+{
+  hw.stops++;
+  hw.reading = false;
+  hw.writing = false;
+  hw.slave = NULL;
+  hw.pending = HW_NONE;
+}
+
+extern "C" void i2c_hal_ack(struct pios_i2c_adapter * /* i2c_adapter */, bool enable)
+{
+  hw.ack = enable;
+}
+
+extern "C" void i2c_hal_send_address(struct pios_i2c_adapter * /* i2c_adapter */, uint16_t addr, bool read)
+{
+  hw.slave = slaves[addr & 0x7f].present ? &slaves[addr & 0x7f] : NULL;
+  if (hw.slave == NULL) {
+    hw.pending = HW_NACK;
+    return;
+  }
+
+  hw.reading = read;
+  hw.writing = !read;
+  hw.reg_selected = false;
+  hw.pending = HW_ADDRESS_SENT;
+}
+
+extern "C" void i2c_hal_send_byte(struct pios_i2c_adapter * /* i2c_adapter */, uint8_t byte)
+{
+  if (!active_byte_in_bounds())
+    hw.out_of_bounds++;
+
+  if (hw.writing && hw.slave) {
+    if (!hw.reg_selected) {
+      hw.slave->reg = byte;
+      hw.reg_selected = true;
+    } else {
+      hw.slave->mem[hw.slave->reg++] = byte;
+    }
+  }
+  hw.pending = HW_BYTE_DONE;
+}
+
+extern "C" uint8_t i2c_hal_receive_byte(struct pios_i2c_adapter * /* i2c_adapter */)
+{
+  /* The write path also does a dummy read to clear TxE */
+  if (!in_read_state())
+    return 0;
+
+  if (!active_byte_in_bounds())
+    hw.out_of_bounds++;
+
+  if (hw.reading && hw.slave)
+    return hw.slave->mem[hw.slave->reg++];
+
+  return 0xff;
+}
+
+extern "C" bool i2c_hal_dma_rx_start(struct pios_i2c_adapter * /* i2c_adapter */, uint8_t *buf, uint16_t len)
+{
+  if (!hw.dma)
+    return false;
+
+  hw.dma_armed = true;
+  hw.dma_buf = buf;
+  hw.dma_len = len;
+  return true;
+}
+
+extern "C" void i2c_hal_dma_stop(struct pios_i2c_adapter * /* i2c_adapter */)
+{
+  hw.dma_armed = false;
+  hw.dma_len = 0;
+}
+
+extern "C" void i2c_adapter_reset_bus(struct pios_i2c_adapter * /* i2c_adapter */)
+{
+  hw.resets++;
+  hw.irqs = 0;
+  hw.ack = false;
+  hw.reading = false;
+  hw.writing = false;
+  hw.slave = NULL;
+  hw.pending = HW_NONE;
+}
+
+/* What a well behaved bus does next */
+static enum hw_event next_event()
+{
+  if (hw.pending != HW_NONE)
+    return hw.pending;
+
+  /* The receiver keeps clocking in bytes until stopped, or the DMA takes them all */
+  if (hw.reading && hw.slave)
+    return (hw.dma_armed && hw.dma_len) ? HW_DMA_DONE : HW_BYTE_DONE;
+
+  return HW_NONE;
+}
+
+/* Decode an event as the interrupt handlers do */
+static void dispatch(enum hw_event event)
+{
+  bool woken = false;
+
+  hw.pending = HW_NONE;
+
+  switch (event) {
+  case HW_NONE:
+    break;
+  case HW_STARTED:
+    i2c_adapter_started(hw.adapter, &woken);
+    break;
+  case HW_ADDRESS_SENT:
+    i2c_adapter_address_sent(hw.adapter, &woken);
+    break;
+  case HW_BYTE_DONE:
+    i2c_adapter_byte_done(hw.adapter, &woken);
+    break;
+  case HW_DMA_DONE:
+    if (hw.dma_armed && hw.dma_len && hw.reading && hw.slave) {
+      if (!dma_in_bounds())
+        hw.out_of_bounds++;
+      for (uint16_t i = 0; i < hw.dma_len; i++)
+        hw.dma_buf[i] = hw.slave->mem[hw.slave->reg++];
+      hw.dma_len = 0;
+      hw.dma_reads++;
+    }
+
+    /* The handler drops the interrupt of a stream already stopped */
+    if (hw.adapter->dma_rx)
+      i2c_adapter_dma_done(hw.adapter, &woken);
+    break;
+  case HW_NACK:
+    i2c_adapter_inject_event(hw.adapter, I2C_EVENT_NACK, &woken);
+    break;
+  case HW_BUS_ERROR:
+    i2c_adapter_inject_event(hw.adapter, I2C_EVENT_BUS_ERROR, &woken);
+    break;
+  }
+}
+
+/* Run the bus until it goes idle, checking the interrupts needed are enabled */
+static uint32_t run_bus()
+{
+  uint32_t events = 0;
+  enum hw_event event;
+
+  while ((event = next_event()) != HW_NONE && events < 10000) {
+    EXPECT_TRUE(hw.irqs & I2C_HAL_IRQ_EVT);
+    EXPECT_TRUE(hw.irqs & I2C_HAL_IRQ_ERR);
+    if (event == HW_BYTE_DONE && hw.reading) {
+      EXPECT_TRUE(hw.irqs & I2C_HAL_IRQ_BUF);
+    }
+    if (event == HW_DMA_DONE) {
+      /* DMA requests need the buffer interrupt off, and every byte but the last acked */
+      EXPECT_FALSE(hw.irqs & I2C_HAL_IRQ_BUF);
+      EXPECT_TRUE(hw.ack);
+    }
+
+    dispatch(event);
+    events++;
+  }
+
+  return events;
+}
+
+/* A request with guard bytes around each of its buffers */
+struct test_request {
+  struct pios_i2c_request request;
+  struct pios_i2c_txn txns[MAX_TXNS];
+  uint8_t bufs[MAX_TXNS][GUARD_LEN + MAX_LEN + GUARD_LEN];
+
+  bool outstanding;
+  uint32_t seq;
+  uint32_t completions;
+  int32_t result;
+  bool guards_intact;
+  struct test_request *chain;
+};
+
+static uint32_t completed_seq;
+static uint32_t completions;
+static uint32_t extra_completions;
+static uint32_t guard_failures;
+static uint32_t bad_results;
+static bool out_of_order;
+
+static bool guards_intact(const struct test_request *t)
+{
+  for (uint32_t i = 0; i < t->request.num_txns; i++) {
+    for (uint32_t j = 0; j < GUARD_LEN; j++) {
+      if (t->bufs[i][j] != GUARD_BYTE)
+        return false;
+      if (t->bufs[i][GUARD_LEN + t->txns[i].len + j] != GUARD_BYTE)
+        return false;
+    }
+  }
+  return true;
+}
+
+static void request_done(struct pios_i2c_request *request, int32_t result, bool * /* woken */)
+{
+  struct test_request *t = (struct test_request *)request->ctx;
+
+  if (!t->outstanding)
+    extra_completions++;
+  if (result != 0 && result != -1 && result != -2 && result != -3)
+    bad_results++;
+  t->outstanding = false;
+  t->completions++;
+  t->result = result;
+  t->guards_intact = guards_intact(t);
+  if (!t->guards_intact)
+    guard_failures++;
+  completions++;
+
+  /* Aborts can overtake, everything else completes in submission order */
+  if (result != -2) {
+    if (t->seq < completed_seq)
+      out_of_order = true;
+    completed_seq = t->seq;
+  }
+
+  if (t->chain) {
+    struct test_request *chain = t->chain;
+    t->chain = NULL;
+    i2c_adapter_submit(hw.adapter, &chain->request, NULL);
+  }
+}
+
+static uint32_t next_seq;
+
+static void init_request(struct test_request *t, uint16_t addr)
+{
+  memset(t, 0, sizeof(*t));
+  memset(t->bufs, GUARD_BYTE, sizeof(t->bufs));
+  t->request.txn_list = t->txns;
+  t->request.callback = request_done;
+  t->request.ctx = t;
+  for (uint32_t i = 0; i < MAX_TXNS; i++) {
+    t->txns[i].addr = addr;
+    t->txns[i].buf = &t->bufs[i][GUARD_LEN];
+  }
+}
+
+static void add_txn(struct test_request *t, enum pios_i2c_txn_direction rw, const uint8_t *data, uint32_t len)
+{
+  struct pios_i2c_txn *txn = &t->txns[t->request.num_txns++];
+  txn->rw = rw;
+  txn->len = len;
+  if (data)
+    memcpy(txn->buf, data, len);
+  else
+    memset(txn->buf, 0, len);
+}
+
+static void submit(struct test_request *t)
+{
+  t->outstanding = true;
+  t->seq = next_seq++;
+  i2c_adapter_submit(hw.adapter, &t->request, NULL);
+}
+
+class I2CFsm : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(&hw, 0, sizeof(hw));
+    memset(slaves, 0, sizeof(slaves));
+    memset(&adapter, 0, sizeof(adapter));
+
+    slaves[EEPROM_ADDR].present = true;
+    slaves[IMU_ADDR].present = true;
+    for (uint32_t i = 0; i < sizeof(slaves[IMU_ADDR].mem); i++)
+      slaves[IMU_ADDR].mem[i] = i ^ 0x5a;
+
+    adapter.magic = PIOS_I2C_DEV_MAGIC;
+    hw.adapter = &adapter;
+    i2c_adapter_fsm_init(&adapter);
+    hw.resets = 0;
+
+    completed_seq = 0;
+    completions = 0;
+    extra_completions = 0;
+    guard_failures = 0;
+    bad_results = 0;
+    out_of_order = false;
+    next_seq = 0;
+  }
+
+  void ReadsEveryLength();
+  void FuzzRandomEvents();
+
+  struct pios_i2c_adapter adapter;
+};
+
+TEST_F(I2CFsm, WriteThenReadBack) {
+  struct test_request write, read;
+  const uint8_t payload[] = { 0x10, 1, 2, 3 };
+  const uint8_t reg[] = { 0x10 };
+
+  init_request(&write, EEPROM_ADDR);
+  add_txn(&write, PIOS_I2C_TXN_WRITE, payload, sizeof(payload));
+  init_request(&read, EEPROM_ADDR);
+  add_txn(&read, PIOS_I2C_TXN_WRITE, reg, sizeof(reg));
+  add_txn(&read, PIOS_I2C_TXN_READ, NULL, 3);
+
+  /* Both in one batch */
+  write.request.next = &read.request;
+  write.outstanding = read.outstanding = true;
+  i2c_adapter_submit(&adapter, &write.request, NULL);
+  run_bus();
+
+  EXPECT_EQ(1U, write.completions);
+  EXPECT_EQ(0, write.result);
+  EXPECT_EQ(1U, read.completions);
+  EXPECT_EQ(0, read.result);
+  EXPECT_EQ(0, memcmp(&payload[1], read.txns[1].buf, 3));
+  EXPECT_TRUE(read.guards_intact);
+
+  /* Two starts and a restart, no resets */
+  EXPECT_EQ(3U, hw.starts);
+  EXPECT_EQ(2U, hw.stops);
+  EXPECT_EQ(0U, hw.resets);
+  EXPECT_EQ(I2C_STATE_STOPPED, adapter.state);
+  EXPECT_EQ(0, hw.irqs);
+
+  EXPECT_EQ(2U, adapter.stats.requests);
+  EXPECT_EQ(8U, adapter.stats.bytes);
+  EXPECT_EQ(0, adapter.stats.queue_depth);
+  EXPECT_EQ(2, adapter.stats.max_queue_depth);
+}
+
+void I2CFsm::ReadsEveryLength() {
+  for (uint32_t len = 1; len <= MAX_LEN; len++) {
+    struct test_request t;
+    const uint8_t reg[] = { 0x20 };
+
+    init_request(&t, IMU_ADDR);
+    add_txn(&t, PIOS_I2C_TXN_WRITE, reg, sizeof(reg));
+    add_txn(&t, PIOS_I2C_TXN_READ, NULL, len);
+    submit(&t);
+    run_bus();
+
+    EXPECT_EQ(0, t.result) << "len " << len;
+    EXPECT_TRUE(t.guards_intact) << "len " << len;
+    for (uint32_t i = 0; i < len; i++)
+      EXPECT_EQ((0x20 + i) ^ 0x5a, t.txns[1].buf[i]) << "len " << len;
+  }
+  EXPECT_EQ(0U, hw.out_of_bounds);
+}
+
+TEST_F(I2CFsm, ReadsEveryLength) {
+  ReadsEveryLength();
+  EXPECT_EQ(0U, hw.dma_reads);
+}
+
+TEST_F(I2CFsm, ReadsEveryLengthByDMA) {
+  hw.dma = true;
+  ReadsEveryLength();
+
+  /* Single bytes stay on the interrupts */
+  EXPECT_EQ(MAX_LEN - 1U, hw.dma_reads);
+  EXPECT_FALSE(hw.dma_armed);
+  EXPECT_FALSE(adapter.dma_rx);
+}
+
+TEST_F(I2CFsm, ReadByDMAWithRestart) {
+  struct test_request t;
+  const uint8_t reg[] = { 0x30 };
+
+  hw.dma = true;
+  init_request(&t, IMU_ADDR);
+  add_txn(&t, PIOS_I2C_TXN_WRITE, reg, sizeof(reg));
+  add_txn(&t, PIOS_I2C_TXN_READ, NULL, 4);
+  add_txn(&t, PIOS_I2C_TXN_READ, NULL, 2);
+  submit(&t);
+  run_bus();
+
+  EXPECT_EQ(0, t.result);
+  EXPECT_TRUE(t.guards_intact);
+  for (uint32_t i = 0; i < 4; i++)
+    EXPECT_EQ((0x30 + i) ^ 0x5a, t.txns[1].buf[i]);
+  for (uint32_t i = 0; i < 2; i++)
+    EXPECT_EQ((0x34 + i) ^ 0x5a, t.txns[2].buf[i]);
+  EXPECT_EQ(2U, hw.dma_reads);
+  EXPECT_EQ(3U, hw.starts);
+  EXPECT_EQ(1U, hw.stops);
+  EXPECT_EQ(0U, hw.out_of_bounds);
+}
+
+TEST_F(I2CFsm, NackAndAbortReleaseDMA) {
+  struct test_request absent, present;
+
+  hw.dma = true;
+  init_request(&absent, ABSENT_ADDR);
+  add_txn(&absent, PIOS_I2C_TXN_READ, NULL, 4);
+  submit(&absent);
+  run_bus();
+
+  EXPECT_EQ(-3, absent.result);
+  EXPECT_FALSE(hw.dma_armed);
+  EXPECT_FALSE(adapter.dma_rx);
+
+  /* Time out with the read handed to the DMA */
+  init_request(&present, IMU_ADDR);
+  add_txn(&present, PIOS_I2C_TXN_READ, NULL, 4);
+  submit(&present);
+  dispatch(next_event());
+  dispatch(next_event());
+  EXPECT_EQ(HW_DMA_DONE, next_event());
+  EXPECT_TRUE(i2c_adapter_abort(&adapter, &present.request, NULL));
+
+  EXPECT_EQ(-2, present.result);
+  EXPECT_FALSE(hw.dma_armed);
+  EXPECT_FALSE(adapter.dma_rx);
+  EXPECT_TRUE(present.guards_intact);
+
+  /* A late interrupt from the stopped stream is dropped */
+  dispatch(HW_DMA_DONE);
+  EXPECT_EQ(I2C_STATE_STOPPED, adapter.state);
+  EXPECT_EQ(0U, adapter.stats.fsm_faults);
+}
+
+TEST_F(I2CFsm, NackCompletesAndQueueContinues) {
+  struct test_request absent, present;
+  const uint8_t reg[] = { 0x00 };
+
+  init_request(&absent, ABSENT_ADDR);
+  add_txn(&absent, PIOS_I2C_TXN_READ, NULL, 2);
+  init_request(&present, IMU_ADDR);
+  add_txn(&present, PIOS_I2C_TXN_WRITE, reg, sizeof(reg));
+  add_txn(&present, PIOS_I2C_TXN_READ, NULL, 2);
+
+  submit(&absent);
+  submit(&present);
+  run_bus();
+
+  EXPECT_EQ(-3, absent.result);
+  EXPECT_EQ(0, present.result);
+  EXPECT_EQ(1U, adapter.stats.nacks);
+  EXPECT_EQ(0U, adapter.stats.bus_errors);
+  EXPECT_EQ(3U, adapter.stats.bytes);
+  EXPECT_EQ(0U, hw.resets);
+}
+
+TEST_F(I2CFsm, BusErrorResetsBusAndQueueContinues) {
+  struct test_request first, second;
+  const uint8_t payload[] = { 0x00, 1, 2, 3, 4 };
+
+  init_request(&first, EEPROM_ADDR);
+  add_txn(&first, PIOS_I2C_TXN_WRITE, payload, sizeof(payload));
+  init_request(&second, EEPROM_ADDR);
+  add_txn(&second, PIOS_I2C_TXN_WRITE, payload, sizeof(payload));
+
+  submit(&first);
+  submit(&second);
+
+  /* Lose arbitration in the middle of the first write */
+  dispatch(next_event());
+  dispatch(next_event());
+  dispatch(next_event());
+  dispatch(HW_BUS_ERROR);
+
+  EXPECT_EQ(1U, first.completions);
+  EXPECT_EQ(-1, first.result);
+  EXPECT_EQ(1U, hw.resets);
+
+  /* The second request was started after the reset */
+  EXPECT_EQ(HW_STARTED, next_event());
+  run_bus();
+
+  EXPECT_EQ(0, second.result);
+  EXPECT_EQ(1U, adapter.stats.bus_errors);
+  EXPECT_EQ(0U, adapter.stats.fsm_faults);
+  EXPECT_EQ(5U, adapter.stats.bytes);
+}
+
+TEST_F(I2CFsm, UnexpectedEventIsFsmFault) {
+  struct test_request t;
+
+  init_request(&t, IMU_ADDR);
+  add_txn(&t, PIOS_I2C_TXN_READ, NULL, 4);
+  submit(&t);
+
+  /* A byte before the address was even sent */
+  dispatch(HW_BYTE_DONE);
+
+  EXPECT_EQ(-1, t.result);
+  EXPECT_EQ(1U, hw.resets);
+  EXPECT_EQ(1U, adapter.stats.fsm_faults);
+  EXPECT_EQ(1U, adapter.stats.bus_errors);
+  EXPECT_EQ(I2C_STATE_STOPPED, adapter.state);
+  EXPECT_TRUE(t.guards_intact);
+}
+
+TEST_F(I2CFsm, SpuriousEventsWhileIdle) {
+  dispatch(HW_STARTED);
+  dispatch(HW_ADDRESS_SENT);
+  dispatch(HW_BYTE_DONE);
+  dispatch(HW_NACK);
+
+  EXPECT_EQ(I2C_STATE_STOPPED, adapter.state);
+  EXPECT_EQ(0U, adapter.stats.requests);
+  EXPECT_EQ(0U, adapter.stats.bus_errors);
+  EXPECT_EQ(0U, hw.out_of_bounds);
+}
+
+TEST_F(I2CFsm, CallbackSubmitsNextRequest) {
+  struct test_request first, second;
+  const uint8_t reg[] = { 0x00 };
+
+  init_request(&first, IMU_ADDR);
+  add_txn(&first, PIOS_I2C_TXN_WRITE, reg, sizeof(reg));
+  add_txn(&first, PIOS_I2C_TXN_READ, NULL, 1);
+  init_request(&second, IMU_ADDR);
+  add_txn(&second, PIOS_I2C_TXN_WRITE, reg, sizeof(reg));
+  add_txn(&second, PIOS_I2C_TXN_READ, NULL, 6);
+
+  first.chain = &second;
+  second.outstanding = true;
+  submit(&first);
+  run_bus();
+
+  EXPECT_EQ(0, first.result);
+  EXPECT_EQ(1U, second.completions);
+  EXPECT_EQ(0, second.result);
+  EXPECT_EQ(2U, adapter.stats.requests);
+  EXPECT_EQ(1, adapter.stats.max_queue_depth);
+}
+
+TEST_F(I2CFsm, AbortQueuedAndActive) {
+  struct test_request a, b, c;
+  const uint8_t payload[] = { 0x00, 1 };
+
+  init_request(&a, EEPROM_ADDR);
+  add_txn(&a, PIOS_I2C_TXN_WRITE, payload, sizeof(payload));
+  init_request(&b, EEPROM_ADDR);
+  add_txn(&b, PIOS_I2C_TXN_WRITE, payload, sizeof(payload));
+  init_request(&c, EEPROM_ADDR);
+  add_txn(&c, PIOS_I2C_TXN_WRITE, payload, sizeof(payload));
+
+  submit(&a);
+  submit(&b);
+  submit(&c);
+  dispatch(next_event());
+
+  /* A queued request is dropped without touching the bus */
+  EXPECT_TRUE(i2c_adapter_abort(&adapter, &c.request, NULL));
+  EXPECT_EQ(-2, c.result);
+  EXPECT_EQ(0U, hw.resets);
+
+  /* The active one resets the bus and the next one starts */
+  EXPECT_TRUE(i2c_adapter_abort(&adapter, &a.request, NULL));
+  EXPECT_EQ(-2, a.result);
+  EXPECT_EQ(1U, hw.resets);
+  EXPECT_EQ(HW_STARTED, next_event());
+  run_bus();
+  EXPECT_EQ(0, b.result);
+
+  /* Too late */
+  EXPECT_FALSE(i2c_adapter_abort(&adapter, &a.request, NULL));
+
+  EXPECT_EQ(1U, a.completions);
+  EXPECT_EQ(1U, c.completions);
+  EXPECT_EQ(2U, adapter.stats.timeouts);
+  EXPECT_EQ(0, adapter.stats.queue_depth);
+}
+
+/* Random batches against a bus that misbehaves: lost, spurious and
+ * reordered events, NACKs, bus errors and timeouts */
+void I2CFsm::FuzzRandomEvents() {
+  static struct test_request pool[16];
+  static const uint16_t addrs[] = { EEPROM_ADDR, IMU_ADDR, ABSENT_ADDR };
+  uint32_t submitted = 0;
+
+  srand(42);
+  memset(pool, 0, sizeof(pool));
+
+  for (uint32_t iter = 0; iter < 200000; iter++) {
+    uint32_t action = rand() % 100;
+
+    if (action < 10) {
+      /* Submit a batch of whatever requests are free */
+      struct pios_i2c_request *head = NULL, **tail = &head;
+      uint32_t batch = 1 + rand() % 3;
+
+      for (uint32_t i = 0; i < NELEMENTS(pool) && batch > 0; i++) {
+        struct test_request *t = &pool[i];
+        if (t->outstanding)
+          continue;
+
+        init_request(t, addrs[rand() % NELEMENTS(addrs)]);
+        uint32_t num_txns = 1 + rand() % MAX_TXNS;
+        for (uint32_t j = 0; j < num_txns; j++) {
+          uint8_t data[MAX_LEN];
+          for (uint32_t k = 0; k < MAX_LEN; k++)
+            data[k] = rand();
+          add_txn(t, (rand() & 1) ? PIOS_I2C_TXN_READ : PIOS_I2C_TXN_WRITE, data, 1 + rand() % MAX_LEN);
+        }
+
+        t->outstanding = true;
+        t->seq = next_seq++;
+        *tail = &t->request;
+        tail = &t->request.next;
+        batch--;
+        submitted++;
+      }
+      if (head)
+        i2c_adapter_submit(&adapter, head, NULL);
+    } else if (action < 12) {
+      /* Time out a random request */
+      i2c_adapter_abort(&adapter, &pool[rand() % NELEMENTS(pool)].request, NULL);
+    } else if (action < 75) {
+      dispatch(next_event());
+    } else {
+      dispatch((enum hw_event)(HW_STARTED + rand() % (HW_BUS_ERROR - HW_STARTED + 1)));
+    }
+
+    ASSERT_LT(adapter.state, I2C_STATE_NUM_STATES);
+    ASSERT_EQ(0U, hw.out_of_bounds) << "iteration " << iter;
+    if (adapter.state == I2C_STATE_STOPPED) {
+      ASSERT_TRUE(adapter.active_request == NULL) << "iteration " << iter;
+      ASSERT_TRUE(adapter.queue_head == NULL) << "iteration " << iter;
+      ASSERT_FALSE(hw.dma_armed) << "iteration " << iter;
+    }
+
+    uint32_t outstanding = 0;
+    for (uint32_t i = 0; i < NELEMENTS(pool); i++)
+      outstanding += pool[i].outstanding;
+    ASSERT_EQ(outstanding, adapter.stats.queue_depth) << "iteration " << iter;
+    ASSERT_EQ(submitted - outstanding, completions) << "iteration " << iter;
+  }
+
+  /* Let the bus behave and time out anything stuck on a lost event */
+  for (uint32_t i = 0; i < NELEMENTS(pool); i++) {
+    run_bus();
+    if (adapter.active_request)
+      i2c_adapter_abort(&adapter, adapter.active_request, NULL);
+  }
+  run_bus();
+
+  for (uint32_t i = 0; i < NELEMENTS(pool); i++)
+    EXPECT_FALSE(pool[i].outstanding);
+
+  EXPECT_EQ(submitted, completions);
+  EXPECT_EQ(0U, extra_completions);
+  EXPECT_EQ(0U, guard_failures);
+  EXPECT_EQ(0U, bad_results);
+  EXPECT_EQ(submitted, adapter.stats.requests);
+  EXPECT_FALSE(out_of_order);
+  EXPECT_EQ(I2C_STATE_STOPPED, adapter.state);
+  EXPECT_EQ(0, adapter.stats.queue_depth);
+  EXPECT_GT(adapter.stats.bytes, 0U);
+  EXPECT_GT(adapter.stats.fsm_faults, 0U);
+}
+
+TEST_F(I2CFsm, FuzzRandomEvents) {
+  FuzzRandomEvents();
+}
+
+TEST_F(I2CFsm, FuzzRandomEventsWithDMA) {
+  hw.dma = true;
+  FuzzRandomEvents();
+  EXPECT_GT(hw.dma_reads, 0U);
+}
@@ -0,0 +1,379 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "insgps.h"		/* API for the INS */
+
+}
+
+#include <math.h>		/* fabs() */
+
+#define GRAVITY_MS2 9.81f
+
+// To use a test fixture, derive a class from testing::Test.
+class InsGps : public testing::Test {
+protected:
+  virtual void SetUp() {
+    INSGPSInit();
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+// Test fixture for INSCompensateDelay()
+class CompensateDelay : public InsGps {
+};
+
+// A level vehicle moving north at 2 m/s
+static void fly_north(float seconds, float dT)
+{
+  const float zeros[3] = {0, 0, 0};
+  const float vel[3] = {2.0f, 0, 0};
+  const float q[4] = {1, 0, 0, 0};
+  const float gyros[3] = {0, 0, 0};
+  const float accels[3] = {0, 0, -GRAVITY_MS2};
+
+  INSSetState(zeros, vel, q, zeros, zeros);
+  for (float t = 0; t < seconds; t += dT)
+    INSStatePrediction(gyros, accels, dT);
+}
+
+TEST_F(CompensateDelay, NoHistory) {
+  float pos[3] = {1.0f, 2.0f, 3.0f};
+
+  INSCompensateDelay(0.1f, pos, NULL);
+
+  EXPECT_EQ(1.0f, pos[0]);
+  EXPECT_EQ(2.0f, pos[1]);
+  EXPECT_EQ(3.0f, pos[2]);
+}
+
+TEST_F(CompensateDelay, ConstantVelocity) {
+  float pos[3] = {0, 0, 0};
+  float vel[3] = {2.0f, 0, 0};
+
+  fly_north(1.0f, 0.002f);
+
+  INSCompensateDelay(0.1f, pos, vel);
+
+  // Moved 0.2 m since the measurement was taken
+  EXPECT_NEAR(0.2f, pos[0], 1e-3);
+  EXPECT_NEAR(0.0f, pos[1], 1e-3);
+  EXPECT_NEAR(0.0f, pos[2], 1e-3);
+
+  // At a constant velocity
+  EXPECT_NEAR(2.0f, vel[0], 1e-3);
+  EXPECT_NEAR(0.0f, vel[1], 1e-3);
+  EXPECT_NEAR(0.0f, vel[2], 1e-3);
+}
+
+TEST_F(CompensateDelay, BetweenSnapshots) {
+  float pos[3] = {0, 0, 0};
+
+  fly_north(1.0f, 0.002f);
+
+  // Snapshots are taken every 5 ms, the position is interpolated
+  INSCompensateDelay(0.0125f, pos, NULL);
+  EXPECT_NEAR(0.025f, pos[0], 1e-3);
+}
+
+TEST_F(CompensateDelay, BeyondHistory) {
+  float pos[3] = {0, 0, 0};
+
+  fly_north(1.0f, 0.002f);
+
+  // The history covers 64 * 5 ms, older measurements use the oldest snapshot
+  INSCompensateDelay(0.5f, pos, NULL);
+  EXPECT_NEAR(0.64f, pos[0], 0.02f);
+}
+
+TEST_F(CompensateDelay, ResetByState) {
+  float pos[3] = {0, 0, 0};
+  const float zeros[3] = {0, 0, 0};
+  const float q[4] = {1, 0, 0, 0};
+
+  fly_north(1.0f, 0.002f);
+  INSSetState(zeros, zeros, q, zeros, zeros);
+
+  INSCompensateDelay(0.1f, pos, NULL);
+  EXPECT_EQ(0.0f, pos[0]);
+}
+
+/*
+ * Closed loop runs of the filter against a simulated flight: a circle of
+ * 20 m radius while rocking in roll, pitch and yaw. The IMU runs at 500 Hz,
+ * the mag at 100 Hz, the baro at 50 Hz and the GPS at 5 Hz with 100 ms of
+ * latency.
+ */
+class Simulation : public InsGps {
+protected:
+  struct result {
+    double attitude_rms;	// deg
+    double position_rms;	// m
+    double predict_us;		// CPU time of the predictions per IMU sample
+  };
+
+  static void truth(double t, double pos[3], double vel[3], double accel[3]) {
+    const double r = 20, w = 0.2;
+
+    pos[0] = r * cos(w * t);
+    pos[1] = r * sin(w * t);
+    pos[2] = -10 - 2 * sin(0.1 * t);
+    vel[0] = -r * w * sin(w * t);
+    vel[1] = r * w * cos(w * t);
+    vel[2] = -0.2 * cos(0.1 * t);
+    accel[0] = -r * w * w * cos(w * t);
+    accel[1] = -r * w * w * sin(w * t);
+    accel[2] = 0.02 * sin(0.1 * t);
+  }
+
+  static void rates(double t, double w[3]) {
+    w[0] = 0.5 * sin(0.7 * t);
+    w[1] = 0.5 * sin(0.5 * t + 1);
+    w[2] = 0.3 * sin(0.3 * t);
+  }
+
+  // Rotate an earth frame vector into the body frame
+  static void rotate_eb(const double q[4], const double e[3], double b[3]) {
+    const double q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+
+    b[0] = (q0*q0 + q1*q1 - q2*q2 - q3*q3) * e[0] + 2 * (q1*q2 + q0*q3) * e[1] + 2 * (q1*q3 - q0*q2) * e[2];
+    b[1] = 2 * (q1*q2 - q0*q3) * e[0] + (q0*q0 - q1*q1 + q2*q2 - q3*q3) * e[1] + 2 * (q2*q3 + q0*q1) * e[2];
+    b[2] = 2 * (q1*q3 + q0*q2) * e[0] + 2 * (q2*q3 - q0*q1) * e[1] + (q0*q0 - q1*q1 - q2*q2 + q3*q3) * e[2];
+  }
+
+  static void integrate(double q[4], const double w[3], double dT) {
+    double dq[4];
+
+    dq[0] = (-q[1] * w[0] - q[2] * w[1] - q[3] * w[2]) / 2;
+    dq[1] = (q[0] * w[0] - q[3] * w[1] + q[2] * w[2]) / 2;
+    dq[2] = (q[3] * w[0] + q[0] * w[1] - q[1] * w[2]) / 2;
+    dq[3] = (-q[2] * w[0] + q[1] * w[1] + q[0] * w[2]) / 2;
+
+    double norm = 0;
+    for (int i = 0; i < 4; i++) {
+      q[i] += dq[i] * dT;
+      norm += q[i] * q[i];
+    }
+    norm = sqrt(norm);
+    for (int i = 0; i < 4; i++)
+      q[i] /= norm;
+  }
+
+  // Deterministic gaussian noise
+  double noise(double sigma) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    double u1 = ((seed >> 11) + 1.0) / 9007199254740993.0;
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    double u2 = (seed >> 11) / 9007199254740992.0;
+    return sigma * sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+  }
+
+  static double cpu_us() {
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+  }
+
+  struct result run(int covariance_decimation, bool compensate_delay) {
+    const double imu_dT = 0.002, duration = 60, settle = 10, gps_delay = 0.1;
+    const int substeps = 10;
+    const float zeros[3] = {0, 0, 0};
+    const float Be[3] = {0.4f, 0.05f, 0.9f};
+    const float accel_var[3] = {0.01f, 0.01f, 0.01f};
+    const float gyro_var[3] = {1e-5f, 1e-5f, 1e-4f};
+    const float mag_var[3] = {0.005f, 0.005f, 10.0f};
+    const float Pdiag[13] = {25.0f,25.0f,25.0f,5.0f,5.0f,5.0f,1e-5f,1e-5f,1e-5f,1e-5f,1e-5f,1e-5f,1e-5f};
+
+    double q[4] = {1, 0, 0, 0};
+    double pos[3], vel[3], accel[3], w[3];
+    double gps_pos[3] = {0, 0, 0}, gps_vel[3] = {0, 0, 0};
+    double gps_time = 0;
+    bool gps_pending = false;
+
+    double attitude_sq = 0, position_sq = 0, predict_us = 0;
+    int samples = 0, imu_samples = 0;
+
+    seed = 1;
+
+    INSGPSInit();
+    INSSetMagVar(mag_var);
+    INSSetAccelVar(accel_var);
+    INSSetGyroVar(gyro_var);
+    INSSetBaroVar(0.1f);
+    INSSetPosVelVar(0.3f, 0.01f, 10.0f);
+    INSSetMagNorth(Be);
+    INSResetP(Pdiag);
+
+    truth(0, pos, vel, accel);
+    float pos0[3] = {(float) pos[0], (float) pos[1], (float) pos[2]};
+    float vel0[3] = {(float) vel[0], (float) vel[1], (float) vel[2]};
+    float q0[4] = {1, 0, 0, 0};
+    INSSetState(pos0, vel0, q0, zeros, zeros);
+
+    float cov_dT = 0;
+    int cov_steps = 0;
+
+    for (int step = 1; step * imu_dT <= duration; step++) {
+      double t = step * imu_dT;
+
+      // Advance the true attitude, the IMU measures the average rate
+      double w_avg[3] = {0, 0, 0};
+      for (int i = 0; i < substeps; i++) {
+        double ts = t - imu_dT + (i + 0.5) * imu_dT / substeps;
+        rates(ts, w);
+        integrate(q, w, imu_dT / substeps);
+        for (int j = 0; j < 3; j++)
+          w_avg[j] += w[j] / substeps;
+      }
+      truth(t, pos, vel, accel);
+
+      double specific_force_e[3] = {accel[0], accel[1], accel[2] - GRAVITY_MS2};
+      double specific_force_b[3];
+      rotate_eb(q, specific_force_e, specific_force_b);
+
+      float gyros[3], accels[3];
+      for (int i = 0; i < 3; i++) {
+        gyros[i] = w_avg[i] + noise(0.002);
+        accels[i] = specific_force_b[i] + noise(0.05);
+      }
+
+      uint16_t sensors = 0;
+      float mag[3] = {0, 0, 0}, gps_ned[3] = {0, 0, 0}, gps_v[3] = {0, 0, 0}, baro = 0;
+
+      if (step % 5 == 0) {
+        double Be_e[3] = {Be[0], Be[1], Be[2]}, Be_b[3];
+        rotate_eb(q, Be_e, Be_b);
+        for (int i = 0; i < 3; i++)
+          mag[i] = Be_b[i] + noise(0.005);
+        sensors |= MAG_SENSORS;
+      }
+
+      if (step % 10 == 0) {
+        baro = -pos[2] + noise(0.3);
+        sensors |= BARO_SENSOR;
+      }
+
+      // Sample the GPS, it reports the sample after the latency
+      if (step % 100 == 0) {
+        for (int i = 0; i < 3; i++) {
+          gps_pos[i] = pos[i] + noise(0.3);
+          gps_vel[i] = vel[i] + noise(0.05);
+        }
+        gps_time = t + gps_delay;
+        gps_pending = true;
+      }
+      if (gps_pending && t >= gps_time - imu_dT / 2) {
+        for (int i = 0; i < 3; i++) {
+          gps_ned[i] = gps_pos[i];
+          gps_v[i] = gps_vel[i];
+        }
+        sensors |= HORIZ_POS_SENSORS | HORIZ_VEL_SENSORS | VERT_VEL_SENSORS;
+        gps_pending = false;
+      }
+
+      double start = cpu_us();
+      INSStatePrediction(gyros, accels, imu_dT);
+      cov_dT += imu_dT;
+      if (sensors || ++cov_steps >= covariance_decimation) {
+        INSCovariancePrediction(cov_dT);
+        cov_dT = 0;
+        cov_steps = 0;
+      }
+      predict_us += cpu_us() - start;
+      imu_samples++;
+
+      if ((sensors & HORIZ_POS_SENSORS) && compensate_delay)
+        INSCompensateDelay(gps_delay, gps_ned, gps_v);
+
+      if (sensors)
+        INSCorrection(mag, gps_ned, gps_v, baro, sensors);
+
+      if (t < settle)
+        continue;
+
+      float est_pos[3], est_vel[3], est_q[4];
+      INSGetState(est_pos, est_vel, est_q, NULL);
+
+      double dot = fabs(est_q[0] * q[0] + est_q[1] * q[1] + est_q[2] * q[2] + est_q[3] * q[3]);
+      double angle = 2 * acos(dot > 1 ? 1 : dot) * 180 / M_PI;
+      attitude_sq += angle * angle;
+      position_sq += (est_pos[0] - pos[0]) * (est_pos[0] - pos[0]) + (est_pos[1] - pos[1]) * (est_pos[1] - pos[1]);
+      samples++;
+    }
+
+    struct result r;
+    r.attitude_rms = sqrt(attitude_sq / samples);
+    r.position_rms = sqrt(position_sq / samples);
+    r.predict_us = predict_us / imu_samples;
+
+    printf("covariance every %d samples, delay compensation %s: attitude %.3f deg, position %.3f m rms, prediction %.2f us/sample\n",
+      covariance_decimation, compensate_delay ? "on " : "off", r.attitude_rms, r.position_rms, r.predict_us);
+
+    return r;
+  }
+
+  uint64_t seed;
+};
+
+TEST_F(Simulation, CovarianceDecimation) {
+  struct result full = run(1, false);
+  struct result half = run(2, false);
+  struct result quarter = run(4, false);
+
+  EXPECT_LT(full.attitude_rms, 2.0);
+
+  // Covariance at a lower rate should barely change the estimate
+  EXPECT_LT(half.attitude_rms, full.attitude_rms * 1.25 + 0.1);
+  EXPECT_LT(quarter.attitude_rms, full.attitude_rms * 1.5 + 0.1);
+  EXPECT_LT(quarter.position_rms, full.position_rms * 1.5 + 0.1);
+}
+
+TEST_F(Simulation, DelayCompensation) {
+  struct result delayed = run(1, false);
+  struct result compensated = run(1, true);
+
+  EXPECT_LT(compensated.position_rms, delayed.position_rms);
+  EXPECT_LT(compensated.attitude_rms, delayed.attitude_rms * 1.1);
+
+  run(4, true);
+}
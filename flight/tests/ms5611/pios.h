@@ -0,0 +1,53 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+/* C Lib Includes */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+#include <pios_i2c.h>
+#include <pios_ms5611.h>
+
+#define PIOS_malloc(size) malloc(size)
+#define PIOS_free(buf) free(buf)
+#define pvPortMalloc(size) malloc(size)
+#define vPortFree(buf) free(buf)
+
+#define PIOS_IRQ_Disable()
+#define PIOS_IRQ_Enable()
+
+/* Just enough of FreeRTOS and pios_sensors.h for the baro output queue */
+typedef void * xQueueHandle;
+
+struct pios_sensor_baro_data {
+	float temperature;
+	float pressure;
+	float altitude;
+};
+
+enum pios_sensor_type {
+	PIOS_SENSOR_BARO,
+};
+
+/* Provided by the unit test */
+extern xQueueHandle xQueueCreate(uint32_t length, uint32_t item_size);
+extern int32_t xQueueSend(xQueueHandle queue, const void *item, uint32_t ticks);
+extern int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, xQueueHandle queue);
+extern uint32_t PIOS_DELAY_GetuS();
+extern int32_t PIOS_DELAY_WaituS(uint32_t uS);
+extern int32_t PIOS_DELAY_WaitmS(uint32_t mS);
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#endif /* PIOS_H */
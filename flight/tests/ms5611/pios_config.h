@@ -0,0 +1,2 @@
+#define PIOS_INCLUDE_MS5611
+#define PIOS_INCLUDE_I2C
@@ -0,0 +1,560 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <vector>
+#include <deque>
+
+extern "C" {
+
+#include "pios.h"
+#include "pios_ms5611_priv.h"
+#include "pios_sensor_bus.h"
+
+}
+
+/* 400kHz I2C, nine clocks per byte with the ack, plus the address byte */
+#define I2C_BYTE_US		23
+#define MS5611_ADDR		0x77
+#define MAG_ADDR		0x1E
+#define MAG_PERIOD_US		13333
+#define RTOS_TICK_US		1000
+
+/* Bus time of one conversion cycle: ADC read then the next start */
+#define CYCLE_OVERHEAD_US	((2 + 4 + 2) * I2C_BYTE_US)
+/* The ADC read command that precedes reading the result */
+#define ADC_COMMAND_US		(2U * I2C_BYTE_US)
+/* One magnetometer register read */
+#define MAG_TRANSFER_US		(9U * I2C_BYTE_US)
+
+/* The example conversion from the MS5611 datasheet */
+static const uint16_t datasheet_prom[6] = { 40127, 36924, 23317, 23282, 33464, 28312 };
+#define DATASHEET_D1		9085466
+#define DATASHEET_D2		8569150
+
+/* Fakes for the services the driver takes from the rest of PiOS */
+static uint32_t fake_time_us;
+static int fake_queue;
+
+struct baro_sample {
+  uint32_t time_us;
+  struct pios_sensor_baro_data data;
+};
+static std::vector<struct baro_sample> samples;
+
+extern "C" uint32_t PIOS_DELAY_GetuS()
+{
+  return fake_time_us;
+}
+
+extern "C" int32_t PIOS_DELAY_WaituS(uint32_t uS)
+{
+  fake_time_us += uS;
+  return 0;
+}
+
+extern "C" int32_t PIOS_DELAY_WaitmS(uint32_t mS)
+{
+  fake_time_us += mS * 1000;
+  return 0;
+}
+
+extern "C" xQueueHandle xQueueCreate(uint32_t /* length */, uint32_t /* item_size */)
+{
+  return &fake_queue;
+}
+
+extern "C" int32_t xQueueSend(xQueueHandle /* queue */, const void *item, uint32_t /* ticks */)
+{
+  struct baro_sample sample;
+  sample.time_us = fake_time_us;
+  memcpy(&sample.data, item, sizeof(sample.data));
+  samples.push_back(sample);
+  return 1;
+}
+
+extern "C" int32_t PIOS_SENSORS_Register(enum pios_sensor_type /* type */, xQueueHandle /* queue */)
+{
+  return 0;
+}
+
+/* The simulated bus, an MS5611 and a magnetometer on it */
+static struct {
+  uint32_t busy_us;
+
+  uint8_t command;
+  bool converting;
+  bool pressure;
+  uint8_t osr;
+  uint32_t ready_us;
+  bool first_was_temperature;
+
+  uint32_t temperature_conversions;
+  uint32_t pressure_conversions;
+  uint32_t early_reads;
+  uint32_t overlapping_starts;
+  uint32_t max_read_latency_us;
+
+  uint32_t mag_transfers;
+  uint32_t mag_transfers_in_window;
+
+  uint32_t baro_transfers;
+  uint32_t batches;
+  uint32_t batched_requests;
+  uint32_t aborts;
+  bool stalled;
+} sim;
+
+static uint32_t conversion_us(uint8_t osr)
+{
+  /* Maximum conversion times from the datasheet */
+  static const uint32_t times[] = { 600, 1170, 2280, 4540, 9040 };
+  return times[osr / 2];
+}
+
+static void ms5611_command(uint8_t command)
+{
+  sim.command = command;
+
+  if ((command & 0xE0) != 0x40)
+    return;
+
+  if (sim.converting && (int32_t)(fake_time_us - sim.ready_us) < 0)
+    sim.overlapping_starts++;
+
+  sim.converting = true;
+  sim.pressure = (command & 0xF0) == 0x40;
+  sim.osr = command & 0x0F;
+  sim.ready_us = fake_time_us + conversion_us(sim.osr);
+
+  if (sim.temperature_conversions + sim.pressure_conversions == 0)
+    sim.first_was_temperature = !sim.pressure;
+
+  if (sim.pressure)
+    sim.pressure_conversions++;
+  else
+    sim.temperature_conversions++;
+}
+
+static void ms5611_read(uint8_t *buf, uint32_t len)
+{
+  uint32_t value = 0;
+
+  if (sim.command >= 0xA0 && sim.command <= 0xAE) {
+    /* Word 0 is reserved for the factory */
+    if (sim.command >= 0xA2)
+      value = datasheet_prom[(sim.command - 0xA2) / 2];
+  } else if (sim.command == 0x00) {
+    /* The ADC reads back 0 until the conversion is complete */
+    if (!sim.converting || (int32_t)(fake_time_us - sim.ready_us) < 0) {
+      sim.early_reads++;
+    } else {
+      uint32_t latency = fake_time_us - sim.ready_us;
+      if (latency > sim.max_read_latency_us)
+        sim.max_read_latency_us = latency;
+      value = sim.pressure ? DATASHEET_D1 : DATASHEET_D2;
+    }
+    sim.converting = false;
+  }
+
+  for (uint32_t i = 0; i < len; i++)
+    buf[i] = value >> (8 * (len - 1 - i));
+}
+
+/* Run transactions on the bus from the current time */
+static void i2c_run(const struct pios_i2c_txn txn_list[], uint32_t num_txns)
+{
+  for (uint32_t i = 0; i < num_txns; i++) {
+    const struct pios_i2c_txn *txn = &txn_list[i];
+    uint32_t duration_us = (1 + txn->len) * I2C_BYTE_US;
+
+    if (txn->addr == MAG_ADDR && i == 0) {
+      sim.mag_transfers++;
+      if (sim.converting)
+        sim.mag_transfers_in_window++;
+    }
+
+    if (txn->rw == PIOS_I2C_TXN_READ) {
+      if (txn->addr == MS5611_ADDR)
+        ms5611_read(txn->buf, txn->len);
+      else
+        memset(txn->buf, 0, txn->len);
+      fake_time_us += duration_us;
+    } else {
+      /* Commands take effect once the byte is on the wire */
+      fake_time_us += duration_us;
+      if (txn->addr == MS5611_ADDR)
+        ms5611_command(txn->buf[0]);
+    }
+
+    sim.busy_us += duration_us;
+  }
+}
+
+static uint32_t i2c_duration_us(const struct pios_i2c_request *request)
+{
+  uint32_t duration_us = 0;
+  for (uint32_t i = 0; i < request->num_txns; i++)
+    duration_us += (1 + request->txn_list[i].len) * I2C_BYTE_US;
+  return duration_us;
+}
+
+/* The adapter queue, requests run back to back from when they are queued */
+struct queued_request {
+  struct pios_i2c_request *request;
+  uint32_t queued_us;
+};
+static std::deque<struct queued_request> i2c_queue;
+static uint32_t i2c_free_us;
+
+static uint32_t i2c_next_start_us()
+{
+  uint32_t start_us = i2c_queue.front().queued_us;
+  if ((int32_t)(i2c_free_us - start_us) > 0)
+    start_us = i2c_free_us;
+  if ((int32_t)(fake_time_us - start_us) > 0)
+    start_us = fake_time_us;
+  return start_us;
+}
+
+/* When the request at the head of the queue completes */
+static uint32_t i2c_next_done_us()
+{
+  return i2c_next_start_us() + i2c_duration_us(i2c_queue.front().request);
+}
+
+/* Run the request at the head of the queue, as the I2C interrupt would */
+static void i2c_complete_next()
+{
+  struct pios_i2c_request *request = i2c_queue.front().request;
+
+  fake_time_us = i2c_next_start_us();
+  i2c_queue.pop_front();
+  request->next = NULL;
+
+  i2c_run(request->txn_list, request->num_txns);
+  i2c_free_us = fake_time_us;
+
+  bool woken = false;
+  request->callback(request, 0, &woken);
+}
+
+extern "C" int32_t PIOS_I2C_Transfer(uint32_t /* i2c_id */, const struct pios_i2c_txn txn_list[], uint32_t num_txns)
+{
+  if (txn_list[0].addr == MS5611_ADDR)
+    sim.baro_transfers++;
+
+  /* Goes on the bus after the requests queued before it */
+  while (!i2c_queue.empty())
+    i2c_complete_next();
+
+  if ((int32_t)(i2c_free_us - fake_time_us) > 0)
+    fake_time_us = i2c_free_us;
+
+  i2c_run(txn_list, num_txns);
+  i2c_free_us = fake_time_us;
+
+  return 0;
+}
+
+extern "C" int32_t PIOS_I2C_Submit(uint32_t /* i2c_id */, struct pios_i2c_request *request)
+{
+  sim.batches++;
+
+  for (; request != NULL; request = request->next) {
+    struct queued_request queued = { request, fake_time_us };
+    i2c_queue.push_back(queued);
+    sim.batched_requests++;
+  }
+
+  return 0;
+}
+
+extern "C" int32_t PIOS_I2C_Abort(uint32_t /* i2c_id */, struct pios_i2c_request *request)
+{
+  for (std::deque<struct queued_request>::iterator it = i2c_queue.begin(); it != i2c_queue.end(); ++it) {
+    if (it->request != request)
+      continue;
+
+    i2c_queue.erase(it);
+    sim.aborts++;
+
+    bool woken = false;
+    request->callback(request, -2, &woken);
+    return 0;
+  }
+
+  return -1;
+}
+
+/* Stands in for the HMC5883 in single measurement mode */
+static uint32_t fake_mag_job(void * /* ctx */)
+{
+  uint8_t reg = 0x03;
+  uint8_t data[6];
+
+  const struct pios_i2c_txn txn_list[] = {
+    { "mag", MAG_ADDR, PIOS_I2C_TXN_WRITE, sizeof(reg), &reg },
+    { "mag", MAG_ADDR, PIOS_I2C_TXN_READ, sizeof(data), data },
+  };
+  PIOS_I2C_Transfer(0, txn_list, NELEMENTS(txn_list));
+
+  return MAG_PERIOD_US;
+}
+
+class MS5611Test : public testing::Test {
+protected:
+  virtual void SetUp() {
+    fake_time_us = 12345;
+    memset(&sim, 0, sizeof(sim));
+    samples.clear();
+    i2c_queue.clear();
+    i2c_free_us = fake_time_us;
+
+    /* Buses persist for the life of the program, so every test gets its own */
+    static uint32_t last_i2c_id;
+    i2c_id = ++last_i2c_id;
+    bus = PIOS_SENSOR_BUS_Get(i2c_id);
+    ASSERT_TRUE(bus != NULL);
+  }
+
+  void init(enum pios_ms5611_osr oversampling, uint32_t interleaving) {
+    cfg.oversampling = oversampling;
+    cfg.temperature_interleaving = interleaving;
+    ASSERT_EQ(0, PIOS_MS5611_Init(&cfg, i2c_id));
+    ASSERT_EQ(0U, sim.temperature_conversions + sim.pressure_conversions);
+    clear_stats();
+  }
+
+  void clear_stats() {
+    sim.busy_us = 0;
+    sim.temperature_conversions = 0;
+    sim.pressure_conversions = 0;
+    sim.max_read_latency_us = 0;
+    sim.mag_transfers = 0;
+    sim.mag_transfers_in_window = 0;
+    sim.baro_transfers = 0;
+    sim.batches = 0;
+    sim.batched_requests = 0;
+    sim.aborts = 0;
+    samples.clear();
+  }
+
+  /* Run the bus the way its task does. With a tick the task only wakes on
+   * tick boundaries, otherwise it wakes exactly at the next deadline. A
+   * completed request wakes it at once. */
+  void run_bus(uint32_t duration_us, uint32_t tick_us) {
+    uint32_t end_us = fake_time_us + duration_us;
+
+    while ((int32_t)(end_us - fake_time_us) > 0) {
+      uint32_t wait_us = PIOS_SENSOR_BUS_Run(bus);
+      ASSERT_NE((uint32_t)PIOS_SENSOR_BUS_IDLE, wait_us);
+      ASSERT_GT(wait_us, 0U);
+
+      uint32_t wake_us;
+      if (tick_us == 0)
+        wake_us = fake_time_us + wait_us;
+      else
+        wake_us = (fake_time_us / tick_us + wait_us / tick_us + 1) * tick_us;
+
+      if (!i2c_queue.empty() && !sim.stalled &&
+          (int32_t)(wake_us - i2c_next_done_us()) >= 0) {
+        i2c_complete_next();
+        continue;
+      }
+
+      fake_time_us = wake_us;
+    }
+  }
+
+  struct pios_ms5611_cfg cfg;
+  uint32_t i2c_id;
+  struct pios_sensor_bus *bus;
+};
+
+TEST_F(MS5611Test, DatasheetExample) {
+  init(MS5611_OSR_4096, 1);
+  run_bus(100000, 0);
+
+  ASSERT_GT(samples.size(), 0U);
+  EXPECT_TRUE(sim.first_was_temperature);
+
+  /* TEMP = 2007 (20.07 C), P = 100009 (1000.09 mbar) */
+  EXPECT_NEAR(20.07f, samples.back().data.temperature, 0.001f);
+  EXPECT_NEAR(100.009f, samples.back().data.pressure, 0.0005f);
+  EXPECT_GT(samples.back().data.altitude, 0.0f);
+}
+
+TEST_F(MS5611Test, NeverReadsBeforeConversionEnds) {
+  const enum pios_ms5611_osr osrs[] = {
+    MS5611_OSR_256, MS5611_OSR_4096, MS5611_OSR_512, MS5611_OSR_2048, MS5611_OSR_1024,
+  };
+
+  init(MS5611_OSR_256, 3);
+
+  for (uint32_t i = 0; i < NELEMENTS(osrs); i++) {
+    EXPECT_EQ(0, PIOS_MS5611_SetOversampling(osrs[i]));
+    run_bus(200000, RTOS_TICK_US);
+  }
+
+  EXPECT_EQ(0U, sim.early_reads);
+  EXPECT_EQ(0U, sim.overlapping_starts);
+
+  /* Waking on the tick costs at most one tick per conversion */
+  EXPECT_LE(sim.max_read_latency_us, RTOS_TICK_US + ADC_COMMAND_US);
+}
+
+TEST_F(MS5611Test, SampleRateFollowsOversampling) {
+  init(MS5611_OSR_1024, 4);
+
+  /* Every fourth pressure conversion is followed by a temperature one */
+  run_bus(1000000, 0);
+  float expected = 1e6f * 4 / (5 * (conversion_us(MS5611_OSR_1024) + CYCLE_OVERHEAD_US));
+  EXPECT_NEAR(expected, samples.size(), 2);
+  EXPECT_EQ(ADC_COMMAND_US, sim.max_read_latency_us);
+
+  EXPECT_EQ(-1, PIOS_MS5611_SetOversampling((enum pios_ms5611_osr) 3));
+  EXPECT_EQ(0, PIOS_MS5611_SetOversampling(MS5611_OSR_4096));
+
+  /* The conversion in flight completes with the rate it was started at */
+  run_bus(conversion_us(MS5611_OSR_1024) + CYCLE_OVERHEAD_US, 0);
+  EXPECT_EQ(MS5611_OSR_4096, sim.osr);
+  EXPECT_EQ(0U, sim.early_reads);
+
+  clear_stats();
+  run_bus(1000000, 0);
+  expected = 1e6f * 4 / (5 * (conversion_us(MS5611_OSR_4096) + CYCLE_OVERHEAD_US));
+  EXPECT_NEAR(expected, samples.size(), 2);
+  EXPECT_EQ(MS5611_OSR_4096, sim.osr);
+}
+
+TEST_F(MS5611Test, TemperatureDecimation) {
+  init(MS5611_OSR_512, 10);
+  run_bus(1000000, 0);
+
+  ASSERT_GT(sim.temperature_conversions, 0U);
+  EXPECT_NEAR(10.0 * sim.temperature_conversions, sim.pressure_conversions, 10);
+
+  /* Every pressure conversion that has been read back is published */
+  EXPECT_NEAR(sim.pressure_conversions, samples.size(), 1);
+}
+
+TEST_F(MS5611Test, SharesBusWithMagnetometer) {
+  init(MS5611_OSR_1024, 10);
+
+  run_bus(1000000, 0);
+  size_t baro_alone = samples.size();
+  float utilization_alone = sim.busy_us / 1e6f;
+
+  struct pios_sensor_bus_job mag_job;
+  memset(&mag_job, 0, sizeof(mag_job));
+  mag_job.name = "mag";
+  mag_job.run = fake_mag_job;
+  ASSERT_EQ(0, PIOS_SENSOR_BUS_AddJob(bus, &mag_job, 0));
+
+  clear_stats();
+  run_bus(1000000, 0);
+
+  /* The magnetometer keeps its rate, and is read while the baro converts */
+  EXPECT_NEAR(1e6f / (MAG_PERIOD_US + MAG_TRANSFER_US), sim.mag_transfers, 1);
+  EXPECT_EQ(sim.mag_transfers, sim.mag_transfers_in_window);
+
+  /* A baro read is held up by at most one magnetometer transfer */
+  EXPECT_LE(sim.max_read_latency_us, MAG_TRANSFER_US + ADC_COMMAND_US);
+  EXPECT_GE(samples.size(), baro_alone * 97 / 100);
+  EXPECT_EQ(0U, sim.early_reads);
+  EXPECT_EQ(0U, sim.overlapping_starts);
+
+  float utilization = sim.busy_us / 1e6f;
+  EXPECT_GT(utilization, utilization_alone);
+  EXPECT_LT(utilization, 0.10f);
+}
+
+TEST_F(MS5611Test, BatchesReadAndStart) {
+  init(MS5611_OSR_1024, 4);
+  run_bus(100000, 0);
+
+  /* Each conversion is read back and the next one started in one batch,
+   * the bus task never waits on a baro transfer */
+  uint32_t conversions = sim.temperature_conversions + sim.pressure_conversions;
+  ASSERT_GT(conversions, 0U);
+  EXPECT_EQ(0U, sim.baro_transfers);
+  EXPECT_NEAR(conversions, sim.batches, 1);
+  EXPECT_NEAR(2 * conversions, sim.batched_requests, 2);
+}
+
+TEST_F(MS5611Test, AbortsOverdueBatch) {
+  init(MS5611_OSR_1024, 4);
+  run_bus(50000, 0);
+
+  /* Nothing completes while the bus is stuck, each batch is taken back
+   * once it is overdue and submitted again */
+  sim.stalled = true;
+  clear_stats();
+  run_bus(100000, 0);
+  EXPECT_TRUE(samples.empty());
+  EXPECT_GE(sim.aborts, 8U);
+  EXPECT_LE(i2c_queue.size(), 2U);
+
+  /* Conversions resume once it recovers */
+  sim.stalled = false;
+  clear_stats();
+  run_bus(100000, 0);
+  EXPECT_GT(samples.size(), 0U);
+  EXPECT_EQ(0U, sim.early_reads);
+  EXPECT_EQ(0U, sim.overlapping_starts);
+}
+
+TEST_F(MS5611Test, SelfTestRestartsConversions) {
+  init(MS5611_OSR_2048, 5);
+
+  /* Leave a pressure conversion in flight */
+  run_bus(50000, 0);
+  ASSERT_TRUE(sim.converting);
+
+  EXPECT_EQ(0, PIOS_MS5611_Test());
+  EXPECT_EQ(0U, sim.early_reads);
+  EXPECT_EQ(0U, sim.overlapping_starts);
+
+  /* The job starts over with a temperature conversion */
+  clear_stats();
+  run_bus(1000, 0);
+  EXPECT_EQ(1U, sim.temperature_conversions);
+  EXPECT_EQ(0U, sim.pressure_conversions);
+  EXPECT_TRUE(samples.empty());
+}
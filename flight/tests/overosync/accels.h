@@ -0,0 +1,6 @@
+#ifndef ACCELS_H
+#define ACCELS_H
+
+extern UAVObjHandle AccelsHandle(void);
+
+#endif /* ACCELS_H */
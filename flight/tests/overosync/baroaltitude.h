@@ -0,0 +1,6 @@
+#ifndef BAROALTITUDE_H
+#define BAROALTITUDE_H
+
+extern UAVObjHandle BaroAltitudeHandle(void);
+
+#endif /* BAROALTITUDE_H */
@@ -0,0 +1,6 @@
+#ifndef GPSPOSITION_H
+#define GPSPOSITION_H
+
+extern UAVObjHandle GPSPositionHandle(void);
+
+#endif /* GPSPOSITION_H */
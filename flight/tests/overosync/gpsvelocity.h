@@ -0,0 +1,6 @@
+#ifndef GPSVELOCITY_H
+#define GPSVELOCITY_H
+
+extern UAVObjHandle GPSVelocityHandle(void);
+
+#endif /* GPSVELOCITY_H */
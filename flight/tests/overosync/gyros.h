@@ -0,0 +1,6 @@
+#ifndef GYROS_H
+#define GYROS_H
+
+extern UAVObjHandle GyrosHandle(void);
+
+#endif /* GYROS_H */
@@ -0,0 +1,6 @@
+#ifndef MAGNETOMETER_H
+#define MAGNETOMETER_H
+
+extern UAVObjHandle MagnetometerHandle(void);
+
+#endif /* MAGNETOMETER_H */
@@ -0,0 +1,4 @@
+#ifndef MODULESETTINGS_H
+#define MODULESETTINGS_H
+
+#endif /* MODULESETTINGS_H */
@@ -0,0 +1,40 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include "pios.h"
+
+/* Just enough of FreeRTOS for the module, provided by the unit test */
+typedef void * xQueueHandle;
+typedef void * xTaskHandle;
+typedef uint32_t portTickType;
+typedef void (*pdTASK_CODE)(void *parameters);
+
+#define pdTRUE			1
+#define pdFALSE			0
+#define tskIDLE_PRIORITY	0
+#define portTICK_RATE_MS	1
+#define MS2TICKS(m)		((m) / (portTICK_RATE_MS))
+
+#define pvPortMalloc(size) malloc(size)
+#define vPortFree(buf) free(buf)
+
+extern xQueueHandle xQueueCreate(uint32_t length, uint32_t item_size);
+extern int32_t xQueueSend(xQueueHandle queue, const void *item, portTickType ticks);
+extern int32_t xQueueReceive(xQueueHandle queue, void *item, portTickType ticks);
+extern int32_t xQueuePeek(xQueueHandle queue, void *item, portTickType ticks);
+extern uint32_t uxQueueMessagesWaiting(xQueueHandle queue);
+extern int32_t xTaskCreate(pdTASK_CODE code, const signed char *name, uint16_t stack_depth,
+			   void *parameters, uint32_t priority, xTaskHandle *handle);
+extern portTickType xTaskGetTickCount(void);
+extern void vTaskDelay(portTickType ticks);
+
+#include "uavobjectmanager.h"
+#include "uavtalk.h"
+
+#define MODULE_INITCALL(ifn, sfn)
+
+/* From taskinfo.h and taskmonitor.h */
+#define TASKINFO_RUNNING_OVEROSYNC 0
+extern int32_t TaskMonitorAdd(uint32_t task, xTaskHandle handle);
+
+#endif /* OPENPILOT_H */
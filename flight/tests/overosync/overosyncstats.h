@@ -0,0 +1,21 @@
+#ifndef OVEROSYNCSTATS_H
+#define OVEROSYNCSTATS_H
+
+/* The fields of the generated object that the module uses */
+typedef struct {
+	uint32_t Send;
+	uint32_t DroppedUpdates;
+	uint32_t Packets;
+	uint32_t SentUpdates[3];
+	uint32_t QueueFull[3];
+	uint16_t MaxLatency[3];
+	uint8_t Connected;
+} OveroSyncStatsData;
+
+typedef enum { OVEROSYNCSTATS_CONNECTED_FALSE=0, OVEROSYNCSTATS_CONNECTED_TRUE=1 } OveroSyncStatsConnectedOptions;
+
+extern int32_t OveroSyncStatsInitialize(void);
+extern int32_t OveroSyncStatsGet(OveroSyncStatsData *dataOut);
+extern int32_t OveroSyncStatsSet(const OveroSyncStatsData *dataIn);
+
+#endif /* OVEROSYNCSTATS_H */
@@ -0,0 +1,28 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+/* C Lib Includes */
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+#include <pios_com.h>
+#include <pios_overo.h>
+
+/* Provided by the unit test */
+extern void * PIOS_malloc(size_t size);
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#endif /* PIOS_H */
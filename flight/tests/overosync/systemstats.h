@@ -0,0 +1,4 @@
+#ifndef SYSTEMSTATS_H
+#define SYSTEMSTATS_H
+
+#endif /* SYSTEMSTATS_H */
@@ -0,0 +1,499 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <setjmp.h>		/* setjmp */
+#include <sys/mman.h>		/* mmap */
+#include <deque>
+#include <vector>
+
+extern "C" {
+
+#include "openpilot.h"
+#include "pios_com_priv.h"
+#include "overosync.h"
+#include "overosyncstats.h"
+
+int32_t OveroSyncStart(void);
+
+}
+
+/* The fifo size used on Revolution, see pios_board.c */
+#define OVERO_TX_BUF_LEN	1024
+
+/* Fakes for the services the module takes from the rest of the firmware */
+struct fake_queue {
+  std::deque<UAVObjEvent> items;
+  uint32_t length;
+};
+
+struct fake_obj {
+  xQueueHandle queue;
+  uint16_t size;
+};
+
+static struct fake_obj fake_sensor;
+static struct fake_obj fake_state;
+
+static pdTASK_CODE fake_task;
+static portTickType fake_ticks;
+static uint32_t fake_rounds;
+static uint32_t fake_round;
+static void (*fake_round_cb)(uint32_t round);
+static jmp_buf fake_task_exit;
+
+static UAVTalkOutputStream fake_stream;
+static UAVTalkOutputReserve fake_reserve;
+static UAVTalkOutputCommit fake_commit;
+
+static pios_com_callback fake_tx_out_cb;
+static uintptr_t fake_tx_out_context;
+static pios_com_tx_span_callback fake_tx_span_cb;
+static uintptr_t fake_tx_span_context;
+static uint8_t *fake_tx_span;
+static uint16_t fake_tx_span_len;
+static int32_t fake_packets;
+static std::vector<uint8_t> received;
+static std::vector<uint8_t> expected;
+static uint16_t next_seq;
+
+uint32_t pios_com_overo_id;
+uint32_t pios_overo_id;
+
+/* The ids are 32 bit on the target, keep the COM device in the low 4 GB */
+extern "C" void * PIOS_malloc(size_t size)
+{
+  void *buf = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+  return buf == MAP_FAILED ? NULL : buf;
+}
+
+extern "C" int32_t PIOS_DELAY_WaitmS(uint32_t /* mS */)
+{
+  return 0;
+}
+
+extern "C" xQueueHandle xQueueCreate(uint32_t length, uint32_t /* item_size */)
+{
+  struct fake_queue *queue = new fake_queue;
+  queue->length = length;
+  return queue;
+}
+
+extern "C" int32_t xQueueSend(xQueueHandle handle, const void *item, portTickType /* ticks */)
+{
+  struct fake_queue *queue = (struct fake_queue *)handle;
+  if (queue->items.size() >= queue->length)
+    return pdFALSE;
+  queue->items.push_back(*(const UAVObjEvent *)item);
+  return pdTRUE;
+}
+
+extern "C" int32_t xQueueReceive(xQueueHandle handle, void *item, portTickType /* ticks */)
+{
+  struct fake_queue *queue = (struct fake_queue *)handle;
+  if (queue->items.empty())
+    return pdFALSE;
+  *(UAVObjEvent *)item = queue->items.front();
+  queue->items.pop_front();
+  return pdTRUE;
+}
+
+/* The task waits here at the top of each round, run the next one */
+extern "C" int32_t xQueuePeek(xQueueHandle handle, void *item, portTickType ticks)
+{
+  struct fake_queue *queue = (struct fake_queue *)handle;
+
+  if (ticks > 0) {
+    if (fake_round == fake_rounds)
+      longjmp(fake_task_exit, 1);
+    fake_ticks++;
+    fake_round_cb(fake_round++);
+  }
+
+  if (queue->items.empty())
+    return pdFALSE;
+  *(UAVObjEvent *)item = queue->items.front();
+  return pdTRUE;
+}
+
+extern "C" uint32_t uxQueueMessagesWaiting(xQueueHandle handle)
+{
+  return ((struct fake_queue *)handle)->items.size();
+}
+
+extern "C" int32_t xTaskCreate(pdTASK_CODE code, const signed char * /* name */, uint16_t /* stack_depth */,
+                               void * /* parameters */, uint32_t /* priority */, xTaskHandle * /* handle */)
+{
+  fake_task = code;
+  return pdTRUE;
+}
+
+extern "C" portTickType xTaskGetTickCount(void)
+{
+  return fake_ticks;
+}
+
+extern "C" void vTaskDelay(portTickType ticks)
+{
+  fake_ticks += ticks;
+}
+
+extern "C" int32_t TaskMonitorAdd(uint32_t /* task */, xTaskHandle /* handle */)
+{
+  return 0;
+}
+
+extern "C" void UAVObjIterate(void (*iterator)(UAVObjHandle obj))
+{
+  iterator(&fake_sensor);
+  iterator(&fake_state);
+}
+
+extern "C" int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, xQueueHandle queue, uint8_t /* eventMask */)
+{
+  ((struct fake_obj *)obj_handle)->queue = queue;
+  return 0;
+}
+
+extern "C" bool UAVObjIsSettings(UAVObjHandle /* obj */)
+{
+  return false;
+}
+
+extern "C" bool UAVObjIsMetaobject(UAVObjHandle /* obj */)
+{
+  return false;
+}
+
+extern "C" UAVObjHandle GyrosHandle(void) { return &fake_sensor; }
+extern "C" UAVObjHandle AccelsHandle(void) { return NULL; }
+extern "C" UAVObjHandle MagnetometerHandle(void) { return NULL; }
+extern "C" UAVObjHandle BaroAltitudeHandle(void) { return NULL; }
+extern "C" UAVObjHandle GPSPositionHandle(void) { return NULL; }
+extern "C" UAVObjHandle GPSVelocityHandle(void) { return NULL; }
+
+extern "C" int32_t OveroSyncStatsInitialize(void)
+{
+  return 0;
+}
+
+extern "C" int32_t OveroSyncStatsGet(OveroSyncStatsData *dataOut)
+{
+  memset(dataOut, 0, sizeof(*dataOut));
+  return 0;
+}
+
+extern "C" int32_t OveroSyncStatsSet(const OveroSyncStatsData * /* dataIn */)
+{
+  return 0;
+}
+
+extern "C" UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream)
+{
+  fake_stream = outputStream;
+  return &fake_stream;
+}
+
+extern "C" int32_t UAVTalkSetOutputBuffer(UAVTalkConnection /* connection */, UAVTalkOutputReserve reserve, UAVTalkOutputCommit commit)
+{
+  fake_reserve = reserve;
+  fake_commit = commit;
+  return 0;
+}
+
+/* The packet sent for an event, the instance id numbers the events */
+static void make_packet(uint16_t seq, uint16_t size, uint8_t *packet)
+{
+  for (int i = 0; i < size; i++)
+    packet[i] = seq + i;
+}
+
+/* Builds the packet in the reserved room or hands it to the stream, as
+ * sendSingleObject does */
+extern "C" int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection /* connectionHandle */, UAVObjHandle obj,
+                                                uint16_t instId, uint8_t /* acked */, int32_t /* timeoutMs */)
+{
+  uint16_t size = ((struct fake_obj *)obj)->size;
+  uint8_t local[256];
+
+  uint8_t *packet = fake_reserve(size);
+  if (packet != NULL) {
+    make_packet(instId, size, packet);
+    return fake_commit(packet, size);
+  }
+
+  make_packet(instId, size, local);
+  return fake_stream(local, size);
+}
+
+extern "C" int32_t PIOS_OVERO_GetPacketCount(uintptr_t /* overo_id */)
+{
+  return fake_packets;
+}
+
+extern "C" int32_t PIOS_OVERO_Enable(uintptr_t /* overo_id */)
+{
+  return 0;
+}
+
+static void fake_bind_tx_cb(uintptr_t /* id */, pios_com_callback tx_out_cb, uintptr_t context)
+{
+  fake_tx_out_cb = tx_out_cb;
+  fake_tx_out_context = context;
+}
+
+static void fake_bind_tx_span_cb(uintptr_t /* id */, pios_com_tx_span_callback tx_span_cb, uintptr_t context)
+{
+  fake_tx_span_cb = tx_span_cb;
+  fake_tx_span_context = context;
+}
+
+static const struct pios_com_driver fake_com_driver = {
+  NULL, NULL, NULL, NULL, NULL, fake_bind_tx_cb, NULL, NULL,
+};
+
+/* A driver that sends straight out of the fifo, like the F4 USART with DMA */
+static const struct pios_com_driver fake_span_com_driver = {
+  NULL, NULL, NULL, NULL, NULL, fake_bind_tx_cb, NULL, fake_bind_tx_span_cb,
+};
+
+/* The span in flight has gone out, give it back and take the next one */
+static uint16_t overo_next_span(void)
+{
+  bool need_yield = false;
+
+  received.insert(received.end(), fake_tx_span, fake_tx_span + fake_tx_span_len);
+  fake_tx_span_len = fake_tx_span_cb(fake_tx_span_context, &fake_tx_span, fake_tx_span_len, &need_yield);
+  return fake_tx_span_len;
+}
+
+/* The Overo clocks out one packet, taking what the fifo holds */
+static void overo_read_packet(void)
+{
+  uint8_t packet[PIOS_OVERO_PACKET_SIZE];
+  bool need_yield = false;
+
+  if (fake_tx_span_cb) {
+    /* Read in place like a DMA, the bytes of a span are only taken when
+     * it is given back, so the last span of a packet stays in flight
+     * while the module builds the next batches */
+    uint16_t room = PIOS_OVERO_PACKET_SIZE;
+    while (room > 0) {
+      uint16_t len = overo_next_span();
+      if (len > room)
+        fake_tx_span_len = len = room;
+      if (len == 0)
+        break;
+      room -= len;
+    }
+    fake_packets++;
+    return;
+  }
+
+  uint16_t len = fake_tx_out_cb(fake_tx_out_context, packet, sizeof(packet), NULL, &need_yield);
+  received.insert(received.end(), packet, packet + len);
+  fake_packets++;
+}
+
+/* Run the module task for a number of rounds, calling round_cb at the
+ * start of each. The task never returns, it is left from the last round. */
+static void run_task(uint32_t rounds, void (*round_cb)(uint32_t round))
+{
+  fake_rounds = rounds;
+  fake_round = 0;
+  fake_round_cb = round_cb;
+  if (setjmp(fake_task_exit) == 0)
+    fake_task(NULL);
+}
+
+/* Queue an update and remember the packet it has to produce */
+static void update(struct fake_obj *obj)
+{
+  UAVObjEvent ev;
+  ev.obj = obj;
+  ev.instId = next_seq++;
+  ev.event = EV_UPDATED;
+  EXPECT_EQ(pdTRUE, xQueueSend(obj->queue, &ev, 0));
+
+  uint8_t packet[256];
+  make_packet(ev.instId, obj->size, packet);
+  expected.insert(expected.end(), packet, packet + obj->size);
+}
+
+class OveroSync : public testing::Test {
+protected:
+  virtual const struct pios_com_driver *driver() {
+    return &fake_com_driver;
+  }
+
+  virtual void SetUp() {
+    uintptr_t com_id;
+    static uint8_t tx_buffer[OVERO_TX_BUF_LEN];
+
+    srand(1);
+    fake_tx_span_cb = NULL;
+    fake_tx_span = NULL;
+    fake_tx_span_len = 0;
+    ASSERT_EQ(0, PIOS_COM_Init(&com_id, driver(), 0, NULL, 0, tx_buffer, sizeof(tx_buffer)));
+    pios_com_overo_id = com_id;
+    ASSERT_EQ(com_id, pios_com_overo_id);
+
+    /* Past the startup delay */
+    fake_ticks = 5000;
+    fake_packets = 0;
+    received.clear();
+    expected.clear();
+    next_seq = 0;
+
+    ASSERT_EQ(0, OveroSyncInitialize());
+    ASSERT_EQ(0, OveroSyncStart());
+    ASSERT_TRUE(fake_task != NULL);
+  }
+};
+
+static void fill_packet_round(uint32_t round)
+{
+  switch (round) {
+  case 0:
+    /* Exactly one packet of updates, one byte more than the fifo holds */
+    for (int i = 0; i < PIOS_OVERO_PACKET_SIZE / 64; i++)
+      update(&fake_sensor);
+    break;
+  case 3:
+    /* All but the last update fit, it waits for the next packet */
+    EXPECT_EQ(1U, uxQueueMessagesWaiting(fake_sensor.queue));
+    overo_read_packet();
+    EXPECT_EQ(PIOS_OVERO_PACKET_SIZE - 64U, received.size());
+    break;
+  case 6:
+    EXPECT_EQ(0U, uxQueueMessagesWaiting(fake_sensor.queue));
+    overo_read_packet();
+    break;
+  }
+}
+
+TEST_F(OveroSync, FillsAWholePacket) {
+  fake_sensor.size = 64;
+  run_task(7, fill_packet_round);
+
+  ASSERT_EQ(expected.size(), received.size());
+  EXPECT_TRUE(expected == received);
+}
+
+static void stream_round(uint32_t round)
+{
+  /* Updates stop after 2000 rounds, then what is queued drains */
+  if (round < 2000) {
+    int sensor_updates = rand() % 4;
+    for (int i = 0; i < sensor_updates; i++)
+      update(&fake_sensor);
+    if (round % 2)
+      update(&fake_state);
+  }
+
+  /* Every other 200 rounds the Overo reads slower than the updates come */
+  if (rand() % 4 != 0 || (round / 200) % 2 == 0)
+    overo_read_packet();
+}
+
+TEST_F(OveroSync, StreamsWithoutLosingUpdates) {
+  /* Odd sizes so that batches wrap around the end of the fifo and go
+   * through the local buffer as well as straight into the fifo */
+  fake_sensor.size = 37;
+  fake_state.size = 101;
+  run_task(2400, stream_round);
+
+  EXPECT_EQ(0U, uxQueueMessagesWaiting(fake_sensor.queue));
+  EXPECT_EQ(0U, uxQueueMessagesWaiting(fake_state.queue));
+  ASSERT_EQ(expected.size(), received.size());
+  EXPECT_TRUE(expected == received);
+}
+
+class OveroSyncSpans : public OveroSync {
+protected:
+  virtual const struct pios_com_driver *driver() {
+    return &fake_span_com_driver;
+  }
+};
+
+TEST_F(OveroSyncSpans, StreamsWithoutLosingUpdates) {
+  /* Same stream, the fifo read in place with the span the driver holds
+   * not overwritten by the batches built into the fifo behind it */
+  fake_sensor.size = 37;
+  fake_state.size = 101;
+  run_task(2400, stream_round);
+
+  /* Finish the span of the last packet */
+  EXPECT_EQ(0, overo_next_span());
+  EXPECT_EQ(OVERO_TX_BUF_LEN - 1, PIOS_COM_GetTxFree(pios_com_overo_id));
+
+  EXPECT_EQ(0U, uxQueueMessagesWaiting(fake_sensor.queue));
+  EXPECT_EQ(0U, uxQueueMessagesWaiting(fake_state.queue));
+  ASSERT_EQ(expected.size(), received.size());
+  EXPECT_TRUE(expected == received);
+}
+
+TEST_F(OveroSyncSpans, HeldSpanIsNotFree) {
+  uint8_t data[OVERO_TX_BUF_LEN - 1];
+  for (unsigned i = 0; i < sizeof(data); i++)
+    data[i] = i;
+
+  /* Move the fifo along so that what follows wraps around its end */
+  ASSERT_EQ(100, PIOS_COM_SendBufferNonBlocking(pios_com_overo_id, data, 100));
+  ASSERT_EQ(100, overo_next_span());
+  ASSERT_EQ(0, overo_next_span());
+  received.clear();
+
+  /* Fill it, the span up to the end goes in flight and cannot be
+   * written over until it is given back */
+  ASSERT_EQ(1000, PIOS_COM_SendBufferNonBlocking(pios_com_overo_id, data, 1000));
+  ASSERT_EQ(OVERO_TX_BUF_LEN - 100, overo_next_span());
+  ASSERT_EQ(sizeof(data) - 1000, PIOS_COM_GetTxFree(pios_com_overo_id));
+  ASSERT_EQ(sizeof(data) - 1000, (unsigned)PIOS_COM_SendBufferNonBlocking(pios_com_overo_id, data + 1000, sizeof(data) - 1000));
+  EXPECT_EQ(-2, PIOS_COM_SendBufferNonBlocking(pios_com_overo_id, data, 1));
+
+  /* Giving it back frees it, the rest comes from the start of the buffer */
+  overo_next_span();
+  EXPECT_EQ(OVERO_TX_BUF_LEN - 100, PIOS_COM_GetTxFree(pios_com_overo_id));
+  ASSERT_EQ(sizeof(data) - (OVERO_TX_BUF_LEN - 100), fake_tx_span_len);
+  EXPECT_EQ(0, overo_next_span());
+
+  ASSERT_EQ(sizeof(data), received.size());
+  EXPECT_EQ(0, memcmp(data, &received[0], sizeof(data)));
+}
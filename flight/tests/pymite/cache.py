@@ -0,0 +1,129 @@
+# Checks that the inline caches of LOAD_GLOBAL, LOAD_NAME and LOAD_ATTR
+# follow every change to the dicts their values came from.
+#
+# Each lookup is first run in a loop, so its code object is hot and the
+# lookup is cached, then what it found is changed under it.
+# See pm26img.py for the statements this script has to do without.
+
+HEAT = [0] * 20
+
+
+# LOAD_GLOBAL of a global
+
+x = 1
+
+def get_x():
+    return x
+
+def set_x(v):
+    global x
+    x = v
+
+for i in HEAT:
+    r = get_x()
+expect('global', get_x(), 1)
+set_x(2)
+expect('global rebound', get_x(), 2)
+x = 3
+expect('global rebound at module level', get_x(), 3)
+
+
+# LOAD_GLOBAL falling back to the builtins
+
+def get_answer():
+    return answer
+
+for i in HEAT:
+    r = get_answer()
+expect('builtin', get_answer(), 42)
+set_builtin('answer', 43)
+expect('builtin rebound', get_answer(), 43)
+answer = 7
+expect('global shadowing a builtin', get_answer(), 7)
+del answer
+expect('builtin after the global is deleted', get_answer(), 43)
+
+
+# LOAD_GLOBAL while the globals dict grows and shrinks
+
+early = 0
+g = 1
+
+def get_g():
+    return g
+
+for i in HEAT:
+    r = get_g()
+k0 = 0
+k1 = 1
+k2 = 2
+k3 = 3
+k4 = 4
+k5 = 5
+k6 = 6
+k7 = 7
+k8 = 8
+k9 = 9
+expect('global after the globals grew', get_g(), 1)
+del early
+expect('global after an earlier global is deleted', get_g(), 1)
+g = 2
+expect('global rebound after the delete', get_g(), 2)
+
+
+# LOAD_ATTR of instance and class attributes
+
+class C:
+    a = 1
+
+class D(C):
+    pass
+
+o = C()
+p = C()
+d = D()
+
+def get_a(obj):
+    return obj.a
+
+for i in HEAT:
+    r = get_a(o)
+expect('class attr', get_a(o), 1)
+C.a = 2
+expect('class attr rebound', get_a(o), 2)
+o.a = 3
+expect('instance attr shadowing a class attr', get_a(o), 3)
+o.a = 4
+expect('instance attr rebound', get_a(o), 4)
+del o.a
+expect('class attr after the instance attr is deleted', get_a(o), 2)
+p.a = 5
+for i in HEAT:
+    r = get_a(p) + get_a(o)
+expect('receivers alternating at one site', r, 7)
+expect('base class attr', get_a(d), 2)
+C.a = 6
+expect('base class attr rebound', get_a(d), 6)
+
+
+# LOAD_NAME at module level
+
+y = 1
+for i in HEAT:
+    z = y
+expect('module name', z, 1)
+y = 2
+for i in HEAT:
+    z = y
+expect('module name rebound', z, 2)
+for i in HEAT:
+    z = answer
+expect('module name from the builtins', z, 43)
+answer = 8
+for i in HEAT:
+    z = answer
+expect('module name shadowing a builtin', z, 8)
+del answer
+for i in HEAT:
+    z = answer
+expect('module name after the shadowing name is deleted', z, 43)
@@ -0,0 +1,78 @@
+#!/usr/bin/env python
+#
+# Runs pmImgCreator.py on Python 2.6 bytecode when the host python is 2.7.
+#
+# The PyMite VM executes Python 2.6 bytecode. Python 2.7 renumbered a few
+# opcodes and added conditional jumps that pop, which have no one to one
+# 2.6 equivalent. The code compiled by the host is renumbered to 2.6 and
+# any 2.7 only opcode is refused, so the test scripts must do without
+# if, while, and, or, assert and comprehensions.
+#
+# Usage: pm26img.py <pmImgCreator.py> [pmImgCreator arguments]
+
+import dis
+import imp
+import sys
+import types
+
+# 2.7 opcodes that moved, with their 2.6 number
+RENUMBER = {
+    'BUILD_MAP': 104,
+    'LOAD_ATTR': 105,
+    'COMPARE_OP': 106,
+    'IMPORT_NAME': 107,
+    'IMPORT_FROM': 108,
+    'EXTENDED_ARG': 143,
+}
+
+# 2.7 opcodes the 2.6 VM cannot run
+REFUSED = [
+    'LIST_APPEND',
+    'BUILD_SET',
+    'JUMP_IF_FALSE_OR_POP',
+    'JUMP_IF_TRUE_OR_POP',
+    'POP_JUMP_IF_FALSE',
+    'POP_JUMP_IF_TRUE',
+    'SETUP_WITH',
+    'SET_ADD',
+    'MAP_ADD',
+]
+
+
+def to_26(co):
+    """ Returns the code object with its bytecode renumbered to 2.6 """
+    if sys.version_info[:2] == (2, 6):
+        return co
+
+    code = []
+    i = 0
+    while i < len(co.co_code):
+        op = ord(co.co_code[i])
+        name = dis.opname[op]
+        if name in REFUSED:
+            raise NotImplementedError('%s at offset %d in %s has no 2.6 bytecode'
+                                      % (name, i, co.co_filename))
+        code.append(chr(RENUMBER.get(name, op)))
+        n = 3 if op >= dis.HAVE_ARGUMENT else 1
+        code.extend(co.co_code[i + 1:i + n])
+        i += n
+
+    consts = tuple(to_26(c) if isinstance(c, types.CodeType) else c
+                   for c in co.co_consts)
+
+    return types.CodeType(co.co_argcount, co.co_nlocals, co.co_stacksize,
+                          co.co_flags, ''.join(code), consts, co.co_names,
+                          co.co_varnames, co.co_filename, co.co_name,
+                          co.co_firstlineno, co.co_lnotab, co.co_freevars,
+                          co.co_cellvars)
+
+
+def main():
+    creator = imp.load_source('pmImgCreator', sys.argv[1])
+    creator.compile = lambda *args: to_26(compile(*args))
+    sys.argv = sys.argv[1:]
+    creator.main()
+
+
+if __name__ == '__main__':
+    main()
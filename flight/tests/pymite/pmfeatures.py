@@ -0,0 +1,21 @@
+# PyMite features of the unit test build. The inline cache is what is
+# under test, the rest is what the test scripts need.
+
+PM_FEATURES = {
+    "HAVE_PRINT": True,
+    "HAVE_GC": True,
+    "HAVE_FLOAT": True,
+    "HAVE_DEL": True,
+    "HAVE_IMPORTS": True,
+    "HAVE_DEFAULTARGS": True,
+    "HAVE_REPLICATION": True,
+    "HAVE_CLASSES": True,
+    "HAVE_ASSERT": False,
+    "HAVE_GENERATORS": False,
+    "HAVE_BACKTICK": False,
+    "HAVE_STRING_FORMAT": False,
+    "HAVE_CLOSURES": False,
+    "HAVE_BYTEARRAY": False,
+    "HAVE_DEBUG_INFO": False,
+    "HAVE_INLINE_CACHE": True,
+}
@@ -0,0 +1,346 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* snprintf */
+#include <stdint.h>		/* uint*_t */
+#include <vector>
+
+extern "C" {
+
+#include "pm.h"
+
+extern unsigned char const usrlib_img[];
+
+static int expects_run;
+
+/* Called by expect() in the test builtins */
+void pymite_ut_expect(char const *name, uint8_t same)
+{
+  expects_run++;
+  EXPECT_TRUE(same) << name;
+}
+
+}
+
+class PyMite : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(PM_RET_OK, pm_init(MEMSPACE_PROG, usrlib_img));
+    expects_run = 0;
+  }
+};
+
+/* The dict tests hold their objects in C variables, which the gc does not see */
+class PyMiteDict : public PyMite {
+protected:
+  virtual void SetUp() {
+    PyMite::SetUp();
+    heap_gcSetAuto(C_FALSE);
+  }
+
+  /* Start over on an empty heap */
+  void reset() {
+    SetUp();
+  }
+
+  pPmObj_t newDict() {
+    pPmObj_t pdict;
+    EXPECT_EQ(PM_RET_OK, dict_new(&pdict));
+    return pdict;
+  }
+
+  pPmObj_t intKey(int32_t i) {
+    pPmObj_t pint;
+    EXPECT_EQ(PM_RET_OK, int_new(i, &pint));
+    return pint;
+  }
+
+  pPmObj_t strKey(int32_t i) {
+    char buf[16];
+    uint8_t const *pstr = (uint8_t const *)buf;
+    pPmObj_t pstring;
+
+    snprintf(buf, sizeof(buf), "key%d", (int)i);
+    EXPECT_EQ(PM_RET_OK, string_new(&pstr, &pstring));
+    return pstring;
+  }
+
+  /* The value of an item, or C_NULL if the key is missing */
+  pPmObj_t get(pPmObj_t pdict, pPmObj_t pkey) {
+    pPmObj_t pval;
+    PmReturn_t retval = dict_getItem(pdict, pkey, &pval);
+    if (retval == PM_RET_EX_KEY) {
+      return C_NULL;
+    }
+    EXPECT_EQ(PM_RET_OK, retval);
+    return pval;
+  }
+
+  int32_t intAt(pSeglist_t psl, int16_t i) {
+    pPmObj_t pobj;
+    EXPECT_EQ(PM_RET_OK, seglist_getItem(psl, i, &pobj));
+    EXPECT_EQ(OBJ_TYPE_INT, OBJ_GET_TYPE(pobj));
+    return ((pPmInt_t)pobj)->val;
+  }
+};
+
+/* Look up every key of dicts below, at and above the sizes that have an index */
+TEST_F(PyMiteDict, LookupAcrossIndexSizes) {
+  const int16_t sizes[] = { 1, 7, 8, 9, 24, 100, 192, 193, 230 };
+
+  for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    int16_t n = sizes[s];
+    reset();
+    pPmObj_t pdict = newDict();
+
+    for (int16_t i = 0; i < n; i++) {
+      ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, intKey(i), intKey(i * 10)));
+      ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, strKey(i), intKey(-i)));
+    }
+    ASSERT_EQ(2 * n, ((pPmDict_t)pdict)->length);
+
+    /* Indexed from DICT_INDEX_MIN_LENGTH items up to 3/4 of the largest index */
+    bool indexed = (2 * n >= DICT_INDEX_MIN_LENGTH) &&
+      (2 * n * 4 <= DICT_INDEX_MAX_SLOTS * 3);
+    EXPECT_EQ(indexed, ((pPmDict_t)pdict)->d_index != C_NULL) << "size " << 2 * n;
+
+    /* Equal keys are different objects, so they are found by value */
+    for (int16_t i = 0; i < n; i++) {
+      pPmObj_t pval = get(pdict, intKey(i));
+      ASSERT_TRUE(pval != C_NULL) << "int key " << i << " of " << 2 * n;
+      EXPECT_EQ(i * 10, ((pPmInt_t)pval)->val);
+
+      pval = get(pdict, strKey(i));
+      ASSERT_TRUE(pval != C_NULL) << "string key " << i << " of " << 2 * n;
+      EXPECT_EQ(-i, ((pPmInt_t)pval)->val);
+    }
+    EXPECT_TRUE(get(pdict, intKey(n)) == C_NULL);
+    EXPECT_TRUE(get(pdict, strKey(n)) == C_NULL);
+    EXPECT_TRUE(get(pdict, intKey(-1)) == C_NULL);
+  }
+}
+
+/* Deleting items moves the later ones down, they must still be found */
+TEST_F(PyMiteDict, LookupAfterDelete) {
+  pPmObj_t pdict = newDict();
+  const int16_t n = 40;
+
+  for (int16_t i = 0; i < n; i++) {
+    ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, intKey(i), intKey(i * 10)));
+  }
+
+  /* Every third key, from the front so each delete moves most items */
+  for (int16_t i = 0; i < n; i += 3) {
+    ASSERT_EQ(PM_RET_OK, dict_delItem(pdict, intKey(i)));
+  }
+  EXPECT_EQ(PM_RET_EX_KEY, dict_delItem(pdict, intKey(0)));
+
+  for (int16_t i = 0; i < n; i++) {
+    pPmObj_t pval = get(pdict, intKey(i));
+    if (i % 3 == 0) {
+      EXPECT_TRUE(pval == C_NULL) << "deleted key " << i;
+    } else {
+      ASSERT_TRUE(pval != C_NULL) << "key " << i;
+      EXPECT_EQ(i * 10, ((pPmInt_t)pval)->val);
+    }
+  }
+
+  /* Shrink below the index size and grow back */
+  for (int16_t i = 0; i < n; i++) {
+    if (i % 3 != 0 && i >= 4) {
+      ASSERT_EQ(PM_RET_OK, dict_delItem(pdict, intKey(i)));
+    }
+  }
+  EXPECT_EQ(2, ((pPmDict_t)pdict)->length);
+  EXPECT_TRUE(((pPmDict_t)pdict)->d_index == C_NULL);
+
+  for (int16_t i = n; i < 2 * n; i++) {
+    ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, intKey(i), intKey(i * 10)));
+  }
+  EXPECT_TRUE(((pPmDict_t)pdict)->d_index != C_NULL);
+  EXPECT_EQ(10, ((pPmInt_t)get(pdict, intKey(1)))->val);
+  for (int16_t i = n; i < 2 * n; i++) {
+    pPmObj_t pval = get(pdict, intKey(i));
+    ASSERT_TRUE(pval != C_NULL) << "key " << i;
+    EXPECT_EQ(i * 10, ((pPmInt_t)pval)->val);
+  }
+}
+
+/* Items are kept in the order they were first added */
+TEST_F(PyMiteDict, InsertionOrder) {
+  pPmObj_t pdict = newDict();
+
+  for (int16_t i = 0; i < 20; i++) {
+    ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, intKey(i), intKey(i)));
+  }
+  ASSERT_EQ(PM_RET_OK, dict_delItem(pdict, intKey(5)));
+  ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, intKey(3), intKey(33)));
+  ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, intKey(5), intKey(55)));
+
+  const int32_t keys[] = { 0, 1, 2, 3, 4, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 5 };
+  ASSERT_EQ(20, ((pPmDict_t)pdict)->length);
+  for (int16_t i = 0; i < 20; i++) {
+    EXPECT_EQ(keys[i], intAt(((pPmDict_t)pdict)->d_keys, i)) << "position " << i;
+  }
+  EXPECT_EQ(33, intAt(((pPmDict_t)pdict)->d_vals, 3));
+  EXPECT_EQ(55, intAt(((pPmDict_t)pdict)->d_vals, 19));
+}
+
+/* The index is only an accelerator, a dict that cannot get one still works */
+TEST_F(PyMiteDict, NoIndexWhenTheHeapIsFull) {
+  pPmObj_t pdict = newDict();
+  pPmObj_t keys[DICT_INDEX_MIN_LENGTH + 1];
+
+  for (int16_t i = 0; i <= DICT_INDEX_MIN_LENGTH; i++) {
+    keys[i] = intKey(i);
+  }
+  for (int16_t i = 0; i < DICT_INDEX_MIN_LENGTH - 1; i++) {
+    ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, keys[i], keys[i]));
+  }
+
+  /* Use up the heap, the next item still fits in the first segment */
+  std::vector<uint8_t *> filler;
+  uint8_t *pchunk;
+  for (uint16_t size = 1024; size >= 8; size /= 2) {
+    while (heap_getChunk(size, &pchunk) == PM_RET_OK) {
+      filler.push_back(pchunk);
+    }
+  }
+
+  ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, keys[DICT_INDEX_MIN_LENGTH - 1],
+        keys[DICT_INDEX_MIN_LENGTH - 1]));
+  EXPECT_TRUE(((pPmDict_t)pdict)->d_index == C_NULL);
+  for (int16_t i = 0; i < DICT_INDEX_MIN_LENGTH; i++) {
+    EXPECT_EQ(keys[i], get(pdict, keys[i]));
+  }
+
+  /* With room again the next item builds the index */
+  for (unsigned i = 0; i < filler.size(); i++) {
+    heap_freeChunk((pPmObj_t)filler[i]);
+  }
+  ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, keys[DICT_INDEX_MIN_LENGTH],
+        keys[DICT_INDEX_MIN_LENGTH]));
+  EXPECT_TRUE(((pPmDict_t)pdict)->d_index != C_NULL);
+  for (int16_t i = 0; i <= DICT_INDEX_MIN_LENGTH; i++) {
+    EXPECT_EQ(keys[i], get(pdict, keys[i]));
+  }
+}
+
+/* The versions and value slots the inline caches rely on */
+TEST_F(PyMiteDict, VersionsAndSlots) {
+  pPmObj_t pdict = newDict();
+  pPmObj_t pother = newDict();
+  EXPECT_NE(((pPmDict_t)pdict)->d_version, ((pPmDict_t)pother)->d_version);
+
+  for (int16_t i = 0; i < 20; i++) {
+    ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, intKey(i), intKey(i)));
+  }
+
+  pPmObj_t *pslot;
+  ASSERT_EQ(PM_RET_OK, dict_getSlot(pdict, intKey(12), &pslot));
+  EXPECT_EQ(12, ((pPmInt_t)*pslot)->val);
+  EXPECT_EQ(PM_RET_EX_KEY, dict_getSlot(pdict, intKey(20), &pslot));
+  ASSERT_EQ(PM_RET_OK, dict_getSlot(pdict, intKey(12), &pslot));
+
+  /* Rebinding keeps the version, the slot holds the new value */
+  uint32_t version = ((pPmDict_t)pdict)->d_version;
+  uint32_t watched = gVmGlobal.watchedVersion;
+  ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, intKey(12), intKey(120)));
+  EXPECT_EQ(version, ((pPmDict_t)pdict)->d_version);
+  EXPECT_EQ(120, ((pPmInt_t)*pslot)->val);
+
+  /* Adding and deleting keys give new versions */
+  ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, intKey(20), intKey(20)));
+  EXPECT_NE(version, ((pPmDict_t)pdict)->d_version);
+  version = ((pPmDict_t)pdict)->d_version;
+  ASSERT_EQ(PM_RET_OK, dict_delItem(pdict, intKey(0)));
+  EXPECT_NE(version, ((pPmDict_t)pdict)->d_version);
+  version = ((pPmDict_t)pdict)->d_version;
+  ASSERT_EQ(PM_RET_OK, dict_clear(pdict));
+  EXPECT_NE(version, ((pPmDict_t)pdict)->d_version);
+
+  /* None of it was watched */
+  EXPECT_EQ(watched, gVmGlobal.watchedVersion);
+
+  /* Any change to a watched dict changes the watched version */
+  ((pPmDict_t)pother)->d_watched = C_TRUE;
+  ASSERT_EQ(PM_RET_OK, dict_setItem(pother, intKey(1), intKey(1)));
+  EXPECT_NE(watched, gVmGlobal.watchedVersion);
+  watched = gVmGlobal.watchedVersion;
+  ASSERT_EQ(PM_RET_OK, dict_setItem(pother, intKey(1), intKey(2)));
+  EXPECT_NE(watched, gVmGlobal.watchedVersion);
+  watched = gVmGlobal.watchedVersion;
+  ASSERT_EQ(PM_RET_OK, dict_delItem(pother, intKey(1)));
+  EXPECT_NE(watched, gVmGlobal.watchedVersion);
+}
+
+/* Equal keys of different objects hash the same */
+TEST_F(PyMiteDict, HashFollowsCompare) {
+  EXPECT_EQ(obj_hash(intKey(123456)), obj_hash(intKey(123456)));
+  EXPECT_EQ(obj_hash(strKey(77)), obj_hash(strKey(77)));
+
+  pPmObj_t pzero, pnegzero;
+  ASSERT_EQ(PM_RET_OK, float_new(0.0f, &pzero));
+  ASSERT_EQ(PM_RET_OK, float_new(-0.0f, &pnegzero));
+  ASSERT_EQ(C_SAME, obj_compare(pzero, pnegzero));
+  EXPECT_EQ(obj_hash(pzero), obj_hash(pnegzero));
+
+  pPmObj_t ptup1, ptup2;
+  ASSERT_EQ(PM_RET_OK, tuple_new(2, &ptup1));
+  ASSERT_EQ(PM_RET_OK, tuple_new(2, &ptup2));
+  ((pPmTuple_t)ptup1)->val[0] = intKey(1);
+  ((pPmTuple_t)ptup1)->val[1] = strKey(2);
+  ((pPmTuple_t)ptup2)->val[0] = intKey(1);
+  ((pPmTuple_t)ptup2)->val[1] = strKey(2);
+  ASSERT_EQ(C_SAME, obj_compare(ptup1, ptup2));
+  EXPECT_EQ(obj_hash(ptup1), obj_hash(ptup2));
+
+  /* So a dict finds a tuple key by value */
+  pPmObj_t pdict = newDict();
+  for (int16_t i = 0; i < 20; i++) {
+    ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, intKey(i), intKey(i)));
+  }
+  ASSERT_EQ(PM_RET_OK, dict_setItem(pdict, ptup1, intKey(99)));
+  ASSERT_TRUE(((pPmDict_t)pdict)->d_index != C_NULL);
+  pPmObj_t pval = get(pdict, ptup2);
+  ASSERT_TRUE(pval != C_NULL);
+  EXPECT_EQ(99, ((pPmInt_t)pval)->val);
+}
+
+/* Run cache.py, which checks the inline caches through expect() */
+TEST_F(PyMite, InlineCacheInvalidation) {
+  EXPECT_EQ(PM_RET_OK, pm_run((uint8_t const *)"cache"));
+  EXPECT_EQ(23, expects_run);
+}
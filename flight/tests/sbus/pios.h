@@ -0,0 +1,34 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+/* C Lib Includes */
+#include <stdlib.h>
+#include <string.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Just enough of the STM32 peripheral library for the inverter setup */
+typedef enum {DISABLE = 0, ENABLE = !DISABLE} FunctionalState;
+typedef enum {Bit_RESET = 0, Bit_SET} BitAction;
+typedef struct { uint32_t unused; } GPIO_TypeDef;
+typedef struct { uint16_t GPIO_Pin; } GPIO_InitTypeDef;
+
+#define GPIO_Init(gpio, init)
+#define GPIO_WriteBit(gpio, pin, val)
+
+#include <pios_com.h>
+#include <pios_rcvr.h>
+#include <pios_rtc.h>
+#include <pios_sbus.h>
+
+#define PIOS_malloc(size) malloc(size)
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#endif /* PIOS_H */
@@ -0,0 +1,2 @@
+#define PIOS_INCLUDE_SBUS
+#define PIOS_SBUS_NUM_INPUTS	(16+2)
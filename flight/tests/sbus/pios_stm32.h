@@ -0,0 +1,10 @@
+#ifndef PIOS_STM32_H
+#define PIOS_STM32_H
+
+struct stm32_gpio {
+	GPIO_TypeDef *gpio;
+	GPIO_InitTypeDef init;
+	uint8_t pin_source;
+};
+
+#endif /* PIOS_STM32_H */
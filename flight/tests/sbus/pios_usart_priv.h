@@ -0,0 +1 @@
+/* Not needed by the S.Bus driver test */
@@ -0,0 +1,558 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+#include <vector>
+
+extern "C" {
+
+#include "pios.h"
+#include "pios_sbus_priv.h"
+
+}
+
+/* Fakes for the services the driver takes from the rest of PiOS */
+static uint32_t fake_time_us;
+static pios_com_callback fake_rx_cb;
+static uintptr_t fake_rx_context;
+static void (*fake_tick_cb)(uintptr_t id);
+static uintptr_t fake_tick_id;
+static uint32_t fake_frames_signalled;
+static uint32_t fake_frame_time_us;
+
+extern "C" bool PIOS_RTC_RegisterTickCallback(void (*fn)(uintptr_t id), uintptr_t data)
+{
+  fake_tick_cb = fn;
+  fake_tick_id = data;
+  return true;
+}
+
+extern "C" bool PIOS_RCVR_ActiveFromISR(void)
+{
+  fake_frames_signalled++;
+  fake_frame_time_us = fake_time_us;
+  return true;
+}
+
+static void fake_bind_rx_cb(uintptr_t /* id */, pios_com_callback rx_in_cb, uintptr_t context)
+{
+  fake_rx_cb = rx_in_cb;
+  fake_rx_context = context;
+}
+
+static const struct pios_com_driver fake_com_driver = {
+  NULL, NULL, NULL, NULL, fake_bind_rx_cb, NULL, NULL,
+};
+
+static const struct pios_sbus_cfg fake_sbus_cfg = {};
+
+/*
+ * The byte-wise decoder as it was before frames were decoded from the
+ * receive buffer, used as the reference for the driver.
+ */
+struct ref_state {
+  uint16_t channel_data[PIOS_SBUS_NUM_INPUTS];
+  uint8_t received_data[SBUS_FRAME_LENGTH - 2];
+  uint8_t receive_timer;
+  uint8_t failsafe_timer;
+  uint8_t frame_found;
+  uint8_t byte_count;
+};
+
+static void ref_reset_channels(struct ref_state *state)
+{
+  for (int i = 0; i < PIOS_SBUS_NUM_INPUTS; i++) {
+    state->channel_data[i] = PIOS_RCVR_TIMEOUT;
+  }
+}
+
+static void ref_unroll_channels(struct ref_state *state)
+{
+  uint8_t *s = state->received_data;
+  uint16_t *d = state->channel_data;
+
+#define F(v,s) (((v) >> (s)) & 0x7ff)
+
+  /* unroll channels 1-8 */
+  *d++ = F(s[0] | s[1] << 8, 0);
+  *d++ = F(s[1] | s[2] << 8, 3);
+  *d++ = F(s[2] | s[3] << 8 | s[4] << 16, 6);
+  *d++ = F(s[4] | s[5] << 8, 1);
+  *d++ = F(s[5] | s[6] << 8, 4);
+  *d++ = F(s[6] | s[7] << 8 | s[8] << 16, 7);
+  *d++ = F(s[8] | s[9] << 8, 2);
+  *d++ = F(s[9] | s[10] << 8, 5);
+
+  /* unroll channels 9-16 */
+  *d++ = F(s[11] | s[12] << 8, 0);
+  *d++ = F(s[12] | s[13] << 8, 3);
+  *d++ = F(s[13] | s[14] << 8 | s[15] << 16, 6);
+  *d++ = F(s[15] | s[16] << 8, 1);
+  *d++ = F(s[16] | s[17] << 8, 4);
+  *d++ = F(s[17] | s[18] << 8 | s[19] << 16, 7);
+  *d++ = F(s[19] | s[20] << 8, 2);
+  *d++ = F(s[20] | s[21] << 8, 5);
+
+#undef F
+
+  /* unroll discrete channels 17 and 18 */
+  *d++ = (s[22] & SBUS_FLAG_DC1) ? SBUS_VALUE_MAX : SBUS_VALUE_MIN;
+  *d++ = (s[22] & SBUS_FLAG_DC2) ? SBUS_VALUE_MAX : SBUS_VALUE_MIN;
+}
+
+static void ref_update_state(struct ref_state *state, uint8_t b)
+{
+  if (!state->frame_found)
+    return;
+
+  if (state->byte_count == 0) {
+    if (b != SBUS_SOF_BYTE) {
+      state->frame_found = 0;
+    } else {
+      state->byte_count++;
+    }
+    return;
+  }
+
+  if (state->byte_count < SBUS_FRAME_LENGTH - 1) {
+    state->received_data[state->byte_count - 1] = b;
+    state->byte_count++;
+  } else {
+    if (b == SBUS_EOF_BYTE) {
+      uint8_t flags = state->received_data[SBUS_FRAME_LENGTH - 3];
+      if (flags & SBUS_FLAG_FL) {
+      } else if (flags & SBUS_FLAG_FS) {
+        ref_reset_channels(state);
+      } else {
+        ref_unroll_channels(state);
+        state->failsafe_timer = 0;
+      }
+    }
+    state->frame_found = 0;
+  }
+}
+
+static void ref_supervisor(struct ref_state *state)
+{
+  if (++state->receive_timer > 2) {
+    state->frame_found = 1;
+    state->byte_count = 0;
+    state->receive_timer = 0;
+  }
+
+  if (++state->failsafe_timer > 64) {
+    ref_reset_channels(state);
+    state->failsafe_timer = 0;
+  }
+}
+
+/* Pack 16 channels and the flags into a frame */
+static void build_frame(uint8_t *frame, const uint16_t *channels, uint8_t flags)
+{
+  memset(frame, 0, SBUS_FRAME_LENGTH);
+  frame[0] = SBUS_SOF_BYTE;
+  for (int ch = 0; ch < 16; ch++) {
+    for (int bit = 0; bit < 11; bit++) {
+      if (channels[ch] & (1 << bit)) {
+        int pos = ch * 11 + bit;
+        frame[1 + pos / 8] |= 1 << (pos % 8);
+      }
+    }
+  }
+  frame[SBUS_FRAME_LENGTH - 2] = flags;
+  frame[SBUS_FRAME_LENGTH - 1] = SBUS_EOF_BYTE;
+}
+
+static void random_frame(uint8_t *frame)
+{
+  uint16_t channels[16];
+  for (int ch = 0; ch < 16; ch++)
+    channels[ch] = rand() & 0x7ff;
+
+  /* mostly good frames, some with the lost frame or failsafe flags */
+  uint8_t flags = rand() & (SBUS_FLAG_DC1 | SBUS_FLAG_DC2);
+  if (rand() % 20 == 0)
+    flags |= SBUS_FLAG_FL;
+  if (rand() % 20 == 0)
+    flags |= SBUS_FLAG_FS;
+
+  build_frame(frame, channels, flags);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class SBus : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1);
+    fake_time_us = 0;
+    fake_frames_signalled = 0;
+    fake_frame_time_us = 0;
+    ASSERT_EQ(0, PIOS_SBus_Init(&sbus_id, &fake_sbus_cfg, &fake_com_driver, 0));
+    ASSERT_TRUE(fake_rx_cb != NULL);
+    ASSERT_TRUE(fake_tick_cb != NULL);
+
+    memset(&ref, 0, sizeof(ref));
+    ref_reset_channels(&ref);
+  }
+
+  virtual void TearDown() {
+    free((void *)sbus_id);
+  }
+
+  /* Hand a buffer to the driver in a single callback and to the reference byte by byte */
+  void receive(const uint8_t *buf, uint16_t len) {
+    uint16_t headroom;
+    bool need_yield;
+    EXPECT_EQ(len, fake_rx_cb(fake_rx_context, (uint8_t *)buf, len, &headroom, &need_yield));
+    for (uint16_t i = 0; i < len; i++) {
+      ref_update_state(&ref, buf[i]);
+      ref.receive_timer = 0;
+    }
+  }
+
+  /* One RTC tick */
+  void tick() {
+    fake_tick_cb(fake_tick_id);
+    ref_supervisor(&ref);
+  }
+
+  /* A pause long enough to resynchronize on the next frame */
+  void pause() {
+    for (int i = 0; i < 3; i++)
+      tick();
+  }
+
+  int32_t channel(uint8_t ch) {
+    return pios_sbus_rcvr_driver.read(sbus_id, ch);
+  }
+
+  void expect_same_as_reference() {
+    for (uint8_t ch = 0; ch < PIOS_SBUS_NUM_INPUTS; ch++)
+      ASSERT_EQ(ref.channel_data[ch], channel(ch)) << "channel " << (int)ch;
+  }
+
+  /* Feed a stream in random chunks of up to max_chunk bytes, with random pauses */
+  void receive_randomly(const std::vector<uint8_t> &stream, uint16_t max_chunk) {
+    size_t pos = 0;
+    while (pos < stream.size()) {
+      uint16_t len = 1 + rand() % max_chunk;
+      if (len > stream.size() - pos)
+        len = stream.size() - pos;
+      receive(&stream[pos], len);
+      pos += len;
+      expect_same_as_reference();
+
+      int ticks = rand() % 8;
+      for (int i = 0; i < ticks; i++) {
+        tick();
+        expect_same_as_reference();
+      }
+    }
+  }
+
+  uintptr_t sbus_id;
+  struct ref_state ref;
+};
+
+TEST_F(SBus, DecodesFrame) {
+  uint16_t channels[16];
+  for (int ch = 0; ch < 16; ch++)
+    channels[ch] = ch * 127 + 5;
+
+  uint8_t frame[SBUS_FRAME_LENGTH];
+  build_frame(frame, channels, SBUS_FLAG_DC2);
+
+  pause();
+  fake_time_us = 123456;
+  uint16_t headroom;
+  bool need_yield = false;
+  EXPECT_EQ(sizeof(frame), fake_rx_cb(fake_rx_context, frame, sizeof(frame), &headroom, &need_yield));
+  for (uint16_t i = 0; i < sizeof(frame); i++) {
+    ref_update_state(&ref, frame[i]);
+    ref.receive_timer = 0;
+  }
+
+  /* the receiver consumer is woken once per frame */
+  EXPECT_EQ(1U, fake_frames_signalled);
+  EXPECT_EQ(123456U, fake_frame_time_us);
+  EXPECT_TRUE(need_yield);
+
+  for (int ch = 0; ch < 16; ch++)
+    EXPECT_EQ(channels[ch], channel(ch));
+  EXPECT_EQ(SBUS_VALUE_MIN, channel(16));
+  EXPECT_EQ(SBUS_VALUE_MAX, channel(17));
+  expect_same_as_reference();
+}
+
+TEST_F(SBus, DecodesFrameByteWise) {
+  uint8_t frame[SBUS_FRAME_LENGTH];
+  random_frame(frame);
+  frame[SBUS_FRAME_LENGTH - 2] = 0;
+
+  pause();
+  for (int i = 0; i < SBUS_FRAME_LENGTH; i++) {
+    fake_time_us = 1000 + i * 120;
+    receive(&frame[i], 1);
+  }
+  expect_same_as_reference();
+
+  /* signalled when the end of frame arrives */
+  EXPECT_EQ(1U, fake_frames_signalled);
+  EXPECT_EQ(1000U + (SBUS_FRAME_LENGTH - 1) * 120, fake_frame_time_us);
+}
+
+TEST_F(SBus, FailsafeAndLostFrames) {
+  uint8_t frame[SBUS_FRAME_LENGTH];
+  random_frame(frame);
+  frame[SBUS_FRAME_LENGTH - 2] = 0;
+  pause();
+  receive(frame, sizeof(frame));
+  expect_same_as_reference();
+
+  /* a lost frame leaves the channels alone and signals nothing */
+  random_frame(frame);
+  frame[SBUS_FRAME_LENGTH - 2] = SBUS_FLAG_FL;
+  pause();
+  receive(frame, sizeof(frame));
+  expect_same_as_reference();
+  EXPECT_EQ(1U, fake_frames_signalled);
+
+  /* failsafe resets the channels */
+  frame[SBUS_FRAME_LENGTH - 2] = SBUS_FLAG_FS;
+  pause();
+  receive(frame, sizeof(frame));
+  expect_same_as_reference();
+  EXPECT_EQ((uint16_t)PIOS_RCVR_TIMEOUT, channel(0));
+  EXPECT_EQ(2U, fake_frames_signalled);
+}
+
+TEST_F(SBus, BackToBackFramesInOneBuffer) {
+  std::vector<uint8_t> stream(3 * SBUS_FRAME_LENGTH);
+  for (int i = 0; i < 3; i++) {
+    random_frame(&stream[i * SBUS_FRAME_LENGTH]);
+    stream[i * SBUS_FRAME_LENGTH + SBUS_FRAME_LENGTH - 2] = 0;
+  }
+
+  pause();
+  fake_time_us = 5000;
+  receive(&stream[0], stream.size());
+
+  /* the reference waits for a pause between frames, the driver takes all three */
+  struct ref_state last;
+  memcpy(last.received_data, &stream[2 * SBUS_FRAME_LENGTH + 1], sizeof(last.received_data));
+  ref_unroll_channels(&last);
+  for (uint8_t ch = 0; ch < PIOS_SBUS_NUM_INPUTS; ch++)
+    EXPECT_EQ(last.channel_data[ch], channel(ch));
+
+  /* the frames of one callback wake the consumer once */
+  EXPECT_EQ(1U, fake_frames_signalled);
+  EXPECT_EQ(5000U, fake_frame_time_us);
+}
+
+TEST_F(SBus, FuzzRandomFrames) {
+  /*
+   * Chunks shorter than two frames, where both decoders must agree exactly
+   * whichever of the driver paths a chunk takes
+   */
+  for (int n = 0; n < 5000; n++) {
+    std::vector<uint8_t> stream(SBUS_FRAME_LENGTH);
+    random_frame(&stream[0]);
+    receive_randomly(stream, 2 * SBUS_FRAME_LENGTH - 1);
+    pause();
+    expect_same_as_reference();
+  }
+}
+
+TEST_F(SBus, FuzzCorruptedStream) {
+  std::vector<uint8_t> stream;
+  for (int n = 0; n < 5000; n++) {
+    uint8_t frame[SBUS_FRAME_LENGTH];
+    random_frame(frame);
+    for (int i = 0; i < SBUS_FRAME_LENGTH; i++) {
+      switch (rand() % 100) {
+      case 0:
+        /* dropped byte */
+        break;
+      case 1:
+        /* inserted byte */
+        stream.push_back(rand() & 0xff);
+        stream.push_back(frame[i]);
+        break;
+      case 2:
+        /* bit error */
+        stream.push_back(frame[i] ^ (1 << (rand() % 8)));
+        break;
+      default:
+        stream.push_back(frame[i]);
+      }
+    }
+
+    /* bursts of noise */
+    if (rand() % 10 == 0) {
+      int len = rand() % (3 * SBUS_FRAME_LENGTH);
+      for (int i = 0; i < len; i++)
+        stream.push_back(rand() % 4 == 0 ? SBUS_SOF_BYTE : rand() & 0xff);
+    }
+  }
+
+  receive_randomly(stream, 2 * SBUS_FRAME_LENGTH - 1);
+}
+
+TEST_F(SBus, FuzzLargeBuffers) {
+  /*
+   * With buffers holding several frames the driver also decodes frames
+   * that follow a good one back to back. Whatever it decodes must be a
+   * complete frame of the stream and never a misaligned one.
+   */
+  for (int n = 0; n < 2000; n++) {
+    std::vector<uint8_t> stream;
+    int frames = 1 + rand() % 6;
+    for (int i = 0; i < frames; i++) {
+      uint8_t frame[SBUS_FRAME_LENGTH];
+      random_frame(frame);
+      if (rand() % 10 == 0)
+        frame[rand() % SBUS_FRAME_LENGTH] ^= 1 << (rand() % 8);
+      stream.insert(stream.end(), frame, frame + SBUS_FRAME_LENGTH);
+    }
+
+    uint32_t signalled = fake_frames_signalled;
+
+    pause();
+    receive(&stream[0], stream.size());
+
+    if (fake_frames_signalled == signalled)
+      continue;
+
+    ASSERT_EQ(signalled + 1, fake_frames_signalled);
+
+    uint16_t channels[PIOS_SBUS_NUM_INPUTS];
+    for (uint8_t ch = 0; ch < PIOS_SBUS_NUM_INPUTS; ch++)
+      channels[ch] = channel(ch);
+
+    /* the last frame decoded sits on a frame boundary of the stream */
+    bool found = false;
+    for (int i = 0; i < frames && !found; i++) {
+      const uint8_t *frame = &stream[i * SBUS_FRAME_LENGTH];
+      struct ref_state decoded;
+      memcpy(decoded.received_data, frame + 1, sizeof(decoded.received_data));
+      if (decoded.received_data[SBUS_FRAME_LENGTH - 3] & SBUS_FLAG_FS)
+        ref_reset_channels(&decoded);
+      else
+        ref_unroll_channels(&decoded);
+      found = memcmp(decoded.channel_data, channels, sizeof(channels)) == 0;
+    }
+    ASSERT_TRUE(found) << "iteration " << n;
+  }
+}
+
+static double elapsed_ns(const struct timespec &start, const struct timespec &end)
+{
+  return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+TEST_F(SBus, Benchmark) {
+  const int num_frames = 200000;
+  std::vector<uint8_t> stream(num_frames * SBUS_FRAME_LENGTH);
+  for (int n = 0; n < num_frames; n++) {
+    random_frame(&stream[n * SBUS_FRAME_LENGTH]);
+    stream[n * SBUS_FRAME_LENGTH + SBUS_FRAME_LENGTH - 2] = 0;
+  }
+
+  uint16_t headroom;
+  bool need_yield;
+  struct timespec start, end;
+  uint32_t ref_sum = 0, byte_sum = 0, block_sum = 0;
+
+  /* the driver needs a pause before each frame, time it on its own */
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int n = 0; n < num_frames; n++)
+    pause();
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double pause_ns = elapsed_ns(start, end) / num_frames;
+
+  /* reference: one byte at a time through the shift/or unroll */
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int n = 0; n < num_frames; n++) {
+    ref.frame_found = 1;
+    ref.byte_count = 0;
+    for (int i = 0; i < SBUS_FRAME_LENGTH; i++)
+      ref_update_state(&ref, stream[n * SBUS_FRAME_LENGTH + i]);
+    ref_sum += ref.channel_data[n % 16];
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double ref_ns = elapsed_ns(start, end) / num_frames;
+
+  /* driver fed one byte per callback, as by the USART interrupt */
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int n = 0; n < num_frames; n++) {
+    pause();
+    for (int i = 0; i < SBUS_FRAME_LENGTH; i++)
+      fake_rx_cb(fake_rx_context, &stream[n * SBUS_FRAME_LENGTH + i], 1, &headroom, &need_yield);
+    byte_sum += channel(n % 16);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double byte_ns = elapsed_ns(start, end) / num_frames - pause_ns;
+
+  /* driver fed a whole frame per callback */
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int n = 0; n < num_frames; n++) {
+    pause();
+    fake_rx_cb(fake_rx_context, &stream[n * SBUS_FRAME_LENGTH], SBUS_FRAME_LENGTH, &headroom, &need_yield);
+    block_sum += channel(n % 16);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double block_ns = elapsed_ns(start, end) / num_frames - pause_ns;
+
+  /*
+   * The driver is built with coverage instrumentation and reached through
+   * its callback, the reference is neither, so only the ratio between the
+   * driver paths is meaningful
+   */
+  printf("S.Bus decode per frame: reference %.1f ns, driver one byte per callback %.1f ns, driver one frame per callback %.1f ns\n",
+         ref_ns, byte_ns, block_ns);
+
+  /* all of them decoded the same frames */
+  EXPECT_EQ(ref_sum, byte_sum);
+  EXPECT_EQ(ref_sum, block_sum);
+}
+
+/**
+ * @}
+ * @}
+ */
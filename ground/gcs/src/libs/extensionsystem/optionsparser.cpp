@@ -36,6 +36,7 @@ using namespace ExtensionSystem::Internal;
 static const char *END_OF_OPTIONS = "--";
 const char *OptionsParser::NO_LOAD_OPTION = "-noload";
 const char *OptionsParser::TEST_OPTION = "-test";
+const char *OptionsParser::PERF_OPTION = "-perf";
 
 OptionsParser::OptionsParser(const QStringList &args,
         const QMap<QString, bool> &appOptions,
@@ -70,6 +71,8 @@ bool OptionsParser::parse()
             continue;
         if (checkForTestOption())
             continue;
+        if (checkForPerfOption())
+            continue;
         if (checkForAppOption())
             continue;
         if (checkForPluginOption())
@@ -112,6 +115,14 @@ bool OptionsParser::checkForTestOption()
     return true;
 }
 
+bool OptionsParser::checkForPerfOption()
+{
+    if (m_currentArg != QLatin1String(PERF_OPTION))
+        return false;
+    m_pmPrivate->initProfiling();
+    return true;
+}
+
 bool OptionsParser::checkForNoLoadOption()
 {
     if (m_currentArg != QLatin1String(NO_LOAD_OPTION))
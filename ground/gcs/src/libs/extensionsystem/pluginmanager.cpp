@@ -39,6 +39,7 @@
 #include <QtCore/QDir>
 #include <QtCore/QTextStream>
 #include <QtCore/QWriteLocker>
+#include <QtCore/QtConcurrentMap>
 #include <QtDebug>
 #ifdef WITH_TESTS
 #include <QTest>
@@ -381,6 +382,9 @@ void PluginManager::formatOptions(QTextStream &str, int optionIndentation, int d
     formatOption(str, QLatin1String(OptionsParser::NO_LOAD_OPTION),
                  QLatin1String("plugin"), QLatin1String("Do not load <plugin>"),
                  optionIndentation, descriptionIndentation);
+    formatOption(str, QLatin1String(OptionsParser::PERF_OPTION),
+                 QString(), QLatin1String("Report plugin load and initialization times"),
+                 optionIndentation, descriptionIndentation);
 }
 
 /*!
@@ -490,7 +494,7 @@ PluginSpecPrivate *PluginManagerPrivate::privateSpec(PluginSpec *spec)
     \internal
 */
 PluginManagerPrivate::PluginManagerPrivate(PluginManager *pluginManager)
-    : extension("xml"), q(pluginManager)
+    : extension("xml"), m_profileElapsedMS(0), m_specReadMS(0), q(pluginManager)
 {
 }
 
@@ -576,21 +580,27 @@ void PluginManagerPrivate::removeObject(QObject *obj)
 void PluginManagerPrivate::loadPlugins()
 {
     QList<PluginSpec *> queue = loadQueue();
+    profilingReport(">loadQueue");
     foreach (PluginSpec *spec, queue) {
         emit q->splashMessages(QString(QObject::tr("Loading %1 plugin")).arg(spec->name()));
         loadPlugin(spec, PluginSpec::Loaded);
+        profilingReport(">loadLibrary", spec);
         if(spec->name() == "Core")
             QObject::connect(spec->plugin(),SIGNAL(splashMessages(QString)),q,SIGNAL(splashMessages(QString)));
     }
     foreach (PluginSpec *spec, queue) {
         emit q->splashMessages(QString(QObject::tr("Initializing %1 plugin")).arg(spec->name()));
         loadPlugin(spec, PluginSpec::Initialized);
+        profilingReport(">initialize", spec);
     }
     QListIterator<PluginSpec *> it(queue);
     it.toBack();
     while (it.hasPrevious()) {
-        loadPlugin(it.previous(), PluginSpec::Running);
+        PluginSpec *spec = it.previous();
+        loadPlugin(spec, PluginSpec::Running);
+        profilingReport(">extensionsInitialized", spec);
     }
+    profilingSummary();
     emit q->pluginsChanged();
     q->m_allPluginsLoaded=true;
     emit q->pluginsLoadEnded();
@@ -696,6 +706,13 @@ void PluginManagerPrivate::setPluginPaths(const QStringList &paths)
     readPluginPaths();
 }
 
+typedef QPair<PluginSpecPrivate *, QString> SpecFile;
+
+static void readSpecFile(SpecFile &specFile)
+{
+    specFile.first->read(specFile.second);
+}
+
 /*!
     \fn void PluginManagerPrivate::readPluginPaths()
     \internal
@@ -716,11 +733,18 @@ void PluginManagerPrivate::readPluginPaths()
         foreach (const QFileInfo &subdir, dirs)
             searchPaths << subdir.absoluteFilePath();
     }
+    // The spec files are independent of each other, parse them in parallel.
+    // The specs are created here so they live in this thread.
+    QList<SpecFile> specs;
     foreach (const QString &specFile, specFiles) {
         PluginSpec *spec = new PluginSpec;
-        spec->d->read(specFile);
+        specs.append(SpecFile(spec->d, specFile));
         pluginSpecs.append(spec);
     }
+    QElapsedTimer readTimer;
+    readTimer.start();
+    QtConcurrent::blockingMap(specs, readSpecFile);
+    m_specReadMS = readTimer.elapsed();
     resolveDependencies();
     // ensure deterministic plugin load order by sorting
     qSort(pluginSpecs.begin(), pluginSpecs.end(), lessThanByPluginName);
@@ -734,6 +758,70 @@ void PluginManagerPrivate::resolveDependencies()
     }
 }
 
+/*!
+    \fn void PluginManagerPrivate::initProfiling()
+    \internal
+*/
+void PluginManagerPrivate::initProfiling()
+{
+    if (!m_profileTimer.isNull())
+        return;
+    m_profileTimer.reset(new QElapsedTimer);
+    m_profileTimer->start();
+    m_profileElapsedMS = 0;
+    qDebug("Profiling started, %d plugin specs read in %lldms",
+           pluginSpecs.size(), m_specReadMS);
+}
+
+/*!
+    \fn void PluginManagerPrivate::profilingReport(const char *what, const PluginSpec *spec)
+    \internal
+    Prints the time spent since the previous report and charges it to \a spec.
+*/
+void PluginManagerPrivate::profilingReport(const char *what, const PluginSpec *spec)
+{
+    if (m_profileTimer.isNull())
+        return;
+    const qint64 absoluteElapsedMS = m_profileTimer->elapsed();
+    const qint64 elapsedMS = absoluteElapsedMS - m_profileElapsedMS;
+    m_profileElapsedMS = absoluteElapsedMS;
+    if (spec) {
+        m_profileTotal[spec] += elapsedMS;
+        qDebug("%-22s %-22s %8lldms (%8lldms)", what, qPrintable(spec->name()), absoluteElapsedMS, elapsedMS);
+    } else {
+        qDebug("%-45s %8lldms (%8lldms)", what, absoluteElapsedMS, elapsedMS);
+    }
+}
+
+static bool greaterThanByTotal(const QPair<qint64, const PluginSpec *> &a,
+                               const QPair<qint64, const PluginSpec *> &b)
+{
+    return a.first > b.first;
+}
+
+/*!
+    \fn void PluginManagerPrivate::profilingSummary()
+    \internal
+    Lists the plugins by the total time they took to start, slowest first.
+*/
+void PluginManagerPrivate::profilingSummary() const
+{
+    if (m_profileTimer.isNull())
+        return;
+    QList<QPair<qint64, const PluginSpec *> > totals;
+    QHash<const PluginSpec *, qint64>::const_iterator it;
+    for (it = m_profileTotal.constBegin(); it != m_profileTotal.constEnd(); ++it)
+        totals.append(qMakePair(it.value(), it.key()));
+    qSort(totals.begin(), totals.end(), greaterThanByTotal);
+
+    qint64 total = 0;
+    for (int i = 0; i < totals.size(); ++i) {
+        qDebug("%-22s %8lldms", qPrintable(totals.at(i).second->name()), totals.at(i).first);
+        total += totals.at(i).first;
+    }
+    qDebug("Total: %lldms", total);
+}
+
  // Look in argument descriptions of the specs for the option.
 PluginSpec *PluginManagerPrivate::pluginForOption(const QString &option, bool *requiresArgument) const
 {
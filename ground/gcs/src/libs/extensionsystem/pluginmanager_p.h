@@ -35,6 +35,9 @@
 #include <QtCore/QSet>
 #include <QtCore/QStringList>
 #include <QtCore/QObject>
+#include <QtCore/QHash>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QScopedPointer>
 
 namespace ExtensionSystem {
 
@@ -60,6 +63,9 @@ public:
     QList<PluginSpec *> loadQueue();
     void loadPlugin(PluginSpec *spec, PluginSpec::State destState);
     void resolveDependencies();
+    void initProfiling();
+    void profilingReport(const char *what, const PluginSpec *spec = 0);
+    void profilingSummary() const;
 
     QList<PluginSpec *> pluginSpecs;
     QList<PluginSpec *> testSpecs;
@@ -69,6 +75,12 @@ public:
 
     QStringList arguments;
 
+    // Startup profiling, enabled with -perf
+    QScopedPointer<QElapsedTimer> m_profileTimer;
+    qint64 m_profileElapsedMS;
+    qint64 m_specReadMS;
+    QHash<const PluginSpec *, qint64> m_profileTotal;
+
     // Look in argument descriptions of the specs for the option.
     PluginSpec *pluginForOption(const QString &option, bool *requiresArgument) const;
     PluginSpec *pluginByName(const QString &name) const;
@@ -68,6 +68,10 @@ HITLConfiguration::HITLConfiguration(QString classId, QSettings* qSettings, QObj
     settings.airspeedActualEnabled= false;
     settings.airspeedActualRate  = 100;
 
+    settings.lockstepEnabled     = false;
+    settings.lockstepRate        = 500;
+    settings.lockstepPort        = HITL_LOCKSTEP_DEFAULT_PORT;
+
 
     // if a saved configuration exists load it, and overwrite defaults
     if (qSettings != 0) {
@@ -124,6 +128,10 @@ HITLConfiguration::HITLConfiguration(QString classId, QSettings* qSettings, QObj
 
         settings.airspeedActualEnabled=qSettings->value("airspeedActualEnabled").toBool();
         settings.airspeedActualRate  = qSettings->value("airspeedActualRate").toInt();
+
+        settings.lockstepEnabled     = qSettings->value("lockstepEnabled", settings.lockstepEnabled).toBool();
+        settings.lockstepRate        = qSettings->value("lockstepRate", settings.lockstepRate).toInt();
+        settings.lockstepPort        = qSettings->value("lockstepPort", settings.lockstepPort).toInt();
     }
 }
 
@@ -174,5 +182,9 @@ void HITLConfiguration::saveConfig(QSettings* qSettings) const {
 
     qSettings->setValue("airspeedActualEnabled", settings.airspeedActualEnabled);
     qSettings->setValue("airspeedActualRate", settings.airspeedActualRate);
+
+    qSettings->setValue("lockstepEnabled", settings.lockstepEnabled);
+    qSettings->setValue("lockstepRate", settings.lockstepRate);
+    qSettings->setValue("lockstepPort", settings.lockstepPort);
 }
 
@@ -0,0 +1,179 @@
+/**
+ ******************************************************************************
+ *
+ * @file       hitllockstep.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup HITLPlugin HITL Plugin
+ * @{
+ * @brief Fixed step lockstep bridge to the simulated flight side
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify 
+ * it under the terms of the GNU General Public License as published by 
+ * the Free Software Foundation; either version 3 of the License, or 
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+ * for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "hitllockstep.h"
+
+#include <QUdpSocket>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QDebug>
+#include <string.h>
+
+HitlLockstep::HitlLockstep(const QString& flightAddress, quint16 flightPort, int rateHz, QObject *parent) :
+    QThread(parent),
+    flightAddress(flightAddress),
+    flightPort(flightPort),
+    stepNs(1000000000LL / qMax(rateHz, 1)),
+    running(true),
+    sensorsValid(false),
+    actuatorsFresh(false)
+{
+    memset(&sensors, 0, sizeof(sensors));
+    memset(actuators, 0, sizeof(actuators));
+}
+
+HitlLockstep::~HitlLockstep()
+{
+    stop();
+}
+
+/**
+ * Latch the simulator state sent with the next step, callable from any thread
+ */
+void HitlLockstep::setSensors(const struct hitl_lockstep_sensors& sensors)
+{
+    QMutexLocker locker(&mutex);
+    this->sensors = sensors;
+    sensorsValid = true;
+}
+
+/**
+ * Get the actuators from the last answered step
+ * @return false if no step was answered since the previous call
+ */
+bool HitlLockstep::takeActuators(float actuators[HITL_LOCKSTEP_NUM_ACTUATORS])
+{
+    QMutexLocker locker(&mutex);
+    if (!actuatorsFresh)
+        return false;
+    memcpy(actuators, this->actuators, sizeof(this->actuators));
+    actuatorsFresh = false;
+    return true;
+}
+
+void HitlLockstep::stop()
+{
+    running = false;
+    wait();
+}
+
+void HitlLockstep::run()
+{
+    QUdpSocket socket;
+    if (!socket.bind(QHostAddress::Any, 0)) {
+        qDebug() << "[HITL] Lockstep could not open its socket:" << socket.errorString();
+        return;
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+
+    quint32 step = 0;
+    qint64 nextStepNs = stepNs;
+
+    quint32 steps = 0;
+    quint32 timeouts = 0;
+    qint64 jitterSumNs = 0;
+    qint64 jitterMaxNs = 0;
+    quint32 jitterSamples = 0;
+    qint64 reportNs = clock.nsecsElapsed();
+
+    while (running) {
+        // Wait for the step to be due
+        qint64 remainingNs;
+        while ((remainingNs = nextStepNs - clock.nsecsElapsed()) > 0) {
+            if (remainingNs > SPIN_THRESHOLD_NS)
+                usleep((remainingNs - SPIN_THRESHOLD_NS) / 1000);
+        }
+        const qint64 jitterNs = -remainingNs;
+        jitterSumNs += jitterNs;
+        jitterMaxNs = qMax(jitterMaxNs, jitterNs);
+        ++jitterSamples;
+
+        struct hitl_lockstep_sensors frame;
+        bool haveSensors;
+        {
+            QMutexLocker locker(&mutex);
+            frame = sensors;
+            haveSensors = sensorsValid;
+        }
+
+        if (haveSensors) {
+            frame.magic = HITL_LOCKSTEP_SENSORS_MAGIC;
+            frame.step = ++step;
+            frame.dT = stepNs / 1.0e9f;
+
+            // The flight side blocks on this frame and answers it once its
+            // control loop ran, the step is sent again until that answer
+            // arrived. A repeated frame is answered again, not stepped twice.
+            bool answered = false;
+            while (!answered && running) {
+                socket.writeDatagram((const char *) &frame, sizeof(frame), flightAddress, flightPort);
+
+                if (!socket.hasPendingDatagrams() && !socket.waitForReadyRead(RESEND_TIMEOUT_MS)) {
+                    ++timeouts;
+                    continue;
+                }
+                while (socket.hasPendingDatagrams()) {
+                    struct hitl_lockstep_actuators reply;
+                    qint64 size = socket.readDatagram((char *) &reply, sizeof(reply));
+                    if (size == sizeof(reply) && reply.magic == HITL_LOCKSTEP_ACTUATORS_MAGIC && reply.step == step) {
+                        QMutexLocker locker(&mutex);
+                        memcpy(actuators, reply.actuator, sizeof(actuators));
+                        actuatorsFresh = true;
+                        answered = true;
+                    }
+                }
+            }
+
+            if (answered)
+                ++steps;
+        }
+
+        // The next step is due one period after this one was due, when the
+        // flight side answered late the steps are only delayed, never skipped
+        nextStepNs += stepNs;
+        const qint64 nowNs = clock.nsecsElapsed();
+        if (nextStepNs < nowNs)
+            nextStepNs = nowNs;
+
+        if (nowNs - reportNs >= REPORT_PERIOD_NS) {
+            const double elapsedS = (nowNs - reportNs) / 1.0e9;
+            emit statistics(steps / elapsedS,
+                            jitterSamples ? jitterSumNs / 1000.0 / jitterSamples : 0.0,
+                            jitterMaxNs / 1000.0,
+                            timeouts);
+            reportNs = nowNs;
+            steps = 0;
+            timeouts = 0;
+            jitterSumNs = 0;
+            jitterMaxNs = 0;
+            jitterSamples = 0;
+        }
+    }
+}
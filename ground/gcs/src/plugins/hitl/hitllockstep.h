@@ -0,0 +1,84 @@
+/**
+ ******************************************************************************
+ *
+ * @file       hitllockstep.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup HITLPlugin HITL Plugin
+ * @{
+ * @brief Fixed step lockstep bridge to the simulated flight side
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify 
+ * it under the terms of the GNU General Public License as published by 
+ * the Free Software Foundation; either version 3 of the License, or 
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+ * for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef HITLLOCKSTEP_H
+#define HITLLOCKSTEP_H
+
+#include <QThread>
+#include <QMutex>
+#include <QHostAddress>
+
+#include "hitl_lockstep.h"
+
+/**
+ * Exchanges batched sensor and actuator frames with the posix simulation
+ * (see pios_sim_lockstep.c) on its own thread. Every step sends the latest
+ * simulator state and waits for the actuators the flight control loop
+ * produced for that step before the next one is started, a step that is not
+ * answered in time is sent again. Steps are started no faster than the
+ * configured rate, independent of the GUI and telemetry.
+ */
+class HitlLockstep : public QThread
+{
+    Q_OBJECT
+
+public:
+    HitlLockstep(const QString& flightAddress, quint16 flightPort, int rateHz, QObject *parent = 0);
+    ~HitlLockstep();
+
+    void setSensors(const struct hitl_lockstep_sensors& sensors);
+    bool takeActuators(float actuators[HITL_LOCKSTEP_NUM_ACTUATORS]);
+    void stop();
+
+signals:
+    //! Emitted once per second from the lockstep thread
+    void statistics(double stepsPerSecond, double meanJitterUs, double maxJitterUs, quint32 timeouts);
+
+protected:
+    void run();
+
+private:
+    //! Below this the step deadline is busy waited, sleeps are not that accurate
+    static const qint64 SPIN_THRESHOLD_NS = 1000000;
+    static const qint64 REPORT_PERIOD_NS = 1000000000;
+    //! A step that is not answered within this is sent again
+    static const int RESEND_TIMEOUT_MS = 100;
+
+    QHostAddress flightAddress;
+    quint16 flightPort;
+    qint64 stepNs;
+    volatile bool running;
+
+    QMutex mutex;
+    struct hitl_lockstep_sensors sensors;
+    bool sensorsValid;
+    float actuators[HITL_LOCKSTEP_NUM_ACTUATORS];
+    bool actuatorsFresh;
+};
+
+#endif // HITLLOCKSTEP_H
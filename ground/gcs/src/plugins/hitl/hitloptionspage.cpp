@@ -118,6 +118,10 @@ QWidget *HITLOptionsPage::createPage(QWidget *parent)
     m_optionsPage->airspeedActualCheckbox->setChecked(config->Settings().airspeedActualEnabled);
     m_optionsPage->airspeedRateSpinbox->setValue(config->Settings().airspeedActualRate);
 
+    m_optionsPage->lockstepCheckbox->setChecked(config->Settings().lockstepEnabled);
+    m_optionsPage->lockstepRateSpinbox->setValue(config->Settings().lockstepRate);
+    m_optionsPage->lockstepPortSpinbox->setValue(config->Settings().lockstepPort);
+
     return optionsPageWidget;
 }
 
@@ -168,6 +172,10 @@ void HITLOptionsPage::apply()
     settings.airspeedActualEnabled=m_optionsPage->airspeedActualCheckbox->isChecked();
     settings.airspeedActualRate=m_optionsPage->airspeedRateSpinbox->value();
 
+    settings.lockstepEnabled = m_optionsPage->lockstepCheckbox->isChecked();
+    settings.lockstepRate = m_optionsPage->lockstepRateSpinbox->value();
+    settings.lockstepPort = m_optionsPage->lockstepPortSpinbox->value();
+
     //Write settings to file
     config->setSimulatorSettings(settings);
 }
@@ -13,6 +13,7 @@ HEADERS += hitlplugin.h \
     hitlgadget.h \
     hitlnoisegeneration.h \
     simulator.h \
+    hitllockstep.h \
     aerosimrcsimulator.h \
     fgsimulator.h \
     il2simulator.h \
@@ -25,6 +26,7 @@ SOURCES += hitlplugin.cpp \
     hitlgadget.cpp \
     hitlnoisegeneration.cpp \
     simulator.cpp \
+    hitllockstep.cpp \
     aerosimrcsimulator.cpp \
     fgsimulator.cpp \
     il2simulator.cpp \
@@ -50,6 +50,7 @@ Simulator::Simulator(const SimulatorSettings& params) :
 	simConnectionStatus(false),
 	txTimer(NULL),
 	simTimer(NULL),
+	lockstep(NULL),
 	name("")
 {
 	// move to thread
@@ -78,6 +79,13 @@ Simulator::Simulator(const SimulatorSettings& params) :
 
 Simulator::~Simulator()
 {
+	if(lockstep)
+	{
+		lockstep->stop();
+		delete lockstep;
+		lockstep = NULL;
+	}
+
 	if(inSocket)
 	{
 		delete inSocket;
@@ -193,6 +201,16 @@ void Simulator::onStart()
 
 	// Setup transmit timer
 	txTimer = new QTimer();
+	if (settings.lockstepEnabled)
+	{
+		// Sensors and actuators go through the lockstep bridge instead of
+		// telemetry, its actuators are applied right before transmitUpdate()
+		lockstep = new HitlLockstep(settings.hostAddress, settings.lockstepPort, settings.lockstepRate);
+		connect(lockstep, SIGNAL(statistics(double,double,double,quint32)),
+				this, SLOT(onLockstepStatistics(double,double,double,quint32)));
+		connect(txTimer, SIGNAL(timeout()), this, SLOT(applyLockstepActuators()),Qt::DirectConnection);
+		lockstep->start(QThread::TimeCriticalPriority);
+	}
 	connect(txTimer, SIGNAL(timeout()), this, SLOT(transmitUpdate()),Qt::DirectConnection);
 	txTimer->setInterval(updatePeriod);
 	txTimer->start();
@@ -408,6 +426,70 @@ void Simulator::resetInitialHomePosition(){
 }
 
 
+/**
+ * @brief Simulator::updateLockstepSensors Hand the simulator state to the
+ * lockstep bridge, which sends it to the flight side with the next step
+ * @param out
+ */
+void Simulator::updateLockstepSensors(const Output2Hardware& out)
+{
+    struct hitl_lockstep_sensors sensors;
+    memset(&sensors, 0, sizeof(sensors));
+
+    sensors.accels[0] = out.accX;
+    sensors.accels[1] = out.accY;
+    sensors.accels[2] = out.accZ;
+
+    sensors.gyros[0] = out.rollRate;
+    sensors.gyros[1] = out.pitchRate;
+    sensors.gyros[2] = out.yawRate;
+
+    sensors.baro[0] = out.altitude;
+
+    float rpy[3] = {out.roll, out.pitch, out.heading};
+    float quat[4];
+    Utils::CoordinateConversions().RPY2Quaternion(rpy,quat);
+    memcpy(sensors.q, quat, sizeof(quat));
+
+    sensors.velocity[0] = out.velNorth;
+    sensors.velocity[1] = out.velEast;
+    sensors.velocity[2] = out.velDown;
+
+    sensors.position[0] = out.dstN-initN;
+    sensors.position[1] = out.dstE-initE;
+    sensors.position[2] = out.dstD-initD;
+
+    lockstep->setSensors(sensors);
+}
+
+/**
+ * @brief Simulator::applyLockstepActuators Copy the actuators of the last
+ * answered lockstep step into ActuatorDesired before it is sent to the simulator
+ */
+void Simulator::applyLockstepActuators()
+{
+    float actuators[HITL_LOCKSTEP_NUM_ACTUATORS];
+    if (!lockstep->takeActuators(actuators))
+        return;
+
+    ActuatorDesired::DataFields actData = actDesired->getData();
+    actData.Roll = actuators[0];
+    actData.Pitch = actuators[1];
+    actData.Yaw = actuators[2];
+    actData.Throttle = actuators[3];
+    actDesired->setData(actData);
+}
+
+void Simulator::onLockstepStatistics(double stepsPerSecond, double meanJitterUs, double maxJitterUs, quint32 timeouts)
+{
+    emit processOutput(QString("Lockstep: %1 steps/s, jitter mean %2 us max %3 us, %4 timeouts\n")
+                       .arg(stepsPerSecond, 0, 'f', 1)
+                       .arg(meanJitterUs, 0, 'f', 1)
+                       .arg(maxJitterUs, 0, 'f', 1)
+                       .arg(timeouts));
+}
+
+
 void Simulator::updateUAVOs(Output2Hardware out){
 
     QTime currentTime = QTime::currentTime();
@@ -454,6 +536,12 @@ void Simulator::updateUAVOs(Output2Hardware out){
         homePositionSet=true;
     }
 
+    // In lockstep mode the sensors bypass the UAVObjects and telemetry
+    if (lockstep) {
+        updateLockstepSensors(out);
+        return;
+    }
+
     /*******************************/
     //Copy everything to the ground truth object. GroundTruth is Noise-free.
     GroundTruth::DataFields groundTruthData;
@@ -65,6 +65,7 @@
 
 #include "utils/coordinateconversions.h"
 #include "physical_constants.h"
+#include "hitllockstep.h"
 
 /**
  * just imagine this was a class without methods and all public properties
@@ -161,6 +162,10 @@ typedef struct _CONNECTION
     bool airspeedActualEnabled;
     quint16 airspeedActualRate;
 
+    bool lockstepEnabled;
+    quint16 lockstepRate;     //[Hz]
+    quint16 lockstepPort;
+
 } SimulatorSettings;
 
 
@@ -267,6 +272,8 @@ private slots:
     void onAutopilotConnect();
     void onAutopilotDisconnect();
     void onSimulatorConnectionTimeout();
+    void onLockstepStatistics(double stepsPerSecond, double meanJitterUs, double maxJitterUs, quint32 timeouts);
+    void applyLockstepActuators();
     Q_INVOKABLE void onDeleteSimulator(void);
 
     virtual void transmitUpdate() = 0;
@@ -315,6 +322,7 @@ private:
     volatile bool simConnectionStatus;
     QTimer* txTimer;
     QTimer* simTimer;
+    HitlLockstep* lockstep;
 
     QTime attRawTime;
     QTime gpsPosTime;
@@ -331,6 +339,7 @@ private:
     void setupOutputObject(UAVObject* obj, quint32 updatePeriod);
     void setupInputObject(UAVObject* obj, quint32 updatePeriod);
     void setupUAVObjects();
+    void updateLockstepSensors(const Output2Hardware& out);
     UAVObjectUtilManager* getObjectUtilManager();
     UAVObjectManager* getObjectManager();
 
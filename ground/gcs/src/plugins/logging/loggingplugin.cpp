@@ -179,7 +179,11 @@ void LoggingThread::run()
         QVector<UAVObject*>::const_iterator jEnd = (*i).constEnd();
         for (j = (*i).constBegin(); j != jEnd; ++j)
         {
-            connect(*j, SIGNAL(objectUpdated(UAVObject*)), (LoggingThread*) this, SLOT(objectUpdated(UAVObject*)));
+            // Updates received from the link are logged as they are unpacked on
+            // the telemetry thread, objectUpdated is coalesced for those.
+            connect(*j, SIGNAL(objectUnpacked(UAVObject*)), (LoggingThread*) this, SLOT(objectUpdated(UAVObject*)), Qt::DirectConnection);
+            connect(*j, SIGNAL(objectUpdatedAuto(UAVObject*)), (LoggingThread*) this, SLOT(objectUpdated(UAVObject*)));
+            connect(*j, SIGNAL(objectUpdatedManual(UAVObject*)), (LoggingThread*) this, SLOT(objectUpdated(UAVObject*)));
             objects++;
         }
     }
@@ -220,7 +224,7 @@ void LoggingThread::stopLogging()
         QVector<UAVObject*>::const_iterator jEnd = (*i).constEnd();
         for (j = (*i).constBegin(); j != jEnd; ++j)
         {
-            disconnect(*j, SIGNAL(objectUpdated(UAVObject*)), (LoggingThread*) this, SLOT(objectUpdated(UAVObject*)));
+            disconnect(*j, 0, (LoggingThread*) this, SLOT(objectUpdated(UAVObject*)));
         }
     }
 
@@ -27,6 +27,10 @@
  */
 
 #include "pfdgadgetwidget.h"
+#include "attitudeactual.h"
+#include "baroairspeed.h"
+#include "positionactual.h"
+#include "velocityactual.h"
 #include <utils/stylehelper.h>
 #include <utils/cachedsvgitem.h>
 #include <iostream>
@@ -249,49 +253,41 @@ void PFDGadgetWidget::updateLinkStatus(UAVObject *object1) {
   */
 void PFDGadgetWidget::updateAttitude(UAVObject *object1) {
     setToolTipPrivate();
-    UAVObjectField * rollField = object1->getField(QString("Roll"));
-    UAVObjectField * yawField = object1->getField(QString("Yaw"));
-    UAVObjectField * pitchField = object1->getField(QString("Pitch"));
-    if(rollField && yawField && pitchField) {
-        // These factors assume some things about the PFD SVG, namely:
-        // - Roll, Pitch and Heading value in degrees
-        // - Pitch lines are 300px high for a +20/-20 range, which means
-        //   7.5 pixels per pitch degree.
-        // TODO: loosen this constraint and only require a +/- 20 deg range,
-        //       and compute the height from the SVG element.
-        // Also: keep the integer value only, to avoid unnecessary redraws
-        rollTarget = -floor(rollField->getDouble()*10)/10;
-        if ((rollTarget - rollValue) > 180) {
-            rollValue += 360;
-        } else if (((rollTarget - rollValue) < -180)) {
-            rollValue -= 360;
-        }
-        pitchTarget = floor(pitchField->getDouble()*7.5);
-
-        // These factors assume some things about the PFD SVG, namely:
-        // - Heading value in degrees
-        // - "Scale" element is 540 degrees wide
-
-        // Corvus Corax: "If you want a smooth transition between two angles, It is usually solved that by substracting
-        // one from another, and if the result is >180 or <-180 I substract (respectively add) 360 degrees
-        // to it. That way you always get the "shorter difference" to turn in."
-        double fac = compassBandWidth/540;
-        headingTarget = yawField->getDouble()*(-fac);
-        if (headingTarget != headingTarget)
-            headingTarget = headingValue; // NaN checking.
-        if ((headingValue - headingTarget)/fac > 180) {
-            headingTarget += 360*fac;
-        } else if (((headingValue - headingTarget)/fac < -180)) {
-            headingTarget -= 360*fac;
-        }
-        headingTarget = floor(headingTarget*10)/10; // Avoid stupid redraws
+    // These factors assume some things about the PFD SVG, namely:
+    // - Roll, Pitch and Heading value in degrees
+    // - Pitch lines are 300px high for a +20/-20 range, which means
+    //   7.5 pixels per pitch degree.
+    // TODO: loosen this constraint and only require a +/- 20 deg range,
+    //       and compute the height from the SVG element.
+    // Also: keep the integer value only, to avoid unnecessary redraws
+    rollTarget = -floor(object1->read<AttitudeActual::Fields::Roll>()*10)/10;
+    if ((rollTarget - rollValue) > 180) {
+        rollValue += 360;
+    } else if (((rollTarget - rollValue) < -180)) {
+        rollValue -= 360;
+    }
+    pitchTarget = floor(object1->read<AttitudeActual::Fields::Pitch>()*7.5);
 
-        if (!dialTimer.isActive())
-            dialTimer.start(); // Rearm the dial Timer which might be stopped.
+    // These factors assume some things about the PFD SVG, namely:
+    // - Heading value in degrees
+    // - "Scale" element is 540 degrees wide
 
-    } else {
-        qDebug() << "Unable to get one of the fields for attitude update";
+    // Corvus Corax: "If you want a smooth transition between two angles, It is usually solved that by substracting
+    // one from another, and if the result is >180 or <-180 I substract (respectively add) 360 degrees
+    // to it. That way you always get the "shorter difference" to turn in."
+    double fac = compassBandWidth/540;
+    headingTarget = object1->read<AttitudeActual::Fields::Yaw>()*(-fac);
+    if (headingTarget != headingTarget)
+        headingTarget = headingValue; // NaN checking.
+    if ((headingValue - headingTarget)/fac > 180) {
+        headingTarget += 360*fac;
+    } else if (((headingValue - headingTarget)/fac < -180)) {
+        headingTarget -= 360*fac;
     }
+    headingTarget = floor(headingTarget*10)/10; // Avoid stupid redraws
+
+    if (!dialTimer.isActive())
+        dialTimer.start(); // Rearm the dial Timer which might be stopped.
 }
 
 /*!
@@ -311,18 +307,13 @@ void PFDGadgetWidget::updateHeading(UAVObject *object) {
   \brief Called by updates to @PositionActual to compute groundspeed from velocity
   */
 void PFDGadgetWidget::updateGroundspeed(UAVObject *object) {
-    UAVObjectField* northField = object->getField("North");
-    UAVObjectField* eastField = object->getField("East");
-    if (northField && eastField) {
-        double val = floor(sqrt(pow(northField->getDouble(),2) + pow(eastField->getDouble(),2))*10)/10;
-        groundspeedTarget = 3.6*val*speedScaleHeight/30;
-
-        if (!dialTimer.isActive())
-            dialTimer.start(); // Rearm the dial Timer which might be stopped.
+    double north = object->read<VelocityActual::Fields::North>();
+    double east = object->read<VelocityActual::Fields::East>();
+    double val = floor(sqrt(pow(north,2) + pow(east,2))*10)/10;
+    groundspeedTarget = 3.6*val*speedScaleHeight/30;
 
-    } else {
-        qDebug() << "UpdateHeading: Wrong field, maybe an issue with object disconnection ?";
-    }
+    if (!dialTimer.isActive())
+        dialTimer.start(); // Rearm the dial Timer which might be stopped.
 }
 
 
@@ -330,32 +321,20 @@ void PFDGadgetWidget::updateGroundspeed(UAVObject *object) {
   \brief Called by updates to @BaroAirspeed
   */
 void PFDGadgetWidget::updateAirspeed(UAVObject *object) {
-    UAVObjectField* airspeedField = object->getField("CalibratedAirspeed");
-    if (airspeedField) {
-        airspeedTarget = airspeedField->getDouble();
-
-        if (!dialTimer.isActive())
-            dialTimer.start(); // Rearm the dial Timer which might be stopped.
+    airspeedTarget = object->read<BaroAirspeed::Fields::CalibratedAirspeed>();
 
-    } else {
-        qDebug() << "UpdateHeading: Wrong field, maybe an issue with object disconnection ?";
-    }
+    if (!dialTimer.isActive())
+        dialTimer.start(); // Rearm the dial Timer which might be stopped.
 }
 
 /*!
   \brief Called by the @ref PositionActual updates to show altitude
   */
 void PFDGadgetWidget::updateAltitude(UAVObject *object) {
-    UAVObjectField* downField = object->getField("Down");
-    if (downField) {
-        altitudeTarget = -downField->getDouble();
+    altitudeTarget = -object->read<PositionActual::Fields::Down>();
 
-        if (!dialTimer.isActive())
-            dialTimer.start(); // Rearm the dial Timer which might be stopped.
-
-    } else {
-        qDebug() << "Unable to get field for altitude update.  Obj: " << object->getName();
-    }
+    if (!dialTimer.isActive())
+        dialTimer.start(); // Rearm the dial Timer which might be stopped.
 }
 
 
@@ -18,7 +18,8 @@ HEADERS += \
     pfdqmlgadgetfactory.h \
     pfdqmlgadgetconfiguration.h \
     pfdqmlgadgetoptionspage.h \
-    lowpassfilter.h
+    lowpassfilter.h \
+    uavobjectsnapshot.h
 
 SOURCES += \
     pfdqmlplugin.cpp \
@@ -27,7 +28,8 @@ SOURCES += \
     pfdqmlgadgetwidget.cpp \
     pfdqmlgadgetconfiguration.cpp \
     pfdqmlgadgetoptionspage.cpp \
-    lowpassfilter.cpp
+    lowpassfilter.cpp \
+    uavobjectsnapshot.cpp
 
 
 contains(DEFINES,USE_OSG) {
@@ -32,6 +32,7 @@
 #include <QtDeclarative/qdeclarativecontext.h>
 #include <QtDeclarative/qdeclarative.h>
 #include "lowpassfilter.h"
+#include "uavobjectsnapshot.h"
 #include "stabilizationdesired.h"
 
 PfdQmlGadgetWidget::PfdQmlGadgetWidget(QWidget *parent) :
@@ -78,12 +79,16 @@ PfdQmlGadgetWidget::PfdQmlGadgetWidget(QWidget *parent) :
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     m_objManager = pm->getObject<UAVObjectManager>();
 
+    // The objects are handed to QML as snapshots latched once per frame
+    m_snapshot = new UAVObjectSnapshot(engine()->rootContext(), m_objManager, this);
     foreach (const QString &objectName, objectsToExport) {
         exportUAVOInstance(objectName, 0);
     }
 
     //to expose settings values
     engine()->rootContext()->setContextProperty("qmlWidget", this);
+    //frame rate and notification counters
+    engine()->rootContext()->setContextProperty("pfdStatistics", m_snapshot);
 #ifdef USE_OSG
     qmlRegisterType<OsgEarthItem>("org.OpenPilot", 1, 0, "OsgEarth");
 #endif
@@ -99,16 +104,13 @@ PfdQmlGadgetWidget::~PfdQmlGadgetWidget()
 
 /**
  * @brief PfdQmlGadgetWidget::exportUAVOInstance Makes the UAVO available inside the QML. This works via the Q_PROPERTY()
- * values in the UAVO synthetic-headers
+ * values in the UAVO synthetic-headers, copied into a per frame snapshot
  * @param objectName UAVObject name
  * @param instId Instance ID
  */
 void PfdQmlGadgetWidget::exportUAVOInstance(const QString &objectName, int instId)
 {
-    UAVObject* object = m_objManager->getObject(objectName, instId);
-    if (object)
-        engine()->rootContext()->setContextProperty(objectName, object);
-    else
+    if (!m_snapshot->addObject(objectName, instId))
         qWarning() << "Failed to load object" << objectName;
 }
 
@@ -122,7 +124,7 @@ void PfdQmlGadgetWidget::resetUAVOExport(const QString &objectName, int instId)
 {
     UAVObject* object = m_objManager->getObject(objectName, instId);
     if (object)
-        engine()->rootContext()->setContextProperty(objectName, (QObject*)NULL);
+        m_snapshot->removeObject(objectName, instId);
     else
         qWarning() << "Failed to load object" << objectName;
 }
@@ -234,6 +236,7 @@ void PfdQmlGadgetWidget::hideEvent(QHideEvent *event)
     foreach (const QString &objectName, objectsToExport) {
         resetUAVOExport(objectName, 0);
     }
+    m_snapshot->stop();
 
     QWidget::hideEvent(event);
 }
@@ -252,6 +255,18 @@ void PfdQmlGadgetWidget::showEvent(QShowEvent *event)
     foreach (const QString &objectName, objectsToExport) {
         exportUAVOInstance(objectName, 0);
     }
+    m_snapshot->start();
 
     QWidget::showEvent(event);
 }
+
+/**
+ * @brief PfdQmlGadgetWidget::paintEvent Reimplements paintEvent() to count
+ * the rendered frames for the frame rate statistics
+ * @param event
+ */
+void PfdQmlGadgetWidget::paintEvent(QPaintEvent *event)
+{
+    QDeclarativeView::paintEvent(event);
+    m_snapshot->frameRendered();
+}
@@ -21,6 +21,7 @@
 #include <QtDeclarative/qdeclarativeview.h>
 
 class UAVObjectManager;
+class UAVObjectSnapshot;
 
 class PfdQmlGadgetWidget : public QDeclarativeView
 {
@@ -82,8 +83,10 @@ private:
     double m_altitude;
 
     UAVObjectManager *m_objManager;
+    UAVObjectSnapshot *m_snapshot;
     void hideEvent(QHideEvent *event);
     void showEvent(QShowEvent *event);
+    void paintEvent(QPaintEvent *event);
     void exportUAVOInstance(const QString &objectName, int instId);
     void resetUAVOExport(const QString &objectName, int instId);
 };
@@ -0,0 +1,157 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "uavobjectsnapshot.h"
+#include "uavobjectmanager.h"
+#include "uavobject.h"
+#include <QDebug>
+#include <QMetaProperty>
+#include <QTimerEvent>
+#include <QtDeclarative/qdeclarativecontext.h>
+
+//! Snapshot rate, matches the usual 60Hz display refresh
+static const int FRAME_PERIOD_MS = 1000 / 60;
+
+//! Interval over which the rate statistics are averaged
+static const int STATISTICS_PERIOD_MS = 1000;
+
+UAVObjectSnapshot::UAVObjectSnapshot(QDeclarativeContext *context, UAVObjectManager *objManager, QObject *parent) :
+    QObject(parent),
+    m_context(context),
+    m_objManager(objManager),
+    m_frames(0),
+    m_updates(0),
+    m_notifications(0),
+    m_framesPerSecond(0),
+    m_updatesPerSecond(0),
+    m_notificationsPerSecond(0)
+{
+}
+
+UAVObjectSnapshot::~UAVObjectSnapshot()
+{
+}
+
+/**
+ * @brief UAVObjectSnapshot::addObject Exports the UAVO to the QML context under its
+ * name. Its current values are published right away.
+ * @param objectName UAVObject name
+ * @param instId Instance ID
+ * @return true if the object exists
+ */
+bool UAVObjectSnapshot::addObject(const QString &objectName, int instId)
+{
+    UAVObject *object = m_objManager->getObject(objectName, instId);
+    if (!object)
+        return false;
+
+    if (!m_exported.contains(object)) {
+        m_exported.insert(object, objectName);
+        connect(object, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)));
+    }
+    publish(object);
+    return true;
+}
+
+/**
+ * @brief UAVObjectSnapshot::removeObject Makes the UAVO no longer available inside the QML.
+ * @param objectName UAVObject name
+ * @param instId Instance ID
+ */
+void UAVObjectSnapshot::removeObject(const QString &objectName, int instId)
+{
+    UAVObject *object = m_objManager->getObject(objectName, instId);
+    if (!object)
+        return;
+
+    disconnect(object, 0, this, 0);
+    m_exported.remove(object);
+    m_dirty.remove(object);
+    m_context->setContextProperty(objectName, QVariant());
+}
+
+void UAVObjectSnapshot::start()
+{
+    m_frames = m_updates = m_notifications = 0;
+    m_statisticsTimer.start();
+    m_frameTimer.start(FRAME_PERIOD_MS, this);
+}
+
+void UAVObjectSnapshot::stop()
+{
+    m_frameTimer.stop();
+    m_dirty.clear();
+}
+
+void UAVObjectSnapshot::objectUpdated(UAVObject *obj)
+{
+    m_updates++;
+    m_dirty.insert(obj);
+}
+
+void UAVObjectSnapshot::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() != m_frameTimer.timerId()) {
+        QObject::timerEvent(event);
+        return;
+    }
+
+    latch();
+
+    if (m_statisticsTimer.elapsed() >= STATISTICS_PERIOD_MS)
+        updateStatistics();
+}
+
+/**
+ * Publish a new snapshot of every object updated since the last frame
+ */
+void UAVObjectSnapshot::latch()
+{
+    foreach (UAVObject *obj, m_dirty) {
+        publish(obj);
+    }
+    m_dirty.clear();
+}
+
+/**
+ * Copy all the QML visible properties of the object into a map and hand
+ * it to the context, which causes one change notification for all the
+ * bindings using this object.
+ */
+void UAVObjectSnapshot::publish(UAVObject *obj)
+{
+    const QMetaObject *meta = obj->metaObject();
+    QVariantMap values;
+    for (int i = meta->propertyOffset(); i < meta->propertyCount(); ++i) {
+        QMetaProperty property = meta->property(i);
+        values.insert(QString::fromLatin1(property.name()), property.read(obj));
+    }
+
+    m_context->setContextProperty(m_exported.value(obj), values);
+    m_notifications++;
+}
+
+void UAVObjectSnapshot::updateStatistics()
+{
+    qreal seconds = m_statisticsTimer.restart() / 1000.0;
+
+    m_framesPerSecond = m_frames / seconds;
+    m_updatesPerSecond = m_updates / seconds;
+    m_notificationsPerSecond = m_notifications / seconds;
+    m_frames = m_updates = m_notifications = 0;
+
+    emit statisticsChanged();
+}
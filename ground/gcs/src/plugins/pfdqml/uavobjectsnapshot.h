@@ -0,0 +1,92 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef UAVOBJECTSNAPSHOT_H_
+#define UAVOBJECTSNAPSHOT_H_
+
+#include <QObject>
+#include <QBasicTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QVariantMap>
+
+class UAVObject;
+class UAVObjectManager;
+class QDeclarativeContext;
+
+/**
+ * Exports UAVObjects to a QML context as once per frame snapshots.
+ *
+ * Instead of handing the UAVObject itself to QML, which emits one NOTIFY
+ * signal per field on every unpack, the object values are latched into a
+ * QVariantMap once per display frame and only for the objects that were
+ * updated. QML bindings then see a single change per object and frame.
+ */
+class UAVObjectSnapshot : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(qreal framesPerSecond READ framesPerSecond NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal updatesPerSecond READ updatesPerSecond NOTIFY statisticsChanged)
+    Q_PROPERTY(qreal notificationsPerSecond READ notificationsPerSecond NOTIFY statisticsChanged)
+public:
+    UAVObjectSnapshot(QDeclarativeContext *context, UAVObjectManager *objManager, QObject *parent = 0);
+    ~UAVObjectSnapshot();
+
+    bool addObject(const QString &objectName, int instId = 0);
+    void removeObject(const QString &objectName, int instId = 0);
+
+    void start();
+    void stop();
+
+    //! Called by the view every time a frame was painted
+    void frameRendered() { m_frames++; }
+
+    qreal framesPerSecond() const { return m_framesPerSecond; }
+    qreal updatesPerSecond() const { return m_updatesPerSecond; }
+    qreal notificationsPerSecond() const { return m_notificationsPerSecond; }
+
+signals:
+    void statisticsChanged();
+
+private slots:
+    void objectUpdated(UAVObject *obj);
+
+protected:
+    void timerEvent(QTimerEvent *event);
+
+private:
+    void latch();
+    void publish(UAVObject *obj);
+    void updateStatistics();
+
+    QDeclarativeContext *m_context;
+    UAVObjectManager *m_objManager;
+
+    QHash<UAVObject *, QString> m_exported;
+    QSet<UAVObject *> m_dirty;
+    QBasicTimer m_frameTimer;
+
+    QElapsedTimer m_statisticsTimer;
+    quint32 m_frames;
+    quint32 m_updates;
+    quint32 m_notifications;
+    qreal m_framesPerSecond;
+    qreal m_updatesPerSecond;
+    qreal m_notificationsPerSecond;
+};
+
+#endif /* UAVOBJECTSNAPSHOT_H_ */
@@ -155,13 +155,29 @@ Plot3dData::~Plot3dData()
 double PlotData::valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName)
 {
     Q_UNUSED(obj);
-    QVariant value;
 
     if(haveSubField){
-        int indexOfSubField = field->getElementNames().indexOf(QRegExp(uavSubFieldName, Qt::CaseSensitive, QRegExp::FixedString));
-        value = field->getValue(indexOfSubField);
+        // All instances share the same element names
+        if (subFieldIndex < 0)
+            subFieldIndex = field->getElementNames().indexOf(uavSubFieldName);
+        return field->getDouble(subFieldIndex);
     }else
-        value = field->getValue();
+        return field->getDouble();
+}
+
+
+/**
+ * @brief fieldOf Return the plotted field of a UAVO instance
+ * @param obj UAVO
+ * @return the field, or NULL if the object has no such field
+ */
+UAVObjectField* PlotData::fieldOf(UAVObject* obj)
+{
+    QHash<UAVObject*, UAVObjectField*>::const_iterator it = fieldCache.constFind(obj);
+    if (it != fieldCache.constEnd())
+        return it.value();
 
-    return value.toDouble();
+    UAVObjectField* field = obj->getField(uavFieldName);
+    fieldCache.insert(obj, field);
+    return field;
 }
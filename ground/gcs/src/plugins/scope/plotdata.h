@@ -40,12 +40,15 @@ class ScopeConfig;
 #include <QTimer>
 #include <QTime>
 #include <QVector>
+#include <QHash>
 
 
 class PlotData : public QObject
 {
     Q_OBJECT
 public:
+    PlotData() : subFieldIndex(-1) {}
+
     double valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName);
 
     //Setter functions
@@ -109,8 +112,12 @@ protected:
     double correctionSum;
     int correctionCount;
 
-private:
+    UAVObjectField* fieldOf(UAVObject* obj);
 
+private:
+    // Field and element lookups are resolved once instead of on every sample
+    QHash<UAVObject*, UAVObjectField*> fieldCache;
+    int subFieldIndex;
 };
 
 /**
@@ -99,7 +99,7 @@ bool HistogramData::append(UAVObject* obj)
     if (uavObjectName == obj->getName()) {
 
         //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
+        UAVObjectField* field = fieldOf(obj);
 
         //Bad place to do this
         double step = binWidth;
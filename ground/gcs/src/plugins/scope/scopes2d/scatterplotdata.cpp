@@ -87,7 +87,7 @@ bool SeriesPlotData::append(UAVObject* obj)
     if (uavObjectName == obj->getName()) {
 
         //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
+        UAVObjectField* field = fieldOf(obj);
 
         if (field) {
 
@@ -154,7 +154,7 @@ bool TimeSeriesPlotData::append(UAVObject* obj)
 {
     if (uavObjectName == obj->getName()) {
         //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
+        UAVObjectField* field = fieldOf(obj);
 
         if (field) {
             QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
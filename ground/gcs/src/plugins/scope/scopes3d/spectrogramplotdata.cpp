@@ -168,13 +168,13 @@ bool SpectrogramData::append(UAVObject* multiObj)
         QVector<double> values;
 
         timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
-        UAVObjectField* multiField =  multiObj->getField(uavFieldName);
+        UAVObjectField* multiField = fieldOf(multiObj);
         Q_ASSERT(multiField);
         if (multiField ) {
 
             // Get the field of interest
             foreach (UAVObject *obj, list) {
-                UAVObjectField* field =  obj->getField(uavFieldName);
+                UAVObjectField* field = fieldOf(obj);
 
                 double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
 
@@ -82,45 +82,105 @@ void SystemHealthGadgetWidget::onAutopilotDisconnect()
     nolink->setVisible(true);
 }
 
-void SystemHealthGadgetWidget::updateAlarms(UAVObject* systemAlarm)
+/**
+  * Create one persistent indicator item per alarm element. The location
+  * of each alarm inside the SVG and the list of existing "<alarm>-<value>"
+  * elements are looked up once here instead of on every update, as the
+  * renderer lookups are expensive DOM queries.
+  */
+void SystemHealthGadgetWidget::buildIndicators()
 {
-    // This code does not know anything about alarms beforehand, and
-    // I found no efficient way to locate items inside the scene by
-    // name, so it's just as simple to reset the scene:
-    // And add the one with the right name.
-    QGraphicsScene *m_scene = scene();
-    foreach ( QGraphicsItem* item ,background->childItems()){
-        m_scene->removeItem(item);
-        delete item; // removeItem does _not_ delete the item.
+    clearIndicators();
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    SystemAlarms *obj = SystemAlarms::GetInstance(objManager);
+    Q_ASSERT(obj);
+    if (obj == NULL)
+        return;
+
+    UAVObjectField *field = obj->getField("Alarm");
+    Q_ASSERT(field);
+    if (field == NULL)
+        return;
+
+    QStringList elements = field->getElementNames();
+    QStringList options = field->getOptions();
+    indicators.resize(elements.size());
+
+    for (int i = 0; i < elements.size(); ++i) {
+        const QString &element = elements.at(i);
+        indicators[i].item = NULL;
+        indicators[i].element = element;
+        indicators[i].value = QString();
+
+        if (!m_renderer->elementExists(element)) {
+            qDebug() << "[SystemHealth] Warning: The SystemHealth SVG does not contain a graphical element for the " << element << " alarm.";
+            continue;
+        }
+
+        foreach (const QString &option, options) {
+            QString element2 = element + "-" + option;
+            if (m_renderer->elementExists(element2))
+                indicatorElements.insert(element2);
+        }
+
+        QMatrix blockMatrix = m_renderer->matrixForElement(element);
+        QRectF bounds = blockMatrix.mapRect(m_renderer->boundsOnElement(element));
+
+        QGraphicsSvgItem *ind = new QGraphicsSvgItem();
+        ind->setSharedRenderer(m_renderer);
+        ind->setParentItem(background);
+        QTransform matrix;
+        matrix.translate(bounds.x(), bounds.y());
+        ind->setTransform(matrix, false);
+        ind->setVisible(false);
+        indicators[i].item = ind;
     }
+}
 
+/**
+  * Remove all the indicator items from the scene
+  */
+void SystemHealthGadgetWidget::clearIndicators()
+{
+    foreach (const AlarmIndicator &indicator, indicators) {
+        if (indicator.item) {
+            scene()->removeItem(indicator.item);
+            delete indicator.item; // removeItem does _not_ delete the item.
+        }
+    }
+    indicators.clear();
+    indicatorElements.clear();
+}
+
+void SystemHealthGadgetWidget::updateAlarms(UAVObject* systemAlarm)
+{
     UAVObjectField *field = systemAlarm->getField("Alarm");
     Q_ASSERT(field);
     if (field == NULL)
         return;
 
-    for (uint i = 0; i < field->getNumElements(); ++i) {
-        QString element = field->getElementNames()[i];
+    int numElements = qMin((int) field->getNumElements(), indicators.size());
+    for (int i = 0; i < numElements; ++i) {
+        AlarmIndicator &indicator = indicators[i];
+        if (indicator.item == NULL)
+            continue;
+
+        // Only touch the items whose alarm actually changed
         QString value = field->getValue(i).toString();
-        if (m_renderer->elementExists(element)) {
-            QMatrix blockMatrix = m_renderer->matrixForElement(element);
-            qreal startX = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).x();
-            qreal startY = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).y();
-            QString element2 = element + "-" + value;
-            if (m_renderer->elementExists(element2)) {
-                QGraphicsSvgItem *ind = new QGraphicsSvgItem();
-                ind->setSharedRenderer(m_renderer);
-                ind->setElementId(element2);
-                ind->setParentItem(background);
-                QTransform matrix;
-                matrix.translate(startX,startY);
-                ind->setTransform(matrix,false);
-            } else {
-                if (value.compare("Uninitialised") != 0)
-                    qDebug() << "[SystemHealth] Warning: The SystemHealth SVG does not contain a graphical element for the " << element2 << " alarm.";
-            }
+        if (value == indicator.value)
+            continue;
+        indicator.value = value;
+
+        QString element2 = indicator.element + "-" + value;
+        if (indicatorElements.contains(element2)) {
+            indicator.item->setElementId(element2);
+            indicator.item->setVisible(true);
         } else {
-            qDebug() << "[SystemHealth] Warning: The SystemHealth SVG does not contain a graphical element for the " << element << " alarm.";
+            indicator.item->setVisible(false);
+            if (value.compare("Uninitialised") != 0)
+                qDebug() << "[SystemHealth] Warning: The SystemHealth SVG does not contain a graphical element for the " << element2 << " alarm.";
         }
     }
 }
@@ -157,11 +217,13 @@ void SystemHealthGadgetWidget::setSystemFile(QString dfn)
          l_scene->setSceneRect(background->boundingRect());
          fitInView(background, Qt::KeepAspectRatio );
 
+         buildIndicators();
+
          // Check whether the autopilot is connected already, by the way:
          ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
          UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
          TelemetryManager* telMngr = pm->getObject<TelemetryManager>();
-         if (telMngr->isConnected()) {
+         if (telMngr && telMngr->isConnected()) {
              onAutopilotConnect();
              SystemAlarms* obj = dynamic_cast<SystemAlarms*>(objManager->getObject(QString("SystemAlarms")));
              updateAlarms(obj);
@@ -210,7 +272,7 @@ void SystemHealthGadgetWidget::mousePressEvent ( QMouseEvent * event )
         foreach(QGraphicsItem* sceneItem, items(point)){
             QGraphicsSvgItem *clickedItem = dynamic_cast<QGraphicsSvgItem*>(sceneItem);
 
-            if(clickedItem){
+            if(clickedItem && clickedItem->isVisible()){
                 if((clickedItem != foreground) && (clickedItem != background)){
                     // Clicked an actual alarm. We need to set haveAlarmItem to true
                     // as two of the items in this loop will always be foreground and
@@ -250,7 +312,7 @@ void SystemHealthGadgetWidget::showAllAlarmDescriptions(const QPoint& location){
         // Loop through all items in the scene looking for svg items that represent alarms
         foreach(QGraphicsItem* curItem, graphicsScene->items()){
             QGraphicsSvgItem* curSvgItem = dynamic_cast<QGraphicsSvgItem*>(curItem);
-            if(curSvgItem && (curSvgItem != foreground) && (curSvgItem != background)){
+            if(curSvgItem && curSvgItem->isVisible() && (curSvgItem != foreground) && (curSvgItem != background)){
                 QString elementId = curSvgItem->elementId();
                 if(!elementId.contains("OK")){
                     // Found an alarm, get its corresponding alarm html file contents
@@ -36,6 +36,8 @@
 #include <QtSvg/QGraphicsSvgItem>
 #include <QMouseEvent>
 #include <QMap>
+#include <QSet>
+#include <QVector>
 #include <QFile>
 #include <QTimer>
 
@@ -61,6 +63,17 @@ private slots:
    void onAutopilotDisconnect();
 
 private:
+   /**
+    * One persistent indicator per alarm. The geometry of each alarm
+    * element is resolved once when the SVG is loaded, so an update only
+    * has to switch the element id of the items whose value changed.
+    */
+   struct AlarmIndicator {
+       QGraphicsSvgItem *item;
+       QString element;
+       QString value;
+   };
+
    QSvgRenderer *m_renderer;
    QGraphicsSvgItem *background;
    QGraphicsSvgItem *foreground;
@@ -69,6 +82,14 @@ private:
                    // Simple flag to skip rendering if the
    bool fgenabled; // layer does not exist.
 
+   // Alarm indicators, in the order of the SystemAlarms.Alarm elements
+   QVector<AlarmIndicator> indicators;
+   // All "<alarm>-<value>" element ids present in the current SVG
+   QSet<QString> indicatorElements;
+
+   void buildIndicators();
+   void clearIndicators();
+
    void showAlarmDescriptionForItemId(const QString itemId, const QPoint& location);
    void showAllAlarmDescriptions(const QPoint &location);
    QString getAlarmDescriptionFileName(const QString itemId);
@@ -0,0 +1,88 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup SystemHealthPlugin System Health Plugin
+ * @{
+ * @brief Measures the SystemHealth alarm update rate
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "../systemhealthgadgetwidget.h"
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+#include "systemalarms.h"
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+/**
+  * Cycle every alarm through all its possible values and report the
+  * updates/s the widget reaches with the given SVG. The object is
+  * restored afterwards, which also resets the alarm items through the
+  * normal objectUpdated path.
+  */
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QTextStream sout(stdout);
+
+    if (argc < 2) {
+        sout << "usage: " << argv[0] << " <system-health.svg> [iterations]\n";
+        return 1;
+    }
+    int iterations = argc > 2 ? QString(argv[2]).toInt() : 1000;
+
+    ExtensionSystem::PluginManager pm;
+    UAVObjectManager *objManager = new UAVObjectManager();
+    UAVObjectsInitialize(objManager);
+    pm.addObject(objManager);
+
+    SystemHealthGadgetWidget widget;
+    widget.setSystemFile(QString(argv[1]));
+    widget.show();
+    app.processEvents();
+
+    SystemAlarms *obj = SystemAlarms::GetInstance(objManager);
+    UAVObjectField *field = obj->getField("Alarm");
+    QStringList options = field->getOptions();
+    SystemAlarms::DataFields saved = obj->getData();
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int n = 0; n < iterations; ++n) {
+        for (uint i = 0; i < field->getNumElements(); ++i)
+            field->setValue(options.at((n + i) % options.size()), i);
+        obj->updated();
+        widget.viewport()->repaint();
+    }
+    qint64 elapsed = timer.elapsed();
+
+    obj->setData(saved);
+    widget.viewport()->repaint();
+
+    sout << iterations << " updates in " << elapsed << " ms ("
+         << (elapsed > 0 ? iterations * 1000.0 / elapsed : 0.0) << " updates/s)\n";
+
+    pm.removeObject(objManager);
+    delete objManager;
+    return 0;
+}
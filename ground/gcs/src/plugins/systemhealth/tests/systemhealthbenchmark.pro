@@ -0,0 +1,22 @@
+# -------------------------------------------------
+# Standalone benchmark of the SystemHealth alarm updates.
+# Not part of the GCS build, run it by hand:
+#   systemhealthbenchmark <system-health.svg> [iterations]
+# -------------------------------------------------
+include(../../../../gcs.pri)
+QT += svg
+TARGET = systemhealthbenchmark
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins
+LIBS += -L$$GCS_PLUGIN_PATH/TauLabs
+QMAKE_RPATHDIR += $$GCS_LIBRARY_PATH $$GCS_PLUGIN_PATH/TauLabs
+include(../../../libs/extensionsystem/extensionsystem.pri)
+include(../../coreplugin/coreplugin.pri)
+include(../systemhealth_dependencies.pri)
+
+SOURCES += main.cpp \
+    ../systemhealthgadgetwidget.cpp
+HEADERS += ../systemhealthgadgetwidget.h
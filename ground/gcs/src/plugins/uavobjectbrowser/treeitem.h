@@ -34,6 +34,7 @@
 #include <QtCore/QList>
 #include <QtCore/QLinkedList>
 #include <QtCore/QMap>
+#include <QtCore/QHash>
 #include <QtCore/QVariant>
 #include <QtCore/QTime>
 #include <QtCore/QTimer>
@@ -197,7 +198,7 @@ public:
     }
 
     DataObjectTreeItem* findDataObjectTreeItemByObjectId(quint32 objectId) {
-        return m_objectTreeItemsPerObjectIds.contains(objectId) ? m_objectTreeItemsPerObjectIds[objectId] : 0;
+        return m_objectTreeItemsPerObjectIds.value(objectId, 0);
     }
 
     void addMetaObjectTreeItem(quint32 objectId, MetaObjectTreeItem* oti) {
@@ -205,14 +206,14 @@ public:
     }
 
     MetaObjectTreeItem* findMetaObjectTreeItemByObjectId(quint32 objectId) {
-        return m_metaObjectTreeItemsPerObjectIds.contains(objectId) ? m_metaObjectTreeItemsPerObjectIds[objectId] : 0;
+        return m_metaObjectTreeItemsPerObjectIds.value(objectId, 0);
     }
 
     QList<MetaObjectTreeItem*> getMetaObjectItems();
 
 private:
-    QMap<quint32, DataObjectTreeItem*> m_objectTreeItemsPerObjectIds;
-    QMap<quint32, MetaObjectTreeItem*> m_metaObjectTreeItemsPerObjectIds;
+    QHash<quint32, DataObjectTreeItem*> m_objectTreeItemsPerObjectIds;
+    QHash<quint32, MetaObjectTreeItem*> m_metaObjectTreeItemsPerObjectIds;
 };
 
 class ObjectTreeItem : public TreeItem
@@ -38,6 +38,7 @@
 #include <QtCore/QSignalMapper>
 #include <QtCore/QDebug>
 #include <math.h>
+#include <string.h>
 
 UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool categorize, bool useScientificNotation) :
     QAbstractItemModel(parent),
@@ -58,6 +59,11 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool categorize, bool us
                                                                                  // out. In any case, never go faster than 10ms.
 
 
+    // Object updates are accumulated and flushed once per display frame
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(1000 / 60);
+    connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flushUpdatedObjects()));
+
     // Create highlight manager, let it run every 300 ms.
     m_highlightManager = new HighLightManager(300, &m_currentTime);
     connect(objManager, SIGNAL(newObject(UAVObject*)), this, SLOT(newObject(UAVObject*)));
@@ -162,13 +168,7 @@ MetaObjectTreeItem* UAVObjectTreeModel::addMetaObject(UAVMetaObject *obj, TreeIt
 
     meta->setHighlightManager(m_highlightManager);
     connect(meta, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
-    foreach (UAVObjectField *field, obj->getFields()) {
-        if (field->getNumElements() > 1) {
-            addArrayField(field, meta);
-        } else {
-            addSingleField(0, field, meta);
-        }
-    }
+    addFields(obj, meta);
     parent->appendChild(meta);
     return meta;
 }
@@ -176,11 +176,10 @@ MetaObjectTreeItem* UAVObjectTreeModel::addMetaObject(UAVMetaObject *obj, TreeIt
 void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
 {
     connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(highlightUpdatedObject(UAVObject*)));
-    TreeItem *item;
+    ObjectTreeItem *item;
     if (obj->isSingleInstance()) {
-        item = parent;
-        DataObjectTreeItem *p = static_cast<DataObjectTreeItem*>(parent);
-        p->setObject(obj);
+        item = static_cast<DataObjectTreeItem*>(parent);
+        item->setObject(obj);
     } else {
         QString name = tr("Instance") +  " " + QString::number(obj->getInstID());
         item = new InstanceTreeItem(obj, name);
@@ -196,16 +195,30 @@ void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
         // Inform the model that the row addition is complete
         endInsertRows();
     }
+    addFields(obj, item);
+}
+
+/**
+ * Add the field items of an object to its tree item and register the
+ * object so that updates can find them without searching the tree.
+ */
+void UAVObjectTreeModel::addFields(UAVObject *obj, ObjectTreeItem *item)
+{
+    ObjectEntry entry;
+    entry.item = item;
     foreach (UAVObjectField *field, obj->getFields()) {
+        TreeItem *fieldItem;
         if (field->getNumElements() > 1) {
-            addArrayField(field, item);
+            fieldItem = addArrayField(field, item);
         } else {
-            addSingleField(0, field, item);
+            fieldItem = addSingleField(0, field, item);
         }
+        entry.fields.append(qMakePair(field, fieldItem));
     }
+    m_objectEntries.insert(obj, entry);
 }
 
-void UAVObjectTreeModel::addArrayField(UAVObjectField *field, TreeItem *parent)
+TreeItem *UAVObjectTreeModel::addArrayField(UAVObjectField *field, TreeItem *parent)
 {
     TreeItem *item = new ArrayFieldTreeItem(field->getName());
     item->setHighlightManager(m_highlightManager);
@@ -214,9 +227,10 @@ void UAVObjectTreeModel::addArrayField(UAVObjectField *field, TreeItem *parent)
         addSingleField(i, field, item);
     }
     parent->appendChild(item);
+    return item;
 }
 
-void UAVObjectTreeModel::addSingleField(int index, UAVObjectField *field, TreeItem *parent)
+TreeItem *UAVObjectTreeModel::addSingleField(int index, UAVObjectField *field, TreeItem *parent)
 {
     QList<QVariant> data;
     if (field->getNumElements() == 1)
@@ -257,6 +271,7 @@ void UAVObjectTreeModel::addSingleField(int index, UAVObjectField *field, TreeIt
     item->setHighlightManager(m_highlightManager);
     connect(item, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
     parent->appendChild(item);
+    return item;
 }
 
 QModelIndex UAVObjectTreeModel::index(int row, int column, const QModelIndex &parent)
@@ -284,16 +299,7 @@ QModelIndex UAVObjectTreeModel::index(TreeItem *item)
     if (item->parent() == 0)
         return QModelIndex();
 
-    QModelIndex root = index(item->parent());
-
-    for (int i = 0; i < rowCount(root); ++i) {
-        QModelIndex childIndex = index(i, 0, root);
-        TreeItem *child = static_cast<TreeItem*>(childIndex.internalPointer());
-        if (child == item)
-            return childIndex;
-    }
-    Q_ASSERT(false);
-    return QModelIndex();
+    return createIndex(item->row(), 0, item);
 }
 
 QModelIndex UAVObjectTreeModel::parent(const QModelIndex &index) const
@@ -429,50 +435,79 @@ QVariant UAVObjectTreeModel::headerData(int section, Qt::Orientation orientation
     return QVariant();
 }
 
+/**
+ * Mark an object as updated. The tree is only refreshed by
+ * flushUpdatedObjects(), at most once per display frame, no matter
+ * how fast the object is updated over telemetry.
+ */
 void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
 {
     Q_ASSERT(obj);
-    ObjectTreeItem *item = findObjectTreeItem(obj);
-    Q_ASSERT(item);
-    if(!m_onlyHighlightChangedValues){
-        item->setHighlight(true);
-    }
-    item->update();
-    if(!m_onlyHighlightChangedValues){
-        QModelIndex itemIndex = index(item);
-        Q_ASSERT(itemIndex != QModelIndex());
-        emit dataChanged(itemIndex, itemIndex);
-    }
+    m_dirtyObjects.insert(obj);
+    if (!m_flushTimer.isActive())
+        m_flushTimer.start();
 }
 
-ObjectTreeItem* UAVObjectTreeModel::findObjectTreeItem(UAVObject *object)
+/**
+ * True if the item or one of its elements holds a value edited by the
+ * user but not yet sent to the object.
+ */
+bool UAVObjectTreeModel::hasUnsavedEdits(TreeItem *item)
 {
-    UAVDataObject *dataObject = qobject_cast<UAVDataObject*>(object);
-    UAVMetaObject *metaObject = qobject_cast<UAVMetaObject*>(object);
-    Q_ASSERT(dataObject || metaObject);
-    if (dataObject) {
-        return findDataObjectTreeItem(dataObject);
-    } else {
-        return findMetaObjectTreeItem(metaObject);
+    if (item->changed())
+        return true;
+    foreach (TreeItem *child, item->treeChildren()) {
+        if (hasUnsavedEdits(child))
+            return true;
     }
-    return 0;
+    return false;
 }
 
-DataObjectTreeItem* UAVObjectTreeModel::findDataObjectTreeItem(UAVDataObject *obj)
+/**
+ * Refresh the tree items of all objects updated since the last flush.
+ * Fields with unsaved edits are always reset to the object value. For
+ * the others only the ones whose packed data differs from what is
+ * displayed are read back, so only the cells that really changed are
+ * re-rendered.
+ */
+void UAVObjectTreeModel::flushUpdatedObjects()
 {
-    //Determine if the root tree is the settings or dynamic data tree
-    TopTreeItem *root = obj->isSettings() ? m_settingsTree : m_nonSettingsTree;
-    return root->findDataObjectTreeItemByObjectId(obj->getObjID());
-}
+    foreach (UAVObject *obj, m_dirtyObjects) {
+        QHash<UAVObject*, ObjectEntry>::iterator entry = m_objectEntries.find(obj);
+        Q_ASSERT(entry != m_objectEntries.end());
+        if (entry == m_objectEntries.end())
+            continue;
+
+        ObjectTreeItem *item = entry->item;
+        if(!m_onlyHighlightChangedValues){
+            item->setHighlight(true);
+        }
 
-MetaObjectTreeItem* UAVObjectTreeModel::findMetaObjectTreeItem(UAVMetaObject *obj)
-{
-    UAVDataObject *dataObject = qobject_cast<UAVDataObject*>(obj->getParentObject());
-    Q_ASSERT(dataObject);
+        int numBytes = obj->getNumBytes();
+        if (m_packBuffer.size() < numBytes)
+            m_packBuffer.resize(numBytes);
+        obj->pack((quint8 *) m_packBuffer.data());
+
+        bool fullUpdate = entry->snapshot.size() != numBytes;
+        for (int i = 0; i < entry->fields.size(); ++i) {
+            UAVObjectField *field = entry->fields.at(i).first;
+            TreeItem *fieldItem = entry->fields.at(i).second;
+            int offset = field->getDataOffset();
+            int fieldBytes = field->getNumBytes();
+            if (fullUpdate || hasUnsavedEdits(fieldItem) ||
+                    memcmp(entry->snapshot.constData() + offset,
+                           m_packBuffer.constData() + offset, fieldBytes) != 0)
+                fieldItem->update();
+        }
+        entry->snapshot = m_packBuffer.left(numBytes);
 
-    //Determine if the root tree is the settings or dynamic data tree
-    TopTreeItem *root = dataObject->isSettings() ? m_settingsTree : m_nonSettingsTree;
-    return root->findMetaObjectTreeItemByObjectId(obj->getObjID());
+        if(!m_onlyHighlightChangedValues){
+            QModelIndex itemIndex = index(item);
+            Q_ASSERT(itemIndex != QModelIndex());
+            emit dataChanged(itemIndex, itemIndex);
+        }
+    }
+    m_dirtyObjects.clear();
 }
 
 void UAVObjectTreeModel::updateHighlight(TreeItem *item)
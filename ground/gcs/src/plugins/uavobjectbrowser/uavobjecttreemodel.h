@@ -31,7 +31,10 @@
 #include "treeitem.h"
 #include <QAbstractItemModel>
 #include <QtCore/QMap>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
 #include <QtCore/QList>
+#include <QtCore/QTimer>
 #include <QtGui/QColor>
 
 class TopTreeItem;
@@ -85,6 +88,7 @@ public slots:
 
 private slots:
     void highlightUpdatedObject(UAVObject *obj);
+    void flushUpdatedObjects();
     void updateHighlight(TreeItem*);
     void updateCurrentTime();
 
@@ -93,16 +97,15 @@ private:
     QModelIndex index(TreeItem *item);
     void addDataObject(UAVDataObject *obj, bool categorize = true);
     MetaObjectTreeItem *addMetaObject(UAVMetaObject *obj, TreeItem *parent);
-    void addArrayField(UAVObjectField *field, TreeItem *parent);
-    void addSingleField(int index, UAVObjectField *field, TreeItem *parent);
+    TreeItem *addArrayField(UAVObjectField *field, TreeItem *parent);
+    TreeItem *addSingleField(int index, UAVObjectField *field, TreeItem *parent);
+    void addFields(UAVObject *obj, ObjectTreeItem *item);
     void addInstance(UAVObject *obj, TreeItem *parent);
+    static bool hasUnsavedEdits(TreeItem *item);
 
     TreeItem *createCategoryItems(QStringList categoryPath, TreeItem *root);
 
     QString updateMode(quint8 updateMode);
-    ObjectTreeItem *findObjectTreeItem(UAVObject *obj);
-    DataObjectTreeItem *findDataObjectTreeItem(UAVDataObject *obj);
-    MetaObjectTreeItem *findMetaObjectTreeItem(UAVMetaObject *obj);
 
     TreeItem *m_rootItem;
     TopTreeItem *m_settingsTree;
@@ -119,6 +122,24 @@ private:
 
     // Highlight manager to handle highlighting of tree items.
     HighLightManager *m_highlightManager;
+
+    /**
+     * Per object bookkeeping: the tree item showing the object, the tree
+     * item of each of its fields and a copy of the packed data as it was
+     * last displayed, used to find which fields really changed.
+     */
+    struct ObjectEntry {
+        ObjectTreeItem *item;
+        QList<QPair<UAVObjectField*, TreeItem*> > fields;
+        QByteArray snapshot;
+    };
+    QHash<UAVObject*, ObjectEntry> m_objectEntries;
+
+    // Objects updated since the last flush. Updates are coalesced and
+    // applied to the tree once per display frame.
+    QSet<UAVObject*> m_dirtyObjects;
+    QTimer m_flushTimer;
+    QByteArray m_packBuffer;
 };
 
 #endif // UAVOBJECTTREEMODEL_H
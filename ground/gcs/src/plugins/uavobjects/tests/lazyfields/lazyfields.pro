@@ -0,0 +1,17 @@
+# -------------------------------------------------
+# Unit test of the lazily created UAVObject fields.
+# Not part of the GCS build, run it by hand after building the plugins.
+# -------------------------------------------------
+include(../../../../../gcs.pri)
+QT += testlib
+TARGET = tst_lazyfields
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins
+LIBS += -L$$GCS_PLUGIN_PATH/TauLabs
+QMAKE_RPATHDIR += $$GCS_LIBRARY_PATH $$GCS_PLUGIN_PATH/TauLabs
+include(../../uavobjects.pri)
+
+SOURCES += tst_lazyfields.cpp
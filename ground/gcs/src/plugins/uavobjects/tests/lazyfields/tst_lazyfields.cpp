@@ -0,0 +1,276 @@
+/**
+ ******************************************************************************
+ *
+ * @file       tst_lazyfields.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief Checks the fields are created on first use, by every accessor
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "uavdataobject.h"
+#include "uavmetaobject.h"
+#include "uavobjectfield.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+
+/**
+ * A data object laid out as the generator writes them, counting the
+ * calls to createFields()
+ */
+class LazyObject : public UAVDataObject
+{
+    Q_OBJECT
+
+public:
+    typedef struct {
+        quint32 Counter;
+        float Gain[2];
+        quint8 Mode;
+    } __attribute__((packed)) DataFields;
+
+    static const quint32 OBJID = 0x1A2B3C4D;
+    static const quint32 NUMBYTES = sizeof(DataFields);
+
+    LazyObject() : UAVDataObject(OBJID, true, false, QString("LazyObject")), creations(0)
+    {
+        initializeData((quint8*)&data, NUMBYTES);
+        data.Counter = 7;
+        data.Gain[0] = 0.5f;
+        data.Gain[1] = 1.5f;
+        data.Mode = 2;
+    }
+
+    DataFields getData()
+    {
+        QMutexLocker locker(mutex);
+        return data;
+    }
+
+    Metadata getDefaultMetadata()
+    {
+        Metadata metadata;
+        MetadataInitialize(metadata);
+        return metadata;
+    }
+
+    UAVDataObject* clone(quint32 instID)
+    {
+        LazyObject *obj = new LazyObject();
+        obj->initialize(instID, getMetaObject());
+        return obj;
+    }
+
+    UAVDataObject* dirtyClone()
+    {
+        return clone(getInstID());
+    }
+
+    int creations;
+
+protected:
+    void createFields()
+    {
+        creations++;
+
+        QList<UAVObjectField*> fields;
+        fields.append( new UAVObjectField(QString("Counter"), QString(""), UAVObjectField::UINT32, 1, QStringList()) );
+        fields.append( new UAVObjectField(QString("Gain"), QString(""), UAVObjectField::FLOAT32, 2, QStringList()) );
+        fields.append( new UAVObjectField(QString("Mode"), QString(""), UAVObjectField::UINT8, 1, QStringList()) );
+        initializeFields(fields, (quint8*)&data, NUMBYTES);
+    }
+
+private:
+    DataFields data;
+};
+
+/**
+ * Touches the fields of an object from its own thread, as telemetry does
+ */
+class FieldsThread : public QThread
+{
+public:
+    FieldsThread(UAVObject *obj) : obj(obj) {}
+
+    QList<UAVObjectField*> fields;
+
+protected:
+    void run()
+    {
+        fields = obj->getFields();
+    }
+
+private:
+    UAVObject *obj;
+};
+
+/*
+ * The accessors that used the field list directly before it was lazy
+ */
+enum Accessor {
+    GET_NUM_FIELDS,
+    GET_FIELDS,
+    GET_FIELD,
+    PACK,
+    UNPACK,
+    TO_STRING_DATA,
+    NUM_ACCESSORS
+};
+Q_DECLARE_METATYPE(Accessor)
+
+static void access(LazyObject *obj, Accessor accessor)
+{
+    quint8 buf[LazyObject::NUMBYTES];
+
+    switch (accessor) {
+    case GET_NUM_FIELDS:
+        QCOMPARE(obj->getNumFields(), 3);
+        break;
+    case GET_FIELDS:
+        QCOMPARE(obj->getFields().count(), 3);
+        break;
+    case GET_FIELD:
+        {
+            float gain = obj->getData().Gain[1];
+            QVERIFY(obj->getField("Gain") != NULL);
+            QCOMPARE(obj->getField("Gain")->getValue(1).toFloat(), gain);
+        }
+        break;
+    case PACK:
+        {
+            LazyObject::DataFields data = obj->getData();
+            QCOMPARE(obj->pack(buf), (qint32)LazyObject::NUMBYTES);
+            QVERIFY(memcmp(buf, &data, LazyObject::NUMBYTES) == 0);
+        }
+        break;
+    case UNPACK:
+        {
+            LazyObject::DataFields data = obj->getData();
+            quint32 counter = data.Counter + 1;
+            data.Counter = counter;
+            data.Mode = 3;
+            memcpy(buf, &data, LazyObject::NUMBYTES);
+            QCOMPARE(obj->unpack(buf), (qint32)LazyObject::NUMBYTES);
+            data = obj->getData();
+            QCOMPARE((quint32)data.Counter, counter);
+            QCOMPARE((quint8)data.Mode, (quint8)3);
+        }
+        break;
+    case TO_STRING_DATA:
+        QVERIFY(obj->toStringData().contains("Gain"));
+        break;
+    case NUM_ACCESSORS:
+        break;
+    }
+}
+
+class tst_LazyFields : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void constructionCreatesNoFields();
+    void firstAccessCreatesFields_data();
+    void firstAccessCreatesFields();
+    void fieldsCreatedByAnotherThread();
+    void metaObjectFields();
+};
+
+void tst_LazyFields::constructionCreatesNoFields()
+{
+    LazyObject obj;
+
+    QCOMPARE(obj.creations, 0);
+    QCOMPARE(obj.getNumBytes(), (quint32)LazyObject::NUMBYTES);
+
+    /* The data is usable without the fields */
+    LazyObject::DataFields data = obj.getData();
+    QCOMPARE((quint32)data.Counter, (quint32)7);
+    QCOMPARE((float)data.Gain[1], 1.5f);
+    QCOMPARE(obj.creations, 0);
+}
+
+void tst_LazyFields::firstAccessCreatesFields_data()
+{
+    QTest::addColumn<Accessor>("accessor");
+
+    QTest::newRow("getNumFields") << GET_NUM_FIELDS;
+    QTest::newRow("getFields") << GET_FIELDS;
+    QTest::newRow("getField") << GET_FIELD;
+    QTest::newRow("pack") << PACK;
+    QTest::newRow("unpack") << UNPACK;
+    QTest::newRow("toStringData") << TO_STRING_DATA;
+}
+
+void tst_LazyFields::firstAccessCreatesFields()
+{
+    QFETCH(Accessor, accessor);
+
+    LazyObject obj;
+
+    access(&obj, accessor);
+    QCOMPARE(obj.creations, 1);
+
+    /* Created once, whatever comes next */
+    for (int n = 0; n < NUM_ACCESSORS; ++n)
+        access(&obj, (Accessor)n);
+    QCOMPARE(obj.creations, 1);
+
+    /* The fields are bound to the object data */
+    obj.getField("Counter")->setValue(42);
+    LazyObject::DataFields data = obj.getData();
+    QCOMPARE((quint32)data.Counter, (quint32)42);
+}
+
+void tst_LazyFields::fieldsCreatedByAnotherThread()
+{
+    LazyObject obj;
+    FieldsThread thread(&obj);
+
+    thread.start();
+    QVERIFY(thread.wait(5000));
+
+    QCOMPARE(obj.creations, 1);
+    QCOMPARE(thread.fields.count(), 3);
+    foreach (UAVObjectField *field, thread.fields)
+        QCOMPARE(field->thread(), obj.thread());
+}
+
+void tst_LazyFields::metaObjectFields()
+{
+    LazyObject obj;
+    UAVMetaObject mobj(LazyObject::OBJID + 1, QString("LazyObjectMeta"), &obj);
+
+    QCOMPARE(mobj.getNumBytes(), (quint32)sizeof(UAVObject::Metadata));
+    QCOMPARE(mobj.getNumFields(), 4);
+    QVERIFY(mobj.getField(tr("Logging Update Period")) != NULL);
+    QCOMPARE(obj.creations, 0);
+}
+
+QTEST_MAIN(tst_LazyFields)
+
+#include "tst_lazyfields.moc"
+
+/**
+ * @}
+ * @}
+ */
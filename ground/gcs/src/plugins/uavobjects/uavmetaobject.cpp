@@ -37,7 +37,18 @@ UAVMetaObject::UAVMetaObject(quint32 objID, const QString& name, UAVObject *pare
     this->parent = parent;
     // Setup default metadata of metaobject (can not be changed)
     UAVObject::MetadataInitialize(ownMetadata);
-    // Setup fields
+    // Initialize parent, the fields are created on first use
+    UAVObject::initialize(0);
+    UAVObject::initializeData((quint8*)&parentMetadata, sizeof(Metadata));
+    // Setup metadata of parent
+    parentMetadata = parent->getDefaultMetadata();
+}
+
+/**
+ * Create the metaobject fields
+ */
+void UAVMetaObject::createFields()
+{
     QStringList modesBitField;
     modesBitField << tr("FlightReadOnly") << tr("GCSReadOnly") << tr("FlightTelemetryAcked") << tr("GCSTelemetryAcked") << tr("FlightUpdatePeriodic") << tr("FlightUpdateOnChange") << tr("GCSUpdatePeriodic") << tr("GCSUpdateOnChange");
     QList<UAVObjectField*> fields;    
@@ -45,11 +56,7 @@ UAVMetaObject::UAVMetaObject(quint32 objID, const QString& name, UAVObject *pare
     fields.append( new UAVObjectField(tr("Flight Telemetry Update Period"), tr("ms"), UAVObjectField::UINT16, 1, QStringList()) );
     fields.append( new UAVObjectField(tr("GCS Telemetry Update Period"), tr("ms"), UAVObjectField::UINT16, 1, QStringList()) );
     fields.append( new UAVObjectField(tr("Logging Update Period"), tr("ms"), UAVObjectField::UINT16, 1, QStringList()) );
-    // Initialize parent
-    UAVObject::initialize(0);
     UAVObject::initializeFields(fields, (quint8*)&parentMetadata, sizeof(Metadata));
-    // Setup metadata of parent
-    parentMetadata = parent->getDefaultMetadata();
 }
 
 /**
@@ -44,6 +44,9 @@ public:
     void setData(const Metadata& mdata);
     Metadata getData();
 
+protected:
+    void createFields();
+
 private:
     UAVObject* parent;
     Metadata ownMetadata;
@@ -28,6 +28,8 @@
 #include "uavobject.h"
 #include <QtEndian>
 #include <QDebug>
+#include <QThread>
+#include <QElapsedTimer>
 
 // Constants
 #define UAVOBJ_ACCESS_SHIFT 0
@@ -41,6 +43,18 @@
 // Macros
 #define SET_BITS(var, shift, value, mask) var = (var & ~(mask << shift)) |	(value << shift);
 
+// Notification latency statistics, shared by all objects
+static QMutex notificationStatsMutex;
+static UAVObject::NotificationStats notificationStats;
+
+static QElapsedTimer startClock()
+{
+    QElapsedTimer clock;
+    clock.start();
+    return clock;
+}
+static const QElapsedTimer notificationClock = startClock();
+
 /**
  * Constructor
  * @param objID The object ID
@@ -54,6 +68,10 @@ UAVObject::UAVObject(quint32 objID, bool isSingleInst, const QString& name)
     this->isSingleInst = isSingleInst;
     this->name = name;
     this->mutex = new QMutex(QMutex::Recursive);
+    this->unpackTimestampUs = 0;
+    this->numBytes = 0;
+    this->data = NULL;
+    this->fieldsCreated = false;
 }
 
 /**
@@ -65,6 +83,19 @@ void UAVObject::initialize(quint32 instID)
     this->instID = instID;
 }
 
+/**
+ * Initialize the object data, the fields are only created by createFields()
+ * the first time they are needed.
+ * @param data Pointer to that actual object data
+ * @param numBytes Number of bytes in the object (total, including all fields)
+ */
+void UAVObject::initializeData(quint8* data, quint32 numBytes)
+{
+    QMutexLocker locker(mutex);
+    this->numBytes = numBytes;
+    this->data = data;
+}
+
 /**
  * Initialize objects' data fields
  * @param fields List of fields held by the object
@@ -77,16 +108,43 @@ void UAVObject::initializeFields(QList<UAVObjectField*>& fields, quint8* data, q
     this->numBytes = numBytes;
     this->data = data;
     this->fields = fields;
+    this->fieldsCreated = true;
     // Initialize fields
     quint32 offset = 0;
     for (int n = 0; n < fields.length(); ++n)
     {
         fields[n]->initialize(data, offset, this);
         offset += fields[n]->getNumBytes();
+        // Fields may be created lazily from another thread (e.g. telemetry)
+        if (fields[n]->thread() != thread())
+            fields[n]->moveToThread(thread());
         connect(fields[n], SIGNAL(fieldUpdated(UAVObjectField*)), this, SLOT(fieldUpdated(UAVObjectField*)));
     }
 }
 
+/**
+ * Create the object fields and call initializeFields(), overridden by the
+ * objects. Called once, the first time the fields are accessed.
+ */
+void UAVObject::createFields()
+{
+}
+
+/**
+ * Make sure the fields have been created, must be called before
+ * accessing the fields list. Most objects are never inspected field by
+ * field, so building the field tables is deferred from construction.
+ */
+void UAVObject::ensureFields()
+{
+    QMutexLocker locker(mutex);
+    if (!fieldsCreated)
+    {
+        fieldsCreated = true;
+        createFields();
+    }
+}
+
 /**
  * Called from the fields each time they are updated
  */
@@ -224,6 +282,7 @@ QMutex* UAVObject::getMutex()
  */
 qint32 UAVObject::getNumFields()
 {
+    ensureFields();
     QMutexLocker locker(mutex);
     return fields.count();
 }
@@ -233,6 +292,7 @@ qint32 UAVObject::getNumFields()
  */
 QList<UAVObjectField*> UAVObject::getFields()
 {
+    ensureFields();
     QMutexLocker locker(mutex);
     return fields;
 }
@@ -243,6 +303,7 @@ QList<UAVObjectField*> UAVObject::getFields()
  */
 UAVObjectField* UAVObject::getField(const QString& name)
 {
+    ensureFields();
     QMutexLocker locker(mutex);
     // Look for field
     for (int n = 0; n < fields.length(); ++n)
@@ -263,6 +324,7 @@ UAVObjectField* UAVObject::getField(const QString& name)
  */
 qint32 UAVObject::pack(quint8* dataOut)
 {
+    ensureFields();
     QMutexLocker locker(mutex);
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
@@ -280,6 +342,7 @@ qint32 UAVObject::pack(quint8* dataOut)
  */
 qint32 UAVObject::unpack(const quint8* dataIn)
 {
+    ensureFields();
     QMutexLocker locker(mutex);
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
@@ -288,12 +351,61 @@ qint32 UAVObject::unpack(const quint8* dataIn)
         field->unpack(&dataIn[offset]);
         offset += field->getNumBytes();
     }
+    locker.unlock();
+
     emit objectUnpacked(this); // trigger object updated event
-    emit objectUpdated(this);
+
+    if (QThread::currentThread() == thread()) {
+        emit objectUpdated(this);
+    } else {
+        // Unpacked on the telemetry thread. Only one objectUpdated notification
+        // is queued to the thread owning the object no matter how many updates
+        // arrive before it runs, so a busy link can not flood the GUI.
+        if (updatePending.testAndSetOrdered(0, 1)) {
+            unpackTimestampUs = notificationClock.nsecsElapsed() / 1000;
+            QMetaObject::invokeMethod(this, "emitCoalescedUpdate", Qt::QueuedConnection);
+        } else {
+            QMutexLocker statsLocker(&notificationStatsMutex);
+            notificationStats.coalesced++;
+        }
+    }
 
     return numBytes;
 }
 
+/**
+ * Emit the objectUpdated signal for all the unpacks received on the
+ * telemetry thread since the last notification.
+ */
+void UAVObject::emitCoalescedUpdate()
+{
+    qint64 unpackTimestamp = unpackTimestampUs;
+    updatePending.fetchAndStoreOrdered(0);
+
+    {
+        qint64 latency = notificationClock.nsecsElapsed() / 1000 - unpackTimestamp;
+        QMutexLocker statsLocker(&notificationStatsMutex);
+        notificationStats.notifications++;
+        notificationStats.totalLatencyUs += latency;
+        if (latency > notificationStats.maxLatencyUs)
+            notificationStats.maxLatencyUs = latency;
+    }
+
+    emit objectUpdated(this);
+}
+
+/**
+ * Return the notification statistics gathered since the previous call
+ * and reset them.
+ */
+UAVObject::NotificationStats UAVObject::takeNotificationStats()
+{
+    QMutexLocker statsLocker(&notificationStatsMutex);
+    NotificationStats stats = notificationStats;
+    notificationStats = NotificationStats();
+    return stats;
+}
+
 /**
  * Save the object data to the file.
  * The file will be created in the current directory
@@ -472,6 +584,7 @@ QString UAVObject::toStringData()
 {
     QString sout;
     sout.append("Data:\n");
+    ensureFields();
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
     {
         UAVObjectField *field = *iter;
@@ -34,11 +34,14 @@
 #include <QObject>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QAtomicInt>
 #include <QString>
 #include <QList>
 #include <QFile>
+#include <cstring>
 #include <qglobal.h>
 #include "uavobjectfield.h"
+#include "uavobjectfielddescriptor.h"
 
 #define UAVOBJ_ACCESS_SHIFT 0
 #define UAVOBJ_GCS_ACCESS_SHIFT 1
@@ -123,12 +126,26 @@ public:
     qint32 getNumFields();
     QList<UAVObjectField*> getFields();
     UAVObjectField* getField(const QString& name);
+    template <typename Field> typename Field::Type read(quint32 index = 0);
+    template <typename Field> void write(typename Field::Type value, quint32 index = 0);
     QString toString();
     QString toStringBrief();
     QString toStringData();
     void emitTransactionCompleted(bool success);
     void emitNewInstance(UAVObject *);
 
+    /**
+     * Latency between an unpack on the telemetry thread and the matching
+     * objectUpdated notification on the thread owning the object.
+     */
+    typedef struct {
+        quint32 notifications;
+        quint32 coalesced;
+        qint64 totalLatencyUs;
+        qint64 maxLatencyUs;
+    } NotificationStats;
+    static NotificationStats takeNotificationStats();
+
     // Metadata accessors
     static void MetadataInitialize(Metadata& meta);
     static AccessMode GetFlightAccess(const Metadata& meta);
@@ -214,6 +231,7 @@ signals:
 
 private slots:
     void fieldUpdated(UAVObjectField* field);
+    void emitCoalescedUpdate();
 
 protected:
     quint32 objID;
@@ -224,12 +242,49 @@ protected:
     QString category;
     quint32 numBytes;
     QMutex* mutex;
+    QAtomicInt updatePending;
+    qint64 unpackTimestampUs;
+    bool fieldsCreated;
     quint8* data;
     QList<UAVObjectField*> fields;
 
+    void initializeData(quint8* data, quint32 numBytes);
     void initializeFields(QList<UAVObjectField*>& fields, quint8* data, quint32 numBytes);
+    virtual void createFields();
+    void ensureFields();
     void setDescription(const QString& description);
     void setCategory(const QString& category);
 };
 
+/**
+ * Read a field directly from the packed object data, without the name
+ * lookup and QVariant conversion of getField()->getValue().
+ * @param index Element index for array fields
+ */
+template <typename Field>
+typename Field::Type UAVObject::read(quint32 index)
+{
+    Q_ASSERT(objID == Field::Object::OBJID);
+    Q_ASSERT(index < Field::NUMELEM);
+    typename Field::Type value;
+    QMutexLocker locker(mutex);
+    memcpy(&value, data + Field::OFFSET + index * sizeof(value), sizeof(value));
+    return value;
+}
+
+/**
+ * Write a field directly into the packed object data. Like
+ * UAVObjectField::setValue() no update is signalled, call updated()
+ * or setData() once all fields are written.
+ * @param index Element index for array fields
+ */
+template <typename Field>
+void UAVObject::write(typename Field::Type value, quint32 index)
+{
+    Q_ASSERT(objID == Field::Object::OBJID);
+    Q_ASSERT(index < Field::NUMELEM);
+    QMutexLocker locker(mutex);
+    memcpy(data + Field::OFFSET + index * sizeof(value), &value, sizeof(value));
+}
+
 #endif // UAVOBJECT_H
@@ -1034,9 +1034,65 @@ void UAVObjectField::setValue(const QVariant& value, quint32 index)
     }
 }
 
+/**
+ * Numeric types are read straight from the object data, the other types
+ * go through getValue() as before.
+ */
 double UAVObjectField::getDouble(quint32 index)
 {
-    return getValue(index).toDouble();
+    if ( index >= numElements )
+        return getValue(index).toDouble();
+
+    const quint8* elem = &data[offset + numBytesPerElement*index];
+    QMutexLocker locker(obj->getMutex());
+    switch (type)
+    {
+    case INT8:
+    {
+        qint8 tmpint8;
+        memcpy(&tmpint8, elem, sizeof(tmpint8));
+        return tmpint8;
+    }
+    case INT16:
+    {
+        qint16 tmpint16;
+        memcpy(&tmpint16, elem, sizeof(tmpint16));
+        return tmpint16;
+    }
+    case INT32:
+    {
+        qint32 tmpint32;
+        memcpy(&tmpint32, elem, sizeof(tmpint32));
+        return tmpint32;
+    }
+    case UINT8:
+    {
+        quint8 tmpuint8;
+        memcpy(&tmpuint8, elem, sizeof(tmpuint8));
+        return tmpuint8;
+    }
+    case UINT16:
+    {
+        quint16 tmpuint16;
+        memcpy(&tmpuint16, elem, sizeof(tmpuint16));
+        return tmpuint16;
+    }
+    case UINT32:
+    {
+        quint32 tmpuint32;
+        memcpy(&tmpuint32, elem, sizeof(tmpuint32));
+        return tmpuint32;
+    }
+    case FLOAT32:
+    {
+        float tmpfloat;
+        memcpy(&tmpfloat, elem, sizeof(tmpfloat));
+        return tmpfloat;
+    }
+    default:
+        locker.unlock();
+        return getValue(index).toDouble();
+    }
 }
 
 void UAVObjectField::setDouble(double value, quint32 index)
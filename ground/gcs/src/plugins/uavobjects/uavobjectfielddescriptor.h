@@ -0,0 +1,48 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectfielddescriptor.h
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      Compile-time description of a UAVObject field
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify 
+ * it under the terms of the GNU General Public License as published by 
+ * the Free Software Foundation; either version 3 of the License, or 
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+ * for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVOBJECTFIELDDESCRIPTOR_H
+#define UAVOBJECTFIELDDESCRIPTOR_H
+
+#include <QtGlobal>
+#include <cstddef>
+
+/**
+ * Describes where a field lives in the packed data of its object. The
+ * generator emits one descriptor per field in the Fields struct of every
+ * object, e.g. AttitudeActual::Fields::Roll, to be used with
+ * UAVObject::read() and UAVObject::write().
+ */
+template <class ObjectType, typename FieldType, quint32 Offset, quint32 NumElements>
+struct UAVObjectFieldDescriptor
+{
+    typedef ObjectType Object;
+    typedef FieldType Type;
+    static const quint32 OFFSET = Offset;
+    static const quint32 NUMELEM = NumElements;
+};
+
+#endif // UAVOBJECTFIELDDESCRIPTOR_H
@@ -42,11 +42,8 @@ const QString $(NAME)::CATEGORY = QString("$(CATEGORY)");
  */
 $(NAME)::$(NAME)(): UAVDataObject(OBJID, ISSINGLEINST, ISSETTINGS, NAME)
 {
-    // Create fields
-    QList<UAVObjectField*> fields;
-$(FIELDSINIT)
-    // Initialize object
-    initializeFields(fields, (quint8*)&data, NUMBYTES);
+    // Initialize object, the fields are created on first use
+    initializeData((quint8*)&data, NUMBYTES);
     // Set the default field values
     setDefaultFieldValues();
     // Set the object description
@@ -59,6 +56,16 @@ $(FIELDSINIT)
             SLOT(emitNotifications()));
 }
 
+/**
+ * Create the object fields
+ */
+void $(NAME)::createFields()
+{
+    QList<UAVObjectField*> fields;
+$(FIELDSINIT)
+    initializeFields(fields, (quint8*)&data, NUMBYTES);
+}
+
 /**
  * Get the default metadata for this object
  */
@@ -48,6 +48,10 @@ public:
 $(DATAFIELDS)
     } __attribute__((packed)) __attribute__((aligned(4))) DataFields;
 
+    // Field descriptors, for use with UAVObject::read() and write()
+    struct Fields {
+$(FIELDDESCRIPTORS)    };
+
     // Field information
 $(DATAFIELDINFO)
   
@@ -83,6 +87,9 @@ $(PROPERTY_NOTIFICATIONS)
 private slots:
     void emitNotifications();
 	
+protected:
+    void createFields();
+
 private:
     DataFields data;
 
@@ -29,7 +29,8 @@
 
 ImportSummaryDialog::ImportSummaryDialog( QWidget *parent) :
     QDialog(parent),
-    ui(new Ui::ImportSummaryDialog)
+    ui(new Ui::ImportSummaryDialog),
+    restore(0)
 {
    ui->setupUi(this);
    setWindowTitle(tr("Import Summary"));
@@ -94,11 +95,67 @@ void ImportSummaryDialog::addLine(QString uavObjectName, QString text, bool stat
 }
 
 /*
-  Saves every checked UAVObjet in the list to Flash
+  Follows the upload of the changed objects done by the restore engine,
+  saving is only possible once the board holds the imported values.
+  Must be called before the restore is started.
+  */
+void ImportSummaryDialog::setRestore(SettingsRestore *restore)
+{
+    this->restore = restore;
+    connect(restore, SIGNAL(objectSent(UAVObject*,bool)), this, SLOT(objectSent(UAVObject*,bool)));
+    connect(restore, SIGNAL(sendFinished(int,int)), this, SLOT(sendFinished(int,int)));
+
+    if (restore->changedCount() > 0) {
+        ui->progressBar->setMaximum(restore->changedCount());
+        ui->progressBar->setValue(0);
+        ui->saveToFlash->setEnabled(false);
+        ui->closeButton->setEnabled(false);
+    }
+}
+
+int ImportSummaryDialog::findRow(const QString &uavObjectName)
+{
+    for(int i=0; i < ui->importSummaryList->rowCount(); i++) {
+        if (ui->importSummaryList->item(i,1)->text() == uavObjectName)
+            return i;
+    }
+    return -1;
+}
+
+void ImportSummaryDialog::objectSent(UAVObject *obj, bool success)
+{
+    ui->progressBar->setValue(ui->progressBar->value()+1);
+
+    int row = findRow(obj->getName());
+    if (row < 0)
+        return;
+    if (success) {
+        uploaded.insert(obj->getName());
+    } else {
+        ui->importSummaryList->item(row,2)->setText("Error (Upload failed)");
+        QCheckBox *box = dynamic_cast<QCheckBox*>(ui->importSummaryList->cellWidget(row,0));
+        box->setChecked(false);
+        box->setEnabled(false);
+    }
+}
+
+void ImportSummaryDialog::sendFinished(int sent, int failed)
+{
+    ui->label->setText(tr("UAV Settings import summary: %1 object(s) changed, %2 failed")
+                       .arg(sent).arg(failed));
+    ui->saveToFlash->setEnabled(true);
+    ui->closeButton->setEnabled(true);
+}
+
+/*
+  Saves every checked UAVObjet in the list to Flash. With the restore
+  engine only the objects it uploaded are saved, the others already
+  held the imported values on the board.
   */
 void ImportSummaryDialog::doTheSaving()
 {
     int itemCount=0;
+
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
     UAVObjectUtilManager *utilManager = pm->getObject<UAVObjectUtilManager>();
@@ -106,7 +163,7 @@ void ImportSummaryDialog::doTheSaving()
 
     for(int i=0; i < ui->importSummaryList->rowCount(); i++) {
         QCheckBox *box = dynamic_cast<QCheckBox*>(ui->importSummaryList->cellWidget(i,0));
-        if (box->isChecked()) {
+        if (box->isChecked() && (!restore || uploaded.contains(ui->importSummaryList->item(i,1)->text()))) {
         ++itemCount;
         }
     }
@@ -117,7 +174,7 @@ void ImportSummaryDialog::doTheSaving()
     for(int i=0; i < ui->importSummaryList->rowCount(); i++) {
         QString uavObjectName = ui->importSummaryList->item(i,1)->text();
         QCheckBox *box = dynamic_cast<QCheckBox*>(ui->importSummaryList->cellWidget(i,0));
-        if (box->isChecked()) {
+        if (box->isChecked() && (!restore || uploaded.contains(uavObjectName))) {
             UAVObject* obj = objManager->getObject(uavObjectName);
             utilManager->saveObjectToFlash(obj);
             this->repaint();
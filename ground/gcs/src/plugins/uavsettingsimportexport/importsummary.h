@@ -31,11 +31,13 @@
 #include <QCheckBox>
 #include <QDesktopServices>
 #include <QUrl>
+#include <QSet>
 #include "ui_importsummarydialog.h"
 #include "uavdataobject.h"
 #include "uavobjectmanager.h"
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectutil/uavobjectutilmanager.h"
+#include "settingsrestore.h"
 
 
 
@@ -51,6 +53,7 @@ public:
     ImportSummaryDialog(QWidget *parent=0);
     ~ImportSummaryDialog();
     void addLine(QString objectName, QString text, bool status);
+    void setRestore(SettingsRestore *restore);
 
 protected:
     void showEvent(QShowEvent *event);
@@ -58,9 +61,14 @@ protected:
 
 private:
     Ui::ImportSummaryDialog *ui;
+    SettingsRestore *restore;
+    QSet<QString> uploaded;
+    int findRow(const QString &uavObjectName);
 
 public slots:
     void updateSaveCompletion();
+    void objectSent(UAVObject *obj, bool success);
+    void sendFinished(int sent, int failed);
 
 private slots:
     void doTheSaving();
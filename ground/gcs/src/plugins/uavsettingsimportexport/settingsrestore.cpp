@@ -0,0 +1,210 @@
+/**
+ ******************************************************************************
+ *
+ * @file       settingsrestore.cpp
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVSettingsImportExport UAVSettings Import/Export Plugin
+ * @{
+ * @brief Snapshot-and-diff engine used to restore a settings file to the board
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "settingsrestore.h"
+#include <QEventLoop>
+#include <QTimer>
+#include <QDebug>
+
+SettingsRestore::SettingsRestore(QObject *parent) :
+    QObject(parent),
+    total(0),
+    sent(0),
+    failed(0),
+    sending(false)
+{
+}
+
+SettingsRestore::~SettingsRestore()
+{
+    foreach (UAVObject *obj, inFlight.keys())
+        disconnect(obj, 0, this, 0);
+    foreach (UAVObject *obj, refreshing.keys())
+        disconnect(obj, 0, this, 0);
+}
+
+/**
+ * Request the objects from the board and snapshot the state it answers
+ * with, blocking until every request completed or REFRESH_TIMEOUT_MS
+ * passed. The GCS copy of a setting can differ from the board, when it
+ * was edited but not sent or changed by another client, so it is not
+ * used for the comparison. An object that could not be refreshed has no
+ * snapshot and is always uploaded.
+ */
+void SettingsRestore::refresh(const QList<UAVObject*> &objects)
+{
+    foreach (UAVObject *obj, objects) {
+        if (!refreshQueue.contains(obj) && !refreshing.contains(obj))
+            refreshQueue.enqueue(obj);
+    }
+
+    QEventLoop loop;
+    QTimer::singleShot(REFRESH_TIMEOUT_MS, &loop, SLOT(quit()));
+    connect(this, SIGNAL(refreshFinished()), &loop, SLOT(quit()));
+    requestNext();
+    if (!refreshQueue.isEmpty() || !refreshing.isEmpty())
+        loop.exec();
+
+    if (!refreshQueue.isEmpty() || !refreshing.isEmpty()) {
+        qDebug() << "[SettingsRestore]" << refreshQueue.size() + refreshing.size()
+                 << "objects were not refreshed, they will be uploaded";
+        foreach (UAVObject *obj, refreshing.keys())
+            disconnect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)),
+                       this, SLOT(refreshCompleted(UAVObject*,bool)));
+        refreshing.clear();
+        refreshQueue.clear();
+    }
+}
+
+/**
+ * Keep up to MAX_IN_FLIGHT object requests outstanding
+ */
+void SettingsRestore::requestNext()
+{
+    while (!refreshQueue.isEmpty() && refreshing.size() < MAX_IN_FLIGHT) {
+        UAVObject *obj = refreshQueue.dequeue();
+        refreshing.insert(obj, true);
+        connect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)),
+                this, SLOT(refreshCompleted(UAVObject*,bool)));
+        obj->requestUpdate();
+    }
+
+    if (refreshQueue.isEmpty() && refreshing.isEmpty())
+        emit refreshFinished();
+}
+
+void SettingsRestore::refreshCompleted(UAVObject *obj, bool success)
+{
+    if (!refreshing.remove(obj))
+        return;
+    disconnect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)),
+               this, SLOT(refreshCompleted(UAVObject*,bool)));
+
+    if (success)
+        snapshot(obj);
+
+    requestNext();
+}
+
+/**
+ * Capture the packed state of an object as the board reported it
+ */
+void SettingsRestore::snapshot(UAVObject *obj)
+{
+    QByteArray data(obj->getNumBytes(), 0);
+    obj->pack((quint8 *)data.data());
+    snapshots.insert(obj, data);
+}
+
+/**
+ * Compare the current packed state of an object with its snapshot
+ */
+bool SettingsRestore::isChanged(UAVObject *obj) const
+{
+    QHash<UAVObject*, QByteArray>::const_iterator it = snapshots.constFind(obj);
+    if (it == snapshots.constEnd())
+        return true;
+
+    QByteArray data(obj->getNumBytes(), 0);
+    obj->pack((quint8 *)data.data());
+    return data != it.value();
+}
+
+/**
+ * Queue an object for upload. Nothing is sent until start() is called.
+ */
+void SettingsRestore::enqueue(UAVObject *obj)
+{
+    if (queue.contains(obj) || inFlight.contains(obj))
+        return;
+    queue.enqueue(obj);
+    ++total;
+}
+
+/**
+ * Start the pipelined upload of the queued objects
+ */
+void SettingsRestore::start()
+{
+    if (sending)
+        return;
+
+    sending = true;
+    sent = 0;
+    failed = 0;
+    sendTime.start();
+    sendNext();
+}
+
+/**
+ * Fill the transmit window. Emits sendFinished once the queue is drained
+ * and every outstanding transaction has completed.
+ */
+void SettingsRestore::sendNext()
+{
+    while (!queue.isEmpty() && inFlight.size() < MAX_IN_FLIGHT) {
+        UAVObject *obj = queue.dequeue();
+        if (UAVObject::GetGcsTelemetryAcked(obj->getMetadata())) {
+            inFlight.insert(obj, true);
+            connect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)),
+                    this, SLOT(transactionCompleted(UAVObject*,bool)));
+            obj->updated();
+        } else {
+            // No ACK will come back, the object is gone once it is handed
+            // to telemetry
+            obj->updated();
+            ++sent;
+            emit objectSent(obj, true);
+        }
+    }
+
+    if (queue.isEmpty() && inFlight.isEmpty() && sending) {
+        sending = false;
+        qDebug() << "[SettingsRestore] Uploaded" << sent << "of" << total << "changed objects,"
+                 << failed << "failed, in" << sendTime.elapsed() << "ms";
+        emit sendFinished(sent, failed);
+    }
+}
+
+void SettingsRestore::transactionCompleted(UAVObject *obj, bool success)
+{
+    if (!inFlight.remove(obj))
+        return;
+    disconnect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)),
+               this, SLOT(transactionCompleted(UAVObject*,bool)));
+
+    if (success)
+        ++sent;
+    else
+        ++failed;
+    emit objectSent(obj, success);
+
+    sendNext();
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,94 @@
+/**
+ ******************************************************************************
+ *
+ * @file       settingsrestore.h
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVSettingsImportExport UAVSettings Import/Export Plugin
+ * @{
+ * @brief Snapshot-and-diff engine used to restore a settings file to the board
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef SETTINGSRESTORE_H
+#define SETTINGSRESTORE_H
+
+#include <QObject>
+#include <QHash>
+#include <QQueue>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include "uavobject.h"
+
+/**
+ * Restores a settings snapshot to the board with as little link traffic
+ * as possible:
+ *  - the objects are requested from the board first, and their packed
+ *    state is captured before the imported values are applied, so that
+ *    only objects whose packed bytes differ from the board are uploaded;
+ *  - uploads are pipelined, keeping up to MAX_IN_FLIGHT acked
+ *    transactions outstanding instead of waiting for each ACK in turn
+ *    (and without overflowing the telemetry event queue).
+ * Saving to flash is left to the import summary, which only saves the
+ * objects that were uploaded.
+ */
+class SettingsRestore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SettingsRestore(QObject *parent = 0);
+    ~SettingsRestore();
+
+    void refresh(const QList<UAVObject*> &objects);
+    bool isChanged(UAVObject *obj) const;
+    void enqueue(UAVObject *obj);
+    void start();
+
+    bool isSending() const { return sending; }
+    int changedCount() const { return total; }
+
+signals:
+    void objectSent(UAVObject *obj, bool success);
+    void sendFinished(int sent, int failed);
+    void refreshFinished();
+
+private slots:
+    void refreshCompleted(UAVObject *obj, bool success);
+    void transactionCompleted(UAVObject *obj, bool success);
+
+private:
+    static const int MAX_IN_FLIGHT = 8;
+    static const int REFRESH_TIMEOUT_MS = 10000;
+
+    void snapshot(UAVObject *obj);
+    void requestNext();
+    void sendNext();
+
+    QHash<UAVObject*, QByteArray> snapshots;
+    QQueue<UAVObject*> refreshQueue;
+    QHash<UAVObject*, bool> refreshing;
+    QQueue<UAVObject*> queue;
+    QHash<UAVObject*, bool> inFlight;
+    int total;
+    int sent;
+    int failed;
+    bool sending;
+    QElapsedTimer sendTime;
+};
+
+#endif // SETTINGSRESTORE_H
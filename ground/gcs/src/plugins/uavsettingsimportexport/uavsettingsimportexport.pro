@@ -9,9 +9,11 @@ include(uavsettingsimportexport_dependencies.pri)
 
 HEADERS += uavsettingsimportexport.h \
     importsummary.h \
+    settingsrestore.h \
     uavsettingsimportexportfactory.h
 SOURCES += uavsettingsimportexport.cpp \
     importsummary.cpp \
+    settingsrestore.cpp \
     uavsettingsimportexportfactory.cpp
  
 OTHER_FILES += uavsettingsimportexport.pluginspec
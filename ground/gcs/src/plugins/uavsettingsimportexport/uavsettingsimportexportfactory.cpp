@@ -31,6 +31,7 @@
 #include <QDebug>
 #include <QCheckBox>
 #include "importsummary.h"
+#include "settingsrestore.h"
 
 // for menu item
 #include <coreplugin/coreconstants.h>
@@ -156,8 +157,18 @@ void UAVSettingsImportExportFactory::importUAVSettings()
 
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    SettingsRestore restore;
     swui.show();
 
+    // Compare against what the board holds, not the GCS copy
+    QList<UAVObject*> objects;
+    for (QDomElement e = root.firstChildElement("object"); !e.isNull(); e = e.nextSiblingElement("object")) {
+        UAVObject *obj = objManager->getObject(e.attribute("name"));
+        if (obj != NULL)
+            objects.append(obj);
+    }
+    restore.refresh(objects);
+
     QDomNode node = root.firstChild();
     while (!node.isNull()) {
         QDomElement e = node.toElement();
@@ -175,7 +186,7 @@ void UAVSettingsImportExportFactory::importUAVSettings()
                 swui.addLine(uavObjectName, "Error (Object unknown)", false);
             } else {
                 //  - Update each field
-                //  - Issue and "updated" command
+                //  - Queue the object for upload if it differs from the board
                 bool error = false;
                 bool setError = false;
                 QDomNode field = node.firstChild();
@@ -212,7 +223,9 @@ void UAVSettingsImportExportFactory::importUAVSettings()
                     }
                     field = field.nextSibling();
                 }
-                obj->updated();
+                bool changed = restore.isChanged(obj);
+                if (changed)
+                    restore.enqueue(obj);
 
                 if (error) {
                     swui.addLine(uavObjectName, "Warning (Object field unknown)", true);
@@ -222,13 +235,15 @@ void UAVSettingsImportExportFactory::importUAVSettings()
                 } else if (setError) {
                     swui.addLine(uavObjectName, "Warning (Objects field value(s) invalid)", false);
                 } else {
-                    swui.addLine(uavObjectName, "OK", true);
+                    swui.addLine(uavObjectName, changed ? "OK" : "OK (unchanged)", true);
                 }
             }
         }
         node = node.nextSibling();
     }
     qDebug() << "End import";
+    swui.setRestore(&restore);
+    restore.start();
     swui.exec();
 }
 
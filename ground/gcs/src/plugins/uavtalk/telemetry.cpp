@@ -31,13 +31,12 @@
 #include "qxtlogger.h"
 #include "oplinksettings.h"
 #include "objectpersistence.h"
-#include <QTime>
 #include <QtGlobal>
 #include <stdlib.h>
 #include <QDebug>
 
 /**
- * @brief The TransactionKey class A key for the QMap to track transactions
+ * @brief The TransactionKey class A key for the QHash to track transactions
  */
 class TransactionKey {
 public:
@@ -58,16 +57,17 @@ public:
         return (rhs.objId == objId && rhs.instId == instId && rhs.req == req);
     }
 
-    bool operator<(const TransactionKey & rhs) const {
-        return objId < rhs.objId || (objId == rhs.objId && instId < rhs.instId) ||
-                (objId == rhs.objId && instId == rhs.instId && req != rhs.req);
-    }
-
     quint32 objId;
     quint32 instId;
     bool req;
 };
 
+inline uint qHash(const TransactionKey &key)
+{
+    // Object IDs are already hashes, only mix in the instance and direction
+    return key.objId ^ (key.instId << 1) ^ (key.req ? 0x80000000 : 0);
+}
+
 /**
  * Constructor
  */
@@ -76,6 +76,16 @@ Telemetry::Telemetry(UAVTalk* utalk, UAVObjectManager* objMngr)
     this->utalk = utalk;
     this->objMngr = objMngr;
     mutex = new QMutex(QMutex::Recursive);
+    processingQueue = false;
+    // Setup the timer wheel used for transaction timeouts and periodic updates,
+    // the timer only runs while there are entries in the wheel
+    wheel.resize(WHEEL_SLOTS);
+    wheelTick = 0;
+    wheelEntries = 0;
+    wheelClock.start();
+    wheelTimer = new QTimer(this);
+    wheelTimer->setInterval(WHEEL_TICK_MS);
+    connect(wheelTimer, SIGNAL(timeout()), this, SLOT(processTimerWheel()));
     // Process all objects in the list
     QVector< QVector<UAVObject*> > objs = objMngr->getObjects();
     const int objSize = objs.size();
@@ -91,21 +101,17 @@ Telemetry::Telemetry(UAVTalk* utalk, UAVObjectManager* objMngr)
     connect(utalk, SIGNAL(nackReceived(UAVObject*)), this, SLOT(transactionFailure(UAVObject*)));
     // Get GCS stats object
     gcsStatsObj = GCSTelemetryStats::GetInstance(objMngr);
-    // Setup and start the periodic timer
-    timeToNextUpdateMs = 0;
-    updateTimer = new QTimer(this);
-    connect(updateTimer, SIGNAL(timeout()), this, SLOT(processPeriodicUpdates()));
-    updateTimer->start(1000);
-    // Setup and start the stats timer
+    // Setup the stats counters
     txErrors = 0;
     txRetries = 0;
 }
 
 Telemetry::~Telemetry()
 {
-    for (QMap<TransactionKey, ObjectTransactionInfo*>::iterator itr = transMap.begin(); itr != transMap.end(); ++itr) {
-        delete itr.value();
-    }
+    // Records still referenced by the timer wheel are either in the map or
+    // in the pool, so this releases all of them
+    qDeleteAll(transMap);
+    qDeleteAll(transPool);
 }
 
 /**
@@ -116,50 +122,53 @@ void Telemetry::registerObject(UAVObject* obj)
     // Setup object for periodic updates
     addObject(obj);
 
-    // Setup object for telemetry updates
-    updateObject(obj, EV_NONE);
+    // Setup object for telemetry updates, new instances always need connecting
+    updateObject(obj, EV_NONE, true);
 }
 
 /**
- * Add an object in the list used for periodic updates
+ * Add an object type to the table used for periodic updates and cached metadata
  */
 void Telemetry::addObject(UAVObject* obj)
 {
-    // Check if object type is already in the list
-    const QVector<ObjectTimeInfo>::iterator iterEnd = objList.end();
-    for (QVector<ObjectTimeInfo>::const_iterator iter = objList.constBegin(); iter != iterEnd; ++iter)
+    const quint32 objID = obj->getObjID();
+    if (objTypes.contains(objID))
     {
-        if (iter->obj->getObjID() == obj->getObjID())
-        {
-            // Object type (not instance!) is already in the list, do nothing
-            return;
-        }
+        // Object type (not instance!) is already in the table, do nothing
+        return;
     }
 
-    // If this point is reached, then the object type is new, let's add it
-    ObjectTimeInfo timeInfo;
-    timeInfo.obj = obj;
-    timeInfo.timeToNextUpdateMs = 0;
-    timeInfo.updatePeriodMs = 0;
-    objList.append(timeInfo);
+    // If this point is reached, then the object type is new, let's add it.
+    // Metadata flags are filled in by updateObject()
+    ObjectTypeInfo typeInfo;
+    typeInfo.obj = obj;
+    UAVMetaObject* metaobj = dynamic_cast<UAVMetaObject*>(obj);
+    typeInfo.parent = metaobj ? metaobj->getParentObject() : NULL;
+    typeInfo.updateMode = UAVObject::UPDATEMODE_MANUAL;
+    typeInfo.acked = false;
+    typeInfo.eventMask = -1;
+    typeInfo.updatePeriodMs = 0;
+    typeInfo.periodGeneration = 0;
+    objTypes.insert(objID, typeInfo);
 }
 
 /**
- * Update the object's timers
+ * Update the object's periodic update entry in the timer wheel
  */
-void Telemetry::setUpdatePeriod(UAVObject* obj, qint32 periodMs)
+void Telemetry::setUpdatePeriod(ObjectTypeInfo &typeInfo, qint32 periodMs)
 {
-    // Find object type (not instance!) and update its period
-    const quint32 objID = obj->getObjID();
+    // Keep the current phase if nothing changed
+    if (typeInfo.updatePeriodMs == periodMs)
+        return;
 
-    const QVector<ObjectTimeInfo>::iterator iterEnd = objList.end();
-    for (QVector<ObjectTimeInfo>::iterator iter = objList.begin(); iter != iterEnd; ++iter)
+    // Any entry still in the wheel belongs to the old period
+    typeInfo.updatePeriodMs = periodMs;
+    ++typeInfo.periodGeneration;
+
+    if (periodMs > 0)
     {
-        if (iter->obj->getObjID() == objID)
-        {
-            iter->updatePeriodMs = periodMs;
-            iter->timeToNextUpdateMs = quint32((float)periodMs * (float)qrand() / (float)RAND_MAX); // avoid bunching of updates
-        }
+        qint32 offsetMs = quint32((float)periodMs * (float)qrand() / (float)RAND_MAX); // avoid bunching of updates
+        scheduleWheelEntry(currentTick() + msToTicks(offsetMs), NULL, typeInfo.obj->getObjID(), typeInfo.periodGeneration);
     }
 }
 
@@ -201,37 +210,43 @@ void Telemetry::connectToObjectInstances(UAVObject* obj, quint32 eventMask)
 /**
  * Update an object based on its metadata properties.
  *
- * This method updates the connections between object events and the telemetry
- * layer, depending on the object's metadata properties.
+ * This method refreshes the cached metadata flags of the object type and
+ * updates the connections between object events and the telemetry layer,
+ * depending on the object's metadata properties. Connections are only
+ * rebuilt when the event mask changes or when force is set.
  *
  * Note (elafargue, 2012.11): we listen for "unpacked" events in every case, because we want
  * to track when we receive object updates after doing an object request.
  */
-void Telemetry::updateObject(UAVObject* obj, quint32 eventType)
+void Telemetry::updateObject(UAVObject* obj, quint32 eventType, bool force)
 {
+    QHash<quint32, ObjectTypeInfo>::iterator typeInfo = objTypes.find(obj->getObjID());
+    if (typeInfo == objTypes.end())
+        return;
+
     // Get metadata
     UAVObject::Metadata metadata = obj->getMetadata();
     UAVObject::UpdateMode updateMode = UAVObject::GetGcsTelemetryUpdateMode(metadata);
+    typeInfo->updateMode = updateMode;
+    typeInfo->acked = UAVObject::GetGcsTelemetryAcked(metadata);
 
     // Setup object depending on update mode
-    qint32 eventMask;
+    qint32 eventMask = typeInfo->eventMask;
     if ( updateMode == UAVObject::UPDATEMODE_PERIODIC )
     {
         // Set update period
-        setUpdatePeriod(obj, metadata.gcsTelemetryUpdatePeriod);
+        setUpdatePeriod(*typeInfo, metadata.gcsTelemetryUpdatePeriod);
         // Connect signals for all instances
         eventMask = EV_UPDATED_MANUAL | EV_UPDATE_REQ | EV_UPDATED_PERIODIC;
         eventMask |= EV_UNPACKED; // we also need to act on remote updates (unpack events)
-        connectToObjectInstances(obj, eventMask);
     }
     else if ( updateMode == UAVObject::UPDATEMODE_ONCHANGE )
     {
         // Set update period
-        setUpdatePeriod(obj, 0);
+        setUpdatePeriod(*typeInfo, 0);
         // Connect signals for all instances
         eventMask = EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
         eventMask |= EV_UNPACKED; // we also need to act on remote updates (unpack events)
-        connectToObjectInstances(obj, eventMask);
     }
     else if ( updateMode == UAVObject::UPDATEMODE_THROTTLED )
     {
@@ -239,7 +254,7 @@ void Telemetry::updateObject(UAVObject* obj, quint32 eventType)
         if ((eventType == EV_UPDATED_PERIODIC) || (eventType == EV_NONE)) {
             // Set update period
             if (eventType == EV_NONE)
-                 setUpdatePeriod(obj, metadata.gcsTelemetryUpdatePeriod);
+                 setUpdatePeriod(*typeInfo, metadata.gcsTelemetryUpdatePeriod);
             // Connect signals for all instances
             eventMask = EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ | EV_UPDATED_PERIODIC;
         }
@@ -250,15 +265,19 @@ void Telemetry::updateObject(UAVObject* obj, quint32 eventType)
             eventMask = EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
         }
         eventMask |= EV_UNPACKED; // we also need to act on remote updates (unpack events)
-        connectToObjectInstances(obj, eventMask);
     }
     else if ( updateMode == UAVObject::UPDATEMODE_MANUAL )
     {
         // Set update period
-        setUpdatePeriod(obj, 0);
+        setUpdatePeriod(*typeInfo, 0);
         // Connect signals for all instances
         eventMask = EV_UPDATED_MANUAL | EV_UPDATE_REQ;
         eventMask |= EV_UNPACKED; // we also need to act on remote updates (unpack events)
+    }
+
+    if ( force || eventMask != typeInfo->eventMask )
+    {
+        typeInfo->eventMask = eventMask;
         connectToObjectInstances(obj, eventMask);
     }
 }
@@ -330,27 +349,49 @@ void Telemetry::transactionRequestCompleted(UAVObject* obj)
  */
 bool Telemetry::updateTransactionMap(UAVObject* obj, bool request)
 {
-    TransactionKey key(obj, request);
-    QMap<TransactionKey, ObjectTransactionInfo*>::iterator itr = transMap.find(key);
+    QHash<TransactionKey, ObjectTransactionInfo*>::iterator itr = transMap.find(TransactionKey(obj, request));
     if ( itr != transMap.end() )
     {
+        // Remove this transaction as it is complete, its timeout entry in
+        // the wheel becomes stale through the generation counter.
         ObjectTransactionInfo *transInfo = itr.value();
-        // Remove this transaction as it is complete.
-        transInfo->timer->stop();
-        transMap.remove(key);
-        delete transInfo;
+        transMap.erase(itr);
+        releaseTransaction(transInfo);
         return true;
     }
     return false;
 }
 
+/**
+ * Get a transaction record from the pool, allocating one if it is empty
+ */
+ObjectTransactionInfo* Telemetry::allocTransaction()
+{
+    if (transPool.isEmpty())
+    {
+        ObjectTransactionInfo *transInfo = new ObjectTransactionInfo;
+        transInfo->generation = 0;
+        return transInfo;
+    }
+    ObjectTransactionInfo *transInfo = transPool.last();
+    transPool.remove(transPool.size() - 1);
+    return transInfo;
+}
+
+/**
+ * Return a transaction record to the pool
+ */
+void Telemetry::releaseTransaction(ObjectTransactionInfo *transInfo)
+{
+    ++transInfo->generation;
+    transPool.append(transInfo);
+}
 
 /**
- * Called when a transaction is not completed within the timeout period (timer event)
+ * Called when a transaction is not completed within the timeout period (timer wheel)
  */
 void Telemetry::transactionTimeout(ObjectTransactionInfo *transInfo)
 {
-    transInfo->timer->stop();
     // Check if more retries are pending
     if (transInfo->retriesRemaining > 0)
     {
@@ -361,7 +402,6 @@ void Telemetry::transactionTimeout(ObjectTransactionInfo *transInfo)
     }
     else
     {
-        transInfo->timer->stop();
         transactionFailure(transInfo->obj);
         ++txErrors;
     }
@@ -382,16 +422,16 @@ void Telemetry::processObjectTransaction(ObjectTransactionInfo *transInfo)
     {   // We are sending an object to the remote end
         utalk->sendObject(transInfo->obj, transInfo->acked, transInfo->allInstances);
     }
-    // Start timer if a response is expected
+    // Schedule a timeout if a response is expected
     if ( transInfo->objRequest || transInfo->acked )
     {
-        transInfo->timer->start(REQ_TIMEOUT_MS);
+        scheduleWheelEntry(currentTick() + msToTicks(REQ_TIMEOUT_MS), transInfo, 0, transInfo->generation);
     }
     else
     {
         // Stop tracking this transaction, since we're not expecting a response:
         transMap.remove(TransactionKey(transInfo->obj, transInfo->objRequest));
-        delete transInfo;
+        releaseTransaction(transInfo);
     }
 }
 
@@ -436,83 +476,93 @@ void Telemetry::processObjectUpdates(UAVObject* obj, EventMask event, bool allIn
 }
 
 /**
- * Process events from the object queue.
+ * Process events from the object queue until both queues are empty.
+ *
+ * Handling an event can complete transactions and update objects, which
+ * enqueues further events. Those calls return straight away and the
+ * events are drained by the loop below instead of by recursion.
  */
 void Telemetry::processObjectQueue()
 {
-    if (objQueue.length() > 1)
-        qDebug() << "[telemetry.cpp] **************** Object Queue above 1 in backlog ****************";
-    // Get object information from queue (first the priority and then the regular queue)
+    if (processingQueue)
+        return;
+    processingQueue = true;
+
     ObjectQueueInfo objInfo;
-    if ( !objPriorityQueue.isEmpty() )
+    while ( !objPriorityQueue.isEmpty() || !objQueue.isEmpty() )
     {
-        objInfo = objPriorityQueue.dequeue();
-    }
-    else if ( !objQueue.isEmpty() )
-    {
-        objInfo = objQueue.dequeue();
-    }
-    else
-    {
-        return;
+        // Get object information from queue (first the priority and then the regular queue)
+        if ( !objPriorityQueue.isEmpty() )
+        {
+            objInfo = objPriorityQueue.dequeue();
+        }
+        else
+        {
+            objInfo = objQueue.dequeue();
+        }
+        processObjectEvent(objInfo);
     }
 
+    processingQueue = false;
+}
+
+/**
+ * Process a single event taken from the object queue.
+ */
+void Telemetry::processObjectEvent(const ObjectQueueInfo &objInfo)
+{
+    const quint32 objID = objInfo.obj->getObjID();
+
     // Check if a connection has been established, only process GCSTelemetryStats updates
     // (used to establish the connection)
     GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
     if ( gcsStats.Status != GCSTelemetryStats::STATUS_CONNECTED )
     {
         objQueue.clear();
-        if ( objInfo.obj->getObjID() != GCSTelemetryStats::OBJID && objInfo.obj->getObjID() != OPLinkSettings::OBJID  && objInfo.obj->getObjID() != ObjectPersistence::OBJID )
+        if ( objID != GCSTelemetryStats::OBJID && objID != OPLinkSettings::OBJID  && objID != ObjectPersistence::OBJID )
         {
             objInfo.obj->emitTransactionCompleted(false);
             return;
         }
     }
 
+    // Use the cached metadata flags of the object type
+    QHash<quint32, ObjectTypeInfo>::const_iterator typeInfo = objTypes.constFind(objID);
+    if ( typeInfo == objTypes.constEnd() )
+        return;
+    const UAVObject::UpdateMode updateMode = typeInfo->updateMode;
+    const bool acked = typeInfo->acked;
+    UAVObject* parent = typeInfo->parent;
+
     // Setup transaction (skip if unpack event)
-    UAVObject::Metadata metadata = objInfo.obj->getMetadata();
-    UAVObject::UpdateMode updateMode = UAVObject::GetGcsTelemetryUpdateMode(metadata);
     if ( ( objInfo.event != EV_UNPACKED ) && ( ( objInfo.event != EV_UPDATED_PERIODIC ) || ( updateMode != UAVObject::UPDATEMODE_THROTTLED ) ) )
     {
         // We are either going to send an object, or are requesting one:
-        if (transMap.contains(TransactionKey(objInfo.obj, objInfo.event == EV_UPDATE_REQ))) {
+        const bool objRequest = ( objInfo.event == EV_UPDATE_REQ );
+        TransactionKey key(objInfo.obj, objRequest);
+        if (transMap.contains(key)) {
             qDebug() << "[telemetry.cpp] Warning: Got request for " << objInfo.obj->getName() << " for which a request is already in progress. Not doing it";
             // We will not re-request it, then, we should wait for a timeout or success...
         } else
         {
-            UAVObject::Metadata metadata = objInfo.obj->getMetadata();
-            ObjectTransactionInfo *transInfo = new ObjectTransactionInfo(this);
+            ObjectTransactionInfo *transInfo = allocTransaction();
             transInfo->obj = objInfo.obj;
             transInfo->allInstances = objInfo.allInstances;
             transInfo->retriesRemaining = MAX_RETRIES;
-            transInfo->acked = UAVObject::GetGcsTelemetryAcked(metadata);
-            if ( objInfo.event == EV_UPDATED || objInfo.event == EV_UPDATED_MANUAL || objInfo.event == EV_UPDATED_PERIODIC )
-            {
-                transInfo->objRequest = false;
-            }
-            else if ( objInfo.event == EV_UPDATE_REQ )
-            {
-                transInfo->objRequest = true;
-            }
-            transInfo->telem = this;
+            transInfo->acked = acked;
+            transInfo->objRequest = objRequest;
             // Insert the transaction into the transaction map.
-            TransactionKey key(objInfo.obj, transInfo->objRequest);
             transMap.insert(key, transInfo);
             processObjectTransaction(transInfo);
         }
     }
 
     // If this is a metaobject then make necessary telemetry updates
-    // to the connections of this object to Telemetry (this) :
-    UAVMetaObject* metaobj = dynamic_cast<UAVMetaObject*>(objInfo.obj);
-    if ( metaobj != NULL )
+    // to the connections of this object to Telemetry (this). Data objects
+    // keep their setup until their metaobject changes.
+    if ( parent != NULL )
     {
-        updateObject( metaobj->getParentObject(), EV_NONE );
-    }
-    else if ( updateMode != UAVObject::UPDATEMODE_THROTTLED )
-    {
-        updateObject( objInfo.obj, objInfo.event );
+        updateObject( parent, EV_NONE );
     }
 
     // We received an "unpacked" event, check whether
@@ -520,74 +570,111 @@ void Telemetry::processObjectQueue()
     if ( objInfo.event == EV_UNPACKED ) {
         // TODO: Check here this is for a OBJ_REQ
         if (transMap.contains(TransactionKey(objInfo.obj, true))) {
-            qDebug() << "[telemetry.cpp] EV_UNPACKED " << objInfo.obj->getName() << QString(QString("0x") + QString::number(objInfo.obj->getObjID(), 16).toUpper()) << " Instance: " << objInfo.obj->getInstID();
+            qDebug() << "[telemetry.cpp] EV_UNPACKED " << objInfo.obj->getName() << QString(QString("0x") + QString::number(objID, 16).toUpper()) << " Instance: " << objInfo.obj->getInstID();
             transactionRequestCompleted(objInfo.obj);
-        } else
-        {
-            processObjectQueue();
         }
     }
 }
 
+/**
+ * Current position of the timer wheel clock, in ticks
+ */
+qint64 Telemetry::currentTick() const
+{
+    return wheelClock.elapsed() / WHEEL_TICK_MS;
+}
 
 /**
- * @brief Telemetry::processPeriodicUpdates Check if any objects are pending for periodic updates
+ * Convert a delay to wheel ticks, rounding up and at least one tick
  */
-void Telemetry::processPeriodicUpdates()
+qint64 Telemetry::msToTicks(qint32 ms)
 {
-    QMutexLocker locker(mutex);
+    return qMax<qint64>(1, (ms + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS);
+}
 
-    // Stop timer
-    updateTimer->stop();
+/**
+ * Insert an entry in the timer wheel, due at the given tick
+ */
+void Telemetry::scheduleWheelEntry(qint64 dueTick, ObjectTransactionInfo *transInfo, quint32 objId, quint32 generation)
+{
+    if (wheelEntries == 0)
+    {
+        // The wheel was stopped while empty, skip the ticks that went by
+        wheelTick = currentTick();
+        wheelTimer->start();
+    }
+    if (dueTick <= wheelTick)
+        dueTick = wheelTick + 1;
+
+    WheelEntry entry;
+    entry.dueTick = dueTick;
+    entry.generation = generation;
+    entry.transInfo = transInfo;
+    entry.objId = objId;
+    wheel[dueTick % WHEEL_SLOTS].append(entry);
+    ++wheelEntries;
+}
 
-    // Iterate through each object and update its timer, if zero then transmit object.
-    // Also calculate smallest delay to next update (will be used for setting timeToNextUpdateMs)
-    qint32 minDelay = MAX_UPDATE_PERIOD_MS;
-    qint32 elapsedMs = 0;
-    QTime time;
-    qint32 offset;
+/**
+ * @brief Telemetry::processTimerWheel Advance the timer wheel up to the current
+ * time, firing transaction timeouts and periodic updates that are due
+ */
+void Telemetry::processTimerWheel()
+{
+    QMutexLocker locker(mutex);
 
-    const QVector<ObjectTimeInfo>::iterator objInfoEnd = objList.end();
-    for (QVector<ObjectTimeInfo>::iterator objinfo = objList.begin(); objinfo != objInfoEnd; ++objinfo)
+    const qint64 now = currentTick();
+    while (wheelTick < now && wheelEntries > 0)
     {
-        // If object is configured for periodic updates
-        // FixMe: This is an inefficient process as it depends on polling. It would be better to have
-        // this functionality be driven through timers.
-        if (objinfo->updatePeriodMs > 0)
+        ++wheelTick;
+        QVector<WheelEntry> &slot = wheel[wheelTick % WHEEL_SLOTS];
+        if (slot.isEmpty())
+            continue;
+
+        // Take the due entries out first, handling them schedules new ones.
+        // Entries further than a full turn away stay in the slot.
+        QVector<WheelEntry> due;
+        for (int n = 0; n < slot.size(); )
         {
-            objinfo->timeToNextUpdateMs -= timeToNextUpdateMs;
-            // Check if time for the next update
-            if (objinfo->timeToNextUpdateMs <= 0)
+            if (slot[n].dueTick <= wheelTick)
             {
-                // Reset timer
-                offset = (-objinfo->timeToNextUpdateMs) % objinfo->updatePeriodMs;
-                objinfo->timeToNextUpdateMs = objinfo->updatePeriodMs - offset;
-                // Send object
-                time.start();
-                processObjectUpdates(objinfo->obj, EV_UPDATED_PERIODIC, true, false);
-                elapsedMs = time.elapsed();
-                // Update timeToNextUpdateMs with the elapsed delay of sending the object;
-                timeToNextUpdateMs += elapsedMs;
+                due.append(slot[n]);
+                slot[n] = slot.last();
+                slot.remove(slot.size() - 1);
             }
-            // Update minimum delay
-            if (objinfo->timeToNextUpdateMs < minDelay)
+            else
             {
-                minDelay = objinfo->timeToNextUpdateMs;
+                ++n;
             }
         }
-    }
+        wheelEntries -= due.size();
 
-    // Check if delay for the next update is too short
-    if (minDelay < MIN_UPDATE_PERIOD_MS)
-    {
-        minDelay = MIN_UPDATE_PERIOD_MS;
+        const int dueSize = due.size();
+        for (int n = 0; n < dueSize; ++n)
+        {
+            const WheelEntry &entry = due[n];
+            if (entry.transInfo != NULL)
+            {
+                // Skip timeouts of transactions that completed meanwhile
+                if (entry.transInfo->generation == entry.generation)
+                    transactionTimeout(entry.transInfo);
+            }
+            else
+            {
+                QHash<quint32, ObjectTypeInfo>::const_iterator typeInfo = objTypes.constFind(entry.objId);
+                if (typeInfo == objTypes.constEnd() ||
+                        typeInfo->periodGeneration != entry.generation || typeInfo->updatePeriodMs <= 0)
+                    continue;
+                // Reschedule from the due tick so the period does not drift
+                UAVObject* obj = typeInfo->obj;
+                scheduleWheelEntry(entry.dueTick + msToTicks(typeInfo->updatePeriodMs), NULL, entry.objId, entry.generation);
+                processObjectUpdates(obj, EV_UPDATED_PERIODIC, true, false);
+            }
+        }
     }
 
-    // Done
-    timeToNextUpdateMs = minDelay;
-
-    // Restart timer
-    updateTimer->start(timeToNextUpdateMs);
+    if (wheelEntries == 0)
+        wheelTimer->stop();
 }
 
 Telemetry::TelemetryStats Telemetry::getStats()
@@ -662,30 +749,3 @@ void Telemetry::newInstance(UAVObject* obj)
     QMutexLocker locker(mutex);
     registerObject(obj);
 }
-
-ObjectTransactionInfo::ObjectTransactionInfo(QObject* parent):QObject(parent)
-{
-    obj = 0;
-    allInstances = false;
-    objRequest = false;
-    retriesRemaining = 0;
-    acked = false;
-    telem = 0;
-    // Setup transaction timer
-    timer = new QTimer(this);
-    timer->stop();
-    connect(timer, SIGNAL(timeout()), this, SLOT(timeout()));
-}
-
-ObjectTransactionInfo::~ObjectTransactionInfo()
-{
-    telem = 0;
-    timer->stop();
-    delete timer;
-}
-
-void ObjectTransactionInfo::timeout()
-{
-    if (!telem.isNull())
-        telem->transactionTimeout(this);
-}
@@ -37,26 +37,25 @@
 #include <QMutexLocker>
 #include <QTimer>
 #include <QQueue>
-#include <QMap>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
 
 class TransactionKey;
 
-class ObjectTransactionInfo: public QObject {
-    Q_OBJECT
-
-public:
-    ObjectTransactionInfo(QObject * parent);
-    ~ObjectTransactionInfo();
+/**
+ * A pending transaction. Records are pooled by Telemetry and recycled once
+ * the transaction completes, the generation is bumped on every recycle so
+ * that stale timeouts left in the timer wheel can be recognised.
+ */
+typedef struct {
     UAVObject* obj;
     bool allInstances;
     bool objRequest;
     qint32 retriesRemaining;
     bool acked;
-    QPointer<class Telemetry>telem;
-    QTimer* timer;
-private slots:
-    void timeout();
-};
+    quint32 generation;
+} ObjectTransactionInfo;
 
 class Telemetry: public QObject
 {
@@ -79,7 +78,6 @@ public:
     ~Telemetry();
     TelemetryStats getStats();
     void resetStats();
-    void transactionTimeout(ObjectTransactionInfo *info);
 
 signals:
 
@@ -87,9 +85,9 @@ private:
     // Constants
     static const int REQ_TIMEOUT_MS = 250;
     static const int MAX_RETRIES = 2;
-    static const int MAX_UPDATE_PERIOD_MS = 1000;
-    static const int MIN_UPDATE_PERIOD_MS = 1;
     static const int MAX_QUEUE_SIZE = 20;
+    static const int WHEEL_TICK_MS = 5;
+    static const int WHEEL_SLOTS = 256;
 
     // Types
     /**
@@ -104,11 +102,19 @@ private:
         EV_UPDATE_REQ = 0x010       /** Request to update object data */
     } EventMask;
 
+    /**
+     * Per object type state, the metadata flags are cached here and only
+     * refreshed when the metaobject changes.
+     */
     typedef struct {
-        UAVObject* obj;
+        UAVObject* obj;             /** First instance, used for periodic updates */
+        UAVObject* parent;          /** Parent object if obj is a metaobject, NULL otherwise */
+        UAVObject::UpdateMode updateMode; /** GCS telemetry update mode */
+        bool acked;                 /** GCS telemetry acked flag */
+        qint32 eventMask;           /** Events connected on all instances, -1 if none yet */
         qint32 updatePeriodMs;      /** Update period in ms or 0 if no periodic updates are needed */
-        qint32 timeToNextUpdateMs;  /** Time delay to the next update */
-    } ObjectTimeInfo;
+        quint32 periodGeneration;   /** Invalidates periodic entries left in the timer wheel */
+    } ObjectTypeInfo;
 
     typedef struct {
         UAVObject* obj;
@@ -116,32 +122,53 @@ private:
         bool allInstances;
     } ObjectQueueInfo;
 
+    /**
+     * Timer wheel entry, either a transaction timeout (transInfo set) or
+     * a periodic update of an object type (transInfo NULL).
+     */
+    typedef struct {
+        qint64 dueTick;
+        quint32 generation;
+        ObjectTransactionInfo* transInfo;
+        quint32 objId;
+    } WheelEntry;
+
     // Variables
     UAVObjectManager* objMngr;
     UAVTalk* utalk;
     GCSTelemetryStats* gcsStatsObj;
-    QVector<ObjectTimeInfo> objList;
+    QHash<quint32, ObjectTypeInfo> objTypes;
     QQueue<ObjectQueueInfo> objQueue;
     QQueue<ObjectQueueInfo> objPriorityQueue;
-    QMap<TransactionKey, ObjectTransactionInfo*>transMap;
+    bool processingQueue;
+    QHash<TransactionKey, ObjectTransactionInfo*> transMap;
+    QVector<ObjectTransactionInfo*> transPool;
+    QVector< QVector<WheelEntry> > wheel;
+    qint64 wheelTick;
+    int wheelEntries;
+    QElapsedTimer wheelClock;
     QMutex* mutex;
-    QTimer* updateTimer;
-    QTimer* statsTimer;
-    qint32 timeToNextUpdateMs;
+    QTimer* wheelTimer;
     quint32 txErrors;
     quint32 txRetries;
 
     // Methods
     void registerObject(UAVObject* obj);
     void addObject(UAVObject* obj);
-    void setUpdatePeriod(UAVObject* obj, qint32 periodMs);
+    void setUpdatePeriod(ObjectTypeInfo &typeInfo, qint32 periodMs);
     void connectToObjectInstances(UAVObject* obj, quint32 eventMask);
-    void updateObject(UAVObject* obj, quint32 eventMask);
+    void updateObject(UAVObject* obj, quint32 eventMask, bool force = false);
     void processObjectUpdates(UAVObject* obj, EventMask event, bool allInstances, bool priority);
     void processObjectTransaction(ObjectTransactionInfo *transInfo);
     void processObjectQueue();
+    void processObjectEvent(const ObjectQueueInfo &objInfo);
     bool updateTransactionMap(UAVObject* obj, bool request);
-
+    ObjectTransactionInfo* allocTransaction();
+    void releaseTransaction(ObjectTransactionInfo *transInfo);
+    void transactionTimeout(ObjectTransactionInfo *transInfo);
+    void scheduleWheelEntry(qint64 dueTick, ObjectTransactionInfo *transInfo, quint32 objId, quint32 generation);
+    qint64 currentTick() const;
+    static qint64 msToTicks(qint32 ms);
 
 private slots:
     void objectUpdatedAuto(UAVObject* obj);
@@ -151,7 +178,7 @@ private slots:
     void updateRequested(UAVObject* obj);
     void newObject(UAVObject* obj);
     void newInstance(UAVObject* obj);
-    void processPeriodicUpdates();
+    void processTimerWheel();
     void transactionSuccess(UAVObject* obj);
     void transactionFailure(UAVObject* obj);
     void transactionRequestCompleted(UAVObject* obj);
@@ -47,8 +47,8 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel)
     gcsStatsObj = GCSTelemetryStats::GetInstance(objMngr);
     flightStatsObj = FlightTelemetryStats::GetInstance(objMngr);
 
-    // Listen for flight stats updates
-    connect(flightStatsObj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(flightStatsUpdated(UAVObject*)));
+    // Listen for flight stats updates, directly on the telemetry thread
+    connect(flightStatsObj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(flightStatsUpdated(UAVObject*)));
 
     // Start update timer
     statsTimer = new QTimer(this);
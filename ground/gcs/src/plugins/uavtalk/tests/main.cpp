@@ -0,0 +1,164 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Runs the telemetry benchmarks against a private object manager
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "telemetrybenchmark.h"
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+#include <QCoreApplication>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDebug>
+
+/**
+ * GUI thread side of the benchmark. It receives the objectUpdated
+ * notifications of every object, as the gadgets do, and measures the
+ * time the event loop needs per frame. Reports once per second along
+ * with the unpack to notification latency gathered by UAVObject.
+ */
+class FrameProbe : public QObject
+{
+    Q_OBJECT
+
+public:
+    FrameProbe(UAVObjectManager *objMngr) :
+        frames(0),
+        totalFrameUs(0),
+        maxFrameUs(0),
+        received(0)
+    {
+        foreach (QVector<UAVObject *> instances, objMngr->getObjects()) {
+            foreach (UAVObject *obj, instances)
+                connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)));
+        }
+        connect(&frameTimer, SIGNAL(timeout()), this, SLOT(frameTick()));
+        frameTimer.start(FRAME_PERIOD_MS);
+        frameClock.start();
+        reportClock.start();
+    }
+
+private slots:
+    void objectUpdated(UAVObject *obj)
+    {
+        Q_UNUSED(obj);
+        ++received;
+    }
+
+    /**
+     * The time between two ticks is the time the event loop needed to
+     * process one frame worth of events.
+     */
+    void frameTick()
+    {
+        qint64 frameUs = frameClock.nsecsElapsed() / 1000;
+        frameClock.restart();
+
+        frames++;
+        totalFrameUs += frameUs;
+        if (frameUs > maxFrameUs)
+            maxFrameUs = frameUs;
+
+        if (reportClock.elapsed() < REPORT_PERIOD_MS)
+            return;
+        reportClock.restart();
+
+        UAVObject::NotificationStats stats = UAVObject::takeNotificationStats();
+        qDebug() << "[FrameProbe] notifications:" << stats.notifications
+                 << "received:" << received
+                 << "coalesced:" << stats.coalesced
+                 << "latency avg/max (us):" << (stats.notifications ? stats.totalLatencyUs / stats.notifications : 0)
+                 << "/" << stats.maxLatencyUs
+                 << "GUI frame avg/max (us):" << (frames ? totalFrameUs / frames : 0)
+                 << "/" << maxFrameUs;
+
+        frames = 0;
+        totalFrameUs = 0;
+        maxFrameUs = 0;
+        received = 0;
+    }
+
+private:
+    static const int FRAME_PERIOD_MS = 16;
+    static const int REPORT_PERIOD_MS = 1000;
+
+    QTimer frameTimer;
+    QElapsedTimer frameClock;
+    QElapsedTimer reportClock;
+    quint32 frames;
+    qint64 totalFrameUs;
+    qint64 maxFrameUs;
+    quint32 received;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+
+    QString mode = args.value(1);
+    if (mode != "updates" && mode != "stream") {
+        qDebug() << "usage:" << args.value(0) << "updates [updates/s] [seconds]";
+        qDebug() << "      " << args.value(0) << "stream [bytes/s] [seconds]";
+        return 1;
+    }
+    int rate = args.value(2).toInt();
+    int seconds = args.value(3).toInt();
+    if (seconds <= 0)
+        seconds = 10;
+
+    // The benchmark objects are private to this process, nothing else
+    // sees the generated traffic
+    ExtensionSystem::PluginManager pm;
+    UAVObjectManager *objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(objMngr);
+    pm.addObject(objMngr);
+
+    QThread linkThread;
+    linkThread.start();
+
+    FrameProbe probe(objMngr);
+    QObject *generator;
+    if (mode == "updates")
+        generator = new TelemetryBenchmark(objMngr, rate > 0 ? rate : 10000, &linkThread);
+    else
+        generator = new TelemetryStreamGenerator(objMngr, rate > 0 ? rate : 1000000, &linkThread);
+    QObject::connect(&linkThread, SIGNAL(finished()), generator, SLOT(deleteLater()));
+    QMetaObject::invokeMethod(generator, "start", Qt::QueuedConnection);
+
+    QTimer::singleShot(seconds * 1000, &app, SLOT(quit()));
+    int ret = app.exec();
+
+    linkThread.quit();
+    linkThread.wait();
+
+    pm.removeObject(objMngr);
+    return ret;
+}
+
+#include "main.moc"
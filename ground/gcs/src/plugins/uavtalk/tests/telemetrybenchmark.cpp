@@ -0,0 +1,265 @@
+/**
+ ******************************************************************************
+ *
+ * @file       telemetrybenchmark.cpp
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Throughput benchmark of the telemetry scheduler over a loopback link
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify 
+ * it under the terms of the GNU General Public License as published by 
+ * the Free Software Foundation; either version 3 of the License, or 
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+ * for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "telemetrybenchmark.h"
+#include "telemetry.h"
+#include "uavtalk.h"
+#include "gcstelemetrystats.h"
+
+#include <QDebug>
+#include <string.h>
+
+LoopbackDevice::LoopbackDevice(QObject *parent) :
+    QIODevice(parent),
+    notifyPending(false)
+{
+}
+
+bool LoopbackDevice::isSequential() const
+{
+    return true;
+}
+
+qint64 LoopbackDevice::bytesAvailable() const
+{
+    return buffer.size() + QIODevice::bytesAvailable();
+}
+
+qint64 LoopbackDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 size = qMin<qint64>(maxSize, buffer.size());
+    memcpy(data, buffer.constData(), size);
+    buffer.remove(0, size);
+    return size;
+}
+
+qint64 LoopbackDevice::writeData(const char *data, qint64 maxSize)
+{
+    buffer.append(data, maxSize);
+    if (!notifyPending) {
+        notifyPending = true;
+        QMetaObject::invokeMethod(this, "notifyReadyRead", Qt::QueuedConnection);
+    }
+    return maxSize;
+}
+
+void LoopbackDevice::notifyReadyRead()
+{
+    notifyPending = false;
+    emit readyRead();
+}
+
+TelemetryBenchmark::TelemetryBenchmark(UAVObjectManager *objMngr, int updatesPerSecond, QThread *linkThread) :
+    objMngr(objMngr),
+    updatesPerSecond(updatesPerSecond),
+    device(0),
+    utalk(0),
+    telemetry(0),
+    obj(0),
+    timer(0),
+    generated(0),
+    updates(0),
+    unpacked(0),
+    busyNs(0)
+{
+    // Run on the link thread, as the real telemetry does
+    moveToThread(linkThread);
+}
+
+TelemetryBenchmark::~TelemetryBenchmark()
+{
+    delete telemetry;
+    delete utalk;
+    delete device;
+}
+
+/**
+ * Setup the loopback link, must be called from the benchmark thread
+ */
+void TelemetryBenchmark::start()
+{
+    device = new LoopbackDevice();
+    device->open(QIODevice::ReadWrite);
+    utalk = new UAVTalk(device, objMngr);
+    telemetry = new Telemetry(utalk, objMngr);
+
+    // GCSTelemetryStats is sent unacked and is let through by Telemetry
+    // before a connection is established
+    obj = GCSTelemetryStats::GetInstance(objMngr);
+    connect(obj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(objectUnpacked(UAVObject*)), Qt::DirectConnection);
+
+    timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(generateUpdates()));
+    timer->start(GENERATE_PERIOD_MS);
+    clock.start();
+    reportClock.start();
+    qDebug() << "[TelemetryBenchmark] Sending" << updatesPerSecond << "updates/s through a loopback link";
+}
+
+/**
+ * Issue the updates that are due since the last call, then report once per period
+ */
+void TelemetryBenchmark::generateUpdates()
+{
+    const qint64 target = clock.elapsed() * updatesPerSecond / 1000;
+
+    QElapsedTimer busy;
+    busy.start();
+    while (generated < target) {
+        obj->updated();
+        ++generated;
+        ++updates;
+    }
+    busyNs += busy.nsecsElapsed();
+
+    const qint64 elapsedMs = reportClock.elapsed();
+    if (elapsedMs < REPORT_PERIOD_MS)
+        return;
+    reportClock.restart();
+
+    Telemetry::TelemetryStats stats = telemetry->getStats();
+    telemetry->resetStats();
+    qDebug() << "[TelemetryBenchmark] updates/s:" << updates * 1000 / elapsedMs
+             << "tx objects/s:" << (qint64)stats.txObjects * 1000 / elapsedMs
+             << "rx objects/s:" << (qint64)stats.rxObjects * 1000 / elapsedMs
+             << "unpacked/s:" << (qint64)unpacked * 1000 / elapsedMs
+             << "tx errors:" << stats.txErrors
+             << "rx errors:" << stats.rxErrors
+             << "cost per update (us):" << (updates ? busyNs / 1000.0 / updates : 0.0);
+    updates = 0;
+    unpacked = 0;
+    busyNs = 0;
+}
+
+void TelemetryBenchmark::objectUnpacked(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+    ++unpacked;
+}
+
+TelemetryStreamGenerator::TelemetryStreamGenerator(UAVObjectManager *objMngr, int bytesPerSecond, QThread *linkThread) :
+    objMngr(objMngr),
+    bytesPerSecond(bytesPerSecond),
+    device(0),
+    utalk(0),
+    nextObject(0),
+    marker(0),
+    timer(0),
+    sentBytes(0),
+    reportedBytes(0),
+    batches(0),
+    totalLatencyUs(0),
+    maxLatencyUs(0)
+{
+    // Run on the link thread, as the real telemetry does
+    moveToThread(linkThread);
+}
+
+TelemetryStreamGenerator::~TelemetryStreamGenerator()
+{
+    delete utalk;
+    delete device;
+}
+
+/**
+ * Setup the loopback link, must be called from the generator thread
+ */
+void TelemetryStreamGenerator::start()
+{
+    device = new LoopbackDevice();
+    device->open(QIODevice::ReadWrite);
+    utalk = new UAVTalk(device, objMngr);
+
+    // Stream the objects the flight side sends, settings would mark the
+    // GCS copies as changed
+    foreach (QVector<UAVDataObject *> instances, objMngr->getDataObjects()) {
+        if (!instances.isEmpty() && !instances[0]->isSettings())
+            objects.append(instances[0]);
+    }
+
+    // Every batch ends with the marker, its unpack closes the batch
+    marker = GCSTelemetryStats::GetInstance(objMngr);
+    connect(marker, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(markerUnpacked(UAVObject*)), Qt::DirectConnection);
+
+    timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(generatePackets()));
+    timer->start(GENERATE_PERIOD_MS);
+    clock.start();
+    reportClock.start();
+    qDebug() << "[TelemetryStreamGenerator] Streaming" << bytesPerSecond << "bytes/s of"
+             << objects.size() << "objects through a loopback link";
+}
+
+/**
+ * Write the packets that are due since the last call as one batch, then
+ * report once per period
+ */
+void TelemetryStreamGenerator::generatePackets()
+{
+    const qint64 target = clock.elapsed() * bytesPerSecond / 1000;
+
+    if (sentBytes < target && !objects.isEmpty()) {
+        while (sentBytes < target) {
+            utalk->sendObject(objects[nextObject], false, false);
+            nextObject = (nextObject + 1) % objects.size();
+            sentBytes = reportedBytes + utalk->getStats().txBytes;
+        }
+        utalk->sendObject(marker, false, false);
+        batchTimes.enqueue(clock.nsecsElapsed());
+    }
+
+    const qint64 elapsedMs = reportClock.elapsed();
+    if (elapsedMs < REPORT_PERIOD_MS)
+        return;
+    reportClock.restart();
+
+    UAVTalk::ComStats stats = utalk->getStats();
+    utalk->resetStats();
+    reportedBytes += stats.txBytes;
+    sentBytes = reportedBytes;
+    qDebug() << "[TelemetryStreamGenerator] tx bytes/s:" << (qint64)stats.txBytes * 1000 / elapsedMs
+             << "rx bytes/s:" << (qint64)stats.rxBytes * 1000 / elapsedMs
+             << "rx objects/s:" << (qint64)stats.rxObjects * 1000 / elapsedMs
+             << "rx errors:" << stats.rxErrors
+             << "batch write to unpack avg/max (us):" << (batches ? totalLatencyUs / batches : 0)
+             << "/" << maxLatencyUs
+             << "batches in flight:" << batchTimes.size();
+    batches = 0;
+    totalLatencyUs = 0;
+    maxLatencyUs = 0;
+}
+
+void TelemetryStreamGenerator::markerUnpacked(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+    if (batchTimes.isEmpty())
+        return;
+
+    qint64 latencyUs = (clock.nsecsElapsed() - batchTimes.dequeue()) / 1000;
+    ++batches;
+    totalLatencyUs += latencyUs;
+    if (latencyUs > maxLatencyUs)
+        maxLatencyUs = latencyUs;
+}
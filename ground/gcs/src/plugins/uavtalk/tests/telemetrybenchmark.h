@@ -0,0 +1,152 @@
+/**
+ ******************************************************************************
+ *
+ * @file       telemetrybenchmark.h
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Throughput benchmark of the telemetry scheduler over a loopback link
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify 
+ * it under the terms of the GNU General Public License as published by 
+ * the Free Software Foundation; either version 3 of the License, or 
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but 
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY 
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License 
+ * for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along 
+ * with this program; if not, write to the Free Software Foundation, Inc., 
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef TELEMETRYBENCHMARK_H
+#define TELEMETRYBENCHMARK_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QQueue>
+#include <QThread>
+#include "uavobjectmanager.h"
+
+class UAVTalk;
+class Telemetry;
+
+/**
+ * Sequential device that reads back everything written to it. readyRead
+ * is emitted from the event loop, as for a real link.
+ */
+class LoopbackDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit LoopbackDevice(QObject *parent = 0);
+
+    bool isSequential() const;
+    qint64 bytesAvailable() const;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private slots:
+    void notifyReadyRead();
+
+private:
+    QByteArray buffer;
+    bool notifyPending;
+};
+
+/**
+ * Drives a dedicated UAVTalk/Telemetry pair over a LoopbackDevice with a
+ * fixed rate of object updates and reports the achieved throughput once
+ * per second. Every update goes through the telemetry queue, is sent,
+ * looped back, unpacked and goes through the queue again as an unpack
+ * event.
+ */
+class TelemetryBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    TelemetryBenchmark(UAVObjectManager *objMngr, int updatesPerSecond, QThread *linkThread);
+    ~TelemetryBenchmark();
+
+public slots:
+    void start();
+
+private slots:
+    void generateUpdates();
+    void objectUnpacked(UAVObject *obj);
+
+private:
+    static const int GENERATE_PERIOD_MS = 1;
+    static const int REPORT_PERIOD_MS = 1000;
+
+    UAVObjectManager *objMngr;
+    int updatesPerSecond;
+    LoopbackDevice *device;
+    UAVTalk *utalk;
+    Telemetry *telemetry;
+    UAVObject *obj;
+    QTimer *timer;
+    QElapsedTimer clock;
+    QElapsedTimer reportClock;
+    qint64 generated;
+    quint32 updates;
+    quint32 unpacked;
+    qint64 busyNs;
+};
+
+/**
+ * Feeds a fixed byte rate of UAVTalk packets for the flight side objects
+ * through a LoopbackDevice into the real objects, as a busy link would.
+ * Reports the achieved rate and the latency from a batch being written to
+ * its last packet being unpacked once per second. The unpack to GUI
+ * notification latency and the GUI frame times are reported by the
+ * FrameProbe of the benchmark application.
+ */
+class TelemetryStreamGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    TelemetryStreamGenerator(UAVObjectManager *objMngr, int bytesPerSecond, QThread *linkThread);
+    ~TelemetryStreamGenerator();
+
+public slots:
+    void start();
+
+private slots:
+    void generatePackets();
+    void markerUnpacked(UAVObject *obj);
+
+private:
+    static const int GENERATE_PERIOD_MS = 1;
+    static const int REPORT_PERIOD_MS = 1000;
+
+    UAVObjectManager *objMngr;
+    int bytesPerSecond;
+    LoopbackDevice *device;
+    UAVTalk *utalk;
+    QVector<UAVObject *> objects;
+    int nextObject;
+    UAVObject *marker;
+    QTimer *timer;
+    QElapsedTimer clock;
+    QElapsedTimer reportClock;
+    qint64 sentBytes;
+    qint64 reportedBytes;
+    QQueue<qint64> batchTimes;
+    quint32 batches;
+    qint64 totalLatencyUs;
+    qint64 maxLatencyUs;
+};
+
+#endif // TELEMETRYBENCHMARK_H
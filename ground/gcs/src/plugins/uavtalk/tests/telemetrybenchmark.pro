@@ -0,0 +1,23 @@
+# -------------------------------------------------
+# Standalone telemetry pipeline benchmark over a loopback link.
+# Not part of the GCS build, run it by hand:
+#   telemetrybenchmark updates [updates/s] [seconds]
+#   telemetrybenchmark stream [bytes/s] [seconds]
+# -------------------------------------------------
+include(../../../../gcs.pri)
+QT += network
+TARGET = telemetrybenchmark
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins
+LIBS += -L$$GCS_PLUGIN_PATH/TauLabs
+QMAKE_RPATHDIR += $$GCS_LIBRARY_PATH $$GCS_PLUGIN_PATH/TauLabs
+include(../../../libs/extensionsystem/extensionsystem.pri)
+include(../uavtalk_dependencies.pri)
+include(../uavtalk.pri)
+
+SOURCES += main.cpp \
+    telemetrybenchmark.cpp
+HEADERS += telemetrybenchmark.h
@@ -79,7 +79,7 @@ UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr)
     connect(io, SIGNAL(readyRead()), this, SLOT(processInputStream()));
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
-    useUDPMirror=settings->useUDPMirror();
+    useUDPMirror=settings && settings->useUDPMirror();
     qDebug()<<"[uavtalk.cpp  ] Use UDP: "<<useUDPMirror;
     if(useUDPMirror)
     {
@@ -123,13 +123,15 @@ UAVTalk::ComStats UAVTalk::getStats()
  */
 void UAVTalk::processInputStream()
 {
-    quint8 tmp;
-
     if (io && io->isReadable()) {
+        // Drain everything available at once, one read() per byte is
+        // far too slow on a busy link
         while (io->bytesAvailable() > 0)
         {
-            io->read((char*)&tmp, 1);
-            processInputByte(tmp);
+            QByteArray rxData = io->readAll();
+            const quint8 *rxBytes = (const quint8 *) rxData.constData();
+            for (int i = 0; i < rxData.size(); ++i)
+                processInputByte(rxBytes[i]);
         }
     }
 }
@@ -620,8 +622,11 @@ UAVObject* UAVTalk::updateObject(quint32 objId, quint16 instId, quint8* data)
         {
             return NULL;
         }
-        // Create a new instance, unpack and register
+        // Create a new instance, unpack and register. The instance is
+        // handed over to the thread owning the other objects, so that its
+        // notifications are delivered like those of the existing instances.
         UAVDataObject* instobj = dobj->clone(instId);
+        instobj->moveToThread(dobj->thread());
         if ( !objMngr->registerObject(instobj) )
         {
             return NULL;
@@ -25,6 +25,7 @@
  */
 
 #include "uavobjectgeneratorflight.h"
+#include <QMap>
 
 using namespace std;
 
@@ -43,17 +44,21 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
     flightIncludeTemplate = readFile( flightCodePath.absoluteFilePath("inc/uavobjecttemplate.h") );
     flightInitTemplate = readFile( flightCodePath.absoluteFilePath("uavobjectsinittemplate.c") );
     flightInitIncludeTemplate = readFile( flightCodePath.absoluteFilePath("inc/uavobjectsinittemplate.h") );
+    flightRegistryTemplate = readFile( flightCodePath.absoluteFilePath("inc/uavobjectsregistrytemplate.h") );
     flightMakeTemplate = readFile( flightCodePath.absoluteFilePath("Makefiletemplate.inc") );
 
-    if ( flightCodeTemplate.isNull() || flightIncludeTemplate.isNull() || flightInitTemplate.isNull()) {
+    if ( flightCodeTemplate.isNull() || flightIncludeTemplate.isNull() || flightInitTemplate.isNull() ||
+         flightRegistryTemplate.isNull()) {
             cerr << "Error: Could not open flight template files." << endl;
             return false;
         }
 
     sizeCalc = 0;
+    QMap<quint32, QString> registry;
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo* info=parser->getObjectByIndex(objidx);
         process_object(info);
+        registry.insert(info->id, info->name);
         flightObjInit.append("#ifdef UAVOBJ_INIT_" + info->namelc +"\r\n");
         flightObjInit.append("    " + info->name + "Initialize();\r\n");
         flightObjInit.append("#endif\r\n");
@@ -84,6 +89,28 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
         return false;
     }
 
+    // Write the flight object registry, sorted by object ID so that the
+    // object manager can binary search it
+    QString registryExterns, registryEntries;
+    QMapIterator<quint32, QString> entry(registry);
+    while (entry.hasNext()) {
+        entry.next();
+        registryExterns.append("extern const UAVObjDescriptor " + entry.value() +
+                               "Descriptor __attribute__((weak));\r\n");
+        registryEntries.append(QString("\t{ 0x%1, &%2Descriptor },\r\n")
+                               .arg(QString().setNum(entry.key(), 16).toUpper())
+                               .arg(entry.value()));
+    }
+    flightRegistryTemplate.replace( QString("$(REGISTRYEXTERNS)"), registryExterns);
+    flightRegistryTemplate.replace( QString("$(REGISTRYENTRIES)"), registryEntries);
+    flightRegistryTemplate.replace( QString("$(REGISTRYSIZE)"), QString().setNum(registry.size()));
+    res = writeFileIfDiffrent( flightOutputPath.absolutePath() + "/uavobjectsregistry.h",
+                     flightRegistryTemplate );
+    if (!res) {
+        cout << "Error: Could not write flight object registry file" << endl;
+        return false;
+    }
+
     // Write the flight object Makefile
     flightMakeTemplate.replace( QString("$(UAVOBJFILENAMES)"), objFileNames);
     flightMakeTemplate.replace( QString("$(UAVOBJNAMES)"), objNames);
@@ -107,6 +107,18 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
     }
     outInclude.replace(QString("$(DATAFIELDS)"), fields);
 
+    // Replace the $(FIELDDESCRIPTORS) tag
+    QString descriptors;
+    for (int n = 0; n < info->fields.length(); ++n)
+    {
+        descriptors.append( QString("        typedef UAVObjectFieldDescriptor<%1, %2, offsetof(DataFields, %3), %4> %3;\n")
+                            .arg(info->name)
+                            .arg(fieldTypeStrCPP[info->fields[n]->type])
+                            .arg(info->fields[n]->name)
+                            .arg(info->fields[n]->numElements) );
+    }
+    outInclude.replace(QString("$(FIELDDESCRIPTORS)"), descriptors);
+
     // Replace $(PROPERTIES) and related tags
     QString properties;
     QString propertiesImpl;
@@ -605,11 +605,25 @@ QString UAVObjectParser::processObjectAttributes(QDomNode& node, ObjectInfo* inf
     else
         return QString("Object:settings attribute value is invalid");
 
+    // Get latestvalue attribute if present
+    info->isLatestValue = false;
+    attr = attributes.namedItem("latestvalue");
+    if ( !attr.isNull() )
+    {
+        if ( attr.nodeValue().compare(QString("true")) == 0 )
+            info->isLatestValue = true;
+        else if ( attr.nodeValue().compare(QString("false")) != 0 )
+            return QString("Object:latestvalue attribute value is invalid");
+    }
 
     // Settings objects can only have a single instance
     if ( info->isSettings && !info->isSingleInst )
         return QString("Object: Settings objects can not have multiple instances");
 
+    // Latest value channels hold one instance of data that is not persisted
+    if ( info->isLatestValue && (info->isSettings || !info->isSingleInst) )
+        return QString("Object: Latest value objects must be single instance data objects");
+
     // Done
     return QString();
 }
@@ -84,6 +84,7 @@ typedef struct  {
     quint32 id;
     bool isSingleInst;
     bool isSettings;
+    bool isLatestValue; /** Lock-free latest value channel on the flight side */
     AccessMode gcsAccess;
     AccessMode flightAccess;
     bool flightTelemetryAcked;
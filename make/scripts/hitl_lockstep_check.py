@@ -0,0 +1,191 @@
+#!/usr/bin/env python
+#
+# Check that the HITL lockstep posix simulation is deterministic: run it
+# twice, feed it the same sequence of sensor frames and compare the actuator
+# answers of every step bit for bit.
+#
+# Usage: hitl_lockstep_check.py <elf> <uavobject headers> [steps]
+#
+# The simulation is started in the current directory, which has to hold the
+# simulated flash. A fresh blank flash is written before every run so both
+# runs start from the default settings. Before the first step the GCS
+# receiver is configured over telemetry, with every stick centered, so that
+# Stabilization runs in attitude mode on the simulated sensors instead of
+# passing the failsafe commands through.
+#
+# The second run is held for a few seconds before its first step. The
+# simulation keeps scheduling meanwhile, so anything in the flight loop that
+# reads the tick count or the wall clock instead of the frame clock makes the
+# answers of the two runs differ.
+
+from __future__ import print_function
+
+import math
+import os
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+import sim_uavtalk
+
+SENSORS_MAGIC = 0x4C4B5331
+ACTUATORS_MAGIC = 0x4C4B4131
+DEFAULT_PORT = 9002
+NUM_ACTUATORS = 8
+
+# See shared/api/hitl_lockstep.h
+SENSORS_FORMAT = '<II' + 'f' * 21
+ACTUATORS_FORMAT = '<II' + 'f' * NUM_ACTUATORS
+
+FLASH_NAME = 'theflash.bin'
+FLASH_SIZE = 3 * 1024 * 1024
+
+STEP_DT = 0.002
+START_TIMEOUT_S = 30
+STEP_TIMEOUT_S = 1
+STEP_RETRIES = 10
+CONTROL_TIMEOUT_S = 10
+SECOND_RUN_HOLD_S = 5
+
+
+def sensor_frame(step):
+    """ The frame of a step, a slow oscillation on every axis """
+    t = step * STEP_DT
+    gyros = [30 * math.sin(2 * math.pi * 0.5 * t),
+             20 * math.sin(2 * math.pi * 0.3 * t),
+             10 * math.sin(2 * math.pi * 0.2 * t)]
+    accels = [0.5 * math.sin(2 * math.pi * 0.4 * t), 0.0, -9.81]
+    mag = [0.0, 0.0, 0.0]
+    baro = [10.0 + math.sin(2 * math.pi * 0.1 * t)]
+    q = [1.0, 0.0, 0.0, 0.0]
+    velocity = [0.0, 0.0, 0.0]
+    position = [0.0, 0.0, -10.0]
+    values = accels + gyros + mag + baro + q + velocity + position
+    return struct.pack(SENSORS_FORMAT, SENSORS_MAGIC, step, STEP_DT, *values)
+
+
+def exchange(sock, address, step, timeout, retries):
+    """ Send the frame of a step until it is answered, return the answer """
+    frame = sensor_frame(step)
+    sock.settimeout(timeout)
+    for _ in range(retries):
+        sock.sendto(frame, address)
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            try:
+                data = sock.recv(1024)
+            except socket.timeout:
+                break
+            if len(data) != struct.calcsize(ACTUATORS_FORMAT):
+                continue
+            reply = struct.unpack(ACTUATORS_FORMAT, data)
+            if reply[0] == ACTUATORS_MAGIC and reply[1] == step:
+                return data[8:]
+    return None
+
+
+def take_control(synthetics):
+    """ Fly from the GCS receiver in Stabilized1, its missing channels read
+    as centered """
+    settings_obj = sim_uavtalk.UAVObject(synthetics, 'ManualControlSettings')
+    status_obj = sim_uavtalk.UAVObject(synthetics, 'FlightStatus')
+
+    telemetry = sim_uavtalk.Telemetry(timeout=START_TIMEOUT_S)
+    try:
+        settings = telemetry.get(settings_obj)
+        for n, channel in enumerate(['Throttle', 'Roll', 'Pitch', 'Yaw']):
+            i = settings_obj.const('ChannelGroups', channel)
+            settings['ChannelGroups'][i] = settings_obj.const('ChannelGroups', 'GCS')
+            settings['ChannelNumber'][i] = n + 1
+            settings['ChannelMin'][i] = 1000
+            settings['ChannelNeutral'][i] = 1500
+            settings['ChannelMax'][i] = 2000
+        settings['FlightModeNumber'] = 1
+        settings['FlightModePosition'][0] = settings_obj.const('FlightModePosition', 'Stabilized1')
+        telemetry.set(settings_obj, settings)
+
+        deadline = time.time() + CONTROL_TIMEOUT_S
+        while True:
+            status = telemetry.get(status_obj)
+            if (status['ControlSource'] == status_obj.const('ControlSource', 'Transmitter') and
+                    status['FlightMode'] == status_obj.const('FlightMode', 'Stabilized1')):
+                break
+            if time.time() > deadline:
+                raise RuntimeError('the simulation did not switch to the GCS receiver')
+            time.sleep(0.1)
+    finally:
+        telemetry.close()
+
+
+def run(elf, synthetics, steps, hold=0):
+    """ Drive one run of the simulation, return the answers of all steps.
+    The first step is sent hold seconds after the simulation took control """
+    with open(FLASH_NAME, 'wb') as flash:
+        flash.write(b'\xff' * FLASH_SIZE)
+
+    with open(os.devnull, 'w') as devnull:
+        sim = subprocess.Popen([elf], stdout=devnull)
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    address = ('127.0.0.1', DEFAULT_PORT)
+    answers = []
+    try:
+        take_control(synthetics)
+        time.sleep(hold)
+
+        # The first step is repeated until the simulation is up
+        answer = exchange(sock, address, 1, 0.1, int(START_TIMEOUT_S / 0.1))
+        if answer is None:
+            raise RuntimeError('the simulation did not answer the first step')
+        answers.append(answer)
+
+        for step in range(2, steps + 1):
+            answer = exchange(sock, address, step, STEP_TIMEOUT_S, STEP_RETRIES)
+            if answer is None:
+                raise RuntimeError('step %d was not answered' % step)
+            answers.append(answer)
+    finally:
+        sock.close()
+        sim.terminate()
+        sim.wait()
+
+    return answers
+
+
+def main():
+    if len(sys.argv) < 3:
+        print('usage: hitl_lockstep_check.py <elf> <uavobject headers> [steps]')
+        return 2
+
+    elf = os.path.abspath(sys.argv[1])
+    synthetics = sys.argv[2]
+    steps = int(sys.argv[3]) if len(sys.argv) > 3 else 5000
+
+    started = time.time()
+    first = run(elf, synthetics, steps)
+    elapsed = time.time() - started
+    print('Lockstep: %d steps in %.1f s, %.0f steps/s' % (steps, elapsed, steps / elapsed))
+
+    second = run(elf, synthetics, steps, SECOND_RUN_HOLD_S)
+
+    for step, (a, b) in enumerate(zip(first, second), 1):
+        if a != b:
+            print('Lockstep: FAILED, the answers differ from step %d' % step)
+            print('  first run:  %s' % (struct.unpack('<' + 'f' * NUM_ACTUATORS, a),))
+            print('  second run: %s' % (struct.unpack('<' + 'f' * NUM_ACTUATORS, b),))
+            return 1
+
+    # The attitude loop follows the sensors, so the answers cannot all match
+    distinct = len(set(first))
+    if distinct < 2:
+        print('Lockstep: FAILED, every step was answered the same, the control loop did not run')
+        return 1
+
+    print('Lockstep: %d steps identical in both runs, %d distinct answers' % (steps, distinct))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
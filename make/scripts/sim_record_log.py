@@ -0,0 +1,153 @@
+#!/usr/bin/env python
+#
+# Record an armed flight of the posix simulation for the log replay check.
+#
+# Usage: sim_record_log.py <elf> <uavobject headers> [seconds]
+#
+# The simulation is started in the current directory on a fresh blank flash
+# and writes its log there (sim_log.opl, see the simulated OveroSync). Over
+# telemetry the airframe is set up as a QuadX, the GCS receiver is made the
+# transmitter and the vehicle is armed at zero throttle in Stabilized1. It
+# is then flown for the given time with some throttle and slow stick
+# movements, so that the log holds the gains of the control loops at work
+# and not only their disarmed outputs.
+
+from __future__ import print_function
+
+import math
+import os
+import subprocess
+import sys
+import time
+
+import sim_uavtalk
+
+FLASH_NAME = 'theflash.bin'
+FLASH_SIZE = 3 * 1024 * 1024
+LOG_NAME = 'sim_log.opl'
+
+START_TIMEOUT_S = 30
+ARM_TIMEOUT_S = 10
+# Well below PIOS_GCSRCVR_TIMEOUT_MS of the simulation
+STICK_PERIOD_S = 0.02
+
+CHANNELS = ['Throttle', 'Roll', 'Pitch', 'Yaw']
+
+# QuadX motors: throttle curve 1, throttle curve 2, roll, pitch, yaw
+QUADX_MIXER = [[127, 0, 64, 64, -64],
+               [127, 0, -64, 64, 64],
+               [127, 0, -64, -64, -64],
+               [127, 0, 64, -64, 64]]
+
+
+def sticks(t):
+    """ Receiver pulses for the throttle, roll, pitch and yaw at time t """
+    if t is None:
+        return [1000, 1500, 1500, 1500]
+    return [1400,
+            1500 + int(200 * math.sin(2 * math.pi * 0.5 * t)),
+            1500 + int(150 * math.sin(2 * math.pi * 0.3 * t)),
+            1500 + int(100 * math.sin(2 * math.pi * 0.2 * t))]
+
+
+def send_sticks(telemetry, receiver_obj, t):
+    channels = sticks(t)
+    telemetry.update(receiver_obj, {'Channel': channels + [1500] * (8 - len(channels))})
+
+
+def setup_airframe(telemetry, synthetics):
+    """ Four motors, without them Actuator stays in failsafe and the
+    vehicle refuses to arm """
+    mixer_obj = sim_uavtalk.UAVObject(synthetics, 'MixerSettings')
+    mixer = telemetry.get(mixer_obj)
+    for n, vector in enumerate(QUADX_MIXER):
+        mixer['Mixer%dType' % (n + 1)] = mixer_obj.const('Mixer1Type', 'Motor')
+        mixer['Mixer%dVector' % (n + 1)] = vector
+    telemetry.set(mixer_obj, mixer)
+
+    actuator_obj = sim_uavtalk.UAVObject(synthetics, 'ActuatorSettings')
+    actuator = telemetry.get(actuator_obj)
+    for n in range(len(QUADX_MIXER)):
+        actuator['ChannelMin'][n] = 1000
+        actuator['ChannelNeutral'][n] = 1000
+        actuator['ChannelMax'][n] = 2000
+    telemetry.set(actuator_obj, actuator)
+
+
+def take_control(telemetry, synthetics):
+    """ Fly from the GCS receiver in Stabilized1, armed as soon as the
+    throttle is low """
+    settings_obj = sim_uavtalk.UAVObject(synthetics, 'ManualControlSettings')
+    settings = telemetry.get(settings_obj)
+    for n, channel in enumerate(CHANNELS):
+        i = settings_obj.const('ChannelGroups', channel)
+        settings['ChannelGroups'][i] = settings_obj.const('ChannelGroups', 'GCS')
+        settings['ChannelNumber'][i] = n + 1
+        settings['ChannelMin'][i] = 1000
+        settings['ChannelNeutral'][i] = 1000 if channel == 'Throttle' else 1500
+        settings['ChannelMax'][i] = 2000
+    settings['FlightModeNumber'] = 1
+    settings['FlightModePosition'][0] = settings_obj.const('FlightModePosition', 'Stabilized1')
+    settings['Arming'] = settings_obj.const('Arming', 'AlwaysArmed')
+    telemetry.set(settings_obj, settings)
+
+
+def record(elf, synthetics, seconds):
+    with open(FLASH_NAME, 'wb') as flash:
+        flash.write(b'\xff' * FLASH_SIZE)
+    if os.path.exists(LOG_NAME):
+        os.remove(LOG_NAME)
+
+    receiver_obj = sim_uavtalk.UAVObject(synthetics, 'GCSReceiver')
+    status_obj = sim_uavtalk.UAVObject(synthetics, 'FlightStatus')
+
+    with open(os.devnull, 'w') as devnull:
+        sim = subprocess.Popen([elf], stdout=devnull)
+
+    try:
+        telemetry = sim_uavtalk.Telemetry(timeout=START_TIMEOUT_S)
+        try:
+            send_sticks(telemetry, receiver_obj, None)
+            setup_airframe(telemetry, synthetics)
+            take_control(telemetry, synthetics)
+
+            deadline = time.time() + ARM_TIMEOUT_S
+            while True:
+                send_sticks(telemetry, receiver_obj, None)
+                status = telemetry.get(status_obj)
+                if (status['Armed'] == status_obj.const('Armed', 'Armed') and
+                        status['FlightMode'] == status_obj.const('FlightMode', 'Stabilized1')):
+                    break
+                if time.time() > deadline:
+                    raise RuntimeError('the simulation did not arm')
+                time.sleep(STICK_PERIOD_S)
+
+            start = time.time()
+            while time.time() - start < seconds:
+                send_sticks(telemetry, receiver_obj, time.time() - start)
+                time.sleep(STICK_PERIOD_S)
+        finally:
+            telemetry.close()
+    finally:
+        sim.terminate()
+        sim.wait()
+
+    if not os.path.exists(LOG_NAME):
+        raise RuntimeError('the simulation did not write %s' % LOG_NAME)
+
+
+def main():
+    if len(sys.argv) < 3:
+        print('usage: sim_record_log.py <elf> <uavobject headers> [seconds]')
+        return 2
+
+    elf = os.path.abspath(sys.argv[1])
+    seconds = float(sys.argv[3]) if len(sys.argv) > 3 else 2
+
+    record(elf, sys.argv[2], seconds)
+    print('Recorded %.1f s of armed flight in %s' % (seconds, os.path.abspath(LOG_NAME)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,176 @@
+#
+# Minimal UAVTalk client for the posix simulation, enough to read and write
+# whole objects over the TCP telemetry port from test scripts.
+#
+# The object layouts are taken from the headers the UAVObject generator
+# writes for the flight code, so they always match the simulation that was
+# built from them.
+
+from __future__ import print_function
+
+import os
+import re
+import socket
+import struct
+import time
+
+SYNC_VAL = 0x3C
+TYPE_VER = 0x20
+TYPE_OBJ = TYPE_VER | 0x00
+TYPE_OBJ_REQ = TYPE_VER | 0x01
+TYPE_OBJ_ACK = TYPE_VER | 0x02
+TYPE_ACK = TYPE_VER | 0x03
+TYPE_NACK = TYPE_VER | 0x04
+TYPE_MASK = 0x78
+TIMESTAMPED = 0x80
+
+HEADER_LENGTH = 8
+
+C_TYPES = {
+    'int8_t': 'b', 'uint8_t': 'B',
+    'int16_t': 'h', 'uint16_t': 'H',
+    'int32_t': 'i', 'uint32_t': 'I',
+    'float': 'f',
+}
+
+
+def crc8(data, crc=0):
+    """ CRC-8 with polynomial 0x07, as PIOS_CRC_updateByte() """
+    for b in bytearray(data):
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+class UAVObject(object):
+    """ Layout of one single instance object, read from its flight header """
+
+    def __init__(self, synthetics_dir, name):
+        self.name = name
+        with open(os.path.join(synthetics_dir, name.lower() + '.h')) as header:
+            text = header.read()
+
+        prefix = name.upper()
+        self.objid = int(re.search(r'#define %s_OBJID (0x[0-9A-Fa-f]+)' % prefix, text).group(1), 16)
+        self.numbytes = int(re.search(r'#define %s_NUMBYTES (\d+)' % prefix, text).group(1))
+
+        body = re.search(r'typedef struct \{(.*?)\} __attribute__\(\(packed\)\)[^;]*%sData;' % name,
+                         text, re.S).group(1)
+        self.fields = []
+        for ctype, field, count in re.findall(r'(\w+) (\w+)(?:\[(\d+)\])?;', body):
+            self.fields.append((field, C_TYPES[ctype], int(count) if count else 1))
+
+        # Enum options and element names, by their generated constant name
+        self.constants = dict((k, int(v)) for k, v in re.findall(r'\b(%s_\w+)=(\d+)' % prefix, text))
+
+        self.format = '<' + ''.join('%d%s' % (count, code) for _, code, count in self.fields)
+        if struct.calcsize(self.format) != self.numbytes:
+            raise ValueError('%s: layout does not match %d bytes' % (name, self.numbytes))
+
+    def const(self, field, value):
+        """ Value of an enum option or index of an element name """
+        return self.constants['%s_%s_%s' % (self.name.upper(), field.upper(), value.upper())]
+
+    def unpack(self, data):
+        values = list(struct.unpack(self.format, data))
+        fields = {}
+        for field, _, count in self.fields:
+            fields[field] = values[:count] if count > 1 else values[0]
+            values = values[count:]
+        return fields
+
+    def pack(self, fields):
+        values = []
+        for field, _, count in self.fields:
+            values += fields[field] if count > 1 else [fields[field]]
+        return struct.pack(self.format, *values)
+
+
+class Telemetry(object):
+    """ UAVTalk over the TCP telemetry port of the simulation """
+
+    def __init__(self, host='127.0.0.1', port=9000, timeout=10):
+        deadline = time.time() + timeout
+        while True:
+            try:
+                self.sock = socket.create_connection((host, port), 1)
+                break
+            except socket.error:
+                if time.time() > deadline:
+                    raise
+                time.sleep(0.1)
+        self.buffer = b''
+
+    def close(self):
+        self.sock.close()
+
+    def send(self, obj, packet_type, data=b''):
+        packet = struct.pack('<BBHI', SYNC_VAL, packet_type, HEADER_LENGTH + len(data), obj.objid) + data
+        self.sock.sendall(packet + struct.pack('B', crc8(packet)))
+
+    def receive(self, objid, types, timeout):
+        """ Wait for a packet of an object of one of the types, return its
+        type and data """
+        deadline = time.time() + timeout
+        while True:
+            while len(self.buffer) >= HEADER_LENGTH + 1:
+                start = self.buffer.find(struct.pack('B', SYNC_VAL))
+                if start < 0:
+                    self.buffer = b''
+                    break
+                self.buffer = self.buffer[start:]
+                if len(self.buffer) < HEADER_LENGTH + 1:
+                    break
+                _, packet_type, size, packet_objid = struct.unpack('<BBHI', self.buffer[:HEADER_LENGTH])
+                if (packet_type & TYPE_MASK) != TYPE_VER or size < HEADER_LENGTH or size > 1024:
+                    self.buffer = self.buffer[1:]
+                    continue
+                if len(self.buffer) < size + 1:
+                    break
+                packet = self.buffer[:size]
+                crc = bytearray(self.buffer[size:size + 1])[0]
+                if crc8(packet) != crc:
+                    self.buffer = self.buffer[1:]
+                    continue
+                self.buffer = self.buffer[size + 1:]
+                if packet_objid == objid and (packet_type & ~TIMESTAMPED) in types:
+                    data = packet[HEADER_LENGTH:]
+                    if packet_type & TIMESTAMPED:
+                        data = data[2:]
+                    return packet_type & ~TIMESTAMPED, data
+
+            remaining = deadline - time.time()
+            if remaining <= 0:
+                return None, None
+            self.sock.settimeout(remaining)
+            try:
+                chunk = self.sock.recv(4096)
+            except socket.timeout:
+                return None, None
+            if not chunk:
+                raise IOError('telemetry connection closed')
+            self.buffer += chunk
+
+    def get(self, obj, timeout=1, retries=5):
+        """ Request an object and return its fields """
+        for _ in range(retries):
+            self.send(obj, TYPE_OBJ_REQ)
+            packet_type, data = self.receive(obj.objid, (TYPE_OBJ, TYPE_OBJ_ACK), timeout)
+            if packet_type is not None and len(data) == obj.numbytes:
+                return obj.unpack(data)
+        raise IOError('no answer to the request of %s' % obj.name)
+
+    def update(self, obj, fields):
+        """ Write an object without waiting for an acknowledge """
+        self.send(obj, TYPE_OBJ, obj.pack(fields))
+
+    def set(self, obj, fields, timeout=1, retries=5):
+        """ Write an object and wait until the flight acknowledged it """
+        data = obj.pack(fields)
+        for _ in range(retries):
+            self.send(obj, TYPE_OBJ_ACK, data)
+            packet_type, _ = self.receive(obj.objid, (TYPE_ACK,), timeout)
+            if packet_type is not None:
+                return
+        raise IOError('%s was not acknowledged' % obj.name)
@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ * @file       hitl_lockstep.h
+ * @addtogroup HITL lockstep protocol
+ * @{
+ * @addtogroup 
+ * @{
+ * @brief Frames exchanged between the GCS HITL bridge and the simulated
+ * flight side when running in lockstep.
+ *
+ * The GCS sends one sensor frame per step, at most at a fixed rate, and waits
+ * for the actuator frame carrying the same step number before starting the
+ * next one. The flight side runs its control loop once per new step and
+ * answers a repeated frame with the same actuators again.
+ * Both ends are expected to share endianness and float layout, which holds
+ * for the host running the GCS and the posix simulation.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef HITL_LOCKSTEP_H_
+#define HITL_LOCKSTEP_H_
+
+#include <stdint.h>
+
+#define HITL_LOCKSTEP_SENSORS_MAGIC   0x4C4B5331 // "LKS1"
+#define HITL_LOCKSTEP_ACTUATORS_MAGIC 0x4C4B4131 // "LKA1"
+#define HITL_LOCKSTEP_DEFAULT_PORT    9002
+#define HITL_LOCKSTEP_NUM_ACTUATORS   8
+
+//! Simulator state for one step, GCS to flight. Mirrors struct pios_sim_state.
+struct hitl_lockstep_sensors {
+	uint32_t magic;
+	uint32_t step;       // Step number, echoed back in the actuator frame
+	float dT;            // [s]
+	float accels[3];     // Body frame [m/s^2]
+	float gyros[3];      // Body frame [deg/s]
+	float mag[3];        // Body frame [mGa], all zero if not simulated
+	float baro[1];       // Altitude [m]
+	float q[4];          // Attitude quaternion
+	float velocity[3];   // NED [m/s]
+	float position[3];   // NED [m]
+} __attribute__((packed));
+
+//! Actuator outputs answering a step, flight to GCS
+struct hitl_lockstep_actuators {
+	uint32_t magic;
+	uint32_t step;
+	float actuator[HITL_LOCKSTEP_NUM_ACTUATORS]; // Roll, pitch, yaw, throttle desired, then unused
+} __attribute__((packed));
+
+#endif /* HITL_LOCKSTEP_H_ */
+
+/**
+ * @}
+ * @}
+ */